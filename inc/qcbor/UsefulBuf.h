@@ -1334,6 +1334,34 @@ void
 UsefulOutBuf_Advance(UsefulOutBuf *pUOutBuf, size_t uAmount);
 
 
+/**
+ * @brief Swap two adjacent regions of the output buffer in place.
+ *
+ * @param[in] pUOutBuf      Pointer to the @ref UsefulOutBuf.
+ * @param[in] uStartOffset  Offset of the first region.
+ * @param[in] uPivotOffset  Offset where the second region starts.
+ * @param[in] uEndOffset    Offset just past the end of the second region.
+ *
+ * The bytes from @c uStartOffset up to @c uPivotOffset are exchanged
+ * with the bytes from @c uPivotOffset up to @c uEndOffset. The two
+ * regions need not be the same size. This is done by reversal in
+ * place so no extra memory is needed.
+ *
+ * This is used for sorting encoded items in the output buffer
+ * without an intermediate buffer.
+ *
+ * If the offsets are not in order or @c uEndOffset is past the end
+ * of the valid data, nothing is swapped and the @ref UsefulOutBuf
+ * enters the error state. Nothing is done if the buffer given to
+ * UsefulOutBuf_Init() was @c NULL.
+ */
+void
+UsefulOutBuf_Swap(UsefulOutBuf *pUOutBuf,
+                  size_t        uStartOffset,
+                  size_t        uPivotOffset,
+                  size_t        uEndOffset);
+
+
 /**
  *  @brief Returns the resulting valid data in a UsefulOutBuf
  *
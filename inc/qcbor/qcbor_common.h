@@ -292,7 +292,8 @@ typedef enum {
    QCBOR_ERR_BUFFER_TOO_SMALL = 1,
 
    /** During encoding, an attempt to create simple value between 24
-       and 31. */
+       and 31, or to sort a map containing indefinite-length items
+       with QCBOREncode_CloseAndSortMap(). */
    QCBOR_ERR_ENCODE_UNSUPPORTED = 2,
 
    /** During encoding, the length of the encoded CBOR exceeded
@@ -333,6 +334,10 @@ typedef enum {
        added to it. */
    QCBOR_ERR_CANNOT_CANCEL = 10,
 
+   /** During conversion of JSON to CBOR with QCBOREncode_AddJSON(),
+       the JSON input was not valid JSON. */
+   QCBOR_ERR_JSON_SYNTAX = 11,
+
 #define QCBOR_START_OF_NOT_WELL_FORMED_ERRORS 20
 
    /** During decoding, the CBOR is not well-formed because a simple
@@ -453,6 +458,11 @@ typedef enum {
        indefinite length map or array in the input CBOR. */
    QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED = 50,
 
+   /** QCBORDecode_ContinueInput() was called when the current input
+       was not all consumed or when a map, array or bstr-wrapped CBOR
+       was entered. */
+   QCBOR_ERR_CANNOT_CONTINUE_INPUT = 51,
+
 #define QCBOR_END_OF_UNRECOVERABLE_DECODE_ERRORS 59
 
    /** More than @ref QCBOR_MAX_TAGS_PER_ITEM tags encountered for a
@@ -546,8 +556,31 @@ typedef enum {
        If an implementation decodes a tag and can and does consume the
        whole tag contents when it is not the correct tag content, this
        error can be returned. None of the built-in tag decoders do
-       this (to save object code). */
-   QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT = 78
+       this (to save object code), but
+       QCBORDecode_GetDateStringAsEpoch() returns it for a date string
+       it can't parse. */
+   QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT = 78,
+
+   /** The decoded CBOR does not conform to the schema passed to
+       QCBORDecode_ValidateSchema(). */
+   QCBOR_ERR_SCHEMA_MISMATCH = 79,
+
+   /** The CDDL passed to QCBORSchema_Compile() has a syntax error, uses
+       CDDL features not supported or exceeds one of the compiler's
+       limits. Also returned by QCBORDecode_ValidateSchema() when the
+       schema was not output by QCBORSchema_Compile(). */
+   QCBOR_ERR_SCHEMA_SYNTAX = 80,
+
+   /** A text string or text string label is not valid UTF-8. This is
+       only checked when enabled with QCBORDecode_SetUTF8Validation(). */
+   QCBOR_ERR_BAD_UTF8 = 81,
+
+   /** A path passed to QCBORPath_Compile() is not valid. */
+   QCBOR_ERR_PATH_SYNTAX = 82,
+
+   /** A map has more labels than can be checked for duplicates with
+       the slots passed to QCBORDecode_SetDuplicateDetection(). */
+   QCBOR_ERR_LABEL_SLOTS_SIZE = 83
 
    /* This is stored in uint8_t; never add values > 255 */
 } QCBORError;
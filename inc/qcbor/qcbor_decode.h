@@ -376,6 +376,11 @@ typedef struct _QCBORItem {
     * QCBORDecode_SetUpAllocator(). */
    uint8_t  uLabelAlloc;
 
+   /** For a text string label that is in the table set with
+    *  QCBORDecode_SetInternTable(), its position in the table plus
+    *  one. 0 for all other labels and when there is no table. */
+   uint8_t  uLabelId;
+
    /** The union holding the item's value. Select union member based
     *  on @c uDataType. */
    union {
@@ -638,6 +643,64 @@ typedef struct _QCBORDecodeContext QCBORDecodeContext;
 void QCBORDecode_Init(QCBORDecodeContext *pCtx, UsefulBufC EncodedCBOR, QCBORDecodeMode nMode);
 
 
+/**
+ * A document prepared once to be decoded by many decoders. See
+ * QCBORDecode_Prepare(). The contents are opaque.
+ */
+typedef struct {
+   /* PRIVATE DATA STRUCTURE */
+   UsefulBufC Encoded;
+   uint64_t   auMappedTags[QCBOR_NUM_MAPPED_TAGS];
+   uint8_t    uDecodeMode;
+   uint8_t    uLastError;
+} QCBORDecodePrepared;
+
+
+/**
+ * @brief Prepare a document to be decoded by many decoders.
+ *
+ * @param[out] pPrepared    The prepared document.
+ * @param[in] EncodedCBOR   The buffer with CBOR encoded bytes.
+ * @param[in] nMode         See QCBORDecode_Init().
+ *
+ * @return The first error decoding @c EncodedCBOR, if any.
+ *
+ * A decode context holds both what is the same for every decode of a
+ * document, such as the input and the mapping of tag numbers, and
+ * the position in it. This does the first part once so decoders for
+ * the same document, for example a configuration blob cached and
+ * decoded by many threads, can each be started with
+ * QCBORDecode_InitFromPrepared().
+ *
+ * All of @c EncodedCBOR is decoded once, checking that it is
+ * well-formed and recording the tag numbers that need mapping. It may
+ * be a CBOR sequence. It must not have indefinite-length strings
+ * because no string allocator is set up.
+ *
+ * @c *pPrepared is never written after this returns, so any number of
+ * threads can use it at the same time without locking. If an error
+ * is returned, decoders started from it are in that error state.
+ */
+QCBORError QCBORDecode_Prepare(QCBORDecodePrepared *pPrepared,
+                               UsefulBufC           EncodedCBOR,
+                               QCBORDecodeMode      nMode);
+
+
+/**
+ * @brief Initialize a decoder from a prepared document.
+ *
+ * @param[in] pCtx       The context to initialize.
+ * @param[in] pPrepared  The prepared document.
+ *
+ * This is the same as QCBORDecode_Init() with the input and mode
+ * given to QCBORDecode_Prepare(), plus the tag number mapping and any
+ * error found by it. The decoder has its own position, nesting and
+ * error state. A string allocator can be set up afterwards as usual.
+ */
+void QCBORDecode_InitFromPrepared(QCBORDecodeContext        *pCtx,
+                                  const QCBORDecodePrepared *pPrepared);
+
+
 /**
  * @brief Set up the MemPool string allocator for indefinite-length strings.
  *
@@ -726,6 +789,162 @@ void QCBORDecode_SetUpAllocator(QCBORDecodeContext *pCtx,
                                 bool                bAllStrings);
 
 
+/**
+ * @brief Check that text strings are valid UTF-8.
+ *
+ * @param[in] pCtx       The decoder context.
+ * @param[in] bValidate  @c true to check, @c false to not.
+ *
+ * CBOR requires text strings to be UTF-8, but by default the decoder
+ * returns whatever bytes are in them. With this set, every text
+ * string and text string label is checked as it is decoded, while
+ * its bytes are still in the cache, and @ref QCBOR_ERR_BAD_UTF8 is
+ * returned if it is not valid UTF-8 as defined in
+ * [RFC 3629] (https://tools.ietf.org/html/rfc3629). Overlong forms,
+ * surrogates and code points above U+10FFFF are not valid. This
+ * includes text strings that are the content of tags such as dates
+ * and URIs.
+ *
+ * @ref QCBOR_ERR_BAD_UTF8 is a recoverable error. The item in error
+ * is consumed. When it is the label of an array or map, the contents
+ * of the array or map are consumed too, so decoding continues with
+ * the next member. In map searches it is only returned for items with
+ * the label searched for, as with other recoverable errors.
+ *
+ * Runs of ASCII are checked eight bytes at a time so checking mostly
+ * ASCII text costs little.
+ */
+void QCBORDecode_SetUTF8Validation(QCBORDecodeContext *pCtx, bool bValidate);
+
+
+/** The maximum number of labels in a @ref QCBORInternTable */
+#define QCBOR_MAX_INTERNED_LABELS 64
+
+/**
+ * A table of text labels for QCBORDecode_SetInternTable(). Initialize
+ * it with QCBORInternTable_Init().
+ */
+typedef struct _QCBORInternTable {
+   /* PRIVATE DATA STRUCTURE */
+   const char *const *pszLabels;
+   uint8_t            auSlots[QCBOR_MAX_INTERNED_LABELS * 2]; /* Index + 1 */
+} QCBORInternTable;
+
+
+/**
+ * @brief Initialize a table of labels to intern.
+ *
+ * @param[out] pTable     The table to initialize.
+ * @param[in] pszLabels   The labels.
+ * @param[in] uNumLabels  The number of labels.
+ *
+ * @retval QCBOR_ERR_ARRAY_TOO_LONG   There are more than
+ *                                    @ref QCBOR_MAX_INTERNED_LABELS.
+ * @retval QCBOR_ERR_DUPLICATE_LABEL  A label is in @c pszLabels twice.
+ *
+ * @c pszLabels is not copied. It and the strings in it must stay
+ * valid while the table is used. The table is about 130 bytes. It is
+ * only read while decoding so one table can be shared by any number
+ * of decoders.
+ */
+QCBORError
+QCBORInternTable_Init(QCBORInternTable   *pTable,
+                      const char *const  *pszLabels,
+                      size_t              uNumLabels);
+
+
+/**
+ * @brief Report labels that are in a table by number.
+ *
+ * @param[in] pCtx    The decoder context.
+ * @param[in] pTable  The table or @c NULL for none.
+ *
+ * Code that decodes maps with text labels usually compares each label
+ * with all the ones it knows about until it finds the one that
+ * matches. With a table set, each text label decoded is looked up in
+ * it by hash, one comparison in most cases, and its position in the
+ * table plus one is put in @c uLabelId of the @ref QCBORItem. Code can
+ * then switch on @c uLabelId:
+ *
+ *     static const char *const aszLabels[] = {"name", "time", "value"};
+ *     enum {LABEL_NAME = 1, LABEL_TIME, LABEL_VALUE};
+ *
+ *     QCBORInternTable_Init(&Table, aszLabels, 3);
+ *     QCBORDecode_SetInternTable(&DCtx, &Table);
+ *     ...
+ *     switch(Item.uLabelId) {
+ *        case LABEL_NAME: ...
+ *
+ * Everything else about the item, including @c uLabelType and
+ * @c label.string, is the same as without the table.
+ */
+void
+QCBORDecode_SetInternTable(QCBORDecodeContext *pCtx, const QCBORInternTable *pTable);
+
+
+/**
+ * One slot of the scratch for QCBORDecode_SetDuplicateDetection().
+ */
+typedef struct _QCBORLabelSlot {
+   /* PRIVATE DATA STRUCTURE */
+   uint8_t  uLabelType; /* QCBOR_TYPE_NONE for an empty slot */
+   union {
+      int64_t    int64;
+      uint64_t   uint64;
+      UsefulBufC string;
+   } label;
+} QCBORLabelSlot;
+
+
+/**
+ * @brief Reject maps that have the same label twice.
+ *
+ * @param[in] pCtx      The decoder context.
+ * @param[in] pSlots    Scratch for checking labels or @c NULL to stop
+ *                      checking.
+ * @param[in] uNumSlots The number of slots in @c pSlots.
+ *
+ * CBOR doesn't allow duplicate labels in a map, but by default they
+ * are only detected in map searches and then only for the labels
+ * searched for. Duplicates can be a security problem when one part
+ * of a system takes the first and another the last.
+ *
+ * With this set, every time the head of a map is decoded the labels
+ * of all its members are put in a hash table in @c pSlots and @ref
+ * QCBOR_ERR_DUPLICATE_LABEL is returned with the map's item if one
+ * occurs twice. This is so for maps gotten with QCBORDecode_GetNext()
+ * and entered with QCBORDecode_EnterMap() and such. The map head is
+ * consumed so this is a recoverable error. As with other recoverable
+ * errors, map searches only return it for a map with the label
+ * searched for.
+ *
+ * Integer labels are compared by value, so the same integer encoded
+ * in two sizes is a duplicate. Strings are compared byte for byte,
+ * the content of an indefinite-length string no matter how it is
+ * chunked, and a text string and byte string are never the same.
+ * Tags on labels are ignored.
+ *
+ * The check decodes only the heads of the members and skips their
+ * values the way QCBORView does. Nothing is allocated, even with a
+ * string allocator. The expected cost is linear in the number of
+ * members, though the members of nested maps are skipped over once
+ * for each map they are in.
+ *
+ * A map can have up to half as many labels as there are slots.
+ * @ref QCBOR_ERR_LABEL_SLOTS_SIZE is returned for bigger maps. The
+ * slots are cleared for each map, and only as many as the map needs
+ * if it is definite-length. For an indefinite-length map all the
+ * slots are cleared. The slots must stay valid while the decoder is
+ * in use. Each is 24 bytes on a 64-bit CPU.
+ *
+ * This doesn't apply in @ref QCBOR_DECODE_MODE_MAP_AS_ARRAY.
+ */
+void
+QCBORDecode_SetDuplicateDetection(QCBORDecodeContext *pCtx,
+                                  QCBORLabelSlot     *pSlots,
+                                  size_t              uNumSlots);
+
+
 /**
  * @brief Get the next item (integer, byte string, array...) in the
  * preorder traversal of the CBOR tree.
@@ -951,7 +1170,8 @@ void QCBORDecode_VGetNextConsume(QCBORDecodeContext *pCtx, QCBORItem *pDecodedIt
  *
  * This uses about 200 bytes of stack, far more than anything else
  * here in qcbor_decode.h because it saves a copy of most of the
- * decode context temporarily.
+ * decode context temporarily. The item is decoded again when it is
+ * gotten unless QCBORDecode_SetPeekCache() is used.
  *
  * This is useful for looking ahead to determine the type of a data
  * item to know which type-specific spiffy decode function to call or
@@ -966,6 +1186,52 @@ void
 QCBORDecode_VPeekNext(QCBORDecodeContext *pCtx, QCBORItem *pDecodedItem);
 
 
+/**
+ * Storage for the item looked ahead at by QCBORDecode_PeekNext() and
+ * QCBORDecode_VPeekNext(). See QCBORDecode_SetPeekCache(). The
+ * contents are opaque.
+ */
+typedef struct _QCBORPeekCache {
+   /* PRIVATE DATA STRUCTURE */
+   QCBORItem          Item;
+   QCBORDecodeNesting NestingAfter;
+   uint8_t            auLevelBefore[sizeof(((QCBORDecodeNesting *)0)->pLevels[0])];
+   const void        *pCurrentBefore;
+   const void        *pBoundedBefore;
+   size_t             uCursorBefore;
+   size_t             uCursorAfter;
+   size_t             uInputLen;
+   bool               bValid;
+} QCBORPeekCache;
+
+
+/**
+ * @brief Keep the item looked ahead at so it isn't decoded again.
+ *
+ * @param[in] pCtx    The decoder context.
+ * @param[in] pCache  Storage for the item or @c NULL to stop using it.
+ *
+ * Without this, QCBORDecode_PeekNext() decodes the next item and
+ * throws away the position after it, so the next
+ * QCBORDecode_GetNext() decodes the same item again. Code that peeks
+ * before almost every item decodes everything twice.
+ *
+ * With this, the peeked item and the position and nesting after it
+ * are kept in @c pCache. The next QCBORDecode_GetNext() or any spiffy
+ * decode function that gets the next item takes them from the cache
+ * without decoding if the decoder is still where it was when it
+ * peeked. Peeking again at the same place also uses the cache. If the
+ * decoder has moved, for example by entering or exiting a map or
+ * rewinding, the cache is not used. Only successful peeks are kept.
+ *
+ * @c pCache is about 300 bytes and must stay valid while it is set.
+ * It belongs to one decoder context. Strings allocated by the string
+ * allocator for the peeked item are allocated only once.
+ */
+void
+QCBORDecode_SetPeekCache(QCBORDecodeContext *pCtx, QCBORPeekCache *pCache);
+
+
 /**
  * @brief Get the next data item without consuming it without use
  * of internal error state.
@@ -981,6 +1247,67 @@ QCBORError
 QCBORDecode_PeekNext(QCBORDecodeContext *pCtx, QCBORItem *pDecodedItem);
 
 
+/**
+ * @brief Get a byte string that may run past the end of the input.
+ *
+ * @param[in]  pCtx          The decoder context.
+ * @param[out] pDecodedItem  The byte string item.
+ * @param[out] puNotInInput  The number of bytes of the byte string
+ *                           past the end of the input.
+ *
+ * This is for byte strings too large to have in memory, for example a
+ * large file in a small CBOR envelope. The input given to the decoder
+ * only has to extend to the head of the byte string. The part of the
+ * byte string that is in the input is returned in @c
+ * pDecodedItem->val.string and the number of bytes after that is
+ * returned in @c puNotInInput. The caller reads that many bytes
+ * itself from wherever the input comes from, for example to copy them
+ * to a file, and then calls QCBORDecode_ContinueInput() with input
+ * that starts right after the byte string to decode the rest.
+ *
+ * When the whole byte string is in the input this is the same as
+ * QCBORDecode_VGetNext() and @c puNotInInput is 0.
+ *
+ * This otherwise works like QCBORDecode_VGetNext(), including for
+ * labels in maps, except the item must be a definite-length byte
+ * string with no tags that QCBOR processes. Other items set @ref
+ * QCBOR_ERR_UNEXPECTED_TYPE. Such an item is consumed, but if it ran
+ * past the end of the input, decoding can't sensibly continue. A
+ * byte string that runs past the end of the input is never copied by
+ * the string allocator.
+ */
+void
+QCBORDecode_GetByteStringHead(QCBORDecodeContext *pCtx,
+                              QCBORItem          *pDecodedItem,
+                              uint64_t           *puNotInInput);
+
+
+/**
+ * @brief Continue decoding with the next part of the input.
+ *
+ * @param[in] pCtx       The decoder context.
+ * @param[in] NextInput  The input that follows the input decoded so far.
+ *
+ * This replaces the input with @c NextInput so decoding continues
+ * with the next item in it. The main use is after
+ * QCBORDecode_GetByteStringHead() for a byte string that ran past the
+ * end of the input, in which case @c NextInput starts right after the
+ * byte string. It can also be used after any item that ends exactly
+ * at the end of the input.
+ *
+ * Arrays and maps being traversed with QCBORDecode_GetNext() continue
+ * in the new input. Because they are found by offsets in the input,
+ * maps, arrays and bstr-wrapped CBOR that have been entered and not
+ * exited can't continue. In that case, or if all of the current input
+ * has not been consumed, @ref QCBOR_ERR_CANNOT_CONTINUE_INPUT is set.
+ *
+ * Functions that rewind, like QCBORDecode_Rewind(), only go back as
+ * far as the start of @c NextInput.
+ */
+void
+QCBORDecode_ContinueInput(QCBORDecodeContext *pCtx, UsefulBufC NextInput);
+
+
 /**
  * @brief Returns the tag numbers for an item.
  *
@@ -0,0 +1,161 @@
+/*==============================================================================
+ qcbor_diag.h -- Output of CBOR diagnostic notation
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_diag_h
+#define qcbor_diag_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_diag.h
+ *
+ * This outputs any CBOR as the diagnostic notation described in
+ * [RFC 8949 section 8] (https://tools.ietf.org/html/rfc8949#section-8)
+ * and extended in [RFC 8610 appendix G]
+ * (https://tools.ietf.org/html/rfc8610#appendix-G). This is also
+ * called extended diagnostic notation or EDN. It is for debugging and
+ * logging, not for machine processing.
+ *
+ * The encoded CBOR is gone over once, head by head. It doesn't use
+ * QCBORDecode_GetNext() so it can show encoding details that decoding
+ * hides, such as which floating-point precision was used and how
+ * indefinite-length strings were chunked. No memory is allocated and
+ * printf() is not used, so it is fast enough to use on sampled
+ * traffic.
+ *
+ * Here's an example:
+ *
+ *     {1: [_ h'0102', -3.5_1], "a": 24(<<{2: true}>>)}
+ *
+ * Floating-point numbers are output as the shortest decimal that
+ * converts back to the same value in the precision they were encoded
+ * in. For example, a single-precision 1.1 is output as "1.1" rather
+ * than "1.100000023841858". This needs no floating-point hardware.
+ *
+ * Output stops with an error as soon as the input is found to not be
+ * well-formed. The output up to that point is still output which
+ * helps with debugging.
+ */
+
+
+/**
+ * Option for QCBORDecode_ToDiag() to output encoding indicators. An
+ * underscore and a digit are output after every item whose head has
+ * a one, two, four or eight-byte argument. For example, a
+ * half-precision 1.5 is "1.5_1" and a double-precision 1.5 is
+ * "1.5_3". A 0 encoded in two bytes is "0_0".
+ */
+#define QCBOR_DIAG_ENCODING_INDICATORS 0x01
+
+/**
+ * Option for QCBORDecode_ToDiag() to output byte strings that contain
+ * well-formed CBOR as embedded CBOR, for example "<<1, 2>>" rather
+ * than "h'0102'". This is a heuristic because many byte strings that
+ * are not meant to be CBOR are well-formed CBOR. An empty byte string
+ * is always output as "h''".
+ */
+#define QCBOR_DIAG_EMBEDDED_CBOR 0x02
+
+
+#ifndef QCBOR_DIAG_MAX_NESTING
+/**
+ * The maximum nesting of arrays, maps, tags, indefinite-length
+ * strings and embedded CBOR. This is the depth cap that bounds
+ * QCBORDecode_ToDiag() stack use on hostile input. It is larger than
+ * @ref QCBOR_MAX_ARRAY_NESTING because tags count as a nesting
+ * level here.  Each level takes 24 bytes of stack.
+ */
+#define QCBOR_DIAG_MAX_NESTING 32
+#endif
+
+
+/**
+ * @brief Callback for output of diagnostic notation.
+ *
+ * @param[in] pWriterCtx  The context passed to QCBORDecode_ToDiagWithWriter().
+ * @param[in] Text        The next piece of the output.
+ *
+ * @return @ref QCBOR_SUCCESS to continue or an error code to stop. The
+ *         error code is returned by QCBORDecode_ToDiagWithWriter().
+ *
+ * Output is buffered so this is called with pieces of up to 64 bytes
+ * or so, not for every token. The text is not NULL-terminated.
+ */
+typedef QCBORError (*QCBORDiagWriter)(void *pWriterCtx, UsefulBufC Text);
+
+
+/**
+ * @brief Output encoded CBOR as diagnostic notation into a buffer.
+ *
+ * @param[in] EncodedCBOR  The CBOR to output. May be a CBOR sequence.
+ * @param[in] uOptions     Zero or more of @ref QCBOR_DIAG_ENCODING_INDICATORS
+ *                         and @ref QCBOR_DIAG_EMBEDDED_CBOR.
+ * @param[in] Buffer       The buffer to output into. Its length is the
+ *                         output size cap.
+ * @param[out] pDiag       The output. Set even on error.
+ *
+ * @retval QCBOR_ERR_BUFFER_TOO_SMALL  The output didn't fit. It is
+ *                                     truncated.
+ * @retval QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP  Nesting deeper than
+ *                                     @ref QCBOR_DIAG_MAX_NESTING.
+ *
+ * Errors that indicate not-well-formed CBOR, for example @ref
+ * QCBOR_ERR_HIT_END, are also returned.
+ *
+ * Items in a CBOR sequence are separated by ", ". The output is not
+ * NULL-terminated. Pass @ref SizeCalculateUsefulBuf as @c Buffer to
+ * just compute the length of the output.
+ */
+QCBORError
+QCBORDecode_ToDiag(UsefulBufC  EncodedCBOR,
+                   uint32_t    uOptions,
+                   UsefulBuf   Buffer,
+                   UsefulBufC *pDiag);
+
+
+/**
+ * @brief Output encoded CBOR as diagnostic notation to a writer.
+ *
+ * @param[in] EncodedCBOR  The CBOR to output. May be a CBOR sequence.
+ * @param[in] uOptions     Same as for QCBORDecode_ToDiag().
+ * @param[in] uMaxLen      Output size cap in bytes.
+ * @param[in] pfWriter     The function called to output.
+ * @param[in] pWriterCtx   Context passed to @c pfWriter.
+ *
+ * This is the same as QCBORDecode_ToDiag() except the output goes to
+ * a callback so it can be streamed, for example to a log, without
+ * having the whole output in memory. When the output would be longer
+ * than @c uMaxLen, output stops at @c uMaxLen and @ref
+ * QCBOR_ERR_BUFFER_TOO_SMALL is returned. Byte strings are output as
+ * two characters per byte, so the cap matters for hostile input.
+ */
+QCBORError
+QCBORDecode_ToDiagWithWriter(UsefulBufC      EncodedCBOR,
+                             uint32_t        uOptions,
+                             size_t          uMaxLen,
+                             QCBORDiagWriter pfWriter,
+                             void           *pWriterCtx);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_diag_h */
@@ -0,0 +1,239 @@
+/*==============================================================================
+ qcbor_dom.h -- Decoding into a tree of nodes in a caller arena
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_dom_h
+#define qcbor_dom_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_dom.h
+ *
+ * QCBORDom_Build() decodes a whole data item into an array of nodes,
+ * one for each item, in memory given by the caller. It is for code
+ * that goes back and forth over a document many times and would
+ * otherwise build its own tree with an allocation for each item.
+ * There is no allocation and no pointers between nodes, just offsets,
+ * so the tree can be moved or copied.
+ *
+ * The nodes are in the order of the items in the encoded CBOR. The
+ * first item in an array or map is the node after the array or map.
+ * The node after an item and everything in it is @c uNext nodes on.
+ * The members of a map are a node for the label followed by a node
+ * for the value. Getting around is only pointer arithmetic:
+ *
+ *     const QCBORDomNode *pChild = QCBORDom_FirstChild(pArray);
+ *     for(i = 0; i < pArray->uCount; i++) {
+ *        ...
+ *        pChild = QCBORDom_Next(pChild);
+ *     }
+ *
+ * Building decodes only heads, as with QCBORView and QCBORSax, so it
+ * is about as fast as checking that the input is well-formed. Strings
+ * point into the input, so it must stay around while the tree is used.
+ *
+ * With @ref QCBOR_DOM_SORT_MAPS, each map also gets its labels sorted
+ * so QCBORDom_GetInMapN() and QCBORDom_GetInMapSZ() are a binary
+ * search rather than a look at every member.
+ *
+ * Integers and major type 7 are decoded as by QCBORDecode_GetNext().
+ * Nothing is done with tags other than record the outermost tag
+ * number on each item. Indefinite-length strings are not supported as
+ * there is no string allocator.
+ */
+
+
+/** Option for QCBORDom_Build() to sort the labels of each map */
+#define QCBOR_DOM_SORT_MAPS 0x01
+
+
+/** The number of sorted labels held in one node. See @ref QCBOR_DOM_SORT_MAPS. */
+#define QCBOR_DOM_SORTED_PER_NODE 4
+
+
+/**
+ * One item in the tree. On a 64-bit machine this is 32 bytes.
+ */
+typedef struct {
+   union {
+      int64_t    int64;
+      uint64_t   uint64;
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+      double     dfnum;
+      float      fnum;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+      uint8_t    uSimple;
+      UsefulBufC string;
+
+      /* For a map, the number of nodes to its sorted labels or 0 if
+       * not sorted. */
+      uint32_t   uSorted;
+
+      /* For the nodes holding sorted labels, offsets from the map to
+       * the labels. */
+      uint32_t   auSorted[QCBOR_DOM_SORTED_PER_NODE];
+   } val;
+
+   /** The outermost tag number or @ref CBOR_TAG_INVALID64. */
+   uint64_t uTagNumber;
+
+   /** The number of nodes to the node after this item and
+    *  everything in it. 1 for an item that isn't an array or map. */
+   uint32_t uNext;
+
+   /** For an array, the number of items in it. For a map, the number
+    *  of label-value pairs. */
+   uint16_t uCount;
+
+   /** One of @c QCBOR_TYPE_XXX such as @ref QCBOR_TYPE_INT64 and @ref
+    *  QCBOR_TYPE_MAP, the same as in a @ref QCBORItem. */
+   uint8_t  uDataType;
+} QCBORDomNode;
+
+
+/**
+ * @brief Decode a data item into a tree of nodes.
+ *
+ * @param[in] Encoded        The encoded CBOR. One data item.
+ * @param[in] pArena         The nodes to put the tree in. May be @c
+ *                           NULL to just compute the number of nodes
+ *                           needed.
+ * @param[in] uArenaSize     The number of nodes in @c pArena.
+ * @param[in] uOptions       0 or @ref QCBOR_DOM_SORT_MAPS.
+ * @param[out] puNodesUsed   The number of nodes used or, when @c
+ *                           pArena is @c NULL, needed.
+ *
+ * @retval QCBOR_ERR_BUFFER_TOO_SMALL     @c pArena doesn't have enough
+ *                                        nodes.
+ * @retval QCBOR_ERR_EXTRA_BYTES          There is more than one item.
+ * @retval QCBOR_ERR_NO_STRING_ALLOCATOR  An indefinite-length string.
+ *
+ * The root of the tree is @c pArena[0]. Errors that
+ * QCBORDecode_GetNext() returns for input that is not well-formed,
+ * such as @ref QCBOR_ERR_HIT_END, are returned the same way.
+ *
+ * There is one node for each data item. A map of n members takes
+ * another (n + 3) / 4 nodes with @ref QCBOR_DOM_SORT_MAPS. These are
+ * at the end of the arena.
+ */
+QCBORError
+QCBORDom_Build(UsefulBufC    Encoded,
+               QCBORDomNode *pArena,
+               size_t        uArenaSize,
+               uint32_t      uOptions,
+               size_t       *puNodesUsed);
+
+
+/**
+ * @brief Get the first item in an array or map.
+ *
+ * @param[in] pNode  An array or map.
+ *
+ * @return The first item, or the first label for a map. @c NULL if
+ *         it is empty.
+ */
+static const QCBORDomNode *
+QCBORDom_FirstChild(const QCBORDomNode *pNode);
+
+
+/**
+ * @brief Get the item after an item and everything in it.
+ *
+ * @param[in] pNode  An item in an array or map.
+ *
+ * This is the next item in the array or map @c pNode is in. The caller
+ * keeps count so as not to go past the last.
+ */
+static const QCBORDomNode *
+QCBORDom_Next(const QCBORDomNode *pNode);
+
+
+/**
+ * @brief Get an item in an array by its position.
+ *
+ * @param[in] pArray  An array.
+ * @param[in] uIndex  The position, 0 for the first.
+ *
+ * @return The item or @c NULL if @c pArray doesn't have that many
+ *         items or isn't an array.
+ */
+const QCBORDomNode *
+QCBORDom_GetInArray(const QCBORDomNode *pArray, uint16_t uIndex);
+
+
+/**
+ * @brief Get the value for an integer label in a map.
+ *
+ * @param[in] pMap    A map.
+ * @param[in] nLabel  The label.
+ *
+ * @return The value or @c NULL if not found or @c pMap isn't a map.
+ *
+ * This is a binary search if the map is sorted. If a label is in the
+ * map more than once, which one is found is not defined.
+ */
+const QCBORDomNode *
+QCBORDom_GetInMapN(const QCBORDomNode *pMap, int64_t nLabel);
+
+
+/**
+ * @brief Get the value for a text label in a map.
+ *
+ * @param[in] pMap     A map.
+ * @param[in] szLabel  The label.
+ *
+ * @return The value or @c NULL if not found or @c pMap isn't a map.
+ *
+ * This is the same as QCBORDom_GetInMapN() except the label is a text
+ * string.
+ */
+const QCBORDomNode *
+QCBORDom_GetInMapSZ(const QCBORDomNode *pMap, const char *szLabel);
+
+
+
+
+/* ========================================================================= *
+ *    BEGINNING OF PRIVATE INLINE IMPLEMENTATION                             *
+ * ========================================================================= */
+
+static inline const QCBORDomNode *
+QCBORDom_FirstChild(const QCBORDomNode *pNode)
+{
+   return pNode->uCount > 0 ? pNode + 1 : NULL;
+}
+
+
+static inline const QCBORDomNode *
+QCBORDom_Next(const QCBORDomNode *pNode)
+{
+   return pNode + pNode->uNext;
+}
+
+/* ========================================================================= *
+ *    END OF PRIVATE INLINE IMPLEMENTATION                                   *
+ * ========================================================================= */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_dom_h */
@@ -1392,6 +1392,75 @@ static void QCBOREncode_AddB64URLTextToMapN(QCBOREncodeContext *pCtx,
                                             UsefulBufC          B64Text);
 
 
+/**
+ @brief Add bytes as base64 or base64url encoded text.
+
+ @param[in] pCtx             The encoding context to add the text to.
+ @param[in] uTagRequirement  Either @ref QCBOR_ENCODE_AS_TAG or
+                             @ref QCBOR_ENCODE_AS_BORROWED.
+ @param[in] Bytes            The bytes to encode.
+
+ These are the same as QCBOREncode_AddTB64Text() and
+ QCBOREncode_AddTB64URLText() except the base64 encoding is done
+ here. It is written directly into the output buffer so no separate
+ buffer is needed for the text.
+
+ As [RFC 8949] (https://tools.ietf.org/html/rfc8949) section 3.4.5.3
+ requires, base64 text is padded with '=' and base64url text is not.
+
+ Error handling is the same as QCBOREncode_AddInt64().
+
+ See also QCBOREncode_EncodeB64() and QCBORDecode_GetB64Decoded().
+ */
+void QCBOREncode_AddTB64TextFromBytes(QCBOREncodeContext *pCtx,
+                                      uint8_t             uTagRequirement,
+                                      UsefulBufC          Bytes);
+
+static void QCBOREncode_AddTB64TextFromBytesToMapSZ(QCBOREncodeContext *pCtx,
+                                                    const char         *szLabel,
+                                                    uint8_t             uTagRequirement,
+                                                    UsefulBufC          Bytes);
+
+static void QCBOREncode_AddTB64TextFromBytesToMapN(QCBOREncodeContext *pCtx,
+                                                   int64_t             nLabel,
+                                                   uint8_t             uTagRequirement,
+                                                   UsefulBufC          Bytes);
+
+void QCBOREncode_AddTB64URLTextFromBytes(QCBOREncodeContext *pCtx,
+                                         uint8_t             uTagRequirement,
+                                         UsefulBufC          Bytes);
+
+static void QCBOREncode_AddTB64URLTextFromBytesToMapSZ(QCBOREncodeContext *pCtx,
+                                                       const char         *szLabel,
+                                                       uint8_t             uTagRequirement,
+                                                       UsefulBufC          Bytes);
+
+static void QCBOREncode_AddTB64URLTextFromBytesToMapN(QCBOREncodeContext *pCtx,
+                                                      int64_t             nLabel,
+                                                      uint8_t             uTagRequirement,
+                                                      UsefulBufC          Bytes);
+
+
+/**
+ @brief Base64 or base64url encode bytes.
+
+ @param[in] Dest   Buffer to output to. Its pointer may be @c NULL to
+                   just compute the length.
+ @param[in] Bytes  The bytes to encode.
+ @param[in] bURL   @c true for base64url, @c false for base64.
+
+ @return The encoded text or @ref NULLUsefulBufC if @c Dest is too
+         small.
+
+ This is the encoder used by QCBOREncode_AddTB64TextFromBytes() for
+ use outside of CBOR encoding, for example to put the text in JSON.
+ Padding is as for QCBOREncode_AddTB64TextFromBytes(). Six bytes at a
+ time are encoded with a 64-bit integer so long inputs are fast
+ without needing any processor-specific instructions.
+ */
+UsefulBufC QCBOREncode_EncodeB64(UsefulBuf Dest, UsefulBufC Bytes, bool bURL);
+
+
 /**
  @brief Add Perl Compatible Regular Expression.
 
@@ -1534,6 +1603,59 @@ static void QCBOREncode_AddDateStringToMapN(QCBOREncodeContext *pCtx,
                                             const char         *szDate);
 
 
+/**
+ @brief  Add a date string formatted from an epoch date.
+
+ @param[in] pCtx             The encoding context to add the date to.
+ @param[in] uTagRequirement  Either @ref QCBOR_ENCODE_AS_TAG or
+                             @ref QCBOR_ENCODE_AS_BORROWED.
+ @param[in] nSeconds         Number of seconds since 1970-01-01T00:00Z
+                             in UTC time.
+ @param[in] uNanoseconds     Fractional part of the time, 0 to
+                             999,999,999.
+ @param[in] nOffsetMinutes   The offset of the local time from UTC in
+                             minutes, -1439 to 1439.
+
+ This formats the date as
+ [RFC 3339] (https://tools.ietf.org/html/rfc3339) requires and adds it
+ as with QCBOREncode_AddTDateString(). It does not use the C library
+ time functions so it has no locale or time zone dependency and
+ allocates nothing.
+
+ When @c nOffsetMinutes is 0 the time ends in "Z", for example
+ "1985-04-12T23:20:50Z". Otherwise it is the local time followed by
+ the offset, for example "1985-04-12T16:20:50-07:00" for an offset of
+ -420. The fraction is output only when @c uNanoseconds is not 0 and
+ has 3, 6 or 9 digits, whichever is the fewest that are exact.
+
+ @ref QCBOR_ERR_DATE_OVERFLOW is set if the year is before 0 or after
+ 9999, which RFC 3339 can't represent, or if @c uNanoseconds or
+ @c nOffsetMinutes is out of range. Otherwise error handling is the
+ same as QCBOREncode_AddInt64().
+
+ QCBORDecode_GetDateStringAsEpoch() does the reverse.
+ */
+void QCBOREncode_AddTDateStringFromEpoch(QCBOREncodeContext *pCtx,
+                                         uint8_t             uTagRequirement,
+                                         int64_t             nSeconds,
+                                         uint32_t            uNanoseconds,
+                                         int16_t             nOffsetMinutes);
+
+static void QCBOREncode_AddTDateStringFromEpochToMapSZ(QCBOREncodeContext *pCtx,
+                                                       const char         *szLabel,
+                                                       uint8_t             uTagRequirement,
+                                                       int64_t             nSeconds,
+                                                       uint32_t            uNanoseconds,
+                                                       int16_t             nOffsetMinutes);
+
+static void QCBOREncode_AddTDateStringFromEpochToMapN(QCBOREncodeContext *pCtx,
+                                                      int64_t             nLabel,
+                                                      uint8_t             uTagRequirement,
+                                                      int64_t             nSeconds,
+                                                      uint32_t            uNanoseconds,
+                                                      int16_t             nOffsetMinutes);
+
+
 /**
  @brief  Add a date-only string.
 
@@ -1757,6 +1879,88 @@ static void QCBOREncode_OpenMapInMapN(QCBOREncodeContext *pCtx, int64_t nLabel);
 static void QCBOREncode_CloseMap(QCBOREncodeContext *pCtx);
 
 
+/**
+ @brief Close an open map and sort its entries.
+
+ @param[in] pCtx The encoding context to close the map in.
+
+ This is the same as QCBOREncode_CloseMap() except the label-value
+ pairs in the map are first sorted into the bytewise lexicographic
+ order of their encoded labels. This is the map ordering required for
+ deterministic encoding by [RFC 8949 section 4.2.1]
+ (https://tools.ietf.org/html/rfc8949#section-4.2.1).
+
+ The sort is done in place in the output buffer so no extra memory is
+ needed. It is an insertion sort that goes over the encoded map
+ entries a number of times proportional to the square of the number
+ of entries. This is fine for maps with tens or even hundreds of
+ entries, but use with very large maps is not advised.
+
+ Nested maps are not sorted by closing the outer map with this. Each
+ map to be sorted must be closed with this.
+
+ Maps that contain indefinite-length items can't be sorted. @ref
+ QCBOR_ERR_ENCODE_UNSUPPORTED is returned by QCBOREncode_Finish() if
+ this is attempted. If something added with QCBOREncode_AddEncoded()
+ is not well-formed, the error the decoder would give for it, such as
+ @ref QCBOR_ERR_HIT_END or @ref QCBOR_ERR_BAD_TYPE_7, is returned.
+
+ Nothing is sorted when only calculating the size of the encoded
+ output as the size does not change with sorting.
+ */
+void QCBOREncode_CloseAndSortMap(QCBOREncodeContext *pCtx);
+
+
+/** Option for QCBOREncode_MergeMaps() to check for duplicate labels */
+#define QCBOR_MERGE_CHECK_DUPLICATES 0x01
+
+/**
+ @brief Add the entries of already-encoded maps to the open map.
+
+ @param[in] pCtx      The encoding context with the map open.
+ @param[in] pMaps     The encoded maps to merge.
+ @param[in] uNumMaps  The number of maps in @c pMaps.
+ @param[in] uOptions  0 or @ref QCBOR_MERGE_CHECK_DUPLICATES.
+
+ This puts the label-value pairs of each of the maps in @c pMaps into
+ the map that is open, as if each had been added with one of the
+ @c QCBOREncode_AddXxxToMap() functions. It is for combining maps
+ that were encoded separately, for example a set of common header
+ parameters with some that are specific to a message, without
+ decoding and encoding them again.
+
+ Only the head of each map is decoded. The count of entries in it is
+ added to the count for the open map, then the bytes of the entries
+ are copied into the output as they are. Other entries may be added
+ to the open map before and after this is called.
+
+ Each map must be a definite-length map with no tags on it. Its
+ entries are not checked, so like QCBOREncode_AddEncoded() it must be
+ well-formed or the output will not be. A map whose head or count of
+ entries runs past the end of it gives @ref QCBOR_ERR_HIT_END.
+
+ With @ref QCBOR_MERGE_CHECK_DUPLICATES, all the labels in the open
+ map, including those added before this was called, are checked after
+ the maps are merged. If a label occurs twice, @ref
+ QCBOR_ERR_DUPLICATE_LABEL is returned by QCBOREncode_Finish(). The
+ check hashes each label so that labels are only compared with each
+ other when their hashes collide. Labels are compared by their
+ encoded bytes, so it is only complete when labels are encoded in
+ preferred serialization. Indefinite-length items can't be checked
+ and give @ref QCBOR_ERR_ENCODE_UNSUPPORTED. Entries that are not
+ well-formed give the error the decoder would, such as @ref
+ QCBOR_ERR_HIT_END. There is no check when only calculating the size
+ of the encoded output.
+
+ @ref QCBOR_ERR_ENCODE_UNSUPPORTED is also returned if a map is not
+ open or an item in @c pMaps is not a map.
+ */
+void QCBOREncode_MergeMaps(QCBOREncodeContext *pCtx,
+                           const UsefulBufC   *pMaps,
+                           size_t              uNumMaps,
+                           uint32_t            uOptions);
+
+
 /**
  @brief Indicate start of encoded CBOR to be wrapped in a bstr.
 
@@ -2201,6 +2405,54 @@ static inline void QCBOREncode_AddBytesLenOnlyToMap(QCBOREncodeContext *pCtx, co
 static inline void QCBOREncode_AddBytesLenOnlyToMapN(QCBOREncodeContext *pCtx, int64_t nLabel, UsefulBufC Bytes);
 
 
+/**
+ @brief Semi-private method to add the bytes of a byte string after its head.
+
+ @param[in] pCtx    The encoding context.
+ @param[in] Bytes   Some of the bytes of the byte string.
+
+ This adds the bytes of a byte string whose head was added with
+ QCBOREncode_AddBytesLenOnly(). It can be called more than once to
+ add them a part at a time. Nothing is checked, so the lengths of the
+ parts must add up to the length given to
+ QCBOREncode_AddBytesLenOnly().
+ */
+void QCBOREncode_AddBytesContentOnly(QCBOREncodeContext *pCtx, UsefulBufC Bytes);
+
+
+/**
+ @brief Semi-private method to open a map or array whose count is known.
+
+ @param[in] pCtx        The encoding context.
+ @param[in] uMajorType  @c CBOR_MAJOR_TYPE_ARRAY or @c CBOR_MAJOR_TYPE_MAP.
+ @param[in] uCount      The number of items or, for a map, of pairs.
+
+ The head is output now rather than inserted when the array or map is
+ closed, so nothing has to be moved. The array or map must be closed
+ with QCBOREncode_CloseMapOrArrayWithCount(). This is for encoders
+ layered on this one that output many small maps whose counts they
+ know.
+ */
+void QCBOREncode_OpenMapOrArrayWithCount(QCBOREncodeContext *pCtx,
+                                         uint8_t             uMajorType,
+                                         uint64_t            uCount);
+
+
+/**
+ @brief Semi-private method to close a map or array opened with QCBOREncode_OpenMapOrArrayWithCount().
+
+ @param[in] pCtx        The encoding context.
+ @param[in] uMajorType  The major CBOR type to close.
+ @param[in] uCount      The count it was opened with.
+
+ @ref QCBOR_ERR_CLOSE_MISMATCH is set if the number of items added
+ isn't @c uCount.
+ */
+void QCBOREncode_CloseMapOrArrayWithCount(QCBOREncodeContext *pCtx,
+                                          uint8_t             uMajorType,
+                                          uint64_t            uCount);
+
+
 
 
 
@@ -3026,6 +3278,47 @@ QCBOREncode_AddB64URLTextToMapN(QCBOREncodeContext *pMe, int64_t nLabel, UsefulB
    QCBOREncode_AddTB64URLTextToMapN(pMe, nLabel, QCBOR_ENCODE_AS_TAG, B64Text);
 }
 
+static inline void
+QCBOREncode_AddTB64TextFromBytesToMapSZ(QCBOREncodeContext *pMe,
+                                        const char         *szLabel,
+                                        uint8_t             uTagRequirement,
+                                        UsefulBufC          Bytes)
+{
+   QCBOREncode_AddSZString(pMe, szLabel);
+   QCBOREncode_AddTB64TextFromBytes(pMe, uTagRequirement, Bytes);
+}
+
+static inline void
+QCBOREncode_AddTB64TextFromBytesToMapN(QCBOREncodeContext *pMe,
+                                       int64_t             nLabel,
+                                       uint8_t             uTagRequirement,
+                                       UsefulBufC          Bytes)
+{
+   QCBOREncode_AddInt64(pMe, nLabel);
+   QCBOREncode_AddTB64TextFromBytes(pMe, uTagRequirement, Bytes);
+}
+
+static inline void
+QCBOREncode_AddTB64URLTextFromBytesToMapSZ(QCBOREncodeContext *pMe,
+                                           const char         *szLabel,
+                                           uint8_t             uTagRequirement,
+                                           UsefulBufC          Bytes)
+{
+   QCBOREncode_AddSZString(pMe, szLabel);
+   QCBOREncode_AddTB64URLTextFromBytes(pMe, uTagRequirement, Bytes);
+}
+
+static inline void
+QCBOREncode_AddTB64URLTextFromBytesToMapN(QCBOREncodeContext *pMe,
+                                          int64_t             nLabel,
+                                          uint8_t             uTagRequirement,
+                                          UsefulBufC          Bytes)
+{
+   QCBOREncode_AddInt64(pMe, nLabel);
+   QCBOREncode_AddTB64URLTextFromBytes(pMe, uTagRequirement, Bytes);
+}
+
+
 
 
 static inline void
@@ -3160,6 +3453,30 @@ QCBOREncode_AddDateStringToMapN(QCBOREncodeContext *pMe, int64_t nLabel, const c
    QCBOREncode_AddTDateStringToMapN(pMe, nLabel, QCBOR_ENCODE_AS_TAG, szDate);
 }
 
+static inline void
+QCBOREncode_AddTDateStringFromEpochToMapSZ(QCBOREncodeContext *pMe,
+                                           const char         *szLabel,
+                                           uint8_t             uTagRequirement,
+                                           int64_t             nSeconds,
+                                           uint32_t            uNanoseconds,
+                                           int16_t             nOffsetMinutes)
+{
+   QCBOREncode_AddSZString(pMe, szLabel);
+   QCBOREncode_AddTDateStringFromEpoch(pMe, uTagRequirement, nSeconds, uNanoseconds, nOffsetMinutes);
+}
+
+static inline void
+QCBOREncode_AddTDateStringFromEpochToMapN(QCBOREncodeContext *pMe,
+                                          int64_t             nLabel,
+                                          uint8_t             uTagRequirement,
+                                          int64_t             nSeconds,
+                                          uint32_t            uNanoseconds,
+                                          int16_t             nOffsetMinutes)
+{
+   QCBOREncode_AddInt64(pMe, nLabel);
+   QCBOREncode_AddTDateStringFromEpoch(pMe, uTagRequirement, nSeconds, uNanoseconds, nOffsetMinutes);
+}
+
 
 static inline void
 QCBOREncode_AddTDaysString(QCBOREncodeContext *pMe, uint8_t uTagRequirement, const char *szDate)
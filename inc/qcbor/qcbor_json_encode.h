@@ -0,0 +1,126 @@
+/*==============================================================================
+ qcbor_json_encode.h -- Convert JSON to CBOR with the QCBOR encoder
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_json_encode_h
+#define qcbor_json_encode_h
+
+
+#include "qcbor/qcbor_encode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_json_encode.h
+ *
+ * This converts JSON text ([RFC 8259]
+ * (https://tools.ietf.org/html/rfc8259)) to CBOR by calling the
+ * @c QCBOREncode_AddXxx() functions directly as the JSON is
+ * tokenized. There is no intermediate tree of nodes and no memory is
+ * allocated. The JSON is gone over once from start to end.
+ *
+ * The JSON to CBOR mapping is the one suggested in [RFC 8949 section
+ * 6.2] (https://tools.ietf.org/html/rfc8949#section-6.2):
+ *
+ *   JSON             | CBOR
+ *   -----------------|---------------------------------------------------
+ *   object           | map with text string labels
+ *   array            | array
+ *   string           | text string, with escapes converted to UTF-8
+ *   integer number   | integer (major type 0 or 1) if in range of
+ *                    | @c uint64_t or @c int64_t, otherwise float
+ *   other number     | float with preferred serialization
+ *   true, false      | simple values true and false
+ *   null             | simple value null
+ *
+ * Numbers with a fractional part or an exponent are converted with one
+ * floating-point multiply or divide when they have no more than 19
+ * significant digits and a decimal exponent that is small enough that
+ * the conversion is exact. This covers almost all numbers seen in
+ * practice. Other numbers are converted with slower big integer
+ * arithmetic. Either way the result is correctly rounded and doesn't
+ * depend on the C locale. Numbers longer than
+ * @ref QCBOR_JSON_MAX_NUMBER_LEN that need the slower conversion can't
+ * be converted.
+ *
+ * Floating-point values are output with QCBOREncode_AddDouble() so
+ * they get preferred serialization and may be as small as
+ * half-precision.
+ *
+ * Scanning of string contents is done eight bytes at a time with
+ * plain 64-bit integer operations so it is faster than byte-by-byte
+ * but still portable.
+ *
+ * The text in JSON strings is not checked to be valid UTF-8. Duplicate
+ * labels in JSON objects are not detected.
+ */
+
+
+/**
+ * Pass this option to QCBOREncode_AddJSON() to sort the entries in
+ * all maps for deterministic encoding. See
+ * QCBOREncode_CloseAndSortMap().
+ */
+#define QCBOR_JSON_SORT_MAPS 0x01
+
+
+/**
+ * The maximum length of a number in the JSON input that has to be
+ * converted with big integer arithmetic. See QCBOREncode_AddJSON().
+ */
+#define QCBOR_JSON_MAX_NUMBER_LEN 128
+
+
+/**
+ * @brief Convert JSON text to CBOR and add it to the encoded output.
+ *
+ * @param[in] pCtx      The encoding context to add the CBOR to.
+ * @param[in] JSON      The JSON text to convert.
+ * @param[in] uOptions  Zero or @ref QCBOR_JSON_SORT_MAPS.
+ *
+ * This adds one CBOR data item that is the conversion of the one JSON
+ * value in @c JSON. It may be added in an array or map like any other
+ * data item. It may be called many times to add several JSON values.
+ *
+ * See the table in qcbor_json_encode.h for how JSON is converted.
+ *
+ * Like the other @c QCBOREncode_AddXxx() functions, errors are not
+ * returned here, but are recorded in the encoding context and
+ * returned by QCBOREncode_Finish() or QCBOREncode_GetErrorState(). If
+ * the JSON is not valid or has something following the one JSON
+ * value other than white space, @ref QCBOR_ERR_JSON_SYNTAX is
+ * recorded. The encoded output is not usable after an error.
+ *
+ * JSON objects and arrays nested more than
+ * @ref QCBOR_MAX_ARRAY_NESTING deep result in
+ * @ref QCBOR_ERR_ARRAY_NESTING_TOO_DEEP.
+ *
+ * A JSON number that can't be converted to an integer and that needs
+ * floating-point results in @ref QCBOR_ERR_HW_FLOAT_DISABLED or
+ * @ref QCBOR_ERR_ALL_FLOAT_DISABLED if floating-point support has been
+ * disabled. A number that needs big integer arithmetic and is longer than
+ * @ref QCBOR_JSON_MAX_NUMBER_LEN results in
+ * @ref QCBOR_ERR_ENCODE_UNSUPPORTED.
+ */
+void
+QCBOREncode_AddJSON(QCBOREncodeContext *pCtx, UsefulBufC JSON, uint32_t uOptions);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_json_encode_h */
@@ -0,0 +1,197 @@
+/*==============================================================================
+ qcbor_packed.h -- Packing and unpacking of Packed CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_packed_h
+#define qcbor_packed_h
+
+
+#include "qcbor/qcbor_common.h"
+#include "qcbor/UsefulBuf.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_packed.h
+ *
+ * Packed CBOR
+ * ([draft-ietf-cbor-packed](https://datatracker.ietf.org/doc/draft-ietf-cbor-packed/))
+ * makes CBOR with repeated strings smaller without a general-purpose
+ * compressor. Each repeated item is put once in a table and
+ * everywhere it occurs is replaced by a reference that is usually one
+ * or two bytes. The result is still CBOR.
+ *
+ * The form supported here is tag 113 enclosing an array of the shared
+ * item table, the argument table and the rump, which is the data item
+ * with the references in it:
+ *
+ *     113([[shared items], [argument items], rump])
+ *
+ * The references are:
+ *
+ * - Simple values 0 through 15 for shared items 0 through 15.
+ * - Tag 6 enclosing an unsigned integer n for shared item 16 + 2n.
+ * - Tag 6 enclosing a negative integer -1 - n for shared item
+ *   16 + 2n + 1.
+ * - Tags 224 through 255 and 28704 through 32767 enclosing a string
+ *   for argument items 0 through 31 and 32 through 4095. The
+ *   argument item is a prefix, a string of the same type, that is put
+ *   in front of the string enclosed.
+ *
+ * QCBORPacked_Pack() turns ordinary CBOR, such as the output of
+ * QCBOREncode_Finish(), into Packed CBOR. QCBORPacked_Unpack() turns
+ * it back so it can be decoded with QCBORDecode_GetNext() and the
+ * other decode functions.
+ *
+ * Both work on the encoded bytes in one pass over them, decoding only
+ * the heads. Items that are not references are copied as they are.
+ */
+
+
+/**
+ * The maximum number of distinct strings QCBORPacked_Pack() counts
+ * to choose the shared items from. Each uses 16 bytes of stack.
+ */
+#ifndef QCBOR_PACKED_MAX_STRINGS
+#define QCBOR_PACKED_MAX_STRINGS 64
+#endif
+
+/**
+ * The maximum number of shared items in Packed CBOR that
+ * QCBORPacked_Unpack() can unpack. Each uses 4 bytes of stack.
+ */
+#ifndef QCBOR_PACKED_MAX_SHARED
+#define QCBOR_PACKED_MAX_SHARED 64
+#endif
+
+/**
+ * The maximum number of argument items in Packed CBOR that
+ * QCBORPacked_Unpack() can unpack and that QCBORPacked_Pack() can
+ * be given. Each uses 4 bytes of stack.
+ */
+#ifndef QCBOR_PACKED_MAX_ARGUMENTS
+#define QCBOR_PACKED_MAX_ARGUMENTS 32
+#endif
+
+/**
+ * The maximum number of items QCBORPacked_Unpack() outputs for
+ * references to shared items. This bounds the time taken by input
+ * made so a few bytes expand to a huge amount.
+ */
+#ifndef QCBOR_PACKED_MAX_EXPANDED_ITEMS
+#define QCBOR_PACKED_MAX_EXPANDED_ITEMS 1000000
+#endif
+
+
+/**
+ * @brief Pack encoded CBOR.
+ *
+ * @param[in] Encoded       One encoded data item.
+ * @param[in] pPrefixes     Text strings to use as prefixes, or
+ *                          @c NULL.
+ * @param[in] uNumPrefixes  The number of prefixes.
+ * @param[in] Buffer        Where to put the Packed CBOR. Its pointer
+ *                          may be @c NULL to just compute the size.
+ * @param[out] pPacked      The Packed CBOR.
+ *
+ * @retval QCBOR_ERR_BUFFER_TOO_SMALL    @c Buffer is too small.
+ * @retval QCBOR_ERR_HIT_END             @c Encoded is not
+ *                                       well-formed because it ends
+ *                                       part way through an item.
+ * @retval QCBOR_ERR_BAD_TYPE_7          @c Encoded has a simple value
+ *                                       in two bytes that fits in
+ *                                       one.
+ * @retval QCBOR_ERR_UNSUPPORTED         @c Encoded has reserved
+ *                                       additional info.
+ * @retval QCBOR_ERR_ENCODE_UNSUPPORTED  @c Encoded has
+ *                                       indefinite-length items,
+ *                                       simple values 0 through 15
+ *                                       or tags used for references.
+ * @retval QCBOR_ERR_EXTRA_BYTES         @c Encoded is more than one
+ *                                       item.
+ * @retval QCBOR_ERR_ARRAY_TOO_LONG      There are more prefixes than
+ *                                       @ref QCBOR_PACKED_MAX_ARGUMENTS.
+ *
+ * Text and byte strings, including map labels, that occur more than
+ * once are counted. The ones that make the output smallest are put in
+ * the shared item table, with the ones that save the most getting the
+ * one-byte references. Only the first @ref QCBOR_PACKED_MAX_STRINGS
+ * distinct strings are considered.
+ *
+ * Text strings that are not shared and start with one of the
+ * prefixes are replaced by a reference to the longest prefix they
+ * start with if that makes them smaller. Prefixes are not found
+ * automatically because good ones like the base part of URIs depend
+ * on the data.
+ *
+ * The output is always tag 113, even when nothing is shared.
+ */
+QCBORError
+QCBORPacked_Pack(UsefulBufC        Encoded,
+                 const UsefulBufC *pPrefixes,
+                 size_t            uNumPrefixes,
+                 UsefulBuf         Buffer,
+                 UsefulBufC       *pPacked);
+
+
+/**
+ * @brief Unpack Packed CBOR.
+ *
+ * @param[in] Packed       The Packed CBOR.
+ * @param[in] Buffer       Where to put the unpacked CBOR. Its pointer
+ *                         may be @c NULL to just compute the size.
+ * @param[out] pUnpacked   The unpacked CBOR.
+ *
+ * @retval QCBOR_ERR_BAD_TAG_CONTENT        The tag 113 content is not
+ *                                          of the right form, a
+ *                                          reference is to an item not
+ *                                          in a table or a prefix and
+ *                                          its string are not the same
+ *                                          type.
+ * @retval QCBOR_ERR_BUFFER_TOO_SMALL       @c Buffer is too small.
+ * @retval QCBOR_ERR_ARRAY_DECODE_TOO_LONG  A table has more items than
+ *                                          @ref QCBOR_PACKED_MAX_SHARED
+ *                                          or @ref
+ *                                          QCBOR_PACKED_MAX_ARGUMENTS.
+ * @retval QCBOR_ERR_EXTRA_BYTES            There is more after the tag
+ *                                          113.
+ * @retval QCBOR_ERR_INPUT_TOO_LARGE        References to shared items
+ *                                          expand to more than @ref
+ *                                          QCBOR_PACKED_MAX_EXPANDED_ITEMS
+ *                                          items.
+ *
+ * Errors for input that is not well-formed such as @ref
+ * QCBOR_ERR_HIT_END are also returned.
+ *
+ * References in the rump are replaced by the items they refer to.
+ * References in shared items are replaced too, to a limited depth so
+ * references that loop give an error. Everything else is copied as it
+ * is.
+ *
+ * If @c Packed doesn't start with tag 113 it is copied unchanged, so
+ * this can be used on input that may or may not be packed.
+ */
+QCBORError
+QCBORPacked_Unpack(UsefulBufC  Packed,
+                   UsefulBuf   Buffer,
+                   UsefulBufC *pUnpacked);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_packed_h */
@@ -0,0 +1,188 @@
+/*==============================================================================
+ qcbor_path.h -- Getting items by path expressions in one traversal
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_path_h
+#define qcbor_path_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_path.h
+ *
+ * This gets items deep in a CBOR document by paths like
+ * <tt>a.b[3].c</tt>. Many paths can be gotten at once, so a whole
+ * projection of a document is gotten in one traversal rather than by
+ * entering and searching maps and arrays once for each item.
+ *
+ * The paths are first compiled by QCBORPath_Compile() into a set of
+ * steps. This can be done once at start up. QCBORDecode_GetPaths()
+ * then gets the next item with QCBORDecode_GetNext() and goes over
+ * everything in it once, matching each item against the paths that
+ * matched its enclosing map or array. Maps and arrays that no path
+ * goes into are skipped over by decoding only the heads of the items
+ * in them, which is much faster than getting each item.
+ *
+ * A path is a sequence of steps from the item QCBORDecode_GetPaths()
+ * starts on. The steps are:
+ *
+ * - <tt>.name</tt> The member of a map with the text string label
+ *   @c name. Names are letters, digits, @c _ and @c -.
+ * - <tt>."any text"</tt> The member of a map with a text string label
+ *   that has characters not allowed in a name. There are no escapes.
+ * - <tt>.123</tt> or <tt>.-7</tt> The member of a map with the
+ *   integer label. Use quotes for a text label that looks like an
+ *   integer.
+ * - <tt>.*</tt> Every member of a map.
+ * - <tt>[3]</tt> The array element at index 3, counting from 0.
+ * - <tt>[*]</tt> Every element of an array.
+ *
+ * The @c . before the first step may be left off, so @c a.b is the
+ * same as @c .a.b. The empty path is the item itself.
+ *
+ * Maps with labels other than integers and text strings can be
+ * traversed, but those members can only be matched with
+ * <tt>.*</tt>. Paths don't work in @ref QCBOR_DECODE_MODE_MAP_AS_ARRAY.
+ */
+
+
+/**
+ * The maximum number of paths in a set. Each is a bit in a 32-bit
+ * mask during traversal.
+ */
+#define QCBOR_PATH_MAX_PATHS 32
+
+
+/**
+ * One step in a compiled path. An array of these is storage for
+ * QCBORPath_Compile(). The members are private.
+ */
+typedef struct {
+   /* PRIVATE DATA STRUCTURE */
+   uint8_t    uType;
+   int64_t    nValue;  /* Integer label or array index */
+   UsefulBufC Label;   /* Text label. Points into the path string. */
+} QCBORPathStep;
+
+
+/**
+ * A set of compiled paths. Set up by QCBORPath_Compile(). The members
+ * are private.
+ */
+typedef struct {
+   /* PRIVATE DATA STRUCTURE */
+   const QCBORPathStep *pSteps;
+   uint8_t              uNumPaths;
+   uint8_t              auNumSteps[QCBOR_PATH_MAX_PATHS];
+   uint16_t             auFirstStep[QCBOR_PATH_MAX_PATHS];
+} QCBORPathSet;
+
+
+/**
+ * @brief Compile paths for QCBORDecode_GetPaths().
+ *
+ * @param[in] pszPaths   Array of path strings.
+ * @param[in] uNumPaths  Number of paths.
+ * @param[in] pSteps     Storage for the compiled steps.
+ * @param[in] uMaxSteps  Number of steps @c pSteps can hold.
+ * @param[out] pSet      The compiled set of paths.
+ *
+ * @retval QCBOR_ERR_PATH_SYNTAX           A path is not valid.
+ * @retval QCBOR_ERR_ARRAY_TOO_LONG        More than @ref QCBOR_PATH_MAX_PATHS paths.
+ * @retval QCBOR_ERR_ARRAY_NESTING_TOO_DEEP  A path has more than
+ *                                         @ref QCBOR_MAX_ARRAY_NESTING steps.
+ * @retval QCBOR_ERR_BUFFER_TOO_SMALL      @c pSteps is too small.
+ *
+ * Each step in each path takes one @ref QCBORPathStep. The text
+ * labels in the compiled steps point into the path strings so they
+ * must stay valid as long as @c pSet is used.
+ */
+QCBORError
+QCBORPath_Compile(const char *const *pszPaths,
+                  size_t             uNumPaths,
+                  QCBORPathStep     *pSteps,
+                  size_t             uMaxSteps,
+                  QCBORPathSet      *pSet);
+
+
+/**
+ * @brief Callback for each item matched by a path.
+ *
+ * @param[in] pCallbackCtx  The context passed to QCBORDecode_GetPaths().
+ * @param[in] uPathIndex    The index of the path that matched.
+ * @param[in] pItem         The item matched.
+ *
+ * Return @ref QCBOR_SUCCESS to continue. Anything else stops the
+ * traversal and is set as the decoder's error. @ref
+ * QCBOR_ERR_CALLBACK_FAIL is for errors that are not CBOR errors.
+ */
+typedef QCBORError (*QCBORPathCallback)(void            *pCallbackCtx,
+                                        size_t           uPathIndex,
+                                        const QCBORItem *pItem);
+
+
+/**
+ * @brief Get the items matching a set of paths.
+ *
+ * @param[in] pCtx          The decode context.
+ * @param[in] pSet          The paths compiled by QCBORPath_Compile().
+ * @param[out] pItems       Array of one item per path or @c NULL.
+ * @param[in] pCallbackCtx  Context for @c pfCallback.
+ * @param[in] pfCallback    Function called for each match or @c NULL.
+ *
+ * This gets the next item with QCBORDecode_GetNext() and goes over
+ * all of it, matching against the paths in @c pSet. Afterwards the
+ * decoder is positioned after the item, just as if
+ * QCBORDecode_VGetNextConsume() had been called.
+ *
+ * For each path, the first item matched is put in @c pItems at the
+ * path's index. If nothing matches, its @c uDataType is @ref
+ * QCBOR_TYPE_NONE. This is all that is needed for paths without
+ * wildcards since they match at most one item. @c pfCallback is
+ * called for every item matched, in the order they occur, which is
+ * the way to get all the items matched by paths with wildcards.
+ *
+ * When a map or array is matched, the item for its head is
+ * returned. The items in it can be matched by other paths in the same
+ * set.
+ *
+ * Maps and arrays that no path goes into are only checked for being
+ * well-formed. Errors such as invalid tag content, a duplicate label
+ * or nesting too deep in them are not found.
+ *
+ * Strings in the items returned point into the input so they stay
+ * valid after this returns. When a string allocator is set with
+ * QCBORDecode_SetMemPool() or QCBORDecode_SetUpAllocator(), the
+ * strings it allocates, such as indefinite-length strings, are in
+ * memory from it instead and are valid until that memory is freed.
+ * Errors are handled like the other spiffy decode functions.
+ */
+void
+QCBORDecode_GetPaths(QCBORDecodeContext *pCtx,
+                     const QCBORPathSet *pSet,
+                     QCBORItem          *pItems,
+                     void               *pCallbackCtx,
+                     QCBORPathCallback   pfCallback);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_path_h */
@@ -180,12 +180,12 @@ struct _QCBOREncodeContext {
  to this structure is through DecodeNesting_Xxx() functions.
 
  64-bit machine size
-   128 = 16 * 8 for the two unions
+   192 = 16 * 12 for the two unions
    64  = 16 * 4 for the uLevelType, 1 byte padded to 4 bytes for alignment
    16  = 16 bytes for two pointers
-   208 TOTAL
+   272 TOTAL
 
- 32-bit machine size is 200 bytes
+ 32-bit machine size is 264 bytes
  */
 typedef struct __QCBORDecodeNesting  {
    // PRIVATE DATA STRUCTURE
@@ -233,6 +233,11 @@ typedef struct __QCBORDecodeNesting  {
             uint16_t uCountCursor;
 #define QCBOR_NON_BOUNDED_OFFSET UINT32_MAX
             uint32_t uStartOffset;
+            /* The end of a bounded map or array once it is known from
+             * a map search or traversing to the end, otherwise
+             * QCBOR_MAP_OFFSET_CACHE_INVALID. */
+#define QCBOR_MAP_OFFSET_CACHE_INVALID UINT32_MAX
+            uint32_t uEndOffset;
          } ma; /* for maps and arrays */
          struct {
             /* The end of the input before the bstr was entered so that
@@ -299,20 +304,32 @@ struct _QCBORDecodeContext {
    uint32_t uMemPoolSize;
    uint32_t uMemPoolFreeOffset;
 
-   // A cached offset to the end of the current map
-   // 0 if no value is cached.
-#define QCBOR_MAP_OFFSET_CACHE_INVALID UINT32_MAX
-   uint32_t uMapEndOffsetCache;
-
    uint8_t  uDecodeMode;
    uint8_t  bStringAllocateAll;
    uint8_t  uLastError;  // QCBORError stuffed into a uint8_t
+   uint8_t  bValidateUTF8; /* Set by QCBORDecode_SetUTF8Validation() */
+   uint8_t  bAllowPartialBytes; /* Only during QCBORDecode_GetByteStringHead() */
 
    /* See MapTagNumber() for description of how tags are mapped. */
    uint64_t auMappedTags[QCBOR_NUM_MAPPED_TAGS];
 
    uint16_t uLastTags[QCBOR_MAX_TAGS_PER_ITEM1];
 
+   /* Set by QCBORDecode_GetByteStringHead() */
+   uint64_t uBytesNotInInput;
+
+   /* Set by QCBORDecode_SetPeekCache(). NULL if there is none. */
+   struct _QCBORPeekCache *pPeekCache;
+
+   /* Set by QCBORDecode_SetInternTable(). NULL if there is none. */
+   const struct _QCBORInternTable *pInternTable;
+
+   /* Set by QCBORDecode_SetDuplicateDetection(). NULL if not checking. */
+   struct _QCBORLabelSlot *pLabelSlots;
+   size_t                  uNumLabelSlots;
+
+   /* Set by QCBORDecode_SetBstrEnterCache(). NULL if there is none. */
+   struct _QCBORBstrEnterCache *pBstrEnterCache;
 };
 
 // Used internally in the impementation here
@@ -0,0 +1,158 @@
+/*==============================================================================
+ qcbor_sax.h -- Event-driven decoding with callbacks
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_sax_h
+#define qcbor_sax_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_sax.h
+ *
+ * QCBORSax_Decode() goes over encoded CBOR once and calls a function
+ * for each thing in it: an integer, a string, the start and end of an
+ * array or map, a tag number and so on. The values are passed as
+ * arguments, not in a @ref QCBORItem, so nothing is filled in that the
+ * callback doesn't use. This suits code that handles each item as it
+ * goes by, such as converters to other formats, validators and
+ * indexers.
+ *
+ * There is no decode context. Heads are decoded by the same code as
+ * QCBORDecode_GetNext() and the same limits apply: nesting to @ref
+ * QCBOR_MAX_ARRAY_NESTING, @ref QCBOR_MAX_ITEMS_IN_ARRAY items in an
+ * array or map and the errors for input that is not well-formed are
+ * the same. Nothing is done with tags other than report their numbers
+ * and there is no string allocator. The chunks of indefinite-length
+ * strings are passed one at a time.
+ *
+ *     static QCBORError Count(void *pCbCtx, uint16_t uCount)
+ *     {
+ *        (*(size_t *)pCbCtx)++;
+ *        return QCBOR_SUCCESS;
+ *     }
+ *
+ *     QCBORSaxCallbacks Callbacks = {0};
+ *     Callbacks.pfBeginMap = Count;
+ *     uErr = QCBORSax_Decode(Encoded, &Callbacks, &uNumMaps);
+ */
+
+
+/**
+ * The functions QCBORSax_Decode() calls. Any can be @c NULL to not be
+ * called. Each gets the @c pCbCtx passed to QCBORSax_Decode().
+ *
+ * Each returns @ref QCBOR_SUCCESS to continue. Anything else stops
+ * decoding and is returned by QCBORSax_Decode(). @ref
+ * QCBOR_ERR_CALLBACK_FAIL is for errors that are not CBOR errors.
+ *
+ * The members of a map are passed in the order they are encoded, the
+ * label and then the value, so @c pfBeginMap is followed by twice as
+ * many items as its count before @c pfEndMap.
+ */
+typedef struct {
+   /** An integer from @c INT64_MIN to @c INT64_MAX. */
+   QCBORError (*pfInt)(void *pCbCtx, int64_t nValue);
+
+   /** A positive integer larger than @c INT64_MAX. Negative integers
+    *  smaller than @c INT64_MIN give @ref QCBOR_ERR_INT_OVERFLOW. */
+   QCBORError (*pfUInt)(void *pCbCtx, uint64_t uValue);
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   /** A half-, single- or double-precision number. */
+   QCBORError (*pfDouble)(void *pCbCtx, double dValue);
+
+   /** A single-precision number. Only called instead of @c pfDouble
+    *  when @c QCBOR_DISABLE_FLOAT_HW_USE is defined, as
+    *  QCBORDecode_GetNext() returns @ref QCBOR_TYPE_FLOAT then. */
+   QCBORError (*pfFloat)(void *pCbCtx, float fValue);
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+   /** @c true or @c false. */
+   QCBORError (*pfBool)(void *pCbCtx, bool bValue);
+
+   /** @c null. */
+   QCBORError (*pfNull)(void *pCbCtx);
+
+   /** @c undefined, which is 23, and the other simple values. */
+   QCBORError (*pfSimple)(void *pCbCtx, uint8_t uSimpleValue);
+
+   /** A byte string. For a definite-length string, @c bMore is @c
+    *  false. For an indefinite-length string, this is called with @c
+    *  bMore @c true for each chunk, then once with @ref NULLUsefulBufC
+    *  and @c bMore @c false. */
+   QCBORError (*pfBytes)(void *pCbCtx, UsefulBufC Bytes, bool bMore);
+
+   /** A text string. Chunks are passed as for @c pfBytes. */
+   QCBORError (*pfText)(void *pCbCtx, UsefulBufC Text, bool bMore);
+
+   /** The start of an array. @c uCount is @ref
+    *  QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH for indefinite
+    *  length. */
+   QCBORError (*pfBeginArray)(void *pCbCtx, uint16_t uCount);
+
+   /** The end of an array, including an empty one. */
+   QCBORError (*pfEndArray)(void *pCbCtx);
+
+   /** The start of a map. @c uCount is the number of members or @ref
+    *  QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH. */
+   QCBORError (*pfBeginMap)(void *pCbCtx, uint16_t uCount);
+
+   /** The end of a map, including an empty one. */
+   QCBORError (*pfEndMap)(void *pCbCtx);
+
+   /** A tag number. This is called before the item it is on, once
+    *  for each tag number with the outermost first. */
+   QCBORError (*pfTag)(void *pCbCtx, uint64_t uTagNumber);
+} QCBORSaxCallbacks;
+
+
+/**
+ * @brief Decode CBOR calling functions for each thing in it.
+ *
+ * @param[in] Encoded     The encoded CBOR.
+ * @param[in] pCallbacks  The functions to call.
+ * @param[in] pCbCtx      Passed to each function.
+ *
+ * @retval QCBOR_ERR_BAD_BREAK  A break that doesn't end an
+ *                              indefinite-length array or map, or
+ *                              that ends a map after a label.
+ * @retval QCBOR_ERR_ARRAY_OR_MAP_UNCONSUMED  The input ends in an
+ *                              array or map.
+ *
+ * All the data items in @c Encoded are decoded, so it can be a CBOR
+ * sequence. @ref QCBOR_SUCCESS is returned when the end of the input
+ * is reached at the end of an item. Errors that
+ * QCBORDecode_GetNext() returns for input that is not well-formed,
+ * such as @ref QCBOR_ERR_HIT_END, are returned the same way. The
+ * functions have been called for everything before the error.
+ *
+ * The strings passed to the functions point into @c Encoded.
+ */
+QCBORError
+QCBORSax_Decode(UsefulBufC               Encoded,
+                const QCBORSaxCallbacks *pCallbacks,
+                void                    *pCbCtx);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_sax_h */
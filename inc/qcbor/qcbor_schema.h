@@ -0,0 +1,173 @@
+/*==============================================================================
+ qcbor_schema.h -- Validation of CBOR against a compiled CDDL schema
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_schema_h
+#define qcbor_schema_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_schema.h
+ *
+ * This validates CBOR against a schema written in a subset of CDDL
+ * ([RFC 8610](https://tools.ietf.org/html/rfc8610)).
+ *
+ * The CDDL is first compiled by QCBORSchema_Compile() into a compact
+ * program of 32-bit words. This can be done once at start up, or at
+ * build time by saving the words as a C array since they don't
+ * contain pointers and don't depend on the CDDL text after compiling.
+ *
+ * QCBORDecode_ValidateSchema() then runs the program over the items
+ * returned by QCBORDecode_GetNext(). There is no tree of nodes and
+ * nothing is allocated. The CBOR is gone over once, so validation
+ * costs about the same as decoding.
+ *
+ * The CDDL subset supported is:
+ *
+ * - Rules of the form <tt>name = type</tt>. The first rule is the
+ *   root. Rules may be referred to before they are defined and may be
+ *   recursive.
+ * - The prelude types any, uint, nint, int, bstr, bytes, tstr, text,
+ *   bool, true, false, nil, null, undefined, float, float16, float32,
+ *   float64, float16-32, float32-64, number, tdate, time, biguint,
+ *   bignint, uri, b64url, b64legacy, regexp, mime-message and
+ *   encoded-cbor. Float sizes are not distinguished.
+ * - Integer values and ranges like <tt>5</tt>, <tt>-1..10</tt> and
+ *   <tt>0...256</tt> within the range of @c int64_t.
+ * - Text string values like <tt>"abc"</tt> and byte string values
+ *   like <tt>'abc'</tt>, without escapes.
+ * - Choices between types with @c /.
+ * - Arrays <tt>[ ]</tt> and maps <tt>{ }</tt> with the occurrence
+ *   indicators @c ?, @c *, @c + and <tt>n*m</tt>.
+ * - Map member keys <tt>name:</tt>, <tt>"name":</tt>, <tt>1:</tt> and
+ *   <tt>type =></tt>, for example <tt>* tstr => any</tt>.
+ * - Tags <tt>#6.nnn(type)</tt>.
+ * - The control <tt>.size</tt> on tstr, bstr and uint, for example
+ *   <tt>bstr .size 32</tt> and <tt>tstr .size (1..64)</tt>.
+ * - Comments starting with @c ;.
+ *
+ * Not supported are groups as types, group choices with @c //,
+ * socket extension with @c /= and @c //=, generics and controls other
+ * than <tt>.size</tt>.
+ *
+ * Validation decides what a data item matches by looking only at
+ * that item, not the items that follow. For example, in
+ * <tt>[* int, int]</tt> all the integers match the first entry so the
+ * second entry is never matched. In a choice, the first alternative
+ * whose type and tags match an array or map is used; its contents
+ * are then required to match. This covers the schemas used in
+ * practice for protocols.
+ *
+ * Map members with a value key are matched before members with a
+ * type key like <tt>* tstr => any</tt>. A map with members that are
+ * not in the schema doesn't match.
+ *
+ * Tags that QCBORDecode_GetNext() decodes, such as epoch dates, big
+ * numbers and URIs, are matched by the tag number they were decoded
+ * from. The contents of decimal fractions and big floats aren't
+ * checked because QCBORDecode_GetNext() has already consumed them.
+ */
+
+
+/**
+ * The maximum number of rules in the CDDL passed to
+ * QCBORSchema_Compile().
+ */
+#ifndef QCBOR_SCHEMA_MAX_RULES
+#define QCBOR_SCHEMA_MAX_RULES 32
+#endif
+
+/**
+ * The maximum number of members in a map in the CDDL passed to
+ * QCBORSchema_Compile(). Each uses two bytes of stack during
+ * validation, for each level of map nesting.
+ */
+#ifndef QCBOR_SCHEMA_MAX_MAP_MEMBERS
+#define QCBOR_SCHEMA_MAX_MAP_MEMBERS 32
+#endif
+
+
+/**
+ * A compiled schema. Set up by QCBORSchema_Compile() or initialized
+ * from a saved program.
+ */
+typedef struct {
+   const uint32_t *puCode;
+   size_t          uCodeLen; /* In 32-bit words */
+} QCBORSchema;
+
+
+/**
+ * @brief Compile CDDL into a program to validate CBOR with.
+ *
+ * @param[in] CDDL        The CDDL text.
+ * @param[out] puCode     Where to put the program. May be @c NULL to
+ *                        just compute the size.
+ * @param[in] uCodeSize   The number of 32-bit words in @c puCode.
+ * @param[out] pSchema    The compiled schema. @c uCodeLen is set even
+ *                        when @c puCode is @c NULL or too small.
+ *
+ * @retval QCBOR_ERR_SCHEMA_SYNTAX     The CDDL has an error or is
+ *                                     outside the supported subset.
+ * @retval QCBOR_ERR_BUFFER_TOO_SMALL  @c puCode is too small.
+ *
+ * See qcbor_schema.h for the subset of CDDL supported. Typical
+ * schemas compile to 2 to 4 words per type or member.
+ */
+QCBORError
+QCBORSchema_Compile(UsefulBufC   CDDL,
+                    uint32_t    *puCode,
+                    size_t       uCodeSize,
+                    QCBORSchema *pSchema);
+
+
+/**
+ * @brief Validate the next item against a schema.
+ *
+ * @param[in] pCtx     The decode context.
+ * @param[in] pSchema  The schema from QCBORSchema_Compile().
+ *
+ * This gets the next item with QCBORDecode_GetNext() and checks it
+ * against the first rule in the schema. If it is an array or map, all
+ * its contents are gotten and checked too. Afterwards the decoder is
+ * positioned after the item, just as if QCBORDecode_VGetNextConsume()
+ * had been called.
+ *
+ * Errors are handled like the other spiffy decode functions. If the
+ * item doesn't conform, @ref QCBOR_ERR_SCHEMA_MISMATCH is set and the
+ * decoder is left at some point inside the item. Use
+ * QCBORDecode_Rewind() or start over to decode again.
+ *
+ * A common use is to validate a whole message and then rewind and
+ * decode it knowing that it is of the right form:
+ *
+ *     QCBORDecode_Init(&DCtx, Message, QCBOR_DECODE_MODE_NORMAL);
+ *     QCBORDecode_ValidateSchema(&DCtx, &Schema);
+ *     QCBORDecode_Rewind(&DCtx);
+ */
+void
+QCBORDecode_ValidateSchema(QCBORDecodeContext *pCtx, const QCBORSchema *pSchema);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_schema_h */
@@ -0,0 +1,229 @@
+/*==============================================================================
+ qcbor_seq_index.h -- Offset index for random access to CBOR sequences
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_seq_index_h
+#define qcbor_seq_index_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_seq_index.h
+ *
+ * A CBOR sequence ([RFC 8742](https://tools.ietf.org/html/rfc8742))
+ * such as an append-only log has no way to find record N except by
+ * decoding all the records before it. This builds an index that is
+ * kept beside the sequence, for example in a sidecar file, and uses
+ * it to position a decoder at a record by number or by key.
+ *
+ * The index is sparse. It has the offset of every Nth record, where N
+ * is the interval given when building it. Getting to a record takes
+ * one lookup in the index and skipping at most N - 1 records. The
+ * skipping decodes only heads as with QCBORView, so an interval of 16
+ * or 64 is usually a good trade between the size of the index and the
+ * time to seek. With an interval of 1, every record is in it.
+ *
+ * The index may also have a key for each record in it. The key is
+ * the integer value of a member with a given label in records that
+ * are maps, for example a sequence number or time stamp. Keys must
+ * not decrease from one record to the next so the index can be
+ * binary searched.
+ *
+ * The index is itself CBOR so it can be stored and examined with
+ * other CBOR tools. It is an array of the interval, the number of
+ * records, the key label or null, and a byte string of entries. Each
+ * entry is an 8-byte offset followed by an 8-byte key if there are
+ * keys, both in network byte order. The integers and the length of
+ * the byte string are always encoded in 8 bytes so the size of the
+ * index is easy to compute and it can be written in one pass.
+ *
+ * Build it at append time:
+ *
+ *     QCBORSeqIndex_Init(&Builder, Storage, 64, true, 1);
+ *     for each record appended {
+ *        QCBORSeqIndex_AddRecord(&Builder, uOffsetOfRecord, nKey);
+ *     }
+ *     QCBORSeqIndex_Finish(&Builder, &Index);
+ *
+ * or after the fact:
+ *
+ *     QCBORSeqIndex_Init(&Builder, Storage, 64, true, 1);
+ *     QCBORSeqIndex_AddSequence(&Builder, Sequence, 0);
+ *     QCBORSeqIndex_Finish(&Builder, &Index);
+ *
+ * Then to decode record 1000:
+ *
+ *     QCBORDecode_Init(&DCtx, Sequence, QCBOR_DECODE_MODE_NORMAL);
+ *     QCBORSeqIndex_SeekToRecord(&DCtx, Index, 1000);
+ *     QCBORDecode_GetNext(&DCtx, &Item);
+ */
+
+
+/**
+ * The size of the storage needed by QCBORSeqIndex_Init() for an index
+ * of @c uNumRecords records.
+ */
+#define QCBOR_SEQ_INDEX_SIZE(uNumRecords, uInterval, bKeys) \
+   (((bKeys) ? 37 : 29) + \
+    (((uNumRecords) + (uInterval) - 1) / (uInterval)) * ((bKeys) ? 16 : 8))
+
+
+/**
+ * The context for building an index. Initialize with
+ * QCBORSeqIndex_Init().
+ */
+typedef struct {
+   /* PRIVATE DATA STRUCTURE */
+   UsefulBuf    Storage;
+   UsefulOutBuf OutBuf;
+   uint64_t     uNumRecords;
+   int64_t      nKeyLabel;
+   int64_t      nLastKey;
+   uint32_t     uInterval;
+   bool         bKeys;
+   uint8_t      uError;
+} QCBORSeqIndexBuilder;
+
+
+/**
+ * @brief Initialize the context for building an index.
+ *
+ * @param[in] pBuilder   The context to initialize.
+ * @param[in] Storage    Where to build the index. Its pointer may be
+ *                       @c NULL to just compute the size.
+ * @param[in] uInterval  Every this many records are in the index. Must
+ *                       be 1 or more.
+ * @param[in] bKeys      Whether to have keys in the index.
+ * @param[in] nKeyLabel  The label of the key in the records. Only
+ *                       used by QCBORSeqIndex_AddSequence().
+ */
+void
+QCBORSeqIndex_Init(QCBORSeqIndexBuilder *pBuilder,
+                   UsefulBuf             Storage,
+                   uint32_t              uInterval,
+                   bool                  bKeys,
+                   int64_t               nKeyLabel);
+
+
+/**
+ * @brief Add the next record to an index.
+ *
+ * @param[in] pBuilder  The index builder.
+ * @param[in] uOffset   The offset of the record in the sequence.
+ * @param[in] nKey      The key of the record. Ignored if there are no
+ *                      keys.
+ *
+ * This is for building the index as records are appended. Every
+ * record in the sequence must be added, in order. Errors are
+ * returned by QCBORSeqIndex_Finish().
+ */
+void
+QCBORSeqIndex_AddRecord(QCBORSeqIndexBuilder *pBuilder,
+                        uint64_t              uOffset,
+                        int64_t               nKey);
+
+
+/**
+ * @brief Add all the records in a sequence to an index.
+ *
+ * @param[in] pBuilder      The index builder.
+ * @param[in] Records       The records to add.
+ * @param[in] uBaseOffset   The offset of @c Records in the sequence.
+ *
+ * This goes over the records skipping each one as QCBORView does. If
+ * there are keys, each record must be a map with an integer member
+ * with the key label. @c uBaseOffset allows a large sequence to be
+ * indexed in parts, or records appended to a sequence already indexed
+ * to be added. Errors are returned by QCBORSeqIndex_Finish().
+ */
+void
+QCBORSeqIndex_AddSequence(QCBORSeqIndexBuilder *pBuilder,
+                          UsefulBufC            Records,
+                          uint64_t              uBaseOffset);
+
+
+/**
+ * @brief Finish building an index.
+ *
+ * @param[in] pBuilder  The index builder.
+ * @param[out] pIndex   The index. Its pointer is @c NULL if the
+ *                      storage pointer was @c NULL.
+ *
+ * @retval QCBOR_ERR_BUFFER_TOO_SMALL  The storage is too small.
+ * @retval QCBOR_ERR_UNSUPPORTED       A key is less than the one
+ *                                     before or the interval is 0.
+ * @retval QCBOR_ERR_LABEL_NOT_FOUND   A record has no key.
+ * @retval QCBOR_ERR_UNEXPECTED_TYPE   A key is not an integer or a
+ *                                     record is not a map.
+ *
+ * Errors decoding the records given to QCBORSeqIndex_AddSequence()
+ * are also returned.
+ */
+QCBORError
+QCBORSeqIndex_Finish(QCBORSeqIndexBuilder *pBuilder, UsefulBufC *pIndex);
+
+
+/**
+ * @brief Position a decoder at a record.
+ *
+ * @param[in] pCtx     The decoder with the sequence as input.
+ * @param[in] Index    The index of the sequence.
+ * @param[in] uRecord  The record number, 0 for the first.
+ *
+ * @retval QCBOR_ERR_NO_MORE_ITEMS    The sequence has fewer records.
+ * @retval QCBOR_ERR_UNEXPECTED_TYPE  @c Index is not an index.
+ * @retval QCBOR_ERR_UNSUPPORTED      A map, array or byte string is
+ *                                    entered in the decoder.
+ *
+ * On success the next item the decoder gets is the record and any
+ * error in the decoder is cleared as with QCBORDecode_Rewind().
+ * Otherwise the decoder is not changed. Errors from skipping the
+ * records before it such as @ref QCBOR_ERR_HIT_END are also
+ * returned.
+ */
+QCBORError
+QCBORSeqIndex_SeekToRecord(QCBORDecodeContext *pCtx,
+                           UsefulBufC          Index,
+                           uint64_t            uRecord);
+
+
+/**
+ * @brief Position a decoder at the first record with a key.
+ *
+ * @param[in] pCtx   The decoder with the sequence as input.
+ * @param[in] Index  The index of the sequence. It must have keys.
+ * @param[in] nKey   The key to find.
+ *
+ * @retval QCBOR_ERR_LABEL_NOT_FOUND  No record has the key.
+ *
+ * This binary searches the index, then looks at the keys of the
+ * records after the entry found until it finds the key or one
+ * greater. Otherwise it is the same as QCBORSeqIndex_SeekToRecord().
+ */
+QCBORError
+QCBORSeqIndex_SeekToKey(QCBORDecodeContext *pCtx,
+                        UsefulBufC          Index,
+                        int64_t             nKey);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_seq_index_h */
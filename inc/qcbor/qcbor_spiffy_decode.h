@@ -1014,6 +1014,63 @@ static void QCBORDecode_GetDaysStringInMapSZ(QCBORDecodeContext *pCtx,
                                              UsefulBufC         *pDateString);
 
 
+/**
+ @brief Decode the next item as a date string and convert it to an epoch date.
+
+ @param[in] pCtx              The decode context.
+ @param[in] uTagRequirement   One of @c QCBOR_TAG_REQUIREMENT_XXX.
+ @param[out] pnSeconds        Number of seconds since
+                              1970-01-01T00:00Z in UTC time.
+ @param[out] puNanoseconds    The fractional part of the time. May be
+                              @c NULL.
+ @param[out] pnOffsetMinutes  The offset of the local time in the
+                              string from UTC in minutes. May be
+                              @c NULL.
+
+ This is QCBORDecode_GetDateString() followed by parsing of the
+ string as a [RFC 3339] (https://tools.ietf.org/html/rfc3339)
+ date-time, for example "1985-04-12T23:20:50.52Z" or
+ "1996-12-19T16:39:57-08:00". The parsing doesn't use the C library
+ time functions so it has no locale or time zone dependency,
+ allocates nothing and takes no locks. The common form with no
+ fraction and "Z" is parsed with no loops at all.
+
+ The year must be 0000 to 9999. A leap second, 60 seconds, is
+ accepted and is the same as the first second of the next minute as
+ for POSIX time. Digits of the fraction after the ninth are ignored.
+ An offset of "-00:00" is returned as 0.
+
+ If the string is not an RFC 3339 date-time, @ref
+ QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT is set. Decoding can continue
+ with the next item.
+
+ Please see @ref Decode-Errors-Overview "Decode Errors Overview".
+
+ See @ref Tag-Usage for discussion on tag requirements.
+
+ See also QCBOREncode_AddTDateStringFromEpoch().
+*/
+void QCBORDecode_GetDateStringAsEpoch(QCBORDecodeContext *pCtx,
+                                      uint8_t             uTagRequirement,
+                                      int64_t            *pnSeconds,
+                                      uint32_t           *puNanoseconds,
+                                      int16_t            *pnOffsetMinutes);
+
+void QCBORDecode_GetDateStringAsEpochInMapN(QCBORDecodeContext *pCtx,
+                                            int64_t             nLabel,
+                                            uint8_t             uTagRequirement,
+                                            int64_t            *pnSeconds,
+                                            uint32_t           *puNanoseconds,
+                                            int16_t            *pnOffsetMinutes);
+
+void QCBORDecode_GetDateStringAsEpochInMapSZ(QCBORDecodeContext *pCtx,
+                                             const char         *szLabel,
+                                             uint8_t             uTagRequirement,
+                                             int64_t            *pnSeconds,
+                                             uint32_t           *puNanoseconds,
+                                             int16_t            *pnOffsetMinutes);
+
+
 /**
  @brief Decode the next item as an epoch date.
 
@@ -1471,6 +1528,111 @@ static void QCBORDecode_GetB64URLInMapSZ(QCBORDecodeContext *pCtx,
                                          uint8_t             uTagRequirement,
                                          UsefulBufC         *pB64Text);
 
+
+/**
+ @brief Decode the next item as base64 text and remove the base64 encoding.
+
+ @param[in] pCtx             The decode context.
+ @param[in] uTagRequirement  One of @c QCBOR_TAG_REQUIREMENT_XXX.
+ @param[in] Buffer           Where to put the decoded bytes. Its
+                             pointer may be @c NULL to use the string
+                             allocator.
+ @param[out] pBytes          The decoded bytes.
+
+ This is QCBORDecode_GetB64() followed by QCBORDecode_DecodeB64(). The
+ bytes are put in @c Buffer, or if its pointer is @c NULL, in memory
+ from the string allocator set with QCBORDecode_SetUpAllocator() that
+ is freed the same way as indefinite-length strings.
+
+ @ref QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT is set if the text is not
+ base64. @ref QCBOR_ERR_BUFFER_TOO_SMALL is set if @c Buffer is too
+ small. Decoding can continue with the next item after either of
+ these. @ref QCBOR_ERR_NO_STRING_ALLOCATOR is set if there is no
+ buffer and no string allocator.
+
+ Please see @ref Decode-Errors-Overview "Decode Errors Overview".
+
+ See @ref Tag-Usage for discussion on tag requirements.
+
+ See also QCBOREncode_AddTB64TextFromBytes().
+*/
+void QCBORDecode_GetB64Decoded(QCBORDecodeContext *pCtx,
+                               uint8_t             uTagRequirement,
+                               UsefulBuf           Buffer,
+                               UsefulBufC         *pBytes);
+
+void QCBORDecode_GetB64DecodedInMapN(QCBORDecodeContext *pCtx,
+                                     int64_t             nLabel,
+                                     uint8_t             uTagRequirement,
+                                     UsefulBuf           Buffer,
+                                     UsefulBufC         *pBytes);
+
+void QCBORDecode_GetB64DecodedInMapSZ(QCBORDecodeContext *pCtx,
+                                      const char         *szLabel,
+                                      uint8_t             uTagRequirement,
+                                      UsefulBuf           Buffer,
+                                      UsefulBufC         *pBytes);
+
+
+/**
+ @brief Decode the next item as base64url text and remove the base64url encoding.
+
+ @param[in] pCtx             The decode context.
+ @param[in] uTagRequirement  One of @c QCBOR_TAG_REQUIREMENT_XXX.
+ @param[in] Buffer           Where to put the decoded bytes. Its
+                             pointer may be @c NULL to use the string
+                             allocator.
+ @param[out] pBytes          The decoded bytes.
+
+ This is the same as QCBORDecode_GetB64Decoded() except for base64url.
+
+ See also QCBOREncode_AddTB64URLTextFromBytes().
+*/
+void QCBORDecode_GetB64URLDecoded(QCBORDecodeContext *pCtx,
+                                  uint8_t             uTagRequirement,
+                                  UsefulBuf           Buffer,
+                                  UsefulBufC         *pBytes);
+
+void QCBORDecode_GetB64URLDecodedInMapN(QCBORDecodeContext *pCtx,
+                                        int64_t             nLabel,
+                                        uint8_t             uTagRequirement,
+                                        UsefulBuf           Buffer,
+                                        UsefulBufC         *pBytes);
+
+void QCBORDecode_GetB64URLDecodedInMapSZ(QCBORDecodeContext *pCtx,
+                                         const char         *szLabel,
+                                         uint8_t             uTagRequirement,
+                                         UsefulBuf           Buffer,
+                                         UsefulBufC         *pBytes);
+
+
+/**
+ @brief Remove base64 or base64url encoding.
+
+ @param[in] Text     The base64 text.
+ @param[in] bURL     @c true for base64url, @c false for base64.
+ @param[in] Dest     Where to put the bytes. (Text.len / 4) * 3 + 2
+                     bytes is always enough.
+ @param[out] pBytes  The decoded bytes.
+
+ @retval QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT  @c Text is not base64
+                                                or base64url.
+ @retval QCBOR_ERR_BUFFER_TOO_SMALL             @c Dest is too small.
+
+ This is the decoder used by QCBORDecode_GetB64Decoded() for use
+ outside of CBOR decoding. Padding with '=' is allowed but not
+ required for both. Characters from the other alphabet, white space
+ and bits left over at the end that are not zero are errors.
+
+ Eight characters at a time are decoded into a 64-bit integer with
+ one check for invalid characters for all eight, so long text is fast
+ without needing any processor-specific instructions.
+*/
+QCBORError QCBORDecode_DecodeB64(UsefulBufC  Text,
+                                 bool        bURL,
+                                 UsefulBuf   Dest,
+                                 UsefulBufC *pBytes);
+
 /**
  @brief Decode the next item as a regular expression.
 
@@ -1636,8 +1798,15 @@ inline static void QCBORDecode_GetBinaryUUIDInMapSZ(QCBORDecodeContext *pCtx,
 
  Please see @ref Decode-Errors-Overview "Decode Errors Overview".
 
- See also QCBORDecode_ExitBstrWrapped(), QCBORDecode_EnterMap() and
- QCBORDecode_EnterArray().
+ With QCBORDecode_SetBstrEnterCache(),
+ QCBORDecode_EnterBstrWrappedFromMapN() and
+ QCBORDecode_EnterBstrWrappedFromMapSZ() remember the byte string they
+ last entered from the current map. Entering it again from the same map
+ with the same label and tag requirement uses the remembered position
+ rather than searching the map again.
+
+ See also QCBORDecode_ExitBstrWrapped(), QCBORDecode_EnterMap(),
+ QCBORDecode_EnterArray() and QCBORDecode_EnterBstrWrappedFromPos().
  */
 void QCBORDecode_EnterBstrWrapped(QCBORDecodeContext *pCtx,
                                   uint8_t             uTagRequirement,
@@ -1654,6 +1823,45 @@ void QCBORDecode_EnterBstrWrappedFromMapSZ(QCBORDecodeContext *pCtx,
                                            UsefulBufC         *pBstr);
 
 
+/**
+ * Storage for the byte string last entered from a map. See
+ * QCBORDecode_SetBstrEnterCache(). The contents are opaque.
+ */
+typedef struct _QCBORBstrEnterCache {
+   /* PRIVATE DATA STRUCTURE */
+   uint32_t uMapStartOffset;
+   uint32_t uBstrStartOffset;
+   uint32_t uBstrLength;
+   uint8_t  uLabelType; /* QCBOR_TYPE_NONE when nothing is remembered */
+   uint8_t  uTagRequirement;
+   union {
+      int64_t    int64;
+      UsefulBufC string;
+   } label;
+} QCBORBstrEnterCache;
+
+
+/**
+ * @brief Remember the byte string entered from a map.
+ *
+ * @param[in] pCtx    The decoder context.
+ * @param[in] pCache  Storage for what was entered or @c NULL to stop
+ *                    using it.
+ *
+ * With this, QCBORDecode_EnterBstrWrappedFromMapN() and
+ * QCBORDecode_EnterBstrWrappedFromMapSZ() keep the position of the
+ * byte string they enter in @c pCache, keyed by the map, the label
+ * and the tag requirement. Entering the same one again, as nested
+ * COSE validation does, needs no map search. Only one byte string is
+ * remembered.
+ *
+ * @c pCache is about 40 bytes and must stay valid while it is set. It
+ * belongs to one decoder context.
+ */
+void
+QCBORDecode_SetBstrEnterCache(QCBORDecodeContext *pCtx, QCBORBstrEnterCache *pCache);
+
+
 /**
  @brief Exit some bstr-wrapped CBOR  has been enetered.
 
@@ -1670,6 +1878,62 @@ void QCBORDecode_EnterBstrWrappedFromMapSZ(QCBORDecodeContext *pCtx,
 void QCBORDecode_ExitBstrWrapped(QCBORDecodeContext *pCtx);
 
 
+/**
+ The position of some bstr-wrapped CBOR in the input so that it can be
+ entered again without decoding the structures around it. It is filled
+ in by QCBORDecode_SaveBstrWrappedPos(). The members are private.
+ */
+typedef struct {
+   /* PRIVATE DATA STRUCTURE */
+   uint32_t uStartOffset;
+   uint32_t uLength;
+} QCBORBstrWrappedPos;
+
+
+/**
+ @brief Save the position of the bstr-wrapped CBOR currently entered.
+
+ @param[in] pCtx   The decode context.
+ @param[out] pPos  The saved position.
+
+ Bstr-wrapped CBOR must have been entered with
+ QCBORDecode_EnterBstrWrapped() or similar, otherwise
+ @ref QCBOR_ERR_EXIT_MISMATCH is set.
+
+ The position can be given to QCBORDecode_EnterBstrWrappedFromPos()
+ later to enter the same bstr-wrapped CBOR without decoding the items
+ around it. This is useful for layered protocols like COSE where a
+ payload nested several layers deep is validated more than once.
+ */
+void QCBORDecode_SaveBstrWrappedPos(QCBORDecodeContext  *pCtx,
+                                    QCBORBstrWrappedPos *pPos);
+
+
+/**
+ @brief Enter bstr-wrapped CBOR from a saved position.
+
+ @param[in] pCtx   The decode context.
+ @param[in] pPos   Position saved with QCBORDecode_SaveBstrWrappedPos().
+ @param[out] pBstr Pointer and length of the bstr-wrapped CBOR. May be @c NULL.
+
+ This is the same as QCBORDecode_EnterBstrWrapped() except the byte
+ string is not decoded and its tag requirement is not checked again;
+ the narrowing of the input and the new nesting level are set up
+ directly from the saved position. QCBORDecode_ExitBstrWrapped() is
+ called to exit it the same as any other bstr-wrapped CBOR.
+
+ This should be called at the same nesting level the byte string was
+ originally entered from, usually right after exiting it or after
+ exiting other bstr-wrapped CBOR entered from the same place. The
+ position must be in the input currently in scope, which is the
+ innermost entered bstr-wrapped CBOR or the whole input, otherwise
+ @ref QCBOR_ERR_HIT_END is set.
+ */
+void QCBORDecode_EnterBstrWrappedFromPos(QCBORDecodeContext        *pCtx,
+                                         const QCBORBstrWrappedPos *pPos,
+                                         UsefulBufC                *pBstr);
+
+
 
 
 /* ===========================================================================
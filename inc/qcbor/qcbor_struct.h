@@ -0,0 +1,311 @@
+/*==============================================================================
+ qcbor_struct.h -- Table-driven encoding and decoding of C structures
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_struct_h
+#define qcbor_struct_h
+
+
+#include <stddef.h> /* For offsetof() */
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_struct.h
+ *
+ * This encodes a C structure as a CBOR map and decodes a CBOR map
+ * into a C structure using a constant table that describes each
+ * member, its label and its type. It replaces long hand-written
+ * sequences of QCBOREncode_AddInt64ToMapN() and
+ * QCBORDecode_GetInt64InMapN() calls.
+ *
+ * Decoding is a single pass through the map. Each item is gotten once
+ * with QCBORDecode_GetNext() and its label looked up in the table, so
+ * the map is not searched again for each member as it is with the
+ * spiffy decode functions that get by label. Lookup starts after the
+ * member last found so it is one comparison per item when the map is
+ * in the same order as the table. This is noticeably faster for maps
+ * with more than a few members.
+ *
+ * Here is an example:
+ *
+ *     typedef struct {
+ *        uint32_t   uPresent;
+ *        int64_t    nAlg;
+ *        UsefulBufC Kid;
+ *        bool       bFlag;
+ *     } Header;
+ *
+ *     static const QCBORStructField HeaderFields[] = {
+ *        QCBOR_STRUCT_FIELD_N(1, Header, nAlg, QCBOR_STRUCT_INT64, QCBOR_STRUCT_REQUIRED),
+ *        QCBOR_STRUCT_FIELD_N(4, Header, Kid,  QCBOR_STRUCT_BYTES, 0),
+ *        QCBOR_STRUCT_FIELD_SZ("flag", Header, bFlag, QCBOR_STRUCT_BOOL, 0),
+ *     };
+ *
+ *     static const QCBORStructDesc HeaderDesc =
+ *        QCBOR_STRUCT_DESC(Header, uPresent, HeaderFields);
+ *
+ *     QCBOREncode_AddStruct(&ECtx, &HeaderDesc, &Header);
+ *     ...
+ *     QCBORDecode_GetStruct(&DCtx, &HeaderDesc, &Header);
+ *
+ * Every structure has a @c uint32_t bit field that records which
+ * members are present, bit 0 for the first member in the table and so
+ * on. The decoder sets it. The encoder outputs required members and
+ * the optional members whose bit is set.
+ *
+ * Text and byte strings are decoded as pointers into the input, as
+ * with QCBORDecode_GetTextString(). Map members that are not in the
+ * table are skipped. Arrays are not supported.
+ */
+
+
+/** Member is an @c int64_t */
+#define QCBOR_STRUCT_INT64  1
+/** Member is a @c uint64_t */
+#define QCBOR_STRUCT_UINT64 2
+/** Member is a @c double. Not available with @c USEFULBUF_DISABLE_ALL_FLOAT. */
+#define QCBOR_STRUCT_DOUBLE 3
+/** Member is a @c bool */
+#define QCBOR_STRUCT_BOOL   4
+/** Member is a @ref UsefulBufC holding a text string */
+#define QCBOR_STRUCT_TEXT   5
+/** Member is a @ref UsefulBufC holding a byte string */
+#define QCBOR_STRUCT_BYTES  6
+/** Member is a structure encoded as a map and described by @c pNested */
+#define QCBOR_STRUCT_MAP    7
+
+
+/** Flag for a member that must be present in the map */
+#define QCBOR_STRUCT_REQUIRED 0x01
+
+
+/** The maximum number of members in a structure */
+#define QCBOR_STRUCT_MAX_FIELDS 32
+
+
+struct QCBORStructDesc_;
+
+/**
+ * Describes one member of a structure. Usually initialized with
+ * QCBOR_STRUCT_FIELD_N(), QCBOR_STRUCT_FIELD_SZ(),
+ * QCBOR_STRUCT_MAP_N() or QCBOR_STRUCT_MAP_SZ().
+ */
+typedef struct {
+   int64_t                        nLabel;  /* Used when szLabel is NULL */
+   const char                    *szLabel;
+   uint16_t                       uOffset; /* From offsetof() */
+   uint8_t                        uType;   /* One of QCBOR_STRUCT_XXX */
+   uint8_t                        uFlags;
+   const struct QCBORStructDesc_ *pNested; /* For QCBOR_STRUCT_MAP */
+} QCBORStructField;
+
+
+/**
+ * Describes a structure. Usually initialized with QCBOR_STRUCT_DESC().
+ */
+typedef struct QCBORStructDesc_ {
+   const QCBORStructField *pFields;
+   uint16_t                uPresentOffset; /* From offsetof() */
+   uint8_t                 uNumFields;
+} QCBORStructDesc;
+
+
+#define QCBOR_STRUCT_FIELD_N(nLabel, Type, Member, uType, uFlags) \
+   {(nLabel), NULL, (uint16_t)offsetof(Type, Member), (uType), (uFlags), NULL}
+
+#define QCBOR_STRUCT_FIELD_SZ(szLabel, Type, Member, uType, uFlags) \
+   {0, (szLabel), (uint16_t)offsetof(Type, Member), (uType), (uFlags), NULL}
+
+#define QCBOR_STRUCT_MAP_N(nLabel, Type, Member, uFlags, pNestedDesc) \
+   {(nLabel), NULL, (uint16_t)offsetof(Type, Member), QCBOR_STRUCT_MAP, (uFlags), (pNestedDesc)}
+
+#define QCBOR_STRUCT_MAP_SZ(szLabel, Type, Member, uFlags, pNestedDesc) \
+   {0, (szLabel), (uint16_t)offsetof(Type, Member), QCBOR_STRUCT_MAP, (uFlags), (pNestedDesc)}
+
+#define QCBOR_STRUCT_DESC(Type, PresentMember, aFields) \
+   {(aFields), (uint16_t)offsetof(Type, PresentMember), \
+    (uint8_t)(sizeof(aFields)/sizeof((aFields)[0]))}
+
+
+/**
+ * @brief Encode a structure as a map.
+ *
+ * @param[in] pCtx     The encoding context.
+ * @param[in] pDesc    Description of the structure.
+ * @param[in] pStruct  The structure to encode.
+ *
+ * Members are output in the order of the table. Error handling is
+ * the same as QCBOREncode_AddInt64(). A table with more than @ref
+ * QCBOR_STRUCT_MAX_FIELDS members sets @ref QCBOR_ERR_UNSUPPORTED.
+ */
+void
+QCBOREncode_AddStruct(QCBOREncodeContext    *pCtx,
+                      const QCBORStructDesc *pDesc,
+                      const void            *pStruct);
+
+
+/**
+ * @brief Decode a map into a structure.
+ *
+ * @param[in] pCtx      The decode context.
+ * @param[in] pDesc     Description of the structure.
+ * @param[out] pStruct  The structure to fill in.
+ *
+ * This gets the next item, which must be a map, and all its contents.
+ * Members not in the map are not changed except for their present
+ * bits, which are cleared.
+ *
+ * Errors are handled like the other spiffy decode functions. If a
+ * required member is missing, @ref QCBOR_ERR_LABEL_NOT_FOUND is set.
+ * If a member is of the wrong type, @ref QCBOR_ERR_UNEXPECTED_TYPE is
+ * set. If a member is in the map twice, @ref QCBOR_ERR_DUPLICATE_LABEL
+ * is set. A table with more than @ref QCBOR_STRUCT_MAX_FIELDS members
+ * sets @ref QCBOR_ERR_UNSUPPORTED.
+ */
+void
+QCBORDecode_GetStruct(QCBORDecodeContext    *pCtx,
+                      const QCBORStructDesc *pDesc,
+                      void                  *pStruct);
+
+
+/**
+ * Describes one column for QCBORDecode_GetColumns() and
+ * QCBOREncode_AddColumns(). Usually initialized with QCBOR_COLUMN_N()
+ * or QCBOR_COLUMN_SZ().
+ *
+ * @c pValues is an array with room for the maximum number of rows of
+ * the type for @c uType, @c int64_t for @ref QCBOR_STRUCT_INT64, @ref
+ * UsefulBufC for @ref QCBOR_STRUCT_TEXT and so on. @ref
+ * QCBOR_STRUCT_MAP is not allowed.
+ *
+ * @c pNulls is a bit map with a bit for each row, bit 0 of byte 0 for
+ * the first row, bit 1 of byte 0 for the second and so on. The bit
+ * is set when the row's map doesn't have the column or has @c null
+ * for it. Then the value in @c pValues is zero. @c pNulls can be @c
+ * NULL if this isn't needed. When encoding, the bit says to leave the
+ * column out of the row.
+ */
+typedef struct {
+   int64_t     nLabel;  /* Used when szLabel is NULL */
+   const char *szLabel;
+   uint8_t     uType;   /* One of QCBOR_STRUCT_XXX */
+   uint8_t     uFlags;  /* QCBOR_STRUCT_REQUIRED for never absent or null */
+   void       *pValues;
+   uint8_t    *pNulls;
+} QCBORColumn;
+
+
+#define QCBOR_COLUMN_N(nLabel, uType, uFlags, pValues, pNulls) \
+   {(nLabel), NULL, (uType), (uFlags), (pValues), (pNulls)}
+
+#define QCBOR_COLUMN_SZ(szLabel, uType, uFlags, pValues, pNulls) \
+   {0, (szLabel), (uType), (uFlags), (pValues), (pNulls)}
+
+
+/**
+ * @brief Decode an array of maps into columns.
+ *
+ * @param[in] pCtx         The decode context.
+ * @param[in] pColumns     The columns.
+ * @param[in] uNumColumns  The number of columns, up to @ref
+ *                         QCBOR_STRUCT_MAX_FIELDS.
+ * @param[in] uMaxRows     The number of values each column has room
+ *                         for.
+ * @param[out] puNumRows   The number of rows decoded.
+ *
+ * This gets the next item, which must be an array of maps, and puts
+ * the value for each column in each map in the column's array. It is
+ * for records that all have the same members, and is quicker than
+ * decoding them one at a time with QCBORDecode_GetStruct() into an
+ * array of structures and copying from there.
+ *
+ * The order of the labels in the first map is remembered. For each
+ * member of the maps after, the column for the label in the same
+ * position in the first map is checked first. When the maps are all
+ * in the same order, which is usual, finding the column is one
+ * comparison. Maps in other orders are decoded correctly, just more
+ * slowly. Members not in the columns are skipped.
+ *
+ * Errors are handled like the other spiffy decode functions and are
+ * the same as for QCBORDecode_GetStruct(). @ref
+ * QCBOR_ERR_LABEL_NOT_FOUND is also set for a required column that is
+ * @c null. @ref QCBOR_ERR_ARRAY_TOO_LONG is set if there are more
+ * than @c uMaxRows maps. @c *puNumRows is the number of rows decoded
+ * before an error.
+ */
+void
+QCBORDecode_GetColumns(QCBORDecodeContext *pCtx,
+                       const QCBORColumn  *pColumns,
+                       uint8_t             uNumColumns,
+                       size_t              uMaxRows,
+                       size_t             *puNumRows);
+
+
+/** Option for QCBOREncode_AddColumns() to output a map of columns
+ *  with RFC 8746 typed arrays rather than an array of maps */
+#define QCBOR_COLUMNS_TYPED_ARRAYS 0x01
+
+
+/**
+ * @brief Encode columns as an array of maps.
+ *
+ * @param[in] pCtx         The encoding context.
+ * @param[in] pColumns     The columns.
+ * @param[in] uNumColumns  The number of columns, up to @ref
+ *                         QCBOR_STRUCT_MAX_FIELDS.
+ * @param[in] uNumRows     The number of values in each column.
+ * @param[in] uOptions     0 or @ref QCBOR_COLUMNS_TYPED_ARRAYS.
+ *
+ * This is the opposite of QCBORDecode_GetColumns(). It outputs an
+ * array with a map for each row. The members of each map are in the
+ * order of the columns. A column whose null bit is set for the row is
+ * left out of its map unless the column is required, in which case
+ * the value in @c pValues is output anyway.
+ *
+ * It is quicker than adding the maps one at a time. Each label is
+ * encoded once rather than once for each row, and the heads of the
+ * array and maps are output with the counts they will have rather than
+ * inserted when they are closed.
+ *
+ * With @ref QCBOR_COLUMNS_TYPED_ARRAYS, the output is instead a map
+ * from the label of each column to all its values. A column of @ref
+ * QCBOR_STRUCT_INT64, @ref QCBOR_STRUCT_UINT64, @ref
+ * QCBOR_STRUCT_DOUBLE or @ref QCBOR_STRUCT_BOOL without nulls is a
+ * big-endian typed array from RFC 8746, a byte string tagged 75, 67,
+ * 82 or 64. Other columns are arrays with @c null for the rows that
+ * have the null bit set. QCBORDecode_GetColumns() doesn't decode this.
+ *
+ * Error handling is the same as QCBOREncode_AddInt64(). @ref
+ * QCBOR_ERR_ARRAY_TOO_LONG is set if there are more than @ref
+ * QCBOR_MAX_ITEMS_IN_ARRAY rows and @ref QCBOR_ERR_UNSUPPORTED for a
+ * column of @ref QCBOR_STRUCT_MAP or too many columns.
+ */
+void
+QCBOREncode_AddColumns(QCBOREncodeContext *pCtx,
+                       const QCBORColumn  *pColumns,
+                       uint8_t             uNumColumns,
+                       size_t              uNumRows,
+                       uint32_t            uOptions);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_struct_h */
@@ -0,0 +1,206 @@
+/*==============================================================================
+ qcbor_transform.h -- Streaming transformation of encoded CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_transform_h
+#define qcbor_transform_h
+
+
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_transform.h
+ *
+ * QCBOREncode_AddTransformed() copies encoded CBOR into the output of
+ * an encoder, passing each map member and array element through a
+ * list of stages on the way. A stage can drop an item, rename a map
+ * label, replace a value or have the members of a map sorted. This is
+ * for things like redaction and renaming of fields in messages passed
+ * through a gateway without decoding them into structures and
+ * encoding them again.
+ *
+ * Only the heads of the input are decoded. Items no stage changes are
+ * copied byte for byte, and a run of them next to each other is
+ * copied with one copy. When all the stages say they don't need to
+ * see inside an array or map, it is copied whole without going into
+ * it. So when little is changed, the cost is close to that of copying
+ * the input.
+ *
+ * An array or map that is gone into is output with
+ * QCBOREncode_OpenArray() or QCBOREncode_OpenMap() and closed the
+ * same way, so its head is in preferred serialization and its count
+ * is right after items are dropped. Only definite-length input is
+ * supported.
+ *
+ *     static QCBORError
+ *     Redact(void *pCtx, const QCBORTransformItem *pItem, QCBORTransformEdit *pEdit)
+ *     {
+ *        if(pItem->uLabelType == QCBOR_TYPE_TEXT_STRING &&
+ *           UsefulBuf_Compare(pItem->label.string, UsefulBuf_FROM_SZ_LITERAL("password")) == 0) {
+ *           pEdit->bDrop = true;
+ *        }
+ *        pEdit->bSkipMembers = pItem->uNestLevel > 0;
+ *        return QCBOR_SUCCESS;
+ *     }
+ *
+ *     const QCBORTransformStage Stages[] = {{Redact, NULL}};
+ *     QCBOREncode_AddTransformed(&ECtx, Message, Stages, 1);
+ */
+
+
+/**
+ * An item passed to a stage. The label and value are as changed by
+ * the stages before.
+ */
+typedef struct {
+   /** 0 for the item passed to QCBOREncode_AddTransformed(), 1 for
+    *  the members or elements in it and so on. */
+   uint8_t    uNestLevel;
+
+   /** @ref QCBOR_TYPE_MAP or @ref QCBOR_TYPE_ARRAY for what this
+    *  item is in, or @ref QCBOR_TYPE_NONE at level 0. */
+   uint8_t    uParentType;
+
+   /** The position of this item in its array or map, counting from 0. */
+   uint16_t   uIndex;
+
+   /** @ref QCBOR_TYPE_INT64, @ref QCBOR_TYPE_UINT64, @ref
+    *  QCBOR_TYPE_TEXT_STRING or @ref QCBOR_TYPE_BYTE_STRING for a map
+    *  member, @ref QCBOR_TYPE_ANY for a member with another kind of
+    *  label or @ref QCBOR_TYPE_NONE if not in a map. Tags on labels
+    *  are ignored. */
+   uint8_t    uLabelType;
+   union {
+      int64_t    int64;
+      uint64_t   uint64;
+      UsefulBufC string;
+   } label;
+
+   /** The CBOR major type of the value, such as
+    *  @ref CBOR_MAJOR_TYPE_MAP, after any tags. */
+   uint8_t    uMajorType;
+
+   /** The outermost tag number on the value or @ref
+    *  CBOR_TAG_INVALID64. */
+   uint64_t   uTagNumber;
+
+   /** The encoded value including its tags. It can be decoded with
+    *  QCBORDecode_Init() if more than the above is needed. */
+   UsefulBufC Value;
+} QCBORTransformItem;
+
+
+/**
+ * What a stage wants done to an item. Stages after the one that sets
+ * @c bDrop are not called. The other changes are seen by the stages
+ * after.
+ */
+typedef struct {
+   /** Leave out the item. For a map member, this is both the label
+    *  and the value. */
+   bool       bDrop;
+
+   /** For a map, sort its members after they are transformed as
+    *  QCBOREncode_CloseAndSortMap() does. */
+   bool       bSortMap;
+
+   /** For an array or map, this stage doesn't need to see what is in
+    *  it. This is cleared before each stage is called. If all the
+    *  stages set it and nothing else is changed, the array or map is
+    *  copied whole. */
+   bool       bSkipMembers;
+
+   /** @ref QCBOR_TYPE_TEXT_STRING or @ref QCBOR_TYPE_INT64 to give a
+    *  map member the label in @c NewLabel or @c nNewLabel. @ref
+    *  QCBOR_TYPE_NONE to keep it. */
+   uint8_t    uNewLabelType;
+   int64_t    nNewLabel;
+   UsefulBufC NewLabel;
+
+   /** The encoded CBOR to put in place of the value, or @ref
+    *  NULLUsefulBufC to keep it. It is not checked, as with
+    *  QCBOREncode_AddEncoded(). What was in the value isn't passed to
+    *  any stage. */
+   UsefulBufC NewValue;
+} QCBORTransformEdit;
+
+
+/**
+ * @brief A stage in a transformation.
+ *
+ * @param[in] pStageCtx  The context in the @ref QCBORTransformStage.
+ * @param[in] pItem      The item.
+ * @param[in,out] pEdit  What to do to the item.
+ *
+ * Return @ref QCBOR_SUCCESS to continue. Anything else stops the
+ * transformation and is set as the encoder's error. @ref
+ * QCBOR_ERR_CALLBACK_FAIL is for errors that are not CBOR errors.
+ */
+typedef QCBORError (*QCBORTransformFn)(void                     *pStageCtx,
+                                       const QCBORTransformItem *pItem,
+                                       QCBORTransformEdit       *pEdit);
+
+
+/** A stage and its context */
+typedef struct {
+   QCBORTransformFn pfStage;
+   void            *pStageCtx;
+} QCBORTransformStage;
+
+
+/**
+ * @brief Add encoded CBOR to the output, transformed by stages.
+ *
+ * @param[in] pCtx        The encoding context.
+ * @param[in] Encoded     One encoded data item.
+ * @param[in] pStages     The stages, called in order.
+ * @param[in] uNumStages  The number of stages.
+ *
+ * This adds one item to the output like QCBOREncode_AddEncoded(), but
+ * each item in @c Encoded, starting with @c Encoded itself, is first
+ * passed to each of the stages. If @c Encoded itself is dropped,
+ * nothing is added.
+ *
+ * Errors are set in the encoder and returned by
+ * QCBOREncode_Finish(). They are:
+ *
+ * - @ref QCBOR_ERR_ENCODE_UNSUPPORTED for indefinite-length input.
+ * - The error the decoder would give, such as @ref QCBOR_ERR_HIT_END
+ *   or @ref QCBOR_ERR_BAD_TYPE_7, for input that is not well-formed.
+ * - @ref QCBOR_ERR_EXTRA_BYTES for more than one item in @c Encoded.
+ * - @ref QCBOR_ERR_ARRAY_TOO_LONG for an array or map with more than
+ *   @ref QCBOR_MAX_ITEMS_IN_ARRAY items that a stage doesn't skip.
+ * - Errors returned by the stages.
+ * - Errors for the encoding such as @ref
+ *   QCBOR_ERR_ARRAY_NESTING_TOO_DEEP.
+ *
+ * Sorting is not done when only computing the size.
+ */
+void
+QCBOREncode_AddTransformed(QCBOREncodeContext        *pCtx,
+                           UsefulBufC                 Encoded,
+                           const QCBORTransformStage *pStages,
+                           size_t                     uNumStages);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_transform_h */
@@ -0,0 +1,279 @@
+/*==============================================================================
+ qcbor_view.h -- Lazy random-access view of encoded CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_view_h
+#define qcbor_view_h
+
+
+#include "qcbor/qcbor_decode.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#if 0
+} // Keep editor indention formatting happy
+#endif
+#endif
+
+
+/**
+ * @file qcbor_view.h
+ *
+ * A view is a reference to one data item in a buffer of
+ * encoded CBOR. Getting the view of a member of a map or an element
+ * of an array decodes only the heads of the items before it; strings
+ * are skipped over without looking at them and nothing after it is
+ * touched. This is much less work than decoding the whole of a large
+ * document when only a few items in it are needed, and the items can
+ * be gotten in any order without entering and exiting maps.
+ *
+ *     QCBORView_Init(&Envelope, Message);
+ *     QCBORView_GetInMapSZ(&Envelope, "route", NULL, &Route);
+ *     QCBORView_GetIndex(&Route, 0, NULL, &First);
+ *     QCBORView_GetItem(&First, &Item);
+ *
+ * A view is just an offset into the buffer so it can be copied
+ * freely. The buffer is never written except by QCBORView_Replace(),
+ * so any number of views in any number of threads can use the same
+ * buffer at the same time.
+ *
+ * Views don't check that what they skip over is well-formed beyond
+ * what is needed to find its end. Use QCBORDecode_GetNext() or
+ * QCBORDecode_ValidateSchema() first if this matters.
+ *
+ * To make repeated lookups in the same map or array faster, a cache
+ * can be passed. It remembers where members and elements that have
+ * been found are. A lookup by label compares the label at each
+ * remembered position before searching the map. A lookup by index
+ * starts from the closest remembered position before it. The cache
+ * is written to by every lookup, so it must not be shared between
+ * threads without a lock, but each thread can have its own.
+ */
+
+
+/**
+ * A view of a data item. Initialize with QCBORView_Init(). It is
+ * filled in by the functions that get a member or element.
+ */
+typedef struct {
+   UsefulBufC Encoded;  /* The whole buffer */
+   size_t     uOffset;  /* Where the item, including its tags, starts */
+} QCBORView;
+
+
+/** One position remembered by @ref QCBORViewCache */
+typedef struct {
+   size_t   uContainer; /* Offset of the array or map */
+   size_t   uOffset;    /* Offset of the element or the member's label */
+   uint32_t uIndex;     /* Element or member number */
+} QCBORViewCacheEntry;
+
+
+/**
+ * A cache of positions in the buffer. Initialize with
+ * QCBORView_InitCache(). Entries are replaced round robin when it is
+ * full.
+ */
+typedef struct {
+   const void          *pBuffer;    /* The buffer the entries are for */
+   size_t               uBufferLen; /* and its length */
+   QCBORViewCacheEntry *pEntries;
+   uint32_t             uNumEntries;
+   uint32_t             uUsed;
+   uint32_t             uNext;
+} QCBORViewCache;
+
+
+/**
+ * @brief Initialize a view of the first item in a buffer.
+ *
+ * @param[out] pView    The view to initialize.
+ * @param[in] Encoded   The encoded CBOR.
+ */
+static void
+QCBORView_Init(QCBORView *pView, UsefulBufC Encoded);
+
+
+/**
+ * @brief Initialize a cache for views.
+ *
+ * @param[out] pCache       The cache to initialize.
+ * @param[in] pEntries      Storage for the entries.
+ * @param[in] uNumEntries   The number of entries in @c pEntries.
+ *
+ * The cache is for one buffer at a time. If it is used with views of
+ * another buffer, it is emptied first. A buffer is another buffer if
+ * its pointer or its length is different.
+ *
+ * If the caller encodes a new document into the same buffer and it
+ * comes out the same length, the cache can't tell. Call this again to
+ * empty it before using it with the new document.
+ */
+static void
+QCBORView_InitCache(QCBORViewCache      *pCache,
+                    QCBORViewCacheEntry *pEntries,
+                    uint32_t             uNumEntries);
+
+
+/**
+ * @brief Decode the item a view refers to.
+ *
+ * @param[in] pView   The view.
+ * @param[out] pItem  The decoded item.
+ *
+ * @return The same errors as QCBORDecode_GetNext().
+ *
+ * This is the same as QCBORDecode_GetNext() on the item. Strings
+ * point into the buffer. For arrays and maps, only the array or map
+ * item is decoded, not the contents. Indefinite-length strings can't
+ * be decoded this way because there is no string allocator.
+ */
+QCBORError
+QCBORView_GetItem(const QCBORView *pView, QCBORItem *pItem);
+
+
+/**
+ * @brief Get a view of an element of an array.
+ *
+ * @param[in] pView    View of the array.
+ * @param[in] uIndex   The element number, 0 for the first.
+ * @param[in] pCache   The cache to use or @c NULL.
+ * @param[out] pChild  View of the element.
+ *
+ * @retval QCBOR_ERR_UNEXPECTED_TYPE  @c pView is not of an array.
+ * @retval QCBOR_ERR_NO_MORE_ITEMS    The array has fewer elements.
+ *
+ * Errors from the heads that are decoded such as @ref
+ * QCBOR_ERR_HIT_END are also returned. Tags on the array are skipped.
+ */
+QCBORError
+QCBORView_GetIndex(const QCBORView *pView,
+                   uint32_t         uIndex,
+                   QCBORViewCache  *pCache,
+                   QCBORView       *pChild);
+
+
+/**
+ * @brief Get a view of the member of a map with an integer label.
+ *
+ * @param[in] pView    View of the map.
+ * @param[in] nLabel   The label.
+ * @param[in] pCache   The cache to use or @c NULL.
+ * @param[out] pChild  View of the member's value.
+ *
+ * @retval QCBOR_ERR_UNEXPECTED_TYPE  @c pView is not of a map.
+ * @retval QCBOR_ERR_LABEL_NOT_FOUND  No member has the label.
+ *
+ * Errors from the heads that are decoded such as @ref
+ * QCBOR_ERR_HIT_END are also returned. If there are duplicate labels,
+ * the first is found. Tagged labels are never matched.
+ */
+QCBORError
+QCBORView_GetInMapN(const QCBORView *pView,
+                    int64_t          nLabel,
+                    QCBORViewCache  *pCache,
+                    QCBORView       *pChild);
+
+
+/**
+ * @brief Get a view of the member of a map with a text string label.
+ *
+ * @param[in] pView    View of the map.
+ * @param[in] szLabel  The label.
+ * @param[in] pCache   The cache to use or @c NULL.
+ * @param[out] pChild  View of the member's value.
+ *
+ * This is the same as QCBORView_GetInMapN() except for the label.
+ * Indefinite-length labels are never matched.
+ */
+QCBORError
+QCBORView_GetInMapSZ(const QCBORView *pView,
+                     const char      *szLabel,
+                     QCBORViewCache  *pCache,
+                     QCBORView       *pChild);
+
+
+/**
+ * @brief Replace the item a view refers to in place.
+ *
+ * @param[in] pView       View of the item to replace.
+ * @param[in] Buffer      The buffer the view's encoded CBOR is in. Its
+ *                        length is the space available.
+ * @param[in] NewItem     The encoded item to put in its place.
+ * @param[out] puNewLen   The length of the encoded CBOR afterwards.
+ *
+ * @retval QCBOR_ERR_BUFFER_TOO_SMALL  There is not enough space in
+ *                                     @c Buffer, or it is shorter
+ *                                     than the view's encoded CBOR.
+ *                                     Nothing is changed.
+ * @retval QCBOR_ERR_EXTRA_BYTES       @c NewItem is more than one item.
+ * @retval QCBOR_ERR_UNSUPPORTED       The view's encoded CBOR doesn't
+ *                                     start at @c Buffer.
+ *
+ * This updates one item in stored CBOR, for example a counter or
+ * time stamp, without decoding and encoding all of it. Get the view
+ * of the item by its path with QCBORView_GetInMapSZ() and such, then
+ * call this. Only the heads on the path and the item replaced are
+ * decoded.
+ *
+ * When @c NewItem is the same size as the item it replaces, it is
+ * just copied over it. Otherwise the rest of the encoded CBOR is
+ * moved once with memmove(). The heads of the arrays and maps the
+ * item is in don't change because they give a number of items, not
+ * a number of bytes. Any tags on the item are replaced too.
+ *
+ * Errors decoding the item being replaced and @c NewItem are also
+ * returned. Views and cache entries for items after the one replaced
+ * are no longer correct when the size changes.
+ */
+QCBORError
+QCBORView_Replace(const QCBORView *pView,
+                  UsefulBuf        Buffer,
+                  UsefulBufC       NewItem,
+                  size_t          *puNewLen);
+
+
+
+
+/* ===========================================================================
+   BEGINNING OF PRIVATE INLINE IMPLEMENTATION
+   ========================================================================== */
+
+static inline void
+QCBORView_Init(QCBORView *pView, UsefulBufC Encoded)
+{
+   pView->Encoded = Encoded;
+   pView->uOffset = 0;
+}
+
+
+static inline void
+QCBORView_InitCache(QCBORViewCache      *pCache,
+                    QCBORViewCacheEntry *pEntries,
+                    uint32_t             uNumEntries)
+{
+   pCache->pBuffer     = NULL;
+   pCache->uBufferLen  = 0;
+   pCache->pEntries    = pEntries;
+   pCache->uNumEntries = uNumEntries;
+   pCache->uUsed       = 0;
+   pCache->uNext       = 0;
+}
+
+/* ===========================================================================
+   END OF PRIVATE INLINE IMPLEMENTATION
+   ========================================================================== */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* qcbor_view_h */
@@ -362,6 +362,66 @@ void UsefulOutBuf_Advance(UsefulOutBuf *pMe, size_t uAmount)
 }
 
 
+/*
+ * Reverse the order of the bytes in a range. Used by
+ * UsefulOutBuf_Swap().
+ */
+static void
+UsefulOutBuf_Private_Reverse(uint8_t *pStart, uint8_t *pEnd)
+{
+   uint8_t uTmp;
+
+   while(pStart + 1 < pEnd) {
+      pEnd--;
+      uTmp    = *pStart;
+      *pStart = *pEnd;
+      *pEnd   = uTmp;
+      pStart++;
+   }
+}
+
+
+/*
+ * Public function -- see UsefulBuf.h
+ */
+void UsefulOutBuf_Swap(UsefulOutBuf *pMe,
+                       size_t        uStartOffset,
+                       size_t        uPivotOffset,
+                       size_t        uEndOffset)
+{
+   if(pMe->err) {
+      /* Already in error state. */
+      return;
+   }
+
+   /* The checks here, like those in UsefulOutBuf_InsertUsefulBuf(),
+    * make sure all three offsets are within the valid data so the
+    * pointer math below can't go off the end of the buffer.
+    */
+   if(uStartOffset > uPivotOffset ||
+      uPivotOffset > uEndOffset ||
+      uEndOffset > pMe->data_len ||
+      pMe->data_len > pMe->UB.len) {
+      pMe->err = 1;
+      return;
+   }
+
+   if(pMe->UB.ptr == NULL) {
+      /* Size calculation mode. Nothing to swap. */
+      return;
+   }
+
+   /* Reversing each of the two regions and then reversing the whole
+    * gives the two regions swapped. Each byte is moved twice which is
+    * fine for the sizes this is used for and needs no extra memory.
+    */
+   uint8_t *pBase = (uint8_t *)pMe->UB.ptr;
+   UsefulOutBuf_Private_Reverse(pBase + uStartOffset, pBase + uPivotOffset);
+   UsefulOutBuf_Private_Reverse(pBase + uPivotOffset, pBase + uEndOffset);
+   UsefulOutBuf_Private_Reverse(pBase + uStartOffset, pBase + uEndOffset);
+}
+
+
 /*
  Public function -- see UsefulBuf.h
  */
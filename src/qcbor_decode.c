@@ -35,6 +35,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "qcbor/qcbor_decode.h"
 #include "qcbor/qcbor_spiffy_decode.h"
 #include "ieee754.h" /* Does not use math.h */
+#include "qcbor_decode_private.h"
 
 #ifndef QCBOR_DISABLE_FLOAT_HW_USE
 
@@ -347,6 +348,11 @@ DecodeNesting_EnterBoundedMapOrArray(QCBORDecodeNesting *pNesting,
 
    DecodeNesting_SetMapOrArrayBoundedMode(pNesting, bIsEmpty, uOffset);
 
+   /* The end of an empty one is where it starts. Otherwise it is
+    * known when a map search or the traversal gets to it. */
+   pNesting->pCurrent->u.ma.uEndOffset = bIsEmpty ? (uint32_t)uOffset :
+                                                    QCBOR_MAP_OFFSET_CACHE_INVALID;
+
    return QCBOR_SUCCESS;
 }
 
@@ -487,6 +493,20 @@ DecodeNesting_GetPreviousBoundedEnd(const QCBORDecodeNesting *pMe)
 }
 
 
+static inline uint32_t
+DecodeNesting_GetBstrScopeStart(const QCBORDecodeNesting *pNesting)
+{
+   /* The innermost byte-count tracked level. The top level is always
+    * one and its start offset is 0. */
+   const struct nesting_decode_level *pLevel = pNesting->pCurrent;
+   while(pLevel != &(pNesting->pLevels[0]) &&
+         pLevel->uLevelType != QCBOR_TYPE_BYTE_STRING) {
+      pLevel--;
+   }
+   return pLevel->u.bs.uBstrStartOffset;
+}
+
+
 
 
 #ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
@@ -574,6 +594,50 @@ void QCBORDecode_Init(QCBORDecodeContext *pMe,
 }
 
 
+/*
+ * Public function, see header file
+ */
+QCBORError QCBORDecode_Prepare(QCBORDecodePrepared *pPrepared,
+                               UsefulBufC           EncodedCBOR,
+                               QCBORDecodeMode      nMode)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   QCBORError         uReturn;
+
+   /* Decode everything once. This checks it and fills in the tag
+    * number mapping which is the only thing decoding changes that is
+    * the same for every decode of it.
+    */
+   QCBORDecode_Init(&DCtx, EncodedCBOR, nMode);
+   do {
+      uReturn = QCBORDecode_GetNext(&DCtx, &Item);
+   } while(uReturn == QCBOR_SUCCESS);
+   if(uReturn == QCBOR_ERR_NO_MORE_ITEMS) {
+      uReturn = QCBOR_SUCCESS;
+   }
+
+   pPrepared->Encoded     = EncodedCBOR;
+   pPrepared->uDecodeMode = (uint8_t)nMode;
+   pPrepared->uLastError  = (uint8_t)uReturn;
+   memcpy(pPrepared->auMappedTags, DCtx.auMappedTags, sizeof(DCtx.auMappedTags));
+
+   return uReturn;
+}
+
+
+/*
+ * Public function, see header file
+ */
+void QCBORDecode_InitFromPrepared(QCBORDecodeContext        *pMe,
+                                  const QCBORDecodePrepared *pPrepared)
+{
+   QCBORDecode_Init(pMe, pPrepared->Encoded, pPrepared->uDecodeMode);
+   memcpy(pMe->auMappedTags, pPrepared->auMappedTags, sizeof(pMe->auMappedTags));
+   pMe->uLastError = pPrepared->uLastError;
+}
+
+
 #ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
 
 /*
@@ -663,288 +727,11 @@ void QCBORDecode_SetCallerConfiguredTagList(QCBORDecodeContext   *pMe,
  * Int is used for values that need less than 16-bits and would be
  * subject to integer promotion and result in complaining from static
  * analyzers.
- */
-
-
-/**
- * @brief Decode the CBOR head, the type and argument.
- *
- * @param[in] pUInBuf            The input buffer to read from.
- * @param[out] pnMajorType       The decoded major type.
- * @param[out] puArgument        The decoded argument.
- * @param[out] pnAdditionalInfo  The decoded Lower 5 bits of initial byte.
- *
- * @retval QCBOR_ERR_UNSUPPORTED
- * @retval QCBOR_ERR_HIT_END
- *
- * This decodes the CBOR "head" that every CBOR data item has. See
- * longer explaination of the head in documentation for
- * QCBOREncode_EncodeHead().
- *
- * This does the network->host byte order conversion. The conversion
- * here also results in the conversion for floats in addition to that
- * for lengths, tags and integer values.
- *
- * The int type is preferred to uint8_t for some variables as this
- * avoids integer promotions, can reduce code size and makes static
- * analyzers happier.
- */
-static inline QCBORError
-DecodeHead(UsefulInputBuf *pUInBuf,
-           int            *pnMajorType,
-           uint64_t       *puArgument,
-           int            *pnAdditionalInfo)
-{
-   QCBORError uReturn;
-
-   /* Get the initial byte that every CBOR data item has and break it
-    * down. */
-   const int nInitialByte    = (int)UsefulInputBuf_GetByte(pUInBuf);
-   const int nTmpMajorType   = nInitialByte >> 5;
-   const int nAdditionalInfo = nInitialByte & 0x1f;
-
-   /* Where the argument accumulates */
-   uint64_t uArgument;
-
-   if(nAdditionalInfo >= LEN_IS_ONE_BYTE && nAdditionalInfo <= LEN_IS_EIGHT_BYTES) {
-      /* Need to get 1,2,4 or 8 additional argument bytes. Map
-       * LEN_IS_ONE_BYTE..LEN_IS_EIGHT_BYTES to actual length.
-       */
-      static const uint8_t aIterate[] = {1,2,4,8};
-
-      /* Loop getting all the bytes in the argument */
-      uArgument = 0;
-      for(int i = aIterate[nAdditionalInfo - LEN_IS_ONE_BYTE]; i; i--) {
-         /* This shift and add gives the endian conversion. */
-         uArgument = (uArgument << 8) + UsefulInputBuf_GetByte(pUInBuf);
-      }
-   } else if(nAdditionalInfo >= ADDINFO_RESERVED1 && nAdditionalInfo <= ADDINFO_RESERVED3) {
-      /* The reserved and thus-far unused additional info values */
-      uReturn = QCBOR_ERR_UNSUPPORTED;
-      goto Done;
-   } else {
-      /* Less than 24, additional info is argument or 31, an
-       * indefinite-length.  No more bytes to get.
-       */
-      uArgument = (uint64_t)nAdditionalInfo;
-   }
-
-   if(UsefulInputBuf_GetError(pUInBuf)) {
-      uReturn = QCBOR_ERR_HIT_END;
-      goto Done;
-   }
-
-   /* All successful if arrived here. */
-   uReturn           = QCBOR_SUCCESS;
-   *pnMajorType      = nTmpMajorType;
-   *puArgument       = uArgument;
-   *pnAdditionalInfo = nAdditionalInfo;
-
-Done:
-   return uReturn;
-}
-
-
-/**
- * @brief Decode integer types, major types 0 and 1.
- *
- * @param[in] nMajorType     The CBOR major type (0 or 1).
- * @param[in] uArgument      The argument from the head.
- * @param[out] pDecodedItem  The filled in decoded item.
- *
- * @retval QCBOR_ERR_INT_OVERFLOW
- *
- * Must only be called when major type is 0 or 1.
- *
- * CBOR doesn't explicitly specify two's compliment for integers but
- * all CPUs use it these days and the test vectors in the RFC are
- * so. All integers in the CBOR structure are positive and the major
- * type indicates positive or negative.  CBOR can express positive
- * integers up to 2^x - 1 where x is the number of bits and negative
- * integers down to 2^x.  Note that negative numbers can be one more
- * away from zero than positive.  Stdint, as far as I can tell, uses
- * two's compliment to represent negative integers.
- */
-static inline QCBORError
-DecodeInteger(int nMajorType, uint64_t uArgument, QCBORItem *pDecodedItem)
-{
-   QCBORError uReturn = QCBOR_SUCCESS;
-
-   if(nMajorType == CBOR_MAJOR_TYPE_POSITIVE_INT) {
-      if (uArgument <= INT64_MAX) {
-         pDecodedItem->val.int64 = (int64_t)uArgument;
-         pDecodedItem->uDataType = QCBOR_TYPE_INT64;
-
-      } else {
-         pDecodedItem->val.uint64 = uArgument;
-         pDecodedItem->uDataType  = QCBOR_TYPE_UINT64;
-      }
-
-   } else {
-      if(uArgument <= INT64_MAX) {
-         /* CBOR's representation of negative numbers lines up with
-          * the two-compliment representation. A negative integer has
-          * one more in range than a positive integer. INT64_MIN is
-          * equal to (-INT64_MAX) - 1.
-          */
-         pDecodedItem->val.int64 = (-(int64_t)uArgument) - 1;
-         pDecodedItem->uDataType = QCBOR_TYPE_INT64;
-
-      } else {
-         /* C can't represent a negative integer in this range so it
-          * is an error.
-          */
-         uReturn = QCBOR_ERR_INT_OVERFLOW;
-      }
-   }
-
-   return uReturn;
-}
-
-
-/* Make sure #define value line up as DecodeSimple counts on this. */
-#if QCBOR_TYPE_FALSE != CBOR_SIMPLEV_FALSE
-#error QCBOR_TYPE_FALSE macro value wrong
-#endif
-
-#if QCBOR_TYPE_TRUE != CBOR_SIMPLEV_TRUE
-#error QCBOR_TYPE_TRUE macro value wrong
-#endif
-
-#if QCBOR_TYPE_NULL != CBOR_SIMPLEV_NULL
-#error QCBOR_TYPE_NULL macro value wrong
-#endif
-
-#if QCBOR_TYPE_UNDEF != CBOR_SIMPLEV_UNDEF
-#error QCBOR_TYPE_UNDEF macro value wrong
-#endif
-
-#if QCBOR_TYPE_BREAK != CBOR_SIMPLE_BREAK
-#error QCBOR_TYPE_BREAK macro value wrong
-#endif
-
-#if QCBOR_TYPE_DOUBLE != DOUBLE_PREC_FLOAT
-#error QCBOR_TYPE_DOUBLE macro value wrong
-#endif
-
-#if QCBOR_TYPE_FLOAT != SINGLE_PREC_FLOAT
-#error QCBOR_TYPE_FLOAT macro value wrong
-#endif
-
-
-/**
- * @brief Decode major type 7 -- true, false, floating-point, break...
  *
- * @param[in] nAdditionalInfo   The lower five bits from the initial byte.
- * @param[in] uArgument         The argument from the head.
- * @param[out] pDecodedItem     The filled in decoded item.
- *
- * @retval QCBOR_ERR_HALF_PRECISION_DISABLED
- * @retval QCBOR_ERR_ALL_FLOAT_DISABLED
- * @retval QCBOR_ERR_BAD_TYPE_7
+ * DecodeHead(), DecodeInteger() and DecodeType7() are in
+ * qcbor_decode_private.h.
  */
 
-static inline QCBORError
-DecodeType7(int nAdditionalInfo, uint64_t uArgument, QCBORItem *pDecodedItem)
-{
-   QCBORError uReturn = QCBOR_SUCCESS;
-
-   /* uAdditionalInfo is 5 bits from the initial byte. Compile time
-    * checks above make sure uAdditionalInfo values line up with
-    * uDataType values.  DecodeHead() never returns an AdditionalInfo
-    * > 0x1f so cast is safe.
-    */
-   pDecodedItem->uDataType = (uint8_t)nAdditionalInfo;
-
-   switch(nAdditionalInfo) {
-      /* No check for ADDINFO_RESERVED1 - ADDINFO_RESERVED3 as they
-       * are caught before this is called.
-       */
-
-      case HALF_PREC_FLOAT: /* 25 */
-#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
-         /* Half-precision is returned as a double.  The cast to
-          * uint16_t is safe because the encoded value was 16 bits. It
-          * was widened to 64 bits to be passed in here.
-          */
-         pDecodedItem->val.dfnum = IEEE754_HalfToDouble((uint16_t)uArgument);
-         pDecodedItem->uDataType = QCBOR_TYPE_DOUBLE;
-#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
-         uReturn = FLOAT_ERR_CODE_NO_HALF_PREC(QCBOR_SUCCESS);
-         break;
-      case SINGLE_PREC_FLOAT: /* 26 */
-#ifndef USEFULBUF_DISABLE_ALL_FLOAT
-         /* Single precision is normally returned as a double since
-          * double is widely supported, there is no loss of precision,
-          * it makes it easy for the caller in most cases and it can
-          * be converted back to single with no loss of precision
-          *
-          * The cast to uint32_t is safe because the encoded value was
-          * 32 bits. It was widened to 64 bits to be passed in here.
-          */
-         {
-            const float f = UsefulBufUtil_CopyUint32ToFloat((uint32_t)uArgument);
-#ifndef QCBOR_DISABLE_FLOAT_HW_USE
-            /* In the normal case, use HW to convert float to
-             * double. */
-            pDecodedItem->val.dfnum = (double)f;
-            pDecodedItem->uDataType = QCBOR_TYPE_DOUBLE;
-#else /* QCBOR_DISABLE_FLOAT_HW_USE */
-            /* Use of float HW is disabled, return as a float. */
-            pDecodedItem->val.fnum = f;
-            pDecodedItem->uDataType = QCBOR_TYPE_FLOAT;
-
-            /* IEEE754_FloatToDouble() could be used here to return as
-             * a double, but it adds object code and most likely
-             * anyone disabling FLOAT HW use doesn't care about floats
-             * and wants to save object code.
-             */
-#endif /* QCBOR_DISABLE_FLOAT_HW_USE */
-         }
-#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
-         uReturn = FLOAT_ERR_CODE_NO_FLOAT(QCBOR_SUCCESS);
-         break;
-
-      case DOUBLE_PREC_FLOAT: /* 27 */
-#ifndef USEFULBUF_DISABLE_ALL_FLOAT
-         pDecodedItem->val.dfnum = UsefulBufUtil_CopyUint64ToDouble(uArgument);
-         pDecodedItem->uDataType = QCBOR_TYPE_DOUBLE;
-#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
-         uReturn = FLOAT_ERR_CODE_NO_FLOAT(QCBOR_SUCCESS);
-         break;
-
-      case CBOR_SIMPLEV_FALSE: /* 20 */
-      case CBOR_SIMPLEV_TRUE:  /* 21 */
-      case CBOR_SIMPLEV_NULL:  /* 22 */
-      case CBOR_SIMPLEV_UNDEF: /* 23 */
-      case CBOR_SIMPLE_BREAK:  /* 31 */
-         break; /* nothing to do */
-
-      case CBOR_SIMPLEV_ONEBYTE: /* 24 */
-         if(uArgument <= CBOR_SIMPLE_BREAK) {
-            /* This takes out f8 00 ... f8 1f which should be encoded
-             * as e0 … f7
-             */
-            uReturn = QCBOR_ERR_BAD_TYPE_7;
-            goto Done;
-         }
-         /* FALLTHROUGH */
-
-      default: /* 0-19 */
-         pDecodedItem->uDataType   = QCBOR_TYPE_UKNOWN_SIMPLE;
-         /* DecodeHead() will make uArgument equal to
-          * nAdditionalInfo when nAdditionalInfo is < 24. This cast is
-          * safe because the 2, 4 and 8 byte lengths of uNumber are in
-          * the double/float cases above
-          */
-         pDecodedItem->val.uSimple = (uint8_t)uArgument;
-         break;
-   }
-
-Done:
-   return uReturn;
-}
-
 
 /**
  * @brief Decode text and byte strings
@@ -953,6 +740,8 @@ Done:
  * @param[in] uStrLen        The length of the string.
  * @param[in] pUInBuf        The surce from which to read the string's bytes.
  * @param[out] pDecodedItem  The filled in decoded item.
+ * @param[out] puNotInInput  Where to put the number of bytes of the
+ *                           string not in the input or NULL.
  *
  * @retval QCBOR_ERR_HIT_END
  * @retval QCBOR_ERR_STRING_ALLOCATE
@@ -961,15 +750,29 @@ Done:
  * The reads @c uStrlen bytes from @c pUInBuf and fills in @c
  * pDecodedItem. If @c pAllocator is not NULL then memory for the
  * string is allocated.
+ *
+ * If @c puNotInInput is not NULL and the string runs past the end of
+ * the input, the part in the input is returned rather than an
+ * error. It is never allocated.
  */
 static inline QCBORError
 DecodeBytes(const QCBORInternalAllocator *pAllocator,
             uint64_t                      uStrLen,
             UsefulInputBuf               *pUInBuf,
-            QCBORItem                    *pDecodedItem)
+            QCBORItem                    *pDecodedItem,
+            uint64_t                     *puNotInInput)
 {
    QCBORError uReturn = QCBOR_SUCCESS;
 
+   if(puNotInInput != NULL) {
+      const size_t uInInput = UsefulInputBuf_BytesUnconsumed(pUInBuf);
+      if(uStrLen > uInInput) {
+         *puNotInInput = uStrLen - uInInput;
+         pDecodedItem->val.string = UsefulInputBuf_GetUsefulBuf(pUInBuf, uInInput);
+         goto Done;
+      }
+   }
+
    /* CBOR lengths can be 64 bits, but size_t is not 64 bits on all
     * CPUs.  This check makes the casts to size_t below safe.
     *
@@ -1040,34 +843,14 @@ static inline uint8_t ConvertStringMajorTypes(int nCBORMajorType)
 }
 
 
-/**
- * @brief Map the CBOR major types  for arrays/maps  to the QCBOR types.
- *
- * @param[in] nCBORMajorType  The CBOR major type to convert.
- * @retturns QCBOR type number.
- *
- * This only works for the two aggregate types.
- */
-static inline uint8_t ConvertArrayOrMapType(int nCBORMajorType)
-{
-   #if QCBOR_TYPE_ARRAY != CBOR_MAJOR_TYPE_ARRAY
-   #error QCBOR_TYPE_ARRAY value not lined up with major type
-   #endif
-
-   #if QCBOR_TYPE_MAP != CBOR_MAJOR_TYPE_MAP
-   #error QCBOR_TYPE_MAP value not lined up with major type
-   #endif
-
-   return (uint8_t)(nCBORMajorType);
-}
-
-
 /**
  * @brief Decode a single primitive data item (decode layer 6).
  *
  * @param[in] pUInBuf       Input buffer to read data item from.
  * @param[out] pDecodedItem  The filled-in decoded item.
  * @param[in] pAllocator    The allocator to use for strings or NULL.
+ * @param[out] puNotInInput  NULL or where to put the number of bytes
+ *                           of a byte string past the end of the input.
  *
  * @retval QCBOR_ERR_UNSUPPORTED
  * @retval QCBOR_ERR_HIT_END
@@ -1085,7 +868,8 @@ static inline uint8_t ConvertArrayOrMapType(int nCBORMajorType)
 static QCBORError
 DecodeAtomicDataItem(UsefulInputBuf               *pUInBuf,
                      QCBORItem                    *pDecodedItem,
-                     const QCBORInternalAllocator *pAllocator)
+                     const QCBORInternalAllocator *pAllocator,
+                     uint64_t                     *puNotInInput)
 {
    QCBORError uReturn;
 
@@ -1124,7 +908,12 @@ DecodeAtomicDataItem(UsefulInputBuf               *pUInBuf,
          if(nAdditionalInfo == LEN_IS_INDEFINITE) {
             pDecodedItem->val.string = (UsefulBufC){NULL, QCBOR_STRING_LENGTH_INDEFINITE};
          } else {
-            uReturn = DecodeBytes(pAllocator, uArgument, pUInBuf, pDecodedItem);
+            /* Only byte strings may run past the end of the input */
+            uReturn = DecodeBytes(pAllocator,
+                                  uArgument,
+                                  pUInBuf,
+                                  pDecodedItem,
+                                  nMajorType == CBOR_MAJOR_TYPE_BYTE_STRING ? puNotInInput : NULL);
          }
          break;
 
@@ -1245,7 +1034,10 @@ QCBORDecode_GetNextFullString(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
 #endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
 
    QCBORError uReturn;
-   uReturn = DecodeAtomicDataItem(&(pMe->InBuf), pDecodedItem, pAllocatorForGetNext);
+   uReturn = DecodeAtomicDataItem(&(pMe->InBuf),
+                                  pDecodedItem,
+                                  pAllocatorForGetNext,
+                                  pMe->bAllowPartialBytes ? &(pMe->uBytesNotInInput) : NULL);
    if(uReturn != QCBOR_SUCCESS) {
       goto Done;
    }
@@ -1279,7 +1071,7 @@ QCBORDecode_GetNextFullString(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
        * be allocated. They are always copied in the the contiguous
        * buffer allocated here.
        */
-      uReturn = DecodeAtomicDataItem(&(pMe->InBuf), &StringChunkItem, NULL);
+      uReturn = DecodeAtomicDataItem(&(pMe->InBuf), &StringChunkItem, NULL, NULL);
       if(uReturn) {
          break;
       }
@@ -1499,6 +1291,90 @@ Done:
 }
 
 
+/* FNV-1a hash of a label for the intern table */
+static uint32_t
+InternTable_Hash(UsefulBufC Label)
+{
+   const uint8_t *pByte = (const uint8_t *)Label.ptr;
+   const uint8_t *pEnd  = pByte + Label.len;
+   uint32_t       uHash = 2166136261U;
+
+   while(pByte < pEnd) {
+      uHash ^= *pByte++;
+      uHash *= 16777619U;
+   }
+
+   return uHash;
+}
+
+
+/*
+ * Look up a label in the intern table. Returns its index plus one or
+ * 0 if it is not in the table. The table has twice as many slots as
+ * labels so the probe sequence is short.
+ */
+static uint8_t
+InternTable_Find(const QCBORInternTable *pTable, UsefulBufC Label)
+{
+   const size_t   uNumSlots = sizeof(pTable->auSlots);
+   const char    *pLabel    = Label.ptr;
+   size_t         uSlot     = InternTable_Hash(Label) % uNumSlots;
+   size_t         uIndex;
+   uint8_t        uEntry;
+
+   while((uEntry = pTable->auSlots[uSlot]) != 0) {
+      /* Stops at the end of the candidate so it is never read past */
+      const char *szCandidate = pTable->pszLabels[uEntry - 1];
+      for(uIndex = 0; uIndex < Label.len; uIndex++) {
+         if(szCandidate[uIndex] == '\0' || szCandidate[uIndex] != pLabel[uIndex]) {
+            break;
+         }
+      }
+      if(uIndex == Label.len && szCandidate[uIndex] == '\0') {
+         return uEntry;
+      }
+      uSlot = (uSlot + 1) % uNumSlots;
+   }
+
+   return 0;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_decode.h file
+ */
+QCBORError
+QCBORInternTable_Init(QCBORInternTable   *pTable,
+                      const char *const  *pszLabels,
+                      size_t              uNumLabels)
+{
+   const size_t uNumSlots = sizeof(pTable->auSlots);
+   size_t       uIndex;
+   size_t       uSlot;
+
+   if(uNumLabels > QCBOR_MAX_INTERNED_LABELS) {
+      return QCBOR_ERR_ARRAY_TOO_LONG;
+   }
+
+   memset(pTable->auSlots, 0, uNumSlots);
+   pTable->pszLabels = pszLabels;
+
+   for(uIndex = 0; uIndex < uNumLabels; uIndex++) {
+      const UsefulBufC Label = UsefulBuf_FromSZ(pszLabels[uIndex]);
+      if(InternTable_Find(pTable, Label) != 0) {
+         return QCBOR_ERR_DUPLICATE_LABEL;
+      }
+      uSlot = InternTable_Hash(Label) % uNumSlots;
+      while(pTable->auSlots[uSlot] != 0) {
+         uSlot = (uSlot + 1) % uNumSlots;
+      }
+      pTable->auSlots[uSlot] = (uint8_t)(uIndex + 1);
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
 /**
  * @brief Combine a map entry label and value into one item (decode layer 3).
  *
@@ -1564,6 +1440,10 @@ QCBORDecode_GetNextMapEntry(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
             /* strings are always good labels */
             pDecodedItem->label.string = LabelItem.val.string;
             pDecodedItem->uLabelType = QCBOR_TYPE_TEXT_STRING;
+            if(pMe->pInternTable != NULL) {
+               pDecodedItem->uLabelId = InternTable_Find(pMe->pInternTable,
+                                                         LabelItem.val.string);
+            }
          } else if (QCBOR_DECODE_MODE_MAP_STRINGS_ONLY == pMe->uDecodeMode) {
             /* It's not a string and we only want strings */
             uReturn = QCBOR_ERR_MAP_LABEL_TYPE;
@@ -1629,7 +1509,7 @@ NextIsBreak(UsefulInputBuf *pUIB, bool *pbNextIsBreak)
    if(UsefulInputBuf_BytesUnconsumed(pUIB) != 0) {
       QCBORItem Peek;
       size_t uPeek = UsefulInputBuf_Tell(pUIB);
-      QCBORError uReturn = DecodeAtomicDataItem(pUIB, &Peek, NULL);
+      QCBORError uReturn = DecodeAtomicDataItem(pUIB, &Peek, NULL, NULL);
       if(uReturn != QCBOR_SUCCESS) {
          return uReturn;
       }
@@ -1715,6 +1595,11 @@ QCBORDecode_NestLevelAscender(QCBORDecodeContext *pMe, bool bMarkEnd)
        * QCBORDecode_ExitBoundedMode().
        */
       if(DecodeNesting_IsCurrentBounded(&(pMe->nesting))) {
+         /* The end is now known so exiting doesn't have to find it.
+          * The cast is OK because the input size is limited to
+          * QCBOR_MAX_DECODE_INPUT_SIZE. */
+         pMe->nesting.pCurrent->u.ma.uEndOffset = (uint32_t)UsefulInputBuf_Tell(&(pMe->InBuf));
+
          /* Set the count to zero for definite-length arrays to indicate
          * cursor is at end of bounded array/map */
          if(bMarkEnd) {
@@ -2293,49 +2178,497 @@ ProcessTaggedString(uint16_t uTag, QCBORItem *pDecodedItem)
 }
 
 
-/**
- * @brief Decode tag content for select tags (decoding layer 1).
- *
- * @param[in] pMe            The decode context.
- * @param[out] pDecodedItem  The decoded item.
- *
- * @return Decoding error code.
+/*
+ * Whether a string is valid UTF-8 per RFC 3629.
  *
- * CBOR tag numbers for the item were decoded in GetNext_TaggedItem(),
- * but the whole tag was not decoded. Here, the whole tags (tag number
- * and tag content) that are supported by QCBOR are decoded. This is a
- * quick pass through for items that are not tags.
+ * Bytes are taken eight at a time in a uint64_t while none of them
+ * have the high bit set, so runs of ASCII go quickly. Otherwise one
+ * character is checked against the table of valid byte sequences in
+ * RFC 3629 section 4. The second byte has a narrower range after
+ * some lead bytes to exclude overlong forms, surrogates and code
+ * points above U+10FFFF.
  */
-static QCBORError
-QCBORDecode_GetNextTagContent(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
-{
-   QCBORError uReturn;
+static bool
+UTF8_IsValid(UsefulBufC String)
+{
+   const uint8_t *pCur = String.ptr;
+   const uint8_t *pEnd = pCur + String.len;
+   uint64_t       uWord;
+   size_t         uNumTrailing;
+   size_t         uIndex;
+   uint8_t        uSecondMin;
+   uint8_t        uSecondMax;
+
+   while(pCur < pEnd) {
+      while(pEnd - pCur >= (ptrdiff_t)sizeof(uint64_t)) {
+         memcpy(&uWord, pCur, sizeof(uint64_t));
+         if(uWord & 0x8080808080808080ULL) {
+            break;
+         }
+         pCur += sizeof(uint64_t);
+      }
+      if(pCur == pEnd) {
+         break;
+      }
 
-   uReturn = QCBORDecode_GetNextMapOrArray(pMe, pDecodedItem);
-   if(uReturn != QCBOR_SUCCESS) {
-      goto Done;
+      const uint8_t uLead = *pCur;
+      if(uLead < 0x80) {
+         pCur++;
+         continue;
+      }
+
+      uSecondMin = 0x80;
+      uSecondMax = 0xbf;
+      if(uLead >= 0xc2 && uLead <= 0xdf) {
+         uNumTrailing = 1;
+      } else if(uLead >= 0xe0 && uLead <= 0xef) {
+         uNumTrailing = 2;
+         if(uLead == 0xe0) {
+            uSecondMin = 0xa0;
+         } else if(uLead == 0xed) {
+            uSecondMax = 0x9f;
+         }
+      } else if(uLead >= 0xf0 && uLead <= 0xf4) {
+         uNumTrailing = 3;
+         if(uLead == 0xf0) {
+            uSecondMin = 0x90;
+         } else if(uLead == 0xf4) {
+            uSecondMax = 0x8f;
+         }
+      } else {
+         return false;
+      }
+
+      if((size_t)(pEnd - pCur) <= uNumTrailing) {
+         return false;
+      }
+      if(pCur[1] < uSecondMin || pCur[1] > uSecondMax) {
+         return false;
+      }
+      for(uIndex = 2; uIndex <= uNumTrailing; uIndex++) {
+         if((pCur[uIndex] & 0xc0) != 0x80) {
+            return false;
+         }
+      }
+      pCur += uNumTrailing + 1;
    }
 
-   /* When there are no tag numbers for the item, this exits first
-    * thing and effectively does nothing.
-    *
-    * This loops over all the tag numbers accumulated for this item
-    * trying to decode and interpret them. This stops at the end of
-    * the list or at the first tag number that can't be interpreted by
-    * this code. This is effectively a recursive processing of the
-    * tags number list that handles nested tags.
-    */
-   while(1) {
-      /* Don't bother to unmap tags via QCBORITem.uTags since this
-       * code only works on tags less than QCBOR_LAST_UNMAPPED_TAG.
-       */
-      const uint16_t uTagToProcess = pDecodedItem->uTags[0];
+   return true;
+}
 
-      if(uTagToProcess == CBOR_TAG_INVALID16) {
-         /* Hit the end of the tag list. A successful exit. */
-         break;
 
-      } else if(uTagToProcess == CBOR_TAG_DATE_EPOCH) {
+/*
+ * Public function, see header qcbor/qcbor_decode.h file
+ */
+void
+QCBORDecode_SetInternTable(QCBORDecodeContext *pMe, const QCBORInternTable *pTable)
+{
+   pMe->pInternTable = pTable;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_decode.h file
+ */
+void
+QCBORDecode_SetUTF8Validation(QCBORDecodeContext *pMe, bool bValidate)
+{
+   pMe->bValidateUTF8 = bValidate;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_decode.h file
+ */
+void
+QCBORDecode_SetDuplicateDetection(QCBORDecodeContext *pMe,
+                                  QCBORLabelSlot     *pSlots,
+                                  size_t              uNumSlots)
+{
+   pMe->pLabelSlots    = pSlots;
+   pMe->uNumLabelSlots = pSlots != NULL ? uNumSlots : 0;
+}
+
+
+/* The type of the label in a slot without the indefinite-length
+ * modifier */
+static inline uint8_t
+LabelSlot_Type(const QCBORLabelSlot *pSlot)
+{
+   return (uint8_t)(pSlot->uLabelType & ~QCBOR_INDEFINITE_LEN_TYPE_MODIFIER);
+}
+
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+/*
+ * An indefinite-length string label is in a slot as the span of its
+ * chunks, heads and all. This gets the bytes of a string label in
+ * order whether it is in chunks or not. The chunks were checked when
+ * the label was put in the slot.
+ */
+typedef struct {
+   UsefulInputBuf Chunks;
+   UsefulBufC     Chunk;
+} LabelSlotReader;
+
+
+static void
+LabelSlot_ReaderInit(LabelSlotReader *pReader, const QCBORLabelSlot *pSlot)
+{
+   if(pSlot->uLabelType & QCBOR_INDEFINITE_LEN_TYPE_MODIFIER) {
+      UsefulInputBuf_Init(&(pReader->Chunks), pSlot->label.string);
+      pReader->Chunk = NULLUsefulBufC;
+   } else {
+      UsefulInputBuf_Init(&(pReader->Chunks), NULLUsefulBufC);
+      pReader->Chunk = pSlot->label.string;
+   }
+}
+
+
+/* Returns false at the end of the label */
+static bool
+LabelSlot_ReaderGetByte(LabelSlotReader *pReader, uint8_t *puByte)
+{
+   int      nMajorType;
+   int      nAdditionalInfo;
+   uint64_t uArgument;
+
+   while(pReader->Chunk.len == 0) {
+      if(UsefulInputBuf_BytesUnconsumed(&(pReader->Chunks)) == 0) {
+         return false;
+      }
+      if(DecodeHead(&(pReader->Chunks), &nMajorType, &uArgument, &nAdditionalInfo) != QCBOR_SUCCESS) {
+         return false;
+      }
+      pReader->Chunk = UsefulInputBuf_GetUsefulBuf(&(pReader->Chunks), (size_t)uArgument);
+   }
+
+   *puByte        = *(const uint8_t *)pReader->Chunk.ptr;
+   pReader->Chunk = UsefulBuf_Tail(pReader->Chunk, 1);
+   return true;
+}
+
+
+/*
+ * Checks the chunks of an indefinite-length string label and puts
+ * their span in the slot. Positioned after the break on return.
+ */
+static bool
+LabelSlot_DecodeChunks(UsefulInputBuf *pInBuf,
+                       int             nStringMajorType,
+                       QCBORLabelSlot *pSlot)
+{
+   int      nMajorType;
+   int      nAdditionalInfo;
+   uint64_t uArgument;
+   size_t   uEnd;
+
+   const size_t uStart = UsefulInputBuf_Tell(pInBuf);
+
+   for(;;) {
+      uEnd = UsefulInputBuf_Tell(pInBuf);
+      if(DecodeHead(pInBuf, &nMajorType, &uArgument, &nAdditionalInfo) != QCBOR_SUCCESS) {
+         return false;
+      }
+      if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == LEN_IS_INDEFINITE) {
+         break;
+      }
+      if(nMajorType != nStringMajorType ||
+         nAdditionalInfo == LEN_IS_INDEFINITE ||
+         uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+         return false;
+      }
+      UsefulInputBuf_Seek(pInBuf, UsefulInputBuf_Tell(pInBuf) + (size_t)uArgument);
+   }
+
+   UsefulInputBuf_Seek(pInBuf, uStart);
+   pSlot->label.string = UsefulInputBuf_GetUsefulBuf(pInBuf, uEnd - uStart);
+   pSlot->uLabelType  |= QCBOR_INDEFINITE_LEN_TYPE_MODIFIER;
+   UsefulInputBuf_Seek(pInBuf, uEnd + 1);
+
+   return true;
+}
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+
+/*
+ * Decodes the label of a map member into a slot the way
+ * QCBORDecode_GetNextMapEntry() does, but from the heads only.
+ * Returns false for a break and for anything that isn't a good
+ * label. The error for that is returned when the member is gotten.
+ */
+static bool
+LabelSlot_Decode(UsefulInputBuf *pInBuf, uint8_t uDecodeMode, QCBORLabelSlot *pSlot)
+{
+   int      nMajorType;
+   int      nAdditionalInfo;
+   uint64_t uArgument;
+
+   /* Tags on labels are ignored */
+   do {
+      if(DecodeHead(pInBuf, &nMajorType, &uArgument, &nAdditionalInfo) != QCBOR_SUCCESS) {
+         return false;
+      }
+   } while(nMajorType == CBOR_MAJOR_TYPE_TAG);
+
+   if(nMajorType == CBOR_MAJOR_TYPE_BYTE_STRING ||
+      nMajorType == CBOR_MAJOR_TYPE_TEXT_STRING) {
+      pSlot->uLabelType = nMajorType == CBOR_MAJOR_TYPE_BYTE_STRING ?
+                             QCBOR_TYPE_BYTE_STRING : QCBOR_TYPE_TEXT_STRING;
+      if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+         return LabelSlot_DecodeChunks(pInBuf, nMajorType, pSlot);
+#else /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+         return false;
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+      }
+      if(uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+         return false;
+      }
+      pSlot->label.string = UsefulInputBuf_GetUsefulBuf(pInBuf, (size_t)uArgument);
+      return true;
+   }
+
+   if(uDecodeMode == QCBOR_DECODE_MODE_MAP_STRINGS_ONLY ||
+      nAdditionalInfo == LEN_IS_INDEFINITE) {
+      return false;
+   }
+
+   if(nMajorType == CBOR_MAJOR_TYPE_POSITIVE_INT) {
+      pSlot->uLabelType   = uArgument > INT64_MAX ? QCBOR_TYPE_UINT64 : QCBOR_TYPE_INT64;
+      pSlot->label.uint64 = uArgument;
+      return true;
+   }
+   if(nMajorType == CBOR_MAJOR_TYPE_NEGATIVE_INT && uArgument <= INT64_MAX) {
+      pSlot->uLabelType  = QCBOR_TYPE_INT64;
+      pSlot->label.int64 = -1 - (int64_t)uArgument;
+      return true;
+   }
+
+   return false;
+}
+
+
+/* Hash of a label for duplicate detection */
+static uint32_t
+LabelSlot_Hash(const QCBORLabelSlot *pSlot)
+{
+   const uint8_t uType = LabelSlot_Type(pSlot);
+
+   if(uType == QCBOR_TYPE_TEXT_STRING || uType == QCBOR_TYPE_BYTE_STRING) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+      if(pSlot->uLabelType & QCBOR_INDEFINITE_LEN_TYPE_MODIFIER) {
+         /* The same as InternTable_Hash() so chunks don't matter */
+         LabelSlotReader Reader;
+         uint8_t         uByte;
+         uint32_t        uHash = 2166136261U;
+
+         LabelSlot_ReaderInit(&Reader, pSlot);
+         while(LabelSlot_ReaderGetByte(&Reader, &uByte)) {
+            uHash ^= uByte;
+            uHash *= 16777619U;
+         }
+         return uHash ^ uType;
+      }
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+      return InternTable_Hash(pSlot->label.string) ^ uType;
+   }
+
+   /* int64 and uint64 are the same bits. The multiply spreads small
+    * integers, the usual labels, over the high bits. */
+   const uint64_t uHash = pSlot->label.uint64 * 0x9E3779B97F4A7C15ULL;
+   return (uint32_t)(uHash >> 32);
+}
+
+
+/* Whether two slots have the same label */
+static bool
+LabelSlot_Matches(const QCBORLabelSlot *pSlot1, const QCBORLabelSlot *pSlot2)
+{
+   const uint8_t uType = LabelSlot_Type(pSlot1);
+
+   if(uType != LabelSlot_Type(pSlot2)) {
+      return false;
+   }
+   if(uType == QCBOR_TYPE_TEXT_STRING || uType == QCBOR_TYPE_BYTE_STRING) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+      if((pSlot1->uLabelType | pSlot2->uLabelType) & QCBOR_INDEFINITE_LEN_TYPE_MODIFIER) {
+         LabelSlotReader Reader1;
+         LabelSlotReader Reader2;
+         uint8_t         uByte1;
+         uint8_t         uByte2;
+         bool            bMore;
+
+         LabelSlot_ReaderInit(&Reader1, pSlot1);
+         LabelSlot_ReaderInit(&Reader2, pSlot2);
+         do {
+            bMore = LabelSlot_ReaderGetByte(&Reader1, &uByte1);
+            if(bMore != LabelSlot_ReaderGetByte(&Reader2, &uByte2) ||
+               (bMore && uByte1 != uByte2)) {
+               return false;
+            }
+         } while(bMore);
+         return true;
+      }
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+      return UsefulBuf_Compare(pSlot1->label.string, pSlot2->label.string) == 0;
+   }
+   return pSlot1->label.uint64 == pSlot2->label.uint64;
+}
+
+
+/**
+ * @brief Check a map for duplicate labels.
+ *
+ * @param[in] pMe       The decoder context.
+ * @param[in] pMapItem  The map head just decoded.
+ *
+ * @retval QCBOR_ERR_DUPLICATE_LABEL
+ * @retval QCBOR_ERR_LABEL_SLOTS_SIZE
+ *
+ * This looks ahead over the members of the map in a copy of the input
+ * buffer, putting the label of each in an open addressing hash table
+ * in the slots. The table has at least twice as many slots as labels
+ * so probe sequences are short. Like QCBORView, only heads are
+ * decoded, values are skipped with QCBORDecode_Private_SkipItem()
+ * and string labels point into the input, so nothing is allocated
+ * even with a string allocator. The maps nested in this one are not
+ * checked until they are gotten.
+ *
+ * Errors decoding the members are not returned here. The check stops
+ * at the first one and it is returned when the member is gotten.
+ */
+static QCBORError
+CheckMapLabels(QCBORDecodeContext *pMe, const QCBORItem *pMapItem)
+{
+   QCBORError      uErr;
+   UsefulInputBuf  InBuf;
+   QCBORLabelSlot  Label;
+   size_t          uNumSlots;
+   size_t          uMaxLabels;
+   size_t          uNumLabels;
+   size_t          uSlot;
+   bool            bIndefinite;
+   QCBORLabelSlot *pSlots = pMe->pLabelSlots;
+
+   if(pMapItem->uNextNestLevel <= pMapItem->uNestingLevel) {
+      /* Empty map */
+      return QCBOR_SUCCESS;
+   }
+
+   uMaxLabels  = pMe->uNumLabelSlots / 2;
+   bIndefinite = pMapItem->val.uCount == QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH;
+   if(!bIndefinite) {
+      if(pMapItem->val.uCount > uMaxLabels) {
+         return QCBOR_ERR_LABEL_SLOTS_SIZE;
+      }
+      uMaxLabels = pMapItem->val.uCount;
+   }
+   uNumSlots = uMaxLabels * 2;
+   memset(pSlots, 0, uNumSlots * sizeof(QCBORLabelSlot));
+
+   /* Positioned after the map head */
+   InBuf = pMe->InBuf;
+
+   uErr = QCBOR_SUCCESS;
+   for(uNumLabels = 0; bIndefinite || uNumLabels < uMaxLabels; uNumLabels++) {
+      if(!LabelSlot_Decode(&InBuf, pMe->uDecodeMode, &Label)) {
+         break;
+      }
+
+      if(uNumLabels >= uMaxLabels) {
+         /* Only for indefinite-length maps */
+         uErr = QCBOR_ERR_LABEL_SLOTS_SIZE;
+         break;
+      }
+
+      uSlot = LabelSlot_Hash(&Label) % uNumSlots;
+      while(pSlots[uSlot].uLabelType != QCBOR_TYPE_NONE) {
+         if(LabelSlot_Matches(&pSlots[uSlot], &Label)) {
+            uErr = QCBOR_ERR_DUPLICATE_LABEL;
+            goto Done;
+         }
+         uSlot = (uSlot + 1) % uNumSlots;
+      }
+      pSlots[uSlot] = Label;
+
+      if(QCBORDecode_Private_SkipItem(&InBuf) != QCBOR_SUCCESS) {
+         break;
+      }
+   }
+
+Done:
+   return uErr;
+}
+
+
+/**
+ * @brief Decode tag content for select tags (decoding layer 1).
+ *
+ * @param[in] pMe            The decode context.
+ * @param[out] pDecodedItem  The decoded item.
+ *
+ * @return Decoding error code.
+ *
+ * CBOR tag numbers for the item were decoded in GetNext_TaggedItem(),
+ * but the whole tag was not decoded. Here, the whole tags (tag number
+ * and tag content) that are supported by QCBOR are decoded. This is a
+ * quick pass through for items that are not tags.
+ */
+static QCBORError
+QCBORDecode_GetNextTagContent(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
+{
+   QCBORError uReturn;
+
+   uReturn = QCBORDecode_GetNextMapOrArray(pMe, pDecodedItem);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   /* This is before the tags are processed so all text strings are
+    * still QCBOR_TYPE_TEXT_STRING. The item has been consumed so this
+    * error is recoverable. When the label of an array or map is bad,
+    * its contents are skipped so it is all consumed. */
+   if(pMe->bValidateUTF8) {
+      if((pDecodedItem->uDataType == QCBOR_TYPE_TEXT_STRING &&
+          !UTF8_IsValid(pDecodedItem->val.string)) ||
+         (pDecodedItem->uLabelType == QCBOR_TYPE_TEXT_STRING &&
+          !UTF8_IsValid(pDecodedItem->label.string))) {
+         uReturn = QCBORDecode_Private_SkipContents(pMe, pDecodedItem);
+         if(uReturn == QCBOR_SUCCESS) {
+            uReturn = QCBOR_ERR_BAD_UTF8;
+         }
+         goto Done;
+      }
+   }
+
+   if(pMe->pLabelSlots != NULL && pDecodedItem->uDataType == QCBOR_TYPE_MAP) {
+      uReturn = CheckMapLabels(pMe, pDecodedItem);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+
+   /* When there are no tag numbers for the item, this exits first
+    * thing and effectively does nothing.
+    *
+    * This loops over all the tag numbers accumulated for this item
+    * trying to decode and interpret them. This stops at the end of
+    * the list or at the first tag number that can't be interpreted by
+    * this code. This is effectively a recursive processing of the
+    * tags number list that handles nested tags.
+    */
+   while(1) {
+      /* Don't bother to unmap tags via QCBORITem.uTags since this
+       * code only works on tags less than QCBOR_LAST_UNMAPPED_TAG.
+       */
+      const uint16_t uTagToProcess = pDecodedItem->uTags[0];
+
+      if(uTagToProcess == CBOR_TAG_INVALID16) {
+         /* Hit the end of the tag list. A successful exit. */
+         break;
+
+      } else if(uTagToProcess == CBOR_TAG_DATE_EPOCH) {
          uReturn = DecodeDateEpoch(pDecodedItem);
 
       } else if(uTagToProcess == CBOR_TAG_DAYS_EPOCH) {
@@ -2382,6 +2715,41 @@ Done:
 }
 
 
+/*
+ * Public function, see header qcbor/qcbor_decode.h file
+ */
+void
+QCBORDecode_SetPeekCache(QCBORDecodeContext *pMe, QCBORPeekCache *pCache)
+{
+   pMe->pPeekCache = pCache;
+   if(pCache != NULL) {
+      pCache->bValid = false;
+   }
+}
+
+
+/*
+ * Whether the decoder is where it was when the item in the peek cache
+ * was peeked at. Decoding depends only on the input position and the
+ * nesting, and only on the current level of the nesting. Being at the
+ * same position in the same level means being in the same array or
+ * map, so this is enough without comparing all the nesting.
+ */
+static bool
+PeekCache_IsHit(QCBORDecodeContext *pMe)
+{
+   const QCBORPeekCache *pCache = pMe->pPeekCache;
+
+   return pCache != NULL &&
+          pCache->bValid &&
+          pCache->uCursorBefore  == UsefulInputBuf_Tell(&(pMe->InBuf)) &&
+          pCache->uInputLen      == UsefulInputBuf_GetBufferLength(&(pMe->InBuf)) &&
+          pCache->pCurrentBefore == pMe->nesting.pCurrent &&
+          pCache->pBoundedBefore == pMe->nesting.pCurrentBounded &&
+          memcmp(pCache->auLevelBefore, pMe->nesting.pCurrent, sizeof(pCache->auLevelBefore)) == 0;
+}
+
+
 /*
  * Public function, see header qcbor/qcbor_decode.h file
  */
@@ -2389,10 +2757,28 @@ QCBORError
 QCBORDecode_GetNext(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
 {
    QCBORError uErr;
+
+   if(PeekCache_IsHit(pMe)) {
+      /* Commit the peeked item */
+      *pDecodedItem = pMe->pPeekCache->Item;
+      pMe->nesting  = pMe->pPeekCache->NestingAfter;
+      UsefulInputBuf_Seek(&(pMe->InBuf), pMe->pPeekCache->uCursorAfter);
+      pMe->pPeekCache->bValid = false;
+      return QCBOR_SUCCESS;
+   }
+
    uErr = QCBORDecode_GetNextTagContent(pMe, pDecodedItem);
    if(uErr != QCBOR_SUCCESS) {
       pDecodedItem->uDataType  = QCBOR_TYPE_NONE;
       pDecodedItem->uLabelType = QCBOR_TYPE_NONE;
+
+      if(QCBORDecode_IsUnrecoverableError(uErr) &&
+         pMe->nesting.pCurrentBounded != NULL &&
+         pMe->nesting.pCurrentBounded->uLevelType != QCBOR_TYPE_BYTE_STRING) {
+         /* An end found by traversing to it isn't trusted if the
+          * traversal failed. Exiting searches for it instead. */
+         pMe->nesting.pCurrentBounded->u.ma.uEndOffset = QCBOR_MAP_OFFSET_CACHE_INVALID;
+      }
    }
    return uErr;
 }
@@ -2404,11 +2790,34 @@ QCBORDecode_GetNext(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
 QCBORError
 QCBORDecode_PeekNext(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
 {
+   QCBORPeekCache *pCache = pMe->pPeekCache;
+
+   if(PeekCache_IsHit(pMe)) {
+      *pDecodedItem = pCache->Item;
+      return QCBOR_SUCCESS;
+   }
+
+   if(pCache != NULL) {
+      pCache->bValid         = false;
+      pCache->uCursorBefore  = UsefulInputBuf_Tell(&(pMe->InBuf));
+      pCache->uInputLen      = UsefulInputBuf_GetBufferLength(&(pMe->InBuf));
+      pCache->pCurrentBefore = pMe->nesting.pCurrent;
+      pCache->pBoundedBefore = pMe->nesting.pCurrentBounded;
+      memcpy(pCache->auLevelBefore, pMe->nesting.pCurrent, sizeof(pCache->auLevelBefore));
+   }
+
    const QCBORDecodeNesting SaveNesting = pMe->nesting;
    const UsefulInputBuf Save = pMe->InBuf;
 
    QCBORError uErr = QCBORDecode_GetNext(pMe, pDecodedItem);
 
+   if(pCache != NULL && uErr == QCBOR_SUCCESS) {
+      pCache->Item         = *pDecodedItem;
+      pCache->NestingAfter = pMe->nesting;
+      pCache->uCursorAfter = UsefulInputBuf_Tell(&(pMe->InBuf));
+      pCache->bValid       = true;
+   }
+
    pMe->nesting = SaveNesting;
    pMe->InBuf = Save;
 
@@ -2446,25 +2855,115 @@ void QCBORDecode_VGetNext(QCBORDecodeContext *pMe, QCBORItem *pDecodedItem)
 /*
  * Public function, see header qcbor/qcbor_decode.h file
  */
-QCBORError
-QCBORDecode_GetNextWithTags(QCBORDecodeContext *pMe,
-                            QCBORItem          *pDecodedItem,
-                            QCBORTagListOut    *pTags)
+void
+QCBORDecode_GetByteStringHead(QCBORDecodeContext *pMe,
+                              QCBORItem          *pDecodedItem,
+                              uint64_t           *puNotInInput)
 {
-   QCBORError uReturn;
+   QCBORError uErr;
 
-   uReturn = QCBORDecode_GetNext(pMe, pDecodedItem);
-   if(uReturn != QCBOR_SUCCESS) {
-      return uReturn;
+   *puNotInInput = 0;
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      pDecodedItem->uDataType  = QCBOR_TYPE_NONE;
+      pDecodedItem->uLabelType = QCBOR_TYPE_NONE;
+      return;
    }
 
-   if(pTags != NULL) {
-      pTags->uNumUsed = 0;
-      /* Reverse the order because pTags is reverse of QCBORItem.uTags. */
-      for(int nTagIndex = QCBOR_MAX_TAGS_PER_ITEM-1; nTagIndex >=0; nTagIndex--) {
-         if(pDecodedItem->uTags[nTagIndex] == CBOR_TAG_INVALID16) {
-            continue;
-         }
+   /* A peeked item was decoded without allowing it to be partial */
+   if(pMe->pPeekCache != NULL) {
+      pMe->pPeekCache->bValid = false;
+   }
+
+   pMe->uBytesNotInInput   = 0;
+   pMe->bAllowPartialBytes = true;
+   uErr = QCBORDecode_GetNext(pMe, pDecodedItem);
+   pMe->bAllowPartialBytes = false;
+   if(uErr != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   if(pDecodedItem->uDataType != QCBOR_TYPE_BYTE_STRING) {
+      uErr = QCBOR_ERR_UNEXPECTED_TYPE;
+      goto Done;
+   }
+
+   *puNotInInput = pMe->uBytesNotInInput;
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_decode.h file
+ */
+void
+QCBORDecode_ContinueInput(QCBORDecodeContext *pMe, UsefulBufC NextInput)
+{
+   QCBORError uErr = QCBOR_SUCCESS;
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      return;
+   }
+
+   if(UsefulInputBuf_BytesUnconsumed(&(pMe->InBuf)) != 0 ||
+      (pMe->nesting.pCurrentBounded != NULL &&
+       pMe->nesting.pCurrentBounded != &(pMe->nesting.pLevels[0]))) {
+      uErr = QCBOR_ERR_CANNOT_CONTINUE_INPUT;
+      goto Done;
+   }
+
+   UsefulInputBuf_Init(&(pMe->InBuf), NextInput);
+
+   /* Anything remembered by offset is for the old input */
+   if(pMe->pBstrEnterCache != NULL) {
+      pMe->pBstrEnterCache->uLabelType = QCBOR_TYPE_NONE;
+   }
+   if(pMe->pPeekCache != NULL) {
+      pMe->pPeekCache->bValid = false;
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   /* The check for the break that ends an indefinite-length array or
+    * map found the end of the old input instead. Now that there is
+    * more input, check again. Nothing else needs to be redone because
+    * this is the only place ascending stops at the end of the input.
+    */
+   if(!DecodeNesting_IsCurrentAtTop(&(pMe->nesting)) &&
+      !DecodeNesting_IsCurrentBstrWrapped(&(pMe->nesting)) &&
+      !DecodeNesting_IsCurrentDefiniteLength(&(pMe->nesting))) {
+      uErr = QCBORDecode_NestLevelAscender(pMe, true);
+   }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_decode.h file
+ */
+QCBORError
+QCBORDecode_GetNextWithTags(QCBORDecodeContext *pMe,
+                            QCBORItem          *pDecodedItem,
+                            QCBORTagListOut    *pTags)
+{
+   QCBORError uReturn;
+
+   uReturn = QCBORDecode_GetNext(pMe, pDecodedItem);
+   if(uReturn != QCBOR_SUCCESS) {
+      return uReturn;
+   }
+
+   if(pTags != NULL) {
+      pTags->uNumUsed = 0;
+      /* Reverse the order because pTags is reverse of QCBORItem.uTags. */
+      for(int nTagIndex = QCBOR_MAX_TAGS_PER_ITEM-1; nTagIndex >=0; nTagIndex--) {
+         if(pDecodedItem->uTags[nTagIndex] == CBOR_TAG_INVALID16) {
+            continue;
+         }
          if(pTags->uNumUsed >= pTags->uNumAllocated) {
             return QCBOR_ERR_TOO_MANY_TAGS;
          }
@@ -2977,6 +3476,7 @@ MapSearch(QCBORDecodeContext *pMe,
 {
    QCBORError uReturn;
    uint64_t   uFoundItemBitMap = 0;
+   size_t     uEndOffset       = 0;
 
    if(pMe->uLastError != QCBOR_SUCCESS) {
       uReturn = pMe->uLastError;
@@ -2993,15 +3493,10 @@ MapSearch(QCBORDecodeContext *pMe,
 
    if(DecodeNesting_IsBoundedEmpty(&(pMe->nesting))) {
       // It is an empty bounded array or map
-      if(pItemArray->uLabelType == QCBOR_TYPE_NONE) {
-         // Just trying to find the end of the map or array
-         pMe->uMapEndOffsetCache = DecodeNesting_GetMapOrArrayStart(&(pMe->nesting));
-         uReturn = QCBOR_SUCCESS;
-      } else {
-         // Nothing is ever found in an empty array or map. All items
-         // are marked as not found below.
-         uReturn = QCBOR_SUCCESS;
-      }
+      // Nothing is ever found in an empty array or map. All items
+      // are marked as not found below. The end was recorded when it
+      // was entered.
+      uReturn = QCBOR_SUCCESS;
       goto Done2;
    }
 
@@ -3108,7 +3603,7 @@ MapSearch(QCBORDecodeContext *pMe,
 
    uReturn = QCBOR_SUCCESS;
 
-   const size_t uEndOffset = UsefulInputBuf_Tell(&(pMe->InBuf));
+   uEndOffset = UsefulInputBuf_Tell(&(pMe->InBuf));
 
    // Check here makes sure that this won't accidentally be
    // QCBOR_MAP_OFFSET_CACHE_INVALID which is larger than
@@ -3118,12 +3613,17 @@ MapSearch(QCBORDecodeContext *pMe,
       uReturn = QCBOR_ERR_INPUT_TOO_LARGE;
       goto Done;
    }
-   /* Cast OK because encoded CBOR is limited to UINT32_MAX */
-   pMe->uMapEndOffsetCache = (uint32_t)uEndOffset;
 
  Done:
    DecodeNesting_RestoreFromMapSearch(&(pMe->nesting), &SaveNesting);
 
+   if(uReturn == QCBOR_SUCCESS) {
+      /* Record the end of the map or array in its level so exiting
+       * it doesn't have to search for it. Cast OK because encoded
+       * CBOR is limited to UINT32_MAX. */
+      pMe->nesting.pCurrentBounded->u.ma.uEndOffset = (uint32_t)uEndOffset;
+   }
+
  Done2:
    /* For all items not found, set the data and label type to QCBOR_TYPE_NONE */
    for(int i = 0; pItemArray[i].uLabelType != 0; i++) {
@@ -3505,8 +4005,6 @@ void QCBORDecode_EnterBoundedMapOrArray(QCBORDecodeContext *pMe, uint8_t uType,
       DecodeNesting_Descend(&(pMe->nesting), uType);
    }
 
-   pMe->uMapEndOffsetCache = QCBOR_MAP_OFFSET_CACHE_INVALID;
-
    uErr = DecodeNesting_EnterBoundedMapOrArray(&(pMe->nesting), bIsEmpty,
                                                UsefulInputBuf_Tell(&(pMe->InBuf)));
 
@@ -3568,8 +4066,6 @@ ExitBoundedLevel(QCBORDecodeContext *pMe, uint32_t uEndOffset)
     */
    DecodeNesting_LevelUpBounded(&(pMe->nesting));
 
-   pMe->uMapEndOffsetCache = QCBOR_MAP_OFFSET_CACHE_INVALID;
-
 Done:
    return uErr;
 }
@@ -3592,10 +4088,11 @@ void QCBORDecode_ExitBoundedMapOrArray(QCBORDecodeContext *pMe, uint8_t uType)
 
    /*
     Have to set the offset to the end of the map/array
-    that is being exited. If there is no cached value,
-    from previous map search, then do a dummy search.
+    that is being exited. If it isn't recorded in the level
+    from a previous map search or traversal to the end, then
+    do a dummy search.
     */
-   if(pMe->uMapEndOffsetCache == QCBOR_MAP_OFFSET_CACHE_INVALID) {
+   if(pMe->nesting.pCurrentBounded->u.ma.uEndOffset == QCBOR_MAP_OFFSET_CACHE_INVALID) {
       QCBORItem Dummy;
       Dummy.uLabelType = QCBOR_TYPE_NONE;
       uErr = MapSearch(pMe, &Dummy, NULL, NULL, NULL);
@@ -3604,7 +4101,7 @@ void QCBORDecode_ExitBoundedMapOrArray(QCBORDecodeContext *pMe, uint8_t uType)
       }
    }
 
-   uErr = ExitBoundedLevel(pMe, pMe->uMapEndOffsetCache);
+   uErr = ExitBoundedLevel(pMe, pMe->nesting.pCurrentBounded->u.ma.uEndOffset);
 
 Done:
    pMe->uLastError = (uint8_t)uErr;
@@ -3612,34 +4109,17 @@ Done:
 
 
 
-static QCBORError InternalEnterBstrWrapped(QCBORDecodeContext *pMe,
-                                           const QCBORItem    *pItem,
-                                           uint8_t             uTagRequirement,
-                                           UsefulBufC         *pBstr)
+/* Narrows the input to the bstr-wrapped CBOR at the given offset and
+ * length and descends into it. This is the common part of entering
+ * from a decoded byte string item and from a saved position.
+ */
+static QCBORError
+EnterBstrWrappedAtOffset(QCBORDecodeContext *pMe,
+                         const size_t        uStartOfBstr,
+                         const size_t        uLenOfBstr)
 {
-   if(pBstr) {
-      *pBstr = NULLUsefulBufC;
-   }
-
-   if(pMe->uLastError != QCBOR_SUCCESS) {
-      /* Already in error state; do nothing. */
-      return pMe->uLastError;
-   }
-
    QCBORError uError;
 
-   const TagSpecification TagSpec =
-      {
-         uTagRequirement,
-         {QBCOR_TYPE_WRAPPED_CBOR, QBCOR_TYPE_WRAPPED_CBOR_SEQUENCE, QCBOR_TYPE_NONE},
-         {QCBOR_TYPE_BYTE_STRING, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE}
-      };
-
-   uError = CheckTagRequirement(TagSpec, pItem);
-   if(uError != QCBOR_SUCCESS) {
-      goto Done;
-   }
-
    if(DecodeNesting_IsCurrentDefiniteLength(&(pMe->nesting))) {
       /* Reverse the decrement done by GetNext() for the bstr so the
        * increment in QCBORDecode_NestLevelAscender() called by
@@ -3648,10 +4128,6 @@ static QCBORError InternalEnterBstrWrapped(QCBORDecodeContext *pMe,
       DecodeNesting_ReverseDecrement(&(pMe->nesting));
    }
 
-   if(pBstr) {
-      *pBstr = pItem->val.string;
-   }
-
    /* This saves the current length of the UsefulInputBuf and then
     * narrows the UsefulInputBuf to start and length of the wrapped
     * CBOR that is being entered.
@@ -3667,18 +4143,17 @@ static QCBORError InternalEnterBstrWrapped(QCBORDecodeContext *pMe,
       goto Done;
    }
 
-   const size_t uStartOfBstr = UsefulInputBuf_PointerToOffset(&(pMe->InBuf),
-                                                              pItem->val.string.ptr);
    /* This check makes the cast of uStartOfBstr to uint32_t below safe. */
    if(uStartOfBstr == SIZE_MAX || uStartOfBstr > QCBOR_MAX_DECODE_INPUT_SIZE) {
-      /* This should never happen because pItem->val.string.ptr should
-       * always be valid since it was just returned.
+      /* This should never happen because the offset should always
+       * come from an item that was just decoded or a checked saved
+       * position.
        */
       uError = QCBOR_ERR_INPUT_TOO_LARGE;
       goto Done;
    }
 
-   const size_t uEndOfBstr = uStartOfBstr + pItem->val.string.len;
+   const size_t uEndOfBstr = uStartOfBstr + uLenOfBstr;
 
    UsefulInputBuf_Seek(&(pMe->InBuf), uStartOfBstr);
    UsefulInputBuf_SetBufferLength(&(pMe->InBuf), uEndOfBstr);
@@ -3691,6 +4166,47 @@ Done:
 }
 
 
+static QCBORError InternalEnterBstrWrapped(QCBORDecodeContext *pMe,
+                                           const QCBORItem    *pItem,
+                                           uint8_t             uTagRequirement,
+                                           UsefulBufC         *pBstr)
+{
+   if(pBstr) {
+      *pBstr = NULLUsefulBufC;
+   }
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      /* Already in error state; do nothing. */
+      return pMe->uLastError;
+   }
+
+   QCBORError uError;
+
+   const TagSpecification TagSpec =
+      {
+         uTagRequirement,
+         {QBCOR_TYPE_WRAPPED_CBOR, QBCOR_TYPE_WRAPPED_CBOR_SEQUENCE, QCBOR_TYPE_NONE},
+         {QCBOR_TYPE_BYTE_STRING, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE}
+      };
+
+   uError = CheckTagRequirement(TagSpec, pItem);
+   if(uError != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   if(pBstr) {
+      *pBstr = pItem->val.string;
+   }
+
+   uError = EnterBstrWrappedAtOffset(pMe,
+                                     UsefulInputBuf_PointerToOffset(&(pMe->InBuf),
+                                                                    pItem->val.string.ptr),
+                                     pItem->val.string.len);
+Done:
+   return uError;
+}
+
+
 /*
   Public function, see header qcbor/qcbor_decode.h file
  */
@@ -3717,6 +4233,118 @@ void QCBORDecode_EnterBstrWrapped(QCBORDecodeContext *pMe,
 }
 
 
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void
+QCBORDecode_SetBstrEnterCache(QCBORDecodeContext *pMe, QCBORBstrEnterCache *pCache)
+{
+   pMe->pBstrEnterCache = pCache;
+   if(pCache != NULL) {
+      pCache->uLabelType = QCBOR_TYPE_NONE;
+   }
+}
+
+
+/* Returns true if the bstr-wrapped CBOR being entered from the current
+ * map by label is the one last entered from it. The cache entry is
+ * keyed by the start of the bounded map. Offsets are in the whole
+ * input so this distinguishes maps in different bstr-wrapped levels.
+ */
+static bool
+BstrEnterCache_IsHit(QCBORDecodeContext *pMe,
+                     const QCBORItem    *pLabel,
+                     const uint8_t       uTagRequirement)
+{
+   const QCBORBstrEnterCache *pCache = pMe->pBstrEnterCache;
+
+   if(pCache == NULL ||
+      pCache->uLabelType == QCBOR_TYPE_NONE ||
+      pCache->uLabelType != pLabel->uLabelType ||
+      pCache->uTagRequirement != uTagRequirement ||
+      !DecodeNesting_IsBoundedType(&(pMe->nesting), QCBOR_TYPE_MAP) ||
+      pMe->nesting.pCurrentBounded->u.ma.uStartOffset != pCache->uMapStartOffset) {
+      return false;
+   }
+
+   if(pLabel->uLabelType == QCBOR_TYPE_INT64) {
+      return pLabel->label.int64 == pCache->label.int64;
+   } else {
+      return UsefulBuf_Compare(pLabel->label.string, pCache->label.string) == 0;
+   }
+}
+
+
+/* Enter a bstr from the current map by label, skipping the map search
+ * if it is the one that was last entered from this map. pItem is an
+ * array of two with the label to search for in the first. */
+static void
+EnterBstrWrappedFromMap(QCBORDecodeContext *pMe,
+                        QCBORItem          *pItem,
+                        const uint8_t       uTagRequirement,
+                        UsefulBufC         *pBstr)
+{
+   QCBORBstrEnterCache *pCache = pMe->pBstrEnterCache;
+   QCBORError           uErr;
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      /* Already in error state; do nothing. */
+      if(pBstr) {
+         *pBstr = NULLUsefulBufC;
+      }
+      return;
+   }
+
+   if(BstrEnterCache_IsHit(pMe, pItem, uTagRequirement)) {
+      if(pBstr) {
+         *pBstr = (UsefulBufC){(const uint8_t *)pMe->InBuf.UB.ptr + pCache->uBstrStartOffset,
+                               pCache->uBstrLength};
+      }
+      uErr = EnterBstrWrappedAtOffset(pMe,
+                                      pCache->uBstrStartOffset,
+                                      pCache->uBstrLength);
+      goto Done;
+   }
+
+   /* pItem is the first of the two items MapSearch() needs */
+   pItem[0].uDataType  = QCBOR_TYPE_ANY;
+   pItem[1].uLabelType = QCBOR_TYPE_NONE; /* Indicates end of array */
+   uErr = MapSearch(pMe, pItem, NULL, NULL, NULL);
+   if(uErr == QCBOR_SUCCESS && pItem->uDataType == QCBOR_TYPE_NONE) {
+      uErr = QCBOR_ERR_LABEL_NOT_FOUND;
+   }
+   if(uErr != QCBOR_SUCCESS) {
+      if(pBstr) {
+         *pBstr = NULLUsefulBufC;
+      }
+      goto Done;
+   }
+
+   /* Remembered before entering because entering changes the bounded
+    * level. */
+   const uint32_t uMapStartOffset = pMe->nesting.pCurrentBounded->u.ma.uStartOffset;
+
+   uErr = InternalEnterBstrWrapped(pMe, pItem, uTagRequirement, pBstr);
+   if(uErr == QCBOR_SUCCESS && pCache != NULL) {
+      pCache->uMapStartOffset  = uMapStartOffset;
+      pCache->uBstrStartOffset = pMe->nesting.pCurrentBounded->u.bs.uBstrStartOffset;
+      pCache->uBstrLength      = (uint32_t)pItem->val.string.len;
+      pCache->uLabelType       = pItem->uLabelType;
+      pCache->uTagRequirement  = uTagRequirement;
+      /* The label found points into the input rather than to memory
+       * the caller may reuse. */
+      if(pItem->uLabelType == QCBOR_TYPE_INT64) {
+         pCache->label.int64   = pItem->label.int64;
+      } else {
+         pCache->label.string  = pItem->label.string;
+      }
+   }
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
+}
+
+
 /*
   Public function, see header qcbor/qcbor_decode.h file
  */
@@ -3725,13 +4353,12 @@ void QCBORDecode_EnterBstrWrappedFromMapN(QCBORDecodeContext *pMe,
                                           uint8_t             uTagRequirement,
                                           UsefulBufC         *pBstr)
 {
-   QCBORItem Item;
-   QCBORDecode_GetItemInMapN(pMe, nLabel, QCBOR_TYPE_ANY, &Item);
+   QCBORItem OneItemSeach[2];
 
-   pMe->uLastError = (uint8_t)InternalEnterBstrWrapped(pMe,
-                                                       &Item,
-                                                       uTagRequirement,
-                                                       pBstr);
+   OneItemSeach[0].uLabelType  = QCBOR_TYPE_INT64;
+   OneItemSeach[0].label.int64 = nLabel;
+
+   EnterBstrWrappedFromMap(pMe, OneItemSeach, uTagRequirement, pBstr);
 }
 
 
@@ -3743,13 +4370,78 @@ void QCBORDecode_EnterBstrWrappedFromMapSZ(QCBORDecodeContext *pMe,
                                            uint8_t             uTagRequirement,
                                            UsefulBufC         *pBstr)
 {
-   QCBORItem Item;
-   QCBORDecode_GetItemInMapSZ(pMe, szLabel, QCBOR_TYPE_ANY, &Item);
+   QCBORItem OneItemSeach[2];
 
-   pMe->uLastError = (uint8_t)InternalEnterBstrWrapped(pMe,
-                                                       &Item,
-                                                       uTagRequirement,
-                                                       pBstr);
+   OneItemSeach[0].uLabelType   = QCBOR_TYPE_TEXT_STRING;
+   OneItemSeach[0].label.string = UsefulBuf_FromSZ(szLabel);
+
+   EnterBstrWrappedFromMap(pMe, OneItemSeach, uTagRequirement, pBstr);
+}
+
+
+/*
+  Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_SaveBstrWrappedPos(QCBORDecodeContext  *pMe,
+                                    QCBORBstrWrappedPos *pPos)
+{
+   pPos->uStartOffset = 0;
+   pPos->uLength      = 0;
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      /* Already in error state; do nothing. */
+      return;
+   }
+
+   if(!DecodeNesting_IsBoundedType(&(pMe->nesting), QCBOR_TYPE_BYTE_STRING)) {
+      pMe->uLastError = QCBOR_ERR_EXIT_MISMATCH;
+      return;
+   }
+
+   /* The casts are safe because the input size is limited to
+    * QCBOR_MAX_DECODE_INPUT_SIZE. */
+   pPos->uStartOffset = pMe->nesting.pCurrentBounded->u.bs.uBstrStartOffset;
+   pPos->uLength      = (uint32_t)UsefulInputBuf_GetBufferLength(&(pMe->InBuf)) -
+                           pPos->uStartOffset;
+}
+
+
+/*
+  Public function, see header qcbor/qcbor_spiffy_decode.h file
+ */
+void QCBORDecode_EnterBstrWrappedFromPos(QCBORDecodeContext        *pMe,
+                                         const QCBORBstrWrappedPos *pPos,
+                                         UsefulBufC                *pBstr)
+{
+   QCBORError uErr;
+
+   if(pBstr) {
+      *pBstr = NULLUsefulBufC;
+   }
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      /* Already in error state; do nothing. */
+      return;
+   }
+
+   /* The saved position must be in the input that is currently in
+    * scope which is either the whole input or the innermost entered
+    * bstr-wrapped CBOR. Done in 64 bits so the sum can't overflow.
+    */
+   if(pPos->uStartOffset < DecodeNesting_GetBstrScopeStart(&(pMe->nesting)) ||
+      (uint64_t)pPos->uStartOffset + pPos->uLength > UsefulInputBuf_GetBufferLength(&(pMe->InBuf))) {
+      uErr = QCBOR_ERR_HIT_END;
+      goto Done;
+   }
+
+   uErr = EnterBstrWrappedAtOffset(pMe, pPos->uStartOffset, pPos->uLength);
+   if(uErr == QCBOR_SUCCESS && pBstr) {
+      *pBstr = (UsefulBufC){(const uint8_t *)pMe->InBuf.UB.ptr + pPos->uStartOffset,
+                            pPos->uLength};
+   }
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
 }
 
 
@@ -3854,183 +4546,684 @@ void QCBORDecode_GetBoolInMapSZ(QCBORDecodeContext *pMe, const char *szLabel, bo
 
 
 
-static void ProcessEpochDate(QCBORDecodeContext *pMe,
-                             QCBORItem           *pItem,
-                             uint8_t              uTagRequirement,
-                             int64_t             *pnTime)
-{
-   if(pMe->uLastError != QCBOR_SUCCESS) {
-      // Already in error state, do nothing
-      return;
-   }
+static void ProcessEpochDate(QCBORDecodeContext *pMe,
+                             QCBORItem           *pItem,
+                             uint8_t              uTagRequirement,
+                             int64_t             *pnTime)
+{
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      // Already in error state, do nothing
+      return;
+   }
+
+   QCBORError uErr;
+
+   const TagSpecification TagSpec =
+   {
+      uTagRequirement,
+      {QCBOR_TYPE_DATE_EPOCH, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE},
+      {QCBOR_TYPE_INT64, QCBOR_TYPE_DOUBLE, QCBOR_TYPE_FLOAT, QCBOR_TYPE_UINT64}
+   };
+
+   uErr = CheckTagRequirement(TagSpec, pItem);
+   if(uErr != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   if(pItem->uDataType != QCBOR_TYPE_DATE_EPOCH) {
+      uErr = DecodeDateEpoch(pItem);
+      if(uErr != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+
+   // Save the tags in the last item's tags in the decode context
+   // for QCBORDecode_GetNthTagOfLast()
+   CopyTags(pMe, pItem);
+
+   *pnTime = pItem->val.epochDate.nSeconds;
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
+}
+
+
+void QCBORDecode_GetEpochDate(QCBORDecodeContext *pMe,
+                              uint8_t             uTagRequirement,
+                              int64_t            *pnTime)
+{
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      // Already in error state, do nothing
+      return;
+   }
+
+   QCBORItem  Item;
+   pMe->uLastError = (uint8_t)QCBORDecode_GetNext(pMe, &Item);
+
+   ProcessEpochDate(pMe, &Item, uTagRequirement, pnTime);
+}
+
+
+void
+QCBORDecode_GetEpochDateInMapN(QCBORDecodeContext *pMe,
+                               int64_t             nLabel,
+                               uint8_t             uTagRequirement,
+                               int64_t            *pnTime)
+{
+   QCBORItem Item;
+   QCBORDecode_GetItemInMapN(pMe, nLabel, QCBOR_TYPE_ANY, &Item);
+   ProcessEpochDate(pMe, &Item, uTagRequirement, pnTime);
+}
+
+
+void
+QCBORDecode_GetEpochDateInMapSZ(QCBORDecodeContext *pMe,
+                                const char         *szLabel,
+                                uint8_t             uTagRequirement,
+                                int64_t            *pnTime)
+{
+   QCBORItem Item;
+   QCBORDecode_GetItemInMapSZ(pMe, szLabel, QCBOR_TYPE_ANY, &Item);
+   ProcessEpochDate(pMe, &Item, uTagRequirement, pnTime);
+}
+
+
+
+/*
+ * Common processing for the RFC 8943 day-count tag. Mostly
+ * make sure the tag content is correct and copy forward any
+ * further other tag numbers.
+ */
+static void ProcessEpochDays(QCBORDecodeContext *pMe,
+                             QCBORItem          *pItem,
+                             uint8_t             uTagRequirement,
+                             int64_t            *pnDays)
+{
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      /* Already in error state, do nothing */
+      return;
+   }
+
+   QCBORError uErr;
+
+   const TagSpecification TagSpec =
+   {
+      uTagRequirement,
+      {QCBOR_TYPE_DAYS_EPOCH, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE},
+      {QCBOR_TYPE_INT64, QCBOR_TYPE_UINT64, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE}
+   };
+
+   uErr = CheckTagRequirement(TagSpec, pItem);
+   if(uErr != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   if(pItem->uDataType != QCBOR_TYPE_DAYS_EPOCH) {
+      uErr = DecodeDaysEpoch(pItem);
+      if(uErr != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+
+   /* Save the tags in the last item's tags in the decode context
+    * for QCBORDecode_GetNthTagOfLast()
+    */
+   CopyTags(pMe, pItem);
+
+   *pnDays = pItem->val.epochDays;
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_decode.h
+ */
+void QCBORDecode_GetEpochDays(QCBORDecodeContext *pMe,
+                              uint8_t             uTagRequirement,
+                              int64_t            *pnDays)
+{
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      /* Already in error state, do nothing */
+      return;
+   }
+
+   QCBORItem  Item;
+   pMe->uLastError = (uint8_t)QCBORDecode_GetNext(pMe, &Item);
+
+   ProcessEpochDays(pMe, &Item, uTagRequirement, pnDays);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_decode.h
+ */
+void
+QCBORDecode_GetEpochDaysInMapN(QCBORDecodeContext *pMe,
+                               int64_t             nLabel,
+                               uint8_t             uTagRequirement,
+                               int64_t            *pnDays)
+{
+   QCBORItem Item;
+   QCBORDecode_GetItemInMapN(pMe, nLabel, QCBOR_TYPE_ANY, &Item);
+   ProcessEpochDays(pMe, &Item, uTagRequirement, pnDays);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_decode.h
+ */
+void
+QCBORDecode_GetEpochDaysInMapSZ(QCBORDecodeContext *pMe,
+                                const char         *szLabel,
+                                uint8_t             uTagRequirement,
+                                int64_t            *pnDays)
+{
+   QCBORItem Item;
+   QCBORDecode_GetItemInMapSZ(pMe, szLabel, QCBOR_TYPE_ANY, &Item);
+   ProcessEpochDays(pMe, &Item, uTagRequirement, pnDays);
+}
+
+
+
+
+/*
+ * Convert two decimal digits. *puBad has a bit set if either is not
+ * a digit. The checks are accumulated so the fixed part of a date
+ * string is converted with one test at the end rather than a branch
+ * per digit.
+ */
+static inline uint32_t
+DateString_TwoDigits(const uint8_t *p, uint32_t *puBad)
+{
+   const uint32_t uTens = (uint32_t)(uint8_t)(p[0] - '0');
+   const uint32_t uOnes = (uint32_t)(uint8_t)(p[1] - '0');
+
+   *puBad |= (uint32_t)(uTens > 9) | (uint32_t)(uOnes > 9);
+
+   return uTens * 10 + uOnes;
+}
+
+
+/*
+ * Parse an RFC 3339 date-time.
+ *
+ * The first 19 characters, "YYYY-MM-DDTHH:MM:SS", are always at the
+ * same offsets so they are converted without a loop. Only the
+ * optional fraction needs one.
+ *
+ * Days since the epoch are computed with the days-from-civil
+ * algorithm described by Howard Hinnant. It counts in 400-year eras
+ * starting on March 1 so the leap day is the last day of the year,
+ * here from an era before year 0 so everything is unsigned.
+ */
+static QCBORError
+ParseDateString(UsefulBufC DateString,
+                int64_t   *pnSeconds,
+                uint32_t  *puNanoseconds,
+                int16_t   *pnOffsetMinutes)
+{
+   static const uint8_t auDaysInMonth[] = {31,29,31,30,31,30,31,31,30,31,30,31};
+
+   const uint8_t *p    = DateString.ptr;
+   const size_t   uLen = DateString.len;
+   uint32_t       uBad = 0;
+   size_t         uPos;
+   uint32_t       uNanoseconds;
+   uint32_t       uScale;
+   int32_t        nOffsetMinutes;
+
+   /* The shortest is "YYYY-MM-DDTHH:MM:SSZ" */
+   if(uLen < 20) {
+      return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+   }
+
+   const uint32_t uYear   = DateString_TwoDigits(p, &uBad) * 100 +
+                            DateString_TwoDigits(p + 2, &uBad);
+   const uint32_t uMonth  = DateString_TwoDigits(p + 5, &uBad);
+   const uint32_t uDay    = DateString_TwoDigits(p + 8, &uBad);
+   const uint32_t uHour   = DateString_TwoDigits(p + 11, &uBad);
+   const uint32_t uMinute = DateString_TwoDigits(p + 14, &uBad);
+   const uint32_t uSecond = DateString_TwoDigits(p + 17, &uBad);
+
+   uBad |= (uint32_t)(p[4] != '-') | (uint32_t)(p[7] != '-') |
+           (uint32_t)((p[10] | 0x20) != 't') |
+           (uint32_t)(p[13] != ':') | (uint32_t)(p[16] != ':');
+   if(uBad) {
+      return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+   }
+
+   if(uMonth < 1 || uMonth > 12 || uDay < 1 || uDay > auDaysInMonth[uMonth - 1] ||
+      uHour > 23 || uMinute > 59 || uSecond > 60) {
+      return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+   }
+   if(uMonth == 2 && uDay == 29 &&
+      (uYear % 4 != 0 || (uYear % 100 == 0 && uYear % 400 != 0))) {
+      return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+   }
+
+   uPos         = 19;
+   uNanoseconds = 0;
+   if(p[uPos] == '.') {
+      uPos++;
+      uScale = 100000000;
+      while(uPos < uLen && (uint8_t)(p[uPos] - '0') <= 9) {
+         uNanoseconds += (uint32_t)(p[uPos] - '0') * uScale;
+         uScale /= 10;
+         uPos++;
+      }
+      if(uPos == 20) {
+         /* A '.' with no digits after it */
+         return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+      }
+   }
+
+   if(uPos + 1 == uLen && (p[uPos] | 0x20) == 'z') {
+      nOffsetMinutes = 0;
+   } else if(uPos + 6 == uLen && (p[uPos] == '+' || p[uPos] == '-')) {
+      const uint32_t uOffsetHour   = DateString_TwoDigits(p + uPos + 1, &uBad);
+      const uint32_t uOffsetMinute = DateString_TwoDigits(p + uPos + 4, &uBad);
+      if(uBad || p[uPos + 3] != ':' || uOffsetHour > 23 || uOffsetMinute > 59) {
+         return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+      }
+      nOffsetMinutes = (int32_t)(uOffsetHour * 60 + uOffsetMinute);
+      if(p[uPos] == '-') {
+         nOffsetMinutes = -nOffsetMinutes;
+      }
+   } else {
+      return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+   }
+
+   /* Years and days since March 1 of the year -400 */
+   const uint32_t uShiftedYear = uYear + 400 - (uMonth <= 2 ? 1 : 0);
+   const uint32_t uYearOfEra   = uShiftedYear % 400;
+   const uint32_t uDayOfYear   = (153 * (uMonth > 2 ? uMonth - 3 : uMonth + 9) + 2) / 5 + uDay - 1;
+   const uint32_t uDayOfEra    = uYearOfEra * 365 + uYearOfEra/4 - uYearOfEra/100 + uDayOfYear;
+   const int64_t  nDays        = (int64_t)(uShiftedYear / 400) * 146097 + uDayOfEra
+                                 - 146097 - 719468;
+
+   *pnSeconds = nDays * 86400 + (int64_t)(uHour * 3600 + uMinute * 60 + uSecond)
+                - (int64_t)nOffsetMinutes * 60;
+   if(puNanoseconds != NULL) {
+      *puNanoseconds = uNanoseconds;
+   }
+   if(pnOffsetMinutes != NULL) {
+      *pnOffsetMinutes = (int16_t)nOffsetMinutes;
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+static void
+ProcessDateStringAsEpoch(QCBORDecodeContext *pMe,
+                         UsefulBufC          DateString,
+                         int64_t            *pnSeconds,
+                         uint32_t           *puNanoseconds,
+                         int16_t            *pnOffsetMinutes)
+{
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      /* Already in error state, do nothing */
+      return;
+   }
+
+   pMe->uLastError = (uint8_t)ParseDateString(DateString,
+                                              pnSeconds,
+                                              puNanoseconds,
+                                              pnOffsetMinutes);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h
+ */
+void
+QCBORDecode_GetDateStringAsEpoch(QCBORDecodeContext *pMe,
+                                 uint8_t             uTagRequirement,
+                                 int64_t            *pnSeconds,
+                                 uint32_t           *puNanoseconds,
+                                 int16_t            *pnOffsetMinutes)
+{
+   UsefulBufC DateString;
+
+   QCBORDecode_GetDateString(pMe, uTagRequirement, &DateString);
+   ProcessDateStringAsEpoch(pMe, DateString, pnSeconds, puNanoseconds, pnOffsetMinutes);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h
+ */
+void
+QCBORDecode_GetDateStringAsEpochInMapN(QCBORDecodeContext *pMe,
+                                       int64_t             nLabel,
+                                       uint8_t             uTagRequirement,
+                                       int64_t            *pnSeconds,
+                                       uint32_t           *puNanoseconds,
+                                       int16_t            *pnOffsetMinutes)
+{
+   UsefulBufC DateString;
+
+   QCBORDecode_GetDateStringInMapN(pMe, nLabel, uTagRequirement, &DateString);
+   ProcessDateStringAsEpoch(pMe, DateString, pnSeconds, puNanoseconds, pnOffsetMinutes);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h
+ */
+void
+QCBORDecode_GetDateStringAsEpochInMapSZ(QCBORDecodeContext *pMe,
+                                        const char         *szLabel,
+                                        uint8_t             uTagRequirement,
+                                        int64_t            *pnSeconds,
+                                        uint32_t           *puNanoseconds,
+                                        int16_t            *pnOffsetMinutes)
+{
+   UsefulBufC DateString;
+
+   QCBORDecode_GetDateStringInMapSZ(pMe, szLabel, uTagRequirement, &DateString);
+   ProcessDateStringAsEpoch(pMe, DateString, pnSeconds, puNanoseconds, pnOffsetMinutes);
+}
+
+
+
+
+/*
+ * The value of each base64 character. Characters only in base64 have
+ * 0x40 set and characters only in base64url have 0x80 set. Those in
+ * neither are 0xff which has both set.
+ */
+static const uint8_t B64_DecodeTable[256] = {
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7e, 0xff, 0xbe, 0xff, 0x7f,
+   0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+   0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xbf,
+   0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+   0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+
+/*
+ * Public function to remove base64 encoding. See
+ * qcbor/qcbor_spiffy_decode.h
+ *
+ * The values of all the characters are OR'd together and checked
+ * once at the end, so there is no branch per character for invalid
+ * ones. The main loop puts eight characters, 48 bits, in a 64-bit
+ * integer and outputs six bytes from it.
+ */
+QCBORError
+QCBORDecode_DecodeB64(UsefulBufC Text, bool bURL, UsefulBuf Dest, UsefulBufC *pBytes)
+{
+   const uint8_t *pIn      = Text.ptr;
+   size_t         uLen     = Text.len;
+   const uint8_t  uBadMask = bURL ? 0x40 : 0x80;
+   uint8_t       *pOut;
+   size_t         uOutLen;
+   uint64_t       uBits;
+   uint32_t       uAll;
+   uint8_t        uValue;
+   int            nIndex;
+
+   /* Padding is only allowed to make the length a multiple of four */
+   if(uLen >= 4 && uLen % 4 == 0 && pIn[uLen - 1] == '=') {
+      uLen--;
+      if(pIn[uLen - 1] == '=') {
+         uLen--;
+      }
+   }
+   if(uLen % 4 == 1) {
+      return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+   }
+
+   uOutLen = (uLen / 4) * 3 + (uLen % 4 ? uLen % 4 - 1 : 0);
+   if(Dest.ptr == NULL || Dest.len < uOutLen) {
+      return QCBOR_ERR_BUFFER_TOO_SMALL;
+   }
+   pOut = Dest.ptr;
+   uAll = 0;
+
+   while(uLen >= 8) {
+      uBits = 0;
+      for(nIndex = 0; nIndex < 8; nIndex++) {
+         uValue = B64_DecodeTable[pIn[nIndex]];
+         uAll  |= uValue;
+         uBits  = uBits << 6 | (uValue & 0x3f);
+      }
+      pOut[0] = (uint8_t)(uBits >> 40);
+      pOut[1] = (uint8_t)(uBits >> 32);
+      pOut[2] = (uint8_t)(uBits >> 24);
+      pOut[3] = (uint8_t)(uBits >> 16);
+      pOut[4] = (uint8_t)(uBits >> 8);
+      pOut[5] = (uint8_t)uBits;
+      pIn  += 8;
+      pOut += 6;
+      uLen -= 8;
+   }
+
+   /* The last one to seven characters */
+   uBits = 0;
+   for(nIndex = 0; nIndex < (int)uLen; nIndex++) {
+      uValue = B64_DecodeTable[pIn[nIndex]];
+      uAll  |= uValue;
+      uBits  = uBits << 6 | (uValue & 0x3f);
+   }
+   switch(uLen) {
+      case 7: /* 42 bits, 5 bytes and 2 bits left over */
+         if(uBits & 0x03) {
+            return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+         }
+         uBits >>= 2;
+         pOut[0] = (uint8_t)(uBits >> 32);
+         pOut[1] = (uint8_t)(uBits >> 24);
+         pOut[2] = (uint8_t)(uBits >> 16);
+         pOut[3] = (uint8_t)(uBits >> 8);
+         pOut[4] = (uint8_t)uBits;
+         break;
+
+      case 6: /* 36 bits, 4 bytes and 4 bits left over */
+         if(uBits & 0x0f) {
+            return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+         }
+         uBits >>= 4;
+         pOut[0] = (uint8_t)(uBits >> 24);
+         pOut[1] = (uint8_t)(uBits >> 16);
+         pOut[2] = (uint8_t)(uBits >> 8);
+         pOut[3] = (uint8_t)uBits;
+         break;
+
+      case 4: /* 24 bits, 3 bytes */
+         pOut[0] = (uint8_t)(uBits >> 16);
+         pOut[1] = (uint8_t)(uBits >> 8);
+         pOut[2] = (uint8_t)uBits;
+         break;
 
-   QCBORError uErr;
+      case 3: /* 18 bits, 2 bytes and 2 bits left over */
+         if(uBits & 0x03) {
+            return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+         }
+         uBits >>= 2;
+         pOut[0] = (uint8_t)(uBits >> 8);
+         pOut[1] = (uint8_t)uBits;
+         break;
 
-   const TagSpecification TagSpec =
-   {
-      uTagRequirement,
-      {QCBOR_TYPE_DATE_EPOCH, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE},
-      {QCBOR_TYPE_INT64, QCBOR_TYPE_DOUBLE, QCBOR_TYPE_FLOAT, QCBOR_TYPE_UINT64}
-   };
+      case 2: /* 12 bits, 1 byte and 4 bits left over */
+         if(uBits & 0x0f) {
+            return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
+         }
+         pOut[0] = (uint8_t)(uBits >> 4);
+         break;
 
-   uErr = CheckTagRequirement(TagSpec, pItem);
-   if(uErr != QCBOR_SUCCESS) {
-      goto Done;
+      default: /* 0 */
+         break;
    }
 
-   if(pItem->uDataType != QCBOR_TYPE_DATE_EPOCH) {
-      uErr = DecodeDateEpoch(pItem);
-      if(uErr != QCBOR_SUCCESS) {
-         goto Done;
-      }
+   if(uAll & uBadMask) {
+      return QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT;
    }
 
-   // Save the tags in the last item's tags in the decode context
-   // for QCBORDecode_GetNthTagOfLast()
-   CopyTags(pMe, pItem);
-
-   *pnTime = pItem->val.epochDate.nSeconds;
+   *pBytes = (UsefulBufC){Dest.ptr, uOutLen};
 
-Done:
-   pMe->uLastError = (uint8_t)uErr;
+   return QCBOR_SUCCESS;
 }
 
 
-void QCBORDecode_GetEpochDate(QCBORDecodeContext *pMe,
-                              uint8_t             uTagRequirement,
-                              int64_t            *pnTime)
+/*
+ * Common processing for getting base64 text and removing the base64
+ * encoding. The buffer comes from the string allocator if none is
+ * given.
+ */
+static void
+ProcessB64Decoded(QCBORDecodeContext *pMe,
+                  UsefulBufC          Text,
+                  bool                bURL,
+                  UsefulBuf           Buffer,
+                  UsefulBufC         *pBytes)
 {
+   QCBORError uErr;
+
    if(pMe->uLastError != QCBOR_SUCCESS) {
-      // Already in error state, do nothing
+      /* Already in error state, do nothing */
       return;
    }
 
-   QCBORItem  Item;
-   pMe->uLastError = (uint8_t)QCBORDecode_GetNext(pMe, &Item);
+   if(Buffer.ptr == NULL) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+      if(pMe->StringAllocator.pfAllocator == NULL) {
+         uErr = QCBOR_ERR_NO_STRING_ALLOCATOR;
+         goto Done;
+      }
+      Buffer = StringAllocator_Allocate(&(pMe->StringAllocator), (Text.len / 4) * 3 + 2);
+      if(UsefulBuf_IsNULL(Buffer)) {
+         uErr = QCBOR_ERR_STRING_ALLOCATE;
+         goto Done;
+      }
+      uErr = QCBORDecode_DecodeB64(Text, bURL, Buffer, pBytes);
+      if(uErr != QCBOR_SUCCESS) {
+         StringAllocator_Free(&(pMe->StringAllocator), Buffer.ptr);
+      }
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+      uErr = QCBOR_ERR_NO_STRING_ALLOCATOR;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+      goto Done;
+   }
 
-   ProcessEpochDate(pMe, &Item, uTagRequirement, pnTime);
+   uErr = QCBORDecode_DecodeB64(Text, bURL, Buffer, pBytes);
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
 }
 
 
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h
+ */
 void
-QCBORDecode_GetEpochDateInMapN(QCBORDecodeContext *pMe,
-                               int64_t             nLabel,
-                               uint8_t             uTagRequirement,
-                               int64_t            *pnTime)
+QCBORDecode_GetB64Decoded(QCBORDecodeContext *pMe,
+                          uint8_t             uTagRequirement,
+                          UsefulBuf           Buffer,
+                          UsefulBufC         *pBytes)
 {
-   QCBORItem Item;
-   QCBORDecode_GetItemInMapN(pMe, nLabel, QCBOR_TYPE_ANY, &Item);
-   ProcessEpochDate(pMe, &Item, uTagRequirement, pnTime);
+   UsefulBufC Text;
+
+   QCBORDecode_GetB64(pMe, uTagRequirement, &Text);
+   ProcessB64Decoded(pMe, Text, false, Buffer, pBytes);
 }
 
 
+/*
+ * Public function, see header qcbor/qcbor_spiffy_decode.h
+ */
 void
-QCBORDecode_GetEpochDateInMapSZ(QCBORDecodeContext *pMe,
-                                const char         *szLabel,
+QCBORDecode_GetB64DecodedInMapN(QCBORDecodeContext *pMe,
+                                int64_t             nLabel,
                                 uint8_t             uTagRequirement,
-                                int64_t            *pnTime)
+                                UsefulBuf           Buffer,
+                                UsefulBufC         *pBytes)
 {
-   QCBORItem Item;
-   QCBORDecode_GetItemInMapSZ(pMe, szLabel, QCBOR_TYPE_ANY, &Item);
-   ProcessEpochDate(pMe, &Item, uTagRequirement, pnTime);
-}
+   UsefulBufC Text;
 
+   QCBORDecode_GetB64InMapN(pMe, nLabel, uTagRequirement, &Text);
+   ProcessB64Decoded(pMe, Text, false, Buffer, pBytes);
+}
 
 
 /*
- * Common processing for the RFC 8943 day-count tag. Mostly
- * make sure the tag content is correct and copy forward any
- * further other tag numbers.
+ * Public function, see header qcbor/qcbor_spiffy_decode.h
  */
-static void ProcessEpochDays(QCBORDecodeContext *pMe,
-                             QCBORItem          *pItem,
-                             uint8_t             uTagRequirement,
-                             int64_t            *pnDays)
+void
+QCBORDecode_GetB64DecodedInMapSZ(QCBORDecodeContext *pMe,
+                                 const char         *szLabel,
+                                 uint8_t             uTagRequirement,
+                                 UsefulBuf           Buffer,
+                                 UsefulBufC         *pBytes)
 {
-   if(pMe->uLastError != QCBOR_SUCCESS) {
-      /* Already in error state, do nothing */
-      return;
-   }
-
-   QCBORError uErr;
-
-   const TagSpecification TagSpec =
-   {
-      uTagRequirement,
-      {QCBOR_TYPE_DAYS_EPOCH, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE},
-      {QCBOR_TYPE_INT64, QCBOR_TYPE_UINT64, QCBOR_TYPE_NONE, QCBOR_TYPE_NONE}
-   };
-
-   uErr = CheckTagRequirement(TagSpec, pItem);
-   if(uErr != QCBOR_SUCCESS) {
-      goto Done;
-   }
-
-   if(pItem->uDataType != QCBOR_TYPE_DAYS_EPOCH) {
-      uErr = DecodeDaysEpoch(pItem);
-      if(uErr != QCBOR_SUCCESS) {
-         goto Done;
-      }
-   }
-
-   /* Save the tags in the last item's tags in the decode context
-    * for QCBORDecode_GetNthTagOfLast()
-    */
-   CopyTags(pMe, pItem);
-
-   *pnDays = pItem->val.epochDays;
+   UsefulBufC Text;
 
-Done:
-   pMe->uLastError = (uint8_t)uErr;
+   QCBORDecode_GetB64InMapSZ(pMe, szLabel, uTagRequirement, &Text);
+   ProcessB64Decoded(pMe, Text, false, Buffer, pBytes);
 }
 
 
 /*
- * Public function, see header qcbor/qcbor_decode.h
+ * Public function, see header qcbor/qcbor_spiffy_decode.h
  */
-void QCBORDecode_GetEpochDays(QCBORDecodeContext *pMe,
-                              uint8_t             uTagRequirement,
-                              int64_t            *pnDays)
+void
+QCBORDecode_GetB64URLDecoded(QCBORDecodeContext *pMe,
+                             uint8_t             uTagRequirement,
+                             UsefulBuf           Buffer,
+                             UsefulBufC         *pBytes)
 {
-   if(pMe->uLastError != QCBOR_SUCCESS) {
-      /* Already in error state, do nothing */
-      return;
-   }
-
-   QCBORItem  Item;
-   pMe->uLastError = (uint8_t)QCBORDecode_GetNext(pMe, &Item);
+   UsefulBufC Text;
 
-   ProcessEpochDays(pMe, &Item, uTagRequirement, pnDays);
+   QCBORDecode_GetB64URL(pMe, uTagRequirement, &Text);
+   ProcessB64Decoded(pMe, Text, true, Buffer, pBytes);
 }
 
 
 /*
- * Public function, see header qcbor/qcbor_decode.h
+ * Public function, see header qcbor/qcbor_spiffy_decode.h
  */
 void
-QCBORDecode_GetEpochDaysInMapN(QCBORDecodeContext *pMe,
-                               int64_t             nLabel,
-                               uint8_t             uTagRequirement,
-                               int64_t            *pnDays)
+QCBORDecode_GetB64URLDecodedInMapN(QCBORDecodeContext *pMe,
+                                   int64_t             nLabel,
+                                   uint8_t             uTagRequirement,
+                                   UsefulBuf           Buffer,
+                                   UsefulBufC         *pBytes)
 {
-   QCBORItem Item;
-   QCBORDecode_GetItemInMapN(pMe, nLabel, QCBOR_TYPE_ANY, &Item);
-   ProcessEpochDays(pMe, &Item, uTagRequirement, pnDays);
+   UsefulBufC Text;
+
+   QCBORDecode_GetB64URLInMapN(pMe, nLabel, uTagRequirement, &Text);
+   ProcessB64Decoded(pMe, Text, true, Buffer, pBytes);
 }
 
 
 /*
- * Public function, see header qcbor/qcbor_decode.h
+ * Public function, see header qcbor/qcbor_spiffy_decode.h
  */
 void
-QCBORDecode_GetEpochDaysInMapSZ(QCBORDecodeContext *pMe,
-                                const char         *szLabel,
-                                uint8_t             uTagRequirement,
-                                int64_t            *pnDays)
+QCBORDecode_GetB64URLDecodedInMapSZ(QCBORDecodeContext *pMe,
+                                    const char         *szLabel,
+                                    uint8_t             uTagRequirement,
+                                    UsefulBuf           Buffer,
+                                    UsefulBufC         *pBytes)
 {
-   QCBORItem Item;
-   QCBORDecode_GetItemInMapSZ(pMe, szLabel, QCBOR_TYPE_ANY, &Item);
-   ProcessEpochDays(pMe, &Item, uTagRequirement, pnDays);
+   UsefulBufC Text;
+
+   QCBORDecode_GetB64URLInMapSZ(pMe, szLabel, uTagRequirement, &Text);
+   ProcessB64Decoded(pMe, Text, true, Buffer, pBytes);
 }
 
 
@@ -5980,3 +7173,155 @@ void QCBORDecode_GetBigFloatBigInMapSZ(QCBORDecodeContext *pMe,
 }
 
 #endif /* QCBOR_DISABLE_EXP_AND_MANTISSA */
+
+
+
+
+/*
+ * Private function. See qcbor_decode_private.h
+ *
+ * Nesting is tracked with a count of items left at each level rather
+ * than by recursion. Tags are not a level because a tag and its
+ * content are one item.
+ */
+QCBORError
+QCBORDecode_Private_SkipItem(UsefulInputBuf *pInBuf)
+{
+   QCBORError uReturn;
+   uint64_t   auLeft[QCBOR_MAX_ARRAY_NESTING + 2];
+   int        nLevel;
+   int        nMajorType;
+   int        nAdditionalInfo;
+   uint64_t   uArgument;
+
+   nLevel     = 0;
+   auLeft[0]  = 1;
+
+   for(;;) {
+      uReturn = DecodeHead(pInBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+
+      if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == LEN_IS_INDEFINITE) {
+         /* A break closes the indefinite-length item it is in */
+         if(nLevel == 0 || auLeft[nLevel] != SKIP_INDEFINITE) {
+            uReturn = QCBOR_ERR_BAD_BREAK;
+            goto Done;
+         }
+         nLevel--;
+
+      } else if(nMajorType == CBOR_MAJOR_TYPE_TAG) {
+         /* The tag content is the rest of the item */
+         continue;
+
+      } else if(nAdditionalInfo == LEN_IS_INDEFINITE ||
+                ((nMajorType == CBOR_MAJOR_TYPE_ARRAY || nMajorType == CBOR_MAJOR_TYPE_MAP) &&
+                 uArgument > 0)) {
+         /* Contents to skip. Indefinite-length strings are a level for
+          * their chunks. */
+         if(nLevel >= QCBOR_MAX_ARRAY_NESTING + 1) {
+            uReturn = QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP;
+            goto Done;
+         }
+         if(nAdditionalInfo != LEN_IS_INDEFINITE &&
+            uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+            /* Each item is at least one byte. This also makes sure
+             * the doubling for maps doesn't overflow. */
+            uReturn = QCBOR_ERR_HIT_END;
+            goto Done;
+         }
+         nLevel++;
+         if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+            auLeft[nLevel] = SKIP_INDEFINITE;
+         } else {
+            auLeft[nLevel] = nMajorType == CBOR_MAJOR_TYPE_MAP ? uArgument * 2 : uArgument;
+         }
+         continue;
+
+      } else if(nMajorType == CBOR_MAJOR_TYPE_BYTE_STRING ||
+                nMajorType == CBOR_MAJOR_TYPE_TEXT_STRING) {
+         if(uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+            uReturn = QCBOR_ERR_HIT_END;
+            goto Done;
+         }
+         UsefulInputBuf_Seek(pInBuf, UsefulInputBuf_Tell(pInBuf) + (size_t)uArgument);
+      }
+
+      /* An item is done. That may finish the arrays and maps it is in. */
+      while(auLeft[nLevel] != SKIP_INDEFINITE && --auLeft[nLevel] == 0) {
+         if(nLevel == 0) {
+            goto Done;
+         }
+         nLevel--;
+      }
+   }
+
+Done:
+   return uReturn;
+}
+
+
+/*
+ * Skips what is in the map or array just gotten by
+ * QCBORDecode_GetNext() by decoding only heads. The nesting is then
+ * ascended as if each item in it had been gotten. See
+ * qcbor_decode_private.h.
+ */
+QCBORError
+QCBORDecode_Private_SkipContents(QCBORDecodeContext *pMe, QCBORItem *pItem)
+{
+   QCBORError uReturn;
+   uint64_t   uCount;
+
+   if(pItem->uNextNestLevel <= pItem->uNestingLevel) {
+      /* Not a map or array with items, so nothing was descended into */
+      return QCBOR_SUCCESS;
+   }
+
+   if(DecodeNesting_IsCurrentDefiniteLength(&(pMe->nesting))) {
+      uCount = pMe->nesting.pCurrent->u.ma.uCountCursor;
+      if(pMe->nesting.pCurrent->uLevelType == QCBOR_TYPE_MAP) {
+         uCount *= 2;
+      }
+      /* The ascender decrements this for the last item */
+      pMe->nesting.pCurrent->u.ma.uCountCursor = 1;
+   } else {
+      /* The ascender consumes the break */
+      uCount = SKIP_INDEFINITE;
+   }
+
+   while(!QCBORDecode_Private_AtEnd(&(pMe->InBuf), &uCount)) {
+      uReturn = QCBORDecode_Private_SkipItem(&(pMe->InBuf));
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+
+   uReturn = QCBORDecode_NestLevelAscender(pMe, true);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   /* The same as at the end of QCBORDecode_GetNextMapOrArray() */
+   if(DecodeNesting_IsAtEndOfBoundedLevel(&(pMe->nesting))) {
+      pItem->uNextNestLevel = 0;
+   } else {
+      pItem->uNextNestLevel = DecodeNesting_GetCurrentLevel(&(pMe->nesting));
+   }
+
+Done:
+   return uReturn;
+}
+
+
+/*
+ * Private function. See qcbor_decode_private.h
+ */
+void
+QCBORDecode_Private_SeekTop(QCBORDecodeContext *pMe, size_t uOffset)
+{
+   UsefulInputBuf_Seek(&(pMe->InBuf), uOffset);
+   DecodeNesting_Init(&(pMe->nesting));
+   pMe->uLastError = QCBOR_SUCCESS;
+}
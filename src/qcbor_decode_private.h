@@ -0,0 +1,424 @@
+/*==============================================================================
+ qcbor_decode_private.h -- Decoder internals used by the other source files
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_decode_private_h
+#define qcbor_decode_private_h
+
+
+#include "qcbor/qcbor_decode.h"
+#include "ieee754.h" /* Does not use math.h */
+
+
+/*
+ * The lowest layer of decoding is here so the decoders in the other
+ * source files that work on heads directly, such as diag, view and
+ * SAX, decode the same way QCBORDecode_GetNext() does. The small
+ * functions are inline so they stay inline in the loops that call
+ * them.
+ */
+
+
+/**
+ * @brief Decode the CBOR head, the type and argument.
+ *
+ * @param[in] pUInBuf            The input buffer to read from.
+ * @param[out] pnMajorType       The decoded major type.
+ * @param[out] puArgument        The decoded argument.
+ * @param[out] pnAdditionalInfo  The decoded Lower 5 bits of initial byte.
+ *
+ * @retval QCBOR_ERR_UNSUPPORTED
+ * @retval QCBOR_ERR_HIT_END
+ *
+ * This decodes the CBOR "head" that every CBOR data item has. See
+ * longer explaination of the head in documentation for
+ * QCBOREncode_EncodeHead().
+ *
+ * This does the network->host byte order conversion. The conversion
+ * here also results in the conversion for floats in addition to that
+ * for lengths, tags and integer values.
+ *
+ * The int type is preferred to uint8_t for some variables as this
+ * avoids integer promotions, can reduce code size and makes static
+ * analyzers happier.
+ */
+static inline QCBORError
+DecodeHead(UsefulInputBuf *pUInBuf,
+           int            *pnMajorType,
+           uint64_t       *puArgument,
+           int            *pnAdditionalInfo)
+{
+   QCBORError uReturn;
+
+   /* Get the initial byte that every CBOR data item has and break it
+    * down. */
+   const int nInitialByte    = (int)UsefulInputBuf_GetByte(pUInBuf);
+   const int nTmpMajorType   = nInitialByte >> 5;
+   const int nAdditionalInfo = nInitialByte & 0x1f;
+
+   /* Where the argument accumulates */
+   uint64_t uArgument;
+
+   if(nAdditionalInfo >= LEN_IS_ONE_BYTE && nAdditionalInfo <= LEN_IS_EIGHT_BYTES) {
+      /* Need to get 1,2,4 or 8 additional argument bytes. Map
+       * LEN_IS_ONE_BYTE..LEN_IS_EIGHT_BYTES to actual length.
+       */
+      static const uint8_t aIterate[] = {1,2,4,8};
+
+      /* Loop getting all the bytes in the argument */
+      uArgument = 0;
+      for(int i = aIterate[nAdditionalInfo - LEN_IS_ONE_BYTE]; i; i--) {
+         /* This shift and add gives the endian conversion. */
+         uArgument = (uArgument << 8) + UsefulInputBuf_GetByte(pUInBuf);
+      }
+   } else if(nAdditionalInfo >= ADDINFO_RESERVED1 && nAdditionalInfo <= ADDINFO_RESERVED3) {
+      /* The reserved and thus-far unused additional info values */
+      uReturn = QCBOR_ERR_UNSUPPORTED;
+      goto Done;
+   } else {
+      /* Less than 24, additional info is argument or 31, an
+       * indefinite-length.  No more bytes to get.
+       */
+      uArgument = (uint64_t)nAdditionalInfo;
+   }
+
+   if(UsefulInputBuf_GetError(pUInBuf)) {
+      uReturn = QCBOR_ERR_HIT_END;
+      goto Done;
+   }
+
+   /* All successful if arrived here. */
+   uReturn           = QCBOR_SUCCESS;
+   *pnMajorType      = nTmpMajorType;
+   *puArgument       = uArgument;
+   *pnAdditionalInfo = nAdditionalInfo;
+
+Done:
+   return uReturn;
+}
+
+
+/**
+ * @brief Decode integer types, major types 0 and 1.
+ *
+ * @param[in] nMajorType     The CBOR major type (0 or 1).
+ * @param[in] uArgument      The argument from the head.
+ * @param[out] pDecodedItem  The filled in decoded item.
+ *
+ * @retval QCBOR_ERR_INT_OVERFLOW
+ *
+ * Must only be called when major type is 0 or 1.
+ *
+ * CBOR doesn't explicitly specify two's compliment for integers but
+ * all CPUs use it these days and the test vectors in the RFC are
+ * so. All integers in the CBOR structure are positive and the major
+ * type indicates positive or negative.  CBOR can express positive
+ * integers up to 2^x - 1 where x is the number of bits and negative
+ * integers down to 2^x.  Note that negative numbers can be one more
+ * away from zero than positive.  Stdint, as far as I can tell, uses
+ * two's compliment to represent negative integers.
+ */
+static inline QCBORError
+DecodeInteger(int nMajorType, uint64_t uArgument, QCBORItem *pDecodedItem)
+{
+   QCBORError uReturn = QCBOR_SUCCESS;
+
+   if(nMajorType == CBOR_MAJOR_TYPE_POSITIVE_INT) {
+      if (uArgument <= INT64_MAX) {
+         pDecodedItem->val.int64 = (int64_t)uArgument;
+         pDecodedItem->uDataType = QCBOR_TYPE_INT64;
+
+      } else {
+         pDecodedItem->val.uint64 = uArgument;
+         pDecodedItem->uDataType  = QCBOR_TYPE_UINT64;
+      }
+
+   } else {
+      if(uArgument <= INT64_MAX) {
+         /* CBOR's representation of negative numbers lines up with
+          * the two-compliment representation. A negative integer has
+          * one more in range than a positive integer. INT64_MIN is
+          * equal to (-INT64_MAX) - 1.
+          */
+         pDecodedItem->val.int64 = (-(int64_t)uArgument) - 1;
+         pDecodedItem->uDataType = QCBOR_TYPE_INT64;
+
+      } else {
+         /* C can't represent a negative integer in this range so it
+          * is an error.
+          */
+         uReturn = QCBOR_ERR_INT_OVERFLOW;
+      }
+   }
+
+   return uReturn;
+}
+
+
+/* Make sure #define value line up as DecodeSimple counts on this. */
+#if QCBOR_TYPE_FALSE != CBOR_SIMPLEV_FALSE
+#error QCBOR_TYPE_FALSE macro value wrong
+#endif
+
+#if QCBOR_TYPE_TRUE != CBOR_SIMPLEV_TRUE
+#error QCBOR_TYPE_TRUE macro value wrong
+#endif
+
+#if QCBOR_TYPE_NULL != CBOR_SIMPLEV_NULL
+#error QCBOR_TYPE_NULL macro value wrong
+#endif
+
+#if QCBOR_TYPE_UNDEF != CBOR_SIMPLEV_UNDEF
+#error QCBOR_TYPE_UNDEF macro value wrong
+#endif
+
+#if QCBOR_TYPE_BREAK != CBOR_SIMPLE_BREAK
+#error QCBOR_TYPE_BREAK macro value wrong
+#endif
+
+#if QCBOR_TYPE_DOUBLE != DOUBLE_PREC_FLOAT
+#error QCBOR_TYPE_DOUBLE macro value wrong
+#endif
+
+#if QCBOR_TYPE_FLOAT != SINGLE_PREC_FLOAT
+#error QCBOR_TYPE_FLOAT macro value wrong
+#endif
+
+
+/**
+ * @brief Decode major type 7 -- true, false, floating-point, break...
+ *
+ * @param[in] nAdditionalInfo   The lower five bits from the initial byte.
+ * @param[in] uArgument         The argument from the head.
+ * @param[out] pDecodedItem     The filled in decoded item.
+ *
+ * @retval QCBOR_ERR_HALF_PRECISION_DISABLED
+ * @retval QCBOR_ERR_ALL_FLOAT_DISABLED
+ * @retval QCBOR_ERR_BAD_TYPE_7
+ */
+
+static inline QCBORError
+DecodeType7(int nAdditionalInfo, uint64_t uArgument, QCBORItem *pDecodedItem)
+{
+   QCBORError uReturn = QCBOR_SUCCESS;
+
+   /* uAdditionalInfo is 5 bits from the initial byte. Compile time
+    * checks above make sure uAdditionalInfo values line up with
+    * uDataType values.  DecodeHead() never returns an AdditionalInfo
+    * > 0x1f so cast is safe.
+    */
+   pDecodedItem->uDataType = (uint8_t)nAdditionalInfo;
+
+   switch(nAdditionalInfo) {
+      /* No check for ADDINFO_RESERVED1 - ADDINFO_RESERVED3 as they
+       * are caught before this is called.
+       */
+
+      case HALF_PREC_FLOAT: /* 25 */
+#ifndef QCBOR_DISABLE_PREFERRED_FLOAT
+         /* Half-precision is returned as a double.  The cast to
+          * uint16_t is safe because the encoded value was 16 bits. It
+          * was widened to 64 bits to be passed in here.
+          */
+         pDecodedItem->val.dfnum = IEEE754_HalfToDouble((uint16_t)uArgument);
+         pDecodedItem->uDataType = QCBOR_TYPE_DOUBLE;
+#endif /* QCBOR_DISABLE_PREFERRED_FLOAT */
+         uReturn = FLOAT_ERR_CODE_NO_HALF_PREC(QCBOR_SUCCESS);
+         break;
+      case SINGLE_PREC_FLOAT: /* 26 */
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+         /* Single precision is normally returned as a double since
+          * double is widely supported, there is no loss of precision,
+          * it makes it easy for the caller in most cases and it can
+          * be converted back to single with no loss of precision
+          *
+          * The cast to uint32_t is safe because the encoded value was
+          * 32 bits. It was widened to 64 bits to be passed in here.
+          */
+         {
+            const float f = UsefulBufUtil_CopyUint32ToFloat((uint32_t)uArgument);
+#ifndef QCBOR_DISABLE_FLOAT_HW_USE
+            /* In the normal case, use HW to convert float to
+             * double. */
+            pDecodedItem->val.dfnum = (double)f;
+            pDecodedItem->uDataType = QCBOR_TYPE_DOUBLE;
+#else /* QCBOR_DISABLE_FLOAT_HW_USE */
+            /* Use of float HW is disabled, return as a float. */
+            pDecodedItem->val.fnum = f;
+            pDecodedItem->uDataType = QCBOR_TYPE_FLOAT;
+
+            /* IEEE754_FloatToDouble() could be used here to return as
+             * a double, but it adds object code and most likely
+             * anyone disabling FLOAT HW use doesn't care about floats
+             * and wants to save object code.
+             */
+#endif /* QCBOR_DISABLE_FLOAT_HW_USE */
+         }
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+         uReturn = FLOAT_ERR_CODE_NO_FLOAT(QCBOR_SUCCESS);
+         break;
+
+      case DOUBLE_PREC_FLOAT: /* 27 */
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+         pDecodedItem->val.dfnum = UsefulBufUtil_CopyUint64ToDouble(uArgument);
+         pDecodedItem->uDataType = QCBOR_TYPE_DOUBLE;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+         uReturn = FLOAT_ERR_CODE_NO_FLOAT(QCBOR_SUCCESS);
+         break;
+
+      case CBOR_SIMPLEV_FALSE: /* 20 */
+      case CBOR_SIMPLEV_TRUE:  /* 21 */
+      case CBOR_SIMPLEV_NULL:  /* 22 */
+      case CBOR_SIMPLEV_UNDEF: /* 23 */
+      case CBOR_SIMPLE_BREAK:  /* 31 */
+         break; /* nothing to do */
+
+      case CBOR_SIMPLEV_ONEBYTE: /* 24 */
+         if(uArgument <= CBOR_SIMPLE_BREAK) {
+            /* This takes out f8 00 ... f8 1f which should be encoded
+             * as e0 … f7
+             */
+            uReturn = QCBOR_ERR_BAD_TYPE_7;
+            goto Done;
+         }
+         /* FALLTHROUGH */
+
+      default: /* 0-19 */
+         pDecodedItem->uDataType   = QCBOR_TYPE_UKNOWN_SIMPLE;
+         /* DecodeHead() will make uArgument equal to
+          * nAdditionalInfo when nAdditionalInfo is < 24. This cast is
+          * safe because the 2, 4 and 8 byte lengths of uNumber are in
+          * the double/float cases above
+          */
+         pDecodedItem->val.uSimple = (uint8_t)uArgument;
+         break;
+   }
+
+Done:
+   return uReturn;
+}
+
+
+/**
+ * @brief Map the CBOR major types  for arrays/maps  to the QCBOR types.
+ *
+ * @param[in] nCBORMajorType  The CBOR major type to convert.
+ * @retturns QCBOR type number.
+ *
+ * This only works for the two aggregate types.
+ */
+static inline uint8_t ConvertArrayOrMapType(int nCBORMajorType)
+{
+   #if QCBOR_TYPE_ARRAY != CBOR_MAJOR_TYPE_ARRAY
+   #error QCBOR_TYPE_ARRAY value not lined up with major type
+   #endif
+
+   #if QCBOR_TYPE_MAP != CBOR_MAJOR_TYPE_MAP
+   #error QCBOR_TYPE_MAP value not lined up with major type
+   #endif
+
+   return (uint8_t)(nCBORMajorType);
+}
+
+
+/* The count of items left passed to QCBORDecode_Private_AtEnd() for
+ * an indefinite-length array or map */
+#define SKIP_INDEFINITE UINT64_MAX
+
+
+/* True if at the end of the array or map being gone through. Counts
+ * down *puCount for definite lengths. */
+static inline bool
+QCBORDecode_Private_AtEnd(UsefulInputBuf *pInBuf, uint64_t *puCount)
+{
+   size_t  uPos;
+   uint8_t uByte;
+
+   if(*puCount == SKIP_INDEFINITE) {
+      uPos  = UsefulInputBuf_Tell(pInBuf);
+      uByte = UsefulInputBuf_GetByte(pInBuf);
+      UsefulInputBuf_Seek(pInBuf, uPos);
+      /* Running out of input is at the end too; skipping then gives
+       * the error */
+      return uByte == (CBOR_MAJOR_TYPE_SIMPLE << 5 | LEN_IS_INDEFINITE);
+   }
+   if(*puCount == 0) {
+      return true;
+   }
+   (*puCount)--;
+   return false;
+}
+
+
+/* Get the bytes of a definite-length string or chunk */
+static inline QCBORError
+QCBORDecode_Private_GetBytes(UsefulInputBuf *pInBuf,
+                             uint64_t        uLen,
+                             UsefulBufC     *pBytes)
+{
+   /* Same limit as DecodeBytes() */
+   if(uLen > SIZE_MAX-4) {
+      return QCBOR_ERR_STRING_TOO_LONG;
+   }
+   *pBytes = UsefulInputBuf_GetUsefulBuf(pInBuf, (size_t)uLen);
+   if(UsefulBuf_IsNULLC(*pBytes)) {
+      return QCBOR_ERR_HIT_END;
+   }
+   return QCBOR_SUCCESS;
+}
+
+
+/**
+ * @brief Skip over one data item including its tags and contents.
+ *
+ * @param[in] pInBuf  Positioned at the item. Positioned after it on
+ *                    return.
+ *
+ * @return An error if the item isn't well-formed enough to find its
+ *         end.
+ *
+ * This decodes only heads and jumps over string contents, so it is
+ * much faster than getting the item.
+ */
+QCBORError
+QCBORDecode_Private_SkipItem(UsefulInputBuf *pInBuf);
+
+
+/**
+ * @brief Skip the contents of a map or array by decoding only heads.
+ *
+ * @param[in] pMe        The decode context.
+ * @param[in,out] pItem  The item just gotten by QCBORDecode_GetNext().
+ *
+ * @return An error if the contents are not well-formed.
+ *
+ * This is much faster than getting each item in the map or array. The
+ * contents are only checked for being well-formed. Afterwards the
+ * decoder is as if every item in it had been gotten and @c
+ * uNextNestLevel in @c pItem is updated to match. Nothing is done if
+ * @c pItem is not a map or array with items.
+ */
+QCBORError
+QCBORDecode_Private_SkipContents(QCBORDecodeContext *pMe, QCBORItem *pItem);
+
+
+/**
+ * @brief Start decoding again at a top-level item.
+ *
+ * @param[in] pMe      The decode context.
+ * @param[in] uOffset  The offset of the item in the input.
+ *
+ * Any nesting and the last error are cleared. This is for the
+ * sequence index to jump to a record.
+ */
+void
+QCBORDecode_Private_SeekTop(QCBORDecodeContext *pMe, size_t uOffset);
+
+
+#endif /* qcbor_decode_private_h */
@@ -0,0 +1,910 @@
+/*==============================================================================
+ qcbor_diag.c -- Output of CBOR diagnostic notation
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_diag.h"
+#include "qcbor_decode_private.h"
+
+
+/**
+ * @file qcbor_diag.c
+ *
+ * This implements QCBORDecode_ToDiag(). It works on CBOR heads
+ * directly with DecodeHead() rather than with QCBORDecode_GetNext()
+ * so that it can show encoding details and so that it doesn't need a
+ * string allocator for indefinite-length strings.
+ *
+ * Arrays, maps, tags and indefinite-length strings are handled
+ * iteratively with a small fixed stack of levels. Embedded CBOR is
+ * handled by recursion, but each recursion uses up a level so the
+ * depth is bounded by QCBOR_DIAG_MAX_NESTING. Whether a byte string
+ * is well-formed CBOR is checked by going over it with output
+ * suppressed. Byte strings inside that are not checked for embedded
+ * CBOR so the amount of work stays linear.
+ *
+ * Floating-point numbers are output by working directly on their
+ * bits with the free-format algorithm of Steele & White as refined by
+ * Burger & Dybvig. It uses exact big-integer arithmetic so it needs no
+ * floating-point hardware and gives the shortest digits that convert
+ * back to the same value.
+ */
+
+
+/* Output is gathered into pieces of this size before calling the
+ * writer. */
+#define DIAG_CHUNK_SIZE 64
+
+
+typedef struct {
+   QCBORDiagWriter pfWriter;
+   void           *pWriterCtx;
+   size_t          uMaxLen;
+   size_t          uTotalLen;
+   uint32_t        uOptions;
+   int             nSuppress; /* Non-zero when just checking well-formedness */
+   QCBORError      uError;    /* Sticky output error */
+   size_t          uChunkLen;
+   char            szChunk[DIAG_CHUNK_SIZE];
+} DiagOutput;
+
+
+typedef struct {
+   uint64_t uCount;      /* Items in array, pairs in map, 1 for tag */
+   uint64_t uCountDone;  /* Items output so far at this level */
+   uint8_t  uMajorType;  /* Array, map, tag or string for indefinite strings */
+   bool     bIndefinite;
+} DiagLevel;
+
+
+static void
+DiagOutput_Flush(DiagOutput *pMe)
+{
+   QCBORError uErr;
+
+   if(pMe->uChunkLen == 0) {
+      return;
+   }
+
+   uErr = (*pMe->pfWriter)(pMe->pWriterCtx,
+                           (UsefulBufC){pMe->szChunk, pMe->uChunkLen});
+   pMe->uChunkLen = 0;
+   if(uErr != QCBOR_SUCCESS && pMe->uError == QCBOR_SUCCESS) {
+      pMe->uError = uErr;
+   }
+}
+
+
+static void
+DiagOutput_Append(DiagOutput *pMe, const char *pText, size_t uLen)
+{
+   size_t     uAmount;
+   QCBORError uCapError;
+
+   if(pMe->nSuppress || pMe->uError != QCBOR_SUCCESS) {
+      return;
+   }
+
+   uCapError = QCBOR_SUCCESS;
+   if(uLen > pMe->uMaxLen - pMe->uTotalLen) {
+      /* Output up to the cap so the truncation is where it should be */
+      uLen = pMe->uMaxLen - pMe->uTotalLen;
+      uCapError = QCBOR_ERR_BUFFER_TOO_SMALL;
+   }
+   pMe->uTotalLen += uLen;
+
+   /* Stops if the writer fails */
+   while(uLen && pMe->uError == QCBOR_SUCCESS) {
+      uAmount = DIAG_CHUNK_SIZE - pMe->uChunkLen;
+      if(uAmount > uLen) {
+         uAmount = uLen;
+      }
+      memcpy(pMe->szChunk + pMe->uChunkLen, pText, uAmount);
+      pMe->uChunkLen += uAmount;
+      pText          += uAmount;
+      uLen           -= uAmount;
+      if(pMe->uChunkLen == DIAG_CHUNK_SIZE) {
+         DiagOutput_Flush(pMe);
+      }
+   }
+
+   if(pMe->uError == QCBOR_SUCCESS) {
+      pMe->uError = uCapError;
+   }
+}
+
+
+static void
+DiagOutput_AppendSZ(DiagOutput *pMe, const char *szText)
+{
+   DiagOutput_Append(pMe, szText, strlen(szText));
+}
+
+
+/* Two digits at a time halves the number of divisions */
+static const char s_szDigitPairs[] =
+   "0001020304050607080910111213141516171819"
+   "2021222324252627282930313233343536373839"
+   "4041424344454647484950515253545556575859"
+   "6061626364656667686970717273747576777879"
+   "8081828384858687888990919293949596979899";
+
+static const char s_szHexDigits[] = "0123456789abcdef";
+
+
+static void
+Diag_AppendUInt(DiagOutput *pOut, uint64_t uNum)
+{
+   char     szBuf[20]; /* UINT64_MAX is 20 digits */
+   char    *pStart;
+   unsigned uPair;
+
+   pStart = szBuf + sizeof(szBuf);
+   while(uNum >= 100) {
+      uPair = (unsigned)(uNum % 100);
+      uNum /= 100;
+      pStart -= 2;
+      memcpy(pStart, &s_szDigitPairs[uPair * 2], 2);
+   }
+   if(uNum >= 10) {
+      pStart -= 2;
+      memcpy(pStart, &s_szDigitPairs[uNum * 2], 2);
+   } else {
+      *--pStart = (char)('0' + uNum);
+   }
+
+   DiagOutput_Append(pOut, pStart, (size_t)(szBuf + sizeof(szBuf) - pStart));
+}
+
+
+/* Outputs _0, _1, _2 or _3 for heads with a 1, 2, 4 or 8-byte
+ * argument. For floats this comes out as _1 for half, _2 for single
+ * and _3 for double-precision as it should. */
+static void
+Diag_AppendIndicator(DiagOutput *pOut, int nAdditionalInfo)
+{
+   char szIndicator[2];
+
+   if(!(pOut->uOptions & QCBOR_DIAG_ENCODING_INDICATORS) ||
+      nAdditionalInfo < LEN_IS_ONE_BYTE ||
+      nAdditionalInfo > LEN_IS_EIGHT_BYTES) {
+      return;
+   }
+
+   szIndicator[0] = '_';
+   szIndicator[1] = (char)('0' + nAdditionalInfo - LEN_IS_ONE_BYTE);
+   DiagOutput_Append(pOut, szIndicator, sizeof(szIndicator));
+}
+
+
+static void
+Diag_AppendHex(DiagOutput *pOut, UsefulBufC Bytes)
+{
+   char           szBuf[DIAG_CHUNK_SIZE];
+   size_t         uBufLen;
+   size_t         uIndex;
+   const uint8_t *pBytes;
+
+   if(pOut->nSuppress) {
+      return;
+   }
+
+   DiagOutput_AppendSZ(pOut, "h'");
+   pBytes = Bytes.ptr;
+   uIndex = 0;
+   while(uIndex < Bytes.len && pOut->uError == QCBOR_SUCCESS) {
+      for(uBufLen = 0; uIndex < Bytes.len && uBufLen < sizeof(szBuf); uIndex++) {
+         szBuf[uBufLen++] = s_szHexDigits[pBytes[uIndex] >> 4];
+         szBuf[uBufLen++] = s_szHexDigits[pBytes[uIndex] & 0x0f];
+      }
+      DiagOutput_Append(pOut, szBuf, uBufLen);
+   }
+   DiagOutput_AppendSZ(pOut, "'");
+}
+
+
+static void
+Diag_AppendText(DiagOutput *pOut, UsefulBufC Text)
+{
+   const uint8_t *pRun;
+   const uint8_t *pCur;
+   const uint8_t *pEnd;
+   char           szEscape[6];
+
+   if(pOut->nSuppress) {
+      return;
+   }
+
+   DiagOutput_AppendSZ(pOut, "\"");
+   pRun = Text.ptr;
+   pEnd = pRun + Text.len;
+   for(pCur = pRun; pCur < pEnd; pCur++) {
+      if(*pCur != '"' && *pCur != '\\' && *pCur >= 0x20 && *pCur != 0x7f) {
+         continue;
+      }
+      /* Output everything before the character to be escaped in one go */
+      DiagOutput_Append(pOut, (const char *)pRun, (size_t)(pCur - pRun));
+      if(*pCur == '"' || *pCur == '\\') {
+         szEscape[0] = '\\';
+         szEscape[1] = (char)*pCur;
+         DiagOutput_Append(pOut, szEscape, 2);
+      } else {
+         memcpy(szEscape, "\\u00", 4);
+         szEscape[4] = s_szHexDigits[*pCur >> 4];
+         szEscape[5] = s_szHexDigits[*pCur & 0x0f];
+         DiagOutput_Append(pOut, szEscape, 6);
+      }
+      pRun = pCur + 1;
+   }
+   DiagOutput_Append(pOut, (const char *)pRun, (size_t)(pEnd - pRun));
+   DiagOutput_AppendSZ(pOut, "\"");
+}
+
+
+/* Big enough for the largest value that comes up when outputting a
+ * double, which is a little over 2^1080 for the smallest
+ * subnormal. */
+#define DIAG_BIG_LIMBS 36
+
+typedef struct {
+   uint32_t auLimb[DIAG_BIG_LIMBS]; /* Least significant first */
+   int      nLen;                   /* Limbs in use, top one non-zero */
+} DiagBigNum;
+
+
+static void
+DiagBig_SetUInt64(DiagBigNum *pMe, uint64_t uValue)
+{
+   pMe->auLimb[0] = (uint32_t)uValue;
+   pMe->auLimb[1] = (uint32_t)(uValue >> 32);
+   pMe->nLen      = pMe->auLimb[1] ? 2 : (pMe->auLimb[0] ? 1 : 0);
+}
+
+
+static void
+DiagBig_ShiftLeft(DiagBigNum *pMe, int nShift)
+{
+   const int nLimbs = nShift / 32;
+   const int nBits  = nShift % 32;
+   uint32_t  uHigh;
+   uint32_t  uLow;
+   int       i;
+
+   if(pMe->nLen == 0) {
+      return;
+   }
+
+   /* Goes from the top down so nothing is overwritten before it is
+    * used. */
+   for(i = pMe->nLen; i >= 0; i--) {
+      uHigh = i < pMe->nLen ? pMe->auLimb[i] : 0;
+      uLow  = i > 0 ? pMe->auLimb[i-1] : 0;
+      pMe->auLimb[i + nLimbs] = nBits ? (uHigh << nBits) | (uLow >> (32 - nBits)) : uHigh;
+   }
+   for(i = 0; i < nLimbs; i++) {
+      pMe->auLimb[i] = 0;
+   }
+
+   pMe->nLen += nLimbs + 1;
+   while(pMe->nLen > 0 && pMe->auLimb[pMe->nLen - 1] == 0) {
+      pMe->nLen--;
+   }
+}
+
+
+static void
+DiagBig_MultiplySmall(DiagBigNum *pMe, uint32_t uMultiplier)
+{
+   uint64_t uCarry;
+   int      i;
+
+   uCarry = 0;
+   for(i = 0; i < pMe->nLen; i++) {
+      uCarry += (uint64_t)pMe->auLimb[i] * uMultiplier;
+      pMe->auLimb[i] = (uint32_t)uCarry;
+      uCarry >>= 32;
+   }
+   if(uCarry) {
+      pMe->auLimb[pMe->nLen++] = (uint32_t)uCarry;
+   }
+}
+
+
+static void
+DiagBig_Add(DiagBigNum *pResult, const DiagBigNum *pA, const DiagBigNum *pB)
+{
+   uint64_t  uCarry;
+   int       i;
+   const int nLen = pA->nLen > pB->nLen ? pA->nLen : pB->nLen;
+
+   uCarry = 0;
+   for(i = 0; i < nLen; i++) {
+      uCarry += i < pA->nLen ? pA->auLimb[i] : 0;
+      uCarry += i < pB->nLen ? pB->auLimb[i] : 0;
+      pResult->auLimb[i] = (uint32_t)uCarry;
+      uCarry >>= 32;
+   }
+   pResult->nLen = nLen;
+   if(uCarry) {
+      pResult->auLimb[pResult->nLen++] = (uint32_t)uCarry;
+   }
+}
+
+
+/* Subtracts B from A. A must not be less than B. */
+static void
+DiagBig_Subtract(DiagBigNum *pA, const DiagBigNum *pB)
+{
+   uint64_t uDiff;
+   uint32_t uBorrow;
+   int      i;
+
+   uBorrow = 0;
+   for(i = 0; i < pA->nLen; i++) {
+      uDiff = (uint64_t)pA->auLimb[i] - (i < pB->nLen ? pB->auLimb[i] : 0) - uBorrow;
+      pA->auLimb[i] = (uint32_t)uDiff;
+      uBorrow = (uint32_t)(uDiff >> 63);
+   }
+   while(pA->nLen > 0 && pA->auLimb[pA->nLen - 1] == 0) {
+      pA->nLen--;
+   }
+}
+
+
+static int
+DiagBig_Compare(const DiagBigNum *pA, const DiagBigNum *pB)
+{
+   int i;
+
+   if(pA->nLen != pB->nLen) {
+      return pA->nLen > pB->nLen ? 1 : -1;
+   }
+   for(i = pA->nLen - 1; i >= 0; i--) {
+      if(pA->auLimb[i] != pB->auLimb[i]) {
+         return pA->auLimb[i] > pB->auLimb[i] ? 1 : -1;
+      }
+   }
+   return 0;
+}
+
+
+/**
+ * @brief Output a finite non-zero float as shortest decimal.
+ *
+ * @param[in] pOut            The output.
+ * @param[in] bNegative       The sign.
+ * @param[in] uMantissa       The mantissa with the hidden bit.
+ * @param[in] nExponent       The value is uMantissa * 2 ^ nExponent.
+ * @param[in] bUnequalGaps    True when the mantissa is a power of two
+ *                            and the gap to the next value down is half
+ *                            of the gap to the next value up.
+ *
+ * The digits are generated until they are within half the gap to the
+ * neighbouring values which gives the shortest output that converts
+ * back to the same value. When the mantissa is even, a value exactly
+ * half way to a neighbour is close enough because reading it back
+ * rounds to even.
+ *
+ * The digit string is output as plain decimal like "123.5" or
+ * "0.00025" when that is reasonably short, and with an exponent like
+ * "1.5e+300" otherwise. There is always a decimal point so floats can
+ * be told from integers.
+ */
+static void
+Diag_AppendFloat(DiagOutput *pOut,
+                 bool        bNegative,
+                 uint64_t    uMantissa,
+                 int         nExponent,
+                 bool        bUnequalGaps)
+{
+   DiagBigNum R;      /* Remainder, the value scaled */
+   DiagBigNum S;      /* Scale, the weight of the current digit */
+   DiagBigNum MPlus;  /* Half the gap to the next value up, scaled */
+   DiagBigNum MMinus; /* Half the gap to the next value down, scaled */
+   DiagBigNum Tmp;
+   char       szDigits[24]; /* A double never needs more than 17 */
+   int        nDigits;
+   int        nK;            /* Value is 0.ddd * 10 ^ nK */
+   int        nDigit;
+   bool       bLow;
+   bool       bHigh;
+   int        nInclusive;    /* 1 if half way counts as close enough */
+   char       szBuf[32];
+   size_t     uLen;
+   int        i;
+
+   if(pOut->nSuppress) {
+      return;
+   }
+
+   nInclusive = (uMantissa & 1) == 0;
+
+   /* Set up R / S = value and MPlus / S, MMinus / S = half gaps */
+   DiagBig_SetUInt64(&R, uMantissa);
+   if(nExponent >= 0) {
+      DiagBig_SetUInt64(&S, bUnequalGaps ? 4 : 2);
+      DiagBig_ShiftLeft(&R, nExponent + (bUnequalGaps ? 2 : 1));
+      DiagBig_SetUInt64(&MMinus, 1);
+      DiagBig_ShiftLeft(&MMinus, nExponent);
+   } else {
+      DiagBig_SetUInt64(&S, 1);
+      DiagBig_ShiftLeft(&S, (bUnequalGaps ? 2 : 1) - nExponent);
+      DiagBig_ShiftLeft(&R, bUnequalGaps ? 2 : 1);
+      DiagBig_SetUInt64(&MMinus, 1);
+   }
+   MPlus = MMinus;
+   if(bUnequalGaps) {
+      DiagBig_ShiftLeft(&MPlus, 1);
+   }
+
+   /* Scale so the first digit generated is the first significant
+    * digit */
+   nK = 0;
+   for(;;) {
+      DiagBig_Add(&Tmp, &R, &MPlus);
+      if(DiagBig_Compare(&Tmp, &S) < 0) {
+         break;
+      }
+      DiagBig_MultiplySmall(&S, 10);
+      nK++;
+   }
+   for(;;) {
+      DiagBig_Add(&Tmp, &R, &MPlus);
+      DiagBig_MultiplySmall(&Tmp, 10);
+      if(DiagBig_Compare(&Tmp, &S) >= 0) {
+         break;
+      }
+      DiagBig_MultiplySmall(&R, 10);
+      DiagBig_MultiplySmall(&MPlus, 10);
+      DiagBig_MultiplySmall(&MMinus, 10);
+      nK--;
+   }
+
+   /* Generate digits */
+   nDigits = 0;
+   do {
+      DiagBig_MultiplySmall(&R, 10);
+      DiagBig_MultiplySmall(&MPlus, 10);
+      DiagBig_MultiplySmall(&MMinus, 10);
+      for(nDigit = 0; DiagBig_Compare(&R, &S) >= 0; nDigit++) {
+         DiagBig_Subtract(&R, &S);
+      }
+      bLow = DiagBig_Compare(&R, &MMinus) < nInclusive;
+      DiagBig_Add(&Tmp, &R, &MPlus);
+      bHigh = DiagBig_Compare(&Tmp, &S) > -nInclusive;
+      if(bLow && bHigh) {
+         /* Either digit works; pick the one that is closer */
+         DiagBig_Add(&Tmp, &R, &R);
+         if(DiagBig_Compare(&Tmp, &S) >= 0) {
+            nDigit++;
+         }
+      } else if(bHigh) {
+         nDigit++;
+      }
+      szDigits[nDigits++] = (char)('0' + nDigit);
+   } while(!bLow && !bHigh && nDigits < (int)sizeof(szDigits));
+
+   /* Format the digits */
+   uLen = 0;
+   if(bNegative) {
+      szBuf[uLen++] = '-';
+   }
+   if(nK > 0 && nK <= 21) {
+      /* Like 1500.0 or 12.25 */
+      for(i = 0; i < nK; i++) {
+         szBuf[uLen++] = i < nDigits ? szDigits[i] : '0';
+      }
+      szBuf[uLen++] = '.';
+      if(nDigits > nK) {
+         memcpy(szBuf + uLen, szDigits + nK, (size_t)(nDigits - nK));
+         uLen += (size_t)(nDigits - nK);
+      } else {
+         szBuf[uLen++] = '0';
+      }
+      DiagOutput_Append(pOut, szBuf, uLen);
+
+   } else if(nK <= 0 && nK > -6) {
+      /* Like 0.0025 */
+      szBuf[uLen++] = '0';
+      szBuf[uLen++] = '.';
+      for(i = nK; i < 0; i++) {
+         szBuf[uLen++] = '0';
+      }
+      memcpy(szBuf + uLen, szDigits, (size_t)nDigits);
+      uLen += (size_t)nDigits;
+      DiagOutput_Append(pOut, szBuf, uLen);
+
+   } else {
+      /* Like 1.5e+300 */
+      szBuf[uLen++] = szDigits[0];
+      szBuf[uLen++] = '.';
+      if(nDigits > 1) {
+         memcpy(szBuf + uLen, szDigits + 1, (size_t)(nDigits - 1));
+         uLen += (size_t)(nDigits - 1);
+      } else {
+         szBuf[uLen++] = '0';
+      }
+      szBuf[uLen++] = 'e';
+      szBuf[uLen++] = nK > 0 ? '+' : '-';
+      DiagOutput_Append(pOut, szBuf, uLen);
+      Diag_AppendUInt(pOut, (uint64_t)(nK > 0 ? nK - 1 : 1 - nK));
+   }
+}
+
+
+/* Break a half, single or double-precision float into its parts
+ * and output it. */
+static void
+Diag_AppendFloatBits(DiagOutput *pOut, int nAdditionalInfo, uint64_t uBits)
+{
+   int      nMantissaBits;
+   int      nExponentBits;
+   int      nBias;
+   int      nBiasedExponent;
+   uint64_t uMantissa;
+   bool     bNegative;
+
+   switch(nAdditionalInfo) {
+      case HALF_PREC_FLOAT:   nMantissaBits = 10; nExponentBits = 5;  break;
+      case SINGLE_PREC_FLOAT: nMantissaBits = 23; nExponentBits = 8;  break;
+      default:                nMantissaBits = 52; nExponentBits = 11; break;
+   }
+
+   nBias           = (1 << (nExponentBits - 1)) - 1;
+   bNegative       = (uBits >> (nMantissaBits + nExponentBits)) & 1;
+   uMantissa       = uBits & ((UINT64_C(1) << nMantissaBits) - 1);
+   nBiasedExponent = (int)(uBits >> nMantissaBits) & ((1 << nExponentBits) - 1);
+
+   if(nBiasedExponent == (1 << nExponentBits) - 1) {
+      DiagOutput_AppendSZ(pOut, uMantissa ? "NaN" : (bNegative ? "-Infinity" : "Infinity"));
+   } else if(nBiasedExponent == 0 && uMantissa == 0) {
+      DiagOutput_AppendSZ(pOut, bNegative ? "-0.0" : "0.0");
+   } else if(nBiasedExponent == 0) {
+      /* Subnormal */
+      Diag_AppendFloat(pOut,
+                       bNegative,
+                       uMantissa,
+                       1 - nBias - nMantissaBits,
+                       false);
+   } else {
+      Diag_AppendFloat(pOut,
+                       bNegative,
+                       uMantissa | (UINT64_C(1) << nMantissaBits),
+                       nBiasedExponent - nBias - nMantissaBits,
+                       uMantissa == 0 && nBiasedExponent > 1);
+   }
+   Diag_AppendIndicator(pOut, nAdditionalInfo);
+}
+
+
+static void
+Diag_AppendClose(DiagOutput *pOut, uint8_t uMajorType)
+{
+   switch(uMajorType) {
+      case CBOR_MAJOR_TYPE_ARRAY: DiagOutput_AppendSZ(pOut, "]"); break;
+      case CBOR_MAJOR_TYPE_MAP:   DiagOutput_AppendSZ(pOut, "}"); break;
+      default:                    DiagOutput_AppendSZ(pOut, ")"); break;
+   }
+}
+
+
+/**
+ * @brief Output a CBOR sequence as diagnostic notation.
+ *
+ * @param[in] pOut     The output.
+ * @param[in] pInBuf   The encoded CBOR. All of it is output.
+ * @param[in] pLevels  The stack of levels.
+ * @param[in] nBase    The level of the items in the sequence.
+ *
+ * @return The first error found in the input, or the output error.
+ *
+ * Levels above @c nBase in @c pLevels are used for nesting. Items
+ * at @c nBase are separated by ", ".
+ */
+static QCBORError
+Diag_Sequence(DiagOutput     *pOut,
+              UsefulInputBuf *pInBuf,
+              DiagLevel      *pLevels,
+              int             nBase)
+{
+   QCBORError     uReturn;
+   int            nLevel;
+   int            nMajorType;
+   int            nAdditionalInfo;
+   uint64_t       uArgument;
+   DiagLevel     *pLevel;
+   bool           bOpen;
+   bool           bFirst;
+   UsefulBufC     String;
+   UsefulInputBuf Embedded;
+
+   nLevel = nBase;
+   bFirst = true;
+   for(;;) {
+      if(nLevel == nBase && UsefulInputBuf_BytesUnconsumed(pInBuf) == 0) {
+         break;
+      }
+
+      uReturn = DecodeHead(pInBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+      pLevel = &pLevels[nLevel];
+
+      if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == LEN_IS_INDEFINITE) {
+         /* A break must close an indefinite-length array, map or
+          * string and a map must not be left with a label and no
+          * value. */
+         if(nLevel == nBase ||
+            !pLevel->bIndefinite ||
+            (pLevel->uMajorType == CBOR_MAJOR_TYPE_MAP && pLevel->uCountDone % 2)) {
+            uReturn = QCBOR_ERR_BAD_BREAK;
+            goto Done;
+         }
+         Diag_AppendClose(pOut, pLevel->uMajorType);
+         nLevel--;
+         goto ItemDone;
+      }
+
+      /* The separator that goes before this item */
+      if(nLevel == nBase) {
+         if(!bFirst) {
+            DiagOutput_AppendSZ(pOut, ", ");
+         }
+         bFirst = false;
+      } else if(pLevel->uMajorType == CBOR_MAJOR_TYPE_MAP && pLevel->uCountDone % 2) {
+         DiagOutput_AppendSZ(pOut, ": ");
+      } else if(pLevel->uCountDone && pLevel->uMajorType != CBOR_MAJOR_TYPE_TAG) {
+         DiagOutput_AppendSZ(pOut, ", ");
+      }
+
+      if(nLevel != nBase &&
+         pLevel->bIndefinite &&
+         (pLevel->uMajorType == CBOR_MAJOR_TYPE_BYTE_STRING ||
+          pLevel->uMajorType == CBOR_MAJOR_TYPE_TEXT_STRING)) {
+         /* Chunks must be definite-length strings of the same type */
+         if(nMajorType != pLevel->uMajorType || nAdditionalInfo == LEN_IS_INDEFINITE) {
+            uReturn = QCBOR_ERR_INDEFINITE_STRING_CHUNK;
+            goto Done;
+         }
+      }
+
+      if(nAdditionalInfo == LEN_IS_INDEFINITE &&
+         (nMajorType == CBOR_MAJOR_TYPE_POSITIVE_INT ||
+          nMajorType == CBOR_MAJOR_TYPE_NEGATIVE_INT ||
+          nMajorType == CBOR_MAJOR_TYPE_TAG)) {
+         /* As DecodeInteger() and tag decoding do */
+         uReturn = QCBOR_ERR_BAD_INT;
+         goto Done;
+      }
+
+      bOpen = false;
+      switch(nMajorType) {
+         case CBOR_MAJOR_TYPE_POSITIVE_INT:
+            Diag_AppendUInt(pOut, uArgument);
+            Diag_AppendIndicator(pOut, nAdditionalInfo);
+            break;
+
+         case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+            DiagOutput_AppendSZ(pOut, "-");
+            if(uArgument == UINT64_MAX) {
+               /* -1 - UINT64_MAX doesn't fit in 64 bits */
+               DiagOutput_AppendSZ(pOut, "18446744073709551616");
+            } else {
+               Diag_AppendUInt(pOut, uArgument + 1);
+            }
+            Diag_AppendIndicator(pOut, nAdditionalInfo);
+            break;
+
+         case CBOR_MAJOR_TYPE_BYTE_STRING:
+         case CBOR_MAJOR_TYPE_TEXT_STRING:
+            if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+               DiagOutput_AppendSZ(pOut, "(_ ");
+               bOpen = true;
+               break;
+            }
+            if(uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+               uReturn = QCBOR_ERR_HIT_END;
+               goto Done;
+            }
+            String = UsefulInputBuf_GetUsefulBuf(pInBuf, (size_t)uArgument);
+            if(nMajorType == CBOR_MAJOR_TYPE_TEXT_STRING) {
+               Diag_AppendText(pOut, String);
+            } else if((pOut->uOptions & QCBOR_DIAG_EMBEDDED_CBOR) &&
+                      !pOut->nSuppress &&
+                      String.len > 0 &&
+                      nLevel < QCBOR_DIAG_MAX_NESTING) {
+               /* Check first with output suppressed */
+               pOut->nSuppress++;
+               UsefulInputBuf_Init(&Embedded, String);
+               uReturn = Diag_Sequence(pOut, &Embedded, pLevels, nLevel + 1);
+               pOut->nSuppress--;
+               if(uReturn == QCBOR_SUCCESS) {
+                  DiagOutput_AppendSZ(pOut, "<<");
+                  UsefulInputBuf_Init(&Embedded, String);
+                  uReturn = Diag_Sequence(pOut, &Embedded, pLevels, nLevel + 1);
+                  if(uReturn != QCBOR_SUCCESS) {
+                     goto Done;
+                  }
+                  DiagOutput_AppendSZ(pOut, ">>");
+               } else {
+                  Diag_AppendHex(pOut, String);
+               }
+            } else {
+               Diag_AppendHex(pOut, String);
+            }
+            Diag_AppendIndicator(pOut, nAdditionalInfo);
+            break;
+
+         case CBOR_MAJOR_TYPE_ARRAY:
+         case CBOR_MAJOR_TYPE_MAP:
+            DiagOutput_AppendSZ(pOut, nMajorType == CBOR_MAJOR_TYPE_ARRAY ? "[" : "{");
+            if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+               DiagOutput_AppendSZ(pOut, "_ ");
+            } else if((pOut->uOptions & QCBOR_DIAG_ENCODING_INDICATORS) &&
+                      nAdditionalInfo >= LEN_IS_ONE_BYTE) {
+               Diag_AppendIndicator(pOut, nAdditionalInfo);
+               DiagOutput_AppendSZ(pOut, " ");
+            }
+            bOpen = true;
+            break;
+
+         case CBOR_MAJOR_TYPE_TAG:
+            Diag_AppendUInt(pOut, uArgument);
+            Diag_AppendIndicator(pOut, nAdditionalInfo);
+            DiagOutput_AppendSZ(pOut, "(");
+            bOpen = true;
+            break;
+
+         case CBOR_MAJOR_TYPE_SIMPLE:
+            if(nAdditionalInfo >= HALF_PREC_FLOAT) {
+               Diag_AppendFloatBits(pOut, nAdditionalInfo, uArgument);
+               break;
+            }
+            if(nAdditionalInfo == LEN_IS_ONE_BYTE && uArgument < 32) {
+               /* Simple values less than 32 must be in the initial byte */
+               uReturn = QCBOR_ERR_BAD_TYPE_7;
+               goto Done;
+            }
+            switch(uArgument) {
+               case CBOR_SIMPLEV_FALSE: DiagOutput_AppendSZ(pOut, "false");     break;
+               case CBOR_SIMPLEV_TRUE:  DiagOutput_AppendSZ(pOut, "true");      break;
+               case CBOR_SIMPLEV_NULL:  DiagOutput_AppendSZ(pOut, "null");      break;
+               case CBOR_SIMPLEV_UNDEF: DiagOutput_AppendSZ(pOut, "undefined"); break;
+               default:
+                  DiagOutput_AppendSZ(pOut, "simple(");
+                  Diag_AppendUInt(pOut, uArgument);
+                  DiagOutput_AppendSZ(pOut, ")");
+                  break;
+            }
+            Diag_AppendIndicator(pOut, nAdditionalInfo);
+            break;
+      }
+
+      if(bOpen) {
+         if(nLevel >= QCBOR_DIAG_MAX_NESTING) {
+            uReturn = QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP;
+            goto Done;
+         }
+         nLevel++;
+         pLevel = &pLevels[nLevel];
+         pLevel->uMajorType  = (uint8_t)nMajorType;
+         pLevel->bIndefinite = nAdditionalInfo == LEN_IS_INDEFINITE;
+         pLevel->uCount      = nMajorType == CBOR_MAJOR_TYPE_TAG ? 1 : uArgument;
+         pLevel->uCountDone  = 0;
+         if(pLevel->bIndefinite || pLevel->uCount != 0) {
+            continue;
+         }
+         /* Empty definite-length array or map closes right away */
+         Diag_AppendClose(pOut, pLevel->uMajorType);
+         nLevel--;
+      }
+
+   ItemDone:
+      /* Count the item and close all levels it completes */
+      while(nLevel != nBase) {
+         pLevel = &pLevels[nLevel];
+         pLevel->uCountDone++;
+         if(pLevel->bIndefinite) {
+            break;
+         }
+         if(pLevel->uMajorType == CBOR_MAJOR_TYPE_MAP) {
+            if(pLevel->uCountDone % 2 || pLevel->uCountDone / 2 != pLevel->uCount) {
+               break;
+            }
+         } else if(pLevel->uCountDone != pLevel->uCount) {
+            break;
+         }
+         Diag_AppendClose(pOut, pLevel->uMajorType);
+         nLevel--;
+      }
+
+      if(pOut->uError != QCBOR_SUCCESS) {
+         uReturn = pOut->uError;
+         goto Done;
+      }
+   }
+
+   uReturn = QCBOR_SUCCESS;
+
+Done:
+   return uReturn;
+}
+
+
+/*
+ * Public function. See qcbor_diag.h
+ */
+QCBORError
+QCBORDecode_ToDiagWithWriter(UsefulBufC      EncodedCBOR,
+                             uint32_t        uOptions,
+                             size_t          uMaxLen,
+                             QCBORDiagWriter pfWriter,
+                             void           *pWriterCtx)
+{
+   QCBORError     uReturn;
+   DiagOutput     Out;
+   DiagLevel      aLevels[QCBOR_DIAG_MAX_NESTING + 1];
+   UsefulInputBuf InBuf;
+
+   Out.pfWriter   = pfWriter;
+   Out.pWriterCtx = pWriterCtx;
+   Out.uMaxLen    = uMaxLen;
+   Out.uTotalLen  = 0;
+   Out.uOptions   = uOptions;
+   Out.nSuppress  = 0;
+   Out.uError     = QCBOR_SUCCESS;
+   Out.uChunkLen  = 0;
+
+   UsefulInputBuf_Init(&InBuf, EncodedCBOR);
+   uReturn = Diag_Sequence(&Out, &InBuf, aLevels, 0);
+
+   /* Output what there is, even on error, as it helps with
+    * debugging. */
+   DiagOutput_Flush(&Out);
+   if(uReturn == QCBOR_SUCCESS) {
+      uReturn = Out.uError;
+   }
+
+   return uReturn;
+}
+
+
+static QCBORError
+Diag_OutBufWriter(void *pWriterCtx, UsefulBufC Text)
+{
+   UsefulOutBuf *pOutBuf = (UsefulOutBuf *)pWriterCtx;
+
+   UsefulOutBuf_AppendUsefulBuf(pOutBuf, Text);
+   return UsefulOutBuf_GetError(pOutBuf) ? QCBOR_ERR_BUFFER_TOO_SMALL : QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function. See qcbor_diag.h
+ */
+QCBORError
+QCBORDecode_ToDiag(UsefulBufC  EncodedCBOR,
+                   uint32_t    uOptions,
+                   UsefulBuf   Buffer,
+                   UsefulBufC *pDiag)
+{
+   QCBORError   uReturn;
+   UsefulOutBuf OutBuf;
+
+   UsefulOutBuf_Init(&OutBuf, Buffer);
+   uReturn = QCBORDecode_ToDiagWithWriter(EncodedCBOR,
+                                          uOptions,
+                                          Buffer.len,
+                                          Diag_OutBufWriter,
+                                          &OutBuf);
+   *pDiag = UsefulOutBuf_OutUBuf(&OutBuf);
+
+   return uReturn;
+}
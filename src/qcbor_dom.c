@@ -0,0 +1,519 @@
+/*==============================================================================
+ qcbor_dom.c -- Decoding into a tree of nodes in a caller arena
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_dom.h"
+#include "qcbor_decode_private.h"
+
+
+/**
+ * @file qcbor_dom.c
+ *
+ * This implements QCBORDom_Build() and the look ups on the tree. The
+ * walk over the input is the same as Sax's, but instead of calling
+ * functions each item is written to the next node. An array or map
+ * gets its uNext and uCount when it is closed.
+ *
+ * The sorted labels for maps are put in nodes at the end of the
+ * arena, working down, so one arena holds both and neither size has
+ * to be known ahead. They are offsets from the map node rather than
+ * indexes in the arena so the look ups don't need the arena.
+ */
+
+
+typedef struct {
+   /* Items left for definite length or items so far for indefinite */
+   uint32_t uItems;
+   uint32_t uNode;  /* The array or map node */
+   uint16_t uCount; /* Items or pairs, once known */
+   uint8_t  uType;  /* QCBOR_TYPE_ARRAY or QCBOR_TYPE_MAP */
+   bool     bIndefinite;
+} DomLevel;
+
+
+static uint32_t *
+Dom_SortedEntry(QCBORDomNode *pIndex, uint32_t uEntry)
+{
+   return &pIndex[uEntry / QCBOR_DOM_SORTED_PER_NODE].val.auSorted[uEntry % QCBOR_DOM_SORTED_PER_NODE];
+}
+
+
+static int
+Dom_LabelRank(uint8_t uDataType)
+{
+   switch(uDataType) {
+      case QCBOR_TYPE_INT64:       return 0;
+      case QCBOR_TYPE_UINT64:      return 1;
+      case QCBOR_TYPE_TEXT_STRING: return 2;
+      case QCBOR_TYPE_BYTE_STRING: return 3;
+      default:                     return 4;
+   }
+}
+
+
+/* Order of labels for sorting and binary search. Integers come first
+ * in numeric order, then text strings, then byte strings, each
+ * ordered by UsefulBuf_Compare(). Labels of other types compare equal
+ * to each other and can only be found by linear search. */
+static int
+Dom_CompareLabels(const QCBORDomNode *pA, const QCBORDomNode *pB)
+{
+   const int nRankA = Dom_LabelRank(pA->uDataType);
+   const int nRankB = Dom_LabelRank(pB->uDataType);
+
+   if(nRankA != nRankB) {
+      return nRankA < nRankB ? -1 : 1;
+   }
+
+   switch(pA->uDataType) {
+      case QCBOR_TYPE_INT64:
+         return pA->val.int64 < pB->val.int64 ? -1 : pA->val.int64 > pB->val.int64;
+
+      case QCBOR_TYPE_UINT64:
+         return pA->val.uint64 < pB->val.uint64 ? -1 : pA->val.uint64 > pB->val.uint64;
+
+      case QCBOR_TYPE_TEXT_STRING:
+      case QCBOR_TYPE_BYTE_STRING:
+         return UsefulBuf_Compare(pA->val.string, pB->val.string);
+
+      default:
+         return 0;
+   }
+}
+
+
+/* Move entry uRoot down the heap of the first uEnd entries until
+ * neither child is greater */
+static void
+Dom_SiftDown(QCBORDomNode *pMap, QCBORDomNode *pIndex, uint32_t uRoot, uint32_t uEnd)
+{
+   uint32_t uChild;
+   uint32_t uTemp;
+
+   while((uChild = 2 * uRoot + 1) < uEnd) {
+      if(uChild + 1 < uEnd &&
+         Dom_CompareLabels(pMap + *Dom_SortedEntry(pIndex, uChild),
+                           pMap + *Dom_SortedEntry(pIndex, uChild + 1)) < 0) {
+         uChild++;
+      }
+      if(Dom_CompareLabels(pMap + *Dom_SortedEntry(pIndex, uRoot),
+                           pMap + *Dom_SortedEntry(pIndex, uChild)) >= 0) {
+         break;
+      }
+      uTemp = *Dom_SortedEntry(pIndex, uRoot);
+      *Dom_SortedEntry(pIndex, uRoot)  = *Dom_SortedEntry(pIndex, uChild);
+      *Dom_SortedEntry(pIndex, uChild) = uTemp;
+      uRoot = uChild;
+   }
+}
+
+
+/* Fill in the index of the labels of the map and sort it. This is a
+ * heap sort rather than the insertion sort used by
+ * QCBOREncode_CloseAndSortMap() so large maps in the input can't make
+ * it slow. */
+static void
+Dom_SortMap(QCBORDomNode *pMap, QCBORDomNode *pIndex)
+{
+   const QCBORDomNode *pLabel;
+   uint32_t            uEntry;
+   uint32_t            uTemp;
+
+   pLabel = pMap + 1;
+   for(uEntry = 0; uEntry < pMap->uCount; uEntry++) {
+      /* Cast is safe because the map and its labels are in one arena
+       * of at most UINT32_MAX nodes */
+      *Dom_SortedEntry(pIndex, uEntry) = (uint32_t)(pLabel - pMap);
+      pLabel = QCBORDom_Next(QCBORDom_Next(pLabel));
+   }
+
+   for(uEntry = pMap->uCount / 2; uEntry > 0; uEntry--) {
+      Dom_SiftDown(pMap, pIndex, uEntry - 1, pMap->uCount);
+   }
+   for(uEntry = pMap->uCount; uEntry > 1; uEntry--) {
+      uTemp = *Dom_SortedEntry(pIndex, 0);
+      *Dom_SortedEntry(pIndex, 0) = *Dom_SortedEntry(pIndex, uEntry - 1);
+      *Dom_SortedEntry(pIndex, uEntry - 1) = uTemp;
+      Dom_SiftDown(pMap, pIndex, 0, uEntry - 1);
+   }
+}
+
+
+/* Decode an integer, major type 7 item or string into a node */
+static QCBORError
+Dom_Value(UsefulInputBuf *pInBuf,
+          int             nMajorType,
+          int             nAdditionalInfo,
+          uint64_t        uArgument,
+          QCBORDomNode   *pNode)
+{
+   QCBORError uReturn;
+   QCBORItem  Value;
+
+   switch(nMajorType) {
+      case CBOR_MAJOR_TYPE_BYTE_STRING:
+      case CBOR_MAJOR_TYPE_TEXT_STRING:
+         if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+            /* Chunks would have to be put together in memory */
+            return QCBOR_ERR_NO_STRING_ALLOCATOR;
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+            return QCBOR_ERR_INDEF_LEN_STRINGS_DISABLED;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+         }
+         pNode->uDataType = nMajorType == CBOR_MAJOR_TYPE_BYTE_STRING ?
+                               QCBOR_TYPE_BYTE_STRING : QCBOR_TYPE_TEXT_STRING;
+         return QCBORDecode_Private_GetBytes(pInBuf, uArgument, &pNode->val.string);
+
+      case CBOR_MAJOR_TYPE_SIMPLE:
+         uReturn = DecodeType7(nAdditionalInfo, uArgument, &Value);
+         break;
+
+      default:
+         if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+            return QCBOR_ERR_BAD_INT;
+         }
+         uReturn = DecodeInteger(nMajorType, uArgument, &Value);
+         break;
+   }
+   if(uReturn != QCBOR_SUCCESS) {
+      return uReturn;
+   }
+
+   /* Only uDataType and val are filled in by the decode functions */
+   pNode->uDataType = Value.uDataType;
+   switch(Value.uDataType) {
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+      case QCBOR_TYPE_DOUBLE:
+         pNode->val.dfnum = Value.val.dfnum;
+         break;
+
+#ifdef QCBOR_DISABLE_FLOAT_HW_USE
+      /* Single precision is only left as a float without float HW use */
+      case QCBOR_TYPE_FLOAT:
+         pNode->val.fnum = Value.val.fnum;
+         break;
+#endif /* QCBOR_DISABLE_FLOAT_HW_USE */
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+      case QCBOR_TYPE_UKNOWN_SIMPLE:
+         pNode->val.uSimple = Value.val.uSimple;
+         break;
+
+      default:
+         /* Integers. For true, false, null and undef, val isn't used. */
+         pNode->val.uint64 = Value.val.uint64;
+         break;
+   }
+   return QCBOR_SUCCESS;
+}
+
+
+/* Close an array or map: fill in its uNext and count and, if maps are
+ * sorted, take nodes from the end for the labels and sort them. */
+static QCBORError
+Dom_Close(const DomLevel *pLevel,
+          QCBORDomNode   *pArena,
+          uint32_t        uSize,
+          uint32_t        uOptions,
+          uint32_t        uNodes,
+          uint32_t       *puIndexNodes)
+{
+   QCBORDomNode *pNode;
+   uint32_t      uNeeded;
+
+   uNeeded = 0;
+   if(pLevel->uType == QCBOR_TYPE_MAP && (uOptions & QCBOR_DOM_SORT_MAPS)) {
+      uNeeded = ((uint32_t)pLevel->uCount + QCBOR_DOM_SORTED_PER_NODE - 1) / QCBOR_DOM_SORTED_PER_NODE;
+      /* uNodes + *puIndexNodes is never more than uSize */
+      if(uNeeded > uSize - uNodes - *puIndexNodes) {
+         return QCBOR_ERR_BUFFER_TOO_SMALL;
+      }
+      *puIndexNodes += uNeeded;
+   }
+
+   if(pArena != NULL) {
+      pNode = &pArena[pLevel->uNode];
+      pNode->uNext  = uNodes - pLevel->uNode;
+      pNode->uCount = pLevel->uCount;
+      if(uNeeded > 0) {
+         pNode->val.uSorted = uSize - *puIndexNodes - pLevel->uNode;
+         Dom_SortMap(pNode, pNode + pNode->val.uSorted);
+      }
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_dom.h file
+ */
+QCBORError
+QCBORDom_Build(UsefulBufC    Encoded,
+               QCBORDomNode *pArena,
+               size_t        uArenaSize,
+               uint32_t      uOptions,
+               size_t       *puNodesUsed)
+{
+   QCBORError     uReturn;
+   UsefulInputBuf InBuf;
+   int            nMajorType;
+   int            nAdditionalInfo;
+   uint64_t       uArgument;
+   int            nDepth;
+   uint64_t       uTagNumber;
+   uint32_t       uNodes;      /* Nodes used from the start */
+   uint32_t       uIndexNodes; /* Nodes used from the end for sorting */
+   uint32_t       uSize;
+   QCBORDomNode  *pNode;
+   QCBORDomNode   CountOnly;
+   DomLevel       aLevels[QCBOR_MAX_ARRAY_NESTING];
+
+   uNodes      = 0;
+   uIndexNodes = 0;
+
+   if(Encoded.len > QCBOR_MAX_DECODE_INPUT_SIZE) {
+      uReturn = QCBOR_ERR_INPUT_TOO_LARGE;
+      goto Done;
+   }
+   UsefulInputBuf_Init(&InBuf, Encoded);
+
+   /* Offsets between nodes are 32 bits. An arena can't usefully be
+    * bigger than this as the input is less than 4GB. */
+   if(pArena == NULL || uArenaSize > UINT32_MAX) {
+      uSize = UINT32_MAX;
+   } else {
+      uSize = (uint32_t)uArenaSize;
+   }
+
+   nDepth     = 0;
+   uTagNumber = CBOR_TAG_INVALID64;
+   while(1) {
+      /* Close the definite-length arrays and maps that are complete */
+      while(nDepth > 0 &&
+            !aLevels[nDepth-1].bIndefinite &&
+            aLevels[nDepth-1].uItems == 0) {
+         nDepth--;
+         uReturn = Dom_Close(&aLevels[nDepth], pArena, uSize, uOptions, uNodes, &uIndexNodes);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+      }
+
+      if(nDepth == 0 && uNodes > 0) {
+         /* The one item is complete */
+         uReturn = UsefulInputBuf_BytesUnconsumed(&InBuf) == 0 ?
+                      QCBOR_SUCCESS : QCBOR_ERR_EXTRA_BYTES;
+         goto Done;
+      }
+
+      uReturn = DecodeHead(&InBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+
+      if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == LEN_IS_INDEFINITE) {
+         /* A break must end an indefinite-length array or map, and a
+          * map only after a value. */
+         if(uTagNumber != CBOR_TAG_INVALID64 ||
+            nDepth == 0 ||
+            !aLevels[nDepth-1].bIndefinite ||
+            (aLevels[nDepth-1].uType == QCBOR_TYPE_MAP && aLevels[nDepth-1].uItems % 2)) {
+            uReturn = QCBOR_ERR_BAD_BREAK;
+            goto Done;
+         }
+         nDepth--;
+         if(aLevels[nDepth].uType == QCBOR_TYPE_MAP) {
+            aLevels[nDepth].uItems /= 2;
+         }
+         if(aLevels[nDepth].uItems > QCBOR_MAX_ITEMS_IN_ARRAY) {
+            uReturn = QCBOR_ERR_ARRAY_DECODE_TOO_LONG;
+            goto Done;
+         }
+         /* Cast is safe because of the check above */
+         aLevels[nDepth].uCount = (uint16_t)aLevels[nDepth].uItems;
+         uReturn = Dom_Close(&aLevels[nDepth], pArena, uSize, uOptions, uNodes, &uIndexNodes);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+         continue;
+      }
+
+      if(nMajorType == CBOR_MAJOR_TYPE_TAG) {
+         if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+            uReturn = QCBOR_ERR_BAD_INT;
+            goto Done;
+         }
+         if(uTagNumber == CBOR_TAG_INVALID64) {
+            uTagNumber = uArgument;
+         }
+         continue;
+      }
+
+      /* Count the item in the enclosing array or map */
+      if(nDepth > 0) {
+         if(aLevels[nDepth-1].bIndefinite) {
+            aLevels[nDepth-1].uItems++;
+         } else {
+            aLevels[nDepth-1].uItems--;
+         }
+      }
+
+      /* uNodes + uIndexNodes is never more than uSize */
+      if(uIndexNodes >= uSize - uNodes) {
+         uReturn = QCBOR_ERR_BUFFER_TOO_SMALL;
+         goto Done;
+      }
+      pNode = pArena != NULL ? &pArena[uNodes] : &CountOnly;
+      pNode->uTagNumber = uTagNumber;
+      pNode->uNext      = 1;
+      pNode->uCount     = 0;
+      pNode->val.uint64 = 0;
+      uTagNumber = CBOR_TAG_INVALID64;
+
+      if(nMajorType == CBOR_MAJOR_TYPE_ARRAY || nMajorType == CBOR_MAJOR_TYPE_MAP) {
+         if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+#ifdef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+            uReturn = QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED;
+            goto Done;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+         } else if(uArgument > QCBOR_MAX_ITEMS_IN_ARRAY) {
+            uReturn = QCBOR_ERR_ARRAY_DECODE_TOO_LONG;
+            goto Done;
+         }
+         if(nDepth >= QCBOR_MAX_ARRAY_NESTING) {
+            uReturn = QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP;
+            goto Done;
+         }
+
+         pNode->uDataType = ConvertArrayOrMapType(nMajorType);
+         aLevels[nDepth].uType       = pNode->uDataType;
+         aLevels[nDepth].uNode       = uNodes;
+         aLevels[nDepth].bIndefinite = nAdditionalInfo == LEN_IS_INDEFINITE;
+         aLevels[nDepth].uItems      = 0;
+         aLevels[nDepth].uCount      = 0;
+         if(!aLevels[nDepth].bIndefinite) {
+            /* Fits because uArgument is at most QCBOR_MAX_ITEMS_IN_ARRAY */
+            aLevels[nDepth].uCount = (uint16_t)uArgument;
+            aLevels[nDepth].uItems = (uint32_t)uArgument;
+            if(nMajorType == CBOR_MAJOR_TYPE_MAP) {
+               aLevels[nDepth].uItems *= 2;
+            }
+         }
+         nDepth++;
+      } else {
+         uReturn = Dom_Value(&InBuf, nMajorType, nAdditionalInfo, uArgument, pNode);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+      }
+      uNodes++;
+   }
+
+Done:
+   if(puNodesUsed != NULL) {
+      *puNodesUsed = uNodes + uIndexNodes;
+   }
+   return uReturn;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_dom.h file
+ */
+const QCBORDomNode *
+QCBORDom_GetInArray(const QCBORDomNode *pArray, uint16_t uIndex)
+{
+   const QCBORDomNode *pItem;
+
+   if(pArray->uDataType != QCBOR_TYPE_ARRAY || uIndex >= pArray->uCount) {
+      return NULL;
+   }
+   pItem = pArray + 1;
+   while(uIndex-- > 0) {
+      pItem = QCBORDom_Next(pItem);
+   }
+   return pItem;
+}
+
+
+/* Binary search if sorted, otherwise look at each label */
+static const QCBORDomNode *
+Dom_GetInMap(const QCBORDomNode *pMap, const QCBORDomNode *pKey)
+{
+   const QCBORDomNode *pIndex;
+   const QCBORDomNode *pLabel;
+   uint32_t            uLow;
+   uint32_t            uHigh;
+   uint32_t            uMid;
+   uint32_t            uEntry;
+   int                 nCompare;
+
+   if(pMap->uDataType != QCBOR_TYPE_MAP) {
+      return NULL;
+   }
+
+   if(pMap->val.uSorted != 0) {
+      pIndex = pMap + pMap->val.uSorted;
+      uLow   = 0;
+      uHigh  = pMap->uCount;
+      while(uLow < uHigh) {
+         uMid   = uLow + (uHigh - uLow) / 2;
+         pLabel = pMap + pIndex[uMid / QCBOR_DOM_SORTED_PER_NODE].val.auSorted[uMid % QCBOR_DOM_SORTED_PER_NODE];
+         nCompare = Dom_CompareLabels(pLabel, pKey);
+         if(nCompare == 0) {
+            return QCBORDom_Next(pLabel);
+         } else if(nCompare < 0) {
+            uLow = uMid + 1;
+         } else {
+            uHigh = uMid;
+         }
+      }
+      return NULL;
+   }
+
+   pLabel = pMap + 1;
+   for(uEntry = 0; uEntry < pMap->uCount; uEntry++) {
+      if(Dom_CompareLabels(pLabel, pKey) == 0) {
+         return QCBORDom_Next(pLabel);
+      }
+      pLabel = QCBORDom_Next(QCBORDom_Next(pLabel));
+   }
+   return NULL;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_dom.h file
+ */
+const QCBORDomNode *
+QCBORDom_GetInMapN(const QCBORDomNode *pMap, int64_t nLabel)
+{
+   QCBORDomNode Key;
+
+   Key.uDataType = QCBOR_TYPE_INT64;
+   Key.val.int64 = nLabel;
+   return Dom_GetInMap(pMap, &Key);
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_dom.h file
+ */
+const QCBORDomNode *
+QCBORDom_GetInMapSZ(const QCBORDomNode *pMap, const char *szLabel)
+{
+   QCBORDomNode Key;
+
+   Key.uDataType  = QCBOR_TYPE_TEXT_STRING;
+   Key.val.string = UsefulBuf_FromSZ(szLabel);
+   return Dom_GetInMap(pMap, &Key);
+}
@@ -34,6 +34,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "qcbor/qcbor_encode.h"
 #include "ieee754.h"
+#include "qcbor_encode_private.h"
 
 
 /**
@@ -121,6 +122,15 @@ Nesting_Increment(QCBORTrackNesting *pNesting)
    return QCBOR_SUCCESS;
 }
 
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
+static inline bool
+Nesting_IsAfterLabel(QCBORTrackNesting *pNesting)
+{
+   /* In a map an odd count means a label was added without its value */
+   return pNesting->pCurrentNesting->uCount & 1 ? true : false;
+}
+#endif /* QCBOR_DISABLE_ENCODE_USAGE_GUARDS */
+
 static inline void
 Nesting_Decrement(QCBORTrackNesting *pNesting)
 {
@@ -154,13 +164,13 @@ Nesting_GetStartPos(QCBORTrackNesting *pNesting)
    return pNesting->pCurrentNesting->uStart;
 }
 
-#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
 static inline uint8_t
 Nesting_GetMajorType(QCBORTrackNesting *pNesting)
 {
    return pNesting->pCurrentNesting->uMajorType;
 }
 
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
 static inline bool
 Nesting_IsInNest(QCBORTrackNesting *pNesting)
 {
@@ -244,6 +254,13 @@ Nesting_IsInNest(QCBORTrackNesting *pNesting)
  * Would generate not-well-formed CBOR
  *   QCBOR_ERR_ENCODE_UNSUPPORTED      -- Simple type between 24 and 31 [1]
  *
+ * Can't sort map entries
+ *   QCBOR_ERR_ENCODE_UNSUPPORTED      -- Indefinite-length item in sorted map
+ *
+ * Can't merge maps
+ *   QCBOR_ERR_ENCODE_UNSUPPORTED      -- Not a map or a map is not open [1]
+ *   QCBOR_ERR_DUPLICATE_LABEL         -- Label in the open map twice
+ *
  * [1] indicated disabled by QCBOR_DISABLE_ENCODE_USAGE_GUARDS
  */
 
@@ -745,6 +762,291 @@ void QCBOREncode_AddType7(QCBOREncodeContext *me, uint8_t uMinLen, uint64_t uNum
 }
 
 
+/* 0000-01-01T00:00:00Z and 9999-12-31T23:59:59Z, the range of RFC 3339 */
+#define DATE_STRING_MIN_SECONDS (-62167219200)
+#define DATE_STRING_MAX_SECONDS 253402300799
+
+
+/*
+ * Write uValue as nDigits decimal digits with leading zeros.
+ */
+static void
+DateString_PutDigits(char *pDest, uint32_t uValue, int nDigits)
+{
+   while(nDigits > 0) {
+      nDigits--;
+      pDest[nDigits] = (char)('0' + uValue % 10);
+      uValue /= 10;
+   }
+}
+
+
+/*
+ * Public function for adding a date string from an epoch date. See
+ * qcbor/qcbor_encode.h
+ *
+ * The calendar date is computed with the civil-from-days algorithm
+ * described by Howard Hinnant, which counts in 400-year eras starting
+ * on March 1 so the leap day is the last day of the year. Counting is
+ * from an era before year 0 so everything is unsigned.
+ */
+void
+QCBOREncode_AddTDateStringFromEpoch(QCBOREncodeContext *pMe,
+                                    uint8_t             uTagRequirement,
+                                    int64_t             nSeconds,
+                                    uint32_t            uNanoseconds,
+                                    int16_t             nOffsetMinutes)
+{
+   /* Longest is "YYYY-MM-DDTHH:MM:SS.nnnnnnnnn+HH:MM" */
+   char     szDate[35];
+   size_t   uLen;
+   int64_t  nLocal;
+   uint64_t uSinceYear0;
+   uint32_t uSecondOfDay;
+   uint32_t uDayOfEra;
+   uint32_t uEra;
+   uint32_t uYearOfEra;
+   uint32_t uDayOfYear;
+   uint32_t uMonthFromMarch;
+   uint32_t uOffset;
+
+   if(uNanoseconds > 999999999 || nOffsetMinutes < -1439 || nOffsetMinutes > 1439) {
+      goto Overflow;
+   }
+   /* Checked before adding the offset so it can't overflow */
+   if(nSeconds < DATE_STRING_MIN_SECONDS - 86400 ||
+      nSeconds > DATE_STRING_MAX_SECONDS + 86400) {
+      goto Overflow;
+   }
+   nLocal = nSeconds + (int64_t)nOffsetMinutes * 60;
+   if(nLocal < DATE_STRING_MIN_SECONDS || nLocal > DATE_STRING_MAX_SECONDS) {
+      goto Overflow;
+   }
+
+   uSinceYear0  = (uint64_t)(nLocal - DATE_STRING_MIN_SECONDS);
+   uSecondOfDay = (uint32_t)(uSinceYear0 % 86400);
+
+   /* Days since March 1 of the year -400. Year 0 is a leap year so
+    * January and February of it are 60 days. */
+   uDayOfEra = (uint32_t)(uSinceYear0 / 86400) - 60 + 146097;
+   uEra      = uDayOfEra / 146097;
+   uDayOfEra = uDayOfEra % 146097;
+
+   uYearOfEra      = (uDayOfEra - uDayOfEra/1460 + uDayOfEra/36524 - uDayOfEra/146096) / 365;
+   uDayOfYear      = uDayOfEra - (365*uYearOfEra + uYearOfEra/4 - uYearOfEra/100);
+   uMonthFromMarch = (5*uDayOfYear + 2) / 153;
+
+   const uint32_t uMonth = uMonthFromMarch < 10 ? uMonthFromMarch + 3 : uMonthFromMarch - 9;
+   const uint32_t uDay   = uDayOfYear - (153*uMonthFromMarch + 2)/5 + 1;
+   const uint32_t uYear  = uYearOfEra + uEra * 400 - 400 + (uMonth <= 2 ? 1 : 0);
+
+   DateString_PutDigits(&szDate[0], uYear, 4);
+   szDate[4] = '-';
+   DateString_PutDigits(&szDate[5], uMonth, 2);
+   szDate[7] = '-';
+   DateString_PutDigits(&szDate[8], uDay, 2);
+   szDate[10] = 'T';
+   DateString_PutDigits(&szDate[11], uSecondOfDay / 3600, 2);
+   szDate[13] = ':';
+   DateString_PutDigits(&szDate[14], (uSecondOfDay / 60) % 60, 2);
+   szDate[16] = ':';
+   DateString_PutDigits(&szDate[17], uSecondOfDay % 60, 2);
+   uLen = 19;
+
+   if(uNanoseconds != 0) {
+      szDate[uLen++] = '.';
+      if(uNanoseconds % 1000000 == 0) {
+         DateString_PutDigits(&szDate[uLen], uNanoseconds / 1000000, 3);
+         uLen += 3;
+      } else if(uNanoseconds % 1000 == 0) {
+         DateString_PutDigits(&szDate[uLen], uNanoseconds / 1000, 6);
+         uLen += 6;
+      } else {
+         DateString_PutDigits(&szDate[uLen], uNanoseconds, 9);
+         uLen += 9;
+      }
+   }
+
+   if(nOffsetMinutes == 0) {
+      szDate[uLen++] = 'Z';
+   } else {
+      if(nOffsetMinutes < 0) {
+         szDate[uLen++] = '-';
+         uOffset = (uint32_t)-nOffsetMinutes;
+      } else {
+         szDate[uLen++] = '+';
+         uOffset = (uint32_t)nOffsetMinutes;
+      }
+      DateString_PutDigits(&szDate[uLen], uOffset / 60, 2);
+      szDate[uLen + 2] = ':';
+      DateString_PutDigits(&szDate[uLen + 3], uOffset % 60, 2);
+      uLen += 5;
+   }
+
+   if(uTagRequirement == QCBOR_ENCODE_AS_TAG) {
+      QCBOREncode_AddTag(pMe, CBOR_TAG_DATE_STRING);
+   }
+   QCBOREncode_AddText(pMe, (UsefulBufC){szDate, uLen});
+   return;
+
+Overflow:
+   pMe->uError = QCBOR_ERR_DATE_OVERFLOW;
+}
+
+
+static const char B64_Alphabet[] =
+   "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const char B64URL_Alphabet[] =
+   "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+
+/*
+ * The length of base64 text for uLen bytes. Base64 is padded to a
+ * multiple of four characters; base64url is not.
+ */
+static size_t
+B64_EncodedLength(size_t uLen, bool bURL)
+{
+   if(bURL) {
+      return (uLen / 3) * 4 + (uLen % 3 ? uLen % 3 + 1 : 0);
+   } else {
+      return ((uLen + 2) / 3) * 4;
+   }
+}
+
+
+/*
+ * Base64 encode into pOut, which must be B64_EncodedLength() long.
+ *
+ * The main loop takes six bytes into a 64-bit integer and outputs
+ * the eight characters for them. This has half as many loads and
+ * loop iterations as three bytes at a time and compilers keep the
+ * integer in a register. It is portable C so there is no need for
+ * processor-specific code.
+ */
+static void
+B64_Encode(const uint8_t *pIn, size_t uLen, uint8_t *pOut, bool bURL)
+{
+   const char *pAlphabet = bURL ? B64URL_Alphabet : B64_Alphabet;
+   uint64_t    uBits;
+   int         nShift;
+
+   while(uLen >= 6) {
+      uBits = (uint64_t)pIn[0] << 40 | (uint64_t)pIn[1] << 32 |
+              (uint64_t)pIn[2] << 24 | (uint64_t)pIn[3] << 16 |
+              (uint64_t)pIn[4] << 8  | (uint64_t)pIn[5];
+      for(nShift = 42; nShift >= 0; nShift -= 6) {
+         *pOut++ = (uint8_t)pAlphabet[(uBits >> nShift) & 0x3f];
+      }
+      pIn  += 6;
+      uLen -= 6;
+   }
+
+   while(uLen >= 3) {
+      uBits = (uint64_t)pIn[0] << 16 | (uint64_t)pIn[1] << 8 | (uint64_t)pIn[2];
+      pOut[0] = (uint8_t)pAlphabet[(uBits >> 18) & 0x3f];
+      pOut[1] = (uint8_t)pAlphabet[(uBits >> 12) & 0x3f];
+      pOut[2] = (uint8_t)pAlphabet[(uBits >> 6) & 0x3f];
+      pOut[3] = (uint8_t)pAlphabet[uBits & 0x3f];
+      pOut += 4;
+      pIn  += 3;
+      uLen -= 3;
+   }
+
+   if(uLen > 0) {
+      uBits = (uint64_t)pIn[0] << 16;
+      if(uLen == 2) {
+         uBits |= (uint64_t)pIn[1] << 8;
+      }
+      pOut[0] = (uint8_t)pAlphabet[(uBits >> 18) & 0x3f];
+      pOut[1] = (uint8_t)pAlphabet[(uBits >> 12) & 0x3f];
+      if(uLen == 2) {
+         pOut[2] = (uint8_t)pAlphabet[(uBits >> 6) & 0x3f];
+      } else if(!bURL) {
+         pOut[2] = '=';
+      }
+      if(!bURL) {
+         pOut[3] = '=';
+      }
+   }
+}
+
+
+/*
+ * Public function to base64 encode. See qcbor/qcbor_encode.h
+ */
+UsefulBufC
+QCBOREncode_EncodeB64(UsefulBuf Dest, UsefulBufC Bytes, bool bURL)
+{
+   const size_t uLen = B64_EncodedLength(Bytes.len, bURL);
+
+   if(Dest.ptr == NULL) {
+      return (UsefulBufC){NULL, uLen};
+   }
+   if(Dest.len < uLen) {
+      return NULLUsefulBufC;
+   }
+   B64_Encode(Bytes.ptr, Bytes.len, Dest.ptr, bURL);
+
+   return (UsefulBufC){Dest.ptr, uLen};
+}
+
+
+/*
+ * Add bytes as base64 text, encoding them directly into the output
+ * buffer after the head.
+ */
+static void
+AddB64FromBytes(QCBOREncodeContext *pMe,
+                uint8_t             uTagRequirement,
+                uint64_t            uTagNumber,
+                UsefulBufC          Bytes,
+                bool                bURL)
+{
+   const size_t uLen = B64_EncodedLength(Bytes.len, bURL);
+   UsefulBuf    Place;
+
+   if(uTagRequirement == QCBOR_ENCODE_AS_TAG) {
+      QCBOREncode_AddTag(pMe, uTagNumber);
+   }
+   AppendCBORHead(pMe, CBOR_MAJOR_TYPE_TEXT_STRING, uLen, 0);
+
+   Place = UsefulOutBuf_GetOutPlace(&(pMe->OutBuf));
+   if(Place.ptr != NULL && Place.len >= uLen) {
+      B64_Encode(Bytes.ptr, Bytes.len, Place.ptr, bURL);
+   }
+   /* Sets the out buf error if there was not room */
+   UsefulOutBuf_Advance(&(pMe->OutBuf), uLen);
+
+   IncrementMapOrArrayCount(pMe);
+}
+
+
+/*
+ * Public function to add bytes as base64. See qcbor/qcbor_encode.h
+ */
+void
+QCBOREncode_AddTB64TextFromBytes(QCBOREncodeContext *pMe,
+                                 uint8_t             uTagRequirement,
+                                 UsefulBufC          Bytes)
+{
+   AddB64FromBytes(pMe, uTagRequirement, CBOR_TAG_B64, Bytes, false);
+}
+
+
+/*
+ * Public function to add bytes as base64url. See qcbor/qcbor_encode.h
+ */
+void
+QCBOREncode_AddTB64URLTextFromBytes(QCBOREncodeContext *pMe,
+                                    uint8_t             uTagRequirement,
+                                    UsefulBufC          Bytes)
+{
+   AddB64FromBytes(pMe, uTagRequirement, CBOR_TAG_B64URL, Bytes, true);
+}
+
+
 #ifndef USEFULBUF_DISABLE_ALL_FLOAT
 /*
  * Public functions for adding a double. See qcbor/qcbor_encode.h
@@ -912,6 +1214,276 @@ void QCBOREncode_CloseMapOrArray(QCBOREncodeContext *me, uint8_t uMajorType)
 }
 
 
+/*
+ * Compare two encoded labels in bytewise lexicographic order as
+ * required by RFC 8949 section 4.2.1. Note that this is not the same
+ * as UsefulBuf_Compare() which puts shorter buffers first.
+ */
+static int
+CompareEncodedLabels(UsefulBufC Label1, UsefulBufC Label2)
+{
+   const size_t uShorter = Label1.len < Label2.len ? Label1.len : Label2.len;
+
+   const int nResult = memcmp(Label1.ptr, Label2.ptr, uShorter);
+   if(nResult != 0) {
+      return nResult;
+   }
+
+   /* A well-formed encoded item is never a prefix of another so this
+    * is only reached for equal labels, but be complete anyway.
+    */
+   if(Label1.len < Label2.len) {
+      return -1;
+   } else if(Label1.len > Label2.len) {
+      return 1;
+   } else {
+      return 0;
+   }
+}
+
+
+/*
+ * Sort the label-value pairs of the map whose entries start at
+ * uStart and run to the end of the output buffer.
+ *
+ * This is an insertion sort. Each entry in turn is rotated into its
+ * place among the already-sorted entries before it with
+ * UsefulOutBuf_Swap(). Offsets rather than pointers are used because
+ * the rotation moves bytes around. Entries with equal labels keep
+ * their order.
+ */
+static QCBORError
+SortMapEntries(UsefulOutBuf *pOutBuf, size_t uStart)
+{
+   UsefulInputBuf   InBuf;
+   QCBORError       uErr;
+   size_t           uSortedEnd;
+   size_t           uNewLabelEnd;
+   size_t           uNewEntryEnd;
+   size_t           uInsertPos;
+   size_t           uLabelEnd;
+   const UsefulBufC Encoded = UsefulOutBuf_OutUBuf(pOutBuf);
+
+   UsefulInputBuf_Init(&InBuf, Encoded);
+
+   uSortedEnd = uStart;
+   while(uSortedEnd < Encoded.len) {
+      /* Find the extent of the label and whole of the next entry */
+      UsefulInputBuf_Seek(&InBuf, uSortedEnd);
+      uErr = ConsumeEncodedItem(&InBuf);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+      uNewLabelEnd = UsefulInputBuf_Tell(&InBuf);
+      uErr = ConsumeEncodedItem(&InBuf);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+      uNewEntryEnd = UsefulInputBuf_Tell(&InBuf);
+
+      const UsefulBufC NewLabel = {(const uint8_t *)Encoded.ptr + uSortedEnd,
+                                   uNewLabelEnd - uSortedEnd};
+
+      /* Find the first sorted entry with a label greater than it */
+      uInsertPos = uStart;
+      while(uInsertPos < uSortedEnd) {
+         UsefulInputBuf_Seek(&InBuf, uInsertPos);
+         /* These were consumed successfully in an earlier pass */
+         (void)ConsumeEncodedItem(&InBuf);
+         uLabelEnd = UsefulInputBuf_Tell(&InBuf);
+
+         const UsefulBufC Label = {(const uint8_t *)Encoded.ptr + uInsertPos,
+                                   uLabelEnd - uInsertPos};
+         if(CompareEncodedLabels(Label, NewLabel) > 0) {
+            break;
+         }
+         (void)ConsumeEncodedItem(&InBuf);
+         uInsertPos = UsefulInputBuf_Tell(&InBuf);
+      }
+
+      if(uInsertPos < uSortedEnd) {
+         UsefulOutBuf_Swap(pOutBuf, uInsertPos, uSortedEnd, uNewEntryEnd);
+      }
+
+      uSortedEnd = uNewEntryEnd;
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function for closing and sorting maps. See qcbor/qcbor_encode.h
+ */
+void QCBOREncode_CloseAndSortMap(QCBOREncodeContext *pMe)
+{
+   QCBORError uErr;
+
+   /* Only sort when a map is what is open. The close below reports the
+    * mismatch error otherwise. Sorting is skipped when only computing
+    * the size and when in the error state.
+    */
+   if(pMe->uError == QCBOR_SUCCESS &&
+      !UsefulOutBuf_GetError(&(pMe->OutBuf)) &&
+      !UsefulOutBuf_IsBufferNULL(&(pMe->OutBuf)) &&
+      Nesting_GetMajorType(&(pMe->nesting)) == CBOR_MAJOR_TYPE_MAP) {
+      uErr = SortMapEntries(&(pMe->OutBuf), Nesting_GetStartPos(&(pMe->nesting)));
+      if(uErr != QCBOR_SUCCESS) {
+         pMe->uError = (uint8_t)uErr;
+         return;
+      }
+   }
+
+   QCBOREncode_CloseMapOrArray(pMe, CBOR_MAJOR_TYPE_MAP);
+}
+
+
+#define MERGE_LABEL_FILTER_BITS 512
+
+/*
+ * Check the labels of the map entries that start at uStart and run to
+ * the end of the output buffer for duplicates.
+ *
+ * Each label's hash sets a bit in a small filter on the stack. Only
+ * when a label's bit is already set is it compared against all the
+ * labels before it. This keeps the check to one walk over the entries
+ * when there are no duplicates unless the map is very large.
+ *
+ * Labels are compared by their encoded bytes, so the same label
+ * encoded two different ways, for example an integer not in
+ * preferred serialization, is not found.
+ */
+static QCBORError
+CheckMapLabels(UsefulOutBuf *pOutBuf, size_t uStart)
+{
+   UsefulInputBuf   InBuf;
+   UsefulInputBuf   PrevInBuf;
+   QCBORError       uErr;
+   size_t           uEntryStart;
+   size_t           uLabelEnd;
+   size_t           uPrevStart;
+   uint32_t         uBit;
+   uint8_t          auFilter[MERGE_LABEL_FILTER_BITS / 8];
+   const UsefulBufC Encoded = UsefulOutBuf_OutUBuf(pOutBuf);
+
+   memset(auFilter, 0, sizeof(auFilter));
+   UsefulInputBuf_Init(&InBuf, Encoded);
+   UsefulInputBuf_Init(&PrevInBuf, Encoded);
+
+   uEntryStart = uStart;
+   UsefulInputBuf_Seek(&InBuf, uEntryStart);
+   while(uEntryStart < Encoded.len) {
+      uErr = ConsumeEncodedItem(&InBuf);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+      uLabelEnd = UsefulInputBuf_Tell(&InBuf);
+
+      const UsefulBufC Label = {(const uint8_t *)Encoded.ptr + uEntryStart,
+                                uLabelEnd - uEntryStart};
+
+      uBit = HashEncodedLabel(Label) % MERGE_LABEL_FILTER_BITS;
+      if(auFilter[uBit / 8] & (1 << (uBit % 8))) {
+         /* Might be a duplicate. Compare with all the labels before. */
+         uPrevStart = uStart;
+         UsefulInputBuf_Seek(&PrevInBuf, uPrevStart);
+         while(uPrevStart < uEntryStart) {
+            /* These were consumed successfully in an earlier pass */
+            (void)ConsumeEncodedItem(&PrevInBuf);
+
+            const UsefulBufC PrevLabel = {(const uint8_t *)Encoded.ptr + uPrevStart,
+                                          UsefulInputBuf_Tell(&PrevInBuf) - uPrevStart};
+            if(UsefulBuf_Compare(PrevLabel, Label) == 0) {
+               return QCBOR_ERR_DUPLICATE_LABEL;
+            }
+
+            (void)ConsumeEncodedItem(&PrevInBuf);
+            uPrevStart = UsefulInputBuf_Tell(&PrevInBuf);
+         }
+      }
+      auFilter[uBit / 8] |= (uint8_t)(1 << (uBit % 8));
+
+      uErr = ConsumeEncodedItem(&InBuf);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+      uEntryStart = UsefulInputBuf_Tell(&InBuf);
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function for merging encoded maps. See qcbor/qcbor_encode.h
+ */
+void QCBOREncode_MergeMaps(QCBOREncodeContext *pMe,
+                           const UsefulBufC   *pMaps,
+                           size_t              uNumMaps,
+                           uint32_t            uOptions)
+{
+   UsefulInputBuf InBuf;
+   QCBORError     uErr;
+   size_t         uIndex;
+   uint64_t       uNumPairs;
+   uint8_t        uMajorType;
+
+   if(pMe->uError != QCBOR_SUCCESS) {
+      return;
+   }
+
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
+   uMajorType = Nesting_GetMajorType(&(pMe->nesting));
+   if((uMajorType != CBOR_MAJOR_TYPE_MAP &&
+       uMajorType != CBOR_MAJOR_NONE_TYPE_MAP_INDEFINITE_LEN) ||
+      Nesting_IsAfterLabel(&(pMe->nesting))) {
+      pMe->uError = QCBOR_ERR_ENCODE_UNSUPPORTED;
+      return;
+   }
+#endif /* QCBOR_DISABLE_ENCODE_USAGE_GUARDS */
+
+   for(uIndex = 0; uIndex < uNumMaps; uIndex++) {
+      /* Only the head of each map is decoded. Its count of pairs is
+       * added to the open map's count and the entries after it are
+       * copied as they are.
+       */
+      UsefulInputBuf_Init(&InBuf, pMaps[uIndex]);
+      uErr = ConsumeEncodedHead(&InBuf, &uMajorType, &uNumPairs);
+      if(uErr == QCBOR_SUCCESS) {
+         if(UsefulInputBuf_GetError(&InBuf)) {
+            uErr = QCBOR_ERR_HIT_END;
+         } else if(uMajorType != CBOR_MAJOR_TYPE_MAP) {
+            uErr = QCBOR_ERR_ENCODE_UNSUPPORTED;
+         } else if(uNumPairs > UsefulInputBuf_BytesUnconsumed(&InBuf) / 2) {
+            /* Every pair takes at least two bytes. This check also
+             * keeps the multiplication below from overflowing. */
+            uErr = QCBOR_ERR_HIT_END;
+         }
+      }
+      if(uErr != QCBOR_SUCCESS) {
+         pMe->uError = (uint8_t)uErr;
+         return;
+      }
+
+      pMe->uError = (uint8_t)Nesting_IncrementBy(&(pMe->nesting), uNumPairs * 2);
+      if(pMe->uError != QCBOR_SUCCESS) {
+         return;
+      }
+
+      UsefulOutBuf_AppendUsefulBuf(&(pMe->OutBuf),
+                                   UsefulBuf_Tail(pMaps[uIndex],
+                                                  UsefulInputBuf_Tell(&InBuf)));
+   }
+
+   if((uOptions & QCBOR_MERGE_CHECK_DUPLICATES) &&
+      !UsefulOutBuf_GetError(&(pMe->OutBuf)) &&
+      !UsefulOutBuf_IsBufferNULL(&(pMe->OutBuf))) {
+      pMe->uError = (uint8_t)CheckMapLabels(&(pMe->OutBuf),
+                                            Nesting_GetStartPos(&(pMe->nesting)));
+   }
+}
+
+
 /*
  * Public functions for closing bstr wrapping. See qcbor/qcbor_encode.h
  */
@@ -1031,6 +1603,53 @@ void QCBOREncode_CloseMapOrArrayIndefiniteLength(QCBOREncodeContext *pMe, uint8_
 }
 
 
+/*
+ * Semi-public function. See qcbor/qcbor_encode.h
+ */
+void QCBOREncode_AddBytesContentOnly(QCBOREncodeContext *pMe, UsefulBufC Bytes)
+{
+   UsefulOutBuf_AppendUsefulBuf(&(pMe->OutBuf), Bytes);
+}
+
+
+/*
+ * Semi-public function. See qcbor/qcbor_encode.h
+ */
+void QCBOREncode_OpenMapOrArrayWithCount(QCBOREncodeContext *pMe,
+                                         uint8_t             uMajorType,
+                                         uint64_t            uCount)
+{
+   /* The head goes first, then the bookkeeping for nesting is done
+    * as for any other open. The position it records isn't used. */
+   AppendCBORHead(pMe, uMajorType, uCount, 0);
+   QCBOREncode_OpenMapOrArray(pMe, uMajorType);
+}
+
+
+/*
+ * Semi-public function. See qcbor/qcbor_encode.h
+ */
+void QCBOREncode_CloseMapOrArrayWithCount(QCBOREncodeContext *pMe,
+                                          uint8_t             uMajorType,
+                                          uint64_t            uCount)
+{
+   if(CheckDecreaseNesting(pMe, uMajorType)) {
+      return;
+   }
+
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
+   if(Nesting_GetCount(&(pMe->nesting)) != uCount) {
+      pMe->uError = QCBOR_ERR_CLOSE_MISMATCH;
+      return;
+   }
+#else
+   (void)uCount;
+#endif /* QCBOR_DISABLE_ENCODE_USAGE_GUARDS */
+
+   Nesting_Decrease(&(pMe->nesting));
+}
+
+
 /*
  * Public function to finish and get the encoded result. See qcbor/qcbor_encode.h
  */
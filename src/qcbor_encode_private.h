@@ -0,0 +1,180 @@
+/*==============================================================================
+ qcbor_encode_private.h -- Encoder internals used by the other source files
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_encode_private_h
+#define qcbor_encode_private_h
+
+
+#include "qcbor/qcbor_encode.h"
+
+
+/*
+ * What map sorting and merging use to work on encoded CBOR is here so
+ * the features in the other source files that work on encoded CBOR,
+ * such as packing and transformation, do it the same way.
+ */
+
+
+/* Add uItems to the count of the open array or map */
+static inline uint8_t
+Nesting_IncrementBy(QCBORTrackNesting *pNesting, uint64_t uItems)
+{
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
+   if(uItems >= (uint64_t)(QCBOR_MAX_ITEMS_IN_ARRAY - pNesting->pCurrentNesting->uCount)) {
+      return QCBOR_ERR_ARRAY_TOO_LONG;
+   }
+#endif /* QCBOR_DISABLE_ENCODE_USAGE_GUARDS */
+
+   /* Cast is safe because of check above */
+   pNesting->pCurrentNesting->uCount = (uint16_t)(pNesting->pCurrentNesting->uCount + uItems);
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Consume the head of an encoded data item and return its major type
+ * and argument. Indefinite lengths are not supported. Reserved
+ * additional info values and simple values encoded in two bytes that
+ * fit in one are not well-formed and give the same errors the decoder
+ * does. The caller must check the input buffer for running out.
+ */
+static inline QCBORError
+ConsumeEncodedHead(UsefulInputBuf *pInBuf, uint8_t *puMajorType, uint64_t *puArgument)
+{
+   const uint8_t uInitialByte    = UsefulInputBuf_GetByte(pInBuf);
+   const uint8_t uAdditionalInfo = uInitialByte & 0x1f;
+
+   if(uAdditionalInfo < LEN_IS_ONE_BYTE) {
+      *puArgument = uAdditionalInfo;
+   } else if(uAdditionalInfo == LEN_IS_ONE_BYTE) {
+      *puArgument = UsefulInputBuf_GetByte(pInBuf);
+   } else if(uAdditionalInfo == LEN_IS_TWO_BYTES) {
+      *puArgument = UsefulInputBuf_GetUint16(pInBuf);
+   } else if(uAdditionalInfo == LEN_IS_FOUR_BYTES) {
+      *puArgument = UsefulInputBuf_GetUint32(pInBuf);
+   } else if(uAdditionalInfo == LEN_IS_EIGHT_BYTES) {
+      *puArgument = UsefulInputBuf_GetUint64(pInBuf);
+   } else if(uAdditionalInfo == LEN_IS_INDEFINITE) {
+      return QCBOR_ERR_ENCODE_UNSUPPORTED;
+   } else {
+      /* Reserved additional info */
+      return QCBOR_ERR_UNSUPPORTED;
+   }
+
+   *puMajorType = uInitialByte >> 5;
+
+   if(*puMajorType == CBOR_MAJOR_TYPE_SIMPLE &&
+      uAdditionalInfo == LEN_IS_ONE_BYTE &&
+      *puArgument <= CBOR_SIMPLE_BREAK) {
+      return QCBOR_ERR_BAD_TYPE_7;
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Consume one complete encoded data item, including any items nested
+ * in it, from the input buffer. This is a minimal walk over the
+ * encoded CBOR that only decodes heads. It is used for map sorting
+ * and for checking labels when merging maps where the input is
+ * mostly output the encoder already produced so it doesn't need to
+ * be as thorough as the decoder. It only needs to be safe.
+ * Indefinite-length items are not supported. Input that runs out
+ * before the item is complete gives QCBOR_ERR_HIT_END as it does when
+ * decoding.
+ *
+ * Rather than recursion, a count of the items still to be consumed is
+ * kept. Arrays add their item count, maps twice their pair count and
+ * tags one for the tag content.
+ */
+static inline QCBORError
+ConsumeEncodedItem(UsefulInputBuf *pInBuf)
+{
+   uint64_t   uItemsLeft = 1;
+   uint64_t   uArgument;
+   uint8_t    uMajorType;
+   QCBORError uErr;
+
+   while(uItemsLeft > 0) {
+      uErr = ConsumeEncodedHead(pInBuf, &uMajorType, &uArgument);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+
+      /* String bytes and array and map items each take at least one
+       * byte so an argument larger than the bytes left is an error.
+       * This also keeps the arithmetic on uItemsLeft from overflowing.
+       */
+      switch(uMajorType) {
+         case CBOR_MAJOR_TYPE_BYTE_STRING:
+         case CBOR_MAJOR_TYPE_TEXT_STRING:
+            if(uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+               return QCBOR_ERR_HIT_END;
+            }
+            UsefulInputBuf_GetBytes(pInBuf, (size_t)uArgument);
+            break;
+
+         case CBOR_MAJOR_TYPE_ARRAY:
+            if(uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+               return QCBOR_ERR_HIT_END;
+            }
+            uItemsLeft += uArgument;
+            break;
+
+         case CBOR_MAJOR_TYPE_MAP:
+            if(uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+               return QCBOR_ERR_HIT_END;
+            }
+            uItemsLeft += uArgument * 2;
+            break;
+
+         case CBOR_MAJOR_TYPE_TAG:
+            uItemsLeft += 1;
+            break;
+
+         default:
+            /* Integers and type 7 are entirely in the head */
+            break;
+      }
+
+      if(UsefulInputBuf_GetError(pInBuf)) {
+         return QCBOR_ERR_HIT_END;
+      }
+
+      uItemsLeft--;
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * A simple and fast hash (FNV-1a) of an encoded label. Only used to
+ * decide whether a label might have been seen before.
+ */
+static inline uint32_t
+HashEncodedLabel(UsefulBufC Label)
+{
+   const uint8_t *pByte = (const uint8_t *)Label.ptr;
+   const uint8_t *pEnd  = pByte + Label.len;
+   uint32_t       uHash = 2166136261U;
+
+   while(pByte < pEnd) {
+      uHash ^= *pByte++;
+      uHash *= 16777619U;
+   }
+
+   return uHash;
+}
+
+
+#endif /* qcbor_encode_private_h */
@@ -27,6 +27,7 @@ const char *qcbor_err_to_str(QCBORError err) {
     _ERR_TO_STR(ERR_ARRAY_TOO_LONG)
     _ERR_TO_STR(ERR_TOO_MANY_CLOSES)
     _ERR_TO_STR(ERR_ARRAY_OR_MAP_STILL_OPEN)
+    _ERR_TO_STR(ERR_JSON_SYNTAX)
     _ERR_TO_STR(ERR_BAD_TYPE_7)
     _ERR_TO_STR(ERR_EXTRA_BYTES)
     _ERR_TO_STR(ERR_UNSUPPORTED)
@@ -42,6 +43,7 @@ const char *qcbor_err_to_str(QCBORError err) {
     _ERR_TO_STR(ERR_BAD_EXP_AND_MANTISSA)
     _ERR_TO_STR(ERR_NO_STRING_ALLOCATOR)
     _ERR_TO_STR(ERR_STRING_ALLOCATE)
+    _ERR_TO_STR(ERR_CANNOT_CONTINUE_INPUT)
     _ERR_TO_STR(ERR_TOO_MANY_TAGS)
     _ERR_TO_STR(ERR_MAP_LABEL_TYPE)
     _ERR_TO_STR(ERR_UNEXPECTED_TYPE)
@@ -62,6 +64,11 @@ const char *qcbor_err_to_str(QCBORError err) {
     _ERR_TO_STR(ERR_HW_FLOAT_DISABLED)
     _ERR_TO_STR(ERR_FLOAT_EXCEPTION)
     _ERR_TO_STR(ERR_ALL_FLOAT_DISABLED)
+    _ERR_TO_STR(ERR_SCHEMA_MISMATCH)
+    _ERR_TO_STR(ERR_SCHEMA_SYNTAX)
+    _ERR_TO_STR(ERR_BAD_UTF8)
+    _ERR_TO_STR(ERR_PATH_SYNTAX)
+    _ERR_TO_STR(ERR_LABEL_SLOTS_SIZE)
 
     default:
         return "Unidentified error";
@@ -0,0 +1,1072 @@
+/*==============================================================================
+ qcbor_json_encode.c -- Convert JSON to CBOR with the QCBOR encoder
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_json_encode.h"
+#include <stddef.h> /* For ptrdiff_t */
+#include <string.h> /* For memcpy() and memcmp() */
+
+
+/**
+ * @file qcbor_json_encode.c
+ *
+ * A single-pass JSON tokenizer that drives the QCBOR encoder.
+ *
+ * Nesting of JSON objects and arrays is tracked here with one bit per
+ * level rather than with recursion so stack use is fixed and small.
+ * The encoder tracks the same nesting for the CBOR output. The depth
+ * limit here is the same as the encoder's.
+ */
+
+#if QCBOR_MAX_ARRAY_NESTING > 32
+#error QCBOR_MAX_ARRAY_NESTING too large for the JSON nesting bit field
+#endif
+
+
+/* What the tokenizer expects next */
+#define JSON_EXPECT_VALUE 0 /* Any JSON value */
+#define JSON_EXPECT_FIRST 1 /* First member or element, or a close */
+#define JSON_EXPECT_NEXT  2 /* A comma or a close */
+
+
+typedef struct {
+   const uint8_t      *pCur;
+   const uint8_t      *pEnd;
+   QCBOREncodeContext *pEncodeCtx;
+   uint32_t            uOptions;
+   uint32_t            uNestIsObject; /* Bit set for levels that are objects */
+   uint8_t             uNestLevel;
+} JSONTokenizer;
+
+
+
+/*
+ * == SWAR String Scanning ==
+ *
+ * Most of the time in tokenizing JSON goes to scanning through string
+ * contents looking for the closing quote. This looks at eight bytes
+ * at a time in a uint64_t to find any of the bytes that end the fast
+ * scan: a quote, a backslash or a control character. The bit
+ * manipulation is the well-known "has zero byte" and "has byte less
+ * than" trick. It only tells whether there is such a byte in the
+ * eight, not where, so the bytes of that eight are then looked at one
+ * at a time.
+ *
+ * This gets much of the gain of SIMD without any instruction set or
+ * compiler dependency. Byte order doesn't matter as only presence is
+ * tested.
+ */
+#define SWAR_ONES  0x0101010101010101ULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+
+static inline uint64_t
+SWAR_HasZeroByte(uint64_t uWord)
+{
+   return (uWord - SWAR_ONES) & ~uWord & SWAR_HIGHS;
+}
+
+static inline uint64_t
+SWAR_HasByteLessThan(uint64_t uWord, uint8_t uLimit)
+{
+   /* Correct for uLimit up to 128 */
+   return (uWord - SWAR_ONES * uLimit) & ~uWord & SWAR_HIGHS;
+}
+
+static inline bool
+JSON_IsStringStop(uint8_t uByte)
+{
+   return uByte == '"' || uByte == '\\' || uByte < 0x20;
+}
+
+
+/*
+ * Returns pointer to the first quote, backslash or control character
+ * at or after pCur or pEnd if there is none.
+ */
+static const uint8_t *
+JSON_ScanString(const uint8_t *pCur, const uint8_t *pEnd)
+{
+   uint64_t uWord;
+
+   while(pEnd - pCur >= (ptrdiff_t)sizeof(uint64_t)) {
+      /* memcpy() rather than a cast because pCur may not be aligned */
+      memcpy(&uWord, pCur, sizeof(uint64_t));
+      if(SWAR_HasZeroByte(uWord ^ (SWAR_ONES * '"'))  ||
+         SWAR_HasZeroByte(uWord ^ (SWAR_ONES * '\\')) ||
+         SWAR_HasByteLessThan(uWord, 0x20)) {
+         break;
+      }
+      pCur += sizeof(uint64_t);
+   }
+
+   while(pCur < pEnd && !JSON_IsStringStop(*pCur)) {
+      pCur++;
+   }
+
+   return pCur;
+}
+
+
+
+/*
+ * == Strings ==
+ */
+
+static inline int
+JSON_HexDigitValue(uint8_t uChar)
+{
+   if(uChar >= '0' && uChar <= '9') {
+      return uChar - '0';
+   } else if(uChar >= 'a' && uChar <= 'f') {
+      return uChar - 'a' + 10;
+   } else if(uChar >= 'A' && uChar <= 'F') {
+      return uChar - 'A' + 10;
+   } else {
+      return -1;
+   }
+}
+
+
+/*
+ * Decode the four hex digits of a \u escape. pCur points to the 'u'.
+ * Returns the code unit or -1 on error.
+ */
+static int32_t
+JSON_DecodeHex4(const uint8_t *pCur, const uint8_t *pEnd)
+{
+   int32_t nCodeUnit = 0;
+   int     nIndex;
+   int     nDigit;
+
+   if(pEnd - pCur < 5) {
+      return -1;
+   }
+   for(nIndex = 1; nIndex <= 4; nIndex++) {
+      nDigit = JSON_HexDigitValue(pCur[nIndex]);
+      if(nDigit < 0) {
+         return -1;
+      }
+      nCodeUnit = (nCodeUnit << 4) + nDigit;
+   }
+
+   return nCodeUnit;
+}
+
+
+/*
+ * Output a code point as UTF-8. pOut may be NULL to just count. Returns
+ * the number of bytes.
+ */
+static size_t
+JSON_EncodeUTF8(uint32_t uCodePoint, uint8_t *pOut)
+{
+   uint8_t pBytes[4];
+   size_t  uLen;
+
+   if(uCodePoint < 0x80) {
+      pBytes[0] = (uint8_t)uCodePoint;
+      uLen = 1;
+   } else if(uCodePoint < 0x800) {
+      pBytes[0] = (uint8_t)(0xc0 | (uCodePoint >> 6));
+      pBytes[1] = (uint8_t)(0x80 | (uCodePoint & 0x3f));
+      uLen = 2;
+   } else if(uCodePoint < 0x10000) {
+      pBytes[0] = (uint8_t)(0xe0 | (uCodePoint >> 12));
+      pBytes[1] = (uint8_t)(0x80 | ((uCodePoint >> 6) & 0x3f));
+      pBytes[2] = (uint8_t)(0x80 | (uCodePoint & 0x3f));
+      uLen = 3;
+   } else {
+      pBytes[0] = (uint8_t)(0xf0 | (uCodePoint >> 18));
+      pBytes[1] = (uint8_t)(0x80 | ((uCodePoint >> 12) & 0x3f));
+      pBytes[2] = (uint8_t)(0x80 | ((uCodePoint >> 6) & 0x3f));
+      pBytes[3] = (uint8_t)(0x80 | (uCodePoint & 0x3f));
+      uLen = 4;
+   }
+
+   if(pOut != NULL) {
+      memcpy(pOut, pBytes, uLen);
+   }
+
+   return uLen;
+}
+
+
+/*
+ * Convert the contents of a JSON string with escapes to UTF-8. pCur
+ * is just after the opening quote. pOut may be NULL to only validate
+ * and compute the length. This is run twice for strings with escapes,
+ * once to get the length for the CBOR head and once to write the
+ * bytes directly into the output buffer. Returns a pointer to the
+ * closing quote or NULL if the string is not valid.
+ */
+static const uint8_t *
+JSON_Unescape(const uint8_t *pCur,
+              const uint8_t *pEnd,
+              uint8_t       *pOut,
+              size_t        *puLen)
+{
+   const uint8_t *pRun;
+   size_t         uLen;
+   int32_t        nCodeUnit;
+   int32_t        nLowSurrogate;
+   uint32_t       uCodePoint;
+   uint8_t        uEscaped;
+
+   uLen = 0;
+   for(;;) {
+      /* Copy the run up to the next quote, backslash or control char */
+      pRun = pCur;
+      pCur = JSON_ScanString(pCur, pEnd);
+      if(pOut != NULL) {
+         memcpy(pOut + uLen, pRun, (size_t)(pCur - pRun));
+      }
+      uLen += (size_t)(pCur - pRun);
+
+      if(pCur >= pEnd || *pCur < 0x20) {
+         /* Unterminated or unescaped control character */
+         return NULL;
+      }
+      if(*pCur == '"') {
+         break;
+      }
+
+      /* A backslash */
+      if(pEnd - pCur < 2) {
+         return NULL;
+      }
+      switch(pCur[1]) {
+         case '"':  uEscaped = '"';  break;
+         case '\\': uEscaped = '\\'; break;
+         case '/':  uEscaped = '/';  break;
+         case 'b':  uEscaped = '\b'; break;
+         case 'f':  uEscaped = '\f'; break;
+         case 'n':  uEscaped = '\n'; break;
+         case 'r':  uEscaped = '\r'; break;
+         case 't':  uEscaped = '\t'; break;
+         case 'u':  uEscaped = 0;    break;
+         default:   return NULL;
+      }
+
+      if(pCur[1] != 'u') {
+         if(pOut != NULL) {
+            pOut[uLen] = uEscaped;
+         }
+         uLen++;
+         pCur += 2;
+         continue;
+      }
+
+      /* A \uXXXX escape, possibly the first of a surrogate pair */
+      nCodeUnit = JSON_DecodeHex4(pCur + 1, pEnd);
+      if(nCodeUnit < 0) {
+         return NULL;
+      }
+      pCur += 6;
+      if(nCodeUnit >= 0xdc00 && nCodeUnit <= 0xdfff) {
+         /* Low surrogate without a high surrogate */
+         return NULL;
+      }
+      if(nCodeUnit >= 0xd800 && nCodeUnit <= 0xdbff) {
+         if(pEnd - pCur < 2 || pCur[0] != '\\' || pCur[1] != 'u') {
+            return NULL;
+         }
+         nLowSurrogate = JSON_DecodeHex4(pCur + 1, pEnd);
+         if(nLowSurrogate < 0xdc00 || nLowSurrogate > 0xdfff) {
+            return NULL;
+         }
+         pCur += 6;
+         uCodePoint = 0x10000 +
+                      ((uint32_t)(nCodeUnit - 0xd800) << 10) +
+                      (uint32_t)(nLowSurrogate - 0xdc00);
+      } else {
+         uCodePoint = (uint32_t)nCodeUnit;
+      }
+
+      uLen += JSON_EncodeUTF8(uCodePoint, pOut == NULL ? NULL : pOut + uLen);
+   }
+
+   *puLen = uLen;
+   return pCur;
+}
+
+
+/*
+ * Add a JSON string as a CBOR text string. pCur is at the opening
+ * quote.
+ *
+ * Strings without escapes, which is nearly all of them, are added
+ * directly from the JSON input with no copying other than into the
+ * output buffer. Strings with escapes are converted directly into the
+ * output buffer after the CBOR head is output.
+ */
+static QCBORError
+JSON_AddString(JSONTokenizer *pMe)
+{
+   const uint8_t *pStart = pMe->pCur + 1;
+   const uint8_t *pStop;
+   size_t         uLen;
+   UsefulBuf      Place;
+   UsefulBuf_MAKE_STACK_UB(HeadBuffer, QCBOR_HEAD_BUFFER_SIZE);
+
+   pStop = JSON_ScanString(pStart, pMe->pEnd);
+   if(pStop < pMe->pEnd && *pStop == '"') {
+      QCBOREncode_AddText(pMe->pEncodeCtx,
+                          (UsefulBufC){pStart, (size_t)(pStop - pStart)});
+      pMe->pCur = pStop + 1;
+      return QCBOR_SUCCESS;
+   }
+
+   /* First pass validates and gets the length */
+   pStop = JSON_Unescape(pStart, pMe->pEnd, NULL, &uLen);
+   if(pStop == NULL) {
+      return QCBOR_ERR_JSON_SYNTAX;
+   }
+
+   /* The head alone is added as if it were the whole encoded item so
+    * it is counted as an item in the enclosing array or map. The
+    * string bytes follow it without being counted.
+    */
+   QCBOREncode_AddEncoded(pMe->pEncodeCtx,
+                          QCBOREncode_EncodeHead(HeadBuffer,
+                                                 CBOR_MAJOR_TYPE_TEXT_STRING,
+                                                 0,
+                                                 uLen));
+
+   Place = UsefulOutBuf_GetOutPlace(&(pMe->pEncodeCtx->OutBuf));
+   if(Place.ptr != NULL && Place.len >= uLen) {
+      (void)JSON_Unescape(pStart, pMe->pEnd, Place.ptr, &uLen);
+   }
+   /* This sets the buffer-too-small error if it didn't fit and
+    * counts in size calculation mode.
+    */
+   UsefulOutBuf_Advance(&(pMe->pEncodeCtx->OutBuf), uLen);
+
+   pMe->pCur = pStop + 1;
+   return QCBOR_SUCCESS;
+}
+
+
+
+/*
+ * == Numbers ==
+ */
+
+#if !defined(USEFULBUF_DISABLE_ALL_FLOAT) && !defined(QCBOR_DISABLE_FLOAT_HW_USE)
+/* All powers of ten that are exactly representable as a double */
+static const double s_dPowersOfTen[] = {
+   1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+   1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+   1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Integers up to 2^53 are exactly representable as a double */
+#define JSON_MAX_EXACT_DOUBLE_INT (1ULL << 53)
+#endif /* ! USEFULBUF_DISABLE_ALL_FLOAT && ! QCBOR_DISABLE_FLOAT_HW_USE */
+
+
+#if !defined(USEFULBUF_DISABLE_ALL_FLOAT) && !defined(QCBOR_DISABLE_FLOAT_HW_USE)
+/*
+ * Unsigned integers big enough for the exact conversion of numbers
+ * of up to QCBOR_JSON_MAX_NUMBER_LEN characters. The largest value is
+ * 10^470 times 2^53, about 1620 bits. Words are least significant
+ * first and uLen has no leading zero words.
+ */
+#define JSON_BIG_WORDS 64
+
+typedef struct {
+   uint32_t auWords[JSON_BIG_WORDS];
+   unsigned uLen;
+} JSONBig;
+
+
+static void
+JSONBig_Set(JSONBig *pMe, uint32_t uValue)
+{
+   pMe->auWords[0] = uValue;
+   pMe->uLen       = uValue != 0;
+}
+
+
+/* pMe = pMe * uMul + uAdd */
+static void
+JSONBig_MulAdd(JSONBig *pMe, uint32_t uMul, uint32_t uAdd)
+{
+   unsigned uIndex;
+   uint64_t uCarry = uAdd;
+
+   for(uIndex = 0; uIndex < pMe->uLen; uIndex++) {
+      uCarry += (uint64_t)pMe->auWords[uIndex] * uMul;
+      pMe->auWords[uIndex] = (uint32_t)uCarry;
+      uCarry >>= 32;
+   }
+   if(uCarry != 0) {
+      pMe->auWords[pMe->uLen++] = (uint32_t)uCarry;
+   }
+}
+
+
+static void
+JSONBig_ShiftLeft(JSONBig *pMe, unsigned uBits)
+{
+   const unsigned uWords = uBits / 32;
+   const unsigned uShift = uBits % 32;
+   unsigned       uIndex;
+   uint32_t       uWord;
+
+   if(pMe->uLen == 0) {
+      return;
+   }
+
+   /* From the top down so no word is written before it is read */
+   pMe->auWords[pMe->uLen + uWords] = 0;
+   for(uIndex = pMe->uLen; uIndex > 0; uIndex--) {
+      uWord = pMe->auWords[uIndex - 1];
+      if(uShift != 0) {
+         pMe->auWords[uIndex + uWords] |= uWord >> (32 - uShift);
+      }
+      pMe->auWords[uIndex - 1 + uWords] = uWord << uShift;
+   }
+   for(uIndex = 0; uIndex < uWords; uIndex++) {
+      pMe->auWords[uIndex] = 0;
+   }
+   pMe->uLen += uWords + 1;
+   if(pMe->auWords[pMe->uLen - 1] == 0) {
+      pMe->uLen--;
+   }
+}
+
+
+static int
+JSONBig_Compare(const JSONBig *pA, const JSONBig *pB)
+{
+   unsigned uIndex;
+
+   if(pA->uLen != pB->uLen) {
+      return pA->uLen < pB->uLen ? -1 : 1;
+   }
+   for(uIndex = pA->uLen; uIndex > 0; uIndex--) {
+      if(pA->auWords[uIndex - 1] != pB->auWords[uIndex - 1]) {
+         return pA->auWords[uIndex - 1] < pB->auWords[uIndex - 1] ? -1 : 1;
+      }
+   }
+   return 0;
+}
+
+
+/* pA = pA - pB where pA is not less than pB */
+static void
+JSONBig_Subtract(JSONBig *pA, const JSONBig *pB)
+{
+   unsigned uIndex;
+   uint64_t uBorrow = 0;
+   uint64_t uDiff;
+
+   for(uIndex = 0; uIndex < pA->uLen; uIndex++) {
+      uDiff = (uint64_t)pA->auWords[uIndex] - uBorrow;
+      if(uIndex < pB->uLen) {
+         uDiff -= pB->auWords[uIndex];
+      }
+      pA->auWords[uIndex] = (uint32_t)uDiff;
+      uBorrow = (uDiff >> 32) != 0;
+   }
+   while(pA->uLen > 0 && pA->auWords[pA->uLen - 1] == 0) {
+      pA->uLen--;
+   }
+}
+
+
+static int
+JSONBig_BitLength(const JSONBig *pMe)
+{
+   int      nBits;
+   uint32_t uTop;
+
+   if(pMe->uLen == 0) {
+      return 0;
+   }
+   nBits = (int)(pMe->uLen - 1) * 32;
+   for(uTop = pMe->auWords[pMe->uLen - 1]; uTop != 0; uTop >>= 1) {
+      nBits++;
+   }
+   return nBits;
+}
+
+
+/*
+ * Convert a JSON number to the nearest double, ties to even, the same
+ * as a correct strtod() but independent of the C locale.
+ *
+ * The number is the ratio N / D of two big integers. The binary
+ * exponent b with 2^b <= N / D < 2^(b+1) is found from their lengths.
+ * Then N / D is scaled by a power of two so the quotient has the 53
+ * bits of the mantissa, fewer for subnormals, and is computed by long
+ * division one bit at a time. The remainder gives the rounding. This
+ * is slow, but only for numbers the fast path can't do.
+ */
+static double
+JSON_ExactToDouble(const uint8_t *pStart, const uint8_t *pEnd)
+{
+   JSONBig        N;
+   JSONBig        D;
+   JSONBig        T;
+   const uint8_t *pCur      = pStart;
+   bool           bNegative = false;
+   int32_t        nExp10    = 0;
+   int32_t        nExplicitExponent;
+   bool           bExponentNegative;
+   int            nBinExp;
+   int            nBits;
+   int            nShift;
+   int            nBit;
+   uint64_t       uQuotient;
+   uint64_t       uDouble;
+
+   JSONBig_Set(&N, 0);
+   JSONBig_Set(&D, 1);
+
+   /* The syntax has already been checked */
+   if(*pCur == '-') {
+      bNegative = true;
+      pCur++;
+   }
+   while(pCur < pEnd && *pCur >= '0' && *pCur <= '9') {
+      JSONBig_MulAdd(&N, 10, (uint32_t)(*pCur++ - '0'));
+   }
+   if(pCur < pEnd && *pCur == '.') {
+      pCur++;
+      while(pCur < pEnd && *pCur >= '0' && *pCur <= '9') {
+         JSONBig_MulAdd(&N, 10, (uint32_t)(*pCur++ - '0'));
+         nExp10--;
+      }
+   }
+   if(pCur < pEnd && (*pCur == 'e' || *pCur == 'E')) {
+      pCur++;
+      bExponentNegative = false;
+      if(*pCur == '+' || *pCur == '-') {
+         bExponentNegative = *pCur++ == '-';
+      }
+      nExplicitExponent = 0;
+      while(pCur < pEnd && *pCur >= '0' && *pCur <= '9') {
+         if(nExplicitExponent < 100000) {
+            nExplicitExponent = nExplicitExponent * 10 + (*pCur - '0');
+         }
+         pCur++;
+      }
+      nExp10 += bExponentNegative ? -nExplicitExponent : nExplicitExponent;
+   }
+
+   /* N has at most QCBOR_JSON_MAX_NUMBER_LEN digits. Beyond these
+    * exponents the result is infinity or zero for any N. */
+   if(N.uLen == 0 || nExp10 < -470) {
+      uDouble = 0;
+      goto Done;
+   }
+   if(nExp10 > 308) {
+      uDouble = 0x7ff0000000000000; /* Infinity */
+      goto Done;
+   }
+   for(; nExp10 > 0; nExp10--) {
+      JSONBig_MulAdd(&N, 10, 0);
+   }
+   for(; nExp10 < 0; nExp10++) {
+      JSONBig_MulAdd(&D, 10, 0);
+   }
+
+   /* Find the binary exponent */
+   nBinExp = JSONBig_BitLength(&N) - JSONBig_BitLength(&D);
+   T = D;
+   if(nBinExp >= 0) {
+      JSONBig_ShiftLeft(&T, (unsigned)nBinExp);
+      if(JSONBig_Compare(&N, &T) < 0) {
+         nBinExp--;
+      }
+   } else {
+      T = N;
+      JSONBig_ShiftLeft(&T, (unsigned)-nBinExp);
+      if(JSONBig_Compare(&T, &D) < 0) {
+         nBinExp--;
+      }
+   }
+   if(nBinExp > 1023) {
+      uDouble = 0x7ff0000000000000;
+      goto Done;
+   }
+
+   /* 53 bits of mantissa, fewer for subnormals. Less than half the
+    * smallest subnormal rounds to zero. */
+   nBits = nBinExp < -1022 ? nBinExp + 1075 : 53;
+   if(nBits < 0) {
+      uDouble = 0;
+      goto Done;
+   }
+
+   /* Scale so that 2^(nBits-1) <= N / D < 2^nBits */
+   nShift = nBits - 1 - nBinExp;
+   if(nShift >= 0) {
+      JSONBig_ShiftLeft(&N, (unsigned)nShift);
+   } else {
+      JSONBig_ShiftLeft(&D, (unsigned)-nShift);
+   }
+
+   /* Long division leaving the remainder in N */
+   uQuotient = 0;
+   for(nBit = nBits - 1; nBit >= 0; nBit--) {
+      T = D;
+      JSONBig_ShiftLeft(&T, (unsigned)nBit);
+      if(JSONBig_Compare(&N, &T) >= 0) {
+         JSONBig_Subtract(&N, &T);
+         uQuotient |= (uint64_t)1 << nBit;
+      }
+   }
+
+   /* Round to nearest, ties to even */
+   JSONBig_ShiftLeft(&N, 1);
+   nShift = JSONBig_Compare(&N, &D);
+   if(nShift > 0 || (nShift == 0 && (uQuotient & 1))) {
+      uQuotient++;
+   }
+
+   if(nBinExp < -1022) {
+      /* Subnormal. A carry out makes it the smallest normal, which
+       * is right. */
+      uDouble = uQuotient;
+   } else {
+      /* The quotient's top bit adds one to the exponent field. A
+       * carry out of rounding adds another, which is also right and
+       * gives infinity at the top. */
+      uDouble = ((uint64_t)(nBinExp + 1022) << 52) + uQuotient;
+   }
+
+Done:
+   if(bNegative) {
+      uDouble |= 0x8000000000000000;
+   }
+   return UsefulBufUtil_CopyUint64ToDouble(uDouble);
+}
+#endif /* ! USEFULBUF_DISABLE_ALL_FLOAT && ! QCBOR_DISABLE_FLOAT_HW_USE */
+
+
+/*
+ * Convert a JSON number that can't be an integer to a double.
+ *
+ * When there are at most 19 significant digits, the mantissa is
+ * exactly representable as a double and the power of ten is one of
+ * those that is exactly representable, one multiply or divide gives
+ * the correctly rounded result. This is the well-known fast path
+ * from Clinger's algorithm. Other numbers go to JSON_ExactToDouble().
+ */
+static QCBORError
+JSON_AddFloat(JSONTokenizer *pMe,
+              const uint8_t *pStart,
+              bool           bNegative,
+              uint64_t       uMantissa,
+              int32_t        nExponent,
+              bool           bExact)
+{
+#ifdef USEFULBUF_DISABLE_ALL_FLOAT
+   (void)pMe;
+   (void)pStart;
+   (void)bNegative;
+   (void)uMantissa;
+   (void)nExponent;
+   (void)bExact;
+   return QCBOR_ERR_ALL_FLOAT_DISABLED;
+#elif defined(QCBOR_DISABLE_FLOAT_HW_USE)
+   (void)pMe;
+   (void)pStart;
+   (void)bNegative;
+   (void)uMantissa;
+   (void)nExponent;
+   (void)bExact;
+   return QCBOR_ERR_HW_FLOAT_DISABLED;
+#else
+   double dValue;
+
+   if(bExact &&
+      uMantissa <= JSON_MAX_EXACT_DOUBLE_INT &&
+      nExponent >= -22 && nExponent <= 22) {
+      dValue = (double)uMantissa;
+      if(nExponent < 0) {
+         dValue /= s_dPowersOfTen[-nExponent];
+      } else {
+         dValue *= s_dPowersOfTen[nExponent];
+      }
+      if(bNegative) {
+         dValue = -dValue;
+      }
+   } else {
+      /* The length limit keeps the big integers a fixed size */
+      if(pMe->pCur - pStart > QCBOR_JSON_MAX_NUMBER_LEN) {
+         return QCBOR_ERR_ENCODE_UNSUPPORTED;
+      }
+      dValue = JSON_ExactToDouble(pStart, pMe->pCur);
+   }
+
+   QCBOREncode_AddDouble(pMe->pEncodeCtx, dValue);
+
+   return QCBOR_SUCCESS;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+}
+
+
+/*
+ * Add a JSON number. pCur is at the minus sign or first digit.
+ *
+ * Numbers that are integers in the JSON and fit in a uint64_t or
+ * int64_t are added as CBOR integers. Everything else is a float.
+ *
+ * Digits are accumulated into a uint64_t mantissa as the syntax is
+ * checked. Digits that don't fit are counted in the exponent if they
+ * are before the decimal point and dropped if after. Either way the
+ * mantissa is then no longer exact.
+ */
+static QCBORError
+JSON_AddNumber(JSONTokenizer *pMe)
+{
+   const uint8_t *pStart    = pMe->pCur;
+   const uint8_t *pEnd      = pMe->pEnd;
+   const uint8_t *pCur      = pMe->pCur;
+   bool           bNegative = false;
+   bool           bIsInt    = true;
+   bool           bExact    = true;
+   uint64_t       uMantissa = 0;
+   int32_t        nExponent = 0;
+   int32_t        nExplicitExponent;
+   bool           bExponentNegative;
+   unsigned       uDigit;
+
+   if(*pCur == '-') {
+      bNegative = true;
+      pCur++;
+   }
+
+   /* Integer part. Leading zeros are not allowed. */
+   if(pCur >= pEnd || *pCur < '0' || *pCur > '9') {
+      return QCBOR_ERR_JSON_SYNTAX;
+   }
+   if(*pCur == '0') {
+      pCur++;
+   } else {
+      while(pCur < pEnd && *pCur >= '0' && *pCur <= '9') {
+         uDigit = (unsigned)(*pCur - '0');
+         if(uMantissa <= (UINT64_MAX - uDigit) / 10) {
+            uMantissa = uMantissa * 10 + uDigit;
+         } else {
+            bExact = false;
+            nExponent++;
+         }
+         pCur++;
+      }
+   }
+
+   /* Fraction part */
+   if(pCur < pEnd && *pCur == '.') {
+      bIsInt = false;
+      pCur++;
+      if(pCur >= pEnd || *pCur < '0' || *pCur > '9') {
+         return QCBOR_ERR_JSON_SYNTAX;
+      }
+      while(pCur < pEnd && *pCur >= '0' && *pCur <= '9') {
+         uDigit = (unsigned)(*pCur - '0');
+         if(bExact && uMantissa <= (UINT64_MAX - uDigit) / 10) {
+            uMantissa = uMantissa * 10 + uDigit;
+            nExponent--;
+         } else {
+            bExact = false;
+         }
+         pCur++;
+      }
+   }
+
+   /* Exponent part */
+   if(pCur < pEnd && (*pCur == 'e' || *pCur == 'E')) {
+      bIsInt = false;
+      pCur++;
+      bExponentNegative = false;
+      if(pCur < pEnd && (*pCur == '+' || *pCur == '-')) {
+         bExponentNegative = *pCur == '-';
+         pCur++;
+      }
+      if(pCur >= pEnd || *pCur < '0' || *pCur > '9') {
+         return QCBOR_ERR_JSON_SYNTAX;
+      }
+      nExplicitExponent = 0;
+      while(pCur < pEnd && *pCur >= '0' && *pCur <= '9') {
+         /* Stop accumulating well before overflow. Such exponents are
+          * only handled by JSON_ExactToDouble() anyway.
+          */
+         if(nExplicitExponent < 100000) {
+            nExplicitExponent = nExplicitExponent * 10 + (*pCur - '0');
+         }
+         pCur++;
+      }
+      nExponent += bExponentNegative ? -nExplicitExponent : nExplicitExponent;
+   }
+
+   pMe->pCur = pCur;
+
+   if(bIsInt && bExact) {
+      if(!bNegative) {
+         QCBOREncode_AddUInt64(pMe->pEncodeCtx, uMantissa);
+         return QCBOR_SUCCESS;
+      } else if(uMantissa <= (uint64_t)INT64_MAX + 1) {
+         /* Written this way to not overflow for INT64_MIN */
+         QCBOREncode_AddInt64(pMe->pEncodeCtx,
+                              uMantissa == 0 ? 0 : -(int64_t)(uMantissa - 1) - 1);
+         return QCBOR_SUCCESS;
+      }
+   }
+
+   return JSON_AddFloat(pMe, pStart, bNegative, uMantissa, nExponent, bExact);
+}
+
+
+
+/*
+ * == Tokenizing ==
+ */
+
+static inline void
+JSON_SkipWhiteSpace(JSONTokenizer *pMe)
+{
+   while(pMe->pCur < pMe->pEnd &&
+         (*pMe->pCur == ' '  || *pMe->pCur == '\n' ||
+          *pMe->pCur == '\r' || *pMe->pCur == '\t')) {
+      pMe->pCur++;
+   }
+}
+
+
+/* Returns the next byte or 0, which is never valid here, at the end */
+static inline uint8_t
+JSON_Peek(JSONTokenizer *pMe)
+{
+   return pMe->pCur < pMe->pEnd ? *pMe->pCur : 0;
+}
+
+
+static inline bool
+JSON_InObject(JSONTokenizer *pMe)
+{
+   return (pMe->uNestIsObject >> (pMe->uNestLevel - 1)) & 0x01;
+}
+
+
+static QCBORError
+JSON_AddLiteral(JSONTokenizer *pMe, const char *szLiteral)
+{
+   const size_t uLen = strlen(szLiteral);
+
+   if((size_t)(pMe->pEnd - pMe->pCur) < uLen ||
+      memcmp(pMe->pCur, szLiteral, uLen)) {
+      return QCBOR_ERR_JSON_SYNTAX;
+   }
+   pMe->pCur += uLen;
+
+   if(*szLiteral == 'n') {
+      QCBOREncode_AddNULL(pMe->pEncodeCtx);
+   } else {
+      QCBOREncode_AddBool(pMe->pEncodeCtx, *szLiteral == 't');
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Add an object member name as a map label and consume the colon
+ * after it. pCur is at the opening quote.
+ */
+static QCBORError
+JSON_AddLabel(JSONTokenizer *pMe)
+{
+   QCBORError uErr;
+
+   if(JSON_Peek(pMe) != '"') {
+      return QCBOR_ERR_JSON_SYNTAX;
+   }
+   uErr = JSON_AddString(pMe);
+   if(uErr != QCBOR_SUCCESS) {
+      return uErr;
+   }
+   JSON_SkipWhiteSpace(pMe);
+   if(JSON_Peek(pMe) != ':') {
+      return QCBOR_ERR_JSON_SYNTAX;
+   }
+   pMe->pCur++;
+
+   return QCBOR_SUCCESS;
+}
+
+
+static QCBORError
+JSON_Open(JSONTokenizer *pMe, bool bIsObject)
+{
+   if(pMe->uNestLevel >= QCBOR_MAX_ARRAY_NESTING) {
+      return QCBOR_ERR_ARRAY_NESTING_TOO_DEEP;
+   }
+
+   if(bIsObject) {
+      pMe->uNestIsObject |= (uint32_t)1 << pMe->uNestLevel;
+      QCBOREncode_OpenMap(pMe->pEncodeCtx);
+   } else {
+      pMe->uNestIsObject &= ~((uint32_t)1 << pMe->uNestLevel);
+      QCBOREncode_OpenArray(pMe->pEncodeCtx);
+   }
+   pMe->uNestLevel++;
+   pMe->pCur++;
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Close the current object or array if pCur is at the matching close
+ * bracket. Returns QCBOR_ERR_JSON_SYNTAX if not.
+ */
+static QCBORError
+JSON_Close(JSONTokenizer *pMe)
+{
+   if(JSON_InObject(pMe)) {
+      if(JSON_Peek(pMe) != '}') {
+         return QCBOR_ERR_JSON_SYNTAX;
+      }
+      if(pMe->uOptions & QCBOR_JSON_SORT_MAPS) {
+         QCBOREncode_CloseAndSortMap(pMe->pEncodeCtx);
+      } else {
+         QCBOREncode_CloseMap(pMe->pEncodeCtx);
+      }
+   } else {
+      if(JSON_Peek(pMe) != ']') {
+         return QCBOR_ERR_JSON_SYNTAX;
+      }
+      QCBOREncode_CloseArray(pMe->pEncodeCtx);
+   }
+   pMe->uNestLevel--;
+   pMe->pCur++;
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function. See qcbor/qcbor_json_encode.h
+ */
+void
+QCBOREncode_AddJSON(QCBOREncodeContext *pMe, UsefulBufC JSON, uint32_t uOptions)
+{
+   JSONTokenizer Tokenizer;
+   QCBORError    uErr = QCBOR_SUCCESS;
+   int           nExpect;
+   uint8_t       uNext;
+
+   if(pMe->uError != QCBOR_SUCCESS) {
+      return;
+   }
+
+   Tokenizer.pCur          = JSON.ptr;
+   Tokenizer.pEnd          = (const uint8_t *)JSON.ptr + JSON.len;
+   Tokenizer.pEncodeCtx    = pMe;
+   Tokenizer.uOptions      = uOptions;
+   Tokenizer.uNestIsObject = 0;
+   Tokenizer.uNestLevel    = 0;
+
+   nExpect = JSON_EXPECT_VALUE;
+   for(;;) {
+      JSON_SkipWhiteSpace(&Tokenizer);
+      uNext = JSON_Peek(&Tokenizer);
+
+      if(nExpect == JSON_EXPECT_FIRST) {
+         /* Just after the open of an object or array */
+         if(uNext == '}' || uNext == ']') {
+            uErr = JSON_Close(&Tokenizer);
+            nExpect = JSON_EXPECT_NEXT;
+         } else if(JSON_InObject(&Tokenizer)) {
+            uErr = JSON_AddLabel(&Tokenizer);
+            nExpect = JSON_EXPECT_VALUE;
+         } else {
+            uErr = QCBOR_SUCCESS;
+            nExpect = JSON_EXPECT_VALUE;
+         }
+
+      } else if(nExpect == JSON_EXPECT_NEXT) {
+         /* Just after a complete value */
+         if(Tokenizer.uNestLevel == 0) {
+            break;
+         }
+         if(uNext == ',') {
+            Tokenizer.pCur++;
+            uErr = QCBOR_SUCCESS;
+            if(JSON_InObject(&Tokenizer)) {
+               JSON_SkipWhiteSpace(&Tokenizer);
+               uErr = JSON_AddLabel(&Tokenizer);
+            }
+            nExpect = JSON_EXPECT_VALUE;
+         } else {
+            uErr = JSON_Close(&Tokenizer);
+         }
+
+      } else {
+         /* A value */
+         nExpect = JSON_EXPECT_NEXT;
+         switch(uNext) {
+            case '{':
+               uErr = JSON_Open(&Tokenizer, true);
+               nExpect = JSON_EXPECT_FIRST;
+               break;
+
+            case '[':
+               uErr = JSON_Open(&Tokenizer, false);
+               nExpect = JSON_EXPECT_FIRST;
+               break;
+
+            case '"':
+               uErr = JSON_AddString(&Tokenizer);
+               break;
+
+            case 't':
+               uErr = JSON_AddLiteral(&Tokenizer, "true");
+               break;
+
+            case 'f':
+               uErr = JSON_AddLiteral(&Tokenizer, "false");
+               break;
+
+            case 'n':
+               uErr = JSON_AddLiteral(&Tokenizer, "null");
+               break;
+
+            case '-':
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+               uErr = JSON_AddNumber(&Tokenizer);
+               break;
+
+            default:
+               uErr = QCBOR_ERR_JSON_SYNTAX;
+               break;
+         }
+      }
+
+      if(uErr != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+
+   /* Only white space may follow the one JSON value */
+   if(Tokenizer.pCur != Tokenizer.pEnd) {
+      uErr = QCBOR_ERR_JSON_SYNTAX;
+   }
+
+Done:
+   if(uErr != QCBOR_SUCCESS) {
+      pMe->uError = (uint8_t)uErr;
+   }
+}
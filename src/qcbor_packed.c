@@ -0,0 +1,771 @@
+/*==============================================================================
+ qcbor_packed.c -- Unpacking of Packed CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_packed.h"
+#include "qcbor_packed_private.h"
+#include "qcbor_encode_private.h"
+#include "qcbor_decode_private.h"
+
+
+/**
+ * @file qcbor_packed.c
+ *
+ * This implements QCBORPacked_Pack() and QCBORPacked_Unpack().
+ */
+
+
+
+
+/* ===========================================================================
+   Packed -- PACKING OF ENCODED CBOR
+
+   This implements QCBORPacked_Pack(). The first pass counts the
+   strings. The second outputs the tables and then the rump, which is
+   the input with the strings chosen replaced by references. A
+   reference is always one item so the counts in the heads of arrays
+   and maps are copied unchanged.
+   ===========================================================================*/
+
+/* Strings shorter than this, head included, are never shared */
+#define PACKED_MIN_SHARED_LEN         2
+
+
+typedef struct {
+   uint32_t uOffset; /* Of the head in the input */
+   uint32_t uLen;    /* Head included */
+   uint32_t uCount;  /* Times it occurs. 0 for an unused entry */
+   int32_t  nShared; /* Index in the shared table or -1 */
+} PackString;
+
+
+typedef struct {
+   UsefulBufC        Encoded;
+   const UsefulBufC *pPrefixes;
+   size_t            uNumPrefixes;
+   UsefulOutBuf      OutBuf;
+   PackString        aStrings[QCBOR_PACKED_MAX_STRINGS];
+} PackedPacker;
+
+
+/* Size of the head the encoder would output for an argument */
+static size_t
+Packed_HeadSize(uint64_t uArgument)
+{
+   if(uArgument < LEN_IS_ONE_BYTE) {
+      return 1;
+   } else if(uArgument <= UINT8_MAX) {
+      return 2;
+   } else if(uArgument <= UINT16_MAX) {
+      return 3;
+   } else if(uArgument <= UINT32_MAX) {
+      return 5;
+   } else {
+      return 9;
+   }
+}
+
+
+/* Size of a reference to shared item uIndex */
+static uint32_t
+Packed_SharedRefSize(uint32_t uIndex)
+{
+   if(uIndex < PACKED_NUM_SIMPLE_REFS) {
+      return 1;
+   }
+   /* Tag 6 and an integer that is half the rest of the index */
+   return 1 + (uint32_t)Packed_HeadSize((uIndex - PACKED_NUM_SIMPLE_REFS) / 2);
+}
+
+
+/*
+ * Find a string in the hash table or the empty entry to put it in.
+ * Returns NULL if it is not there and the table is full.
+ */
+static PackString *
+Packed_FindString(PackedPacker *pMe, UsefulBufC String)
+{
+   uint32_t    uIndex;
+   uint32_t    uProbes;
+   PackString *pEntry;
+
+   uIndex = HashEncodedLabel(String) % QCBOR_PACKED_MAX_STRINGS;
+   for(uProbes = 0; uProbes < QCBOR_PACKED_MAX_STRINGS; uProbes++) {
+      pEntry = &(pMe->aStrings[uIndex]);
+      if(pEntry->uCount == 0) {
+         return pEntry;
+      }
+      if(pEntry->uLen == String.len &&
+         memcmp((const uint8_t *)pMe->Encoded.ptr + pEntry->uOffset, String.ptr, String.len) == 0) {
+         return pEntry;
+      }
+      uIndex = (uIndex + 1) % QCBOR_PACKED_MAX_STRINGS;
+   }
+
+   return NULL;
+}
+
+
+/*
+ * Choose the shared items. Each slot in the shared table in turn gets
+ * the string that saves the most with the size of reference for that
+ * slot. The saving is the bytes saved by all the references less the
+ * string itself in the table.
+ */
+static uint32_t
+Packed_ChooseShared(PackedPacker *pMe)
+{
+   uint32_t    uSlot;
+   uint32_t    uIndex;
+   uint32_t    uRefSize;
+   uint64_t    uSaving;
+   uint64_t    uBestSaving;
+   PackString *pBest;
+   PackString *pString;
+
+   for(uSlot = 0; uSlot < QCBOR_PACKED_MAX_SHARED; uSlot++) {
+      uRefSize    = Packed_SharedRefSize(uSlot);
+      uBestSaving = 0;
+      pBest       = NULL;
+
+      for(uIndex = 0; uIndex < QCBOR_PACKED_MAX_STRINGS; uIndex++) {
+         pString = &(pMe->aStrings[uIndex]);
+         if(pString->uCount < 2 || pString->nShared >= 0 || pString->uLen <= uRefSize) {
+            continue;
+         }
+         uSaving = (uint64_t)pString->uCount * (pString->uLen - uRefSize);
+         if(uSaving > pString->uLen && uSaving - pString->uLen > uBestSaving) {
+            uBestSaving = uSaving - pString->uLen;
+            pBest       = pString;
+         }
+      }
+
+      if(pBest == NULL) {
+         break;
+      }
+      pBest->nShared = (int32_t)uSlot;
+   }
+
+   return uSlot;
+}
+
+
+/*
+ * Output a reference to a prefix in place of a text string if one of
+ * the prefixes starts it and the reference is smaller. Returns false
+ * if nothing was output.
+ */
+static bool
+Packed_OutputPrefixRef(PackedPacker *pMe, UsefulBufC String, size_t uEncodedLen)
+{
+   size_t     uIndex;
+   size_t     uBest;
+   size_t     uRefSize;
+   UsefulBufC Prefix;
+   UsefulBufC Rest;
+
+   uBest = SIZE_MAX;
+   for(uIndex = 0; uIndex < pMe->uNumPrefixes; uIndex++) {
+      Prefix = pMe->pPrefixes[uIndex];
+      if(Prefix.len <= String.len &&
+         memcmp(Prefix.ptr, String.ptr, Prefix.len) == 0 &&
+         (uBest == SIZE_MAX || Prefix.len > pMe->pPrefixes[uBest].len)) {
+         uBest = uIndex;
+      }
+   }
+   if(uBest == SIZE_MAX) {
+      return false;
+   }
+
+   Rest = UsefulBuf_Tail(String, pMe->pPrefixes[uBest].len);
+   uRefSize = Packed_HeadSize(PACKED_TAG_ARGUMENT_REF_FIRST + uBest) +
+              Packed_HeadSize(Rest.len) + Rest.len;
+   if(uRefSize >= uEncodedLen) {
+      return false;
+   }
+
+   Packed_AppendHead(&(pMe->OutBuf), CBOR_MAJOR_TYPE_TAG, PACKED_TAG_ARGUMENT_REF_FIRST + uBest);
+   Packed_AppendHead(&(pMe->OutBuf), CBOR_MAJOR_TYPE_TEXT_STRING, Rest.len);
+   UsefulOutBuf_AppendUsefulBuf(&(pMe->OutBuf), Rest);
+
+   return true;
+}
+
+
+static void
+Packed_OutputSharedRef(PackedPacker *pMe, uint32_t uIndex)
+{
+   if(uIndex < PACKED_NUM_SIMPLE_REFS) {
+      UsefulOutBuf_AppendByte(&(pMe->OutBuf), (uint8_t)(CBOR_MAJOR_TYPE_SIMPLE << 5 | uIndex));
+   } else {
+      uIndex -= PACKED_NUM_SIMPLE_REFS;
+      Packed_AppendHead(&(pMe->OutBuf), CBOR_MAJOR_TYPE_TAG, PACKED_TAG_SHARED_REF);
+      Packed_AppendHead(&(pMe->OutBuf),
+                        uIndex % 2 ? CBOR_MAJOR_TYPE_NEGATIVE_INT : CBOR_MAJOR_TYPE_POSITIVE_INT,
+                        uIndex / 2);
+   }
+}
+
+
+/*
+ * Walk over one data item in the input. When bOutput is false the
+ * strings are counted. When it is true the rump is output.
+ *
+ * This is the same walk as ConsumeEncodedItem(). Input that uses what
+ * Packed CBOR uses for references is rejected because it would be
+ * unpacked into something else.
+ */
+static QCBORError
+Packed_WalkItem(PackedPacker *pMe, bool bOutput)
+{
+   UsefulInputBuf InBuf;
+   uint64_t       uItemsLeft = 1;
+   uint64_t       uArgument;
+   uint8_t        uMajorType;
+   size_t         uHeadStart;
+   size_t         uHeadEnd;
+   QCBORError     uErr;
+   PackString    *pString;
+
+   UsefulInputBuf_Init(&InBuf, pMe->Encoded);
+
+   while(uItemsLeft > 0) {
+      uHeadStart = UsefulInputBuf_Tell(&InBuf);
+      uErr = ConsumeEncodedHead(&InBuf, &uMajorType, &uArgument);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+      if(UsefulInputBuf_GetError(&InBuf)) {
+         return QCBOR_ERR_HIT_END;
+      }
+      uHeadEnd = UsefulInputBuf_Tell(&InBuf);
+
+      switch(uMajorType) {
+         case CBOR_MAJOR_TYPE_BYTE_STRING:
+         case CBOR_MAJOR_TYPE_TEXT_STRING:
+            if(uArgument > UsefulInputBuf_BytesUnconsumed(&InBuf)) {
+               return QCBOR_ERR_HIT_END;
+            }
+            const UsefulBufC Content   = UsefulInputBuf_GetUsefulBuf(&InBuf, (size_t)uArgument);
+            const UsefulBufC WholeItem = {(const uint8_t *)pMe->Encoded.ptr + uHeadStart,
+                                          uHeadEnd - uHeadStart + Content.len};
+            pString = NULL;
+            if(WholeItem.len >= PACKED_MIN_SHARED_LEN) {
+               pString = Packed_FindString(pMe, WholeItem);
+            }
+            if(!bOutput) {
+               if(pString != NULL) {
+                  if(pString->uCount == 0) {
+                     pString->uOffset = (uint32_t)uHeadStart;
+                     pString->uLen    = (uint32_t)WholeItem.len;
+                  }
+                  pString->uCount++;
+               }
+            } else if(pString != NULL && pString->nShared >= 0) {
+               Packed_OutputSharedRef(pMe, (uint32_t)pString->nShared);
+            } else if(uMajorType != CBOR_MAJOR_TYPE_TEXT_STRING ||
+                      !Packed_OutputPrefixRef(pMe, Content, WholeItem.len)) {
+               UsefulOutBuf_AppendUsefulBuf(&(pMe->OutBuf), WholeItem);
+            }
+            uItemsLeft--;
+            continue;
+
+         case CBOR_MAJOR_TYPE_ARRAY:
+         case CBOR_MAJOR_TYPE_MAP:
+            if(uArgument > UsefulInputBuf_BytesUnconsumed(&InBuf)) {
+               return QCBOR_ERR_HIT_END;
+            }
+            uItemsLeft += uMajorType == CBOR_MAJOR_TYPE_MAP ? uArgument * 2 : uArgument;
+            break;
+
+         case CBOR_MAJOR_TYPE_TAG:
+            if(uArgument == PACKED_TAG_SHARED_REF ||
+               uArgument == PACKED_TAG_TABLE_SETUP ||
+               (uArgument >= PACKED_TAG_ARGUMENT_REF_FIRST && uArgument <= PACKED_TAG_ARGUMENT_REF_LAST) ||
+               (uArgument >= PACKED_TAG_ARGUMENT_REF2_FIRST &&
+                uArgument <= PACKED_TAG_ARGUMENT_REF2_LAST)) {
+               return QCBOR_ERR_ENCODE_UNSUPPORTED;
+            }
+            uItemsLeft += 1;
+            break;
+
+         case CBOR_MAJOR_TYPE_SIMPLE:
+            if(uHeadEnd - uHeadStart == 1 && uArgument < PACKED_NUM_SIMPLE_REFS) {
+               return QCBOR_ERR_ENCODE_UNSUPPORTED;
+            }
+            break;
+
+         default:
+            break;
+      }
+
+      if(bOutput) {
+         /* Not a string so the head is the whole item or just the
+          * start of it. Either way it is copied. */
+         UsefulOutBuf_AppendData(&(pMe->OutBuf),
+                                 (const uint8_t *)pMe->Encoded.ptr + uHeadStart,
+                                 uHeadEnd - uHeadStart);
+      }
+      uItemsLeft--;
+   }
+
+   if(UsefulInputBuf_BytesUnconsumed(&InBuf) != 0) {
+      return QCBOR_ERR_EXTRA_BYTES;
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function. See qcbor_packed.h
+ */
+QCBORError
+QCBORPacked_Pack(UsefulBufC        Encoded,
+                 const UsefulBufC *pPrefixes,
+                 size_t            uNumPrefixes,
+                 UsefulBuf         Buffer,
+                 UsefulBufC       *pPacked)
+{
+   QCBORError   uReturn;
+   PackedPacker Me;
+   uint32_t     uNumShared;
+   uint32_t     uSlot;
+   uint32_t     uIndex;
+   size_t       uPrefix;
+
+   if(uNumPrefixes > QCBOR_PACKED_MAX_ARGUMENTS) {
+      uReturn = QCBOR_ERR_ARRAY_TOO_LONG;
+      goto Done;
+   }
+   if(Encoded.len > UINT32_MAX) {
+      uReturn = QCBOR_ERR_BUFFER_TOO_LARGE;
+      goto Done;
+   }
+
+   memset(Me.aStrings, 0, sizeof(Me.aStrings));
+   for(uIndex = 0; uIndex < QCBOR_PACKED_MAX_STRINGS; uIndex++) {
+      Me.aStrings[uIndex].nShared = -1;
+   }
+   Me.Encoded      = Encoded;
+   Me.pPrefixes    = pPrefixes;
+   Me.uNumPrefixes = uNumPrefixes;
+   UsefulOutBuf_Init(&Me.OutBuf, Buffer);
+
+   uReturn = Packed_WalkItem(&Me, false);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   uNumShared = Packed_ChooseShared(&Me);
+
+   Packed_AppendHead(&Me.OutBuf, CBOR_MAJOR_TYPE_TAG, PACKED_TAG_TABLE_SETUP);
+   Packed_AppendHead(&Me.OutBuf, CBOR_MAJOR_TYPE_ARRAY, 3);
+
+   Packed_AppendHead(&Me.OutBuf, CBOR_MAJOR_TYPE_ARRAY, uNumShared);
+   for(uSlot = 0; uSlot < uNumShared; uSlot++) {
+      for(uIndex = 0; Me.aStrings[uIndex].nShared != (int32_t)uSlot; uIndex++);
+      UsefulOutBuf_AppendData(&Me.OutBuf,
+                              (const uint8_t *)Encoded.ptr + Me.aStrings[uIndex].uOffset,
+                              Me.aStrings[uIndex].uLen);
+   }
+
+   Packed_AppendHead(&Me.OutBuf, CBOR_MAJOR_TYPE_ARRAY, uNumPrefixes);
+   for(uPrefix = 0; uPrefix < uNumPrefixes; uPrefix++) {
+      Packed_AppendHead(&Me.OutBuf, CBOR_MAJOR_TYPE_TEXT_STRING, pPrefixes[uPrefix].len);
+      UsefulOutBuf_AppendUsefulBuf(&Me.OutBuf, pPrefixes[uPrefix]);
+   }
+
+   /* The first pass succeeded so this does too */
+   (void)Packed_WalkItem(&Me, true);
+
+   if(UsefulOutBuf_GetError(&Me.OutBuf)) {
+      uReturn = QCBOR_ERR_BUFFER_TOO_SMALL;
+      goto Done;
+   }
+   *pPacked = UsefulOutBuf_OutUBuf(&Me.OutBuf);
+
+Done:
+   return uReturn;
+}
+
+
+
+
+/* ===========================================================================
+   Unpack -- UNPACKING OF PACKED CBOR
+
+   This implements QCBORPacked_Unpack(). The rump is copied a head at
+   a time with references replaced by the table items they refer to.
+   Table items are found by offsets recorded when the tables are first
+   skipped over.
+   ===========================================================================*/
+
+/* How deep references in shared items to other shared items can go.
+ * This is what stops references that loop. */
+#define PACKED_MAX_REF_DEPTH           8
+
+
+typedef struct {
+   UsefulBufC   Packed;
+   UsefulOutBuf OutBuf;
+   /* Offset of each table item, plus the end of the last */
+   uint32_t     auShared[QCBOR_PACKED_MAX_SHARED + 1];
+   uint32_t     auArgument[QCBOR_PACKED_MAX_ARGUMENTS + 1];
+   uint32_t     uNumShared;
+   uint32_t     uNumArguments;
+   /* Items output for references in shared items. See
+    * QCBOR_PACKED_MAX_EXPANDED_ITEMS. */
+   uint32_t     uExpandedItems;
+} PackedUnpacker;
+
+
+/* Skip over a table recording where each item in it starts */
+static QCBORError
+Packed_ReadTable(UsefulInputBuf *pInBuf,
+                 uint32_t       *puOffsets,
+                 uint32_t        uMaxItems,
+                 uint32_t       *puNumItems)
+{
+   QCBORError uReturn;
+   int        nMajorType;
+   int        nAdditionalInfo;
+   uint64_t   uCount;
+   uint32_t   uIndex;
+
+   uReturn = DecodeHead(pInBuf, &nMajorType, &uCount, &nAdditionalInfo);
+   if(uReturn != QCBOR_SUCCESS) {
+      return uReturn;
+   }
+   if(nMajorType != CBOR_MAJOR_TYPE_ARRAY || nAdditionalInfo == LEN_IS_INDEFINITE) {
+      return QCBOR_ERR_BAD_TAG_CONTENT;
+   }
+   if(uCount > uMaxItems) {
+      return QCBOR_ERR_ARRAY_DECODE_TOO_LONG;
+   }
+
+   for(uIndex = 0; uIndex < uCount; uIndex++) {
+      /* The input is limited to QCBOR_MAX_DECODE_INPUT_SIZE so
+       * offsets fit in 32 bits */
+      puOffsets[uIndex] = (uint32_t)UsefulInputBuf_Tell(pInBuf);
+      uReturn = QCBORDecode_Private_SkipItem(pInBuf);
+      if(uReturn != QCBOR_SUCCESS) {
+         return uReturn;
+      }
+   }
+   puOffsets[uIndex] = (uint32_t)UsefulInputBuf_Tell(pInBuf);
+   *puNumItems = uIndex;
+
+   return QCBOR_SUCCESS;
+}
+
+
+static QCBORError
+Packed_ExpandItem(PackedUnpacker *pMe, UsefulInputBuf *pInBuf, int nDepth);
+
+
+/* Output shared item uIndex with the references in it expanded */
+static QCBORError
+Packed_ExpandShared(PackedUnpacker *pMe, uint64_t uIndex, int nDepth)
+{
+   UsefulInputBuf TableInBuf;
+
+   if(uIndex >= pMe->uNumShared || nDepth >= PACKED_MAX_REF_DEPTH) {
+      return QCBOR_ERR_BAD_TAG_CONTENT;
+   }
+
+   UsefulInputBuf_Init(&TableInBuf, pMe->Packed);
+   UsefulInputBuf_Seek(&TableInBuf, pMe->auShared[uIndex]);
+
+   return Packed_ExpandItem(pMe, &TableInBuf, nDepth + 1);
+}
+
+
+/* Output argument item uIndex followed by the string that is the
+ * content of the reference */
+static QCBORError
+Packed_ExpandArgument(PackedUnpacker *pMe, UsefulInputBuf *pInBuf, uint64_t uIndex)
+{
+   QCBORError     uReturn;
+   UsefulInputBuf TableInBuf;
+   int            nMajorType;
+   int            nPrefixMajorType;
+   int            nAdditionalInfo;
+   uint64_t       uLen;
+   uint64_t       uPrefixLen;
+   UsefulBufC     Prefix;
+   UsefulBufC     Rest;
+
+   if(uIndex >= pMe->uNumArguments) {
+      return QCBOR_ERR_BAD_TAG_CONTENT;
+   }
+
+   UsefulInputBuf_Init(&TableInBuf, pMe->Packed);
+   UsefulInputBuf_Seek(&TableInBuf, pMe->auArgument[uIndex]);
+   uReturn = DecodeHead(&TableInBuf, &nPrefixMajorType, &uPrefixLen, &nAdditionalInfo);
+   if(uReturn != QCBOR_SUCCESS) {
+      return uReturn;
+   }
+   if((nPrefixMajorType != CBOR_MAJOR_TYPE_TEXT_STRING &&
+       nPrefixMajorType != CBOR_MAJOR_TYPE_BYTE_STRING) ||
+      nAdditionalInfo == LEN_IS_INDEFINITE) {
+      return QCBOR_ERR_BAD_TAG_CONTENT;
+   }
+   Prefix = UsefulInputBuf_GetUsefulBuf(&TableInBuf, (size_t)uPrefixLen);
+
+   uReturn = DecodeHead(pInBuf, &nMajorType, &uLen, &nAdditionalInfo);
+   if(uReturn != QCBOR_SUCCESS) {
+      return uReturn;
+   }
+   if(nMajorType != nPrefixMajorType || nAdditionalInfo == LEN_IS_INDEFINITE) {
+      return QCBOR_ERR_BAD_TAG_CONTENT;
+   }
+   if(uLen > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+      return QCBOR_ERR_HIT_END;
+   }
+   Rest = UsefulInputBuf_GetUsefulBuf(pInBuf, (size_t)uLen);
+
+   Packed_AppendHead(&(pMe->OutBuf), (uint8_t)nMajorType, Prefix.len + Rest.len);
+   UsefulOutBuf_AppendUsefulBuf(&(pMe->OutBuf), Prefix);
+   UsefulOutBuf_AppendUsefulBuf(&(pMe->OutBuf), Rest);
+
+   return QCBOR_SUCCESS;
+}
+
+
+/**
+ * @brief Output one item with the references in it expanded.
+ *
+ * @param[in] pMe      The unpacker.
+ * @param[in] pInBuf   Positioned at the item. Positioned after it on
+ *                     return.
+ * @param[in] nDepth   How many shared items this is in.
+ *
+ * This walks the item like QCBORDecode_Private_SkipItem() does, but
+ * copies the heads and string contents to the output as it goes. A
+ * reference is one item in the array or map it is in, however big
+ * what it refers to is.
+ *
+ * References in shared items can make the output very much bigger
+ * than the input. This stops as soon as the output doesn't fit and
+ * when the items output for shared items reach
+ * QCBOR_PACKED_MAX_EXPANDED_ITEMS so even computing the size takes
+ * bounded time.
+ */
+static QCBORError
+Packed_ExpandItem(PackedUnpacker *pMe, UsefulInputBuf *pInBuf, int nDepth)
+{
+   QCBORError uReturn;
+   uint64_t   auLeft[QCBOR_MAX_ARRAY_NESTING + 2];
+   int        nLevel;
+   int        nMajorType;
+   int        nAdditionalInfo;
+   uint64_t   uArgument;
+   size_t     uHeadStart;
+
+   nLevel     = 0;
+   auLeft[0]  = 1;
+
+   for(;;) {
+      if(UsefulOutBuf_GetError(&(pMe->OutBuf))) {
+         uReturn = QCBOR_ERR_BUFFER_TOO_SMALL;
+         goto Done;
+      }
+      if(nDepth > 0) {
+         if(pMe->uExpandedItems >= QCBOR_PACKED_MAX_EXPANDED_ITEMS) {
+            uReturn = QCBOR_ERR_INPUT_TOO_LARGE;
+            goto Done;
+         }
+         pMe->uExpandedItems++;
+      }
+
+      uHeadStart = UsefulInputBuf_Tell(pInBuf);
+      uReturn = DecodeHead(pInBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+
+      if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo < PACKED_NUM_SIMPLE_REFS) {
+         uReturn = Packed_ExpandShared(pMe, (uint64_t)nAdditionalInfo, nDepth);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+
+      } else if(nMajorType == CBOR_MAJOR_TYPE_TAG && uArgument == PACKED_TAG_SHARED_REF) {
+         /* The index is the tag content. Both integer types are used
+          * to make the references to the first 48 shared items two
+          * bytes. */
+         uReturn = DecodeHead(pInBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+         if((nMajorType != CBOR_MAJOR_TYPE_POSITIVE_INT &&
+             nMajorType != CBOR_MAJOR_TYPE_NEGATIVE_INT) ||
+            uArgument >= QCBOR_PACKED_MAX_SHARED) {
+            uReturn = QCBOR_ERR_BAD_TAG_CONTENT;
+            goto Done;
+         }
+         uArgument = PACKED_NUM_SIMPLE_REFS + uArgument * 2 +
+                     (nMajorType == CBOR_MAJOR_TYPE_NEGATIVE_INT ? 1 : 0);
+         uReturn = Packed_ExpandShared(pMe, uArgument, nDepth);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+
+      } else if(nMajorType == CBOR_MAJOR_TYPE_TAG &&
+                uArgument >= PACKED_TAG_ARGUMENT_REF_FIRST &&
+                uArgument <= PACKED_TAG_ARGUMENT_REF_LAST) {
+         uReturn = Packed_ExpandArgument(pMe, pInBuf, uArgument - PACKED_TAG_ARGUMENT_REF_FIRST);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+
+      } else if(nMajorType == CBOR_MAJOR_TYPE_TAG &&
+                uArgument >= PACKED_TAG_ARGUMENT_REF2_FIRST &&
+                uArgument <= PACKED_TAG_ARGUMENT_REF2_LAST) {
+         uArgument = uArgument - PACKED_TAG_ARGUMENT_REF2_FIRST +
+                     (PACKED_TAG_ARGUMENT_REF_LAST - PACKED_TAG_ARGUMENT_REF_FIRST + 1);
+         uReturn = Packed_ExpandArgument(pMe, pInBuf, uArgument);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+
+      } else {
+         /* Not a reference. Copy the head. */
+         UsefulOutBuf_AppendData(&(pMe->OutBuf),
+                                 (const uint8_t *)pMe->Packed.ptr + uHeadStart,
+                                 UsefulInputBuf_Tell(pInBuf) - uHeadStart);
+
+         if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == LEN_IS_INDEFINITE) {
+            if(nLevel == 0 || auLeft[nLevel] != SKIP_INDEFINITE) {
+               uReturn = QCBOR_ERR_BAD_BREAK;
+               goto Done;
+            }
+            nLevel--;
+
+         } else if(nMajorType == CBOR_MAJOR_TYPE_TAG) {
+            /* The tag content is the rest of the item */
+            continue;
+
+         } else if(nAdditionalInfo == LEN_IS_INDEFINITE ||
+                   ((nMajorType == CBOR_MAJOR_TYPE_ARRAY || nMajorType == CBOR_MAJOR_TYPE_MAP) &&
+                    uArgument > 0)) {
+            if(nLevel >= QCBOR_MAX_ARRAY_NESTING + 1) {
+               uReturn = QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP;
+               goto Done;
+            }
+            if(nAdditionalInfo != LEN_IS_INDEFINITE &&
+               uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+               uReturn = QCBOR_ERR_HIT_END;
+               goto Done;
+            }
+            nLevel++;
+            if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+               auLeft[nLevel] = SKIP_INDEFINITE;
+            } else {
+               auLeft[nLevel] = nMajorType == CBOR_MAJOR_TYPE_MAP ? uArgument * 2 : uArgument;
+            }
+            continue;
+
+         } else if(nMajorType == CBOR_MAJOR_TYPE_BYTE_STRING ||
+                   nMajorType == CBOR_MAJOR_TYPE_TEXT_STRING) {
+            if(uArgument > UsefulInputBuf_BytesUnconsumed(pInBuf)) {
+               uReturn = QCBOR_ERR_HIT_END;
+               goto Done;
+            }
+            UsefulOutBuf_AppendUsefulBuf(&(pMe->OutBuf),
+                                         UsefulInputBuf_GetUsefulBuf(pInBuf, (size_t)uArgument));
+         }
+      }
+
+      /* An item is done. That may finish the arrays and maps it is in. */
+      while(auLeft[nLevel] != SKIP_INDEFINITE && --auLeft[nLevel] == 0) {
+         if(nLevel == 0) {
+            goto Done;
+         }
+         nLevel--;
+      }
+   }
+
+Done:
+   return uReturn;
+}
+
+
+/*
+ * Public function. See qcbor_packed.h
+ */
+QCBORError
+QCBORPacked_Unpack(UsefulBufC Packed, UsefulBuf Buffer, UsefulBufC *pUnpacked)
+{
+   QCBORError     uReturn;
+   PackedUnpacker Me;
+   UsefulInputBuf InBuf;
+   int            nMajorType;
+   int            nAdditionalInfo;
+   uint64_t       uArgument;
+
+   Me.Packed         = Packed;
+   Me.uExpandedItems = 0;
+   UsefulOutBuf_Init(&Me.OutBuf, Buffer);
+   UsefulInputBuf_Init(&InBuf, Packed);
+
+   uReturn = DecodeHead(&InBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+   if(uReturn != QCBOR_SUCCESS ||
+      nMajorType != CBOR_MAJOR_TYPE_TAG ||
+      uArgument != PACKED_TAG_TABLE_SETUP) {
+      /* Not packed */
+      UsefulOutBuf_AppendUsefulBuf(&Me.OutBuf, Packed);
+      uReturn = QCBOR_SUCCESS;
+      goto Finish;
+   }
+
+   if(Packed.len > QCBOR_MAX_DECODE_INPUT_SIZE) {
+      uReturn = QCBOR_ERR_INPUT_TOO_LARGE;
+      goto Done;
+   }
+
+   uReturn = DecodeHead(&InBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   if(nMajorType != CBOR_MAJOR_TYPE_ARRAY || uArgument != 3 ||
+      nAdditionalInfo == LEN_IS_INDEFINITE) {
+      uReturn = QCBOR_ERR_BAD_TAG_CONTENT;
+      goto Done;
+   }
+
+   uReturn = Packed_ReadTable(&InBuf, Me.auShared, QCBOR_PACKED_MAX_SHARED, &Me.uNumShared);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   uReturn = Packed_ReadTable(&InBuf, Me.auArgument, QCBOR_PACKED_MAX_ARGUMENTS, &Me.uNumArguments);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   uReturn = Packed_ExpandItem(&Me, &InBuf, 0);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   if(UsefulInputBuf_BytesUnconsumed(&InBuf) != 0) {
+      uReturn = QCBOR_ERR_EXTRA_BYTES;
+      goto Done;
+   }
+
+Finish:
+   if(UsefulOutBuf_GetError(&Me.OutBuf)) {
+      uReturn = QCBOR_ERR_BUFFER_TOO_SMALL;
+      goto Done;
+   }
+   *pUnpacked = UsefulOutBuf_OutUBuf(&Me.OutBuf);
+
+Done:
+   return uReturn;
+}
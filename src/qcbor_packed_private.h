@@ -0,0 +1,53 @@
+/*==============================================================================
+ qcbor_packed_private.h -- What packing and unpacking share
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_packed_private_h
+#define qcbor_packed_private_h
+
+
+#include "qcbor/UsefulBuf.h"
+#include "qcbor/qcbor_common.h"
+
+
+/* The tag numbers and simple values of Packed CBOR */
+#define PACKED_TAG_TABLE_SETUP         113
+#define PACKED_TAG_SHARED_REF          6
+#define PACKED_TAG_ARGUMENT_REF_FIRST  224
+#define PACKED_TAG_ARGUMENT_REF_LAST   255
+#define PACKED_TAG_ARGUMENT_REF2_FIRST 28704
+#define PACKED_TAG_ARGUMENT_REF2_LAST  32767
+#define PACKED_NUM_SIMPLE_REFS         16
+
+
+/* Output a head with the argument in its shortest form */
+static inline void
+Packed_AppendHead(UsefulOutBuf *pOutBuf, uint8_t uMajorType, uint64_t uArgument)
+{
+   const uint8_t uMajorBits = (uint8_t)(uMajorType << 5);
+
+   if(uArgument < LEN_IS_ONE_BYTE) {
+      UsefulOutBuf_AppendByte(pOutBuf, (uint8_t)(uMajorBits | uArgument));
+   } else if(uArgument <= UINT8_MAX) {
+      UsefulOutBuf_AppendByte(pOutBuf, uMajorBits | LEN_IS_ONE_BYTE);
+      UsefulOutBuf_AppendByte(pOutBuf, (uint8_t)uArgument);
+   } else if(uArgument <= UINT16_MAX) {
+      UsefulOutBuf_AppendByte(pOutBuf, uMajorBits | LEN_IS_TWO_BYTES);
+      UsefulOutBuf_AppendUint16(pOutBuf, (uint16_t)uArgument);
+   } else if(uArgument <= UINT32_MAX) {
+      UsefulOutBuf_AppendByte(pOutBuf, uMajorBits | LEN_IS_FOUR_BYTES);
+      UsefulOutBuf_AppendUint32(pOutBuf, (uint32_t)uArgument);
+   } else {
+      UsefulOutBuf_AppendByte(pOutBuf, uMajorBits | LEN_IS_EIGHT_BYTES);
+      UsefulOutBuf_AppendUint64(pOutBuf, uArgument);
+   }
+}
+
+
+#endif /* qcbor_packed_private_h */
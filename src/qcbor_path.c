@@ -0,0 +1,380 @@
+/*==============================================================================
+ qcbor_path.c -- Getting items by path expressions in one traversal
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_path.h"
+#include "qcbor_decode_private.h"
+
+
+/**
+ * @file qcbor_path.c
+ *
+ * Traversal keeps a 32-bit mask for each nesting level with a bit set
+ * for each path that matched the map or array being traversed at
+ * that level. An item is only compared to the step of the paths in
+ * its parent's mask. Maps and arrays no path goes into are skipped
+ * by decoding only their heads.
+ */
+
+
+#define PATH_STEP_TEXT_LABEL 1
+#define PATH_STEP_INT_LABEL  2
+#define PATH_STEP_ANY_LABEL  3
+#define PATH_STEP_INDEX      4
+#define PATH_STEP_ANY_INDEX  5
+
+
+static bool
+Path_IsNameChar(char c)
+{
+   return (c >= 'a' && c <= 'z') ||
+          (c >= 'A' && c <= 'Z') ||
+          (c >= '0' && c <= '9') ||
+          c == '_' || c == '-';
+}
+
+
+/* Parse a decimal integer that takes up all of Text. Returns false if
+ * it isn't one or doesn't fit in an int64_t. */
+static bool
+Path_ParseInt(UsefulBufC Text, int64_t *pnValue)
+{
+   const char *p    = (const char *)Text.ptr;
+   size_t      uLen = Text.len;
+   bool        bNeg = false;
+   uint64_t    uValue = 0;
+
+   if(uLen > 0 && *p == '-') {
+      bNeg = true;
+      p++;
+      uLen--;
+   }
+   if(uLen == 0) {
+      return false;
+   }
+   for(; uLen > 0; p++, uLen--) {
+      if(*p < '0' || *p > '9') {
+         return false;
+      }
+      if(uValue > ((uint64_t)INT64_MAX + 1) / 10) {
+         return false;
+      }
+      uValue = uValue * 10 + (uint64_t)(*p - '0');
+   }
+   if(uValue > (uint64_t)INT64_MAX + (bNeg ? 1 : 0)) {
+      return false;
+   }
+
+   /* Done in unsigned so -INT64_MAX-1 doesn't overflow */
+   *pnValue = bNeg ? (int64_t)(0 - uValue) : (int64_t)uValue;
+   return true;
+}
+
+
+/* Compiles one path into pSteps. Returns the error and the number of
+ * steps in *puNumSteps. */
+static QCBORError
+Path_CompileOne(const char    *szPath,
+                QCBORPathStep *pSteps,
+                size_t         uMaxSteps,
+                size_t        *puNumSteps)
+{
+   const char *p = szPath;
+   size_t      uNumSteps = 0;
+   QCBORPathStep Step;
+
+   while(*p != '\0') {
+      Step.nValue = 0;
+      if(*p == '[') {
+         /* Array index or [*] */
+         const char *pStart = ++p;
+         while(*p != ']' && *p != '\0') {
+            p++;
+         }
+         if(*p != ']') {
+            return QCBOR_ERR_PATH_SYNTAX;
+         }
+         const UsefulBufC Index = {pStart, (size_t)(p - pStart)};
+         p++;
+         if(Index.len == 1 && *pStart == '*') {
+            Step.uType = PATH_STEP_ANY_INDEX;
+         } else if(*pStart != '-' && Path_ParseInt(Index, &Step.nValue)) {
+            Step.uType = PATH_STEP_INDEX;
+         } else {
+            return QCBOR_ERR_PATH_SYNTAX;
+         }
+         Step.Label = NULLUsefulBufC;
+
+      } else {
+         /* Map label. The leading '.' is optional on the first step. */
+         if(*p == '.') {
+            p++;
+         } else if(uNumSteps != 0) {
+            return QCBOR_ERR_PATH_SYNTAX;
+         }
+
+         if(*p == '"') {
+            const char *pStart = ++p;
+            while(*p != '"' && *p != '\0') {
+               p++;
+            }
+            if(*p != '"') {
+               return QCBOR_ERR_PATH_SYNTAX;
+            }
+            Step.uType = PATH_STEP_TEXT_LABEL;
+            Step.Label = (UsefulBufC){pStart, (size_t)(p - pStart)};
+            p++;
+
+         } else if(*p == '*') {
+            Step.uType = PATH_STEP_ANY_LABEL;
+            Step.Label = NULLUsefulBufC;
+            p++;
+
+         } else {
+            const char *pStart = p;
+            while(Path_IsNameChar(*p)) {
+               p++;
+            }
+            Step.Label = (UsefulBufC){pStart, (size_t)(p - pStart)};
+            if(Step.Label.len == 0) {
+               return QCBOR_ERR_PATH_SYNTAX;
+            }
+            if(Path_ParseInt(Step.Label, &Step.nValue)) {
+               Step.uType = PATH_STEP_INT_LABEL;
+               Step.Label = NULLUsefulBufC;
+            } else {
+               Step.uType = PATH_STEP_TEXT_LABEL;
+            }
+         }
+      }
+
+      if(uNumSteps >= QCBOR_MAX_ARRAY_NESTING) {
+         return QCBOR_ERR_ARRAY_NESTING_TOO_DEEP;
+      }
+      if(uNumSteps >= uMaxSteps) {
+         return QCBOR_ERR_BUFFER_TOO_SMALL;
+      }
+      pSteps[uNumSteps++] = Step;
+   }
+
+   *puNumSteps = uNumSteps;
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_path.h file
+ */
+QCBORError
+QCBORPath_Compile(const char *const *pszPaths,
+                  size_t             uNumPaths,
+                  QCBORPathStep     *pSteps,
+                  size_t             uMaxSteps,
+                  QCBORPathSet      *pSet)
+{
+   QCBORError uErr;
+   size_t     uPath;
+   size_t     uUsed = 0;
+   size_t     uNumSteps;
+
+   if(uNumPaths > QCBOR_PATH_MAX_PATHS) {
+      return QCBOR_ERR_ARRAY_TOO_LONG;
+   }
+   /* So the index of the first step fits in a uint16_t */
+   if(uMaxSteps > UINT16_MAX) {
+      uMaxSteps = UINT16_MAX;
+   }
+
+   for(uPath = 0; uPath < uNumPaths; uPath++) {
+      uErr = Path_CompileOne(pszPaths[uPath],
+                             pSteps + uUsed,
+                             uMaxSteps - uUsed,
+                             &uNumSteps);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+      /* Casts are safe because of the checks on the number of steps */
+      pSet->auFirstStep[uPath] = (uint16_t)uUsed;
+      pSet->auNumSteps[uPath]  = (uint8_t)uNumSteps;
+      uUsed += uNumSteps;
+   }
+
+   pSet->pSteps    = pSteps;
+   pSet->uNumPaths = (uint8_t)uNumPaths;
+
+   return QCBOR_SUCCESS;
+}
+
+
+/* Whether an item matches a step. uIndex is the item's index in its
+ * array, used when it has no label. */
+static bool
+Path_StepMatches(const QCBORPathStep *pStep, const QCBORItem *pItem, uint32_t uIndex)
+{
+   switch(pStep->uType) {
+      case PATH_STEP_TEXT_LABEL:
+         return pItem->uLabelType == QCBOR_TYPE_TEXT_STRING &&
+                UsefulBuf_Compare(pItem->label.string, pStep->Label) == 0;
+
+      case PATH_STEP_INT_LABEL:
+         return pItem->uLabelType == QCBOR_TYPE_INT64 &&
+                pItem->label.int64 == pStep->nValue;
+
+      case PATH_STEP_ANY_LABEL:
+         return pItem->uLabelType != QCBOR_TYPE_NONE;
+
+      case PATH_STEP_INDEX:
+         return pItem->uLabelType == QCBOR_TYPE_NONE &&
+                (int64_t)uIndex == pStep->nValue;
+
+      case PATH_STEP_ANY_INDEX:
+         return pItem->uLabelType == QCBOR_TYPE_NONE;
+
+      default:
+         return false;
+   }
+}
+
+
+/* Record a match in the item array and call the callback */
+static QCBORError
+Path_Matched(QCBORItem         *pItems,
+             size_t             uPath,
+             const QCBORItem   *pItem,
+             void              *pCallbackCtx,
+             QCBORPathCallback  pfCallback)
+{
+   if(pItems != NULL && pItems[uPath].uDataType == QCBOR_TYPE_NONE) {
+      pItems[uPath] = *pItem;
+   }
+   if(pfCallback != NULL) {
+      return (*pfCallback)(pCallbackCtx, uPath, pItem);
+   }
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_path.h file
+ */
+void
+QCBORDecode_GetPaths(QCBORDecodeContext *pMe,
+                     const QCBORPathSet *pSet,
+                     QCBORItem          *pItems,
+                     void               *pCallbackCtx,
+                     QCBORPathCallback   pfCallback)
+{
+   QCBORError uErr;
+   QCBORItem  Item;
+   size_t     uPath;
+   uint8_t    uBaseLevel;
+   uint32_t   uMatched;
+   uint32_t   uDeeper;
+
+   /* For the map or array being traversed at each level relative to
+    * the starting item, the paths that matched it and the index of the
+    * next item in it. */
+   uint32_t   auActive[QCBOR_MAX_ARRAY_NESTING + 2];
+   uint32_t   auIndex[QCBOR_MAX_ARRAY_NESTING + 2];
+
+   if(pItems != NULL) {
+      for(uPath = 0; uPath < pSet->uNumPaths; uPath++) {
+         pItems[uPath].uDataType  = QCBOR_TYPE_NONE;
+         pItems[uPath].uLabelType = QCBOR_TYPE_NONE;
+      }
+   }
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      return;
+   }
+
+   uErr = QCBORDecode_GetNext(pMe, &Item);
+   if(uErr != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   uBaseLevel = Item.uNestingLevel;
+
+   /* The starting item matches the empty paths and all the others go
+    * into it. */
+   uDeeper = 0;
+   for(uPath = 0; uPath < pSet->uNumPaths; uPath++) {
+      if(pSet->auNumSteps[uPath] == 0) {
+         uErr = Path_Matched(pItems, uPath, &Item, pCallbackCtx, pfCallback);
+         if(uErr != QCBOR_SUCCESS) {
+            goto Done;
+         }
+      } else {
+         uDeeper |= (uint32_t)1 << uPath;
+      }
+   }
+   auActive[1] = uDeeper;
+   auIndex[1]  = 0;
+   if(uDeeper == 0) {
+      uErr = QCBORDecode_Private_SkipContents(pMe, &Item);
+      if(uErr != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+
+   while(Item.uNextNestLevel > uBaseLevel) {
+      uErr = QCBORDecode_GetNext(pMe, &Item);
+      if(uErr != QCBOR_SUCCESS) {
+         goto Done;
+      }
+
+      /* uNestingLevel is always greater than uBaseLevel here and the
+       * decoder limits nesting, so this is in the bounds of auActive. */
+      const size_t   uLevel = (size_t)(Item.uNestingLevel - uBaseLevel);
+      const uint32_t uIndex = auIndex[uLevel]++;
+
+      uMatched = 0;
+      uDeeper  = 0;
+      for(uPath = 0; uPath < pSet->uNumPaths; uPath++) {
+         if(!(auActive[uLevel] & ((uint32_t)1 << uPath))) {
+            continue;
+         }
+         const QCBORPathStep *pStep = &(pSet->pSteps[pSet->auFirstStep[uPath] + uLevel - 1]);
+         if(!Path_StepMatches(pStep, &Item, uIndex)) {
+            continue;
+         }
+         if(pSet->auNumSteps[uPath] == uLevel) {
+            uMatched |= (uint32_t)1 << uPath;
+         } else {
+            uDeeper |= (uint32_t)1 << uPath;
+         }
+      }
+
+      for(uPath = 0; uMatched != 0 && uPath < pSet->uNumPaths; uPath++) {
+         if(uMatched & ((uint32_t)1 << uPath)) {
+            uErr = Path_Matched(pItems, uPath, &Item, pCallbackCtx, pfCallback);
+            if(uErr != QCBOR_SUCCESS) {
+               goto Done;
+            }
+         }
+      }
+
+      if(Item.uNextNestLevel > Item.uNestingLevel) {
+         /* A map or array with items. Paths that need more steps only
+          * go on into these. If none do it is skipped. */
+         if(uDeeper == 0) {
+            uErr = QCBORDecode_Private_SkipContents(pMe, &Item);
+            if(uErr != QCBOR_SUCCESS) {
+               goto Done;
+            }
+         } else {
+            auActive[uLevel + 1] = uDeeper;
+            auIndex[uLevel + 1]  = 0;
+         }
+      }
+   }
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
+}
@@ -0,0 +1,302 @@
+/*==============================================================================
+ qcbor_sax.c -- Event-driven decoding with callbacks
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_sax.h"
+#include "qcbor_decode_private.h"
+
+
+/**
+ * @file qcbor_sax.c
+ *
+ * This implements QCBORSax_Decode(). Like Diag and View, it works on
+ * CBOR heads directly with DecodeHead(). Integers and major type 7
+ * are decoded by the same functions QCBORDecode_GetNext() uses so
+ * the errors and float options are the same. Arrays and maps are
+ * handled iteratively with a fixed stack of levels.
+ */
+
+
+typedef struct {
+   /* Items left for definite length or items so far for indefinite */
+   uint32_t uItems;
+   uint8_t  uType;  /* QCBOR_TYPE_ARRAY or QCBOR_TYPE_MAP */
+   bool     bIndefinite;
+} SaxLevel;
+
+
+static QCBORError
+Sax_String(UsefulInputBuf          *pInBuf,
+           const QCBORSaxCallbacks *pCb,
+           void                    *pCbCtx,
+           int                      nMajorType,
+           int                      nAdditionalInfo,
+           uint64_t                 uArgument)
+{
+   QCBORError uReturn;
+   UsefulBufC String;
+
+   QCBORError (*pfString)(void *, UsefulBufC, bool) =
+      nMajorType == CBOR_MAJOR_TYPE_BYTE_STRING ? pCb->pfBytes : pCb->pfText;
+
+   if(nAdditionalInfo != LEN_IS_INDEFINITE) {
+      uReturn = QCBORDecode_Private_GetBytes(pInBuf, uArgument, &String);
+      if(uReturn == QCBOR_SUCCESS && pfString != NULL) {
+         uReturn = (*pfString)(pCbCtx, String, false);
+      }
+      return uReturn;
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   while(1) {
+      int nChunkMajorType;
+      int nChunkAdditionalInfo;
+
+      uReturn = DecodeHead(pInBuf, &nChunkMajorType, &uArgument, &nChunkAdditionalInfo);
+      if(uReturn != QCBOR_SUCCESS) {
+         return uReturn;
+      }
+      if(nChunkMajorType == CBOR_MAJOR_TYPE_SIMPLE &&
+         nChunkAdditionalInfo == LEN_IS_INDEFINITE) {
+         /* The break that ends the string */
+         String = NULLUsefulBufC;
+         return pfString != NULL ? (*pfString)(pCbCtx, String, false) : QCBOR_SUCCESS;
+      }
+      if(nChunkMajorType != nMajorType || nChunkAdditionalInfo == LEN_IS_INDEFINITE) {
+         return QCBOR_ERR_INDEFINITE_STRING_CHUNK;
+      }
+      uReturn = QCBORDecode_Private_GetBytes(pInBuf, uArgument, &String);
+      if(uReturn == QCBOR_SUCCESS && pfString != NULL) {
+         uReturn = (*pfString)(pCbCtx, String, true);
+      }
+      if(uReturn != QCBOR_SUCCESS) {
+         return uReturn;
+      }
+   }
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+   return QCBOR_ERR_INDEF_LEN_STRINGS_DISABLED;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+}
+
+
+/* Decode an integer or major type 7 item and call for it */
+static QCBORError
+Sax_Value(const QCBORSaxCallbacks *pCb,
+          void                    *pCbCtx,
+          int                      nMajorType,
+          int                      nAdditionalInfo,
+          uint64_t                 uArgument)
+{
+   QCBORError uReturn;
+   QCBORItem  Value;
+
+   if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE) {
+      uReturn = DecodeType7(nAdditionalInfo, uArgument, &Value);
+   } else if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+      uReturn = QCBOR_ERR_BAD_INT;
+   } else {
+      uReturn = DecodeInteger(nMajorType, uArgument, &Value);
+   }
+   if(uReturn != QCBOR_SUCCESS) {
+      return uReturn;
+   }
+
+   /* Only uDataType and val are filled in. The rest of the item is
+    * never touched. */
+   switch(Value.uDataType) {
+      case QCBOR_TYPE_INT64:
+         return pCb->pfInt ? (*pCb->pfInt)(pCbCtx, Value.val.int64) : QCBOR_SUCCESS;
+
+      case QCBOR_TYPE_UINT64:
+         return pCb->pfUInt ? (*pCb->pfUInt)(pCbCtx, Value.val.uint64) : QCBOR_SUCCESS;
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+      case QCBOR_TYPE_DOUBLE:
+         return pCb->pfDouble ? (*pCb->pfDouble)(pCbCtx, Value.val.dfnum) : QCBOR_SUCCESS;
+
+#ifdef QCBOR_DISABLE_FLOAT_HW_USE
+      /* Single precision is only left as a float without float HW use */
+      case QCBOR_TYPE_FLOAT:
+         return pCb->pfFloat ? (*pCb->pfFloat)(pCbCtx, Value.val.fnum) : QCBOR_SUCCESS;
+#endif /* QCBOR_DISABLE_FLOAT_HW_USE */
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+      case QCBOR_TYPE_FALSE:
+      case QCBOR_TYPE_TRUE:
+         return pCb->pfBool ? (*pCb->pfBool)(pCbCtx, Value.uDataType == QCBOR_TYPE_TRUE) : QCBOR_SUCCESS;
+
+      case QCBOR_TYPE_NULL:
+         return pCb->pfNull ? (*pCb->pfNull)(pCbCtx) : QCBOR_SUCCESS;
+
+      case QCBOR_TYPE_UNDEF:
+         return pCb->pfSimple ? (*pCb->pfSimple)(pCbCtx, CBOR_SIMPLEV_UNDEF) : QCBOR_SUCCESS;
+
+      default:
+         /* QCBOR_TYPE_UKNOWN_SIMPLE */
+         return pCb->pfSimple ? (*pCb->pfSimple)(pCbCtx, Value.val.uSimple) : QCBOR_SUCCESS;
+   }
+}
+
+
+static QCBORError
+Sax_End(const QCBORSaxCallbacks *pCb, void *pCbCtx, uint8_t uType)
+{
+   QCBORError (*pfEnd)(void *) = uType == QCBOR_TYPE_MAP ? pCb->pfEndMap : pCb->pfEndArray;
+
+   return pfEnd != NULL ? (*pfEnd)(pCbCtx) : QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function, see header qcbor/qcbor_sax.h file
+ */
+QCBORError
+QCBORSax_Decode(UsefulBufC               Encoded,
+                const QCBORSaxCallbacks *pCb,
+                void                    *pCbCtx)
+{
+   QCBORError     uReturn;
+   UsefulInputBuf InBuf;
+   int            nMajorType;
+   int            nAdditionalInfo;
+   uint64_t       uArgument;
+   int            nDepth;
+   bool           bTagged;
+   SaxLevel       aLevels[QCBOR_MAX_ARRAY_NESTING];
+
+   if(Encoded.len > QCBOR_MAX_DECODE_INPUT_SIZE) {
+      return QCBOR_ERR_INPUT_TOO_LARGE;
+   }
+   UsefulInputBuf_Init(&InBuf, Encoded);
+
+   nDepth  = 0;
+   bTagged = false;
+   while(1) {
+      /* Close the definite-length arrays and maps that are complete */
+      while(nDepth > 0 &&
+            !aLevels[nDepth-1].bIndefinite &&
+            aLevels[nDepth-1].uItems == 0) {
+         nDepth--;
+         uReturn = Sax_End(pCb, pCbCtx, aLevels[nDepth].uType);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+      }
+
+      if(!bTagged && UsefulInputBuf_BytesUnconsumed(&InBuf) == 0) {
+         /* As QCBORDecode_Finish() does */
+         uReturn = nDepth == 0 ? QCBOR_SUCCESS : QCBOR_ERR_ARRAY_OR_MAP_UNCONSUMED;
+         goto Done;
+      }
+
+      uReturn = DecodeHead(&InBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+
+      if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == LEN_IS_INDEFINITE) {
+         /* A break must end an indefinite-length array or map, and a
+          * map only after a value. */
+         if(bTagged ||
+            nDepth == 0 ||
+            !aLevels[nDepth-1].bIndefinite ||
+            (aLevels[nDepth-1].uType == QCBOR_TYPE_MAP && aLevels[nDepth-1].uItems % 2)) {
+            uReturn = QCBOR_ERR_BAD_BREAK;
+            goto Done;
+         }
+         nDepth--;
+         uReturn = Sax_End(pCb, pCbCtx, aLevels[nDepth].uType);
+         if(uReturn != QCBOR_SUCCESS) {
+            goto Done;
+         }
+         continue;
+      }
+
+      if(nMajorType == CBOR_MAJOR_TYPE_TAG) {
+         if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+            uReturn = QCBOR_ERR_BAD_INT;
+            goto Done;
+         }
+         bTagged = true;
+         if(pCb->pfTag != NULL) {
+            uReturn = (*pCb->pfTag)(pCbCtx, uArgument);
+            if(uReturn != QCBOR_SUCCESS) {
+               goto Done;
+            }
+         }
+         continue;
+      }
+      bTagged = false;
+
+      /* Count the item in the enclosing array or map */
+      if(nDepth > 0) {
+         if(aLevels[nDepth-1].bIndefinite) {
+            aLevels[nDepth-1].uItems++;
+         } else {
+            aLevels[nDepth-1].uItems--;
+         }
+      }
+
+      switch(nMajorType) {
+         case CBOR_MAJOR_TYPE_BYTE_STRING:
+         case CBOR_MAJOR_TYPE_TEXT_STRING:
+            uReturn = Sax_String(&InBuf, pCb, pCbCtx, nMajorType, nAdditionalInfo, uArgument);
+            break;
+
+         case CBOR_MAJOR_TYPE_ARRAY:
+         case CBOR_MAJOR_TYPE_MAP:
+            if(nAdditionalInfo == LEN_IS_INDEFINITE) {
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+               uArgument = QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH;
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+               uReturn = QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED;
+               break;
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+            } else if(uArgument > QCBOR_MAX_ITEMS_IN_ARRAY) {
+               uReturn = QCBOR_ERR_ARRAY_DECODE_TOO_LONG;
+               break;
+            }
+            if(nDepth >= QCBOR_MAX_ARRAY_NESTING) {
+               uReturn = QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP;
+               break;
+            }
+
+            {
+               QCBORError (*pfBegin)(void *, uint16_t) =
+                  nMajorType == CBOR_MAJOR_TYPE_MAP ? pCb->pfBeginMap : pCb->pfBeginArray;
+               /* Cast is safe because of the check above */
+               uReturn = pfBegin != NULL ? (*pfBegin)(pCbCtx, (uint16_t)uArgument) : QCBOR_SUCCESS;
+            }
+
+            aLevels[nDepth].uType       = ConvertArrayOrMapType(nMajorType);
+            aLevels[nDepth].bIndefinite = nAdditionalInfo == LEN_IS_INDEFINITE;
+            aLevels[nDepth].uItems      = 0;
+            if(!aLevels[nDepth].bIndefinite) {
+               /* Fits because uArgument is at most QCBOR_MAX_ITEMS_IN_ARRAY */
+               aLevels[nDepth].uItems = (uint32_t)uArgument;
+               if(nMajorType == CBOR_MAJOR_TYPE_MAP) {
+                  aLevels[nDepth].uItems *= 2;
+               }
+            }
+            nDepth++;
+            break;
+
+         default:
+            uReturn = Sax_Value(pCb, pCbCtx, nMajorType, nAdditionalInfo, uArgument);
+            break;
+      }
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+
+Done:
+   return uReturn;
+}
@@ -0,0 +1,1329 @@
+/*==============================================================================
+ qcbor_schema.c -- Validation of CBOR against a compiled CDDL schema
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_schema.h"
+#include <string.h> /* For memcmp(), memmove(), memset() and strlen() */
+
+
+/**
+ * @file qcbor_schema.c
+ *
+ * The compiled program is an array of 32-bit words. The first word is
+ * a magic number with the program version and the second is the
+ * index of the root node. After that come the nodes, one for each
+ * type in the CDDL.
+ *
+ * Each node starts with a header word that has the op code in the
+ * low 8 bits and the number of words in the node, including its
+ * children, in the upper 24 bits so a node can be skipped without
+ * looking inside it. The words after the header depend on the op
+ * code:
+ *
+ *   Op code         | Words after the header
+ *   ----------------|-----------------------------------------------
+ *   SCHEMA_OP_TYPE  | Type class, one of SCHEMA_TYPE_XXX
+ *   SCHEMA_OP_RANGE | Min low, min high, max low, max high (int64_t)
+ *   SCHEMA_OP_VALUE | Major type, length, bytes four to a word
+ *   SCHEMA_OP_SIZE  | Min, max, the node being constrained
+ *   SCHEMA_OP_CHOICE| Count, the alternative nodes
+ *   SCHEMA_OP_ARRAY | Count, entries each an occurrence and a node
+ *   SCHEMA_OP_MAP   | Count, entries each an occurrence, key node
+ *                   | and value node
+ *   SCHEMA_OP_TAG   | Tag number low, high, the content node
+ *   SCHEMA_OP_REF   | Index of the node referred to
+ *
+ * An occurrence word has the minimum in the upper 16 bits and the
+ * maximum in the lower 16 bits with 0xffff meaning no maximum.
+ *
+ * Compiling is done in three passes over the CDDL by the same parser.
+ * The first doesn't output anything, but finds the names of the rules
+ * so the second can tell rules from types in the prelude, which are
+ * not the same size. The second doesn't output anything either, but
+ * records where each rule will be so the third can output rule
+ * references. The parser is recursive, but its depth is limited.
+ */
+
+
+#define SCHEMA_MAGIC 0x51534301 /* "QSC" and version 1 */
+
+#define SCHEMA_OP_TYPE   1
+#define SCHEMA_OP_RANGE  2
+#define SCHEMA_OP_VALUE  3
+#define SCHEMA_OP_SIZE   4
+#define SCHEMA_OP_CHOICE 5
+#define SCHEMA_OP_ARRAY  6
+#define SCHEMA_OP_MAP    7
+#define SCHEMA_OP_TAG    8
+#define SCHEMA_OP_REF    9
+
+#define SCHEMA_OP(uHeader)   ((uHeader) & 0xff)
+#define SCHEMA_SKIP(uHeader) ((uHeader) >> 8)
+
+#define SCHEMA_TYPE_ANY    0
+#define SCHEMA_TYPE_UINT   1
+#define SCHEMA_TYPE_NINT   2
+#define SCHEMA_TYPE_INT    3
+#define SCHEMA_TYPE_BSTR   4
+#define SCHEMA_TYPE_TSTR   5
+#define SCHEMA_TYPE_BOOL   6
+#define SCHEMA_TYPE_TRUE   7
+#define SCHEMA_TYPE_FALSE  8
+#define SCHEMA_TYPE_NIL    9
+#define SCHEMA_TYPE_UNDEF  10
+#define SCHEMA_TYPE_FLOAT  11
+#define SCHEMA_TYPE_NUMBER 12
+
+#define SCHEMA_OCCUR_UNBOUNDED 0xffff
+
+/* Limits nesting in the CDDL and rules that refer to each other
+ * without an array or map in between */
+#define SCHEMA_MAX_DEPTH 32
+
+#define SCHEMA_NO_MATCH UINT32_MAX
+
+
+
+
+/* ===========================================================================
+   Compiler
+   ===========================================================================*/
+
+typedef struct {
+   size_t   uNameOffset;
+   size_t   uNameLen;
+   uint32_t uNode;
+} SchemaRule;
+
+
+typedef struct {
+   const char *pText;
+   size_t      uTextLen;
+   size_t      uPos;
+   uint32_t   *puCode;     /* NULL on the first two passes */
+   size_t      uCodeSize;
+   size_t      uCodeLen;
+   QCBORError  uError;
+   int         nDepth;
+   int         nRules;
+   SchemaRule  aRules[QCBOR_SCHEMA_MAX_RULES];
+} SchemaCompiler;
+
+
+/* The types from the CDDL prelude that this supports. The ones that
+ * are tags have the tag number. */
+static const struct {
+   const char *szName;
+   uint16_t    uTagNumber;
+   uint8_t     uType;
+} s_aPrelude[] = {
+   {"any",          CBOR_TAG_INVALID16,     SCHEMA_TYPE_ANY},
+   {"uint",         CBOR_TAG_INVALID16,     SCHEMA_TYPE_UINT},
+   {"nint",         CBOR_TAG_INVALID16,     SCHEMA_TYPE_NINT},
+   {"int",          CBOR_TAG_INVALID16,     SCHEMA_TYPE_INT},
+   {"bstr",         CBOR_TAG_INVALID16,     SCHEMA_TYPE_BSTR},
+   {"bytes",        CBOR_TAG_INVALID16,     SCHEMA_TYPE_BSTR},
+   {"tstr",         CBOR_TAG_INVALID16,     SCHEMA_TYPE_TSTR},
+   {"text",         CBOR_TAG_INVALID16,     SCHEMA_TYPE_TSTR},
+   {"bool",         CBOR_TAG_INVALID16,     SCHEMA_TYPE_BOOL},
+   {"true",         CBOR_TAG_INVALID16,     SCHEMA_TYPE_TRUE},
+   {"false",        CBOR_TAG_INVALID16,     SCHEMA_TYPE_FALSE},
+   {"nil",          CBOR_TAG_INVALID16,     SCHEMA_TYPE_NIL},
+   {"null",         CBOR_TAG_INVALID16,     SCHEMA_TYPE_NIL},
+   {"undefined",    CBOR_TAG_INVALID16,     SCHEMA_TYPE_UNDEF},
+   {"float",        CBOR_TAG_INVALID16,     SCHEMA_TYPE_FLOAT},
+   {"float16",      CBOR_TAG_INVALID16,     SCHEMA_TYPE_FLOAT},
+   {"float32",      CBOR_TAG_INVALID16,     SCHEMA_TYPE_FLOAT},
+   {"float64",      CBOR_TAG_INVALID16,     SCHEMA_TYPE_FLOAT},
+   {"float16-32",   CBOR_TAG_INVALID16,     SCHEMA_TYPE_FLOAT},
+   {"float32-64",   CBOR_TAG_INVALID16,     SCHEMA_TYPE_FLOAT},
+   {"number",       CBOR_TAG_INVALID16,     SCHEMA_TYPE_NUMBER},
+   {"tdate",        CBOR_TAG_DATE_STRING,   SCHEMA_TYPE_TSTR},
+   {"time",         CBOR_TAG_DATE_EPOCH,    SCHEMA_TYPE_NUMBER},
+   {"biguint",      CBOR_TAG_POS_BIGNUM,    SCHEMA_TYPE_BSTR},
+   {"bignint",      CBOR_TAG_NEG_BIGNUM,    SCHEMA_TYPE_BSTR},
+   {"encoded-cbor", CBOR_TAG_CBOR,          SCHEMA_TYPE_BSTR},
+   {"uri",          CBOR_TAG_URI,           SCHEMA_TYPE_TSTR},
+   {"b64url",       CBOR_TAG_B64URL,        SCHEMA_TYPE_TSTR},
+   {"b64legacy",    CBOR_TAG_B64,           SCHEMA_TYPE_TSTR},
+   {"regexp",       CBOR_TAG_REGEX,         SCHEMA_TYPE_TSTR},
+   {"mime-message", CBOR_TAG_MIME,          SCHEMA_TYPE_TSTR},
+};
+
+
+static void
+SchemaC_Error(SchemaCompiler *pMe, QCBORError uError)
+{
+   if(pMe->uError == QCBOR_SUCCESS) {
+      pMe->uError = uError;
+   }
+}
+
+
+/* The first pass found the program fits, so output can only go past
+ * the end while trying to parse a map key that turns out not to be
+ * one. It is thrown away in that case. */
+static void
+SchemaC_Emit(SchemaCompiler *pMe, uint32_t uWord)
+{
+   if(pMe->puCode != NULL && pMe->uCodeLen < pMe->uCodeSize) {
+      pMe->puCode[pMe->uCodeLen] = uWord;
+   }
+   pMe->uCodeLen++;
+}
+
+
+static void
+SchemaC_Emit64(SchemaCompiler *pMe, uint64_t uValue)
+{
+   SchemaC_Emit(pMe, (uint32_t)uValue);
+   SchemaC_Emit(pMe, (uint32_t)(uValue >> 32));
+}
+
+
+/* Sets the header of a node once all of it has been output. */
+static void
+SchemaC_EndNode(SchemaCompiler *pMe, size_t uStart, uint8_t uOp)
+{
+   const size_t uLen = pMe->uCodeLen - uStart;
+
+   if(uLen >= 1 << 24) {
+      SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+   }
+   if(pMe->puCode != NULL && uStart < pMe->uCodeSize) {
+      pMe->puCode[uStart] = (uint32_t)(uLen << 8) | uOp;
+   }
+}
+
+
+/* Makes room for a header and other words in front of a node that
+ * has already been output, for example when a choice or a control
+ * is found after the first type. */
+static void
+SchemaC_InsertBefore(SchemaCompiler *pMe, size_t uStart, size_t uWords)
+{
+   if(pMe->puCode != NULL && pMe->uCodeLen + uWords <= pMe->uCodeSize) {
+      memmove(pMe->puCode + uStart + uWords,
+              pMe->puCode + uStart,
+              (pMe->uCodeLen - uStart) * sizeof(uint32_t));
+   }
+   pMe->uCodeLen += uWords;
+}
+
+
+static void
+SchemaC_Patch(SchemaCompiler *pMe, size_t uAt, uint32_t uWord)
+{
+   if(pMe->puCode != NULL && uAt < pMe->uCodeSize) {
+      pMe->puCode[uAt] = uWord;
+   }
+}
+
+
+static void
+SchemaC_SkipSpace(SchemaCompiler *pMe)
+{
+   while(pMe->uPos < pMe->uTextLen) {
+      const char c = pMe->pText[pMe->uPos];
+      if(c == ';') {
+         /* A comment to the end of the line */
+         while(pMe->uPos < pMe->uTextLen && pMe->pText[pMe->uPos] != '\n') {
+            pMe->uPos++;
+         }
+      } else if(c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+         pMe->uPos++;
+      } else {
+         break;
+      }
+   }
+}
+
+
+/* Skips white space and then consumes szToken if it is next. */
+static bool
+SchemaC_Accept(SchemaCompiler *pMe, const char *szToken)
+{
+   const size_t uLen = strlen(szToken);
+
+   SchemaC_SkipSpace(pMe);
+   if(pMe->uTextLen - pMe->uPos < uLen ||
+      memcmp(pMe->pText + pMe->uPos, szToken, uLen)) {
+      return false;
+   }
+   pMe->uPos += uLen;
+   return true;
+}
+
+
+static void
+SchemaC_Expect(SchemaCompiler *pMe, const char *szToken)
+{
+   if(!SchemaC_Accept(pMe, szToken)) {
+      SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+   }
+}
+
+
+static bool
+SchemaC_IsIdChar(char c, bool bFirst)
+{
+   if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+      c == '@' || c == '_' || c == '$') {
+      return true;
+   }
+   return !bFirst && ((c >= '0' && c <= '9') || c == '-' || c == '.');
+}
+
+
+/* Gets a CDDL identifier. A '-' or '.' must be followed by a letter
+ * or digit so "a..b" isn't an identifier and ".size" is not consumed
+ * as part of the identifier before it. */
+static bool
+SchemaC_Identifier(SchemaCompiler *pMe, size_t *puOffset, size_t *puLen)
+{
+   size_t uEnd;
+   char   c;
+
+   SchemaC_SkipSpace(pMe);
+   if(pMe->uPos >= pMe->uTextLen || !SchemaC_IsIdChar(pMe->pText[pMe->uPos], true)) {
+      return false;
+   }
+   for(uEnd = pMe->uPos + 1; uEnd < pMe->uTextLen; uEnd++) {
+      c = pMe->pText[uEnd];
+      if(!SchemaC_IsIdChar(c, false)) {
+         break;
+      }
+      if((c == '-' || c == '.') &&
+         (uEnd + 1 >= pMe->uTextLen ||
+          !SchemaC_IsIdChar(pMe->pText[uEnd + 1], false) ||
+          pMe->pText[uEnd + 1] == '-' || pMe->pText[uEnd + 1] == '.')) {
+         break;
+      }
+   }
+   *puOffset = pMe->uPos;
+   *puLen    = uEnd - pMe->uPos;
+   pMe->uPos = uEnd;
+   return true;
+}
+
+
+static bool
+SchemaC_IsDigit(const SchemaCompiler *pMe, size_t uPos)
+{
+   return uPos < pMe->uTextLen && pMe->pText[uPos] >= '0' && pMe->pText[uPos] <= '9';
+}
+
+
+/* Gets a decimal or 0x hex integer that fits in int64_t. */
+static bool
+SchemaC_Integer(SchemaCompiler *pMe, int64_t *pnValue)
+{
+   bool     bNegative;
+   uint64_t uValue;
+   uint64_t uBase;
+   unsigned uDigit;
+   char     c;
+
+   SchemaC_SkipSpace(pMe);
+   bNegative = pMe->uPos < pMe->uTextLen && pMe->pText[pMe->uPos] == '-';
+   if(!SchemaC_IsDigit(pMe, pMe->uPos + bNegative)) {
+      return false;
+   }
+   pMe->uPos += bNegative;
+
+   uBase = 10;
+   if(pMe->uTextLen - pMe->uPos > 2 &&
+      pMe->pText[pMe->uPos] == '0' &&
+      (pMe->pText[pMe->uPos + 1] == 'x' || pMe->pText[pMe->uPos + 1] == 'X')) {
+      uBase = 16;
+      pMe->uPos += 2;
+   }
+
+   uValue = 0;
+   for(; pMe->uPos < pMe->uTextLen; pMe->uPos++) {
+      c = pMe->pText[pMe->uPos];
+      if(c >= '0' && c <= '9') {
+         uDigit = (unsigned)(c - '0');
+      } else if(uBase == 16 && c >= 'a' && c <= 'f') {
+         uDigit = (unsigned)(c - 'a' + 10);
+      } else if(uBase == 16 && c >= 'A' && c <= 'F') {
+         uDigit = (unsigned)(c - 'A' + 10);
+      } else {
+         break;
+      }
+      if(uValue > ((uint64_t)INT64_MAX + 1 - uDigit) / uBase) {
+         SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+         return false;
+      }
+      uValue = uValue * uBase + uDigit;
+   }
+
+   if(!bNegative && uValue > INT64_MAX) {
+      SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+      return false;
+   }
+   /* Negation in uint64_t so INT64_MIN doesn't overflow */
+   *pnValue = bNegative ? (int64_t)(0 - uValue) : (int64_t)uValue;
+   return true;
+}
+
+
+static void
+SchemaC_Range(SchemaCompiler *pMe, int64_t nMin, int64_t nMax)
+{
+   const size_t uStart = pMe->uCodeLen;
+
+   SchemaC_Emit(pMe, 0);
+   SchemaC_Emit64(pMe, (uint64_t)nMin);
+   SchemaC_Emit64(pMe, (uint64_t)nMax);
+   SchemaC_EndNode(pMe, uStart, SCHEMA_OP_RANGE);
+}
+
+
+/* Outputs a string value for the text at uOffset. */
+static void
+SchemaC_Value(SchemaCompiler *pMe, uint32_t uMajorType, size_t uOffset, size_t uLen)
+{
+   const size_t uStart = pMe->uCodeLen;
+   size_t       uIndex;
+   uint32_t     uWord;
+
+   SchemaC_Emit(pMe, 0);
+   SchemaC_Emit(pMe, uMajorType);
+   SchemaC_Emit(pMe, (uint32_t)uLen);
+   /* Packed least significant byte first so the program doesn't
+    * depend on the endianness of the machine that compiled it */
+   uWord = 0;
+   for(uIndex = 0; uIndex < uLen; uIndex++) {
+      uWord |= (uint32_t)(uint8_t)pMe->pText[uOffset + uIndex] << (8 * (uIndex % 4));
+      if(uIndex % 4 == 3) {
+         SchemaC_Emit(pMe, uWord);
+         uWord = 0;
+      }
+   }
+   if(uLen % 4) {
+      SchemaC_Emit(pMe, uWord);
+   }
+   SchemaC_EndNode(pMe, uStart, SCHEMA_OP_VALUE);
+}
+
+
+/* Gets a text or byte string value without escapes. */
+static bool
+SchemaC_String(SchemaCompiler *pMe, char cQuote, size_t *puOffset, size_t *puLen)
+{
+   size_t uEnd;
+
+   SchemaC_SkipSpace(pMe);
+   if(pMe->uPos >= pMe->uTextLen || pMe->pText[pMe->uPos] != cQuote) {
+      return false;
+   }
+   for(uEnd = pMe->uPos + 1; uEnd < pMe->uTextLen && pMe->pText[uEnd] != cQuote; uEnd++) {
+      if(pMe->pText[uEnd] == '\\') {
+         break;
+      }
+   }
+   if(uEnd >= pMe->uTextLen || pMe->pText[uEnd] != cQuote) {
+      SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+      return false;
+   }
+   *puOffset = pMe->uPos + 1;
+   *puLen    = uEnd - *puOffset;
+   pMe->uPos = uEnd + 1;
+   return true;
+}
+
+
+static void
+SchemaC_Type(SchemaCompiler *pMe);
+
+
+/* Outputs the entries of an array or map and returns how many. */
+static uint32_t
+SchemaC_Group(SchemaCompiler *pMe, bool bMap, const char *szClose)
+{
+   uint32_t uCount;
+   int64_t  nMin;
+   int64_t  nMax;
+   size_t   uSavePos;
+   size_t   uSaveCodeLen;
+   size_t   uOffset;
+   size_t   uLen;
+   bool     bKey;
+
+   for(uCount = 0; pMe->uError == QCBOR_SUCCESS && !SchemaC_Accept(pMe, szClose); uCount++) {
+      /* The occurrence indicator */
+      nMin = 1;
+      nMax = 1;
+      uSavePos = pMe->uPos;
+      if(SchemaC_Accept(pMe, "?")) {
+         nMin = 0;
+      } else if(SchemaC_Accept(pMe, "+")) {
+         nMax = SCHEMA_OCCUR_UNBOUNDED;
+      } else {
+         if(!SchemaC_Integer(pMe, &nMin)) {
+            nMin = 0;
+         }
+         if(SchemaC_Accept(pMe, "*")) {
+            if(!SchemaC_Integer(pMe, &nMax)) {
+               nMax = SCHEMA_OCCUR_UNBOUNDED;
+            }
+         } else {
+            /* Not an occurrence, maybe a value */
+            pMe->uPos = uSavePos;
+            nMin = 1;
+         }
+      }
+      if(nMin < 0 || nMax > SCHEMA_OCCUR_UNBOUNDED || nMin > nMax || nMax == 0) {
+         SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+         break;
+      }
+      SchemaC_Emit(pMe, (uint32_t)(nMin << 16 | nMax));
+
+      /* The member key. A bare word followed by ':' is a text key,
+       * otherwise the key is a type followed by "=>" or a value
+       * followed by ':'. */
+      bKey = false;
+      uSavePos     = pMe->uPos;
+      uSaveCodeLen = pMe->uCodeLen;
+      if(SchemaC_Identifier(pMe, &uOffset, &uLen) && SchemaC_Accept(pMe, ":")) {
+         SchemaC_Value(pMe, CBOR_MAJOR_TYPE_TEXT_STRING, uOffset, uLen);
+         bKey = true;
+      } else {
+         pMe->uPos = uSavePos;
+         SchemaC_Type(pMe);
+         if(pMe->uError == QCBOR_SUCCESS &&
+            (SchemaC_Accept(pMe, "=>") || SchemaC_Accept(pMe, ":"))) {
+            bKey = true;
+         } else {
+            /* Not a key; parse it again as the value */
+            pMe->uError   = QCBOR_SUCCESS;
+            pMe->uPos     = uSavePos;
+            pMe->uCodeLen = uSaveCodeLen;
+         }
+      }
+
+      if(bMap) {
+         if(!bKey) {
+            SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+         }
+      } else if(bKey) {
+         /* Keys in arrays are just documentation */
+         pMe->uCodeLen = uSaveCodeLen;
+      }
+
+      SchemaC_Type(pMe);
+      SchemaC_Accept(pMe, ",");
+   }
+
+   if(bMap && uCount > QCBOR_SCHEMA_MAX_MAP_MEMBERS) {
+      SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+   }
+   return uCount;
+}
+
+
+static void
+SchemaC_Type2(SchemaCompiler *pMe)
+{
+   size_t   uStart;
+   size_t   uOffset;
+   size_t   uLen;
+   int64_t  nTag;
+   size_t   uIndex;
+   int      nRule;
+   uint32_t uCount;
+
+   uStart = pMe->uCodeLen;
+
+   if(SchemaC_String(pMe, '"', &uOffset, &uLen)) {
+      SchemaC_Value(pMe, CBOR_MAJOR_TYPE_TEXT_STRING, uOffset, uLen);
+
+   } else if(SchemaC_String(pMe, '\'', &uOffset, &uLen)) {
+      SchemaC_Value(pMe, CBOR_MAJOR_TYPE_BYTE_STRING, uOffset, uLen);
+
+   } else if(SchemaC_Accept(pMe, "[") || SchemaC_Accept(pMe, "{")) {
+      const bool bMap = pMe->pText[pMe->uPos - 1] == '{';
+      SchemaC_Emit(pMe, 0);
+      SchemaC_Emit(pMe, 0);
+      uCount = SchemaC_Group(pMe, bMap, bMap ? "}" : "]");
+      SchemaC_Patch(pMe, uStart + 1, uCount);
+      SchemaC_EndNode(pMe, uStart, bMap ? SCHEMA_OP_MAP : SCHEMA_OP_ARRAY);
+
+   } else if(SchemaC_Accept(pMe, "(")) {
+      SchemaC_Type(pMe);
+      SchemaC_Expect(pMe, ")");
+
+   } else if(SchemaC_Accept(pMe, "#6.")) {
+      if(!SchemaC_Integer(pMe, &nTag) || nTag < 0) {
+         SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+         return;
+      }
+      SchemaC_Emit(pMe, 0);
+      SchemaC_Emit64(pMe, (uint64_t)nTag);
+      SchemaC_Expect(pMe, "(");
+      SchemaC_Type(pMe);
+      SchemaC_Expect(pMe, ")");
+      SchemaC_EndNode(pMe, uStart, SCHEMA_OP_TAG);
+
+   } else if(SchemaC_Identifier(pMe, &uOffset, &uLen)) {
+      /* Rules take precedence over the prelude */
+      for(nRule = 0; nRule < pMe->nRules; nRule++) {
+         if(pMe->aRules[nRule].uNameLen == uLen &&
+            !memcmp(pMe->pText + pMe->aRules[nRule].uNameOffset, pMe->pText + uOffset, uLen)) {
+            break;
+         }
+      }
+      if(nRule < pMe->nRules || pMe->nRules == 0) {
+         /* On the first pass the rules aren't known yet. Nothing from
+          * that pass but the names of the rules is used. */
+         SchemaC_Emit(pMe, 0);
+         SchemaC_Emit(pMe, nRule < pMe->nRules ? pMe->aRules[nRule].uNode : 0);
+         SchemaC_EndNode(pMe, uStart, SCHEMA_OP_REF);
+         return;
+      }
+      for(uIndex = 0; uIndex < sizeof(s_aPrelude)/sizeof(s_aPrelude[0]); uIndex++) {
+         if(strlen(s_aPrelude[uIndex].szName) == uLen &&
+            !memcmp(s_aPrelude[uIndex].szName, pMe->pText + uOffset, uLen)) {
+            break;
+         }
+      }
+      if(uIndex == sizeof(s_aPrelude)/sizeof(s_aPrelude[0])) {
+         SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+         return;
+      }
+      if(s_aPrelude[uIndex].uTagNumber != CBOR_TAG_INVALID16) {
+         SchemaC_Emit(pMe, 0);
+         SchemaC_Emit64(pMe, s_aPrelude[uIndex].uTagNumber);
+      }
+      SchemaC_Emit(pMe, (2 << 8) | SCHEMA_OP_TYPE);
+      SchemaC_Emit(pMe, s_aPrelude[uIndex].uType);
+      if(s_aPrelude[uIndex].uTagNumber != CBOR_TAG_INVALID16) {
+         SchemaC_EndNode(pMe, uStart, SCHEMA_OP_TAG);
+      }
+
+   } else {
+      SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+   }
+}
+
+
+/* A type with an optional range or control. */
+static void
+SchemaC_Type1(SchemaCompiler *pMe)
+{
+   const size_t uStart = pMe->uCodeLen;
+   int64_t      nMin;
+   int64_t      nMax;
+   bool         bExclusive;
+
+   if(SchemaC_Integer(pMe, &nMin)) {
+      nMax = nMin;
+      bExclusive = SchemaC_Accept(pMe, "...");
+      if(bExclusive || SchemaC_Accept(pMe, "..")) {
+         if(!SchemaC_Integer(pMe, &nMax) || (bExclusive && nMax == INT64_MIN)) {
+            SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+            return;
+         }
+         nMax -= bExclusive;
+      }
+      SchemaC_Range(pMe, nMin, nMax);
+   } else {
+      SchemaC_Type2(pMe);
+   }
+
+   if(SchemaC_Accept(pMe, ".size")) {
+      /* A size as a number or a range in parentheses */
+      const bool bParen = SchemaC_Accept(pMe, "(");
+      if(!SchemaC_Integer(pMe, &nMin)) {
+         SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+         return;
+      }
+      nMax = nMin;
+      if(bParen) {
+         bExclusive = SchemaC_Accept(pMe, "...");
+         if(!bExclusive) {
+            SchemaC_Expect(pMe, "..");
+         }
+         if(!SchemaC_Integer(pMe, &nMax)) {
+            SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+            return;
+         }
+         nMax -= bExclusive;
+         SchemaC_Expect(pMe, ")");
+      } else {
+         /* A single number is the maximum */
+         nMin = 0;
+      }
+      if(nMin < 0 || nMax < nMin || nMax > UINT32_MAX) {
+         SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+         return;
+      }
+      SchemaC_InsertBefore(pMe, uStart, 3);
+      SchemaC_Patch(pMe, uStart + 1, (uint32_t)nMin);
+      SchemaC_Patch(pMe, uStart + 2, (uint32_t)nMax);
+      SchemaC_EndNode(pMe, uStart, SCHEMA_OP_SIZE);
+   }
+}
+
+
+static void
+SchemaC_Type(SchemaCompiler *pMe)
+{
+   const size_t uStart = pMe->uCodeLen;
+   uint32_t     uCount;
+
+   if(++pMe->nDepth > SCHEMA_MAX_DEPTH) {
+      SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+      return;
+   }
+
+   SchemaC_Type1(pMe);
+   for(uCount = 1; pMe->uError == QCBOR_SUCCESS; uCount++) {
+      SchemaC_SkipSpace(pMe);
+      /* "//" is a group choice, which isn't supported */
+      if(pMe->uTextLen - pMe->uPos >= 2 && !memcmp(pMe->pText + pMe->uPos, "//", 2)) {
+         SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+      }
+      if(!SchemaC_Accept(pMe, "/")) {
+         break;
+      }
+      if(uCount == 1) {
+         SchemaC_InsertBefore(pMe, uStart, 2);
+      }
+      SchemaC_Type1(pMe);
+   }
+
+   if(uCount > 1) {
+      SchemaC_Patch(pMe, uStart + 1, uCount);
+      SchemaC_EndNode(pMe, uStart, SCHEMA_OP_CHOICE);
+   }
+
+   pMe->nDepth--;
+}
+
+
+/* One pass over all the rules */
+static void
+SchemaC_Rules(SchemaCompiler *pMe)
+{
+   size_t uOffset;
+   size_t uLen;
+   int    nRule;
+
+   pMe->uPos     = 0;
+   pMe->uCodeLen = 0;
+   pMe->nDepth   = 0;
+   SchemaC_Emit(pMe, SCHEMA_MAGIC);
+   SchemaC_Emit(pMe, 2);
+
+   for(nRule = 0; pMe->uError == QCBOR_SUCCESS; nRule++) {
+      SchemaC_SkipSpace(pMe);
+      if(pMe->uPos == pMe->uTextLen) {
+         break;
+      }
+      if(!SchemaC_Identifier(pMe, &uOffset, &uLen) ||
+         !SchemaC_Accept(pMe, "=") ||
+         nRule >= QCBOR_SCHEMA_MAX_RULES) {
+         SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+         break;
+      }
+      if(pMe->puCode == NULL) {
+         /* The passes that don't output record where the rules are */
+         pMe->aRules[nRule].uNameOffset = uOffset;
+         pMe->aRules[nRule].uNameLen    = uLen;
+         pMe->aRules[nRule].uNode       = (uint32_t)pMe->uCodeLen;
+      }
+      SchemaC_Type(pMe);
+   }
+
+   if(nRule == 0) {
+      SchemaC_Error(pMe, QCBOR_ERR_SCHEMA_SYNTAX);
+   }
+   if(pMe->puCode == NULL) {
+      pMe->nRules = nRule;
+   }
+}
+
+
+/*
+ * Public function. See qcbor_schema.h
+ */
+QCBORError
+QCBORSchema_Compile(UsefulBufC   CDDL,
+                    uint32_t    *puCode,
+                    size_t       uCodeSize,
+                    QCBORSchema *pSchema)
+{
+   SchemaCompiler Compiler;
+
+   Compiler.pText     = CDDL.ptr;
+   Compiler.uTextLen  = CDDL.len;
+   Compiler.uError    = QCBOR_SUCCESS;
+   Compiler.nRules    = 0;
+   Compiler.puCode    = NULL;
+   Compiler.uCodeSize = 0;
+
+   SchemaC_Rules(&Compiler);
+   if(Compiler.uError == QCBOR_SUCCESS) {
+      SchemaC_Rules(&Compiler);
+   }
+
+   pSchema->puCode   = puCode;
+   pSchema->uCodeLen = Compiler.uCodeLen;
+
+   if(Compiler.uError == QCBOR_SUCCESS && puCode != NULL) {
+      if(uCodeSize < Compiler.uCodeLen) {
+         return QCBOR_ERR_BUFFER_TOO_SMALL;
+      }
+      Compiler.puCode    = puCode;
+      Compiler.uCodeSize = uCodeSize;
+      SchemaC_Rules(&Compiler);
+   }
+
+   return Compiler.uError;
+}
+
+
+
+
+/* ===========================================================================
+   Validator
+
+   Schema_Match() checks an item against a node without consuming
+   anything more from the decoder. For arrays and maps it checks only
+   the type and tags. It returns the node that matched, which for a
+   choice, reference or tag is a node inside. Schema_Descend() then
+   consumes and checks the contents of arrays and maps.
+   ===========================================================================*/
+
+typedef struct {
+   QCBORDecodeContext *pDecode;
+   const uint32_t     *puCode;
+   size_t              uCodeLen;
+} SchemaValidator;
+
+
+static int64_t
+Schema_Get64(const uint32_t *puCode)
+{
+   return (int64_t)((uint64_t)puCode[0] | (uint64_t)puCode[1] << 32);
+}
+
+
+/* For QCBOR types that come from decoding a tag, this gives the tag
+ * number and the type of the tag content. */
+static uint64_t
+Schema_DecodedTag(const QCBORItem *pItem, uint8_t *puContentType)
+{
+   *puContentType = QCBOR_TYPE_TEXT_STRING;
+
+   switch(pItem->uDataType) {
+      case QCBOR_TYPE_DATE_STRING: return CBOR_TAG_DATE_STRING;
+      case QCBOR_TYPE_DAYS_STRING: return CBOR_TAG_DAYS_STRING;
+      case QCBOR_TYPE_URI:         return CBOR_TAG_URI;
+      case QCBOR_TYPE_BASE64URL:   return CBOR_TAG_B64URL;
+      case QCBOR_TYPE_BASE64:      return CBOR_TAG_B64;
+      case QCBOR_TYPE_REGEX:       return CBOR_TAG_REGEX;
+      case QCBOR_TYPE_MIME:        return CBOR_TAG_MIME;
+      default: break;
+   }
+
+   *puContentType = QCBOR_TYPE_BYTE_STRING;
+   switch(pItem->uDataType) {
+      case QCBOR_TYPE_POSBIGNUM:                   return CBOR_TAG_POS_BIGNUM;
+      case QCBOR_TYPE_NEGBIGNUM:                   return CBOR_TAG_NEG_BIGNUM;
+      case QBCOR_TYPE_WRAPPED_CBOR:                return CBOR_TAG_CBOR;
+      case QBCOR_TYPE_WRAPPED_CBOR_SEQUENCE:       return CBOR_TAG_CBOR_SEQUENCE;
+      case QCBOR_TYPE_UUID:                        return CBOR_TAG_BIN_UUID;
+      case QCBOR_TYPE_BINARY_MIME:                 return CBOR_TAG_BINARY_MIME;
+      default: break;
+   }
+
+   *puContentType = QCBOR_TYPE_ARRAY;
+   switch(pItem->uDataType) {
+      case QCBOR_TYPE_DECIMAL_FRACTION:
+      case QCBOR_TYPE_DECIMAL_FRACTION_POS_BIGNUM:
+      case QCBOR_TYPE_DECIMAL_FRACTION_NEG_BIGNUM: return CBOR_TAG_DECIMAL_FRACTION;
+      case QCBOR_TYPE_BIGFLOAT:
+      case QCBOR_TYPE_BIGFLOAT_POS_BIGNUM:
+      case QCBOR_TYPE_BIGFLOAT_NEG_BIGNUM:         return CBOR_TAG_BIGFLOAT;
+      default: break;
+   }
+
+   *puContentType = QCBOR_TYPE_INT64;
+   switch(pItem->uDataType) {
+      case QCBOR_TYPE_DAYS_EPOCH: return CBOR_TAG_DAYS_EPOCH;
+      case QCBOR_TYPE_DATE_EPOCH:
+#if !defined(USEFULBUF_DISABLE_ALL_FLOAT) && !defined(QCBOR_DISABLE_FLOAT_HW_USE)
+         if(pItem->val.epochDate.fSecondsFraction != 0) {
+            *puContentType = QCBOR_TYPE_DOUBLE;
+         }
+#endif /* ! USEFULBUF_DISABLE_ALL_FLOAT && ! QCBOR_DISABLE_FLOAT_HW_USE */
+         return CBOR_TAG_DATE_EPOCH;
+      default: break;
+   }
+
+   *puContentType = pItem->uDataType;
+   return CBOR_TAG_INVALID64;
+}
+
+
+/* Number of tags on the item including one decoded by QCBOR. */
+static int
+Schema_TagCount(const SchemaValidator *pMe, const QCBORItem *pItem)
+{
+   uint8_t  uContentType;
+   uint32_t uIndex;
+
+   for(uIndex = 0; QCBORDecode_GetNthTag(pMe->pDecode, pItem, uIndex) != CBOR_TAG_INVALID64; uIndex++);
+
+   return (int)uIndex + (Schema_DecodedTag(pItem, &uContentType) != CBOR_TAG_INVALID64);
+}
+
+
+/* Gets the tag at nIndex with 0 being the innermost, the one closest
+ * to the content. A tag decoded by QCBOR is always the innermost. */
+static uint64_t
+Schema_TagAt(const SchemaValidator *pMe, const QCBORItem *pItem, int nIndex)
+{
+   uint8_t        uContentType;
+   const uint64_t uDecodedTag = Schema_DecodedTag(pItem, &uContentType);
+
+   if(uDecodedTag != CBOR_TAG_INVALID64) {
+      if(nIndex == 0) {
+         return uDecodedTag;
+      }
+      nIndex--;
+   }
+   return QCBORDecode_GetNthTag(pMe->pDecode, pItem, (uint32_t)nIndex);
+}
+
+
+static bool
+Schema_TypeMatches(uint32_t uType, uint8_t uDataType, const QCBORItem *pItem)
+{
+   switch(uType) {
+      case SCHEMA_TYPE_ANY:
+         return true;
+      case SCHEMA_TYPE_UINT:
+         return uDataType == QCBOR_TYPE_UINT64 ||
+                (uDataType == QCBOR_TYPE_INT64 && pItem->val.int64 >= 0);
+      case SCHEMA_TYPE_NINT:
+         return uDataType == QCBOR_TYPE_INT64 && pItem->val.int64 < 0;
+      case SCHEMA_TYPE_INT:
+         return uDataType == QCBOR_TYPE_INT64 || uDataType == QCBOR_TYPE_UINT64;
+      case SCHEMA_TYPE_BSTR:
+         return uDataType == QCBOR_TYPE_BYTE_STRING;
+      case SCHEMA_TYPE_TSTR:
+         return uDataType == QCBOR_TYPE_TEXT_STRING;
+      case SCHEMA_TYPE_BOOL:
+         return uDataType == QCBOR_TYPE_TRUE || uDataType == QCBOR_TYPE_FALSE;
+      case SCHEMA_TYPE_TRUE:
+         return uDataType == QCBOR_TYPE_TRUE;
+      case SCHEMA_TYPE_FALSE:
+         return uDataType == QCBOR_TYPE_FALSE;
+      case SCHEMA_TYPE_NIL:
+         return uDataType == QCBOR_TYPE_NULL;
+      case SCHEMA_TYPE_UNDEF:
+         return uDataType == QCBOR_TYPE_UNDEF;
+      case SCHEMA_TYPE_FLOAT:
+         return uDataType == QCBOR_TYPE_DOUBLE || uDataType == QCBOR_TYPE_FLOAT;
+      case SCHEMA_TYPE_NUMBER:
+         return uDataType == QCBOR_TYPE_INT64 || uDataType == QCBOR_TYPE_UINT64 ||
+                uDataType == QCBOR_TYPE_DOUBLE || uDataType == QCBOR_TYPE_FLOAT;
+      default:
+         return false;
+   }
+}
+
+
+/**
+ * @brief Check an item against a node.
+ *
+ * @param[in] pMe        The validator.
+ * @param[in] uNode      The node to check against.
+ * @param[in] pItem      The item to check.
+ * @param[in] nTagsLeft  The number of the item's tags not yet matched.
+ * @param[in] nDepth     Count of references followed to stop loops.
+ *
+ * @return The node that matched or @ref SCHEMA_NO_MATCH.
+ */
+static uint32_t
+Schema_Match(const SchemaValidator *pMe,
+             uint32_t               uNode,
+             const QCBORItem       *pItem,
+             int                    nTagsLeft,
+             int                    nDepth)
+{
+   const uint32_t *puNode = pMe->puCode + uNode;
+   uint8_t         uDataType;
+   int64_t         nValue;
+   uint32_t        uCount;
+   uint32_t        uChild;
+   uint32_t        uMatch;
+
+   if(SCHEMA_OP(puNode[0]) == SCHEMA_OP_TAG) {
+      if(nTagsLeft == 0 ||
+         Schema_TagAt(pMe, pItem, nTagsLeft - 1) != (uint64_t)Schema_Get64(puNode + 1)) {
+         return SCHEMA_NO_MATCH;
+      }
+      return Schema_Match(pMe, uNode + 3, pItem, nTagsLeft - 1, nDepth);
+   }
+
+   if(SCHEMA_OP(puNode[0]) == SCHEMA_OP_REF || SCHEMA_OP(puNode[0]) == SCHEMA_OP_CHOICE) {
+      if(nDepth >= SCHEMA_MAX_DEPTH) {
+         return SCHEMA_NO_MATCH;
+      }
+      if(SCHEMA_OP(puNode[0]) == SCHEMA_OP_REF) {
+         if(puNode[1] >= pMe->uCodeLen) {
+            /* A program that wasn't made by QCBORSchema_Compile() */
+            return SCHEMA_NO_MATCH;
+         }
+         return Schema_Match(pMe, puNode[1], pItem, nTagsLeft, nDepth + 1);
+      }
+      uChild = uNode + 2;
+      for(uCount = puNode[1]; uCount > 0; uCount--) {
+         uMatch = Schema_Match(pMe, uChild, pItem, nTagsLeft, nDepth + 1);
+         if(uMatch != SCHEMA_NO_MATCH) {
+            return uMatch;
+         }
+         uChild += SCHEMA_SKIP(pMe->puCode[uChild]);
+      }
+      return SCHEMA_NO_MATCH;
+   }
+
+   if(SCHEMA_OP(puNode[0]) == SCHEMA_OP_TYPE && puNode[1] == SCHEMA_TYPE_ANY) {
+      /* Any matches no matter what tags there are */
+      return uNode;
+   }
+
+   if(nTagsLeft > 0) {
+      /* Tags that aren't in the schema */
+      return SCHEMA_NO_MATCH;
+   }
+
+   /* The type once all tags have been matched */
+   Schema_DecodedTag(pItem, &uDataType);
+
+   switch(SCHEMA_OP(puNode[0])) {
+      case SCHEMA_OP_TYPE:
+         return Schema_TypeMatches(puNode[1], uDataType, pItem) ? uNode : SCHEMA_NO_MATCH;
+
+      case SCHEMA_OP_RANGE:
+         if(uDataType != QCBOR_TYPE_INT64) {
+            return SCHEMA_NO_MATCH;
+         }
+         switch(pItem->uDataType) {
+            case QCBOR_TYPE_DATE_EPOCH: nValue = pItem->val.epochDate.nSeconds; break;
+            case QCBOR_TYPE_DAYS_EPOCH: nValue = pItem->val.epochDays;          break;
+            default:                    nValue = pItem->val.int64;              break;
+         }
+         if(nValue < Schema_Get64(puNode + 1) || nValue > Schema_Get64(puNode + 3)) {
+            return SCHEMA_NO_MATCH;
+         }
+         return uNode;
+
+      case SCHEMA_OP_VALUE:
+         if(uDataType != (puNode[1] == CBOR_MAJOR_TYPE_TEXT_STRING ? QCBOR_TYPE_TEXT_STRING : QCBOR_TYPE_BYTE_STRING) ||
+            pItem->val.string.len != puNode[2]) {
+            return SCHEMA_NO_MATCH;
+         }
+         for(uCount = 0; uCount < puNode[2]; uCount++) {
+            if(((const uint8_t *)pItem->val.string.ptr)[uCount] !=
+               (uint8_t)(puNode[3 + uCount / 4] >> (8 * (uCount % 4)))) {
+               return SCHEMA_NO_MATCH;
+            }
+         }
+         return uNode;
+
+      case SCHEMA_OP_SIZE:
+         uMatch = Schema_Match(pMe, uNode + 3, pItem, nTagsLeft, nDepth);
+         if(uMatch == SCHEMA_NO_MATCH) {
+            return SCHEMA_NO_MATCH;
+         }
+         if(uDataType == QCBOR_TYPE_TEXT_STRING || uDataType == QCBOR_TYPE_BYTE_STRING) {
+            if(pItem->val.string.len < puNode[1] || pItem->val.string.len > puNode[2]) {
+               return SCHEMA_NO_MATCH;
+            }
+         } else if(uDataType == QCBOR_TYPE_INT64 || uDataType == QCBOR_TYPE_UINT64) {
+            /* For integers the size is the number of bytes needed */
+            if(puNode[2] < 8 && pItem->val.uint64 >> (puNode[2] * 8)) {
+               return SCHEMA_NO_MATCH;
+            }
+         } else {
+            return SCHEMA_NO_MATCH;
+         }
+         return uMatch;
+
+      case SCHEMA_OP_ARRAY:
+         return uDataType == QCBOR_TYPE_ARRAY ? uNode : SCHEMA_NO_MATCH;
+
+      case SCHEMA_OP_MAP:
+         return uDataType == QCBOR_TYPE_MAP ? uNode : SCHEMA_NO_MATCH;
+
+      default:
+         return SCHEMA_NO_MATCH;
+   }
+}
+
+
+static QCBORError
+Schema_Descend(const SchemaValidator *pMe,
+               uint32_t               uNode,
+               const QCBORItem       *pItem,
+               uint8_t               *puNextLevel);
+
+
+/* Gets the next item in an array or map, matches it against uNode
+ * and checks its contents. */
+static QCBORError
+Schema_CheckItem(const SchemaValidator *pMe,
+                 uint32_t               uNode,
+                 const QCBORItem       *pItem,
+                 uint8_t               *puNextLevel)
+{
+   const uint32_t uMatch = Schema_Match(pMe, uNode, pItem, Schema_TagCount(pMe, pItem), 0);
+
+   if(uMatch == SCHEMA_NO_MATCH) {
+      return QCBOR_ERR_SCHEMA_MISMATCH;
+   }
+   return Schema_Descend(pMe, uMatch, pItem, puNextLevel);
+}
+
+
+static QCBORError
+Schema_CheckArray(const SchemaValidator *pMe,
+                  uint32_t               uNode,
+                  const QCBORItem       *pArray,
+                  uint8_t               *puNextLevel)
+{
+   QCBORError uErr;
+   QCBORItem  Item;
+   uint32_t   uEntriesLeft;
+   uint32_t   uEntry;
+   uint32_t   uOccurrences;
+   uint32_t   uOccur;
+   uint32_t   uMatch;
+
+   uEntriesLeft = pMe->puCode[uNode + 1];
+   uEntry       = uNode + 2;
+   uOccurrences = 0;
+
+   while(*puNextLevel > pArray->uNestingLevel) {
+      uErr = QCBORDecode_GetNext(pMe->pDecode, &Item);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+
+      /* Find the entry the item belongs to. An entry that can take
+       * more items keeps taking them while they match. */
+      for(;;) {
+         if(uEntriesLeft == 0) {
+            return QCBOR_ERR_SCHEMA_MISMATCH;
+         }
+         uOccur = pMe->puCode[uEntry];
+         if(uOccurrences < (uOccur & 0xffff)) {
+            uMatch = Schema_Match(pMe, uEntry + 1, &Item, Schema_TagCount(pMe, &Item), 0);
+            if(uMatch != SCHEMA_NO_MATCH) {
+               break;
+            }
+         }
+         if(uOccurrences < uOccur >> 16) {
+            return QCBOR_ERR_SCHEMA_MISMATCH;
+         }
+         uEntry += 1 + SCHEMA_SKIP(pMe->puCode[uEntry + 1]);
+         uEntriesLeft--;
+         uOccurrences = 0;
+      }
+
+      uOccurrences++;
+      uErr = Schema_Descend(pMe, uMatch, &Item, puNextLevel);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+   }
+
+   /* The rest of the entries must be optional */
+   for(; uEntriesLeft > 0; uEntriesLeft--) {
+      if(uOccurrences < pMe->puCode[uEntry] >> 16) {
+         return QCBOR_ERR_SCHEMA_MISMATCH;
+      }
+      uEntry += 1 + SCHEMA_SKIP(pMe->puCode[uEntry + 1]);
+      uOccurrences = 0;
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+static QCBORError
+Schema_CheckMap(const SchemaValidator *pMe,
+                uint32_t               uNode,
+                const QCBORItem       *pMap,
+                uint8_t               *puNextLevel)
+{
+   QCBORError     uErr;
+   QCBORItem      Item;
+   QCBORItem      Label;
+   uint16_t       auOccurrences[QCBOR_SCHEMA_MAX_MAP_MEMBERS];
+   const uint32_t uMembers = pMe->puCode[uNode + 1];
+   uint32_t       uMember;
+   uint32_t       uEntry;
+   uint32_t       uKeyOp;
+   int            nPass;
+
+   memset(auOccurrences, 0, sizeof(auOccurrences));
+
+   /* Labels are matched as items with no tags */
+   memset(&Label, 0, sizeof(Label));
+
+   while(*puNextLevel > pMap->uNestingLevel) {
+      uErr = QCBORDecode_GetNext(pMe->pDecode, &Item);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+
+      Label.uDataType = Item.uLabelType;
+      switch(Item.uLabelType) {
+         case QCBOR_TYPE_INT64:  Label.val.int64  = Item.label.int64;  break;
+         case QCBOR_TYPE_UINT64: Label.val.uint64 = Item.label.uint64; break;
+         default:                Label.val.string = Item.label.string; break;
+      }
+
+      /* Members with value keys first, then ones with type keys */
+      uEntry = 0;
+      for(nPass = 0; nPass < 2; nPass++) {
+         uEntry = uNode + 2;
+         for(uMember = 0; uMember < uMembers; uMember++) {
+            uKeyOp = SCHEMA_OP(pMe->puCode[uEntry + 1]);
+            if((nPass == 0) == (uKeyOp == SCHEMA_OP_VALUE || uKeyOp == SCHEMA_OP_RANGE) &&
+               auOccurrences[uMember] < (pMe->puCode[uEntry] & 0xffff) &&
+               Schema_Match(pMe, uEntry + 1, &Label, 0, 0) != SCHEMA_NO_MATCH) {
+               break;
+            }
+            uEntry += 1 + SCHEMA_SKIP(pMe->puCode[uEntry + 1]);
+            uEntry += SCHEMA_SKIP(pMe->puCode[uEntry]);
+         }
+         if(uMember < uMembers) {
+            break;
+         }
+      }
+      if(nPass == 2) {
+         /* A label not in the schema */
+         return QCBOR_ERR_SCHEMA_MISMATCH;
+      }
+
+      auOccurrences[uMember]++;
+      uEntry += 1 + SCHEMA_SKIP(pMe->puCode[uEntry + 1]);
+      uErr = Schema_CheckItem(pMe, uEntry, &Item, puNextLevel);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+   }
+
+   /* Check required members are present */
+   uEntry = uNode + 2;
+   for(uMember = 0; uMember < uMembers; uMember++) {
+      if(auOccurrences[uMember] < pMe->puCode[uEntry] >> 16) {
+         return QCBOR_ERR_SCHEMA_MISMATCH;
+      }
+      uEntry += 1 + SCHEMA_SKIP(pMe->puCode[uEntry + 1]);
+      uEntry += SCHEMA_SKIP(pMe->puCode[uEntry]);
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/**
+ * @brief Consume and check the contents of an array or map.
+ *
+ * @param[in] pMe           The validator.
+ * @param[in] uNode         The node returned by Schema_Match() for @c pItem.
+ * @param[in] pItem         The item just gotten.
+ * @param[out] puNextLevel  The nesting level of the item after all
+ *                          that was consumed.
+ *
+ * This does nothing but set @c puNextLevel for items that are not
+ * arrays or maps. Arrays and maps that matched "any" are consumed
+ * without checking.
+ */
+static QCBORError
+Schema_Descend(const SchemaValidator *pMe,
+               uint32_t               uNode,
+               const QCBORItem       *pItem,
+               uint8_t               *puNextLevel)
+{
+   QCBORError uErr;
+   QCBORItem  Item;
+
+   *puNextLevel = pItem->uNextNestLevel;
+
+   if(pItem->uDataType != QCBOR_TYPE_ARRAY && pItem->uDataType != QCBOR_TYPE_MAP) {
+      return QCBOR_SUCCESS;
+   }
+
+   switch(SCHEMA_OP(pMe->puCode[uNode])) {
+      case SCHEMA_OP_ARRAY:
+         return Schema_CheckArray(pMe, uNode, pItem, puNextLevel);
+
+      case SCHEMA_OP_MAP:
+         return Schema_CheckMap(pMe, uNode, pItem, puNextLevel);
+
+      default:
+         while(*puNextLevel > pItem->uNestingLevel) {
+            uErr = QCBORDecode_GetNext(pMe->pDecode, &Item);
+            if(uErr != QCBOR_SUCCESS) {
+               return uErr;
+            }
+            *puNextLevel = Item.uNextNestLevel;
+         }
+         return QCBOR_SUCCESS;
+   }
+}
+
+
+/*
+ * Public function. See qcbor_schema.h
+ */
+void
+QCBORDecode_ValidateSchema(QCBORDecodeContext *pMe, const QCBORSchema *pSchema)
+{
+   QCBORError      uErr;
+   QCBORItem       Item;
+   SchemaValidator Validator;
+   uint8_t         uNextLevel;
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      return;
+   }
+
+   if(pSchema->uCodeLen < 3 ||
+      pSchema->puCode[0] != SCHEMA_MAGIC ||
+      pSchema->puCode[1] >= pSchema->uCodeLen) {
+      uErr = QCBOR_ERR_SCHEMA_SYNTAX;
+      goto Done;
+   }
+
+   Validator.pDecode  = pMe;
+   Validator.puCode   = pSchema->puCode;
+   Validator.uCodeLen = pSchema->uCodeLen;
+
+   uErr = QCBORDecode_GetNext(pMe, &Item);
+   if(uErr != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   uErr = Schema_CheckItem(&Validator, pSchema->puCode[1], &Item, &uNextLevel);
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
+}
@@ -0,0 +1,450 @@
+/*==============================================================================
+ qcbor_seq_index.c -- Offset index of CBOR sequences
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_seq_index.h"
+#include "qcbor/qcbor_view.h"
+#include "qcbor_decode_private.h"
+
+
+/**
+ * @file qcbor_seq_index.c
+ *
+ * This implements the functions in qcbor_seq_index.h. Records are
+ * skipped with QCBORDecode_Private_SkipItem() and keys are gotten
+ * with views.
+ */
+
+
+#define SEQ_INDEX_KEYED_HEADER_SIZE 37
+#define SEQ_INDEX_HEADER_SIZE       29
+#define SEQ_INDEX_HEAD_UINT         (CBOR_MAJOR_TYPE_POSITIVE_INT << 5 | LEN_IS_EIGHT_BYTES)
+#define SEQ_INDEX_HEAD_NINT         (CBOR_MAJOR_TYPE_NEGATIVE_INT << 5 | LEN_IS_EIGHT_BYTES)
+#define SEQ_INDEX_HEAD_BSTR         (CBOR_MAJOR_TYPE_BYTE_STRING << 5 | LEN_IS_EIGHT_BYTES)
+#define SEQ_INDEX_HEAD_NULL         (CBOR_MAJOR_TYPE_SIMPLE << 5 | CBOR_SIMPLEV_NULL)
+
+
+/* An index after its header has been checked */
+typedef struct {
+   UsefulBufC Entries;
+   uint64_t   uNumRecords;
+   uint64_t   uNumEntries;
+   int64_t    nKeyLabel;
+   uint32_t   uInterval;
+   uint8_t    uEntrySize;
+} SeqIndex;
+
+
+/* Get the integer value of the member with label nKeyLabel of the
+ * map at uOffset */
+static QCBORError
+SeqIndex_GetKey(UsefulBufC Encoded, size_t uOffset, int64_t nKeyLabel, int64_t *pnKey)
+{
+   QCBORError uReturn;
+   QCBORView  Record;
+   QCBORView  Key;
+   QCBORItem  Item;
+
+   Record.Encoded = Encoded;
+   Record.uOffset = uOffset;
+
+   uReturn = QCBORView_GetInMapN(&Record, nKeyLabel, NULL, &Key);
+   if(uReturn != QCBOR_SUCCESS) {
+      return uReturn;
+   }
+   uReturn = QCBORView_GetItem(&Key, &Item);
+   if(uReturn != QCBOR_SUCCESS) {
+      return uReturn;
+   }
+   if(Item.uDataType != QCBOR_TYPE_INT64) {
+      return QCBOR_ERR_UNEXPECTED_TYPE;
+   }
+
+   *pnKey = Item.val.int64;
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function. See qcbor_seq_index.h
+ */
+void
+QCBORSeqIndex_Init(QCBORSeqIndexBuilder *pMe,
+                   UsefulBuf             Storage,
+                   uint32_t              uInterval,
+                   bool                  bKeys,
+                   int64_t               nKeyLabel)
+{
+   pMe->Storage     = Storage;
+   pMe->uNumRecords = 0;
+   pMe->nKeyLabel   = nKeyLabel;
+   pMe->nLastKey    = INT64_MIN;
+   pMe->uInterval   = uInterval;
+   pMe->bKeys       = bKeys;
+   pMe->uError      = uInterval == 0 ? QCBOR_ERR_UNSUPPORTED : QCBOR_SUCCESS;
+
+   /* The header is filled in by QCBORSeqIndex_Finish() when the number
+    * of records is known. The entries go after it. */
+   UsefulOutBuf_Init(&(pMe->OutBuf), Storage);
+   UsefulOutBuf_Advance(&(pMe->OutBuf),
+                        bKeys ? SEQ_INDEX_KEYED_HEADER_SIZE : SEQ_INDEX_HEADER_SIZE);
+}
+
+
+/*
+ * Public function. See qcbor_seq_index.h
+ */
+void
+QCBORSeqIndex_AddRecord(QCBORSeqIndexBuilder *pMe, uint64_t uOffset, int64_t nKey)
+{
+   if(pMe->uError != QCBOR_SUCCESS) {
+      return;
+   }
+
+   if(pMe->bKeys) {
+      if(nKey < pMe->nLastKey) {
+         pMe->uError = QCBOR_ERR_UNSUPPORTED;
+         return;
+      }
+      pMe->nLastKey = nKey;
+   }
+
+   if(pMe->uNumRecords % pMe->uInterval == 0) {
+      UsefulOutBuf_AppendUint64(&(pMe->OutBuf), uOffset);
+      if(pMe->bKeys) {
+         UsefulOutBuf_AppendUint64(&(pMe->OutBuf), (uint64_t)nKey);
+      }
+   }
+   pMe->uNumRecords++;
+}
+
+
+/*
+ * Public function. See qcbor_seq_index.h
+ */
+void
+QCBORSeqIndex_AddSequence(QCBORSeqIndexBuilder *pMe,
+                          UsefulBufC            Records,
+                          uint64_t              uBaseOffset)
+{
+   QCBORError     uErr;
+   UsefulInputBuf InBuf;
+   size_t         uOffset;
+   int64_t        nKey;
+
+   UsefulInputBuf_Init(&InBuf, Records);
+
+   nKey = 0;
+   while(pMe->uError == QCBOR_SUCCESS && UsefulInputBuf_BytesUnconsumed(&InBuf) > 0) {
+      uOffset = UsefulInputBuf_Tell(&InBuf);
+
+      if(pMe->bKeys) {
+         uErr = SeqIndex_GetKey(Records, uOffset, pMe->nKeyLabel, &nKey);
+         if(uErr != QCBOR_SUCCESS) {
+            pMe->uError = (uint8_t)uErr;
+            break;
+         }
+      }
+
+      uErr = QCBORDecode_Private_SkipItem(&InBuf);
+      if(uErr != QCBOR_SUCCESS) {
+         pMe->uError = (uint8_t)uErr;
+         break;
+      }
+
+      QCBORSeqIndex_AddRecord(pMe, uBaseOffset + uOffset, nKey);
+   }
+}
+
+
+/*
+ * Public function. See qcbor_seq_index.h
+ */
+QCBORError
+QCBORSeqIndex_Finish(QCBORSeqIndexBuilder *pMe, UsefulBufC *pIndex)
+{
+   UsefulOutBuf Header;
+   size_t       uHeaderSize;
+
+   if(pMe->uError != QCBOR_SUCCESS) {
+      return pMe->uError;
+   }
+   if(UsefulOutBuf_GetError(&(pMe->OutBuf))) {
+      return QCBOR_ERR_BUFFER_TOO_SMALL;
+   }
+
+   *pIndex = UsefulOutBuf_OutUBuf(&(pMe->OutBuf));
+   if(pIndex->ptr == NULL) {
+      return QCBOR_SUCCESS;
+   }
+
+   /* The fixed-size header in the space left for it */
+   uHeaderSize = pMe->bKeys ? SEQ_INDEX_KEYED_HEADER_SIZE : SEQ_INDEX_HEADER_SIZE;
+   UsefulOutBuf_Init(&Header, (UsefulBuf){pMe->Storage.ptr, uHeaderSize});
+
+   UsefulOutBuf_AppendByte(&Header, CBOR_MAJOR_TYPE_ARRAY << 5 | 4);
+   UsefulOutBuf_AppendByte(&Header, SEQ_INDEX_HEAD_UINT);
+   UsefulOutBuf_AppendUint64(&Header, pMe->uInterval);
+   UsefulOutBuf_AppendByte(&Header, SEQ_INDEX_HEAD_UINT);
+   UsefulOutBuf_AppendUint64(&Header, pMe->uNumRecords);
+   if(!pMe->bKeys) {
+      UsefulOutBuf_AppendByte(&Header, SEQ_INDEX_HEAD_NULL);
+   } else if(pMe->nKeyLabel >= 0) {
+      UsefulOutBuf_AppendByte(&Header, SEQ_INDEX_HEAD_UINT);
+      UsefulOutBuf_AppendUint64(&Header, (uint64_t)pMe->nKeyLabel);
+   } else {
+      UsefulOutBuf_AppendByte(&Header, SEQ_INDEX_HEAD_NINT);
+      UsefulOutBuf_AppendUint64(&Header, (uint64_t)(-1 - pMe->nKeyLabel));
+   }
+   UsefulOutBuf_AppendByte(&Header, SEQ_INDEX_HEAD_BSTR);
+   UsefulOutBuf_AppendUint64(&Header, pIndex->len - uHeaderSize);
+
+   return QCBOR_SUCCESS;
+}
+
+
+/* Check the header of an index and find its entries */
+static QCBORError
+SeqIndex_Open(UsefulBufC Encoded, SeqIndex *pIndex)
+{
+   UsefulInputBuf InBuf;
+   int            nMajorType;
+   int            nAdditionalInfo;
+   uint64_t       uInterval;
+   uint64_t       uLen;
+   bool           bKeys;
+
+   UsefulInputBuf_Init(&InBuf, Encoded);
+
+   if(DecodeHead(&InBuf, &nMajorType, &uLen, &nAdditionalInfo) != QCBOR_SUCCESS ||
+      nMajorType != CBOR_MAJOR_TYPE_ARRAY || uLen != 4) {
+      goto BadIndex;
+   }
+   if(DecodeHead(&InBuf, &nMajorType, &uInterval, &nAdditionalInfo) != QCBOR_SUCCESS ||
+      nMajorType != CBOR_MAJOR_TYPE_POSITIVE_INT ||
+      uInterval == 0 || uInterval > UINT32_MAX) {
+      goto BadIndex;
+   }
+   pIndex->uInterval = (uint32_t)uInterval;
+   if(DecodeHead(&InBuf, &nMajorType, &pIndex->uNumRecords, &nAdditionalInfo) != QCBOR_SUCCESS ||
+      nMajorType != CBOR_MAJOR_TYPE_POSITIVE_INT) {
+      goto BadIndex;
+   }
+
+   if(DecodeHead(&InBuf, &nMajorType, &uLen, &nAdditionalInfo) != QCBOR_SUCCESS) {
+      goto BadIndex;
+   }
+   bKeys = true;
+   if(nMajorType == CBOR_MAJOR_TYPE_POSITIVE_INT && uLen <= INT64_MAX) {
+      pIndex->nKeyLabel = (int64_t)uLen;
+   } else if(nMajorType == CBOR_MAJOR_TYPE_NEGATIVE_INT && uLen <= INT64_MAX) {
+      pIndex->nKeyLabel = -1 - (int64_t)uLen;
+   } else if(nMajorType == CBOR_MAJOR_TYPE_SIMPLE && nAdditionalInfo == CBOR_SIMPLEV_NULL) {
+      bKeys = false;
+   } else {
+      goto BadIndex;
+   }
+   pIndex->uEntrySize = bKeys ? 16 : 8;
+
+   /* The entries must be just the right size for the number of
+    * records. Then no lookup can go off the end of them. */
+   pIndex->uNumEntries = pIndex->uNumRecords / pIndex->uInterval +
+                         (pIndex->uNumRecords % pIndex->uInterval ? 1 : 0);
+   if(DecodeHead(&InBuf, &nMajorType, &uLen, &nAdditionalInfo) != QCBOR_SUCCESS ||
+      nMajorType != CBOR_MAJOR_TYPE_BYTE_STRING ||
+      uLen != UsefulInputBuf_BytesUnconsumed(&InBuf) ||
+      uLen / pIndex->uEntrySize != pIndex->uNumEntries ||
+      uLen % pIndex->uEntrySize != 0) {
+      goto BadIndex;
+   }
+   pIndex->Entries = UsefulInputBuf_GetUsefulBuf(&InBuf, (size_t)uLen);
+
+   return QCBOR_SUCCESS;
+
+BadIndex:
+   return QCBOR_ERR_UNEXPECTED_TYPE;
+}
+
+
+static uint64_t
+SeqIndex_GetEntry(const SeqIndex *pIndex, uint64_t uEntry, int64_t *pnKey)
+{
+   UsefulInputBuf InBuf;
+   uint64_t       uOffset;
+
+   /* uEntry is less than uNumEntries which was checked against the
+    * size of Entries so this is always in range */
+   UsefulInputBuf_Init(&InBuf, pIndex->Entries);
+   UsefulInputBuf_Seek(&InBuf, (size_t)(uEntry * pIndex->uEntrySize));
+   uOffset = UsefulInputBuf_GetUint64(&InBuf);
+   if(pnKey != NULL) {
+      *pnKey = (int64_t)UsefulInputBuf_GetUint64(&InBuf);
+   }
+
+   return uOffset;
+}
+
+
+/* Set up pInBuf on the decoder's input at the start of an entry's
+ * record */
+static QCBORError
+SeqIndex_SeekEntry(QCBORDecodeContext *pMe,
+                   const SeqIndex     *pIndex,
+                   uint64_t            uEntry,
+                   UsefulInputBuf     *pInBuf)
+{
+   const uint64_t uOffset = SeqIndex_GetEntry(pIndex, uEntry, NULL);
+
+   /* After exiting the last map entered, the bounded level is the top
+    * level rather than NULL */
+   if(pMe->nesting.pCurrentBounded != NULL &&
+      pMe->nesting.pCurrentBounded != &(pMe->nesting.pLevels[0])) {
+      return QCBOR_ERR_UNSUPPORTED;
+   }
+
+   UsefulInputBuf_Init(pInBuf, pMe->InBuf.UB);
+   if(uOffset >= UsefulInputBuf_GetBufferLength(pInBuf)) {
+      return QCBOR_ERR_HIT_END;
+   }
+   UsefulInputBuf_Seek(pInBuf, (size_t)uOffset);
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function. See qcbor_seq_index.h
+ */
+QCBORError
+QCBORSeqIndex_SeekToRecord(QCBORDecodeContext *pMe,
+                           UsefulBufC          Index,
+                           uint64_t            uRecord)
+{
+   QCBORError     uReturn;
+   SeqIndex       Idx;
+   UsefulInputBuf InBuf;
+   uint32_t       uSkip;
+
+   uReturn = SeqIndex_Open(Index, &Idx);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   if(uRecord >= Idx.uNumRecords) {
+      uReturn = QCBOR_ERR_NO_MORE_ITEMS;
+      goto Done;
+   }
+
+   uReturn = SeqIndex_SeekEntry(pMe, &Idx, uRecord / Idx.uInterval, &InBuf);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   for(uSkip = (uint32_t)(uRecord % Idx.uInterval); uSkip > 0; uSkip--) {
+      uReturn = QCBORDecode_Private_SkipItem(&InBuf);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+   if(UsefulInputBuf_BytesUnconsumed(&InBuf) == 0) {
+      uReturn = QCBOR_ERR_HIT_END;
+      goto Done;
+   }
+
+   QCBORDecode_Private_SeekTop(pMe, UsefulInputBuf_Tell(&InBuf));
+
+Done:
+   return uReturn;
+}
+
+
+/*
+ * Public function. See qcbor_seq_index.h
+ */
+QCBORError
+QCBORSeqIndex_SeekToKey(QCBORDecodeContext *pMe,
+                        UsefulBufC          Index,
+                        int64_t             nKey)
+{
+   QCBORError     uReturn;
+   SeqIndex       Idx;
+   UsefulInputBuf InBuf;
+   uint64_t       uLow;
+   uint64_t       uHigh;
+   uint64_t       uMid;
+   uint64_t       uRecordsLeft;
+   int64_t        nEntryKey;
+   int64_t        nRecordKey;
+   size_t         uOffset;
+
+   uReturn = SeqIndex_Open(Index, &Idx);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   if(Idx.uEntrySize != 16) {
+      uReturn = QCBOR_ERR_UNEXPECTED_TYPE;
+      goto Done;
+   }
+   if(Idx.uNumEntries == 0) {
+      uReturn = QCBOR_ERR_LABEL_NOT_FOUND;
+      goto Done;
+   }
+
+   /* Find the last entry with a key less than nKey. The first record
+    * with nKey is after it. Keys can repeat so an entry with a key
+    * equal to nKey may not be the first record with it. If there is
+    * no such entry, start at the first. */
+   uLow  = 0;
+   uHigh = Idx.uNumEntries;
+   while(uHigh - uLow > 1) {
+      uMid = uLow + (uHigh - uLow) / 2;
+      (void)SeqIndex_GetEntry(&Idx, uMid, &nEntryKey);
+      if(nEntryKey < nKey) {
+         uLow = uMid;
+      } else {
+         uHigh = uMid;
+      }
+   }
+
+   uReturn = SeqIndex_SeekEntry(pMe, &Idx, uLow, &InBuf);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   /* Look at the records from the entry up to the next entry, and one
+    * more as that is where the key is when it is in the next entry
+    * and repeated in the records before it */
+   uRecordsLeft = Idx.uNumRecords - uLow * Idx.uInterval;
+   if(uRecordsLeft > (uint64_t)Idx.uInterval + 1) {
+      uRecordsLeft = (uint64_t)Idx.uInterval + 1;
+   }
+   for(; uRecordsLeft > 0; uRecordsLeft--) {
+      uOffset = UsefulInputBuf_Tell(&InBuf);
+      uReturn = SeqIndex_GetKey(InBuf.UB, uOffset, Idx.nKeyLabel, &nRecordKey);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+      if(nRecordKey == nKey) {
+         QCBORDecode_Private_SeekTop(pMe, uOffset);
+         goto Done;
+      }
+      if(nRecordKey > nKey) {
+         break;
+      }
+      uReturn = QCBORDecode_Private_SkipItem(&InBuf);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+
+   uReturn = QCBOR_ERR_LABEL_NOT_FOUND;
+
+Done:
+   return uReturn;
+}
@@ -0,0 +1,810 @@
+/*==============================================================================
+ qcbor_struct.c -- Table-driven encoding and decoding of C structures
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_struct.h"
+#include <string.h> /* For memcpy(), memcmp() and strlen() */
+
+
+/**
+ * @file qcbor_struct.c
+ *
+ * Members are read and written through memcpy() at their offset in
+ * the structure so there is no assumption about alignment of the
+ * structure pointer passed in.
+ */
+
+
+static void
+Struct_EncodeLabel(QCBOREncodeContext *pMe, int64_t nLabel, const char *szLabel)
+{
+   if(szLabel != NULL) {
+      QCBOREncode_AddSZString(pMe, szLabel);
+   } else {
+      QCBOREncode_AddInt64(pMe, nLabel);
+   }
+}
+
+
+/* Outputs the value in pMember, which is of uType. Not for
+ * QCBOR_STRUCT_MAP. */
+static void
+Struct_EncodeValue(QCBOREncodeContext *pMe, uint8_t uType, const uint8_t *pMember)
+{
+   int64_t    nValue;
+   uint64_t   uValue;
+   bool       bValue;
+   UsefulBufC String;
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   double     dValue;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+   switch(uType) {
+      case QCBOR_STRUCT_INT64:
+         memcpy(&nValue, pMember, sizeof(nValue));
+         QCBOREncode_AddInt64(pMe, nValue);
+         break;
+
+      case QCBOR_STRUCT_UINT64:
+         memcpy(&uValue, pMember, sizeof(uValue));
+         QCBOREncode_AddUInt64(pMe, uValue);
+         break;
+
+      case QCBOR_STRUCT_DOUBLE:
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+         memcpy(&dValue, pMember, sizeof(dValue));
+         QCBOREncode_AddDouble(pMe, dValue);
+#else /* USEFULBUF_DISABLE_ALL_FLOAT */
+         pMe->uError = QCBOR_ERR_ALL_FLOAT_DISABLED;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+         break;
+
+      case QCBOR_STRUCT_BOOL:
+         memcpy(&bValue, pMember, sizeof(bValue));
+         QCBOREncode_AddBool(pMe, bValue);
+         break;
+
+      case QCBOR_STRUCT_TEXT:
+         memcpy(&String, pMember, sizeof(String));
+         QCBOREncode_AddText(pMe, String);
+         break;
+
+      case QCBOR_STRUCT_BYTES:
+         memcpy(&String, pMember, sizeof(String));
+         QCBOREncode_AddBytes(pMe, String);
+         break;
+
+      default:
+         pMe->uError = QCBOR_ERR_UNSUPPORTED;
+         break;
+   }
+}
+
+
+/*
+ * Public function. See qcbor_struct.h
+ */
+void
+QCBOREncode_AddStruct(QCBOREncodeContext    *pMe,
+                      const QCBORStructDesc *pDesc,
+                      const void            *pStruct)
+{
+   const uint8_t          *pBytes = (const uint8_t *)pStruct;
+   const QCBORStructField *pField;
+   uint32_t                uPresent;
+   uint8_t                 uIndex;
+
+   /* There's one bit for each member in uPresent */
+   if(pDesc->uNumFields > QCBOR_STRUCT_MAX_FIELDS) {
+      pMe->uError = QCBOR_ERR_UNSUPPORTED;
+      return;
+   }
+
+   memcpy(&uPresent, pBytes + pDesc->uPresentOffset, sizeof(uPresent));
+
+   QCBOREncode_OpenMap(pMe);
+
+   for(uIndex = 0; uIndex < pDesc->uNumFields; uIndex++) {
+      pField = &pDesc->pFields[uIndex];
+      if(!(pField->uFlags & QCBOR_STRUCT_REQUIRED) && !(uPresent & (1U << uIndex))) {
+         continue;
+      }
+
+      Struct_EncodeLabel(pMe, pField->nLabel, pField->szLabel);
+
+      if(pField->uType == QCBOR_STRUCT_MAP) {
+         QCBOREncode_AddStruct(pMe, pField->pNested, pBytes + pField->uOffset);
+      } else {
+         Struct_EncodeValue(pMe, pField->uType, pBytes + pField->uOffset);
+      }
+   }
+
+   QCBOREncode_CloseMap(pMe);
+}
+
+
+
+
+typedef struct {
+   QCBORDecodeContext *pDecode;
+   uint8_t             uNextLevel; /* Nesting level of the next item */
+} StructDecoder;
+
+
+/* Whether the label of pItem is nLabel or szLabel */
+static bool
+Struct_LabelMatches(int64_t nLabel, const char *szLabel, const QCBORItem *pItem)
+{
+   if(szLabel == NULL) {
+      return pItem->uLabelType == QCBOR_TYPE_INT64 && pItem->label.int64 == nLabel;
+   } else {
+      return pItem->uLabelType == QCBOR_TYPE_TEXT_STRING &&
+             pItem->label.string.len == strlen(szLabel) &&
+             !memcmp(pItem->label.string.ptr, szLabel, pItem->label.string.len);
+   }
+}
+
+
+/* Finds the member for the label of pItem starting at uHint, which is
+ * the one after the member last found. Returns uNumFields if not
+ * found. */
+static uint8_t
+Struct_FindField(const QCBORStructDesc *pDesc, const QCBORItem *pItem, uint8_t uHint)
+{
+   const QCBORStructField *pField;
+   uint8_t                 uCount;
+   uint8_t                 uIndex;
+
+   uIndex = uHint;
+   for(uCount = 0; uCount < pDesc->uNumFields; uCount++, uIndex++) {
+      if(uIndex >= pDesc->uNumFields) {
+         uIndex = 0;
+      }
+      pField = &pDesc->pFields[uIndex];
+      if(Struct_LabelMatches(pField->nLabel, pField->szLabel, pItem)) {
+         return uIndex;
+      }
+   }
+
+   return pDesc->uNumFields;
+}
+
+
+/* Consumes the contents of an array or map not in the structure */
+static QCBORError
+Struct_Skip(StructDecoder *pMe, const QCBORItem *pItem)
+{
+   QCBORError uErr;
+   QCBORItem  Item;
+
+   while(pMe->uNextLevel > pItem->uNestingLevel) {
+      uErr = QCBORDecode_GetNext(pMe->pDecode, &Item);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+      pMe->uNextLevel = Item.uNextNestLevel;
+   }
+   return QCBOR_SUCCESS;
+}
+
+
+static QCBORError
+Struct_DecodeMap(StructDecoder         *pMe,
+                 const QCBORStructDesc *pDesc,
+                 uint8_t               *pBytes,
+                 const QCBORItem       *pMap);
+
+
+/* Stores the value of pItem in pMember, which is of uType. Not for
+ * QCBOR_STRUCT_MAP. */
+static QCBORError
+Struct_DecodeValue(uint8_t uType, uint8_t *pMember, const QCBORItem *pItem)
+{
+   bool bValue;
+
+   switch(uType) {
+      case QCBOR_STRUCT_INT64:
+         if(pItem->uDataType != QCBOR_TYPE_INT64) {
+            return pItem->uDataType == QCBOR_TYPE_UINT64 ? QCBOR_ERR_INT_OVERFLOW :
+                                                           QCBOR_ERR_UNEXPECTED_TYPE;
+         }
+         memcpy(pMember, &pItem->val.int64, sizeof(int64_t));
+         break;
+
+      case QCBOR_STRUCT_UINT64:
+         if(pItem->uDataType == QCBOR_TYPE_INT64) {
+            if(pItem->val.int64 < 0) {
+               return QCBOR_ERR_NUMBER_SIGN_CONVERSION;
+            }
+         } else if(pItem->uDataType != QCBOR_TYPE_UINT64) {
+            return QCBOR_ERR_UNEXPECTED_TYPE;
+         }
+         /* Non-negative int64 and uint64 share representation */
+         memcpy(pMember, &pItem->val.uint64, sizeof(uint64_t));
+         break;
+
+      case QCBOR_STRUCT_DOUBLE:
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+         if(pItem->uDataType == QCBOR_TYPE_DOUBLE) {
+            memcpy(pMember, &pItem->val.dfnum, sizeof(double));
+#ifndef QCBOR_DISABLE_FLOAT_HW_USE
+         } else if(pItem->uDataType == QCBOR_TYPE_FLOAT) {
+            const double dValue = (double)pItem->val.fnum;
+            memcpy(pMember, &dValue, sizeof(double));
+#endif /* QCBOR_DISABLE_FLOAT_HW_USE */
+         } else {
+            return QCBOR_ERR_UNEXPECTED_TYPE;
+         }
+         break;
+#else /* USEFULBUF_DISABLE_ALL_FLOAT */
+         return QCBOR_ERR_ALL_FLOAT_DISABLED;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+      case QCBOR_STRUCT_BOOL:
+         if(pItem->uDataType != QCBOR_TYPE_TRUE && pItem->uDataType != QCBOR_TYPE_FALSE) {
+            return QCBOR_ERR_UNEXPECTED_TYPE;
+         }
+         bValue = pItem->uDataType == QCBOR_TYPE_TRUE;
+         memcpy(pMember, &bValue, sizeof(bool));
+         break;
+
+      case QCBOR_STRUCT_TEXT:
+      case QCBOR_STRUCT_BYTES:
+         if(pItem->uDataType != (uType == QCBOR_STRUCT_TEXT ? QCBOR_TYPE_TEXT_STRING :
+                                                              QCBOR_TYPE_BYTE_STRING)) {
+            return QCBOR_ERR_UNEXPECTED_TYPE;
+         }
+         memcpy(pMember, &pItem->val.string, sizeof(UsefulBufC));
+         break;
+
+      default:
+         return QCBOR_ERR_UNSUPPORTED;
+   }
+
+   return QCBOR_SUCCESS;
+}
+
+
+/* Stores the value of pItem in the member */
+static QCBORError
+Struct_DecodeField(StructDecoder          *pMe,
+                   const QCBORStructField *pField,
+                   uint8_t                *pBytes,
+                   const QCBORItem        *pItem)
+{
+   uint8_t *pMember = pBytes + pField->uOffset;
+
+   if(pField->uType == QCBOR_STRUCT_MAP) {
+      if(pItem->uDataType != QCBOR_TYPE_MAP) {
+         return QCBOR_ERR_UNEXPECTED_TYPE;
+      }
+      return Struct_DecodeMap(pMe, pField->pNested, pMember, pItem);
+   }
+
+   return Struct_DecodeValue(pField->uType, pMember, pItem);
+}
+
+
+static QCBORError
+Struct_DecodeMap(StructDecoder         *pMe,
+                 const QCBORStructDesc *pDesc,
+                 uint8_t               *pBytes,
+                 const QCBORItem       *pMap)
+{
+   QCBORError uErr;
+   QCBORItem  Item;
+   uint32_t   uPresent;
+   uint8_t    uIndex;
+   uint8_t    uHint;
+
+   if(pDesc->uNumFields > QCBOR_STRUCT_MAX_FIELDS) {
+      return QCBOR_ERR_UNSUPPORTED;
+   }
+
+   uPresent = 0;
+   uHint    = 0;
+   pMe->uNextLevel = pMap->uNextNestLevel;
+
+   while(pMe->uNextLevel > pMap->uNestingLevel) {
+      uErr = QCBORDecode_GetNext(pMe->pDecode, &Item);
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+      pMe->uNextLevel = Item.uNextNestLevel;
+
+      uIndex = Struct_FindField(pDesc, &Item, uHint);
+      if(uIndex == pDesc->uNumFields) {
+         uErr = Struct_Skip(pMe, &Item);
+      } else if(uPresent & (1U << uIndex)) {
+         uErr = QCBOR_ERR_DUPLICATE_LABEL;
+      } else {
+         uPresent |= 1U << uIndex;
+         uHint = (uint8_t)(uIndex + 1);
+         uErr = Struct_DecodeField(pMe, &pDesc->pFields[uIndex], pBytes, &Item);
+      }
+      if(uErr != QCBOR_SUCCESS) {
+         return uErr;
+      }
+   }
+
+   for(uIndex = 0; uIndex < pDesc->uNumFields; uIndex++) {
+      if((pDesc->pFields[uIndex].uFlags & QCBOR_STRUCT_REQUIRED) && !(uPresent & (1U << uIndex))) {
+         return QCBOR_ERR_LABEL_NOT_FOUND;
+      }
+   }
+
+   memcpy(pBytes + pDesc->uPresentOffset, &uPresent, sizeof(uPresent));
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ * Public function. See qcbor_struct.h
+ */
+void
+QCBORDecode_GetStruct(QCBORDecodeContext    *pMe,
+                      const QCBORStructDesc *pDesc,
+                      void                  *pStruct)
+{
+   QCBORError    uErr;
+   QCBORItem     Item;
+   StructDecoder Decoder;
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      return;
+   }
+
+   uErr = QCBORDecode_GetNext(pMe, &Item);
+   if(uErr != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   if(Item.uDataType != QCBOR_TYPE_MAP) {
+      uErr = QCBOR_ERR_UNEXPECTED_TYPE;
+      goto Done;
+   }
+
+   Decoder.pDecode = pMe;
+   uErr = Struct_DecodeMap(&Decoder, pDesc, (uint8_t *)pStruct, &Item);
+
+Done:
+   pMe->uLastError = (uint8_t)uErr;
+}
+
+
+
+
+/* The size of one value in a column of uType or 0 if it can't be a
+ * column */
+static size_t
+Column_ValueSize(uint8_t uType)
+{
+   switch(uType) {
+      case QCBOR_STRUCT_INT64:  return sizeof(int64_t);
+      case QCBOR_STRUCT_UINT64: return sizeof(uint64_t);
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+      case QCBOR_STRUCT_DOUBLE: return sizeof(double);
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+      case QCBOR_STRUCT_BOOL:   return sizeof(bool);
+      case QCBOR_STRUCT_TEXT:
+      case QCBOR_STRUCT_BYTES:  return sizeof(UsefulBufC);
+      default:                  return 0;
+   }
+}
+
+
+/* Finds the column for the label of pItem, first trying uExpected.
+ * Returns uNumColumns if not found. */
+static uint8_t
+Column_Find(const QCBORColumn *pColumns,
+            uint8_t            uNumColumns,
+            const QCBORItem   *pItem,
+            uint8_t            uExpected)
+{
+   uint8_t uIndex;
+
+   if(uExpected < uNumColumns &&
+      Struct_LabelMatches(pColumns[uExpected].nLabel, pColumns[uExpected].szLabel, pItem)) {
+      return uExpected;
+   }
+
+   for(uIndex = 0; uIndex < uNumColumns; uIndex++) {
+      if(Struct_LabelMatches(pColumns[uIndex].nLabel, pColumns[uIndex].szLabel, pItem)) {
+         return uIndex;
+      }
+   }
+
+   return uNumColumns;
+}
+
+
+/*
+ * Public function. See qcbor_struct.h
+ */
+void
+QCBORDecode_GetColumns(QCBORDecodeContext *pMe,
+                       const QCBORColumn  *pColumns,
+                       uint8_t             uNumColumns,
+                       size_t              uMaxRows,
+                       size_t             *puNumRows)
+{
+   QCBORError    uErr;
+   QCBORItem     Array;
+   QCBORItem     Map;
+   QCBORItem     Item;
+   StructDecoder Decoder;
+   size_t        uRow;
+   size_t        uSize;
+   size_t        uPosition;
+   size_t        uOrderLen;
+   uint32_t      uSeen;
+   uint32_t      uPresent; /* Seen and not null */
+   uint8_t       uIndex;
+   uint8_t      *pValue;
+   uint8_t       uNullMask;
+
+   /* The column for each position in the first map, uNumColumns for
+    * members that aren't a column */
+   uint8_t       auOrder[QCBOR_STRUCT_MAX_FIELDS];
+
+   uRow       = 0;
+   *puNumRows = 0;
+
+   if(pMe->uLastError != QCBOR_SUCCESS) {
+      return;
+   }
+
+   if(uNumColumns > QCBOR_STRUCT_MAX_FIELDS) {
+      uErr = QCBOR_ERR_UNSUPPORTED;
+      goto Done;
+   }
+   for(uIndex = 0; uIndex < uNumColumns; uIndex++) {
+      if(Column_ValueSize(pColumns[uIndex].uType) == 0) {
+         uErr = QCBOR_ERR_UNSUPPORTED;
+         goto Done;
+      }
+   }
+
+   uErr = QCBORDecode_GetNext(pMe, &Array);
+   if(uErr != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   if(Array.uDataType != QCBOR_TYPE_ARRAY) {
+      uErr = QCBOR_ERR_UNEXPECTED_TYPE;
+      goto Done;
+   }
+
+   Decoder.pDecode    = pMe;
+   Decoder.uNextLevel = Array.uNextNestLevel;
+   uOrderLen          = 0;
+
+   while(Decoder.uNextLevel > Array.uNestingLevel) {
+      uErr = QCBORDecode_GetNext(pMe, &Map);
+      if(uErr != QCBOR_SUCCESS) {
+         goto Done;
+      }
+      Decoder.uNextLevel = Map.uNextNestLevel;
+      if(Map.uDataType != QCBOR_TYPE_MAP) {
+         uErr = QCBOR_ERR_UNEXPECTED_TYPE;
+         goto Done;
+      }
+      if(uRow >= uMaxRows) {
+         uErr = QCBOR_ERR_ARRAY_TOO_LONG;
+         goto Done;
+      }
+
+      uSeen     = 0;
+      uPresent  = 0;
+      uPosition = 0;
+      while(Decoder.uNextLevel > Map.uNestingLevel) {
+         uErr = QCBORDecode_GetNext(pMe, &Item);
+         if(uErr != QCBOR_SUCCESS) {
+            goto Done;
+         }
+         Decoder.uNextLevel = Item.uNextNestLevel;
+
+         if(uRow == 0) {
+            uIndex = Column_Find(pColumns, uNumColumns, &Item, uNumColumns);
+            if(uPosition < QCBOR_STRUCT_MAX_FIELDS) {
+               auOrder[uPosition] = uIndex;
+               uOrderLen = uPosition + 1;
+            }
+         } else {
+            uIndex = Column_Find(pColumns, uNumColumns, &Item,
+                                 uPosition < uOrderLen ? auOrder[uPosition] : uNumColumns);
+         }
+         uPosition++;
+
+         if(uIndex == uNumColumns) {
+            uErr = Struct_Skip(&Decoder, &Item);
+            if(uErr != QCBOR_SUCCESS) {
+               goto Done;
+            }
+            continue;
+         }
+         if(uSeen & (1U << uIndex)) {
+            uErr = QCBOR_ERR_DUPLICATE_LABEL;
+            goto Done;
+         }
+         uSeen |= 1U << uIndex;
+         if(Item.uDataType == QCBOR_TYPE_NULL) {
+            /* Left absent so it is recorded as null below */
+            continue;
+         }
+         uPresent |= 1U << uIndex;
+
+         uSize  = Column_ValueSize(pColumns[uIndex].uType);
+         pValue = (uint8_t *)pColumns[uIndex].pValues + uRow * uSize;
+         uErr = Struct_DecodeValue(pColumns[uIndex].uType, pValue, &Item);
+         if(uErr != QCBOR_SUCCESS) {
+            goto Done;
+         }
+      }
+
+      /* Record the nulls and check for missing required columns */
+      uNullMask = (uint8_t)(1U << (uRow % 8));
+      for(uIndex = 0; uIndex < uNumColumns; uIndex++) {
+         if(uPresent & (1U << uIndex)) {
+            if(pColumns[uIndex].pNulls != NULL) {
+               pColumns[uIndex].pNulls[uRow / 8] &= (uint8_t)~uNullMask;
+            }
+            continue;
+         }
+         if(pColumns[uIndex].uFlags & QCBOR_STRUCT_REQUIRED) {
+            uErr = QCBOR_ERR_LABEL_NOT_FOUND;
+            goto Done;
+         }
+         uSize = Column_ValueSize(pColumns[uIndex].uType);
+         memset((uint8_t *)pColumns[uIndex].pValues + uRow * uSize, 0, uSize);
+         if(pColumns[uIndex].pNulls != NULL) {
+            pColumns[uIndex].pNulls[uRow / 8] |= uNullMask;
+         }
+      }
+
+      uRow++;
+   }
+
+Done:
+   *puNumRows = uRow;
+   pMe->uLastError = (uint8_t)uErr;
+}
+
+
+
+
+/* RFC 8746 tags for big-endian typed arrays */
+#define COLUMN_TAG_UINT8_ARRAY      64
+#define COLUMN_TAG_UINT64_BE_ARRAY  67
+#define COLUMN_TAG_SINT64_BE_ARRAY  75
+#define COLUMN_TAG_FLOAT64_BE_ARRAY 82
+
+/* Room for the labels encoded once. Labels that don't fit are encoded
+ * for each row. */
+#define COLUMN_LABEL_BUFFER_SIZE    256
+
+/* Typed array bytes are put together in pieces this big */
+#define COLUMN_CHUNK_SIZE           64
+
+
+static bool
+Column_IsNull(const QCBORColumn *pColumn, size_t uRow)
+{
+   return !(pColumn->uFlags & QCBOR_STRUCT_REQUIRED) &&
+          pColumn->pNulls != NULL &&
+          (pColumn->pNulls[uRow / 8] & (1U << (uRow % 8)));
+}
+
+
+static const uint8_t *
+Column_Value(const QCBORColumn *pColumn, size_t uRow)
+{
+   return (const uint8_t *)pColumn->pValues + uRow * Column_ValueSize(pColumn->uType);
+}
+
+
+/* Encodes the label of the column into pLabels and returns it, or
+ * NULLUsefulBufC if there is no room */
+static UsefulBufC
+Column_EncodeLabelOnce(UsefulOutBuf *pLabels, const QCBORColumn *pColumn)
+{
+   UsefulBufC   Head;
+   UsefulBufC   Text;
+   const size_t uStart = UsefulOutBuf_GetEndPosition(pLabels);
+   UsefulBuf_MAKE_STACK_UB(HeadBuffer, QCBOR_HEAD_BUFFER_SIZE);
+
+   Text = NULLUsefulBufC;
+   if(pColumn->szLabel != NULL) {
+      Text = UsefulBuf_FromSZ(pColumn->szLabel);
+      Head = QCBOREncode_EncodeHead(HeadBuffer, CBOR_MAJOR_TYPE_TEXT_STRING, 0, Text.len);
+   } else if(pColumn->nLabel < 0) {
+      /* Can't overflow because of the + 1 */
+      Head = QCBOREncode_EncodeHead(HeadBuffer, CBOR_MAJOR_TYPE_NEGATIVE_INT, 0,
+                                    (uint64_t)(-(pColumn->nLabel + 1)));
+   } else {
+      Head = QCBOREncode_EncodeHead(HeadBuffer, CBOR_MAJOR_TYPE_POSITIVE_INT, 0,
+                                    (uint64_t)pColumn->nLabel);
+   }
+
+   UsefulOutBuf_AppendUsefulBuf(pLabels, Head);
+   if(Text.len > 0) {
+      UsefulOutBuf_AppendUsefulBuf(pLabels, Text);
+   }
+   if(UsefulOutBuf_GetError(pLabels)) {
+      return NULLUsefulBufC;
+   }
+
+   return UsefulBuf_Tail(UsefulOutBuf_OutUBuf(pLabels), uStart);
+}
+
+
+static void
+Column_AddLabel(QCBOREncodeContext *pMe, const QCBORColumn *pColumn, UsefulBufC Label)
+{
+   if(UsefulBuf_IsNULLC(Label)) {
+      Struct_EncodeLabel(pMe, pColumn->nLabel, pColumn->szLabel);
+   } else {
+      QCBOREncode_AddEncoded(pMe, Label);
+   }
+}
+
+
+/* Outputs a column of integers, doubles or bools as a typed array */
+static void
+Column_AddTypedArray(QCBOREncodeContext *pMe, const QCBORColumn *pColumn, size_t uNumRows)
+{
+   UsefulOutBuf   Chunk;
+   UsefulBufC     Length;
+   size_t         uRow;
+   const uint8_t *pValue;
+   uint64_t       uValue;
+   bool           bValue;
+   uint64_t       uTag;
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   double         dValue;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+   UsefulBuf_MAKE_STACK_UB(ChunkBuffer, COLUMN_CHUNK_SIZE);
+
+   switch(pColumn->uType) {
+      case QCBOR_STRUCT_INT64:  uTag = COLUMN_TAG_SINT64_BE_ARRAY;  break;
+      case QCBOR_STRUCT_UINT64: uTag = COLUMN_TAG_UINT64_BE_ARRAY;  break;
+      case QCBOR_STRUCT_DOUBLE: uTag = COLUMN_TAG_FLOAT64_BE_ARRAY; break;
+      default:                  uTag = COLUMN_TAG_UINT8_ARRAY;      break;
+   }
+
+   /* Bools are one byte, the others eight */
+   Length.ptr = NULL;
+   Length.len = uNumRows * (pColumn->uType == QCBOR_STRUCT_BOOL ? 1 : 8);
+   QCBOREncode_AddTag(pMe, uTag);
+   QCBOREncode_AddBytesLenOnly(pMe, Length);
+
+   UsefulOutBuf_Init(&Chunk, ChunkBuffer);
+   for(uRow = 0; uRow < uNumRows; uRow++) {
+      pValue = Column_Value(pColumn, uRow);
+      switch(pColumn->uType) {
+         case QCBOR_STRUCT_INT64:
+         case QCBOR_STRUCT_UINT64:
+            /* Two's complement int64_t has the same bytes as uint64_t */
+            memcpy(&uValue, pValue, sizeof(uValue));
+            UsefulOutBuf_AppendUint64(&Chunk, uValue);
+            break;
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+         case QCBOR_STRUCT_DOUBLE:
+            memcpy(&dValue, pValue, sizeof(dValue));
+            UsefulOutBuf_AppendDouble(&Chunk, dValue);
+            break;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+         default:
+            memcpy(&bValue, pValue, sizeof(bValue));
+            UsefulOutBuf_AppendByte(&Chunk, bValue ? 1 : 0);
+            break;
+      }
+
+      if(UsefulOutBuf_RoomLeft(&Chunk) < sizeof(uint64_t)) {
+         QCBOREncode_AddBytesContentOnly(pMe, UsefulOutBuf_OutUBuf(&Chunk));
+         UsefulOutBuf_Reset(&Chunk);
+      }
+   }
+   QCBOREncode_AddBytesContentOnly(pMe, UsefulOutBuf_OutUBuf(&Chunk));
+}
+
+
+/*
+ * Public function. See qcbor_struct.h
+ */
+void
+QCBOREncode_AddColumns(QCBOREncodeContext *pMe,
+                       const QCBORColumn  *pColumns,
+                       uint8_t             uNumColumns,
+                       size_t              uNumRows,
+                       uint32_t            uOptions)
+{
+   UsefulOutBuf       Labels;
+   UsefulBufC         aLabels[QCBOR_STRUCT_MAX_FIELDS];
+   const QCBORColumn *pColumn;
+   size_t             uRow;
+   uint8_t            uIndex;
+   uint8_t            uCount;
+   bool               bHasNull;
+   UsefulBuf_MAKE_STACK_UB(LabelBuffer, COLUMN_LABEL_BUFFER_SIZE);
+
+   if(uNumColumns > QCBOR_STRUCT_MAX_FIELDS) {
+      pMe->uError = QCBOR_ERR_UNSUPPORTED;
+      return;
+   }
+   if(uNumRows > QCBOR_MAX_ITEMS_IN_ARRAY) {
+      pMe->uError = QCBOR_ERR_ARRAY_TOO_LONG;
+      return;
+   }
+
+   UsefulOutBuf_Init(&Labels, LabelBuffer);
+   for(uIndex = 0; uIndex < uNumColumns; uIndex++) {
+      if(Column_ValueSize(pColumns[uIndex].uType) == 0) {
+         pMe->uError = QCBOR_ERR_UNSUPPORTED;
+         return;
+      }
+      aLabels[uIndex] = Column_EncodeLabelOnce(&Labels, &pColumns[uIndex]);
+   }
+
+   if(uOptions & QCBOR_COLUMNS_TYPED_ARRAYS) {
+      QCBOREncode_OpenMapOrArrayWithCount(pMe, CBOR_MAJOR_TYPE_MAP, uNumColumns);
+      for(uIndex = 0; uIndex < uNumColumns; uIndex++) {
+         pColumn = &pColumns[uIndex];
+         Column_AddLabel(pMe, pColumn, aLabels[uIndex]);
+
+         bHasNull = false;
+         for(uRow = 0; uRow < uNumRows && !bHasNull; uRow++) {
+            bHasNull = Column_IsNull(pColumn, uRow);
+         }
+
+         if(!bHasNull &&
+            pColumn->uType != QCBOR_STRUCT_TEXT &&
+            pColumn->uType != QCBOR_STRUCT_BYTES) {
+            Column_AddTypedArray(pMe, pColumn, uNumRows);
+            continue;
+         }
+
+         QCBOREncode_OpenMapOrArrayWithCount(pMe, CBOR_MAJOR_TYPE_ARRAY, uNumRows);
+         for(uRow = 0; uRow < uNumRows; uRow++) {
+            if(Column_IsNull(pColumn, uRow)) {
+               QCBOREncode_AddNULL(pMe);
+            } else {
+               Struct_EncodeValue(pMe, pColumn->uType, Column_Value(pColumn, uRow));
+            }
+         }
+         QCBOREncode_CloseMapOrArrayWithCount(pMe, CBOR_MAJOR_TYPE_ARRAY, uNumRows);
+      }
+      QCBOREncode_CloseMapOrArrayWithCount(pMe, CBOR_MAJOR_TYPE_MAP, uNumColumns);
+      return;
+   }
+
+   QCBOREncode_OpenMapOrArrayWithCount(pMe, CBOR_MAJOR_TYPE_ARRAY, uNumRows);
+   for(uRow = 0; uRow < uNumRows && pMe->uError == QCBOR_SUCCESS; uRow++) {
+      uCount = 0;
+      for(uIndex = 0; uIndex < uNumColumns; uIndex++) {
+         if(!Column_IsNull(&pColumns[uIndex], uRow)) {
+            uCount++;
+         }
+      }
+
+      QCBOREncode_OpenMapOrArrayWithCount(pMe, CBOR_MAJOR_TYPE_MAP, uCount);
+      for(uIndex = 0; uIndex < uNumColumns; uIndex++) {
+         pColumn = &pColumns[uIndex];
+         if(Column_IsNull(pColumn, uRow)) {
+            continue;
+         }
+         Column_AddLabel(pMe, pColumn, aLabels[uIndex]);
+         Struct_EncodeValue(pMe, pColumn->uType, Column_Value(pColumn, uRow));
+      }
+      QCBOREncode_CloseMapOrArrayWithCount(pMe, CBOR_MAJOR_TYPE_MAP, uCount);
+   }
+   QCBOREncode_CloseMapOrArrayWithCount(pMe, CBOR_MAJOR_TYPE_ARRAY, uNumRows);
+}
@@ -0,0 +1,358 @@
+/*==============================================================================
+ qcbor_transform.c -- Streaming transformation of encoded CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_transform.h"
+#include "qcbor_encode_private.h"
+
+
+/**
+ * @file qcbor_transform.c
+ *
+ * This implements QCBOREncode_AddTransformed(). The input is checked
+ * once with ConsumeEncodedItem() and then walked member by member.
+ * Members the stages leave alone are not copied one at a time. The
+ * start of the first of them is remembered and they are copied with
+ * one append when a changed member or the end of the array or map is
+ * reached. The count they add is added in one go too.
+ */
+
+
+typedef struct {
+   QCBOREncodeContext        *pEncode;
+   const QCBORTransformStage *pStages;
+   size_t                     uNumStages;
+   UsefulBufC                 Encoded;
+   UsefulInputBuf             InBuf;
+} TransformWalker;
+
+
+/*
+ * Fill in the label type and label of the item from the encoded
+ * label. Tags on the label are skipped. The label has been checked
+ * by ConsumeEncodedItem().
+ */
+static void
+Transform_DecodeLabel(UsefulBufC Label, QCBORTransformItem *pItem)
+{
+   UsefulInputBuf InBuf;
+   uint8_t        uMajorType;
+   uint64_t       uArgument;
+
+   UsefulInputBuf_Init(&InBuf, Label);
+   do {
+      uMajorType = CBOR_MAJOR_TYPE_SIMPLE;
+      if(ConsumeEncodedHead(&InBuf, &uMajorType, &uArgument) != QCBOR_SUCCESS) {
+         break;
+      }
+   } while(uMajorType == CBOR_MAJOR_TYPE_TAG);
+
+   switch(uMajorType) {
+      case CBOR_MAJOR_TYPE_POSITIVE_INT:
+         if(uArgument > INT64_MAX) {
+            pItem->uLabelType   = QCBOR_TYPE_UINT64;
+            pItem->label.uint64 = uArgument;
+         } else {
+            pItem->uLabelType  = QCBOR_TYPE_INT64;
+            pItem->label.int64 = (int64_t)uArgument;
+         }
+         break;
+
+      case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+         if(uArgument > INT64_MAX) {
+            pItem->uLabelType = QCBOR_TYPE_ANY;
+         } else {
+            pItem->uLabelType  = QCBOR_TYPE_INT64;
+            pItem->label.int64 = -(int64_t)uArgument - 1;
+         }
+         break;
+
+      case CBOR_MAJOR_TYPE_BYTE_STRING:
+      case CBOR_MAJOR_TYPE_TEXT_STRING:
+         pItem->uLabelType = uMajorType == CBOR_MAJOR_TYPE_TEXT_STRING ?
+                                QCBOR_TYPE_TEXT_STRING : QCBOR_TYPE_BYTE_STRING;
+         pItem->label.string = UsefulInputBuf_GetUsefulBuf(&InBuf, (size_t)uArgument);
+         break;
+
+      default:
+         pItem->uLabelType = QCBOR_TYPE_ANY;
+         break;
+   }
+}
+
+
+/*
+ * Fill in the major type and tag number of the item from its value.
+ * The offset of the head after the tags is returned in puHeadStart
+ * and of what follows it in puContentStart. For an array or map
+ * puArgument is its count.
+ *
+ * A replacement value from a stage isn't checked, so this has to be
+ * safe for anything.
+ */
+static void
+Transform_DescribeValue(QCBORTransformItem *pItem,
+                        uint64_t           *puArgument,
+                        size_t             *puHeadStart,
+                        size_t             *puContentStart)
+{
+   UsefulInputBuf InBuf;
+   uint8_t        uMajorType;
+
+   UsefulInputBuf_Init(&InBuf, pItem->Value);
+   pItem->uTagNumber = CBOR_TAG_INVALID64;
+   *puArgument       = 0;
+
+   for(;;) {
+      *puHeadStart = UsefulInputBuf_Tell(&InBuf);
+      pItem->uMajorType = UsefulInputBuf_GetByte(&InBuf) >> 5;
+      UsefulInputBuf_Seek(&InBuf, *puHeadStart);
+
+      if(ConsumeEncodedHead(&InBuf, &uMajorType, puArgument) != QCBOR_SUCCESS ||
+         UsefulInputBuf_GetError(&InBuf) ||
+         uMajorType != CBOR_MAJOR_TYPE_TAG) {
+         break;
+      }
+      if(pItem->uTagNumber == CBOR_TAG_INVALID64) {
+         pItem->uTagNumber = *puArgument;
+      }
+   }
+
+   *puContentStart = UsefulInputBuf_Tell(&InBuf);
+}
+
+
+/*
+ * Copy a run of unchanged members from the input and add them to the
+ * count of the open array or map.
+ */
+static void
+Transform_CopyRun(TransformWalker *pMe, size_t uStart, size_t uEnd, uint64_t uNumItems)
+{
+   if(uNumItems == 0) {
+      return;
+   }
+
+   UsefulOutBuf_AppendData(&(pMe->pEncode->OutBuf),
+                           (const uint8_t *)pMe->Encoded.ptr + uStart,
+                           uEnd - uStart);
+   pMe->pEncode->uError = (uint8_t)Nesting_IncrementBy(&(pMe->pEncode->nesting), uNumItems);
+}
+
+
+/*
+ * Transform the uCount members of an array or map, or the one item at
+ * the top when uParentType is QCBOR_TYPE_NONE. The input buffer is
+ * positioned at the first member. This recurses for each array or map
+ * that has to be gone into, which is limited by the encoder's nesting
+ * limit.
+ */
+static void
+Transform_Members(TransformWalker *pMe,
+                  uint8_t          uParentType,
+                  uint64_t         uCount,
+                  uint8_t          uLevel)
+{
+   QCBOREncodeContext *pEncode = pMe->pEncode;
+   QCBORTransformItem  Item;
+   QCBORTransformEdit  Edit;
+   QCBORError          uErr;
+   uint64_t            uIndex;
+   uint64_t            uArgument;
+   uint64_t            uRunItems;
+   size_t              uRunStart;
+   size_t              uMemberStart;
+   size_t              uValueStart;
+   size_t              uHeadStart;
+   size_t              uContentStart;
+   size_t              uStage;
+   bool                bSkipMembers;
+   bool                bDescend;
+   uint8_t             uMajorType;
+
+   const bool bInMap = uParentType == QCBOR_TYPE_MAP;
+
+   /* More than this can't be output in the array or map anyway. It
+    * also keeps uIndex in the 16 bits of Item.uIndex. */
+   if(uCount > QCBOR_MAX_ITEMS_IN_ARRAY) {
+      pEncode->uError = QCBOR_ERR_ARRAY_TOO_LONG;
+      return;
+   }
+
+   uRunItems = 0;
+   uRunStart = 0;
+   for(uIndex = 0; uIndex < uCount; uIndex++) {
+      uMemberStart = UsefulInputBuf_Tell(&(pMe->InBuf));
+
+      Item.uNestLevel  = uLevel;
+      Item.uParentType = uParentType;
+      Item.uIndex      = (uint16_t)uIndex; /* Fits because of the check above */
+      Item.uLabelType  = QCBOR_TYPE_NONE;
+
+      /* All was checked up front so these don't fail */
+      if(bInMap) {
+         (void)ConsumeEncodedItem(&(pMe->InBuf));
+         Transform_DecodeLabel(UsefulBuf_Head(UsefulBuf_Tail(pMe->Encoded, uMemberStart),
+                                              UsefulInputBuf_Tell(&(pMe->InBuf)) - uMemberStart),
+                               &Item);
+      }
+      uValueStart = UsefulInputBuf_Tell(&(pMe->InBuf));
+      (void)ConsumeEncodedItem(&(pMe->InBuf));
+      Item.Value = UsefulBuf_Head(UsefulBuf_Tail(pMe->Encoded, uValueStart),
+                                  UsefulInputBuf_Tell(&(pMe->InBuf)) - uValueStart);
+      Transform_DescribeValue(&Item, &uArgument, &uHeadStart, &uContentStart);
+      uMajorType = Item.uMajorType;
+
+      memset(&Edit, 0, sizeof(Edit));
+      Edit.NewLabel = NULLUsefulBufC;
+      Edit.NewValue = NULLUsefulBufC;
+      bSkipMembers  = true;
+
+      for(uStage = 0; uStage < pMe->uNumStages; uStage++) {
+         Edit.bSkipMembers = false;
+         uErr = (*pMe->pStages[uStage].pfStage)(pMe->pStages[uStage].pStageCtx, &Item, &Edit);
+         if(uErr != QCBOR_SUCCESS) {
+            pEncode->uError = (uint8_t)uErr;
+            return;
+         }
+         if(Edit.bDrop) {
+            break;
+         }
+         bSkipMembers = bSkipMembers && Edit.bSkipMembers;
+
+         /* Let the stages after see the changes */
+         if(bInMap && Edit.uNewLabelType == QCBOR_TYPE_TEXT_STRING) {
+            Item.uLabelType   = QCBOR_TYPE_TEXT_STRING;
+            Item.label.string = Edit.NewLabel;
+         } else if(bInMap && Edit.uNewLabelType == QCBOR_TYPE_INT64) {
+            Item.uLabelType  = QCBOR_TYPE_INT64;
+            Item.label.int64 = Edit.nNewLabel;
+         }
+         if(!UsefulBuf_IsNULLC(Edit.NewValue)) {
+            /* Only the type and tag are wanted as this isn't gone into */
+            uint64_t uUnused;
+            size_t   uUnused1;
+            size_t   uUnused2;
+            Item.Value = Edit.NewValue;
+            Transform_DescribeValue(&Item, &uUnused, &uUnused1, &uUnused2);
+         }
+      }
+
+      bDescend = UsefulBuf_IsNULLC(Edit.NewValue) &&
+                 ((uMajorType == CBOR_MAJOR_TYPE_ARRAY && !bSkipMembers) ||
+                  (uMajorType == CBOR_MAJOR_TYPE_MAP && (!bSkipMembers || Edit.bSortMap)));
+
+      if(!Edit.bDrop &&
+         !bDescend &&
+         UsefulBuf_IsNULLC(Edit.NewValue) &&
+         !(bInMap && (Edit.uNewLabelType == QCBOR_TYPE_TEXT_STRING ||
+                      Edit.uNewLabelType == QCBOR_TYPE_INT64))) {
+         /* Unchanged, so becomes part of the run to copy */
+         if(uRunItems == 0) {
+            uRunStart = uMemberStart;
+         }
+         uRunItems += bInMap ? 2 : 1;
+         continue;
+      }
+
+      Transform_CopyRun(pMe, uRunStart, uMemberStart, uRunItems);
+      uRunItems = 0;
+      if(pEncode->uError != QCBOR_SUCCESS) {
+         return;
+      }
+      if(Edit.bDrop) {
+         continue;
+      }
+
+      if(bInMap) {
+         if(Edit.uNewLabelType == QCBOR_TYPE_TEXT_STRING) {
+            QCBOREncode_AddText(pEncode, Edit.NewLabel);
+         } else if(Edit.uNewLabelType == QCBOR_TYPE_INT64) {
+            QCBOREncode_AddInt64(pEncode, Edit.nNewLabel);
+         } else {
+            QCBOREncode_AddEncoded(pEncode,
+                                   UsefulBuf_Head(UsefulBuf_Tail(pMe->Encoded, uMemberStart),
+                                                  uValueStart - uMemberStart));
+         }
+      }
+
+      if(!bDescend) {
+         QCBOREncode_AddEncoded(pEncode, Item.Value);
+      } else {
+         /* The tags are output as they are, then the array or map is
+          * opened as any other so its count is right after drops. */
+         UsefulOutBuf_AppendData(&(pEncode->OutBuf),
+                                 (const uint8_t *)pMe->Encoded.ptr + uValueStart,
+                                 uHeadStart);
+         QCBOREncode_OpenMapOrArray(pEncode, uMajorType);
+         if(pEncode->uError != QCBOR_SUCCESS) {
+            return;
+         }
+
+         UsefulInputBuf_Seek(&(pMe->InBuf), uValueStart + uContentStart);
+         Transform_Members(pMe,
+                           uMajorType == CBOR_MAJOR_TYPE_MAP ? QCBOR_TYPE_MAP : QCBOR_TYPE_ARRAY,
+                           uArgument,
+                           (uint8_t)(uLevel + 1));
+         if(pEncode->uError != QCBOR_SUCCESS) {
+            return;
+         }
+
+         if(uMajorType == CBOR_MAJOR_TYPE_MAP && Edit.bSortMap) {
+            QCBOREncode_CloseAndSortMap(pEncode);
+         } else {
+            QCBOREncode_CloseMapOrArray(pEncode, uMajorType);
+         }
+      }
+      if(pEncode->uError != QCBOR_SUCCESS) {
+         return;
+      }
+   }
+
+   Transform_CopyRun(pMe, uRunStart, UsefulInputBuf_Tell(&(pMe->InBuf)), uRunItems);
+}
+
+
+/*
+ * Public function. See qcbor_transform.h
+ */
+void
+QCBOREncode_AddTransformed(QCBOREncodeContext        *pMe,
+                           UsefulBufC                 Encoded,
+                           const QCBORTransformStage *pStages,
+                           size_t                     uNumStages)
+{
+   TransformWalker Walker;
+   QCBORError      uErr;
+
+   if(pMe->uError != QCBOR_SUCCESS) {
+      return;
+   }
+
+   /* Check all the input first so the walk doesn't have to and so
+    * nothing is output for input that isn't right. */
+   UsefulInputBuf_Init(&Walker.InBuf, Encoded);
+   uErr = ConsumeEncodedItem(&Walker.InBuf);
+   if(uErr == QCBOR_SUCCESS && UsefulInputBuf_BytesUnconsumed(&Walker.InBuf) != 0) {
+      uErr = QCBOR_ERR_EXTRA_BYTES;
+   }
+   if(uErr != QCBOR_SUCCESS) {
+      pMe->uError = (uint8_t)uErr;
+      return;
+   }
+   UsefulInputBuf_Seek(&Walker.InBuf, 0);
+
+   Walker.pEncode    = pMe;
+   Walker.pStages    = pStages;
+   Walker.uNumStages = uNumStages;
+   Walker.Encoded    = Encoded;
+
+   Transform_Members(&Walker, QCBOR_TYPE_NONE, 1, 0);
+}
@@ -0,0 +1,385 @@
+/*==============================================================================
+ qcbor_view.c -- Lazy random-access views of encoded CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor/qcbor_view.h"
+#include "qcbor_decode_private.h"
+
+
+/**
+ * @file qcbor_view.c
+ *
+ * This implements the QCBORView functions. Like Diag, it works on
+ * CBOR heads directly with DecodeHead(). To find an element or member
+ * the items before it are skipped by decoding just their heads and
+ * jumping over string contents.
+ */
+
+
+/* Positions pInBuf after the head of the array or map in the view */
+static QCBORError
+View_Open(const QCBORView *pView,
+          int              nExpectedMajorType,
+          UsefulInputBuf  *pInBuf,
+          uint64_t        *puCount)
+{
+   QCBORError uReturn;
+   int        nMajorType;
+   int        nAdditionalInfo;
+   uint64_t   uArgument;
+
+   UsefulInputBuf_Init(pInBuf, pView->Encoded);
+   UsefulInputBuf_Seek(pInBuf, pView->uOffset);
+
+   do {
+      uReturn = DecodeHead(pInBuf, &nMajorType, &uArgument, &nAdditionalInfo);
+      if(uReturn != QCBOR_SUCCESS) {
+         return uReturn;
+      }
+   } while(nMajorType == CBOR_MAJOR_TYPE_TAG);
+
+   if(nMajorType != nExpectedMajorType) {
+      return QCBOR_ERR_UNEXPECTED_TYPE;
+   }
+
+   *puCount = nAdditionalInfo == LEN_IS_INDEFINITE ? SKIP_INDEFINITE : uArgument;
+   return QCBOR_SUCCESS;
+}
+
+
+static void
+View_CacheAdd(QCBORViewCache  *pCache,
+              const QCBORView *pView,
+              uint32_t         uIndex,
+              size_t           uOffset)
+{
+   QCBORViewCacheEntry *pEntry;
+
+   if(pCache == NULL || pCache->uNumEntries == 0) {
+      return;
+   }
+
+   pEntry = &pCache->pEntries[pCache->uNext];
+   pEntry->uContainer = pView->uOffset;
+   pEntry->uOffset    = uOffset;
+   pEntry->uIndex     = uIndex;
+
+   pCache->uNext = (pCache->uNext + 1) % pCache->uNumEntries;
+   if(pCache->uUsed < pCache->uNumEntries) {
+      pCache->uUsed++;
+   }
+}
+
+
+/* Empties the cache if it is for another buffer. Rewriting a buffer
+ * with a document of the same length needs QCBORView_InitCache(). */
+static void
+View_CacheCheckBuffer(QCBORViewCache *pCache, const QCBORView *pView)
+{
+   if(pCache == NULL) {
+      return;
+   }
+   if(pCache->pBuffer != pView->Encoded.ptr ||
+      pCache->uBufferLen != pView->Encoded.len) {
+      pCache->pBuffer    = pView->Encoded.ptr;
+      pCache->uBufferLen = pView->Encoded.len;
+      pCache->uUsed      = 0;
+      pCache->uNext      = 0;
+   }
+}
+
+
+/*
+ * Public function. See qcbor_view.h
+ */
+QCBORError
+QCBORView_GetItem(const QCBORView *pView, QCBORItem *pItem)
+{
+   QCBORDecodeContext DCtx;
+
+   QCBORDecode_Init(&DCtx,
+                    UsefulBuf_Tail(pView->Encoded, pView->uOffset),
+                    QCBOR_DECODE_MODE_NORMAL);
+   return QCBORDecode_GetNext(&DCtx, pItem);
+}
+
+
+/*
+ * Public function. See qcbor_view.h
+ */
+QCBORError
+QCBORView_GetIndex(const QCBORView *pView,
+                   uint32_t         uIndex,
+                   QCBORViewCache  *pCache,
+                   QCBORView       *pChild)
+{
+   QCBORError           uReturn;
+   UsefulInputBuf       InBuf;
+   uint64_t             uCount;
+   uint32_t             uCurrent;
+   uint32_t             uEntry;
+   QCBORViewCacheEntry *pEntry;
+
+   uReturn = View_Open(pView, CBOR_MAJOR_TYPE_ARRAY, &InBuf, &uCount);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   /* Start from the closest remembered element at or before uIndex */
+   uCurrent = 0;
+   View_CacheCheckBuffer(pCache, pView);
+   if(pCache != NULL) {
+      for(uEntry = 0; uEntry < pCache->uUsed; uEntry++) {
+         pEntry = &pCache->pEntries[uEntry];
+         if(pEntry->uContainer == pView->uOffset &&
+            pEntry->uIndex <= uIndex &&
+            pEntry->uIndex >= uCurrent) {
+            uCurrent = pEntry->uIndex;
+            UsefulInputBuf_Seek(&InBuf, pEntry->uOffset);
+         }
+      }
+      if(uCount != SKIP_INDEFINITE) {
+         uCount -= uCurrent;
+      }
+   }
+
+   for(;;) {
+      if(QCBORDecode_Private_AtEnd(&InBuf, &uCount)) {
+         uReturn = QCBOR_ERR_NO_MORE_ITEMS;
+         goto Done;
+      }
+      if(uCurrent == uIndex) {
+         break;
+      }
+      uReturn = QCBORDecode_Private_SkipItem(&InBuf);
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+      uCurrent++;
+   }
+
+   pChild->Encoded = pView->Encoded;
+   pChild->uOffset = UsefulInputBuf_Tell(&InBuf);
+   View_CacheAdd(pCache, pView, uIndex, pChild->uOffset);
+
+Done:
+   return uReturn;
+}
+
+
+/* The label to look for. Only one of the two is used. */
+typedef struct {
+   int64_t    nLabel;
+   UsefulBufC Label;
+   bool       bText;
+} ViewLabel;
+
+
+/* Checks the label at the current position. pInBuf is left after the
+ * label only if it matches. */
+static bool
+View_LabelMatches(UsefulInputBuf *pInBuf, const ViewLabel *pLabel)
+{
+   const size_t uStart = UsefulInputBuf_Tell(pInBuf);
+   int          nMajorType;
+   int          nAdditionalInfo;
+   uint64_t     uArgument;
+   bool         bMatch;
+
+   bMatch = false;
+   if(DecodeHead(pInBuf, &nMajorType, &uArgument, &nAdditionalInfo) == QCBOR_SUCCESS &&
+      nAdditionalInfo != LEN_IS_INDEFINITE) {
+      if(pLabel->bText) {
+         bMatch = nMajorType == CBOR_MAJOR_TYPE_TEXT_STRING &&
+                  uArgument == pLabel->Label.len &&
+                  UsefulBuf_Compare(UsefulInputBuf_GetUsefulBuf(pInBuf, pLabel->Label.len),
+                                    pLabel->Label) == 0;
+      } else if(nMajorType == CBOR_MAJOR_TYPE_POSITIVE_INT) {
+         bMatch = pLabel->nLabel >= 0 && uArgument == (uint64_t)pLabel->nLabel;
+      } else if(nMajorType == CBOR_MAJOR_TYPE_NEGATIVE_INT) {
+         /* -1 - uArgument == nLabel computed without overflow */
+         bMatch = pLabel->nLabel < 0 && uArgument == (uint64_t)(-1 - pLabel->nLabel);
+      }
+   }
+
+   if(!bMatch) {
+      UsefulInputBuf_Seek(pInBuf, uStart);
+   }
+   return bMatch;
+}
+
+
+static QCBORError
+View_GetInMap(const QCBORView *pView,
+              const ViewLabel *pLabel,
+              QCBORViewCache  *pCache,
+              QCBORView       *pChild)
+{
+   QCBORError     uReturn;
+   UsefulInputBuf InBuf;
+   uint64_t       uCount;
+   uint32_t       uEntry;
+   uint32_t       uMember;
+   size_t         uLabelOffset;
+
+   uReturn = View_Open(pView, CBOR_MAJOR_TYPE_MAP, &InBuf, &uCount);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+
+   /* Try the remembered members of this map first */
+   View_CacheCheckBuffer(pCache, pView);
+   if(pCache != NULL) {
+      for(uEntry = 0; uEntry < pCache->uUsed; uEntry++) {
+         if(pCache->pEntries[uEntry].uContainer != pView->uOffset) {
+            continue;
+         }
+         uLabelOffset = UsefulInputBuf_Tell(&InBuf);
+         UsefulInputBuf_Seek(&InBuf, pCache->pEntries[uEntry].uOffset);
+         if(View_LabelMatches(&InBuf, pLabel)) {
+            goto Found;
+         }
+         UsefulInputBuf_Seek(&InBuf, uLabelOffset);
+      }
+   }
+
+   for(uMember = 0; ; uMember++) {
+      if(QCBORDecode_Private_AtEnd(&InBuf, &uCount)) {
+         uReturn = QCBOR_ERR_LABEL_NOT_FOUND;
+         goto Done;
+      }
+      uLabelOffset = UsefulInputBuf_Tell(&InBuf);
+      if(View_LabelMatches(&InBuf, pLabel)) {
+         View_CacheAdd(pCache, pView, uMember, uLabelOffset);
+         goto Found;
+      }
+      uReturn = QCBORDecode_Private_SkipItem(&InBuf);
+      if(uReturn == QCBOR_SUCCESS) {
+         uReturn = QCBORDecode_Private_SkipItem(&InBuf);
+      }
+      if(uReturn != QCBOR_SUCCESS) {
+         goto Done;
+      }
+   }
+
+Found:
+   if(UsefulInputBuf_BytesUnconsumed(&InBuf) == 0) {
+      uReturn = QCBOR_ERR_HIT_END;
+      goto Done;
+   }
+   pChild->Encoded = pView->Encoded;
+   pChild->uOffset = UsefulInputBuf_Tell(&InBuf);
+
+Done:
+   return uReturn;
+}
+
+
+/*
+ * Public function. See qcbor_view.h
+ */
+QCBORError
+QCBORView_GetInMapN(const QCBORView *pView,
+                    int64_t          nLabel,
+                    QCBORViewCache  *pCache,
+                    QCBORView       *pChild)
+{
+   ViewLabel Label;
+
+   Label.nLabel = nLabel;
+   Label.Label  = NULLUsefulBufC;
+   Label.bText  = false;
+
+   return View_GetInMap(pView, &Label, pCache, pChild);
+}
+
+
+/*
+ * Public function. See qcbor_view.h
+ */
+QCBORError
+QCBORView_GetInMapSZ(const QCBORView *pView,
+                     const char      *szLabel,
+                     QCBORViewCache  *pCache,
+                     QCBORView       *pChild)
+{
+   ViewLabel Label;
+
+   Label.nLabel = 0;
+   Label.Label  = UsefulBuf_FromSZ(szLabel);
+   Label.bText  = true;
+
+   return View_GetInMap(pView, &Label, pCache, pChild);
+}
+
+
+/*
+ * Public function. See qcbor_view.h
+ */
+QCBORError
+QCBORView_Replace(const QCBORView *pView,
+                  UsefulBuf        Buffer,
+                  UsefulBufC       NewItem,
+                  size_t          *puNewLen)
+{
+   QCBORError     uReturn;
+   UsefulInputBuf InBuf;
+   size_t         uOldEnd;
+   size_t         uNewEnd;
+   size_t         uNewLen;
+
+   if(pView->Encoded.ptr != Buffer.ptr) {
+      uReturn = QCBOR_ERR_UNSUPPORTED;
+      goto Done;
+   }
+   if(pView->Encoded.len > Buffer.len) {
+      uReturn = QCBOR_ERR_BUFFER_TOO_SMALL;
+      goto Done;
+   }
+
+   /* The new item must be exactly one item */
+   UsefulInputBuf_Init(&InBuf, NewItem);
+   uReturn = QCBORDecode_Private_SkipItem(&InBuf);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   if(UsefulInputBuf_BytesUnconsumed(&InBuf) != 0) {
+      uReturn = QCBOR_ERR_EXTRA_BYTES;
+      goto Done;
+   }
+
+   /* Where the old item ends */
+   UsefulInputBuf_Init(&InBuf, pView->Encoded);
+   UsefulInputBuf_Seek(&InBuf, pView->uOffset);
+   uReturn = QCBORDecode_Private_SkipItem(&InBuf);
+   if(uReturn != QCBOR_SUCCESS) {
+      goto Done;
+   }
+   uOldEnd = UsefulInputBuf_Tell(&InBuf);
+
+   uNewEnd = pView->uOffset + NewItem.len;
+   uNewLen = pView->Encoded.len - uOldEnd + uNewEnd;
+   if(uNewLen > Buffer.len) {
+      uReturn = QCBOR_ERR_BUFFER_TOO_SMALL;
+      goto Done;
+   }
+
+   if(uNewEnd != uOldEnd) {
+      memmove((uint8_t *)Buffer.ptr + uNewEnd,
+              (uint8_t *)Buffer.ptr + uOldEnd,
+              pView->Encoded.len - uOldEnd);
+   }
+   memcpy((uint8_t *)Buffer.ptr + pView->uOffset, NewItem.ptr, NewItem.len);
+
+   *puNewLen = uNewLen;
+
+Done:
+   return uReturn;
+}
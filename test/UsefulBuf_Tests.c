@@ -867,3 +867,51 @@ const char *UBAdvanceTest(void)
 
    return NULL;
 }
+
+
+const char *UOBTest_Swap(void)
+{
+   UsefulOutBuf_MakeOnStack(UOB, 20);
+
+   UsefulOutBuf_AppendString(&UOB, "abcdefghij");
+
+   /* Unequal sized regions in the middle */
+   UsefulOutBuf_Swap(&UOB, 1, 3, 8);
+   if(UsefulBuf_Compare(UsefulOutBuf_OutUBuf(&UOB),
+                        UsefulBuf_FROM_SZ_LITERAL("adefghbcij"))) {
+      return "Swap of unequal regions failed";
+   }
+
+   /* Whole buffer, swapping back */
+   UsefulOutBuf_Swap(&UOB, 1, 6, 8);
+   if(UsefulBuf_Compare(UsefulOutBuf_OutUBuf(&UOB),
+                        UsefulBuf_FROM_SZ_LITERAL("abcdefghij"))) {
+      return "Swap back failed";
+   }
+
+   /* Empty regions do nothing */
+   UsefulOutBuf_Swap(&UOB, 0, 0, 10);
+   UsefulOutBuf_Swap(&UOB, 10, 10, 10);
+   if(UsefulBuf_Compare(UsefulOutBuf_OutUBuf(&UOB),
+                        UsefulBuf_FROM_SZ_LITERAL("abcdefghij"))) {
+      return "Swap of empty region changed data";
+   }
+
+   /* Past the end of the valid data */
+   UsefulOutBuf_Swap(&UOB, 2, 4, 11);
+   if(!UsefulOutBuf_GetError(&UOB)) {
+      return "Swap off end didn't set error";
+   }
+
+   /* Size calculation mode */
+   UsefulOutBuf SizeUOB;
+   UsefulOutBuf_Init(&SizeUOB, (UsefulBuf){NULL, 100});
+   UsefulOutBuf_AppendString(&SizeUOB, "abcdefghij");
+   UsefulOutBuf_Swap(&SizeUOB, 0, 5, 10);
+   if(UsefulOutBuf_GetError(&SizeUOB) ||
+      UsefulOutBuf_GetEndPosition(&SizeUOB) != 10) {
+      return "Swap in size calculation mode failed";
+   }
+
+   return NULL;
+}
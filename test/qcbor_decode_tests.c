@@ -7983,3 +7983,1435 @@ int32_t BoolTest(void)
 
    return 0;
 }
+
+
+#ifndef QCBOR_DISABLE_TAGS
+/* {1: 100000(h'01'), 2: [200000("x"), 4], "s": "abc"}. The tag
+ * numbers are large enough to need mapping. */
+static const uint8_t spPreparedInput[] = {
+   0xa3, 0x01, 0xda, 0x00, 0x01, 0x86, 0xa0, 0x41, 0x01, 0x02, 0x82,
+   0xda, 0x00, 0x03, 0x0d, 0x40, 0x61, 0x78, 0x04, 0x61, 0x73, 0x63,
+   0x61, 0x62, 0x63};
+#else /* QCBOR_DISABLE_TAGS */
+/* {1: h'01', 2: ["x", 4], "s": "abc"} */
+static const uint8_t spPreparedInput[] = {
+   0xa3, 0x01, 0x41, 0x01, 0x02, 0x82, 0x61, 0x78, 0x04, 0x61, 0x73,
+   0x63, 0x61, 0x62, 0x63};
+#endif /* QCBOR_DISABLE_TAGS */
+
+
+int32_t PreparedDecodeTest(void)
+{
+   QCBORDecodePrepared Prepared;
+   QCBORDecodePrepared PreparedCopy;
+   QCBORDecodeContext  DCtx1;
+   QCBORDecodeContext  DCtx2;
+   QCBORItem           Item;
+   UsefulBufC          String;
+   QCBORError          uErr;
+
+   uErr = QCBORDecode_Prepare(&Prepared,
+                              UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spPreparedInput),
+                              QCBOR_DECODE_MODE_NORMAL);
+   if(uErr != QCBOR_SUCCESS) {
+      return 1;
+   }
+   memcpy(&PreparedCopy, &Prepared, sizeof(Prepared));
+
+   /* Two decoders from the same prepared document interleaved */
+   QCBORDecode_InitFromPrepared(&DCtx1, &Prepared);
+   QCBORDecode_InitFromPrepared(&DCtx2, &Prepared);
+
+   if(QCBORDecode_GetNext(&DCtx1, &Item) != QCBOR_SUCCESS ||
+      Item.uDataType != QCBOR_TYPE_MAP) {
+      return 10;
+   }
+   QCBORDecode_EnterMap(&DCtx2, NULL);
+   QCBORDecode_GetTextStringInMapSZ(&DCtx2, "s", &String);
+   if(QCBORDecode_GetError(&DCtx2) != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(String, UsefulBuf_FROM_SZ_LITERAL("abc"))) {
+      return 11;
+   }
+
+   if(QCBORDecode_GetNext(&DCtx1, &Item) != QCBOR_SUCCESS ||
+      Item.uDataType != QCBOR_TYPE_BYTE_STRING) {
+      return 12;
+   }
+#ifndef QCBOR_DISABLE_TAGS
+   if(QCBORDecode_GetNthTag(&DCtx1, &Item, 0) != 100000) {
+      return 13;
+   }
+#endif /* QCBOR_DISABLE_TAGS */
+
+   QCBORDecode_EnterArrayFromMapN(&DCtx2, 2);
+   QCBORDecode_GetNext(&DCtx2, &Item);
+   if(QCBORDecode_GetError(&DCtx2) != QCBOR_SUCCESS ||
+      Item.uDataType != QCBOR_TYPE_TEXT_STRING) {
+      return 14;
+   }
+#ifndef QCBOR_DISABLE_TAGS
+   if(QCBORDecode_GetNthTag(&DCtx2, &Item, 0) != 200000) {
+      return 15;
+   }
+#endif /* QCBOR_DISABLE_TAGS */
+   QCBORDecode_ExitArray(&DCtx2);
+   QCBORDecode_ExitMap(&DCtx2);
+   if(QCBORDecode_Finish(&DCtx2) != QCBOR_SUCCESS) {
+      return 16;
+   }
+
+   if(QCBORDecode_GetNext(&DCtx1, &Item) != QCBOR_SUCCESS ||
+      Item.uDataType != QCBOR_TYPE_ARRAY) {
+      return 17;
+   }
+   QCBORDecode_InitFromPrepared(&DCtx2, &Prepared);
+   QCBORDecode_VGetNextConsume(&DCtx2, &Item);
+   if(QCBORDecode_Finish(&DCtx2) != QCBOR_SUCCESS) {
+      return 18;
+   }
+   if(QCBORDecode_GetNext(&DCtx1, &Item) != QCBOR_SUCCESS ||
+      Item.uDataType != QCBOR_TYPE_TEXT_STRING) {
+      return 19;
+   }
+
+   /* The prepared document isn't changed by decoding */
+   if(memcmp(&Prepared, &PreparedCopy, sizeof(Prepared))) {
+      return 20;
+   }
+
+   /* Not well-formed input puts decoders in the error state */
+   static const uint8_t spNotWellFormed[] = {0x82, 0x01, 0x1c};
+   uErr = QCBORDecode_Prepare(&Prepared,
+                              UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNotWellFormed),
+                              QCBOR_DECODE_MODE_NORMAL);
+   if(uErr != QCBOR_ERR_UNSUPPORTED) {
+      return 30;
+   }
+   QCBORDecode_InitFromPrepared(&DCtx1, &Prepared);
+   QCBORDecode_EnterArray(&DCtx1, NULL);
+   if(QCBORDecode_GetError(&DCtx1) != QCBOR_ERR_UNSUPPORTED) {
+      return 31;
+   }
+
+   return 0;
+}
+
+
+static bool
+PeekCacheSameItem(const QCBORItem *pItem1, const QCBORItem *pItem2)
+{
+   return pItem1->uDataType      == pItem2->uDataType &&
+          pItem1->uLabelType     == pItem2->uLabelType &&
+          pItem1->uNestingLevel  == pItem2->uNestingLevel &&
+          pItem1->uNextNestLevel == pItem2->uNextNestLevel &&
+          pItem1->val.uint64     == pItem2->val.uint64 &&
+          pItem1->val.string.len == pItem2->val.string.len &&
+          pItem1->label.string.ptr == pItem2->label.string.ptr;
+}
+
+
+int32_t PeekCacheTest(void)
+{
+   QCBORDecodeContext DCtx;
+   QCBORPeekCache     Cache;
+   QCBORItem          aExpected[12];
+   QCBORItem          Item;
+   QCBORItem          Peeked;
+   QCBORError         uErr;
+   int                nNumItems;
+   int                nIndex;
+   int64_t            nInt;
+   uint8_t            auWritable[sizeof(pValidMapEncoded)];
+
+   /* What plain GetNext() gives */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(pValidMapEncoded), 0);
+   for(nNumItems = 0; nNumItems < 12; nNumItems++) {
+      uErr = QCBORDecode_GetNext(&DCtx, &aExpected[nNumItems]);
+      if(uErr == QCBOR_ERR_NO_MORE_ITEMS) {
+         break;
+      }
+      if(uErr != QCBOR_SUCCESS) {
+         return 1;
+      }
+   }
+   if(nNumItems != 10) {
+      return 2;
+   }
+
+   /* Peeking twice and getting each item gives the same */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(pValidMapEncoded), 0);
+   QCBORDecode_SetPeekCache(&DCtx, &Cache);
+   for(nIndex = 0; nIndex < nNumItems; nIndex++) {
+      if(QCBORDecode_PeekNext(&DCtx, &Peeked) != QCBOR_SUCCESS ||
+         !PeekCacheSameItem(&Peeked, &aExpected[nIndex])) {
+         return 10 + nIndex;
+      }
+      QCBORDecode_VPeekNext(&DCtx, &Peeked);
+      if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS ||
+         !PeekCacheSameItem(&Peeked, &aExpected[nIndex])) {
+         return 30 + nIndex;
+      }
+      if(QCBORDecode_GetNext(&DCtx, &Item) != QCBOR_SUCCESS ||
+         !PeekCacheSameItem(&Item, &aExpected[nIndex])) {
+         return 50 + nIndex;
+      }
+   }
+   if(QCBORDecode_PeekNext(&DCtx, &Peeked) != QCBOR_ERR_NO_MORE_ITEMS) {
+      return 70;
+   }
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS) {
+      return 71;
+   }
+
+   /* Peeking before entering and searching */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(pValidMapEncoded), 0);
+   QCBORDecode_SetPeekCache(&DCtx, &Cache);
+   QCBORDecode_VPeekNext(&DCtx, &Peeked);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_VPeekNext(&DCtx, &Peeked);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_GetInt64InMapSZ(&DCtx, "first integer", &nInt);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS ||
+      nInt != 42 ||
+      !PeekCacheSameItem(&Item, &aExpected[1])) {
+      return 80;
+   }
+   QCBORDecode_EnterMapFromMapSZ(&DCtx, "map in a map");
+   QCBORDecode_VPeekNext(&DCtx, &Peeked);
+   QCBORDecode_GetInt64InMapSZ(&DCtx, "another int", &nInt);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS ||
+      nInt != 98 ||
+      Peeked.uDataType != QCBOR_TYPE_BYTE_STRING) {
+      return 81;
+   }
+   QCBORDecode_ExitMap(&DCtx);
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS) {
+      return 82;
+   }
+
+   /* The item gotten after a peek really is the cached one. Change the
+    * input after peeking to see this. */
+   memcpy(auWritable, pValidMapEncoded, sizeof(auWritable));
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(auWritable), 0);
+   QCBORDecode_SetPeekCache(&DCtx, &Cache);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_VPeekNext(&DCtx, &Peeked);
+   auWritable[16] = 0x2b; /* 42 becomes 43 */
+   QCBORDecode_GetNext(&DCtx, &Item);
+   if(Item.uDataType != QCBOR_TYPE_INT64 || Item.val.int64 != 42) {
+      return 90;
+   }
+   QCBORDecode_Rewind(&DCtx);
+   QCBORDecode_GetNext(&DCtx, &Item);
+   if(Item.uDataType != QCBOR_TYPE_INT64 || Item.val.int64 != 43) {
+      return 91;
+   }
+
+   /* Not using the cache any more */
+   QCBORDecode_Rewind(&DCtx);
+   QCBORDecode_SetPeekCache(&DCtx, NULL);
+   QCBORDecode_VPeekNext(&DCtx, &Peeked);
+   auWritable[16] = 0x2a;
+   QCBORDecode_GetNext(&DCtx, &Item);
+   if(Item.uDataType != QCBOR_TYPE_INT64 || Item.val.int64 != 42) {
+      return 92;
+   }
+
+   return 0;
+}
+
+
+int32_t ExitWithoutRescanTest(void)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   QCBORError         uErr;
+   int64_t            nInt;
+   uint8_t            auWritable[sizeof(pValidMapEncoded)];
+
+   /* The input is changed so it is not well-formed after the end of
+    * the map is known. Exiting succeeds because it doesn't decode the
+    * map again to find its end. */
+
+   /* End found by getting all the items */
+   memcpy(auWritable, pValidMapEncoded, sizeof(auWritable));
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(auWritable), 0);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   do {
+      uErr = QCBORDecode_GetNext(&DCtx, &Item);
+   } while(uErr == QCBOR_SUCCESS);
+   if(uErr != QCBOR_ERR_NO_MORE_ITEMS) {
+      return 1;
+   }
+   auWritable[15] = 0x1c; /* Reserved additional info */
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS) {
+      return 2;
+   }
+
+   /* Ends found by map searches, in nested maps */
+   memcpy(auWritable, pValidMapEncoded, sizeof(auWritable));
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(auWritable), 0);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_EnterMapFromMapSZ(&DCtx, "map in a map");
+   QCBORDecode_GetInt64InMapSZ(&DCtx, "another int", &nInt);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS || nInt != 98) {
+      return 10;
+   }
+   auWritable[15] = 0x1c;
+   auWritable[80] = 0x5c;
+   QCBORDecode_ExitMap(&DCtx);
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS) {
+      return 11;
+   }
+
+   /* With the end not known, exiting finds the damage */
+   memcpy(auWritable, pValidMapEncoded, sizeof(auWritable));
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(auWritable), 0);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   auWritable[80] = 0x5c;
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) == QCBOR_SUCCESS) {
+      return 20;
+   }
+
+   return 0;
+}
+
+
+static const struct {
+   const char *szDate;
+   int64_t     nSeconds;
+   uint32_t    uNanoseconds;
+   int16_t     nOffsetMinutes;
+} DateStringEpochCases[] = {
+   {"1970-01-01T00:00:00Z",              0,            0,         0},
+   {"1985-04-12T23:20:50.52Z",           482196050,    520000000, 0},
+   {"1996-12-19T16:39:57-08:00",         851042397,    0,         -480},
+   {"1937-01-01T12:00:27.87+00:20",      -1041337173,  870000000, 20},
+   {"1990-12-31T23:59:60Z",              662688000,    0,         0},
+   {"2000-02-29t12:00:00z",              951825600,    0,         0},
+   {"0000-01-01T00:00:00Z",              -62167219200, 0,         0},
+   {"9999-12-31T23:59:59.123456789Z",    253402300799, 123456789, 0},
+   {"2024-06-30T10:00:00.0000000019-00:00", 1719741600, 1,        0},
+};
+
+static const char *aszBadDateStrings[] = {
+   "2001-02-29T00:00:00Z",
+   "1900-02-29T00:00:00Z",
+   "1985-13-12T23:20:50Z",
+   "1985-04-31T23:20:50Z",
+   "1985-04-12T24:20:50Z",
+   "1985-04-12T23:20:61Z",
+   "1985-04-12T23:20:50.Z",
+   "1985-04-12 23:20:50Z",
+   "1985-04-12T23:20:50",
+   "1985-04-12T23:20:50+0800",
+   "1985-04-12T23:20:50+24:00",
+   "1985-04-12T23:20:50Zx",
+   "1985-04-1xT23:20:50Z",
+   "85-04-12T23:20:50Z",
+};
+
+
+int32_t DateStringEpochTest(void)
+{
+   QCBOREncodeContext ECtx;
+   QCBORDecodeContext DCtx;
+   UsefulBufC         Encoded;
+   UsefulBufC         String;
+   int64_t            nSeconds;
+   uint32_t           uNanoseconds;
+   int16_t            nOffset;
+   size_t             uIndex;
+   UsefulBuf_MAKE_STACK_UB(Buffer, 600);
+
+   /* Parse the strings */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenArray(&ECtx);
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(DateStringEpochCases, DateStringEpochCases[0]); uIndex++) {
+      QCBOREncode_AddDateString(&ECtx, DateStringEpochCases[uIndex].szDate);
+   }
+   QCBOREncode_CloseArray(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 1;
+   }
+
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(DateStringEpochCases, DateStringEpochCases[0]); uIndex++) {
+      QCBORDecode_GetDateStringAsEpoch(&DCtx,
+                                       QCBOR_TAG_REQUIREMENT_TAG,
+                                       &nSeconds,
+                                       &uNanoseconds,
+                                       &nOffset);
+      if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS ||
+         nSeconds != DateStringEpochCases[uIndex].nSeconds ||
+         uNanoseconds != DateStringEpochCases[uIndex].uNanoseconds ||
+         nOffset != DateStringEpochCases[uIndex].nOffsetMinutes) {
+         return 10 + (int32_t)uIndex;
+      }
+   }
+   QCBORDecode_ExitArray(&DCtx);
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 2;
+   }
+
+   /* Bad strings are a recoverable error */
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(aszBadDateStrings, aszBadDateStrings[0]); uIndex++) {
+      QCBOREncode_Init(&ECtx, Buffer);
+      QCBOREncode_OpenArray(&ECtx);
+      QCBOREncode_AddTDateString(&ECtx, QCBOR_ENCODE_AS_BORROWED, aszBadDateStrings[uIndex]);
+      QCBOREncode_AddInt64(&ECtx, 7);
+      QCBOREncode_CloseArray(&ECtx);
+      if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+         return 3;
+      }
+
+      QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_EnterArray(&DCtx, NULL);
+      QCBORDecode_GetDateStringAsEpoch(&DCtx,
+                                       QCBOR_TAG_REQUIREMENT_NOT_A_TAG,
+                                       &nSeconds,
+                                       NULL,
+                                       NULL);
+      if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT) {
+         return 30 + (int32_t)uIndex;
+      }
+      QCBORDecode_GetInt64(&DCtx, &nSeconds);
+      QCBORDecode_ExitArray(&DCtx);
+      if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS || nSeconds != 7) {
+         return 50 + (int32_t)uIndex;
+      }
+   }
+
+   /* Format them and parse them back */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddTDateStringFromEpochToMapN(&ECtx, 1, QCBOR_ENCODE_AS_TAG, 0, 0, 0);
+   QCBOREncode_AddTDateStringFromEpochToMapN(&ECtx, 2, QCBOR_ENCODE_AS_TAG, 482196050, 520000000, 0);
+   QCBOREncode_AddTDateStringFromEpochToMapN(&ECtx, 3, QCBOR_ENCODE_AS_TAG, 851042397, 0, -480);
+   QCBOREncode_AddTDateStringFromEpochToMapN(&ECtx, 4, QCBOR_ENCODE_AS_TAG, -1041337173, 870000, 20);
+   QCBOREncode_AddTDateStringFromEpochToMapSZ(&ECtx, "min", QCBOR_ENCODE_AS_BORROWED, -62167219200, 0, 0);
+   QCBOREncode_AddTDateStringFromEpochToMapSZ(&ECtx, "max", QCBOR_ENCODE_AS_BORROWED, 253402300799, 1, 0);
+   QCBOREncode_AddTDateStringFromEpochToMapSZ(&ECtx, "leap", QCBOR_ENCODE_AS_BORROWED, 951825600 - 43200, 0, 0);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 4;
+   }
+
+   static const char *aszExpected[] = {
+      "1970-01-01T00:00:00Z",
+      "1985-04-12T23:20:50.520Z",
+      "1996-12-19T16:39:57-08:00",
+      "1937-01-01T12:00:27.000870+00:20",
+   };
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(aszExpected, aszExpected[0]); uIndex++) {
+      QCBORDecode_GetDateStringInMapN(&DCtx, (int64_t)uIndex + 1, QCBOR_TAG_REQUIREMENT_TAG, &String);
+      if(UsefulBuf_Compare(String, UsefulBuf_FromSZ(aszExpected[uIndex]))) {
+         return 60 + (int32_t)uIndex;
+      }
+   }
+   QCBORDecode_GetDateStringInMapSZ(&DCtx, "min", QCBOR_TAG_REQUIREMENT_NOT_A_TAG, &String);
+   if(UsefulBuf_Compare(String, UsefulBuf_FROM_SZ_LITERAL("0000-01-01T00:00:00Z"))) {
+      return 70;
+   }
+   QCBORDecode_GetDateStringInMapSZ(&DCtx, "leap", QCBOR_TAG_REQUIREMENT_NOT_A_TAG, &String);
+   if(UsefulBuf_Compare(String, UsefulBuf_FROM_SZ_LITERAL("2000-02-29T00:00:00Z"))) {
+      return 71;
+   }
+   QCBORDecode_GetDateStringAsEpochInMapN(&DCtx, 4, QCBOR_TAG_REQUIREMENT_TAG, &nSeconds, &uNanoseconds, &nOffset);
+   if(nSeconds != -1041337173 || uNanoseconds != 870000 || nOffset != 20) {
+      return 72;
+   }
+   QCBORDecode_GetDateStringAsEpochInMapSZ(&DCtx, "max", QCBOR_TAG_REQUIREMENT_NOT_A_TAG, &nSeconds, &uNanoseconds, &nOffset);
+   if(nSeconds != 253402300799 || uNanoseconds != 1 || nOffset != 0) {
+      return 73;
+   }
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 74;
+   }
+
+   /* Out of range */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddTDateStringFromEpoch(&ECtx, QCBOR_ENCODE_AS_TAG, 253402300800, 0, 0);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_ERR_DATE_OVERFLOW) {
+      return 80;
+   }
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddTDateStringFromEpoch(&ECtx, QCBOR_ENCODE_AS_TAG, 0, 0, -1440);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_ERR_DATE_OVERFLOW) {
+      return 81;
+   }
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddTDateStringFromEpoch(&ECtx, QCBOR_ENCODE_AS_TAG, INT64_MIN, 0, 0);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_ERR_DATE_OVERFLOW) {
+      return 82;
+   }
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddTDateStringFromEpoch(&ECtx, QCBOR_ENCODE_AS_TAG, 0, 1000000000, 0);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_ERR_DATE_OVERFLOW) {
+      return 83;
+   }
+
+   return 0;
+}
+
+
+/* The test vectors from RFC 4648 section 10 */
+static const struct {
+   const char *szBytes;
+   const char *szB64;
+   const char *szB64URL;
+} B64Vectors[] = {
+   {"",       "",         ""},
+   {"f",      "Zg==",     "Zg"},
+   {"fo",     "Zm8=",     "Zm8"},
+   {"foo",    "Zm9v",     "Zm9v"},
+   {"foob",   "Zm9vYg==", "Zm9vYg"},
+   {"fooba",  "Zm9vYmE=", "Zm9vYmE"},
+   {"foobar", "Zm9vYmFy", "Zm9vYmFy"},
+};
+
+static const struct {
+   const char *szText;
+   bool        bURL;
+} B64Bad[] = {
+   {"Z",         false},
+   {"Zg=",       false},
+   {"Zg===",     false},
+   {"Zh==",      false},
+   {"Zm9=",      false},
+   {"Zm 9v",     false},
+   {"Zm9vYmFy=", false},
+   {"Zg==Zg==",  false},
+   {"ab-_",      false},
+   {"ab+/",      true},
+   {"Zm9vYmFyZh", true},
+   {"Zm9vYmFyZm9", true},
+};
+
+
+int32_t Base64Test(void)
+{
+   QCBOREncodeContext ECtx;
+   QCBORDecodeContext DCtx;
+   UsefulBufC         Encoded;
+   UsefulBufC         Text;
+   UsefulBufC         Bytes;
+   size_t             uIndex;
+   size_t             uLen;
+   uint8_t            auBytes[200];
+   uint8_t            auText[300];
+   UsefulBuf_MAKE_STACK_UB(Buffer, 700);
+   UsefulBuf_MAKE_STACK_UB(Out, 200);
+
+   /* RFC 4648 vectors with the standalone encoder and decoder */
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(B64Vectors, B64Vectors[0]); uIndex++) {
+      const UsefulBufC In = UsefulBuf_FromSZ(B64Vectors[uIndex].szBytes);
+
+      Text = QCBOREncode_EncodeB64((UsefulBuf){auText, sizeof(auText)}, In, false);
+      if(UsefulBuf_Compare(Text, UsefulBuf_FromSZ(B64Vectors[uIndex].szB64))) {
+         return 10 + (int32_t)uIndex;
+      }
+      Text = QCBOREncode_EncodeB64((UsefulBuf){auText, sizeof(auText)}, In, true);
+      if(UsefulBuf_Compare(Text, UsefulBuf_FromSZ(B64Vectors[uIndex].szB64URL))) {
+         return 20 + (int32_t)uIndex;
+      }
+      if(QCBORDecode_DecodeB64(UsefulBuf_FromSZ(B64Vectors[uIndex].szB64), false, Out, &Bytes) ||
+         UsefulBuf_Compare(Bytes, In)) {
+         return 30 + (int32_t)uIndex;
+      }
+      /* Padding is allowed for base64url too */
+      if(QCBORDecode_DecodeB64(UsefulBuf_FromSZ(B64Vectors[uIndex].szB64), true, Out, &Bytes) ||
+         UsefulBuf_Compare(Bytes, In)) {
+         return 40 + (int32_t)uIndex;
+      }
+      if(QCBORDecode_DecodeB64(UsefulBuf_FromSZ(B64Vectors[uIndex].szB64URL), true, Out, &Bytes) ||
+         UsefulBuf_Compare(Bytes, In)) {
+         return 50 + (int32_t)uIndex;
+      }
+   }
+
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(B64Bad, B64Bad[0]); uIndex++) {
+      if(QCBORDecode_DecodeB64(UsefulBuf_FromSZ(B64Bad[uIndex].szText),
+                               B64Bad[uIndex].bURL,
+                               Out,
+                               &Bytes) != QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT) {
+         return 60 + (int32_t)uIndex;
+      }
+   }
+
+   /* Lengths either side of the six and eight at a time loops */
+   for(uIndex = 0; uIndex < sizeof(auBytes); uIndex++) {
+      auBytes[uIndex] = (uint8_t)(uIndex * 37 + 11);
+   }
+   for(uLen = 0; uLen < 30; uLen++) {
+      const UsefulBufC In = {auBytes + 100, uLen};
+
+      Text = QCBOREncode_EncodeB64((UsefulBuf){NULL, 0}, In, uLen % 2);
+      if(Text.ptr != NULL || Text.len != (uLen % 2 ? (uLen * 4 + 2) / 3 : (uLen + 2) / 3 * 4)) {
+         return 80;
+      }
+      Text = QCBOREncode_EncodeB64((UsefulBuf){auText, sizeof(auText)}, In, uLen % 2);
+      if(QCBORDecode_DecodeB64(Text, uLen % 2, Out, &Bytes) ||
+         UsefulBuf_Compare(Bytes, In)) {
+         return 81;
+      }
+      if(uLen > 0 &&
+         QCBORDecode_DecodeB64(Text, uLen % 2, (UsefulBuf){Out.ptr, uLen - 1}, &Bytes) !=
+            QCBOR_ERR_BUFFER_TOO_SMALL) {
+         return 82;
+      }
+   }
+   if(!UsefulBuf_IsNULLC(QCBOREncode_EncodeB64((UsefulBuf){auText, 7}, UsefulBuf_FROM_SZ_LITERAL("foobar"), false))) {
+      return 83;
+   }
+
+   /* Add and get */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddTB64TextFromBytesToMapN(&ECtx, 1, QCBOR_ENCODE_AS_TAG, (UsefulBufC){auBytes, sizeof(auBytes)});
+   QCBOREncode_AddTB64URLTextFromBytesToMapN(&ECtx, 2, QCBOR_ENCODE_AS_TAG, (UsefulBufC){auBytes, 100});
+   QCBOREncode_AddTB64TextFromBytesToMapSZ(&ECtx, "a", QCBOR_ENCODE_AS_BORROWED, UsefulBuf_FROM_SZ_LITERAL("fo"));
+   QCBOREncode_AddTB64URLTextFromBytesToMapSZ(&ECtx, "b", QCBOR_ENCODE_AS_BORROWED, UsefulBuf_FROM_SZ_LITERAL("fo"));
+   QCBOREncode_AddTB64Text(&ECtx, QCBOR_ENCODE_AS_TAG, UsefulBuf_FROM_SZ_LITERAL("c"));
+   QCBOREncode_AddTB64Text(&ECtx, QCBOR_ENCODE_AS_TAG, UsefulBuf_FROM_SZ_LITERAL("Zm9=")); /* Bad */
+   QCBOREncode_AddInt64(&ECtx, 3);
+   QCBOREncode_AddInt64(&ECtx, 4);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 90;
+   }
+
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+#ifndef QCBOR_DISABLE_UNCOMMON_TAGS
+   QCBORDecode_GetB64InMapN(&DCtx, 1, QCBOR_TAG_REQUIREMENT_TAG, &Text);
+   if(Text.len != 268 || memcmp(Text.ptr, "CzBVep/E6Q4zWH", 14)) {
+      return 91;
+   }
+   QCBORDecode_GetB64DecodedInMapN(&DCtx, 1, QCBOR_TAG_REQUIREMENT_TAG, Out, &Bytes);
+   if(QCBORDecode_GetError(&DCtx) || UsefulBuf_Compare(Bytes, (UsefulBufC){auBytes, sizeof(auBytes)})) {
+      return 92;
+   }
+   QCBORDecode_GetB64URLDecodedInMapN(&DCtx, 2, QCBOR_TAG_REQUIREMENT_TAG, Out, &Bytes);
+   if(QCBORDecode_GetError(&DCtx) || UsefulBuf_Compare(Bytes, (UsefulBufC){auBytes, 100})) {
+      return 93;
+   }
+#endif /* QCBOR_DISABLE_UNCOMMON_TAGS */
+   QCBORDecode_GetB64InMapSZ(&DCtx, "a", QCBOR_TAG_REQUIREMENT_NOT_A_TAG, &Text);
+   if(UsefulBuf_Compare(Text, UsefulBuf_FROM_SZ_LITERAL("Zm8="))) {
+      return 94;
+   }
+   QCBORDecode_GetB64URLInMapSZ(&DCtx, "b", QCBOR_TAG_REQUIREMENT_NOT_A_TAG, &Text);
+   if(UsefulBuf_Compare(Text, UsefulBuf_FROM_SZ_LITERAL("Zm8"))) {
+      return 95;
+   }
+   QCBORDecode_GetB64URLDecodedInMapSZ(&DCtx, "b", QCBOR_TAG_REQUIREMENT_NOT_A_TAG, Out, &Bytes);
+   QCBORDecode_GetB64DecodedInMapSZ(&DCtx, "a", QCBOR_TAG_REQUIREMENT_NOT_A_TAG, Out, &Bytes);
+   if(QCBORDecode_GetError(&DCtx) || UsefulBuf_Compare(Bytes, UsefulBuf_FROM_SZ_LITERAL("fo"))) {
+      return 96;
+   }
+#ifndef QCBOR_DISABLE_UNCOMMON_TAGS
+   /* Too small a buffer, then a bad one, then the right type */
+   QCBORDecode_GetB64DecodedInMapN(&DCtx, 1, QCBOR_TAG_REQUIREMENT_TAG, (UsefulBuf){Out.ptr, 199}, &Bytes);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 97;
+   }
+   QCBORDecode_GetB64URLDecodedInMapN(&DCtx, 1, QCBOR_TAG_REQUIREMENT_TAG, Out, &Bytes);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 98;
+   }
+   QCBORDecode_GetB64DecodedInMapSZ(&DCtx, "c", QCBOR_TAG_REQUIREMENT_TAG, Out, &Bytes);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_RECOVERABLE_BAD_TAG_CONTENT) {
+      return 99;
+   }
+#endif /* QCBOR_DISABLE_UNCOMMON_TAGS */
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 100;
+   }
+
+#ifndef QCBOR_DISABLE_UNCOMMON_TAGS
+   /* Decoded into memory from the string allocator */
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetB64DecodedInMapN(&DCtx, 1, QCBOR_TAG_REQUIREMENT_TAG, NULLUsefulBuf, &Bytes);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_NO_STRING_ALLOCATOR) {
+      return 101;
+   }
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   UsefulBuf_MAKE_STACK_UB(Pool, 400);
+   if(QCBORDecode_SetMemPool(&DCtx, Pool, false)) {
+      return 102;
+   }
+   QCBORDecode_GetB64DecodedInMapN(&DCtx, 1, QCBOR_TAG_REQUIREMENT_TAG, NULLUsefulBuf, &Bytes);
+   if(QCBORDecode_GetError(&DCtx) ||
+      UsefulBuf_Compare(Bytes, (UsefulBufC){auBytes, sizeof(auBytes)}) ||
+      (const uint8_t *)Bytes.ptr < (const uint8_t *)Pool.ptr ||
+      (const uint8_t *)Bytes.ptr >= (const uint8_t *)Pool.ptr + Pool.len) {
+      return 103;
+   }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+#endif /* QCBOR_DISABLE_UNCOMMON_TAGS */
+
+   return 0;
+}
+
+
+static const char *aszValidUTF8[] = {
+   "",
+   "A string of ASCII that is longer than eight bytes",
+   "caf\xc3\xa9",
+   "\xe2\x82\xac 12345678 \xe2\x82\xac",
+   "\xf0\x9f\x98\x80",
+   "\xf4\x8f\xbf\xbf",        /* U+10FFFF */
+   "\xed\x9f\xbf",            /* U+D7FF */
+   "\xee\x80\x80",            /* U+E000 */
+   "\xe0\xa0\x80",            /* U+0800 */
+   "\xf0\x90\x80\x80",        /* U+10000 */
+};
+
+static const char *aszInvalidUTF8[] = {
+   "\xc0\x80",                /* Overlong NUL */
+   "\xc1\xbf",                /* Overlong */
+   "\xe0\x80\x80",            /* Overlong */
+   "\xf0\x8f\xbf\xbf",        /* Overlong */
+   "\xed\xa0\x80",            /* Surrogate */
+   "\xf4\x90\x80\x80",        /* Above U+10FFFF */
+   "\xf5\x80\x80\x80",
+   "\xff",
+   "\x80",                    /* Lone continuation */
+   "ASCII before a bad one \xe2\x82",  /* Truncated */
+   "\xe2\x28\xa1",
+   "\xc3\xa9\xc3",
+};
+
+
+int32_t UTF8ValidationTest(void)
+{
+   QCBOREncodeContext ECtx;
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   UsefulBufC         Encoded;
+   UsefulBufC         String;
+   size_t             uIndex;
+   UsefulBuf_MAKE_STACK_UB(Buffer, 400);
+
+   /* Valid strings as values and labels */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(aszValidUTF8, aszValidUTF8[0]); uIndex++) {
+      QCBOREncode_AddSZStringToMap(&ECtx, aszValidUTF8[uIndex], aszValidUTF8[uIndex]);
+   }
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 1;
+   }
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetUTF8Validation(&DCtx, true);
+   do {
+      QCBORDecode_VGetNext(&DCtx, &Item);
+   } while(QCBORDecode_GetError(&DCtx) == QCBOR_SUCCESS);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_NO_MORE_ITEMS) {
+      return 2;
+   }
+
+   /* Each invalid one as a value, then as a label */
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(aszInvalidUTF8, aszInvalidUTF8[0]); uIndex++) {
+      QCBOREncode_Init(&ECtx, Buffer);
+      QCBOREncode_OpenMap(&ECtx);
+      QCBOREncode_AddSZStringToMapN(&ECtx, 1, aszInvalidUTF8[uIndex]);
+      QCBOREncode_AddInt64ToMap(&ECtx, aszInvalidUTF8[uIndex], 2);
+      QCBOREncode_AddInt64ToMapN(&ECtx, 3, 3);
+      QCBOREncode_CloseMap(&ECtx);
+      if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+         return 3;
+      }
+
+      /* Not checked by default */
+      QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_EnterMap(&DCtx, NULL);
+      QCBORDecode_GetTextStringInMapN(&DCtx, 1, &String);
+      if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS) {
+         return 10 + (int32_t)uIndex;
+      }
+
+      QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_SetUTF8Validation(&DCtx, true);
+      QCBORDecode_VGetNext(&DCtx, &Item);
+      QCBORDecode_VGetNext(&DCtx, &Item);
+      if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_BAD_UTF8) {
+         return 30 + (int32_t)uIndex;
+      }
+      QCBORDecode_VGetNext(&DCtx, &Item);
+      if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_BAD_UTF8) {
+         return 50 + (int32_t)uIndex;
+      }
+      QCBORDecode_VGetNext(&DCtx, &Item);
+      if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS || Item.val.int64 != 3) {
+         return 70 + (int32_t)uIndex;
+      }
+   }
+
+   /* Map searches only report it for the item searched for. Tag
+    * content is checked too. */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddSZStringToMapN(&ECtx, 1, "\xc0\x80");
+   QCBOREncode_AddDateStringToMapN(&ECtx, 2, "\xed\xa0\x80");
+   QCBOREncode_AddSZStringToMapN(&ECtx, 3, "\xe2\x82\xac");
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 90;
+   }
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetUTF8Validation(&DCtx, true);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetTextStringInMapN(&DCtx, 3, &String);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS || String.len != 3) {
+      return 91;
+   }
+   QCBORDecode_GetDateStringInMapN(&DCtx, 2, QCBOR_TAG_REQUIREMENT_TAG, &String);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_BAD_UTF8) {
+      return 92;
+   }
+   QCBORDecode_GetTextStringInMapN(&DCtx, 1, &String);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_BAD_UTF8) {
+      return 93;
+   }
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS) {
+      return 94;
+   }
+
+   /* Turned off again */
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetUTF8Validation(&DCtx, true);
+   QCBORDecode_SetUTF8Validation(&DCtx, false);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetTextStringInMapN(&DCtx, 1, &String);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS) {
+      return 95;
+   }
+
+   /* A bad label on an array consumes the whole array */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_OpenArrayInMap(&ECtx, "\xc0\x80");
+   QCBOREncode_AddInt64(&ECtx, 1);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_AddInt64(&ECtx, 2);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddInt64ToMapN(&ECtx, 3, 3);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 96;
+   }
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetUTF8Validation(&DCtx, true);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_BAD_UTF8 ||
+      Item.uNextNestLevel != 1) {
+      return 97;
+   }
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS ||
+      Item.uLabelType != QCBOR_TYPE_INT64 || Item.val.int64 != 3) {
+      return 98;
+   }
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetUTF8Validation(&DCtx, true);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetInt64InMapN(&DCtx, 3, &Item.val.int64);
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS || Item.val.int64 != 3) {
+      return 99;
+   }
+
+   return 0;
+}
+
+
+int32_t InternTableTest(void)
+{
+   static const char *const aszLabels[] = {"name", "time", "value", "", "a longer label"};
+   static const char *const aszDuplicate[] = {"x", "y", "x"};
+   const char        *aszTooMany[QCBOR_MAX_INTERNED_LABELS + 1];
+   QCBORInternTable   Table;
+   QCBOREncodeContext ECtx;
+   QCBORDecodeContext DCtx;
+   QCBORDecodeContext DCtx2;
+   QCBORItem          Item;
+   UsefulBufC         Encoded;
+   int64_t            nInt;
+   size_t             uIndex;
+   UsefulBuf_MAKE_STACK_UB(Buffer, 200);
+
+   static const struct {
+      const char *szLabel;
+      size_t      uLen;
+      uint8_t     uExpectedId;
+   } Members[] = {
+      {"time",           4,  2},
+      {"nam",            3,  0},
+      {"names",          5,  0},
+      {"name",           4,  1},
+      {"",               0,  4},
+      {"a longer label", 14, 5},
+      {"val\0e",         5,  0},
+      {"value",          5,  3},
+   };
+
+   if(QCBORInternTable_Init(&Table, aszDuplicate, 3) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 1;
+   }
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(aszTooMany, aszTooMany[0]); uIndex++) {
+      aszTooMany[uIndex] = "x";
+   }
+   if(QCBORInternTable_Init(&Table, aszTooMany, QCBOR_MAX_INTERNED_LABELS + 1) != QCBOR_ERR_ARRAY_TOO_LONG) {
+      return 2;
+   }
+   if(QCBORInternTable_Init(&Table, aszLabels, C_ARRAY_COUNT(aszLabels, aszLabels[0]))) {
+      return 3;
+   }
+
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(Members, Members[0]); uIndex++) {
+      QCBOREncode_AddText(&ECtx, (UsefulBufC){Members[uIndex].szLabel, Members[uIndex].uLen});
+      QCBOREncode_AddInt64(&ECtx, (int64_t)uIndex);
+   }
+   QCBOREncode_AddInt64ToMapN(&ECtx, 1, 99);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 4;
+   }
+
+   /* Two decoders sharing the table */
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_Init(&DCtx2, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetInternTable(&DCtx, &Table);
+   QCBORDecode_SetInternTable(&DCtx2, &Table);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_EnterMap(&DCtx2, NULL);
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(Members, Members[0]); uIndex++) {
+      QCBORDecode_VGetNext(&DCtx, &Item);
+      if(QCBORDecode_GetError(&DCtx) ||
+         Item.uLabelType != QCBOR_TYPE_TEXT_STRING ||
+         Item.label.string.len != Members[uIndex].uLen ||
+         Item.uLabelId != Members[uIndex].uExpectedId ||
+         Item.val.int64 != (int64_t)uIndex) {
+         return 10 + (int32_t)uIndex;
+      }
+      QCBORDecode_VGetNext(&DCtx2, &Item);
+      if(Item.uLabelId != Members[uIndex].uExpectedId) {
+         return 30 + (int32_t)uIndex;
+      }
+   }
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   if(Item.uLabelType != QCBOR_TYPE_INT64 || Item.uLabelId != 0) {
+      return 50;
+   }
+
+   /* Searching by label is not affected */
+   QCBORDecode_GetInt64InMapSZ(&DCtx, "value", &nInt);
+   if(QCBORDecode_GetError(&DCtx) || nInt != 7) {
+      return 51;
+   }
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 52;
+   }
+
+   /* No ids without a table */
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetInternTable(&DCtx, &Table);
+   QCBORDecode_SetInternTable(&DCtx, NULL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   if(QCBORDecode_GetError(&DCtx) || Item.uLabelId != 0) {
+      return 60;
+   }
+
+   return 0;
+}
+
+
+int32_t BstrWrappedPosTest(void)
+{
+   QCBOREncodeContext  ECtx;
+   QCBORDecodeContext  DCtx;
+   QCBORBstrWrappedPos Pos;
+   QCBORBstrWrappedPos OuterPos;
+   QCBORBstrEnterCache BstrCache;
+   QCBORItem           Item;
+   UsefulBufC          Encoded;
+   UsefulBufC          Outer;
+   UsefulBufC          Inner;
+   UsefulBufC          Bstr;
+   int64_t             nInt;
+   int                 nPass;
+   UsefulBuf_MAKE_STACK_UB(Buffer, 100);
+
+   /* {1: << [<< {"a": 5} >>, 7] >>, "p": << 9 >>, 3: 4}
+    *
+    * Only the lengths of the wrapped CBOR from the encoder are
+    * compared because closing the outer map moves it. */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_BstrWrapInMapN(&ECtx, 1);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_BstrWrap(&ECtx);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMap(&ECtx, "a", 5);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_CloseBstrWrap2(&ECtx, false, &Inner);
+   QCBOREncode_AddInt64(&ECtx, 7);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_CloseBstrWrap2(&ECtx, false, &Outer);
+   QCBOREncode_BstrWrapInMap(&ECtx, "p");
+   QCBOREncode_AddInt64(&ECtx, 9);
+   QCBOREncode_CloseBstrWrap2(&ECtx, false, NULL);
+   QCBOREncode_AddInt64ToMapN(&ECtx, 3, 4);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 1;
+   }
+
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetBstrEnterCache(&DCtx, &BstrCache);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+
+   QCBORDecode_SaveBstrWrappedPos(&DCtx, &Pos);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_EXIT_MISMATCH) {
+      return 2;
+   }
+
+   /* The second pass enters from the map using the remembered position */
+   for(nPass = 0; nPass < 2; nPass++) {
+      QCBORDecode_EnterBstrWrappedFromMapN(&DCtx, 1, QCBOR_TAG_REQUIREMENT_NOT_A_TAG, &Bstr);
+      if(QCBORDecode_GetError(&DCtx) || Bstr.len != Outer.len) {
+         return 10 + nPass;
+      }
+      QCBORDecode_EnterArray(&DCtx, NULL);
+      QCBORDecode_EnterBstrWrapped(&DCtx, QCBOR_TAG_REQUIREMENT_NOT_A_TAG, &Bstr);
+      QCBORDecode_SaveBstrWrappedPos(&DCtx, &Pos);
+      QCBORDecode_EnterMap(&DCtx, NULL);
+      QCBORDecode_GetInt64InMapSZ(&DCtx, "a", &nInt);
+      QCBORDecode_ExitMap(&DCtx);
+      QCBORDecode_ExitBstrWrapped(&DCtx);
+      if(QCBORDecode_GetError(&DCtx) || nInt != 5 || Bstr.len != Inner.len) {
+         return 12 + nPass;
+      }
+
+      /* Enter the inner one again from its saved position */
+      QCBORDecode_EnterBstrWrappedFromPos(&DCtx, &Pos, &Bstr);
+      if(QCBORDecode_GetError(&DCtx) || Bstr.len != Inner.len) {
+         return 14 + nPass;
+      }
+      QCBORDecode_EnterMap(&DCtx, NULL);
+      QCBORDecode_GetInt64InMapSZ(&DCtx, "a", &nInt);
+      QCBORDecode_ExitMap(&DCtx);
+      QCBORDecode_ExitBstrWrapped(&DCtx);
+
+      /* Traversal continues after the byte string */
+      QCBORDecode_GetInt64(&DCtx, &nInt);
+      if(QCBORDecode_GetError(&DCtx) || nInt != 7) {
+         return 16 + nPass;
+      }
+      QCBORDecode_ExitArray(&DCtx);
+      QCBORDecode_SaveBstrWrappedPos(&DCtx, &OuterPos);
+      QCBORDecode_ExitBstrWrapped(&DCtx);
+      if(QCBORDecode_GetError(&DCtx)) {
+         return 18 + nPass;
+      }
+   }
+
+   /* Same label and different tag requirement is checked again */
+   QCBORDecode_EnterBstrWrappedFromMapN(&DCtx, 1, QCBOR_TAG_REQUIREMENT_TAG, NULL);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 20;
+   }
+
+   /* A text label, then the same text label from the cache */
+   for(nPass = 0; nPass < 2; nPass++) {
+      QCBORDecode_EnterBstrWrappedFromMapSZ(&DCtx, "p", QCBOR_TAG_REQUIREMENT_NOT_A_TAG, NULL);
+      QCBORDecode_GetInt64(&DCtx, &nInt);
+      if(QCBORDecode_GetError(&DCtx) || nInt != 9) {
+         return 21 + nPass;
+      }
+
+      /* The outer position is not in scope in here */
+      QCBORDecode_EnterBstrWrappedFromPos(&DCtx, &OuterPos, &Bstr);
+      if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_HIT_END ||
+         !UsefulBuf_IsNULLC(Bstr)) {
+         return 23 + nPass;
+      }
+      QCBORDecode_ExitBstrWrapped(&DCtx);
+   }
+
+   QCBORDecode_EnterBstrWrappedFromMapN(&DCtx, 99, QCBOR_TAG_REQUIREMENT_NOT_A_TAG, &Bstr);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_LABEL_NOT_FOUND ||
+      !UsefulBuf_IsNULLC(Bstr)) {
+      return 30;
+   }
+
+   /* The outer one from its saved position at the map level */
+   QCBORDecode_EnterBstrWrappedFromPos(&DCtx, &OuterPos, &Bstr);
+   QCBORDecode_GetNext(&DCtx, &Item);
+   if(QCBORDecode_GetError(&DCtx) ||
+      Bstr.len != Outer.len ||
+      Item.uDataType != QCBOR_TYPE_ARRAY) {
+      return 31;
+   }
+   QCBORDecode_ExitBstrWrapped(&DCtx);
+
+   QCBORDecode_GetInt64InMapN(&DCtx, 3, &nInt);
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) || nInt != 4) {
+      return 32;
+   }
+
+   return 0;
+}
+
+
+int32_t StreamByteStringTest(void)
+{
+   QCBOREncodeContext ECtx;
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   UsefulBufC         Encoded;
+   UsefulBufC         Rest;
+   uint64_t           uNotInInput;
+   size_t             uHeadEnd;
+   size_t             uIndex;
+   uint8_t            uBlob[300];
+   UsefulBuf_MAKE_STACK_UB(Buffer, 400);
+
+   for(uIndex = 0; uIndex < sizeof(uBlob); uIndex++) {
+      uBlob[uIndex] = (uint8_t)uIndex;
+   }
+
+   /* ["name", h'<300 bytes>', 7] */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_AddSZString(&ECtx, "name");
+   QCBOREncode_AddBytes(&ECtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(uBlob));
+   QCBOREncode_AddInt64(&ECtx, 7);
+   QCBOREncode_CloseArray(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 1;
+   }
+   /* Array head, "name" and the byte string head */
+   uHeadEnd = 1 + 5 + 3;
+
+   /* Input ending 10 bytes into the byte string */
+   QCBORDecode_Init(&DCtx, UsefulBuf_Head(Encoded, uHeadEnd + 10), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_GetByteStringHead(&DCtx, &Item, &uNotInInput);
+   if(QCBORDecode_GetError(&DCtx) ||
+      Item.uDataType != QCBOR_TYPE_BYTE_STRING ||
+      Item.val.string.len != 10 ||
+      memcmp(Item.val.string.ptr, uBlob, 10) ||
+      uNotInInput != sizeof(uBlob) - 10) {
+      return 2;
+   }
+   /* The caller reads the rest of the byte string from elsewhere */
+   Rest = UsefulBuf_Tail(Encoded, uHeadEnd + sizeof(uBlob));
+   QCBORDecode_ContinueInput(&DCtx, Rest);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   if(QCBORDecode_GetError(&DCtx) ||
+      Item.uDataType != QCBOR_TYPE_INT64 ||
+      Item.val.int64 != 7 ||
+      Item.uNestingLevel != 1) {
+      return 3;
+   }
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 4;
+   }
+
+   /* All in the input is the same as getting it normally */
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_GetByteStringHead(&DCtx, &Item, &uNotInInput);
+   if(QCBORDecode_GetError(&DCtx) ||
+      Item.val.string.len != sizeof(uBlob) ||
+      uNotInInput != 0) {
+      return 5;
+   }
+
+   /* Not a byte string */
+   QCBORDecode_GetByteStringHead(&DCtx, &Item, &uNotInInput);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 6;
+   }
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 7;
+   }
+
+   /* Text strings must be all in the input */
+   QCBORDecode_Init(&DCtx, UsefulBuf_Head(Encoded, 4), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_GetByteStringHead(&DCtx, &Item, &uNotInInput);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_HIT_END) {
+      return 8;
+   }
+
+   /* Can't continue with unconsumed input */
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_ContinueInput(&DCtx, Rest);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_CANNOT_CONTINUE_INPUT) {
+      return 9;
+   }
+
+   /* Can't continue in an entered array */
+   QCBORDecode_Init(&DCtx, UsefulBuf_Head(Encoded, uHeadEnd), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_GetByteStringHead(&DCtx, &Item, &uNotInInput);
+   if(QCBORDecode_GetError(&DCtx) ||
+      Item.val.string.len != 0 ||
+      uNotInInput != sizeof(uBlob)) {
+      return 10;
+   }
+   QCBORDecode_ContinueInput(&DCtx, Rest);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_CANNOT_CONTINUE_INPUT) {
+      return 11;
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   /* {_ "n": 1, "data": h'<300 bytes>'} with the byte string last so
+    * the break is only in the continued input. */
+   static const uint8_t spIndefHead[] = {
+      0xbf, 0x61, 'n', 0x01, 0x64, 'd', 'a', 't', 'a', 0x59, 0x01, 0x2c
+   };
+   static const uint8_t spBreak[] = {0xff};
+
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefHead), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_GetByteStringHead(&DCtx, &Item, &uNotInInput);
+   if(QCBORDecode_GetError(&DCtx) ||
+      Item.uLabelType != QCBOR_TYPE_TEXT_STRING ||
+      UsefulBuf_Compare(Item.label.string, UsefulBuf_FROM_SZ_LITERAL("data")) ||
+      uNotInInput != sizeof(uBlob)) {
+      return 20;
+   }
+   QCBORDecode_ContinueInput(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBreak));
+   if(QCBORDecode_Finish(&DCtx)) {
+      return 21;
+   }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+   return 0;
+}
+
+
+/* {1: 0, 2: 0, 1: 0} */
+static const uint8_t spDuplicateInt[] = {0xa3, 0x01, 0x00, 0x02, 0x00, 0x01, 0x00};
+
+/* {1: 0, 1: 0} with the second 1 not in preferred serialization */
+static const uint8_t spDuplicateLongInt[] = {0xa2, 0x01, 0x00, 0x18, 0x01, 0x00};
+
+/* {"a": 0, h'61': 0, -1: 0, 18446744073709551615: 0} */
+static const uint8_t spNoDuplicates[] = {
+   0xa4, 0x61, 0x61, 0x00, 0x41, 0x61, 0x00, 0x20, 0x00,
+   0x1b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00};
+
+/* {1: {5: 0, 5: 0}, 2: 7} */
+static const uint8_t spNestedDuplicate[] = {
+   0xa2, 0x01, 0xa2, 0x05, 0x00, 0x05, 0x00, 0x02, 0x07};
+
+/* {1: [{1: 0}, {1: 0}], 2: {1: 0}} Same labels in different maps */
+static const uint8_t spSameInOtherMaps[] = {
+   0xa2, 0x01, 0x82, 0xa1, 0x01, 0x00, 0xa1, 0x01, 0x00, 0x02, 0xa1, 0x01, 0x00};
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+/* {_ "x": 0, "y": [_ 1], "x": 0} */
+static const uint8_t spIndefDuplicate[] = {
+   0xbf, 0x61, 0x78, 0x00, 0x61, 0x79, 0x9f, 0x01, 0xff, 0x61, 0x78, 0x00, 0xff};
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+/* {"a": {"b": "xy", "c": h'01'}, "d": ["e"]} */
+static const uint8_t spStringLabels[] = {
+   0xa2, 0x61, 0x61, 0xa2, 0x61, 0x62, 0x62, 0x78, 0x79, 0x61, 0x63,
+   0x41, 0x01, 0x61, 0x64, 0x81, 0x61, 0x65};
+
+/* {"a": {"b": 0}, "a": 1} */
+static const uint8_t spStringDuplicate[] = {
+   0xa2, 0x61, 0x61, 0xa1, 0x61, 0x62, 0x00, 0x61, 0x61, 0x01};
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+/* {(_ "a", "b"): 0, "ab": 1} */
+static const uint8_t spChunkedDuplicate[] = {
+   0xa2, 0x7f, 0x61, 0x61, 0x61, 0x62, 0xff, 0x00, 0x62, 0x61, 0x62, 0x01};
+
+/* {(_ "a", "b"): 0, "ac": 1} */
+static const uint8_t spChunkedLabels[] = {
+   0xa2, 0x7f, 0x61, 0x61, 0x61, 0x62, 0xff, 0x00, 0x62, 0x61, 0x63, 0x01};
+
+/* {(_ "a", "b"): 0, "ac": 1, (_ "a", "c", ""): 2} */
+static const uint8_t spChunkedDuplicate2[] = {
+   0xa3, 0x7f, 0x61, 0x61, 0x61, 0x62, 0xff, 0x00, 0x62, 0x61, 0x63, 0x01,
+   0x7f, 0x61, 0x61, 0x61, 0x63, 0x60, 0xff, 0x02};
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+
+/* Get everything in the input and return the first error */
+static QCBORError
+DuplicateTestGetAll(UsefulBufC Input, QCBORLabelSlot *pSlots, size_t uNumSlots)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   QCBORError         uErr;
+
+   QCBORDecode_Init(&DCtx, Input, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetDuplicateDetection(&DCtx, pSlots, uNumSlots);
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   /* Only room for the strings in the inputs once. The check doesn't
+    * allocate so this is enough. */
+   UsefulBuf_MAKE_STACK_UB(Pool, QCBOR_DECODE_MIN_MEM_POOL_SIZE + 10);
+   QCBORDecode_SetMemPool(&DCtx, Pool, true);
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+   do {
+      uErr = QCBORDecode_GetNext(&DCtx, &Item);
+   } while(uErr == QCBOR_SUCCESS);
+
+   return uErr == QCBOR_ERR_NO_MORE_ITEMS ? QCBOR_SUCCESS : uErr;
+}
+
+
+int32_t DuplicateDetectionTest(void)
+{
+   QCBORLabelSlot     aSlots[8];
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   int64_t            nInt;
+
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicateInt),
+                          aSlots, 8) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 1;
+   }
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicateInt),
+                          NULL, 0) != QCBOR_SUCCESS) {
+      return 2;
+   }
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicateLongInt),
+                          aSlots, 8) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 3;
+   }
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNoDuplicates),
+                          aSlots, 8) != QCBOR_SUCCESS) {
+      return 4;
+   }
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSameInOtherMaps),
+                          aSlots, 8) != QCBOR_SUCCESS) {
+      return 5;
+   }
+
+   /* Too few slots for four labels */
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNoDuplicates),
+                          aSlots, 7) != QCBOR_ERR_LABEL_SLOTS_SIZE) {
+      return 6;
+   }
+
+   /* The outer map is fine. The error comes with the nested map. */
+   QCBORDecode_Init(&DCtx,
+                    UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNestedDuplicate),
+                    QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetDuplicateDetection(&DCtx, aSlots, 8);
+   if(QCBORDecode_GetNext(&DCtx, &Item) != QCBOR_SUCCESS ||
+      Item.uDataType != QCBOR_TYPE_MAP ||
+      Item.val.uCount != 2) {
+      return 10;
+   }
+   if(QCBORDecode_GetNext(&DCtx, &Item) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 11;
+   }
+
+   /* Map searches don't return it for maps not searched for */
+   QCBORDecode_Init(&DCtx,
+                    UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNestedDuplicate),
+                    QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetDuplicateDetection(&DCtx, aSlots, 8);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetInt64InMapN(&DCtx, 2, &nInt);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS || nInt != 7) {
+      return 20;
+   }
+   QCBORDecode_EnterMapFromMapN(&DCtx, 1);
+   if(QCBORDecode_GetAndResetError(&DCtx) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 21;
+   }
+
+   /* Entering a map checks it */
+   QCBORDecode_Init(&DCtx,
+                    UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicateInt),
+                    QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_SetDuplicateDetection(&DCtx, aSlots, 8);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 30;
+   }
+
+   /* Maps as arrays are not checked */
+   QCBORDecode_Init(&DCtx,
+                    UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDuplicateInt),
+                    QCBOR_DECODE_MODE_MAP_AS_ARRAY);
+   QCBORDecode_SetDuplicateDetection(&DCtx, aSlots, 8);
+   if(QCBORDecode_GetNext(&DCtx, &Item) != QCBOR_SUCCESS) {
+      return 40;
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefDuplicate),
+                          aSlots, 8) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 50;
+   }
+   /* With an indefinite-length map, the error is at the third label */
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefDuplicate),
+                          aSlots, 5) != QCBOR_ERR_LABEL_SLOTS_SIZE) {
+      return 51;
+   }
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spStringLabels),
+                          aSlots, 8) != QCBOR_SUCCESS) {
+      return 60;
+   }
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spStringDuplicate),
+                          aSlots, 8) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 61;
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   /* Chunked labels are compared by their content */
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spChunkedDuplicate),
+                          aSlots, 8) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 70;
+   }
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spChunkedDuplicate2),
+                          aSlots, 8) != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 71;
+   }
+   if(DuplicateTestGetAll(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spChunkedLabels),
+                          aSlots, 8) != QCBOR_SUCCESS) {
+      return 72;
+   }
+#endif /* ! QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+   return 0;
+}
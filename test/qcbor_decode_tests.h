@@ -318,4 +318,63 @@ Test GitHub issue #134: decode an indefinite-length string with a zero-length fi
 */
 int32_t CBORTestIssue134(void);
 
+/*
+ Test decoders started from a prepared document.
+ */
+int32_t PreparedDecodeTest(void);
+
+
+/*
+ Test PeekNext() with a peek cache.
+ */
+int32_t PeekCacheTest(void);
+
+
+/*
+ Test that exiting a map whose end is known doesn't decode it again.
+ */
+int32_t ExitWithoutRescanTest(void);
+
+
+/*
+ Test conversion between RFC 3339 date strings and epoch dates.
+ */
+int32_t DateStringEpochTest(void);
+
+
+/*
+ Test base64 and base64url encoding and decoding.
+ */
+int32_t Base64Test(void);
+
+
+/*
+ Test the optional UTF-8 validation of text strings.
+ */
+int32_t UTF8ValidationTest(void);
+
+
+/*
+ Test label interning.
+ */
+int32_t InternTableTest(void);
+
+
+/*
+ Test entering bstr-wrapped CBOR from saved positions.
+ */
+int32_t BstrWrappedPosTest(void);
+
+
+/*
+ Test getting byte strings that run past the end of the input.
+ */
+int32_t StreamByteStringTest(void);
+
+
+/*
+ Test detection of duplicate labels in whole maps.
+ */
+int32_t DuplicateDetectionTest(void);
+
 #endif /* defined(__QCBOR__qcbort_decode_tests__) */
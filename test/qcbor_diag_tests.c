@@ -0,0 +1,321 @@
+/*==============================================================================
+ qcbor_diag_tests.c -- tests for output of CBOR diagnostic notation
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_diag_tests.h"
+#include "qcbor/qcbor_diag.h"
+
+
+struct DiagTestCase {
+   UsefulBufC  Encoded;
+   uint32_t    uOptions;
+   const char *szExpected;
+};
+
+/* The encoded CBOR is given as a string literal of hex escapes */
+#define DIAG_TEST_CASE(szEncoded, uOptions, szExpected) \
+   {{szEncoded, sizeof(szEncoded) - 1}, uOptions, szExpected}
+
+#define DIAG_IND  QCBOR_DIAG_ENCODING_INDICATORS
+#define DIAG_EMB  QCBOR_DIAG_EMBEDDED_CBOR
+
+
+static const struct DiagTestCase sDiagTestCases[] = {
+   /* Integers */
+   DIAG_TEST_CASE("\x00", 0, "0"),
+   DIAG_TEST_CASE("\x17", 0, "23"),
+   DIAG_TEST_CASE("\x18\x18", 0, "24"),
+   DIAG_TEST_CASE("\x18\x18", DIAG_IND, "24_0"),
+   DIAG_TEST_CASE("\x19\x00\x00", DIAG_IND, "0_1"),
+   DIAG_TEST_CASE("\x1a\x00\x0f\x42\x40", DIAG_IND, "1000000_2"),
+   DIAG_TEST_CASE("\x1b\xff\xff\xff\xff\xff\xff\xff\xff", 0, "18446744073709551615"),
+   DIAG_TEST_CASE("\x20", 0, "-1"),
+   DIAG_TEST_CASE("\x38\x63", 0, "-100"),
+   DIAG_TEST_CASE("\x3b\xff\xff\xff\xff\xff\xff\xff\xff", DIAG_IND, "-18446744073709551616_3"),
+
+   /* Strings */
+   DIAG_TEST_CASE("\x40", 0, "h''"),
+   DIAG_TEST_CASE("\x43\x01\xab\xff", 0, "h'01abff'"),
+   DIAG_TEST_CASE("\x60", 0, "\"\""),
+   DIAG_TEST_CASE("\x63\x61\x22\x5c", 0, "\"a\\\"\\\\\""),
+   DIAG_TEST_CASE("\x62\x0a\x7f", 0, "\"\\u000a\\u007f\""),
+   DIAG_TEST_CASE("\x63\xe2\x82\xac", 0, "\"\xe2\x82\xac\""),
+   DIAG_TEST_CASE("\x78\x01\x61", DIAG_IND, "\"a\"_0"),
+   DIAG_TEST_CASE("\x5f\x42\x01\x02\x41\x03\xff", 0, "(_ h'0102', h'03')"),
+   DIAG_TEST_CASE("\x7f\x61\x61\x61\x62\xff", 0, "(_ \"a\", \"b\")"),
+   DIAG_TEST_CASE("\x7f\xff", 0, "(_ )"),
+
+   /* Arrays and maps */
+   DIAG_TEST_CASE("\x80", 0, "[]"),
+   DIAG_TEST_CASE("\xa0", 0, "{}"),
+   DIAG_TEST_CASE("\x83\x01\x02\x03", 0, "[1, 2, 3]"),
+   DIAG_TEST_CASE("\xa2\x01\x02\x61\x61\x80", 0, "{1: 2, \"a\": []}"),
+   DIAG_TEST_CASE("\x82\x81\x81\x80\xa1\x01\xa0", 0, "[[[[]]], {1: {}}]"),
+   DIAG_TEST_CASE("\x9f\x01\x82\x02\x03\xff", 0, "[_ 1, [2, 3]]"),
+   DIAG_TEST_CASE("\xbf\x61\x61\x01\xff", 0, "{_ \"a\": 1}"),
+   DIAG_TEST_CASE("\x9f\xff", 0, "[_ ]"),
+   DIAG_TEST_CASE("\x98\x02\x01\x02", DIAG_IND, "[_0 1, 2]"),
+   DIAG_TEST_CASE("\xb9\x00\x01\x01\x02", DIAG_IND, "{_1 1: 2}"),
+   DIAG_TEST_CASE("\x98\x00", DIAG_IND, "[_0 ]"),
+
+   /* Tags */
+   DIAG_TEST_CASE("\xc1\x1a\x5f\x5e\x10\x00", 0, "1(1600000000)"),
+   DIAG_TEST_CASE("\xc0\xc1\x01", 0, "0(1(1))"),
+   DIAG_TEST_CASE("\x82\xd8\x18\x01\x02", DIAG_IND, "[24_0(1), 2]"),
+   DIAG_TEST_CASE("\xa1\xc1\x01\xc2\x40", 0, "{1(1): 2(h'')}"),
+
+   /* Simple values */
+   DIAG_TEST_CASE("\x84\xf4\xf5\xf6\xf7", 0, "[false, true, null, undefined]"),
+   DIAG_TEST_CASE("\xf0", 0, "simple(16)"),
+   DIAG_TEST_CASE("\xf8\xff", DIAG_IND, "simple(255)_0"),
+
+   /* Floats */
+   DIAG_TEST_CASE("\xf9\x3e\x00", 0, "1.5"),
+   DIAG_TEST_CASE("\xf9\x3e\x00", DIAG_IND, "1.5_1"),
+   DIAG_TEST_CASE("\xf9\x00\x00", 0, "0.0"),
+   DIAG_TEST_CASE("\xf9\x80\x00", 0, "-0.0"),
+   DIAG_TEST_CASE("\xf9\x7c\x00", 0, "Infinity"),
+   DIAG_TEST_CASE("\xf9\xfc\x00", 0, "-Infinity"),
+   DIAG_TEST_CASE("\xf9\x7e\x00", 0, "NaN"),
+   DIAG_TEST_CASE("\xf9\x7b\xff", 0, "65500.0"),
+   DIAG_TEST_CASE("\xf9\x00\x01", 0, "6.0e-8"),
+   DIAG_TEST_CASE("\xf9\x04\x00", 0, "0.00006104"),
+   DIAG_TEST_CASE("\xfa\x3f\x8c\xcc\xcd", DIAG_IND, "1.1_2"),
+   DIAG_TEST_CASE("\xfa\xc0\x20\x00\x00", 0, "-2.5"),
+   DIAG_TEST_CASE("\xfa\x4b\x80\x00\x00", 0, "16777216.0"),
+   DIAG_TEST_CASE("\xfa\x7f\x7f\xff\xff", 0, "3.4028235e+38"),
+   DIAG_TEST_CASE("\xfa\x00\x00\x00\x01", 0, "1.0e-45"),
+   DIAG_TEST_CASE("\xfb\x3f\xf1\x99\x99\x99\x99\x99\x9a", DIAG_IND, "1.1_3"),
+   DIAG_TEST_CASE("\xfb\x3f\xb9\x99\x99\x99\x99\x99\x9a", 0, "0.1"),
+   DIAG_TEST_CASE("\xfb\xc0\x5e\xdd\x2f\x1a\x9f\xbe\x77", 0, "-123.456"),
+   DIAG_TEST_CASE("\xfb\x40\x10\x00\x00\x00\x00\x00\x00", 0, "4.0"),
+   DIAG_TEST_CASE("\xfb\x43\x40\x00\x00\x00\x00\x00\x00", 0, "9007199254740992.0"),
+   DIAG_TEST_CASE("\xfb\x44\x1a\xc5\x3a\x7e\x04\xbc\xda", 0, "123456789012345680000.0"),
+   DIAG_TEST_CASE("\xfb\x44\x4b\x1a\xe4\xd6\xe2\xef\x50", 0, "1.0e+21"),
+   DIAG_TEST_CASE("\xfb\x3e\xe4\xf8\xb5\x88\xe3\x68\xf1", 0, "0.00001"),
+   DIAG_TEST_CASE("\xfb\x3e\xb0\xc6\xf7\xa0\xb5\xed\x8d", 0, "0.000001"),
+   DIAG_TEST_CASE("\xfb\x3e\x7a\xd7\xf2\x9a\xbc\xaf\x48", 0, "1.0e-7"),
+   DIAG_TEST_CASE("\xfb\x7e\x37\xe4\x3c\x88\x00\x75\x9c", 0, "1.0e+300"),
+   DIAG_TEST_CASE("\xfb\x00\x10\x00\x00\x00\x00\x00\x00", 0, "2.2250738585072014e-308"),
+   DIAG_TEST_CASE("\xfb\x00\x00\x00\x00\x00\x00\x00\x01", 0, "5.0e-324"),
+   DIAG_TEST_CASE("\xfb\x7f\xef\xff\xff\xff\xff\xff\xff", 0, "1.7976931348623157e+308"),
+   DIAG_TEST_CASE("\xfb\x7f\xf8\x00\x00\x00\x00\x00\x00", DIAG_IND, "NaN_3"),
+
+   /* Embedded CBOR */
+   DIAG_TEST_CASE("\x43\x82\x01\x02", 0, "h'820102'"),
+   DIAG_TEST_CASE("\x43\x82\x01\x02", DIAG_EMB, "<<[1, 2]>>"),
+   DIAG_TEST_CASE("\x42\x01\x02", DIAG_EMB, "<<1, 2>>"),
+   DIAG_TEST_CASE("\x41\xff", DIAG_EMB, "h'ff'"),
+   DIAG_TEST_CASE("\x42\x82\x01", DIAG_EMB, "h'8201'"),
+   DIAG_TEST_CASE("\x40", DIAG_EMB, "h''"),
+   DIAG_TEST_CASE("\xd8\x18\x44\x43\x41\x01\x02", DIAG_EMB, "24(<<<<<<1>>, 2>>>>)"),
+   DIAG_TEST_CASE("\xd8\x18\x44\x43\x41\x01\x02", DIAG_EMB | DIAG_IND, "24_0(<<<<<<1>>, 2>>>>)"),
+   DIAG_TEST_CASE("\x58\x01\x00", DIAG_EMB | DIAG_IND, "<<0>>_0"),
+   DIAG_TEST_CASE("\x41\x1f", DIAG_EMB, "h'1f'"),
+
+   /* A CBOR sequence */
+   DIAG_TEST_CASE("\x01\x61\x61\x80", 0, "1, \"a\", []"),
+   DIAG_TEST_CASE("", 0, ""),
+};
+
+
+int32_t DiagTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(Buffer, 200);
+   UsefulBufC              Diag;
+   QCBORError              uErr;
+   size_t                  uIndex;
+
+   for(uIndex = 0; uIndex < sizeof(sDiagTestCases)/sizeof(sDiagTestCases[0]); uIndex++) {
+      const struct DiagTestCase *pTest = &sDiagTestCases[uIndex];
+
+      uErr = QCBORDecode_ToDiag(pTest->Encoded, pTest->uOptions, Buffer, &Diag);
+      if(uErr != QCBOR_SUCCESS) {
+         return (int32_t)(uIndex * 100 + uErr);
+      }
+      if(UsefulBuf_Compare(Diag, UsefulBuf_FromSZ(pTest->szExpected))) {
+         return (int32_t)(uIndex * 100 + 99);
+      }
+
+      /* Size calculation gives the same length */
+      uErr = QCBORDecode_ToDiag(pTest->Encoded, pTest->uOptions, SizeCalculateUsefulBuf, &Diag);
+      if(uErr != QCBOR_SUCCESS || Diag.len != strlen(pTest->szExpected)) {
+         return (int32_t)(uIndex * 100 + 98);
+      }
+   }
+
+   return 0;
+}
+
+
+struct DiagErrorTestCase {
+   UsefulBufC  Encoded;
+   QCBORError  uExpectedErr;
+   const char *szExpectedOutput;
+};
+
+#define DIAG_ERROR_TEST_CASE(szEncoded, uErr, szOutput) \
+   {{szEncoded, sizeof(szEncoded) - 1}, uErr, szOutput}
+
+static const struct DiagErrorTestCase sDiagErrorTestCases[] = {
+   DIAG_ERROR_TEST_CASE("\x82\x01", QCBOR_ERR_HIT_END, "[1"),
+   DIAG_ERROR_TEST_CASE("\x19\x01", QCBOR_ERR_HIT_END, ""),
+   DIAG_ERROR_TEST_CASE("\x43\x01\x02", QCBOR_ERR_HIT_END, ""),
+   DIAG_ERROR_TEST_CASE("\x01\x5b\xff\xff\xff\xff\xff\xff\xff\xff", QCBOR_ERR_HIT_END, "1, "),
+   DIAG_ERROR_TEST_CASE("\xff", QCBOR_ERR_BAD_BREAK, ""),
+   DIAG_ERROR_TEST_CASE("\x82\x01\xff", QCBOR_ERR_BAD_BREAK, "[1"),
+   DIAG_ERROR_TEST_CASE("\xbf\x01\xff", QCBOR_ERR_BAD_BREAK, "{_ 1"),
+   DIAG_ERROR_TEST_CASE("\xc1\xff", QCBOR_ERR_BAD_BREAK, "1("),
+   DIAG_ERROR_TEST_CASE("\x1c", QCBOR_ERR_UNSUPPORTED, ""),
+   DIAG_ERROR_TEST_CASE("\x9f\xfe", QCBOR_ERR_UNSUPPORTED, "[_ "),
+   DIAG_ERROR_TEST_CASE("\xf8\x10", QCBOR_ERR_BAD_TYPE_7, ""),
+   DIAG_ERROR_TEST_CASE("\x1f", QCBOR_ERR_BAD_INT, ""),
+   DIAG_ERROR_TEST_CASE("\x3f", QCBOR_ERR_BAD_INT, ""),
+   DIAG_ERROR_TEST_CASE("\xdf\x01", QCBOR_ERR_BAD_INT, ""),
+   DIAG_ERROR_TEST_CASE("\x82\x01\x1f", QCBOR_ERR_BAD_INT, "[1, "),
+   DIAG_ERROR_TEST_CASE("\x5f\x61\x61\xff", QCBOR_ERR_INDEFINITE_STRING_CHUNK, "(_ "),
+   DIAG_ERROR_TEST_CASE("\x5f\x5f\xff\xff", QCBOR_ERR_INDEFINITE_STRING_CHUNK, "(_ "),
+   DIAG_ERROR_TEST_CASE("\x7f\x01\xff", QCBOR_ERR_INDEFINITE_STRING_CHUNK, "(_ "),
+};
+
+
+struct DiagWriterCtx {
+   UsefulOutBuf OutBuf;
+   int          nCalls;
+   int          nFailAtCall;
+};
+
+static QCBORError DiagTestWriter(void *pCtx, UsefulBufC Text)
+{
+   struct DiagWriterCtx *pWriter = (struct DiagWriterCtx *)pCtx;
+
+   pWriter->nCalls++;
+   if(pWriter->nCalls == pWriter->nFailAtCall) {
+      return QCBOR_ERR_CALLBACK_FAIL;
+   }
+   UsefulOutBuf_AppendUsefulBuf(&(pWriter->OutBuf), Text);
+   return QCBOR_SUCCESS;
+}
+
+
+int32_t DiagErrorTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(Buffer, 300);
+   UsefulBuf_MAKE_STACK_UB(Input, 120);
+   UsefulBufC              Diag;
+   QCBORError              uErr;
+   size_t                  uIndex;
+   struct DiagWriterCtx    Writer;
+   UsefulOutBuf            UOB;
+   UsefulBufC              Encoded;
+
+   for(uIndex = 0; uIndex < sizeof(sDiagErrorTestCases)/sizeof(sDiagErrorTestCases[0]); uIndex++) {
+      const struct DiagErrorTestCase *pTest = &sDiagErrorTestCases[uIndex];
+
+      uErr = QCBORDecode_ToDiag(pTest->Encoded, 0, Buffer, &Diag);
+      if(uErr != pTest->uExpectedErr) {
+         return (int32_t)(uIndex * 100 + uErr);
+      }
+      /* The output up to the error is still there */
+      if(UsefulBuf_Compare(Diag, UsefulBuf_FromSZ(pTest->szExpectedOutput))) {
+         return (int32_t)(uIndex * 100 + 99);
+      }
+   }
+
+   /* Nesting to exactly the limit is OK, one more is not */
+   memset(Input.ptr, 0x81, QCBOR_DIAG_MAX_NESTING + 1);
+   ((uint8_t *)Input.ptr)[QCBOR_DIAG_MAX_NESTING] = 0x00;
+   uErr = QCBORDecode_ToDiag((UsefulBufC){Input.ptr, QCBOR_DIAG_MAX_NESTING + 1}, 0, Buffer, &Diag);
+   if(uErr != QCBOR_SUCCESS || Diag.len != QCBOR_DIAG_MAX_NESTING * 2 + 1) {
+      return -1;
+   }
+   ((uint8_t *)Input.ptr)[QCBOR_DIAG_MAX_NESTING] = 0x81;
+   ((uint8_t *)Input.ptr)[QCBOR_DIAG_MAX_NESTING + 1] = 0x00;
+   uErr = QCBORDecode_ToDiag((UsefulBufC){Input.ptr, QCBOR_DIAG_MAX_NESTING + 2}, 0, Buffer, &Diag);
+   if(uErr != QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP) {
+      return -2;
+   }
+
+   /* Tags count as nesting */
+   memset(Input.ptr, 0xc1, QCBOR_DIAG_MAX_NESTING + 1);
+   ((uint8_t *)Input.ptr)[QCBOR_DIAG_MAX_NESTING + 1] = 0x00;
+   uErr = QCBORDecode_ToDiag((UsefulBufC){Input.ptr, QCBOR_DIAG_MAX_NESTING + 2}, 0, Buffer, &Diag);
+   if(uErr != QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP) {
+      return -3;
+   }
+
+   /* Byte strings wrapped more deeply than the nesting limit. The
+    * inner ones are output as hex rather than as an error. */
+   UsefulOutBuf_Init(&UOB, Input);
+   UsefulOutBuf_AppendByte(&UOB, 0x00);
+   for(uIndex = 0; uIndex < QCBOR_DIAG_MAX_NESTING + 8; uIndex++) {
+      const size_t uLen = UsefulOutBuf_GetEndPosition(&UOB);
+      if(uLen < 24) {
+         UsefulOutBuf_InsertByte(&UOB, (uint8_t)(0x40 + uLen), 0);
+      } else {
+         UsefulOutBuf_InsertByte(&UOB, (uint8_t)uLen, 0);
+         UsefulOutBuf_InsertByte(&UOB, 0x58, 0);
+      }
+   }
+   Encoded = UsefulOutBuf_OutUBuf(&UOB);
+   if(UsefulBuf_IsNULLC(Encoded)) {
+      return -4;
+   }
+   uErr = QCBORDecode_ToDiag(Encoded, QCBOR_DIAG_EMBEDDED_CBOR, Buffer, &Diag);
+   if(uErr != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(UsefulBuf_Head(Diag, 4), UsefulBuf_FromSZ("<<<<")) ||
+      UsefulBuf_Compare(UsefulBuf_Tail(Diag, Diag.len - 2), UsefulBuf_FromSZ(">>"))) {
+      return -5;
+   }
+
+   /* Output that doesn't fit is truncated at the end of the buffer */
+   uErr = QCBORDecode_ToDiag(UsefulBuf_FROM_SZ_LITERAL("\x82\x01\x02"),
+                             0,
+                             (UsefulBuf){Buffer.ptr, 4},
+                             &Diag);
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL ||
+      UsefulBuf_Compare(Diag, UsefulBuf_FROM_SZ_LITERAL("[1, "))) {
+      return -6;
+   }
+
+   /* A 100-byte string goes to the writer in several pieces */
+   memset(Input.ptr, 0xab, 101);
+   ((uint8_t *)Input.ptr)[0] = 0x58;
+   ((uint8_t *)Input.ptr)[1] = 99;
+   Encoded = (UsefulBufC){Input.ptr, 101};
+   UsefulOutBuf_Init(&(Writer.OutBuf), Buffer);
+   Writer.nCalls      = 0;
+   Writer.nFailAtCall = 0;
+   uErr = QCBORDecode_ToDiagWithWriter(Encoded, 0, SIZE_MAX, DiagTestWriter, &Writer);
+   Diag = UsefulOutBuf_OutUBuf(&(Writer.OutBuf));
+   if(uErr != QCBOR_SUCCESS || Diag.len != 201 || Writer.nCalls < 3) {
+      return -7;
+   }
+
+   /* The writer's size cap */
+   UsefulOutBuf_Init(&(Writer.OutBuf), Buffer);
+   Writer.nCalls = 0;
+   uErr = QCBORDecode_ToDiagWithWriter(Encoded, 0, 50, DiagTestWriter, &Writer);
+   Diag = UsefulOutBuf_OutUBuf(&(Writer.OutBuf));
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL || Diag.len != 50) {
+      return -8;
+   }
+
+   /* An error from the writer stops output and is returned */
+   UsefulOutBuf_Init(&(Writer.OutBuf), Buffer);
+   Writer.nCalls      = 0;
+   Writer.nFailAtCall = 2;
+   uErr = QCBORDecode_ToDiagWithWriter(Encoded, 0, SIZE_MAX, DiagTestWriter, &Writer);
+   if(uErr != QCBOR_ERR_CALLBACK_FAIL || Writer.nCalls != 2) {
+      return -9;
+   }
+
+   return 0;
+}
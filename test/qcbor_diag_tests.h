@@ -0,0 +1,32 @@
+/*==============================================================================
+ qcbor_diag_tests.h -- tests for output of CBOR diagnostic notation
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_diag_tests_h
+#define qcbor_diag_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Outputs a set of encoded CBOR as diagnostic notation and compares
+ the results to the expected text. Covers all major types,
+ indefinite lengths, floats, encoding indicators and embedded CBOR.
+ */
+int32_t DiagTest(void);
+
+
+/*
+ Checks that not-well-formed CBOR, too deep nesting, the output size
+ cap and writer errors give the expected errors.
+ */
+int32_t DiagErrorTest(void);
+
+
+#endif /* qcbor_diag_tests_h */
@@ -0,0 +1,309 @@
+/*==============================================================================
+ qcbor_dom_tests.c -- tests for decoding into a tree of nodes
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_dom_tests.h"
+#include "qcbor/qcbor_dom.h"
+#include "qcbor/qcbor_encode.h"
+#include <string.h> /* for memcpy() */
+
+
+/*
+ {"b": [1, -2, "x"], 3: h'0102', "a": {"z": 18446744073709551615},
+  -1: true, "t": 1(100), 0: []}
+ */
+static UsefulBufC
+DomTest_Encode(UsefulBuf Buffer)
+{
+   QCBOREncodeContext ECtx;
+   UsefulBufC         Encoded;
+   static const uint8_t auBytes[] = {0x01, 0x02};
+
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_OpenArrayInMap(&ECtx, "b");
+   QCBOREncode_AddInt64(&ECtx, 1);
+   QCBOREncode_AddInt64(&ECtx, -2);
+   QCBOREncode_AddSZString(&ECtx, "x");
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddBytesToMapN(&ECtx, 3, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(auBytes));
+   QCBOREncode_OpenMapInMap(&ECtx, "a");
+   QCBOREncode_AddUInt64ToMap(&ECtx, "z", UINT64_MAX);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddBoolToMapN(&ECtx, -1, true);
+   QCBOREncode_AddSZString(&ECtx, "t");
+   QCBOREncode_AddTag(&ECtx, 1);
+   QCBOREncode_AddInt64(&ECtx, 100);
+   QCBOREncode_OpenArrayInMapN(&ECtx, 0);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_SUCCESS) {
+      return NULLUsefulBufC;
+   }
+   return Encoded;
+}
+
+
+/* Look up everything in the tree from DomTest_Encode(). The same
+ * results are expected whether or not the maps are sorted. */
+static int32_t
+DomTest_Lookups(const QCBORDomNode *pRoot)
+{
+   const QCBORDomNode *pNode;
+
+   if(pRoot->uDataType != QCBOR_TYPE_MAP || pRoot->uCount != 6) {
+      return 1;
+   }
+
+   pNode = QCBORDom_GetInMapSZ(pRoot, "b");
+   if(pNode == NULL || pNode->uDataType != QCBOR_TYPE_ARRAY || pNode->uCount != 3) {
+      return 2;
+   }
+   pNode = QCBORDom_GetInArray(pNode, 2);
+   if(pNode == NULL || pNode->uDataType != QCBOR_TYPE_TEXT_STRING ||
+      UsefulBuf_Compare(pNode->val.string, UsefulBuf_FROM_SZ_LITERAL("x"))) {
+      return 3;
+   }
+   if(QCBORDom_GetInArray(QCBORDom_GetInMapSZ(pRoot, "b"), 3) != NULL) {
+      return 4;
+   }
+
+   pNode = QCBORDom_GetInMapN(pRoot, 3);
+   if(pNode == NULL || pNode->uDataType != QCBOR_TYPE_BYTE_STRING || pNode->val.string.len != 2) {
+      return 5;
+   }
+
+   pNode = QCBORDom_GetInMapSZ(QCBORDom_GetInMapSZ(pRoot, "a"), "z");
+   if(pNode == NULL || pNode->uDataType != QCBOR_TYPE_UINT64 || pNode->val.uint64 != UINT64_MAX) {
+      return 6;
+   }
+
+   pNode = QCBORDom_GetInMapN(pRoot, -1);
+   if(pNode == NULL || pNode->uDataType != QCBOR_TYPE_TRUE) {
+      return 7;
+   }
+
+   pNode = QCBORDom_GetInMapSZ(pRoot, "t");
+   if(pNode == NULL || pNode->uDataType != QCBOR_TYPE_INT64 ||
+      pNode->val.int64 != 100 || pNode->uTagNumber != 1) {
+      return 8;
+   }
+
+   pNode = QCBORDom_GetInMapN(pRoot, 0);
+   if(pNode == NULL || pNode->uDataType != QCBOR_TYPE_ARRAY ||
+      pNode->uCount != 0 || QCBORDom_FirstChild(pNode) != NULL) {
+      return 9;
+   }
+
+   /* Not there, or not a map or array */
+   if(QCBORDom_GetInMapSZ(pRoot, "c") != NULL ||
+      QCBORDom_GetInMapSZ(pRoot, "") != NULL ||
+      QCBORDom_GetInMapN(pRoot, 4) != NULL ||
+      QCBORDom_GetInMapN(pRoot, -2) != NULL ||
+      QCBORDom_GetInMapN(QCBORDom_GetInMapSZ(pRoot, "b"), 0) != NULL ||
+      QCBORDom_GetInArray(pRoot, 0) != NULL) {
+      return 10;
+   }
+
+   return 0;
+}
+
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+/* {_ "b": 1, "a": [_ 2], "c": 3} */
+static const uint8_t spDomIndef[] = {0xbf, 0x61, 0x62, 0x01, 0x61, 0x61, 0x9f, 0x02, 0xff,
+                                     0x61, 0x63, 0x03, 0xff};
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+
+int32_t DomBuildTest(void)
+{
+   QCBORError          uErr;
+   UsefulBufC          Encoded;
+   size_t              uNeeded;
+   size_t              uUsed;
+   size_t              uIndex;
+   int32_t             nResult;
+   const QCBORDomNode *pNode;
+   QCBORDomNode        aArena[30];
+   QCBORDomNode        aCopy[30];
+   UsefulBuf_MAKE_STACK_UB(Buffer, 100);
+
+   Encoded = DomTest_Encode(Buffer);
+   if(UsefulBuf_IsNULLC(Encoded)) {
+      return 1;
+   }
+
+   /* 18 items and, when sorted, 2 nodes for the 6 labels of the outer
+    * map and 1 for the inner map */
+   uErr = QCBORDom_Build(Encoded, NULL, 0, 0, &uNeeded);
+   if(uErr != QCBOR_SUCCESS || uNeeded != 18) {
+      return 2;
+   }
+   uErr = QCBORDom_Build(Encoded, aArena, uNeeded, 0, &uUsed);
+   if(uErr != QCBOR_SUCCESS || uUsed != uNeeded) {
+      return 3;
+   }
+   nResult = DomTest_Lookups(&aArena[0]);
+   if(nResult) {
+      return 10 + nResult;
+   }
+
+   /* Walk the members in order */
+   if(aArena[0].uNext != 18) {
+      return 30;
+   }
+   pNode = QCBORDom_FirstChild(&aArena[0]);
+   for(uIndex = 0; uIndex < aArena[0].uCount; uIndex++) {
+      pNode = QCBORDom_Next(QCBORDom_Next(pNode));
+   }
+   if(pNode != &aArena[18]) {
+      return 31;
+   }
+   pNode = QCBORDom_Next(QCBORDom_FirstChild(&aArena[0]));
+   if(pNode->uDataType != QCBOR_TYPE_ARRAY || pNode->uNext != 4 ||
+      pNode[2].uDataType != QCBOR_TYPE_INT64 || pNode[2].val.int64 != -2) {
+      return 32;
+   }
+
+   uErr = QCBORDom_Build(Encoded, NULL, 0, QCBOR_DOM_SORT_MAPS, &uNeeded);
+   if(uErr != QCBOR_SUCCESS || uNeeded != 21) {
+      return 40;
+   }
+   uErr = QCBORDom_Build(Encoded, aArena, uNeeded - 1, QCBOR_DOM_SORT_MAPS, &uUsed);
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 41;
+   }
+   uErr = QCBORDom_Build(Encoded, aArena, sizeof(aArena)/sizeof(aArena[0]), QCBOR_DOM_SORT_MAPS, &uUsed);
+   if(uErr != QCBOR_SUCCESS || uUsed != uNeeded) {
+      return 42;
+   }
+   if(aArena[0].val.uSorted == 0) {
+      return 43;
+   }
+   nResult = DomTest_Lookups(&aArena[0]);
+   if(nResult) {
+      return 50 + nResult;
+   }
+
+   /* Offsets only, so a copy works the same */
+   memcpy(aCopy, aArena, sizeof(aArena));
+   memset(aArena, 0xff, sizeof(aArena));
+   nResult = DomTest_Lookups(&aCopy[0]);
+   if(nResult) {
+      return 70 + nResult;
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   /* Sorted when the count is known at the break */
+   uErr = QCBORDom_Build(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spDomIndef),
+                         aArena, sizeof(aArena)/sizeof(aArena[0]), QCBOR_DOM_SORT_MAPS, &uUsed);
+   if(uErr != QCBOR_SUCCESS || uUsed != 9 || aArena[0].uCount != 3 || aArena[0].uNext != 8) {
+      return 90;
+   }
+   pNode = QCBORDom_GetInMapSZ(&aArena[0], "a");
+   if(pNode == NULL || pNode->uDataType != QCBOR_TYPE_ARRAY ||
+      pNode->uCount != 1 || pNode->uNext != 2 || pNode[1].val.int64 != 2) {
+      return 91;
+   }
+   pNode = QCBORDom_GetInMapSZ(&aArena[0], "c");
+   if(pNode == NULL || pNode->val.int64 != 3) {
+      return 92;
+   }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   /* 1.5 as a double */
+   uErr = QCBORDom_Build((UsefulBufC){"\xfb\x3f\xf8\x00\x00\x00\x00\x00\x00", 9},
+                         aArena, 1, 0, &uUsed);
+   if(uErr != QCBOR_SUCCESS || aArena[0].uDataType != QCBOR_TYPE_DOUBLE ||
+      UsefulBufUtil_CopyDoubleToUint64(aArena[0].val.dfnum) != UsefulBufUtil_CopyDoubleToUint64(1.5)) {
+      return 100;
+   }
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+   return 0;
+}
+
+
+static const struct {
+   const char *szName;
+   UsefulBufC  Input;
+   QCBORError  uExpected;
+} DomErrorTests[] = {
+   {"empty",              {"", 0},                       QCBOR_ERR_HIT_END},
+   {"two items",          {"\x01\x02", 2},               QCBOR_ERR_EXTRA_BYTES},
+   {"break alone",        {"\xff", 1},                   QCBOR_ERR_BAD_BREAK},
+   {"break in array",     {"\x81\xff", 2},               QCBOR_ERR_BAD_BREAK},
+   {"array cut short",    {"\x82\x01", 2},               QCBOR_ERR_HIT_END},
+   {"tag at end",         {"\xc1", 1},                   QCBOR_ERR_HIT_END},
+   {"string cut short",   {"\x63\x61", 2},               QCBOR_ERR_HIT_END},
+   {"reserved add info",  {"\x1c", 1},                   QCBOR_ERR_UNSUPPORTED},
+   {"indefinite int",     {"\x1f", 1},                   QCBOR_ERR_BAD_INT},
+   {"bad simple",         {"\xf8\x10", 2},               QCBOR_ERR_BAD_TYPE_7},
+   {"array too long",     {"\x9a\x00\x01\x00\x00", 5},   QCBOR_ERR_ARRAY_DECODE_TOO_LONG},
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   {"break after label",  {"\xbf\x01\xff", 3},           QCBOR_ERR_BAD_BREAK},
+   {"tag on break",       {"\x9f\xc1\xff", 3},           QCBOR_ERR_BAD_BREAK},
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+   {"indefinite array",   {"\x9f\xff", 2},               QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED},
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   {"indefinite string",  {"\x5f\x41\x00\xff", 4},       QCBOR_ERR_NO_STRING_ALLOCATOR},
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+   {"indefinite string",  {"\x5f\x41\x00\xff", 4},       QCBOR_ERR_INDEF_LEN_STRINGS_DISABLED},
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+};
+
+
+int32_t DomErrorsTest(void)
+{
+   size_t       uIndex;
+   size_t       uUsed;
+   QCBORError   uErr;
+   uint8_t      auDeep[QCBOR_MAX_ARRAY_NESTING + 2];
+   QCBORDomNode aArena[QCBOR_MAX_ARRAY_NESTING + 2];
+
+   for(uIndex = 0; uIndex < sizeof(DomErrorTests)/sizeof(DomErrorTests[0]); uIndex++) {
+      uErr = QCBORDom_Build(DomErrorTests[uIndex].Input, aArena, 4, 0, &uUsed);
+      if(uErr != DomErrorTests[uIndex].uExpected) {
+         return (int32_t)(1 + uIndex * 10);
+      }
+      /* The same without an arena */
+      uErr = QCBORDom_Build(DomErrorTests[uIndex].Input, NULL, 0, QCBOR_DOM_SORT_MAPS, NULL);
+      if(uErr != DomErrorTests[uIndex].uExpected) {
+         return (int32_t)(2 + uIndex * 10);
+      }
+   }
+
+   /* As deep as allowed, then one too deep */
+   memset(auDeep, 0x81, sizeof(auDeep));
+   auDeep[QCBOR_MAX_ARRAY_NESTING] = 0x00;
+   uErr = QCBORDom_Build((UsefulBufC){auDeep, QCBOR_MAX_ARRAY_NESTING + 1},
+                         aArena, QCBOR_MAX_ARRAY_NESTING + 1, 0, &uUsed);
+   if(uErr != QCBOR_SUCCESS || aArena[0].uNext != QCBOR_MAX_ARRAY_NESTING + 1) {
+      return 500;
+   }
+   auDeep[QCBOR_MAX_ARRAY_NESTING] = 0x81;
+   auDeep[QCBOR_MAX_ARRAY_NESTING + 1] = 0x00;
+   uErr = QCBORDom_Build((UsefulBufC){auDeep, sizeof(auDeep)},
+                         aArena, QCBOR_MAX_ARRAY_NESTING + 2, 0, &uUsed);
+   if(uErr != QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP) {
+      return 501;
+   }
+
+   /* Too small by one node. The number used is how far it got. */
+   uErr = QCBORDom_Build((UsefulBufC){"\x82\x01\x02", 3}, aArena, 2, 0, &uUsed);
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL || uUsed != 2) {
+      return 600;
+   }
+
+   return 0;
+}
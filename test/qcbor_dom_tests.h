@@ -0,0 +1,32 @@
+/*==============================================================================
+ qcbor_dom_tests.h -- tests for decoding into a tree of nodes
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_dom_tests_h
+#define qcbor_dom_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Builds trees with and without sorted maps, walks them, looks up
+ labels and array positions, checks the number of nodes needed and
+ that a tree still works after it is copied.
+ */
+int32_t DomBuildTest(void);
+
+
+/*
+ Checks the errors for input that is not well-formed, more than one
+ item and an arena that is too small.
+ */
+int32_t DomErrorsTest(void);
+
+
+#endif /* qcbor_dom_tests_h */
@@ -3061,3 +3061,250 @@ OpenCloseBytesTest(void)
 
    return 0;
 }
+
+
+/*
+ {1: [true, false], 3: "c", -1: 0, "a": {"y": 2, "z": 1}, "b": 2}
+ with the entries in the bytewise lexicographic order of their
+ encoded labels.
+ */
+static const uint8_t spExpectedSortedMap[] = {
+   0xA5,
+      0x01, 0x82, 0xF5, 0xF4,
+      0x03, 0x61, 0x63,
+      0x20, 0x00,
+      0x61, 0x61, 0xA2,
+         0x61, 0x79, 0x02,
+         0x61, 0x7A, 0x01,
+      0x61, 0x62, 0x02
+};
+
+
+int32_t SortMapTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(   TestBuf, 100);
+   QCBOREncodeContext         EC;
+   UsefulBufC                 Encoded;
+   QCBORError                 uErr;
+   size_t                     uSize;
+
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_AddSZStringToMapN(&EC, 3, "c");
+      QCBOREncode_AddInt64ToMap(&EC, "b", 2);
+      QCBOREncode_OpenArrayInMapN(&EC, 1);
+         QCBOREncode_AddBool(&EC, true);
+         QCBOREncode_AddBool(&EC, false);
+      QCBOREncode_CloseArray(&EC);
+      QCBOREncode_AddInt64ToMapN(&EC, -1, 0);
+      QCBOREncode_OpenMapInMap(&EC, "a");
+         QCBOREncode_AddInt64ToMap(&EC, "z", 1);
+         QCBOREncode_AddInt64ToMap(&EC, "y", 2);
+      QCBOREncode_CloseAndSortMap(&EC);
+   QCBOREncode_CloseAndSortMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_SUCCESS) {
+      return 1;
+   }
+   if(UsefulBuf_Compare(Encoded,
+                        UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spExpectedSortedMap))) {
+      return 2;
+   }
+
+   /* Size calculation gives the same size without sorting */
+   QCBOREncode_Init(&EC, SizeCalculateUsefulBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_AddInt64ToMap(&EC, "b", 2);
+      QCBOREncode_AddInt64ToMap(&EC, "a", 1);
+   QCBOREncode_CloseAndSortMap(&EC);
+   uErr = QCBOREncode_FinishGetSize(&EC, &uSize);
+   if(uErr != QCBOR_SUCCESS || uSize != 7) {
+      return 3;
+   }
+
+   /* An empty map */
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+   QCBOREncode_CloseAndSortMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Encoded, UsefulBuf_FROM_SZ_LITERAL("\xA0"))) {
+      return 4;
+   }
+
+   /* Indefinite-length items can't be sorted */
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_AddInt64ToMapN(&EC, 2, 0);
+      QCBOREncode_OpenArrayIndefiniteLengthInMapN(&EC, 1);
+      QCBOREncode_CloseArrayIndefiniteLength(&EC);
+   QCBOREncode_CloseAndSortMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_ERR_ENCODE_UNSUPPORTED) {
+      return 5;
+   }
+
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
+   /* Closing an array with the map sort */
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenArray(&EC);
+      QCBOREncode_AddInt64(&EC, 2);
+      QCBOREncode_AddInt64(&EC, 1);
+   QCBOREncode_CloseAndSortMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_ERR_CLOSE_MISMATCH) {
+      return 6;
+   }
+#endif /* QCBOR_DISABLE_ENCODE_USAGE_GUARDS */
+
+   return 0;
+}
+
+
+/* {1: 2, "a": true} */
+static const uint8_t spMergeMap1[] = {
+   0xA2, 0x01, 0x02, 0x61, 0x61, 0xF5
+};
+
+/* {-1: [0]} */
+static const uint8_t spMergeMap2[] = {
+   0xA1, 0x20, 0x81, 0x00
+};
+
+/* {0: "x", 1: 3} */
+static const uint8_t spMergeMapDup[] = {
+   0xA2, 0x00, 0x61, 0x78, 0x01, 0x03
+};
+
+/* {0: "x", 1: 2, "a": true, -1: [0], "b": {}} */
+static const uint8_t spExpectedMergedMap[] = {
+   0xA5, 0x00, 0x61, 0x78, 0x01, 0x02, 0x61, 0x61,
+   0xF5, 0x20, 0x81, 0x00, 0x61, 0x62, 0xA0
+};
+
+
+int32_t MergeMapsTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(   TestBuf, 100);
+   QCBOREncodeContext         EC;
+   UsefulBufC                 Encoded;
+   QCBORError                 uErr;
+   size_t                     uSize;
+   UsefulBufC                 Maps[3];
+
+   Maps[0] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spMergeMap1);
+   Maps[1] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spMergeMap2);
+   Maps[2] = UsefulBuf_FROM_SZ_LITERAL("\xA0");
+
+   /* Entries added before and after the merge */
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_AddSZStringToMapN(&EC, 0, "x");
+      QCBOREncode_MergeMaps(&EC, Maps, 3, QCBOR_MERGE_CHECK_DUPLICATES);
+      QCBOREncode_OpenMapInMap(&EC, "b");
+      QCBOREncode_CloseMap(&EC);
+   QCBOREncode_CloseMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_SUCCESS) {
+      return 1;
+   }
+   if(UsefulBuf_Compare(Encoded,
+                        UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spExpectedMergedMap))) {
+      return 2;
+   }
+
+   /* Size calculation */
+   QCBOREncode_Init(&EC, SizeCalculateUsefulBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_AddSZStringToMapN(&EC, 0, "x");
+      QCBOREncode_MergeMaps(&EC, Maps, 3, QCBOR_MERGE_CHECK_DUPLICATES);
+      QCBOREncode_OpenMapInMap(&EC, "b");
+      QCBOREncode_CloseMap(&EC);
+   QCBOREncode_CloseMap(&EC);
+   uErr = QCBOREncode_FinishGetSize(&EC, &uSize);
+   if(uErr != QCBOR_SUCCESS || uSize != sizeof(spExpectedMergedMap)) {
+      return 3;
+   }
+
+   /* Duplicate between two merged maps */
+   Maps[1] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spMergeMapDup);
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_MergeMaps(&EC, Maps, 2, QCBOR_MERGE_CHECK_DUPLICATES);
+   QCBOREncode_CloseMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 4;
+   }
+
+   /* Not checked without the option */
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_MergeMaps(&EC, Maps, 2, 0);
+   QCBOREncode_CloseMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_SUCCESS || Encoded.len != 11 ||
+      ((const uint8_t *)Encoded.ptr)[0] != 0xA4) {
+      return 5;
+   }
+
+   /* Duplicate with an entry added before the merge */
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_AddBoolToMap(&EC, "a", false);
+      QCBOREncode_MergeMaps(&EC, Maps, 1, QCBOR_MERGE_CHECK_DUPLICATES);
+   QCBOREncode_CloseMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_ERR_DUPLICATE_LABEL) {
+      return 6;
+   }
+
+   /* Merging into an indefinite-length map */
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMapIndefiniteLength(&EC);
+      QCBOREncode_MergeMaps(&EC, Maps, 1, QCBOR_MERGE_CHECK_DUPLICATES);
+   QCBOREncode_CloseMapIndefiniteLength(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Encoded,
+                        UsefulBuf_FROM_SZ_LITERAL("\xBF\x01\x02\x61\x61\xF5\xFF"))) {
+      return 7;
+   }
+
+   /* Not a map */
+   Maps[0] = UsefulBuf_FROM_SZ_LITERAL("\x82\x01\x02");
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_MergeMaps(&EC, Maps, 1, 0);
+   QCBOREncode_CloseMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_ERR_ENCODE_UNSUPPORTED) {
+      return 8;
+   }
+
+   /* Count of pairs larger than the bytes */
+   Maps[0] = UsefulBuf_FROM_SZ_LITERAL("\xB8\x20\x01\x02");
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+      QCBOREncode_MergeMaps(&EC, Maps, 1, 0);
+   QCBOREncode_CloseMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_ERR_HIT_END) {
+      return 9;
+   }
+
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
+   /* Merging into an array */
+   Maps[0] = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spMergeMap1);
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenArray(&EC);
+      QCBOREncode_MergeMaps(&EC, Maps, 1, 0);
+   QCBOREncode_CloseArray(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_ERR_ENCODE_UNSUPPORTED) {
+      return 10;
+   }
+#endif /* QCBOR_DISABLE_ENCODE_USAGE_GUARDS */
+
+   return 0;
+}
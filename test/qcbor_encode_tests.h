@@ -192,5 +192,19 @@ int32_t QCBORHeadTest(void);
 int32_t OpenCloseBytesTest(void);
 
 
+/*
+ Test QCBOREncode_CloseAndSortMap() which sorts map entries for
+ deterministic encoding.
+ */
+int32_t SortMapTest(void);
+
+
+/*
+ Test QCBOREncode_MergeMaps() which adds the entries of encoded maps
+ to the open map.
+ */
+int32_t MergeMapsTest(void);
+
+
 
 #endif /* defined(__QCBOR__qcbor_encode_tests__) */
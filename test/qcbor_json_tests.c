@@ -0,0 +1,326 @@
+/*==============================================================================
+ qcbor_json_tests.c -- tests for conversion of JSON to CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_json_tests.h"
+#include "qcbor/qcbor_json_encode.h"
+
+
+struct JSONTestCase {
+   const char    *szJSON;
+   uint32_t       uOptions;
+   const uint8_t *pExpected;
+   size_t         uExpectedLen;
+};
+
+#define JSON_TEST_CASE(szJSON, uOptions, pExpected) \
+   {szJSON, uOptions, pExpected, sizeof(pExpected)}
+
+
+static const uint8_t spExpectedObject[] = {
+   0xA3,
+      0x61, 0x61, 0x01,
+      0x61, 0x62, 0x83, 0xF5, 0xF4, 0xF6,
+      0x61, 0x63, 0x61, 0x78
+};
+
+static const uint8_t spExpectedEmpties[] = {
+   0x83, 0x80, 0xA0, 0x60
+};
+
+static const uint8_t spExpectedIntegers[] = {
+   0x88,
+      0x00,
+      0x20,
+      0x17,
+      0x18, 0x18,
+      0x39, 0x01, 0x00,
+      0x1B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0x3B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0x00
+};
+
+/* "a\"b\\c\/d\n\u00e9\ud83d\ude00" */
+static const uint8_t spExpectedEscapes[] = {
+   0x6E,
+      0x61, 0x22, 0x62, 0x5C, 0x63, 0x2F, 0x64, 0x0A,
+      0xC3, 0xA9,
+      0xF0, 0x9F, 0x98, 0x80
+};
+
+/* Long enough for the eight-at-a-time scan with an escape at the end */
+static const uint8_t spExpectedLongString[] = {
+   0x78, 0x1B,
+      'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
+      'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
+      '\t'
+};
+
+static const uint8_t spExpectedUnsorted[] = {
+   0xA3,
+      0x61, 0x62, 0x01,
+      0x61, 0x61, 0xA2,
+         0x61, 0x64, 0x02,
+         0x61, 0x63, 0x03,
+      0x62, 0x61, 0x61, 0x00
+};
+
+static const uint8_t spExpectedSorted[] = {
+   0xA3,
+      0x61, 0x61, 0xA2,
+         0x61, 0x63, 0x03,
+         0x61, 0x64, 0x02,
+      0x61, 0x62, 0x01,
+      0x62, 0x61, 0x61, 0x00
+};
+
+#if !defined(USEFULBUF_DISABLE_ALL_FLOAT) && \
+    !defined(QCBOR_DISABLE_FLOAT_HW_USE) && \
+    !defined(QCBOR_DISABLE_PREFERRED_FLOAT)
+static const uint8_t spExpectedFloats[] = {
+   0x89,
+      0xF9, 0x3E, 0x00,                   /* 1.5 */
+      0xF9, 0x80, 0x00,                   /* -0.0 */
+      0xF9, 0x56, 0x40,                   /* 1e2 */
+      0xFB, 0x3F, 0xB9, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9A, /* 0.1 */
+      0xF9, 0x3C, 0x00,                   /* 1.0 */
+      0xFA, 0x5F, 0x80, 0x00, 0x00,       /* 18446744073709551616 */
+      0xFB, 0x40, 0x09, 0x21, 0xFB, 0x54, 0x44, 0x2D, 0x18, /* pi */
+      0xFA, 0xDF, 0x00, 0x00, 0x00,       /* -9223372036854775809 */
+      0xFB, 0x4B, 0xFF, 0x77, 0x7D, 0x05, 0x89, 0x93, 0xBC  /* 12.345E+57 */
+};
+
+/* Numbers that need the big integer conversion */
+static const uint8_t spExpectedExactFloats[] = {
+   0x85,
+      0xFB, 0x7F, 0xEF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, /* largest */
+      0xF9, 0x7C, 0x00,                   /* 1e400 is infinity */
+      0xFA, 0x5A, 0x00, 0x00, 0x00,       /* tie rounds to even 2^53 */
+      0xFB, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* smallest normal */
+      0xF9, 0x80, 0x00                    /* -1e-400 is -0.0 */
+};
+#endif
+
+
+static const struct JSONTestCase sJSONTestCases[] = {
+   JSON_TEST_CASE("{\"a\": 1, \"b\": [true, false, null], \"c\": \"x\"}",
+                  0,
+                  spExpectedObject),
+   JSON_TEST_CASE(" \t\r\n[ [ ] ,{}, \"\" ] \n",
+                  0,
+                  spExpectedEmpties),
+   JSON_TEST_CASE("[0,-1,23,24,-257,18446744073709551615,"
+                  "-9223372036854775808,-0]",
+                  0,
+                  spExpectedIntegers),
+   JSON_TEST_CASE("\"a\\\"b\\\\c\\/d\\n\\u00e9\\ud83d\\ude00\"",
+                  0,
+                  spExpectedEscapes),
+   JSON_TEST_CASE("\"abcdefghijklmnopqrstuvwxyz\\u0009\"",
+                  0,
+                  spExpectedLongString),
+   JSON_TEST_CASE("{\"b\": 1, \"a\": {\"d\": 2, \"c\": 3}, \"aa\": 0}",
+                  0,
+                  spExpectedUnsorted),
+   JSON_TEST_CASE("{\"b\": 1, \"a\": {\"d\": 2, \"c\": 3}, \"aa\": 0}",
+                  QCBOR_JSON_SORT_MAPS,
+                  spExpectedSorted),
+#if !defined(USEFULBUF_DISABLE_ALL_FLOAT) && \
+    !defined(QCBOR_DISABLE_FLOAT_HW_USE) && \
+    !defined(QCBOR_DISABLE_PREFERRED_FLOAT)
+   JSON_TEST_CASE("[1.5, -0.0, 1e2, 0.1, 1.0, 18446744073709551616,"
+                  " 3.14159265358979323846264338327950288,"
+                  " -9223372036854775809, 12.345E+57]",
+                  0,
+                  spExpectedFloats),
+   JSON_TEST_CASE("[1.7976931348623157e308, 1e400, 9007199254740993.0,"
+                  " 2.2250738585072014e-308, -1e-400]",
+                  0,
+                  spExpectedExactFloats),
+#endif
+   {NULL, 0, NULL, 0}
+};
+
+
+int32_t JSONToCBORTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(           TestBuf, 200);
+   QCBOREncodeContext                 EC;
+   UsefulBufC                         Encoded;
+   QCBORError                         uErr;
+   size_t                             uSize;
+   const struct JSONTestCase         *pTest;
+   int32_t                            nIndex;
+
+   for(pTest = sJSONTestCases, nIndex = 0; pTest->szJSON; pTest++, nIndex++) {
+      const UsefulBufC JSON = UsefulBuf_FromSZ(pTest->szJSON);
+      const UsefulBufC Expected = {pTest->pExpected, pTest->uExpectedLen};
+
+      QCBOREncode_Init(&EC, TestBuf);
+      QCBOREncode_AddJSON(&EC, JSON, pTest->uOptions);
+      uErr = QCBOREncode_Finish(&EC, &Encoded);
+      if(uErr != QCBOR_SUCCESS) {
+         return nIndex * 10 + 1;
+      }
+      if(UsefulBuf_Compare(Encoded, Expected)) {
+         return nIndex * 10 + 2;
+      }
+
+      /* The size calculation must give the same size */
+      QCBOREncode_Init(&EC, SizeCalculateUsefulBuf);
+      QCBOREncode_AddJSON(&EC, JSON, pTest->uOptions);
+      uErr = QCBOREncode_FinishGetSize(&EC, &uSize);
+      if(uErr != QCBOR_SUCCESS || uSize != Expected.len) {
+         return nIndex * 10 + 3;
+      }
+   }
+
+   /* Added as a map value, more than once */
+   static const uint8_t spExpectedInMap[] = {
+      0xA2, 0x61, 0x6A, 0x81, 0x01, 0x61, 0x6B, 0x02
+   };
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_OpenMap(&EC);
+   QCBOREncode_AddSZString(&EC, "j");
+   QCBOREncode_AddJSON(&EC, UsefulBuf_FROM_SZ_LITERAL("[1]"), 0);
+   QCBOREncode_AddSZString(&EC, "k");
+   QCBOREncode_AddJSON(&EC, UsefulBuf_FROM_SZ_LITERAL("2"), 0);
+   QCBOREncode_CloseMap(&EC);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Encoded, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spExpectedInMap))) {
+      return 1000;
+   }
+
+   /* Nesting right up to the limit */
+   char szDeep[QCBOR_MAX_ARRAY_NESTING * 2 + 1];
+   for(nIndex = 0; nIndex < QCBOR_MAX_ARRAY_NESTING; nIndex++) {
+      szDeep[nIndex] = '[';
+      szDeep[QCBOR_MAX_ARRAY_NESTING + nIndex] = ']';
+   }
+   szDeep[QCBOR_MAX_ARRAY_NESTING * 2] = '\0';
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_AddJSON(&EC, UsefulBuf_FromSZ(szDeep), 0);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_SUCCESS || Encoded.len != QCBOR_MAX_ARRAY_NESTING) {
+      return 1001;
+   }
+
+   return 0;
+}
+
+
+struct JSONErrorTestCase {
+   const char *szJSON;
+   QCBORError  uExpectedErr;
+};
+
+static const struct JSONErrorTestCase sJSONErrorTestCases[] = {
+   {"",                 QCBOR_ERR_JSON_SYNTAX},
+   {"   ",              QCBOR_ERR_JSON_SYNTAX},
+   {"[",                QCBOR_ERR_JSON_SYNTAX},
+   {"]",                QCBOR_ERR_JSON_SYNTAX},
+   {"[}",               QCBOR_ERR_JSON_SYNTAX},
+   {"{]",               QCBOR_ERR_JSON_SYNTAX},
+   {"[1,]",             QCBOR_ERR_JSON_SYNTAX},
+   {"[1 2]",            QCBOR_ERR_JSON_SYNTAX},
+   {"[,1]",             QCBOR_ERR_JSON_SYNTAX},
+   {"{\"a\"}",          QCBOR_ERR_JSON_SYNTAX},
+   {"{\"a\":}",         QCBOR_ERR_JSON_SYNTAX},
+   {"{\"a\":1,}",       QCBOR_ERR_JSON_SYNTAX},
+   {"{\"a\" 1}",        QCBOR_ERR_JSON_SYNTAX},
+   {"{1:2}",            QCBOR_ERR_JSON_SYNTAX},
+   {"1 2",              QCBOR_ERR_JSON_SYNTAX},
+   {"01",               QCBOR_ERR_JSON_SYNTAX},
+   {"-",                QCBOR_ERR_JSON_SYNTAX},
+   {"+1",               QCBOR_ERR_JSON_SYNTAX},
+   {"1.",               QCBOR_ERR_JSON_SYNTAX},
+   {".5",               QCBOR_ERR_JSON_SYNTAX},
+   {"1e",               QCBOR_ERR_JSON_SYNTAX},
+   {"1e+",              QCBOR_ERR_JSON_SYNTAX},
+   {"tru",              QCBOR_ERR_JSON_SYNTAX},
+   {"nul",              QCBOR_ERR_JSON_SYNTAX},
+   {"True",             QCBOR_ERR_JSON_SYNTAX},
+   {"\"abc",            QCBOR_ERR_JSON_SYNTAX},
+   {"\"abc\\",          QCBOR_ERR_JSON_SYNTAX},
+   {"\"\\x\"",          QCBOR_ERR_JSON_SYNTAX},
+   {"\"\\u12\"",        QCBOR_ERR_JSON_SYNTAX},
+   {"\"\\u12G4\"",      QCBOR_ERR_JSON_SYNTAX},
+   {"\"\\ud800\"",      QCBOR_ERR_JSON_SYNTAX},
+   {"\"\\ud800\\u0041\"", QCBOR_ERR_JSON_SYNTAX},
+   {"\"\\udc00\"",      QCBOR_ERR_JSON_SYNTAX},
+   {"\"a\tb\"",         QCBOR_ERR_JSON_SYNTAX},
+   {"\"abcdefghijk\nlmnopq\"", QCBOR_ERR_JSON_SYNTAX},
+   {"[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]", QCBOR_ERR_ARRAY_NESTING_TOO_DEEP},
+#ifdef USEFULBUF_DISABLE_ALL_FLOAT
+   {"1.5",              QCBOR_ERR_ALL_FLOAT_DISABLED},
+#elif defined(QCBOR_DISABLE_FLOAT_HW_USE)
+   {"1.5",              QCBOR_ERR_HW_FLOAT_DISABLED},
+#else
+   {"1.00000000000000000000000000000000000000000000000000000000000000000"
+     "000000000000000000000000000000000000000000000000000000000000000001",
+                        QCBOR_ERR_ENCODE_UNSUPPORTED},
+#endif
+   {NULL,               QCBOR_SUCCESS}
+};
+
+
+int32_t JSONToCBORErrorTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(                TestBuf, 100);
+   QCBOREncodeContext                      EC;
+   UsefulBufC                              Encoded;
+   QCBORError                              uErr;
+   const struct JSONErrorTestCase         *pTest;
+   int32_t                                 nIndex;
+
+   for(pTest = sJSONErrorTestCases, nIndex = 0; pTest->szJSON; pTest++, nIndex++) {
+      QCBOREncode_Init(&EC, TestBuf);
+      QCBOREncode_AddJSON(&EC, UsefulBuf_FromSZ(pTest->szJSON), 0);
+      uErr = QCBOREncode_GetErrorState(&EC);
+      if(uErr != pTest->uExpectedErr) {
+         return nIndex * 10 + 1;
+      }
+   }
+
+   /* Output buffer too small for a string with no escapes */
+   UsefulBuf_MAKE_STACK_UB(SmallBuf, 5);
+   QCBOREncode_Init(&EC, SmallBuf);
+   QCBOREncode_AddJSON(&EC, UsefulBuf_FROM_SZ_LITERAL("\"abcdef\""), 0);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 1000;
+   }
+
+   /* Output buffer too small for a string with escapes */
+   QCBOREncode_Init(&EC, SmallBuf);
+   QCBOREncode_AddJSON(&EC, UsefulBuf_FROM_SZ_LITERAL("\"abc\\ndef\""), 0);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 1001;
+   }
+
+   /* Encoder already in error state is left alone */
+   QCBOREncode_Init(&EC, TestBuf);
+   QCBOREncode_CloseArray(&EC);
+   QCBOREncode_AddJSON(&EC, UsefulBuf_FROM_SZ_LITERAL("[1"), 0);
+   uErr = QCBOREncode_Finish(&EC, &Encoded);
+#ifndef QCBOR_DISABLE_ENCODE_USAGE_GUARDS
+   if(uErr != QCBOR_ERR_TOO_MANY_CLOSES) {
+      return 1002;
+   }
+#else
+   if(uErr != QCBOR_ERR_JSON_SYNTAX) {
+      return 1003;
+   }
+#endif /* QCBOR_DISABLE_ENCODE_USAGE_GUARDS */
+
+   return 0;
+}
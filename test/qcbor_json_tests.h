@@ -0,0 +1,32 @@
+/*==============================================================================
+ qcbor_json_tests.h -- tests for conversion of JSON to CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_json_tests_h
+#define qcbor_json_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Converts a set of JSON documents to CBOR and compares the results to
+ the expected encoding. Covers all JSON types, string escapes, number
+ conversion and map sorting.
+ */
+int32_t JSONToCBORTest(void);
+
+
+/*
+ Checks that invalid JSON and JSON that can't be converted give the
+ expected errors.
+ */
+int32_t JSONToCBORErrorTest(void);
+
+
+#endif /* qcbor_json_tests_h */
@@ -0,0 +1,343 @@
+/*==============================================================================
+ qcbor_packed_tests.c -- tests for packing and unpacking of Packed CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_packed_tests.h"
+#include "qcbor/qcbor_packed.h"
+#include "qcbor/qcbor_encode.h"
+
+
+#define PACKED_TEST_NUM_READINGS 8
+
+
+/*
+ An array of readings like {"name": "temperature", "unit": "celsius",
+ "href": "coap://sensors.example.com/r/N", "v": N}.
+ */
+static UsefulBufC
+EncodePackedTestReadings(UsefulBuf Buffer)
+{
+   QCBOREncodeContext ECtx;
+   UsefulBufC         Encoded;
+   int                nReading;
+   char               szHref[40];
+
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenArray(&ECtx);
+   for(nReading = 0; nReading < PACKED_TEST_NUM_READINGS; nReading++) {
+      memcpy(szHref, "coap://sensors.example.com/r/", 30);
+      szHref[29] = (char)('0' + nReading);
+      szHref[30] = '\0';
+      QCBOREncode_OpenMap(&ECtx);
+      QCBOREncode_AddSZStringToMap(&ECtx, "name", "temperature");
+      QCBOREncode_AddSZStringToMap(&ECtx, "unit", "celsius");
+      QCBOREncode_AddSZStringToMap(&ECtx, "href", szHref);
+      QCBOREncode_AddInt64ToMap(&ECtx, "v", nReading * 1000);
+      QCBOREncode_CloseMap(&ECtx);
+   }
+   QCBOREncode_CloseArray(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_SUCCESS) {
+      return NULLUsefulBufC;
+   }
+
+   return Encoded;
+}
+
+
+int32_t PackedRoundTripTest(void)
+{
+   UsefulBufC Encoded;
+   UsefulBufC Packed;
+   UsefulBufC Unpacked;
+   UsefulBufC SizeOnly;
+   QCBORError uErr;
+   UsefulBufC aPrefixes[QCBOR_PACKED_MAX_ARGUMENTS + 1];
+   size_t     uIndex;
+
+   UsefulBuf_MAKE_STACK_UB(EncodeBuffer, 600);
+   UsefulBuf_MAKE_STACK_UB(PackBuffer, 600);
+   UsefulBuf_MAKE_STACK_UB(UnpackBuffer, 600);
+
+   Encoded = EncodePackedTestReadings(EncodeBuffer);
+   if(UsefulBuf_IsNULLC(Encoded)) {
+      return 1;
+   }
+
+   /* Repeated strings only */
+   uErr = QCBORPacked_Pack(Encoded, NULL, 0, PackBuffer, &Packed);
+   if(uErr != QCBOR_SUCCESS) {
+      return 10;
+   }
+   if(Packed.len >= Encoded.len) {
+      return 11;
+   }
+   uErr = QCBORPacked_Unpack(Packed, UnpackBuffer, &Unpacked);
+   if(uErr != QCBOR_SUCCESS) {
+      return 12;
+   }
+   if(UsefulBuf_Compare(Unpacked, Encoded)) {
+      return 13;
+   }
+
+   /* With a prefix for the URIs it is smaller still */
+   aPrefixes[0] = UsefulBuf_FROM_SZ_LITERAL("coap://");
+   aPrefixes[1] = UsefulBuf_FROM_SZ_LITERAL("coap://sensors.example.com/r/");
+   aPrefixes[2] = UsefulBuf_FROM_SZ_LITERAL("http://");
+   uErr = QCBORPacked_Pack(Encoded, aPrefixes, 3, PackBuffer, &SizeOnly);
+   if(uErr != QCBOR_SUCCESS) {
+      return 20;
+   }
+   if(SizeOnly.len >= Packed.len) {
+      return 21;
+   }
+   Packed = SizeOnly;
+   uErr = QCBORPacked_Unpack(Packed, UnpackBuffer, &Unpacked);
+   if(uErr != QCBOR_SUCCESS) {
+      return 22;
+   }
+   if(UsefulBuf_Compare(Unpacked, Encoded)) {
+      return 23;
+   }
+
+   /* Computing the sizes */
+   uErr = QCBORPacked_Pack(Encoded, aPrefixes, 3, (UsefulBuf){NULL, SIZE_MAX}, &SizeOnly);
+   if(uErr != QCBOR_SUCCESS || SizeOnly.len != Packed.len) {
+      return 30;
+   }
+   uErr = QCBORPacked_Unpack(Packed, (UsefulBuf){NULL, SIZE_MAX}, &SizeOnly);
+   if(uErr != QCBOR_SUCCESS || SizeOnly.len != Encoded.len) {
+      return 31;
+   }
+
+   /* Buffers too small */
+   uErr = QCBORPacked_Pack(Encoded, aPrefixes, 3, (UsefulBuf){PackBuffer.ptr, Packed.len - 1}, &SizeOnly);
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 40;
+   }
+   uErr = QCBORPacked_Unpack(Packed, (UsefulBuf){UnpackBuffer.ptr, Encoded.len - 1}, &SizeOnly);
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 41;
+   }
+
+   /* Nothing repeated still gives tag 113 */
+   static const uint8_t spNothing[] = {0x82, 0x01, 0x61, 0x61};
+   static const uint8_t spNothingPacked[] = {0xd8, 0x71, 0x83, 0x80, 0x80, 0x82, 0x01, 0x61, 0x61};
+   uErr = QCBORPacked_Pack(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNothing), NULL, 0, PackBuffer, &Packed);
+   if(uErr != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Packed, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spNothingPacked))) {
+      return 50;
+   }
+
+   /* Input that can't be packed */
+   static const uint8_t spSimple0[] = {0x81, 0xe0};
+   uErr = QCBORPacked_Pack(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSimple0), NULL, 0, PackBuffer, &Packed);
+   if(uErr != QCBOR_ERR_ENCODE_UNSUPPORTED) {
+      return 60;
+   }
+   static const uint8_t spTag6[] = {0xc6, 0x00};
+   uErr = QCBORPacked_Pack(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTag6), NULL, 0, PackBuffer, &Packed);
+   if(uErr != QCBOR_ERR_ENCODE_UNSUPPORTED) {
+      return 61;
+   }
+   static const uint8_t spTag224[] = {0xd8, 0xe0, 0x60};
+   uErr = QCBORPacked_Pack(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTag224), NULL, 0, PackBuffer, &Packed);
+   if(uErr != QCBOR_ERR_ENCODE_UNSUPPORTED) {
+      return 62;
+   }
+   static const uint8_t spIndefinite[] = {0x9f, 0xff};
+   uErr = QCBORPacked_Pack(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefinite), NULL, 0, PackBuffer, &Packed);
+   if(uErr != QCBOR_ERR_ENCODE_UNSUPPORTED) {
+      return 63;
+   }
+   static const uint8_t spTwoItems[] = {0x01, 0x02};
+   uErr = QCBORPacked_Pack(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTwoItems), NULL, 0, PackBuffer, &Packed);
+   if(uErr != QCBOR_ERR_EXTRA_BYTES) {
+      return 64;
+   }
+   static const uint8_t spTruncated[] = {0x82, 0x63, 0x61};
+   uErr = QCBORPacked_Pack(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spTruncated), NULL, 0, PackBuffer, &Packed);
+   if(uErr != QCBOR_ERR_HIT_END) {
+      return 65;
+   }
+   for(uIndex = 0; uIndex < QCBOR_PACKED_MAX_ARGUMENTS + 1; uIndex++) {
+      aPrefixes[uIndex] = UsefulBuf_FROM_SZ_LITERAL("x");
+   }
+   uErr = QCBORPacked_Pack(Encoded, aPrefixes, QCBOR_PACKED_MAX_ARGUMENTS + 1, PackBuffer, &Packed);
+   if(uErr != QCBOR_ERR_ARRAY_TOO_LONG) {
+      return 66;
+   }
+
+   return 0;
+}
+
+
+struct PackedUnpackErrorTest {
+   UsefulBufC Packed;
+   QCBORError uExpectedErr;
+};
+
+
+int32_t PackedUnpackTest(void)
+{
+   QCBOREncodeContext ECtx;
+   UsefulBufC         Packed;
+   UsefulBufC         Expected;
+   UsefulBufC         Unpacked;
+   QCBORError         uErr;
+   int                nItem;
+   char               szItem[4];
+   size_t             uIndex;
+
+   UsefulBuf_MAKE_STACK_UB(PackBuffer, 200);
+   UsefulBuf_MAKE_STACK_UB(ExpectBuffer, 100);
+   UsefulBuf_MAKE_STACK_UB(UnpackBuffer, 100);
+
+   /* 113([["s0", [simple(0)], "s2", ... "s17"],
+    *      ["http://"],
+    *      [simple(1), 6(0), 6(-1), 224("abc"), 2]])
+    */
+   QCBOREncode_Init(&ECtx, PackBuffer);
+   QCBOREncode_AddTag(&ECtx, 113);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_OpenArray(&ECtx);
+   for(nItem = 0; nItem < 18; nItem++) {
+      if(nItem == 1) {
+         QCBOREncode_AddEncoded(&ECtx, UsefulBuf_FROM_SZ_LITERAL("\x81\xe0"));
+         continue;
+      }
+      szItem[0] = 's';
+      if(nItem < 10) {
+         szItem[1] = (char)('0' + nItem);
+         szItem[2] = '\0';
+      } else {
+         szItem[1] = (char)('0' + nItem / 10);
+         szItem[2] = (char)('0' + nItem % 10);
+         szItem[3] = '\0';
+      }
+      QCBOREncode_AddSZString(&ECtx, szItem);
+   }
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_AddSZString(&ECtx, "http://");
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_AddEncoded(&ECtx, UsefulBuf_FROM_SZ_LITERAL("\xe1"));
+   QCBOREncode_AddEncoded(&ECtx, UsefulBuf_FROM_SZ_LITERAL("\xc6\x00"));
+   QCBOREncode_AddEncoded(&ECtx, UsefulBuf_FROM_SZ_LITERAL("\xc6\x20"));
+   QCBOREncode_AddEncoded(&ECtx, UsefulBuf_FROM_SZ_LITERAL("\xd8\xe0\x63" "abc"));
+   QCBOREncode_AddInt64(&ECtx, 2);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_CloseArray(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Packed) != QCBOR_SUCCESS) {
+      return 1;
+   }
+
+   QCBOREncode_Init(&ECtx, ExpectBuffer);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_AddSZString(&ECtx, "s0");
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddSZString(&ECtx, "s16");
+   QCBOREncode_AddSZString(&ECtx, "s17");
+   QCBOREncode_AddSZString(&ECtx, "http://abc");
+   QCBOREncode_AddInt64(&ECtx, 2);
+   QCBOREncode_CloseArray(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Expected) != QCBOR_SUCCESS) {
+      return 2;
+   }
+
+   uErr = QCBORPacked_Unpack(Packed, UnpackBuffer, &Unpacked);
+   if(uErr != QCBOR_SUCCESS) {
+      return 10;
+   }
+   if(UsefulBuf_Compare(Unpacked, Expected)) {
+      return 11;
+   }
+
+   /* Not packed is copied */
+   uErr = QCBORPacked_Unpack(Expected, UnpackBuffer, &Unpacked);
+   if(uErr != QCBOR_SUCCESS || UsefulBuf_Compare(Unpacked, Expected)) {
+      return 20;
+   }
+
+   /* A shared item table with one more item than allowed */
+   uint8_t *pTooMany = PackBuffer.ptr;
+   pTooMany[0] = 0xd8;
+   pTooMany[1] = 0x71;
+   pTooMany[2] = 0x83;
+   pTooMany[3] = 0x98;
+   pTooMany[4] = QCBOR_PACKED_MAX_SHARED + 1;
+   memset(pTooMany + 5, 0, QCBOR_PACKED_MAX_SHARED + 1);
+   pTooMany[QCBOR_PACKED_MAX_SHARED + 6] = 0x80;
+   pTooMany[QCBOR_PACKED_MAX_SHARED + 7] = 0x00;
+
+   const struct PackedUnpackErrorTest aErrorTests[] = {
+      /* Shared item that refers to itself */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x81\xe0\x80\xe0"), QCBOR_ERR_BAD_TAG_CONTENT},
+      /* Shared items that refer to each other */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x82\xe1\xe0\x80\xe0"), QCBOR_ERR_BAD_TAG_CONTENT},
+      /* Reference to a shared item that isn't there */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x80\x80\xe0"), QCBOR_ERR_BAD_TAG_CONTENT},
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x80\x80\xc6\x01"), QCBOR_ERR_BAD_TAG_CONTENT},
+      /* Tag 6 with content that is not an integer */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x81\x01\x80\xc6\x40"), QCBOR_ERR_BAD_TAG_CONTENT},
+      /* Reference to an argument item that isn't there */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x80\x80\xd8\xe0\x60"), QCBOR_ERR_BAD_TAG_CONTENT},
+      /* Prefix and string of different types */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x80\x81\x61\x61\xd8\xe0\x41\x62"), QCBOR_ERR_BAD_TAG_CONTENT},
+      /* Argument item that is not a string */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x80\x81\x01\xd8\xe0\x61\x62"), QCBOR_ERR_BAD_TAG_CONTENT},
+      /* Tag content not an array of three */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x82\x80\x80"), QCBOR_ERR_BAD_TAG_CONTENT},
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\xa0\x80\x00"), QCBOR_ERR_BAD_TAG_CONTENT},
+      /* Too many shared items */
+      {(UsefulBufC){PackBuffer.ptr, QCBOR_PACKED_MAX_SHARED + 8}, QCBOR_ERR_ARRAY_DECODE_TOO_LONG},
+      /* More after the packed item */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x80\x80\x01\x02"), QCBOR_ERR_EXTRA_BYTES},
+      /* Truncated */
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x80\x80\x82\x01"), QCBOR_ERR_HIT_END},
+      {UsefulBuf_FROM_SZ_LITERAL("\xd8\x71\x83\x80\x81\x61\x61\xd8\xe0\x63\x62"), QCBOR_ERR_HIT_END},
+   };
+
+   for(uIndex = 0; uIndex < sizeof(aErrorTests)/sizeof(aErrorTests[0]); uIndex++) {
+      uErr = QCBORPacked_Unpack(aErrorTests[uIndex].Packed, UnpackBuffer, &Unpacked);
+      if(uErr != aErrorTests[uIndex].uExpectedErr) {
+         return (int32_t)(100 + uIndex);
+      }
+   }
+
+   /* Shared item n is an array of 16 references to shared item n + 1
+    * so a one-byte rump expands to 16^7 items */
+   uint8_t *pBomb = PackBuffer.ptr;
+   size_t   uBombLen = 0;
+   pBomb[uBombLen++] = 0xd8;
+   pBomb[uBombLen++] = 0x71;
+   pBomb[uBombLen++] = 0x83;
+   pBomb[uBombLen++] = 0x88;
+   for(nItem = 1; nItem < 8; nItem++) {
+      pBomb[uBombLen++] = 0x90;
+      memset(pBomb + uBombLen, 0xe0 + nItem, 16);
+      uBombLen += 16;
+   }
+   pBomb[uBombLen++] = 0x00;
+   pBomb[uBombLen++] = 0x80;
+   pBomb[uBombLen++] = 0xe0;
+
+   uErr = QCBORPacked_Unpack((UsefulBufC){pBomb, uBombLen}, UnpackBuffer, &Unpacked);
+   if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 200;
+   }
+   uErr = QCBORPacked_Unpack((UsefulBufC){pBomb, uBombLen}, (UsefulBuf){NULL, SIZE_MAX}, &Unpacked);
+   if(uErr != QCBOR_ERR_INPUT_TOO_LARGE) {
+      return 201;
+   }
+
+   return 0;
+}
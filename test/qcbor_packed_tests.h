@@ -0,0 +1,34 @@
+/*==============================================================================
+ qcbor_packed_tests.h -- tests for packing and unpacking of Packed CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_packed_tests_h
+#define qcbor_packed_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Packs a document with repeated labels, values and URIs, checks it is
+ smaller and unpacks to the same bytes, and checks input that can't be
+ packed.
+ */
+int32_t PackedRoundTripTest(void);
+
+
+/*
+ Unpacks hand-made Packed CBOR with all the kinds of reference and
+ references in shared items, and checks references that loop or are
+ out of range, tables that are not well-formed and references that
+ expand to too much.
+ */
+int32_t PackedUnpackTest(void);
+
+
+#endif /* qcbor_packed_tests_h */
@@ -0,0 +1,331 @@
+/*==============================================================================
+ qcbor_path_tests.c -- tests for getting items by path expressions
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_path_tests.h"
+#include "qcbor/qcbor_path.h"
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_spiffy_decode.h"
+#include <string.h> /* For memset() */
+
+
+static const char *aszBadPaths[] = {
+   "a..b",
+   "a.",
+   ".",
+   "a[",
+   "a[]",
+   "a[-1]",
+   "a[x]",
+   "a b",
+   "[*]x",
+   ".\"unterminated",
+   "a.b$",
+};
+
+
+int32_t PathCompileTest(void)
+{
+   QCBORPathStep aSteps[40];
+   QCBORPathSet  Set;
+   const char   *aszPaths[QCBOR_PATH_MAX_PATHS + 1];
+   size_t        uIndex;
+
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(aszBadPaths, aszBadPaths[0]); uIndex++) {
+      if(QCBORPath_Compile(&aszBadPaths[uIndex], 1, aSteps, 40, &Set) != QCBOR_ERR_PATH_SYNTAX) {
+         return (int32_t)(1 + uIndex);
+      }
+   }
+
+   static const char *aszGood[] = {
+      "", "a", ".a", "*", "[0][1]", ".-5.\"x y\"[*].*", "a-b_c.9"
+   };
+   if(QCBORPath_Compile(aszGood, C_ARRAY_COUNT(aszGood, aszGood[0]), aSteps, 40, &Set)) {
+      return 20;
+   }
+
+   /* Exactly enough storage and one short */
+   if(QCBORPath_Compile(aszGood, C_ARRAY_COUNT(aszGood, aszGood[0]), aSteps, 11, &Set)) {
+      return 21;
+   }
+   if(QCBORPath_Compile(aszGood, C_ARRAY_COUNT(aszGood, aszGood[0]), aSteps, 10, &Set) != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 22;
+   }
+
+   for(uIndex = 0; uIndex < C_ARRAY_COUNT(aszPaths, aszPaths[0]); uIndex++) {
+      aszPaths[uIndex] = "a";
+   }
+   if(QCBORPath_Compile(aszPaths, QCBOR_PATH_MAX_PATHS + 1, aSteps, 40, &Set) != QCBOR_ERR_ARRAY_TOO_LONG) {
+      return 23;
+   }
+   if(QCBORPath_Compile(aszPaths, QCBOR_PATH_MAX_PATHS, aSteps, 40, &Set)) {
+      return 24;
+   }
+
+   aszPaths[0] = "a.a.a.a.a.a.a.a.a.a.a.a.a.a.a";
+   if(QCBORPath_Compile(aszPaths, 1, aSteps, 40, &Set)) {
+      return 25;
+   }
+   aszPaths[0] = "a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a";
+   if(QCBORPath_Compile(aszPaths, 1, aSteps, 40, &Set) != QCBOR_ERR_ARRAY_NESTING_TOO_DEEP) {
+      return 26;
+   }
+
+   return 0;
+}
+
+
+struct PathTestCallbackCtx {
+   int     nCalls;
+   int     nFailAt;
+   size_t  auPath[8];
+   int64_t anValue[8];
+};
+
+
+static QCBORError
+PathTestCallback(void *pCallbackCtx, size_t uPathIndex, const QCBORItem *pItem)
+{
+   struct PathTestCallbackCtx *pCtx = (struct PathTestCallbackCtx *)pCallbackCtx;
+
+   if(pCtx->nCalls == pCtx->nFailAt) {
+      return QCBOR_ERR_CALLBACK_FAIL;
+   }
+   if(pCtx->nCalls < 8) {
+      pCtx->auPath[pCtx->nCalls]  = uPathIndex;
+      pCtx->anValue[pCtx->nCalls] = pItem->uDataType == QCBOR_TYPE_INT64 ? pItem->val.int64 : -1;
+   }
+   pCtx->nCalls++;
+   return QCBOR_SUCCESS;
+}
+
+
+/* Indexes of the paths in aszGetPaths */
+enum {
+   PATH_DEEP, PATH_INT_LABEL, PATH_QUOTED, PATH_IDS, PATH_ARRAY,
+   PATH_ROOT, PATH_MISSING, PATH_BAD_INDEX, PATH_WILD_LABEL, PATH_NUM
+};
+
+static const char *aszGetPaths[] = {
+   "a.b[3].c",
+   ".1",
+   ".\"odd key\"",
+   "list[*].id",
+   "a.b",
+   "",
+   "a.nothere",
+   "a.b[9]",
+   "a.*",
+};
+
+
+int32_t PathGetTest(void)
+{
+   QCBOREncodeContext         ECtx;
+   QCBORDecodeContext         DCtx;
+   QCBORPathStep              aSteps[20];
+   QCBORPathSet               Set;
+   QCBORItem                  aItems[PATH_NUM];
+   UsefulBufC                 Encoded;
+   int64_t                    nInt;
+   int                        nId;
+   struct PathTestCallbackCtx CbCtx;
+   UsefulBuf_MAKE_STACK_UB(   Buffer, 300);
+
+   if(QCBORPath_Compile(aszGetPaths, PATH_NUM, aSteps, 20, &Set)) {
+      return 1;
+   }
+
+   /* {"skip": {"big": [1, 2, [3, 4]]},
+    *  "a": {"b": [10, 11, 12, {"c": "deep"}], "x": 1},
+    *  1: "int label",
+    *  "odd key": true,
+    *  "list": [{"id": 1}, {"id": 2}, {"name": "none"}, {"id": 3}]}
+    * followed by 99 in a CBOR sequence */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_OpenMapInMap(&ECtx, "skip");
+   QCBOREncode_OpenArrayInMap(&ECtx, "big");
+   QCBOREncode_AddInt64(&ECtx, 1);
+   QCBOREncode_AddInt64(&ECtx, 2);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_AddInt64(&ECtx, 3);
+   QCBOREncode_AddInt64(&ECtx, 4);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_OpenMapInMap(&ECtx, "a");
+   QCBOREncode_OpenArrayInMap(&ECtx, "b");
+   QCBOREncode_AddInt64(&ECtx, 10);
+   QCBOREncode_AddInt64(&ECtx, 11);
+   QCBOREncode_AddInt64(&ECtx, 12);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddSZStringToMap(&ECtx, "c", "deep");
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddInt64ToMap(&ECtx, "x", 1);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddSZStringToMapN(&ECtx, 1, "int label");
+   QCBOREncode_AddBoolToMap(&ECtx, "odd key", true);
+   QCBOREncode_OpenArrayInMap(&ECtx, "list");
+   for(nId = 1; nId <= 3; nId++) {
+      QCBOREncode_OpenMap(&ECtx);
+      QCBOREncode_AddInt64ToMap(&ECtx, "id", nId);
+      QCBOREncode_CloseMap(&ECtx);
+      if(nId == 2) {
+         QCBOREncode_OpenMap(&ECtx);
+         QCBOREncode_AddSZStringToMap(&ECtx, "name", "none");
+         QCBOREncode_CloseMap(&ECtx);
+      }
+   }
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddInt64(&ECtx, 99);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 2;
+   }
+
+   memset(&CbCtx, 0, sizeof(CbCtx));
+   CbCtx.nFailAt = -1;
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetPaths(&DCtx, &Set, aItems, &CbCtx, PathTestCallback);
+   if(QCBORDecode_GetError(&DCtx)) {
+      return 3;
+   }
+
+   if(aItems[PATH_DEEP].uDataType != QCBOR_TYPE_TEXT_STRING ||
+      UsefulBuf_Compare(aItems[PATH_DEEP].val.string, UsefulBuf_FROM_SZ_LITERAL("deep"))) {
+      return 10;
+   }
+   if(aItems[PATH_INT_LABEL].uDataType != QCBOR_TYPE_TEXT_STRING ||
+      aItems[PATH_INT_LABEL].label.int64 != 1) {
+      return 11;
+   }
+   if(aItems[PATH_QUOTED].uDataType != QCBOR_TYPE_TRUE) {
+      return 12;
+   }
+   if(aItems[PATH_IDS].uDataType != QCBOR_TYPE_INT64 ||
+      aItems[PATH_IDS].val.int64 != 1) {
+      return 13;
+   }
+   if(aItems[PATH_ARRAY].uDataType != QCBOR_TYPE_ARRAY ||
+      aItems[PATH_ARRAY].val.uCount != 4) {
+      return 14;
+   }
+   if(aItems[PATH_ROOT].uDataType != QCBOR_TYPE_MAP ||
+      aItems[PATH_ROOT].val.uCount != 5) {
+      return 15;
+   }
+   if(aItems[PATH_MISSING].uDataType != QCBOR_TYPE_NONE ||
+      aItems[PATH_BAD_INDEX].uDataType != QCBOR_TYPE_NONE) {
+      return 16;
+   }
+   if(aItems[PATH_WILD_LABEL].uDataType != QCBOR_TYPE_ARRAY) {
+      return 17;
+   }
+
+   /* The root, then a.* for b, a.b, a.* for x, then the three ids */
+   static const size_t auExpectedPath[] = {
+      PATH_ROOT, PATH_ARRAY, PATH_WILD_LABEL, PATH_DEEP, PATH_WILD_LABEL,
+      PATH_INT_LABEL, PATH_QUOTED, PATH_IDS
+   };
+   if(CbCtx.nCalls != 10) {
+      return 20;
+   }
+   for(nId = 0; nId < 8; nId++) {
+      if(CbCtx.auPath[nId] != auExpectedPath[nId]) {
+         return 21 + nId;
+      }
+   }
+   if(CbCtx.anValue[4] != 1 || CbCtx.anValue[7] != 1) {
+      return 30;
+   }
+
+   /* Positioned after the document */
+   QCBORDecode_GetInt64(&DCtx, &nInt);
+   if(QCBORDecode_Finish(&DCtx) || nInt != 99) {
+      return 31;
+   }
+
+   /* Without the item array and with a callback that fails */
+   memset(&CbCtx, 0, sizeof(CbCtx));
+   CbCtx.nFailAt = 3;
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetPaths(&DCtx, &Set, NULL, &CbCtx, PathTestCallback);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_CALLBACK_FAIL || CbCtx.nCalls != 3) {
+      return 32;
+   }
+
+   /* Paths from an item inside an entered map */
+   static const char *aszInner[] = {"b[0]", "x"};
+   if(QCBORPath_Compile(aszInner, 2, aSteps, 20, &Set)) {
+      return 40;
+   }
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_VGetNextConsume(&DCtx, &aItems[0]); /* Skip "skip" */
+   QCBORDecode_GetPaths(&DCtx, &Set, aItems, NULL, NULL);
+   if(QCBORDecode_GetError(&DCtx) ||
+      aItems[0].val.int64 != 10 ||
+      aItems[1].val.int64 != 1) {
+      return 41;
+   }
+   QCBORDecode_GetTextStringInMapN(&DCtx, 1, &Encoded);
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_GetError(&DCtx)) {
+      return 42;
+   }
+
+   /* Skipped arrays and maps are only checked for being well-formed.
+    * 1(h'00') isn't a valid date, but isn't decoded. */
+   static const UsefulBufC aSkipInputs[] = {
+      /* {"v": 7, "s": [1, {2: [3]}, 1(h'00')]} 8 */
+      {"\xa2\x61\x76\x07\x61\x73\x83\x01\xa1\x02\x81\x03\xc1\x41\x00\x08", 16},
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+      /* {"v": 7, "s": [_ 1, {_ 2: [3]}, 1(h'00')]} 8 */
+      {"\xa2\x61\x76\x07\x61\x73\x9f\x01\xbf\x02\x81\x03\xff\xc1\x41\x00\xff\x08", 18},
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+   };
+   static const char *aszSkip[] = {"v", ""};
+   size_t uInput;
+   for(uInput = 0; uInput < C_ARRAY_COUNT(aSkipInputs, UsefulBufC); uInput++) {
+      if(QCBORPath_Compile(aszSkip, 1, aSteps, 20, &Set)) {
+         return 50;
+      }
+      QCBORDecode_Init(&DCtx, aSkipInputs[uInput], QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_GetPaths(&DCtx, &Set, aItems, NULL, NULL);
+      QCBORDecode_GetInt64(&DCtx, &nInt);
+      if(QCBORDecode_Finish(&DCtx) ||
+         aItems[0].val.int64 != 7 ||
+         nInt != 8) {
+         return 51 + (int32_t)uInput * 10;
+      }
+
+      /* The array skipped is the last thing in an entered map */
+      if(QCBORPath_Compile(aszSkip + 1, 1, aSteps, 20, &Set)) {
+         return 52;
+      }
+      QCBORDecode_Init(&DCtx, aSkipInputs[uInput], QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_EnterMap(&DCtx, NULL);
+      QCBORDecode_GetInt64(&DCtx, &nInt);
+      QCBORDecode_GetPaths(&DCtx, &Set, aItems, NULL, NULL);
+      if(QCBORDecode_GetError(&DCtx) ||
+         aItems[0].uDataType != QCBOR_TYPE_ARRAY) {
+         return 53 + (int32_t)uInput * 10;
+      }
+      QCBORDecode_ExitMap(&DCtx);
+      QCBORDecode_GetInt64(&DCtx, &nInt);
+      if(QCBORDecode_Finish(&DCtx) || nInt != 8) {
+         return 54 + (int32_t)uInput * 10;
+      }
+   }
+
+   return 0;
+}
@@ -0,0 +1,32 @@
+/*==============================================================================
+ qcbor_path_tests.h -- tests for getting items by path expressions
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_path_tests_h
+#define qcbor_path_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Compiles good and bad paths and checks the errors, including too many
+ paths, paths too deep and storage too small.
+ */
+int32_t PathCompileTest(void);
+
+
+/*
+ Gets many paths from a document in one traversal, including integer
+ and quoted labels, indexes, wildcards with the callback, paths that
+ match nothing, a failing callback and the decoder position after.
+ */
+int32_t PathGetTest(void);
+
+
+#endif /* qcbor_path_tests_h */
@@ -0,0 +1,451 @@
+/*==============================================================================
+ qcbor_sax_tests.c -- tests for event-driven decoding with callbacks
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_sax_tests.h"
+#include "qcbor/qcbor_sax.h"
+#include "qcbor/qcbor_encode.h"
+
+
+/*
+ Each callback appends a short token to the log so the sequence of
+ calls can be compared to a string.
+ */
+typedef struct {
+   UsefulOutBuf Log;
+   int          nFailAfter; /* Fail on this call. -1 for never. */
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   double       dLast;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+} SaxTestLog;
+
+
+static void
+SaxTest_AppendUInt(UsefulOutBuf *pLog, uint64_t uValue)
+{
+   char   szDigits[20];
+   size_t uLen = 0;
+
+   do {
+      szDigits[uLen++] = (char)('0' + uValue % 10);
+      uValue /= 10;
+   } while(uValue != 0);
+   while(uLen > 0) {
+      UsefulOutBuf_AppendByte(pLog, (uint8_t)szDigits[--uLen]);
+   }
+}
+
+
+static QCBORError
+SaxTest_Token(void *pCbCtx, const char *szToken, bool bHasValue, bool bNegative, uint64_t uValue)
+{
+   SaxTestLog *pMe = (SaxTestLog *)pCbCtx;
+
+   if(pMe->nFailAfter == 0) {
+      return QCBOR_ERR_CALLBACK_FAIL;
+   }
+   pMe->nFailAfter--;
+
+   UsefulOutBuf_AppendString(&(pMe->Log), szToken);
+   if(bHasValue) {
+      if(bNegative) {
+         UsefulOutBuf_AppendByte(&(pMe->Log), '-');
+      }
+      SaxTest_AppendUInt(&(pMe->Log), uValue);
+   }
+   UsefulOutBuf_AppendByte(&(pMe->Log), ' ');
+   return QCBOR_SUCCESS;
+}
+
+
+static QCBORError
+SaxTest_Int(void *pCbCtx, int64_t nValue)
+{
+   /* Done in unsigned so INT64_MIN doesn't overflow */
+   const uint64_t uMagnitude = nValue < 0 ? 0 - (uint64_t)nValue : (uint64_t)nValue;
+   return SaxTest_Token(pCbCtx, "i", true, nValue < 0, uMagnitude);
+}
+
+static QCBORError
+SaxTest_UInt(void *pCbCtx, uint64_t uValue)
+{
+   return SaxTest_Token(pCbCtx, "u", true, false, uValue);
+}
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+static QCBORError
+SaxTest_Double(void *pCbCtx, double dValue)
+{
+   ((SaxTestLog *)pCbCtx)->dLast = dValue;
+   return SaxTest_Token(pCbCtx, "d", false, false, 0);
+}
+
+static QCBORError
+SaxTest_Float(void *pCbCtx, float fValue)
+{
+   (void)fValue;
+   return SaxTest_Token(pCbCtx, "f", false, false, 0);
+}
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+static QCBORError
+SaxTest_Bool(void *pCbCtx, bool bValue)
+{
+   return SaxTest_Token(pCbCtx, bValue ? "T" : "F", false, false, 0);
+}
+
+static QCBORError
+SaxTest_Null(void *pCbCtx)
+{
+   return SaxTest_Token(pCbCtx, "n", false, false, 0);
+}
+
+static QCBORError
+SaxTest_Simple(void *pCbCtx, uint8_t uSimpleValue)
+{
+   return SaxTest_Token(pCbCtx, "s", true, false, uSimpleValue);
+}
+
+static QCBORError
+SaxTest_Bytes(void *pCbCtx, UsefulBufC Bytes, bool bMore)
+{
+   if(UsefulBuf_IsNULLC(Bytes)) {
+      return SaxTest_Token(pCbCtx, "b.", false, false, 0);
+   }
+   return SaxTest_Token(pCbCtx, bMore ? "b+" : "b", true, false, Bytes.len);
+}
+
+static QCBORError
+SaxTest_Text(void *pCbCtx, UsefulBufC Text, bool bMore)
+{
+   SaxTestLog *pMe = (SaxTestLog *)pCbCtx;
+
+   if(UsefulBuf_IsNULLC(Text)) {
+      return SaxTest_Token(pCbCtx, "t.", false, false, 0);
+   }
+   if(pMe->nFailAfter == 0) {
+      return QCBOR_ERR_CALLBACK_FAIL;
+   }
+   pMe->nFailAfter--;
+
+   /* The token is the text in quotes */
+   UsefulOutBuf_AppendString(&(pMe->Log), bMore ? "t+\"" : "t\"");
+   UsefulOutBuf_AppendUsefulBuf(&(pMe->Log), Text);
+   UsefulOutBuf_AppendString(&(pMe->Log), "\" ");
+   return QCBOR_SUCCESS;
+}
+
+static QCBORError
+SaxTest_BeginArray(void *pCbCtx, uint16_t uCount)
+{
+   if(uCount == QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH) {
+      return SaxTest_Token(pCbCtx, "[_", false, false, 0);
+   }
+   return SaxTest_Token(pCbCtx, "[", true, false, uCount);
+}
+
+static QCBORError
+SaxTest_EndArray(void *pCbCtx)
+{
+   return SaxTest_Token(pCbCtx, "]", false, false, 0);
+}
+
+static QCBORError
+SaxTest_BeginMap(void *pCbCtx, uint16_t uCount)
+{
+   if(uCount == QCBOR_COUNT_INDICATES_INDEFINITE_LENGTH) {
+      return SaxTest_Token(pCbCtx, "{_", false, false, 0);
+   }
+   return SaxTest_Token(pCbCtx, "{", true, false, uCount);
+}
+
+static QCBORError
+SaxTest_EndMap(void *pCbCtx)
+{
+   return SaxTest_Token(pCbCtx, "}", false, false, 0);
+}
+
+static QCBORError
+SaxTest_Tag(void *pCbCtx, uint64_t uTagNumber)
+{
+   return SaxTest_Token(pCbCtx, "#", true, false, uTagNumber);
+}
+
+
+static const QCBORSaxCallbacks SaxTestCallbacks = {
+   SaxTest_Int,
+   SaxTest_UInt,
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   SaxTest_Double,
+   SaxTest_Float,
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+   SaxTest_Bool,
+   SaxTest_Null,
+   SaxTest_Simple,
+   SaxTest_Bytes,
+   SaxTest_Text,
+   SaxTest_BeginArray,
+   SaxTest_EndArray,
+   SaxTest_BeginMap,
+   SaxTest_EndMap,
+   SaxTest_Tag
+};
+
+
+/* Decode and compare the log with szExpected. Returns the error or
+ * QCBOR_ERR_CALLBACK_FAIL if the log is different. */
+static QCBORError
+SaxTest_Check(UsefulBufC Input, int nFailAfter, const char *szExpected)
+{
+   SaxTestLog Log;
+   QCBORError uErr;
+   UsefulBuf_MAKE_STACK_UB(LogBuffer, 300);
+
+   UsefulOutBuf_Init(&Log.Log, LogBuffer);
+   Log.nFailAfter = nFailAfter;
+
+   uErr = QCBORSax_Decode(Input, &SaxTestCallbacks, &Log);
+
+   if(UsefulBuf_Compare(UsefulOutBuf_OutUBuf(&Log.Log), UsefulBuf_FromSZ(szExpected))) {
+      return QCBOR_ERR_CALLBACK_FAIL;
+   }
+   return uErr;
+}
+
+
+/* (_ "ab", "c") */
+static const uint8_t spSaxIndefText[] = {0x7f, 0x62, 0x61, 0x62, 0x61, 0x63, 0xff};
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+/* (_ h'01', h'') */
+static const uint8_t spSaxIndefBytes[] = {0x5f, 0x41, 0x01, 0x40, 0xff};
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+/* [_ {_ 1: 2}, []] */
+static const uint8_t spSaxIndefArrays[] = {0x9f, 0xbf, 0x01, 0x02, 0xff, 0x80, 0xff};
+
+/* A sequence of 1, -24, 1(2(3)) */
+static const uint8_t spSaxSequence[] = {0x01, 0x37, 0xc1, 0xc2, 0x03};
+
+
+int32_t SaxEventsTest(void)
+{
+   QCBOREncodeContext ECtx;
+   UsefulBufC         Encoded;
+   QCBORError         uErr;
+   QCBORSaxCallbacks  OnlyInts;
+   SaxTestLog         Log;
+   UsefulBuf_MAKE_STACK_UB(Buffer, 100);
+
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_AddInt64(&ECtx, 1);
+   QCBOREncode_AddInt64(&ECtx, INT64_MIN);
+   QCBOREncode_AddUInt64(&ECtx, UINT64_MAX);
+   QCBOREncode_AddSZString(&ECtx, "abc");
+   QCBOREncode_AddBytes(&ECtx, (UsefulBufC){"\x01\x02", 2});
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddBoolToMap(&ECtx, "a", true);
+   QCBOREncode_AddInt64(&ECtx, 5);
+   QCBOREncode_AddNULL(&ECtx);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddTag(&ECtx, 1);
+   QCBOREncode_AddInt64(&ECtx, 1000);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddBool(&ECtx, false);
+   QCBOREncode_AddUndef(&ECtx);
+   QCBOREncode_AddSimple(&ECtx, 99);
+   QCBOREncode_CloseArray(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return 1;
+   }
+
+   uErr = SaxTest_Check(Encoded, -1,
+      "[11 i1 i-9223372036854775808 u18446744073709551615 t\"abc\" b2 "
+      "{2 t\"a\" T i5 n } #1 i1000 [0 ] F s23 s99 ] ");
+   if(uErr != QCBOR_SUCCESS) {
+      return 2;
+   }
+
+   /* Callbacks left NULL are skipped */
+   memset(&OnlyInts, 0, sizeof(OnlyInts));
+   OnlyInts.pfInt = SaxTest_Int;
+   {
+      UsefulBuf_MAKE_STACK_UB(LogBuffer, 100);
+      UsefulOutBuf_Init(&Log.Log, LogBuffer);
+      Log.nFailAfter = -1;
+      uErr = QCBORSax_Decode(Encoded, &OnlyInts, &Log);
+      if(uErr != QCBOR_SUCCESS ||
+         UsefulBuf_Compare(UsefulOutBuf_OutUBuf(&Log.Log),
+                           UsefulBuf_FromSZ("i1 i-9223372036854775808 i5 i1000 "))) {
+         return 3;
+      }
+   }
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   if(SaxTest_Check(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSaxIndefText), -1,
+                    "t+\"ab\" t+\"c\" t. ")) {
+      return 10;
+   }
+   if(SaxTest_Check(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSaxIndefBytes), -1,
+                    "b+1 b+0 b. ")) {
+      return 11;
+   }
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+   if(SaxTest_Check(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSaxIndefText), -1,
+                    "") != QCBOR_ERR_INDEF_LEN_STRINGS_DISABLED) {
+      return 12;
+   }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   if(SaxTest_Check(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSaxIndefArrays), -1,
+                    "[_ {_ i1 i2 } [0 ] ] ")) {
+      return 20;
+   }
+#else /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+   if(SaxTest_Check(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSaxIndefArrays), -1,
+                    "") != QCBOR_ERR_INDEF_LEN_ARRAYS_DISABLED) {
+      return 21;
+   }
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+   if(SaxTest_Check(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSaxSequence), -1,
+                    "i1 i-24 #1 #2 i3 ")) {
+      return 30;
+   }
+   if(SaxTest_Check(NULLUsefulBufC, -1, "")) {
+      return 31;
+   }
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   {
+      UsefulBuf_MAKE_STACK_UB(LogBuffer, 20);
+
+      QCBOREncode_Init(&ECtx, Buffer);
+      QCBOREncode_AddDoubleNoPreferred(&ECtx, 1.5);
+      (void)QCBOREncode_Finish(&ECtx, &Encoded);
+
+      UsefulOutBuf_Init(&Log.Log, LogBuffer);
+      Log.nFailAfter = -1;
+      uErr = QCBORSax_Decode(Encoded, &SaxTestCallbacks, &Log);
+      if(uErr != QCBOR_SUCCESS ||
+         UsefulBufUtil_CopyDoubleToUint64(Log.dLast) != UsefulBufUtil_CopyDoubleToUint64(1.5)) {
+         return 40;
+      }
+   }
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+   return 0;
+}
+
+
+static const struct {
+   const char *szName;
+   UsefulBufC  Input;
+   QCBORError  uExpected;
+} SaxErrorTests[] = {
+   {"break alone",        {"\xff", 1},                   QCBOR_ERR_BAD_BREAK},
+   {"break in array",     {"\x81\xff", 2},               QCBOR_ERR_BAD_BREAK},
+   {"array cut short",    {"\x82\x01", 2},               QCBOR_ERR_ARRAY_OR_MAP_UNCONSUMED},
+   {"tag at end",         {"\xc1", 1},                   QCBOR_ERR_HIT_END},
+   {"string cut short",   {"\x63\x61", 2},               QCBOR_ERR_HIT_END},
+   {"head cut short",     {"\x19\x01", 2},               QCBOR_ERR_HIT_END},
+   {"reserved add info",  {"\x1c", 1},                   QCBOR_ERR_UNSUPPORTED},
+   {"indefinite int",     {"\x1f", 1},                   QCBOR_ERR_BAD_INT},
+   {"indefinite tag",     {"\xdf", 1},                   QCBOR_ERR_BAD_INT},
+   {"bad simple",         {"\xf8\x10", 2},               QCBOR_ERR_BAD_TYPE_7},
+   {"negative overflow",  {"\x3b\xff\xff\xff\xff\xff\xff\xff\xff", 9}, QCBOR_ERR_INT_OVERFLOW},
+   {"array too long",     {"\x9a\x00\x01\x00\x00", 5},   QCBOR_ERR_ARRAY_DECODE_TOO_LONG},
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   {"break after label",  {"\xbf\x01\xff", 3},           QCBOR_ERR_BAD_BREAK},
+   {"tag on break",       {"\x9f\xc1\xff", 3},           QCBOR_ERR_BAD_BREAK},
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   {"wrong chunk type",   {"\x7f\x41\x00\xff", 4},       QCBOR_ERR_INDEFINITE_STRING_CHUNK},
+   {"nested indef chunk", {"\x5f\x5f\xff\xff", 4},       QCBOR_ERR_INDEFINITE_STRING_CHUNK},
+   {"chunks cut short",   {"\x5f\x41\x00", 3},           QCBOR_ERR_HIT_END},
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+};
+
+
+/* Decode with QCBORDecode_GetNext() and QCBORDecode_Finish() and
+ * return the first error */
+static QCBORError
+SaxTest_GetNextError(UsefulBufC Input)
+{
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   QCBORError         uErr;
+
+   QCBORDecode_Init(&DCtx, Input, QCBOR_DECODE_MODE_NORMAL);
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS
+   /* For the indefinite-length strings */
+   UsefulBuf_MAKE_STACK_UB(Pool, 100);
+   QCBORDecode_SetMemPool(&DCtx, Pool, false);
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_STRINGS */
+   do {
+      uErr = QCBORDecode_GetNext(&DCtx, &Item);
+   } while(uErr == QCBOR_SUCCESS);
+   if(uErr == QCBOR_ERR_NO_MORE_ITEMS) {
+      uErr = QCBORDecode_Finish(&DCtx);
+   }
+
+   return uErr;
+}
+
+
+int32_t SaxErrorsTest(void)
+{
+   size_t     uIndex;
+   QCBORError uErr;
+   uint8_t    auDeep[QCBOR_MAX_ARRAY_NESTING + 2];
+   SaxTestLog Log;
+   UsefulBuf_MAKE_STACK_UB(LogBuffer, 100);
+
+   for(uIndex = 0; uIndex < sizeof(SaxErrorTests)/sizeof(SaxErrorTests[0]); uIndex++) {
+      UsefulOutBuf_Init(&Log.Log, LogBuffer);
+      Log.nFailAfter = -1;
+      uErr = QCBORSax_Decode(SaxErrorTests[uIndex].Input, &SaxTestCallbacks, &Log);
+      if(uErr != SaxErrorTests[uIndex].uExpected) {
+         return (int32_t)(1 + uIndex * 10);
+      }
+      /* The same error as the pull decoder */
+      if(SaxTest_GetNextError(SaxErrorTests[uIndex].Input) != uErr) {
+         return (int32_t)(2 + uIndex * 10);
+      }
+   }
+
+   /* As deep as allowed, then one too deep */
+   memset(auDeep, 0x81, sizeof(auDeep));
+   auDeep[QCBOR_MAX_ARRAY_NESTING] = 0x00;
+   uErr = SaxTest_Check((UsefulBufC){auDeep, QCBOR_MAX_ARRAY_NESTING + 1}, -1,
+                        "[1 [1 [1 [1 [1 [1 [1 [1 [1 [1 [1 [1 [1 [1 [1 i0 "
+                        "] ] ] ] ] ] ] ] ] ] ] ] ] ] ] ");
+   if(uErr != QCBOR_SUCCESS) {
+      return 500;
+   }
+   auDeep[QCBOR_MAX_ARRAY_NESTING] = 0x81;
+   auDeep[QCBOR_MAX_ARRAY_NESTING + 1] = 0x00;
+   uErr = QCBORSax_Decode((UsefulBufC){auDeep, sizeof(auDeep)}, &SaxTestCallbacks, &Log);
+   if(uErr != QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP) {
+      return 501;
+   }
+
+   /* An error from a callback stops decoding. The first two calls
+    * succeed. */
+   uErr = SaxTest_Check((UsefulBufC){"\x83\x01\x02\x03", 4}, 2, "[3 i1 ");
+   if(uErr != QCBOR_ERR_CALLBACK_FAIL) {
+      return 600;
+   }
+
+   return 0;
+}
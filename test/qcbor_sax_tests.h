@@ -0,0 +1,33 @@
+/*==============================================================================
+ qcbor_sax_tests.h -- tests for event-driven decoding with callbacks
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_sax_tests_h
+#define qcbor_sax_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Decodes documents with every kind of item, including tags,
+ indefinite-length strings, arrays and maps and CBOR sequences, and
+ checks the callbacks made.
+ */
+int32_t SaxEventsTest(void);
+
+
+/*
+ Checks that input that is not well-formed gives the same errors as
+ QCBORDecode_GetNext() and that an error from a callback stops
+ decoding.
+ */
+int32_t SaxErrorsTest(void);
+
+
+#endif /* qcbor_sax_tests_h */
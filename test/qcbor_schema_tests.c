@@ -0,0 +1,363 @@
+/*==============================================================================
+ qcbor_schema_tests.c -- tests for validation against a CDDL schema
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_schema_tests.h"
+#include "qcbor/qcbor_schema.h"
+#include "qcbor/qcbor_spiffy_decode.h"
+#include <string.h> /* For strcat() and strcpy() */
+
+
+#define SCHEMA_TEST_CODE_SIZE 200
+
+
+static const char *aszBadCDDL[] = {
+   "",
+   "; just a comment",
+   "a = ",
+   "a = foo",
+   "a = [int",
+   "a = { int }",
+   "a = int // tstr",
+   "a = 1..",
+   "a = #6.-1(int)",
+   "a = tstr .size (5..1)",
+   "a = tstr .size",
+   "a = [3*1 int]",
+   "a = [0*0 int]",
+   "a = \"abc",
+   "a = \"a\\\"bc\"",
+   "a = 9223372036854775808",
+   "a = (int",
+   "a int",
+   "a = [[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[int]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]",
+};
+
+
+static const char *aszGoodCDDL[] = {
+   "a = b\nb = int",
+   "a = [* a] ; recursive",
+   "a = 0x10..0x20 / -0x10...0",
+   "a = -9223372036854775808..9223372036854775807",
+   "a = {1: int 2: tstr, ? \"x\" : bool, * int => any}",
+   "a = [name: tstr, age: uint]",
+   "a = #6.1234(bstr .size (0...8))",
+   "a = [tdate, b]\nb = int",
+   "a = [uri, b]\nb = tstr",
+   "a = [int, tdate]",
+   "a = [tdate]\ntdate = int",
+};
+
+
+int32_t SchemaCompileTest(void)
+{
+   uint32_t    auCode[SCHEMA_TEST_CODE_SIZE];
+   QCBORSchema Schema;
+   QCBORError  uErr;
+   size_t      uIndex;
+   size_t      uLen;
+   char        szCDDL[400];
+
+   for(uIndex = 0; uIndex < sizeof(aszBadCDDL)/sizeof(aszBadCDDL[0]); uIndex++) {
+      uErr = QCBORSchema_Compile(UsefulBuf_FromSZ(aszBadCDDL[uIndex]),
+                                 auCode, SCHEMA_TEST_CODE_SIZE, &Schema);
+      if(uErr != QCBOR_ERR_SCHEMA_SYNTAX) {
+         return (int32_t)(uIndex * 100 + uErr + 1);
+      }
+   }
+
+   for(uIndex = 0; uIndex < sizeof(aszGoodCDDL)/sizeof(aszGoodCDDL[0]); uIndex++) {
+      /* Size calculation then compile into a buffer exactly the size */
+      uErr = QCBORSchema_Compile(UsefulBuf_FromSZ(aszGoodCDDL[uIndex]),
+                                 NULL, 0, &Schema);
+      if(uErr != QCBOR_SUCCESS || Schema.uCodeLen > SCHEMA_TEST_CODE_SIZE) {
+         return (int32_t)(1000 + uIndex * 100 + uErr);
+      }
+      uLen = Schema.uCodeLen;
+
+      uErr = QCBORSchema_Compile(UsefulBuf_FromSZ(aszGoodCDDL[uIndex]),
+                                 auCode, uLen - 1, &Schema);
+      if(uErr != QCBOR_ERR_BUFFER_TOO_SMALL || Schema.uCodeLen != uLen) {
+         return (int32_t)(2000 + uIndex * 100 + uErr);
+      }
+
+      uErr = QCBORSchema_Compile(UsefulBuf_FromSZ(aszGoodCDDL[uIndex]),
+                                 auCode, uLen, &Schema);
+      if(uErr != QCBOR_SUCCESS || Schema.uCodeLen != uLen || Schema.puCode != auCode) {
+         return (int32_t)(3000 + uIndex * 100 + uErr);
+      }
+   }
+
+   /* One more than the maximum number of rules */
+   szCDDL[0] = '\0';
+   for(uIndex = 0; uIndex <= QCBOR_SCHEMA_MAX_RULES; uIndex++) {
+      strcat(szCDDL, "r = int\n");
+   }
+   uErr = QCBORSchema_Compile(UsefulBuf_FromSZ(szCDDL), auCode, SCHEMA_TEST_CODE_SIZE, &Schema);
+   if(uErr != QCBOR_ERR_SCHEMA_SYNTAX) {
+      return -1;
+   }
+
+   /* One more than the maximum number of map members */
+   strcpy(szCDDL, "m = {");
+   for(uIndex = 0; uIndex <= QCBOR_SCHEMA_MAX_MAP_MEMBERS; uIndex++) {
+      strcat(szCDDL, "? 1: int, ");
+   }
+   strcat(szCDDL, "}");
+   uErr = QCBORSchema_Compile(UsefulBuf_FromSZ(szCDDL), NULL, 0, &Schema);
+   if(uErr != QCBOR_ERR_SCHEMA_SYNTAX) {
+      return -2;
+   }
+
+   return 0;
+}
+
+
+struct SchemaTestCase {
+   const char *szCDDL;
+   UsefulBufC  Encoded;
+   QCBORError  uExpectedErr;
+};
+
+/* The encoded CBOR is given as a string literal of hex escapes */
+#define SCHEMA_TEST_CASE(szCDDL, szEncoded, uExpectedErr) \
+   {szCDDL, {szEncoded, sizeof(szEncoded) - 1}, uExpectedErr}
+
+#define SCHEMA_OK       QCBOR_SUCCESS
+#define SCHEMA_MISMATCH QCBOR_ERR_SCHEMA_MISMATCH
+
+static const char szMapCDDL[] =
+   "msg = {\n"
+   "   1: int,                   ; alg\n"
+   "   ? 2: bstr .size (1..4),   ; kid\n"
+   "   \"name\": tstr,\n"
+   "   * tstr => any\n"
+   "}\n";
+
+static const char szArrayCDDL[] = "a = [uint, * tstr, ? bool]";
+
+static const char szChoiceCDDL[] = "c = -10..10 / \"x\" / 'b' / nil / 100...200";
+
+static const char szTagCDDL[] =
+   "t = [tdate, time, biguint, #6.1234(int), encoded-cbor]";
+
+static const char szTreeCDDL[] = "tree = [int, * tree]";
+
+static const char szHeaderCDDL[] = "h = { \"alg\": int, * tstr => bstr }";
+
+
+static const struct SchemaTestCase sSchemaTestCases[] = {
+   /* {1: 5, 2: h'0102', "name": "x"} */
+   SCHEMA_TEST_CASE(szMapCDDL, "\xa3\x01\x05\x02\x42\x01\x02\x64name\x61x", SCHEMA_OK),
+   /* Missing "name" */
+   SCHEMA_TEST_CASE(szMapCDDL, "\xa2\x01\x05\x02\x42\x01\x02", SCHEMA_MISMATCH),
+   /* bstr too long for .size */
+   SCHEMA_TEST_CASE(szMapCDDL, "\xa3\x01\x05\x02\x45\x01\x02\x03\x04\x05\x64name\x61x", SCHEMA_MISMATCH),
+   /* An extra member with a text key and an array value */
+   SCHEMA_TEST_CASE(szMapCDDL, "\xa3\x01\x05\x64name\x61x\x61z\x82\x01\x02", SCHEMA_OK),
+   /* An extra member with an int key */
+   SCHEMA_TEST_CASE(szMapCDDL, "\xa3\x01\x05\x64name\x61x\x03\x00", SCHEMA_MISMATCH),
+   /* Label 1 twice */
+   SCHEMA_TEST_CASE(szMapCDDL, "\xa3\x01\x05\x01\x05\x64name\x61x", SCHEMA_MISMATCH),
+   /* Wrong type for label 1 */
+   SCHEMA_TEST_CASE(szMapCDDL, "\xa2\x01\x61" "a\x64name\x61x", SCHEMA_MISMATCH),
+   /* Not a map */
+   SCHEMA_TEST_CASE(szMapCDDL, "\x80", SCHEMA_MISMATCH),
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   /* Indefinite-length map */
+   SCHEMA_TEST_CASE(szMapCDDL, "\xbf\x01\x05\x64name\x61x\xff", SCHEMA_OK),
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+
+   SCHEMA_TEST_CASE(szArrayCDDL, "\x83\x01\x61" "a\xf5", SCHEMA_OK),
+   SCHEMA_TEST_CASE(szArrayCDDL, "\x81\x01", SCHEMA_OK),
+   SCHEMA_TEST_CASE(szArrayCDDL, "\x84\x01\x61" "a\x61" "b\xf4", SCHEMA_OK),
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   SCHEMA_TEST_CASE(szArrayCDDL, "\x9f\x01\x61" "a\xff", SCHEMA_OK),
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+   SCHEMA_TEST_CASE(szArrayCDDL, "\x82\x20\x61" "a", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE(szArrayCDDL, "\x83\x01\xf5\xf5", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE(szArrayCDDL, "\x80", SCHEMA_MISMATCH),
+
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x29", SCHEMA_OK),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x0a", SCHEMA_OK),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x0b", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x2a", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x61x", SCHEMA_OK),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x61y", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x41" "b", SCHEMA_OK),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x41x", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\xf6", SCHEMA_OK),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\xf7", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x18\xc7", SCHEMA_OK),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x18\xc8", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE(szChoiceCDDL, "\x1b\xff\xff\xff\xff\xff\xff\xff\xff", SCHEMA_MISMATCH),
+
+   SCHEMA_TEST_CASE(szTagCDDL,
+                    "\x85"
+                    "\xc0\x74" "2013-03-21T20:04:00Z"
+                    "\xc1\x1a\x51\x4b\x67\xb0"
+                    "\xc2\x42\x01\x00"
+                    "\xd9\x04\xd2\x05"
+                    "\xd8\x18\x41\x01",
+                    SCHEMA_OK),
+   /* tdate without its tag */
+   SCHEMA_TEST_CASE(szTagCDDL,
+                    "\x85"
+                    "\x74" "2013-03-21T20:04:00Z"
+                    "\xc1\x1a\x51\x4b\x67\xb0"
+                    "\xc2\x42\x01\x00"
+                    "\xd9\x04\xd2\x05"
+                    "\xd8\x18\x41\x01",
+                    SCHEMA_MISMATCH),
+   /* #6.1234 with another tag outside */
+   SCHEMA_TEST_CASE(szTagCDDL,
+                    "\x85"
+                    "\xc0\x74" "2013-03-21T20:04:00Z"
+                    "\xc1\x1a\x51\x4b\x67\xb0"
+                    "\xc2\x42\x01\x00"
+                    "\xd9\x04\xd3\xd9\x04\xd2\x05"
+                    "\xd8\x18\x41\x01",
+                    SCHEMA_MISMATCH),
+   /* An unexpected tag on an int */
+   SCHEMA_TEST_CASE("i = int", "\xd9\x04\xd2\x05", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE("i = #6.1234(#6.1235(int))", "\xd9\x04\xd2\xd9\x04\xd3\x05", SCHEMA_OK),
+   SCHEMA_TEST_CASE("i = #6.1235(#6.1234(int))", "\xd9\x04\xd2\xd9\x04\xd3\x05", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE("a = any", "\xd9\x04\xd2\x82\x05\xa1\x01\x02", SCHEMA_OK),
+   SCHEMA_TEST_CASE("d = tdate", "\xc1\x01", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE("d = time", "\xc1\x01", SCHEMA_OK),
+   SCHEMA_TEST_CASE("d = #6.1(0..10)", "\xc1\x0b", SCHEMA_MISMATCH),
+   /* Rules after types from the prelude that are tags */
+   SCHEMA_TEST_CASE("a = [tdate, b]\nb = int", "\x82\xc0\x61x\x05", SCHEMA_OK),
+   SCHEMA_TEST_CASE("a = [uri, b]\nb = tstr", "\x82\xd8\x20\x61x\x61y", SCHEMA_OK),
+   SCHEMA_TEST_CASE("a = [int, tdate]", "\x82\x01\xc0\x61x", SCHEMA_OK),
+   /* A rule takes precedence over the prelude even when it is later */
+   SCHEMA_TEST_CASE("a = [tdate]\ntdate = int", "\x81\x05", SCHEMA_OK),
+   SCHEMA_TEST_CASE("a = [tdate]\ntdate = int", "\x81\xc0\x61x", SCHEMA_MISMATCH),
+
+   /* [1, [2, [3]], [4]] */
+   SCHEMA_TEST_CASE(szTreeCDDL, "\x83\x01\x82\x02\x81\x03\x81\x04", SCHEMA_OK),
+   SCHEMA_TEST_CASE(szTreeCDDL, "\x82\x01\x82\x02\x61" "a", SCHEMA_MISMATCH),
+
+   SCHEMA_TEST_CASE("u = uint .size 1", "\x18\xff", SCHEMA_OK),
+   SCHEMA_TEST_CASE("u = uint .size 1", "\x19\x01\x00", SCHEMA_MISMATCH),
+   SCHEMA_TEST_CASE("s = tstr .size 3", "\x63" "abc", SCHEMA_OK),
+   SCHEMA_TEST_CASE("s = tstr .size 3", "\x64" "abcd", SCHEMA_MISMATCH),
+
+   SCHEMA_TEST_CASE(szHeaderCDDL, "\xa2\x63" "alg\x01\x61k\x41\x01", SCHEMA_OK),
+   /* "alg" matches its own member first, not * tstr => bstr */
+   SCHEMA_TEST_CASE(szHeaderCDDL, "\xa1\x63" "alg\x41\x01", SCHEMA_MISMATCH),
+
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   SCHEMA_TEST_CASE("f = [float, number]", "\x82\xfb\x3f\xf0\x00\x00\x00\x00\x00\x00\x01", SCHEMA_OK),
+   SCHEMA_TEST_CASE("f = float", "\x01", SCHEMA_MISMATCH),
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+   /* Not-well-formed CBOR gives the decode error */
+   SCHEMA_TEST_CASE("a = [* int]", "\x82\x01", QCBOR_ERR_NO_MORE_ITEMS),
+};
+
+
+/* A map with an extra member that has nested arrays followed by 7 */
+static const uint8_t spSequence[] = {
+   0xa3, 0x01, 0x05, 0x64, 'n', 'a', 'm', 'e', 0x61, 'x',
+   0x61, 'z', 0x82, 0x81, 0x01, 0x81, 0x02, 0x07
+};
+
+
+int32_t SchemaValidateTest(void)
+{
+   uint32_t           auCode[SCHEMA_TEST_CODE_SIZE];
+   QCBORSchema        Schema;
+   QCBORDecodeContext DCtx;
+   QCBORItem          Item;
+   QCBORError         uErr;
+   size_t             uIndex;
+   uint32_t          *puCode;
+
+   for(uIndex = 0; uIndex < sizeof(sSchemaTestCases)/sizeof(sSchemaTestCases[0]); uIndex++) {
+      /* Compiled into the end of the buffer in exactly the size
+       * needed so reading past the end of the program is caught */
+      uErr = QCBORSchema_Compile(UsefulBuf_FromSZ(sSchemaTestCases[uIndex].szCDDL),
+                                 NULL, 0, &Schema);
+      if(uErr != QCBOR_SUCCESS || Schema.uCodeLen > SCHEMA_TEST_CODE_SIZE) {
+         return (int32_t)(uIndex * 100 + 97);
+      }
+      puCode = auCode + SCHEMA_TEST_CODE_SIZE - Schema.uCodeLen;
+      uErr = QCBORSchema_Compile(UsefulBuf_FromSZ(sSchemaTestCases[uIndex].szCDDL),
+                                 puCode, Schema.uCodeLen, &Schema);
+      if(uErr != QCBOR_SUCCESS) {
+         return (int32_t)(uIndex * 100 + 99);
+      }
+
+      QCBORDecode_Init(&DCtx, sSchemaTestCases[uIndex].Encoded, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_ValidateSchema(&DCtx, &Schema);
+      uErr = QCBORDecode_GetError(&DCtx);
+      if(uErr != sSchemaTestCases[uIndex].uExpectedErr) {
+         return (int32_t)(uIndex * 100 + uErr);
+      }
+      if(uErr == QCBOR_SUCCESS && QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS) {
+         return (int32_t)(uIndex * 100 + 98);
+      }
+   }
+
+   /* Positioned after the item validated and can rewind */
+   uErr = QCBORSchema_Compile(UsefulBuf_FromSZ(szMapCDDL), auCode, SCHEMA_TEST_CODE_SIZE, &Schema);
+   if(uErr != QCBOR_SUCCESS) {
+      return -1;
+   }
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSequence), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_ValidateSchema(&DCtx, &Schema);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS ||
+      Item.uDataType != QCBOR_TYPE_INT64 || Item.val.int64 != 7) {
+      return -2;
+   }
+   QCBORDecode_Rewind(&DCtx);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   QCBORDecode_GetInt64InMapN(&DCtx, 1, &Item.val.int64);
+   QCBORDecode_ExitMap(&DCtx);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_SUCCESS || Item.val.int64 != 5) {
+      return -3;
+   }
+
+   /* A mismatch sticks like other spiffy decode errors */
+   uErr = QCBORSchema_Compile(UsefulBuf_FromSZ("a = tstr"), auCode, SCHEMA_TEST_CODE_SIZE, &Schema);
+   if(uErr != QCBOR_SUCCESS) {
+      return -4;
+   }
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSequence), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_ValidateSchema(&DCtx, &Schema);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_SCHEMA_MISMATCH) {
+      return -5;
+   }
+
+   /* A program that wasn't made by QCBORSchema_Compile() */
+   auCode[0] = 0;
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSequence), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_ValidateSchema(&DCtx, &Schema);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_SCHEMA_SYNTAX) {
+      return -6;
+   }
+
+   /* A reference past the end of the program */
+   uErr = QCBORSchema_Compile(UsefulBuf_FromSZ("a = b\nb = int"), auCode, SCHEMA_TEST_CODE_SIZE, &Schema);
+   if(uErr != QCBOR_SUCCESS) {
+      return -7;
+   }
+   auCode[3] = (uint32_t)Schema.uCodeLen;
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSequence), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_ValidateSchema(&DCtx, &Schema);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_SCHEMA_MISMATCH) {
+      return -8;
+   }
+
+   return 0;
+}
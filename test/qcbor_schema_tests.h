@@ -0,0 +1,32 @@
+/*==============================================================================
+ qcbor_schema_tests.h -- tests for validation against a CDDL schema
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_schema_tests_h
+#define qcbor_schema_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Compiles CDDL in and out of the supported subset and checks the
+ errors, size calculation and buffer too small.
+ */
+int32_t SchemaCompileTest(void);
+
+
+/*
+ Validates a set of encoded CBOR against schemas and checks the
+ result. Covers prelude types, values, ranges, choices, occurrences,
+ maps, tags, .size, recursive rules and the decoder position after.
+ */
+int32_t SchemaValidateTest(void);
+
+
+#endif /* qcbor_schema_tests_h */
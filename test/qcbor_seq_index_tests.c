@@ -0,0 +1,377 @@
+/*==============================================================================
+ qcbor_seq_index_tests.c -- tests for the offset index of CBOR sequences
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_seq_index_tests.h"
+#include "qcbor/qcbor_seq_index.h"
+#include "qcbor/qcbor_encode.h"
+#include "qcbor/qcbor_spiffy_decode.h"
+
+
+#define SEQ_TEST_NUM_RECORDS 10
+
+/* Keys of the records. Some repeat. */
+static const int64_t spSeqTestKeys[SEQ_TEST_NUM_RECORDS] = {
+   -5, 5, 5, 5, 10, 20, 20, 30, 40, 50
+};
+
+
+/*
+ A sequence of records like {1: key, 2: record number}. Every third
+ record also has a byte string and an array to skip over.
+ */
+static UsefulBufC
+EncodeSeqTestRecords(UsefulBuf Buffer, uint64_t *puOffsets)
+{
+   QCBOREncodeContext ECtx;
+   UsefulBufC         Encoded;
+   size_t             uOffset;
+   int                nRecord;
+   static const uint8_t spFill[40] = {0};
+
+   uOffset = 0;
+   for(nRecord = 0; nRecord < SEQ_TEST_NUM_RECORDS; nRecord++) {
+      puOffsets[nRecord] = uOffset;
+      QCBOREncode_Init(&ECtx, (UsefulBuf){(uint8_t *)Buffer.ptr + uOffset,
+                                          Buffer.len - uOffset});
+      QCBOREncode_OpenMap(&ECtx);
+      if(nRecord % 3 == 0) {
+         QCBOREncode_AddBytesToMap(&ECtx, "fill", UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spFill));
+         QCBOREncode_OpenArrayInMap(&ECtx, "a");
+         QCBOREncode_AddInt64(&ECtx, nRecord);
+         QCBOREncode_CloseArray(&ECtx);
+      }
+      QCBOREncode_AddInt64ToMapN(&ECtx, 1, spSeqTestKeys[nRecord]);
+      QCBOREncode_AddInt64ToMapN(&ECtx, 2, nRecord);
+      QCBOREncode_CloseMap(&ECtx);
+      if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_SUCCESS) {
+         return NULLUsefulBufC;
+      }
+      uOffset += Encoded.len;
+   }
+
+   return (UsefulBufC){Buffer.ptr, uOffset};
+}
+
+
+/* Check the decoder is at the record by getting its record number */
+static int32_t
+CheckSeqTestRecord(QCBORDecodeContext *pDCtx, int64_t nExpectedRecord)
+{
+   int64_t nRecord;
+
+   QCBORDecode_EnterMap(pDCtx, NULL);
+   QCBORDecode_GetInt64InMapN(pDCtx, 2, &nRecord);
+   QCBORDecode_ExitMap(pDCtx);
+   if(QCBORDecode_GetError(pDCtx) != QCBOR_SUCCESS) {
+      return 1;
+   }
+   return nRecord == nExpectedRecord ? 0 : 2;
+}
+
+
+int32_t SeqIndexTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(   SeqBuf, 600);
+   UsefulBuf_MAKE_STACK_UB(   IndexBuf1, QCBOR_SEQ_INDEX_SIZE(SEQ_TEST_NUM_RECORDS, 1, true));
+   UsefulBuf_MAKE_STACK_UB(   IndexBuf2, QCBOR_SEQ_INDEX_SIZE(SEQ_TEST_NUM_RECORDS, 1, true));
+   QCBORSeqIndexBuilder       Builder;
+   QCBORDecodeContext         DCtx;
+   UsefulBufC                 Sequence;
+   UsefulBufC                 Index;
+   UsefulBufC                 Index2;
+   uint64_t                   auOffsets[SEQ_TEST_NUM_RECORDS];
+   QCBORError                 uErr;
+   int                        nKeys;
+   uint32_t                   uInterval;
+   int                        nRecord;
+   int                        nKey;
+   static const uint32_t      auIntervals[] = {1, 3, 4, 10, 11};
+
+   Sequence = EncodeSeqTestRecords(SeqBuf, auOffsets);
+   if(UsefulBuf_IsNULLC(Sequence)) {
+      return 1;
+   }
+
+   for(nKeys = 0; nKeys < 2; nKeys++) {
+      for(uInterval = 0; uInterval < sizeof(auIntervals)/sizeof(auIntervals[0]); uInterval++) {
+         const int32_t nTestBase = (nKeys * 10 + (int32_t)uInterval) * 1000;
+
+         /* At append time */
+         QCBORSeqIndex_Init(&Builder, IndexBuf1, auIntervals[uInterval], nKeys, 1);
+         for(nRecord = 0; nRecord < SEQ_TEST_NUM_RECORDS; nRecord++) {
+            QCBORSeqIndex_AddRecord(&Builder, auOffsets[nRecord], spSeqTestKeys[nRecord]);
+         }
+         uErr = QCBORSeqIndex_Finish(&Builder, &Index);
+         if(uErr != QCBOR_SUCCESS ||
+            Index.len != QCBOR_SEQ_INDEX_SIZE(SEQ_TEST_NUM_RECORDS, auIntervals[uInterval], nKeys)) {
+            return nTestBase + 1;
+         }
+
+         /* After the fact, in two parts */
+         QCBORSeqIndex_Init(&Builder, IndexBuf2, auIntervals[uInterval], nKeys, 1);
+         QCBORSeqIndex_AddSequence(&Builder, UsefulBuf_Head(Sequence, auOffsets[4]), 0);
+         QCBORSeqIndex_AddSequence(&Builder, UsefulBuf_Tail(Sequence, auOffsets[4]), auOffsets[4]);
+         uErr = QCBORSeqIndex_Finish(&Builder, &Index2);
+         if(uErr != QCBOR_SUCCESS || UsefulBuf_Compare(Index, Index2)) {
+            return nTestBase + 2;
+         }
+
+         /* Size calculation */
+         QCBORSeqIndex_Init(&Builder, SizeCalculateUsefulBuf, auIntervals[uInterval], nKeys, 1);
+         QCBORSeqIndex_AddSequence(&Builder, Sequence, 0);
+         uErr = QCBORSeqIndex_Finish(&Builder, &Index2);
+         if(uErr != QCBOR_SUCCESS || Index2.len != Index.len) {
+            return nTestBase + 3;
+         }
+
+         /* Every record in backwards order */
+         QCBORDecode_Init(&DCtx, Sequence, QCBOR_DECODE_MODE_NORMAL);
+         for(nRecord = SEQ_TEST_NUM_RECORDS - 1; nRecord >= 0; nRecord--) {
+            uErr = QCBORSeqIndex_SeekToRecord(&DCtx, Index, (uint64_t)nRecord);
+            if(uErr != QCBOR_SUCCESS) {
+               return nTestBase + 10 + nRecord;
+            }
+            if(CheckSeqTestRecord(&DCtx, nRecord)) {
+               return nTestBase + 20 + nRecord;
+            }
+         }
+
+         uErr = QCBORSeqIndex_SeekToRecord(&DCtx, Index, SEQ_TEST_NUM_RECORDS);
+         if(uErr != QCBOR_ERR_NO_MORE_ITEMS) {
+            return nTestBase + 4;
+         }
+
+         if(!nKeys) {
+            uErr = QCBORSeqIndex_SeekToKey(&DCtx, Index, 5);
+            if(uErr != QCBOR_ERR_UNEXPECTED_TYPE) {
+               return nTestBase + 5;
+            }
+            continue;
+         }
+
+         /* Every key gets the first record with it */
+         for(nRecord = SEQ_TEST_NUM_RECORDS - 1; nRecord >= 0; nRecord--) {
+            if(nRecord > 0 && spSeqTestKeys[nRecord - 1] == spSeqTestKeys[nRecord]) {
+               continue;
+            }
+            uErr = QCBORSeqIndex_SeekToKey(&DCtx, Index, spSeqTestKeys[nRecord]);
+            if(uErr != QCBOR_SUCCESS) {
+               return nTestBase + 30 + nRecord;
+            }
+            if(CheckSeqTestRecord(&DCtx, nRecord)) {
+               return nTestBase + 40 + nRecord;
+            }
+         }
+
+         /* Missing keys before, between and after */
+         for(nKey = -10; nKey <= 60; nKey++) {
+            if(nKey == -5 || nKey % 5 == 0) {
+               continue;
+            }
+            uErr = QCBORSeqIndex_SeekToKey(&DCtx, Index, nKey);
+            if(uErr != QCBOR_ERR_LABEL_NOT_FOUND) {
+               return nTestBase + 6;
+            }
+         }
+         uErr = QCBORSeqIndex_SeekToKey(&DCtx, Index, 15);
+         if(uErr != QCBOR_ERR_LABEL_NOT_FOUND) {
+            return nTestBase + 7;
+         }
+         uErr = QCBORSeqIndex_SeekToKey(&DCtx, Index, INT64_MAX);
+         if(uErr != QCBOR_ERR_LABEL_NOT_FOUND) {
+            return nTestBase + 8;
+         }
+      }
+   }
+
+   /* The index is itself CBOR */
+   QCBORDecode_Init(&DCtx, Index, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   QCBORDecode_GetUInt64(&DCtx, &auOffsets[0]);
+   QCBORDecode_GetUInt64(&DCtx, &auOffsets[1]);
+   QCBORDecode_GetUInt64(&DCtx, &auOffsets[2]);
+   QCBORDecode_GetByteString(&DCtx, &Index2);
+   QCBORDecode_ExitArray(&DCtx);
+   uErr = QCBORDecode_Finish(&DCtx);
+   if(uErr != QCBOR_SUCCESS ||
+      auOffsets[0] != 11 || auOffsets[1] != SEQ_TEST_NUM_RECORDS ||
+      auOffsets[2] != 1 || Index2.len != 16) {
+      return 2;
+   }
+
+   /* An empty sequence */
+   QCBORSeqIndex_Init(&Builder, IndexBuf1, 4, true, -1);
+   QCBORSeqIndex_AddSequence(&Builder, NULLUsefulBufC, 0);
+   uErr = QCBORSeqIndex_Finish(&Builder, &Index);
+   if(uErr != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Index,
+                        UsefulBuf_FROM_SZ_LITERAL(
+                        "\x84"
+                        "\x1b\x00\x00\x00\x00\x00\x00\x00\x04"
+                        "\x1b\x00\x00\x00\x00\x00\x00\x00\x00"
+                        "\x3b\x00\x00\x00\x00\x00\x00\x00\x00"
+                        "\x5b\x00\x00\x00\x00\x00\x00\x00\x00"))) {
+      return 3;
+   }
+   QCBORDecode_Init(&DCtx, NULLUsefulBufC, QCBOR_DECODE_MODE_NORMAL);
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 0) != QCBOR_ERR_NO_MORE_ITEMS) {
+      return 4;
+   }
+   if(QCBORSeqIndex_SeekToKey(&DCtx, Index, 0) != QCBOR_ERR_LABEL_NOT_FOUND) {
+      return 5;
+   }
+
+   return 0;
+}
+
+
+/* Set the low two bytes of the offset in the last entry of an index
+ * without keys */
+static void
+SetLastOffset(uint8_t *pIndex, size_t uIndexLen, uint64_t uOffset)
+{
+   pIndex[uIndexLen - 2] = (uint8_t)(uOffset >> 8);
+   pIndex[uIndexLen - 1] = (uint8_t)uOffset;
+}
+
+
+int32_t SeqIndexErrorTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(   SeqBuf, 600);
+   UsefulBuf_MAKE_STACK_UB(   IndexBuf, QCBOR_SEQ_INDEX_SIZE(SEQ_TEST_NUM_RECORDS, 1, true));
+   QCBORSeqIndexBuilder       Builder;
+   QCBORDecodeContext         DCtx;
+   UsefulBufC                 Sequence;
+   UsefulBufC                 Index;
+   uint64_t                   auOffsets[SEQ_TEST_NUM_RECORDS];
+   uint8_t                    auBadIndex[QCBOR_SEQ_INDEX_SIZE(SEQ_TEST_NUM_RECORDS, 4, false)];
+
+   Sequence = EncodeSeqTestRecords(SeqBuf, auOffsets);
+
+   /* Keys out of order */
+   QCBORSeqIndex_Init(&Builder, IndexBuf, 2, true, 1);
+   QCBORSeqIndex_AddRecord(&Builder, 0, 5);
+   QCBORSeqIndex_AddRecord(&Builder, 10, 4);
+   QCBORSeqIndex_AddRecord(&Builder, 20, 6);
+   if(QCBORSeqIndex_Finish(&Builder, &Index) != QCBOR_ERR_UNSUPPORTED) {
+      return 1;
+   }
+
+   /* Interval of 0 */
+   QCBORSeqIndex_Init(&Builder, IndexBuf, 0, false, 1);
+   QCBORSeqIndex_AddRecord(&Builder, 0, 0);
+   if(QCBORSeqIndex_Finish(&Builder, &Index) != QCBOR_ERR_UNSUPPORTED) {
+      return 2;
+   }
+
+   /* Records without the key label */
+   QCBORSeqIndex_Init(&Builder, IndexBuf, 2, true, 3);
+   QCBORSeqIndex_AddSequence(&Builder, Sequence, 0);
+   if(QCBORSeqIndex_Finish(&Builder, &Index) != QCBOR_ERR_LABEL_NOT_FOUND) {
+      return 3;
+   }
+
+   /* Key that is not an integer */
+   QCBORSeqIndex_Init(&Builder, IndexBuf, 2, true, 1);
+   QCBORSeqIndex_AddSequence(&Builder, UsefulBuf_FROM_SZ_LITERAL("\xa1\x01\x61x"), 0);
+   if(QCBORSeqIndex_Finish(&Builder, &Index) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 4;
+   }
+
+   /* Record that is not a map */
+   QCBORSeqIndex_Init(&Builder, IndexBuf, 2, true, 1);
+   QCBORSeqIndex_AddSequence(&Builder, UsefulBuf_FROM_SZ_LITERAL("\x81\x01"), 0);
+   if(QCBORSeqIndex_Finish(&Builder, &Index) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 5;
+   }
+
+   /* Truncated record */
+   QCBORSeqIndex_Init(&Builder, IndexBuf, 2, false, 1);
+   QCBORSeqIndex_AddSequence(&Builder, UsefulBuf_FROM_SZ_LITERAL("\x01\x82\x01"), 0);
+   if(QCBORSeqIndex_Finish(&Builder, &Index) != QCBOR_ERR_HIT_END) {
+      return 6;
+   }
+
+   /* Storage too small */
+   QCBORSeqIndex_Init(&Builder, (UsefulBuf){IndexBuf.ptr, 50}, 1, true, 1);
+   QCBORSeqIndex_AddSequence(&Builder, Sequence, 0);
+   if(QCBORSeqIndex_Finish(&Builder, &Index) != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 7;
+   }
+
+   /* Build a good index to damage */
+   QCBORSeqIndex_Init(&Builder, (UsefulBuf){auBadIndex, sizeof(auBadIndex)}, 4, false, 0);
+   QCBORSeqIndex_AddSequence(&Builder, Sequence, 0);
+   if(QCBORSeqIndex_Finish(&Builder, &Index) != QCBOR_SUCCESS) {
+      return 8;
+   }
+   QCBORDecode_Init(&DCtx, Sequence, QCBOR_DECODE_MODE_NORMAL);
+
+   /* Wrong number of records for the entries */
+   auBadIndex[18] = 13;
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 0) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 9;
+   }
+   auBadIndex[18] = 8;
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 0) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 10;
+   }
+   /* More records than the sequence has */
+   auBadIndex[18] = 12;
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 12) != QCBOR_ERR_NO_MORE_ITEMS) {
+      return 11;
+   }
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 11) != QCBOR_ERR_HIT_END) {
+      return 12;
+   }
+   auBadIndex[18] = SEQ_TEST_NUM_RECORDS;
+
+   /* Interval of 0 */
+   auBadIndex[9] = 0;
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 0) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 13;
+   }
+   auBadIndex[9] = 4;
+
+   /* Truncated */
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, UsefulBuf_Head(Index, Index.len - 1), 0) != QCBOR_ERR_UNEXPECTED_TYPE) {
+      return 14;
+   }
+
+   /* Offset past the end of the sequence */
+   SetLastOffset(auBadIndex, Index.len, 0xffff);
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 8) != QCBOR_ERR_HIT_END) {
+      return 15;
+   }
+   /* Offset that is not at a record so skipping goes off the end */
+   SetLastOffset(auBadIndex, Index.len, Sequence.len - 1);
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 9) != QCBOR_ERR_HIT_END) {
+      return 16;
+   }
+
+   /* Good again and the decoder works after the errors */
+   SetLastOffset(auBadIndex, Index.len, auOffsets[8]);
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 9) != QCBOR_SUCCESS) {
+      return 17;
+   }
+   if(CheckSeqTestRecord(&DCtx, 9)) {
+      return 18;
+   }
+
+   /* Not at the top level of the decoder */
+   QCBORDecode_Rewind(&DCtx);
+   QCBORDecode_EnterMap(&DCtx, NULL);
+   if(QCBORSeqIndex_SeekToRecord(&DCtx, Index, 0) != QCBOR_ERR_UNSUPPORTED) {
+      return 19;
+   }
+
+   return 0;
+}
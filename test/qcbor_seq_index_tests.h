@@ -0,0 +1,32 @@
+/*==============================================================================
+ qcbor_seq_index_tests.h -- tests for the offset index of CBOR sequences
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_seq_index_tests_h
+#define qcbor_seq_index_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Builds indexes with several intervals at append time and after the
+ fact, checks they are the same and seeks to every record and to keys
+ that repeat, are missing and are out of range.
+ */
+int32_t SeqIndexTest(void);
+
+
+/*
+ Checks keys out of order, records without keys, storage too small,
+ and indexes that are not well-formed.
+ */
+int32_t SeqIndexErrorTest(void);
+
+
+#endif /* qcbor_seq_index_tests_h */
@@ -0,0 +1,587 @@
+/*==============================================================================
+ qcbor_struct_tests.c -- tests for table-driven encoding and decoding of
+ C structures
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_struct_tests.h"
+#include "qcbor/qcbor_struct.h"
+#include "qcbor/qcbor_spiffy_decode.h"
+#include <string.h> /* For memset() */
+
+
+typedef struct {
+   uint32_t   uPresent;
+   int64_t    nX;
+   int64_t    nY;
+} TestPoint;
+
+typedef struct {
+   uint32_t   uPresent;
+   int64_t    nAlg;
+   UsefulBufC Kid;
+   uint64_t   uCount;
+   bool       bFlag;
+   UsefulBufC Name;
+   TestPoint  Origin;
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   double     dScale;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+} TestMessage;
+
+
+static const QCBORStructField sPointFields[] = {
+   QCBOR_STRUCT_FIELD_N(1, TestPoint, nX, QCBOR_STRUCT_INT64, QCBOR_STRUCT_REQUIRED),
+   QCBOR_STRUCT_FIELD_N(2, TestPoint, nY, QCBOR_STRUCT_INT64, QCBOR_STRUCT_REQUIRED),
+};
+
+static const QCBORStructDesc sPointDesc = QCBOR_STRUCT_DESC(TestPoint, uPresent, sPointFields);
+
+static const QCBORStructField sMessageFields[] = {
+   QCBOR_STRUCT_FIELD_N(1, TestMessage, nAlg, QCBOR_STRUCT_INT64, QCBOR_STRUCT_REQUIRED),
+   QCBOR_STRUCT_FIELD_N(4, TestMessage, Kid, QCBOR_STRUCT_BYTES, 0),
+   QCBOR_STRUCT_FIELD_N(-70000, TestMessage, uCount, QCBOR_STRUCT_UINT64, 0),
+   QCBOR_STRUCT_FIELD_SZ("flag", TestMessage, bFlag, QCBOR_STRUCT_BOOL, 0),
+   QCBOR_STRUCT_FIELD_SZ("name", TestMessage, Name, QCBOR_STRUCT_TEXT, QCBOR_STRUCT_REQUIRED),
+   QCBOR_STRUCT_MAP_SZ("origin", TestMessage, Origin, 0, &sPointDesc),
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   QCBOR_STRUCT_FIELD_N(9, TestMessage, dScale, QCBOR_STRUCT_DOUBLE, 0),
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+};
+
+static const QCBORStructDesc sMessageDesc = QCBOR_STRUCT_DESC(TestMessage, uPresent, sMessageFields);
+
+static const QCBORStructDesc sTooManyDesc = {
+   sMessageFields, (uint16_t)offsetof(TestMessage, uPresent), QCBOR_STRUCT_MAX_FIELDS + 1
+};
+
+
+static const uint8_t spKid[] = {0x01, 0x02, 0x03};
+
+
+/* The same as QCBOREncode_AddStruct() would for a full TestMessage */
+static void
+EncodeMessageByHand(QCBOREncodeContext *pECtx, const TestMessage *pMessage)
+{
+   QCBOREncode_OpenMap(pECtx);
+   QCBOREncode_AddInt64ToMapN(pECtx, 1, pMessage->nAlg);
+   QCBOREncode_AddBytesToMapN(pECtx, 4, pMessage->Kid);
+   QCBOREncode_AddUInt64ToMapN(pECtx, -70000, pMessage->uCount);
+   QCBOREncode_AddBoolToMap(pECtx, "flag", pMessage->bFlag);
+   QCBOREncode_AddTextToMap(pECtx, "name", pMessage->Name);
+   QCBOREncode_OpenMapInMap(pECtx, "origin");
+   QCBOREncode_AddInt64ToMapN(pECtx, 1, pMessage->Origin.nX);
+   QCBOREncode_AddInt64ToMapN(pECtx, 2, pMessage->Origin.nY);
+   QCBOREncode_CloseMap(pECtx);
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   QCBOREncode_AddDoubleToMapN(pECtx, 9, pMessage->dScale);
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+   QCBOREncode_CloseMap(pECtx);
+}
+
+
+int32_t StructRoundTripTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(   StructBuf, 200);
+   UsefulBuf_MAKE_STACK_UB(   HandBuf, 200);
+   QCBOREncodeContext         ECtx;
+   QCBORDecodeContext         DCtx;
+   TestMessage                Message;
+   TestMessage                Decoded;
+   UsefulBufC                 Encoded;
+   UsefulBufC                 Expected;
+
+   memset(&Message, 0, sizeof(Message));
+   Message.uPresent  = 0xffffffff;
+   Message.nAlg      = -7;
+   Message.Kid       = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spKid);
+   Message.uCount    = UINT64_MAX;
+   Message.bFlag     = true;
+   Message.Name      = UsefulBuf_FROM_SZ_LITERAL("hello");
+   Message.Origin.nX = INT64_MIN;
+   Message.Origin.nY = 100000;
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   Message.dScale    = 1.5;
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+   QCBOREncode_Init(&ECtx, StructBuf);
+   QCBOREncode_AddStruct(&ECtx, &sMessageDesc, &Message);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return -1;
+   }
+
+   QCBOREncode_Init(&ECtx, HandBuf);
+   EncodeMessageByHand(&ECtx, &Message);
+   if(QCBOREncode_Finish(&ECtx, &Expected)) {
+      return -2;
+   }
+   if(UsefulBuf_Compare(Encoded, Expected)) {
+      return -3;
+   }
+
+   memset(&Decoded, 0, sizeof(Decoded));
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetStruct(&DCtx, &sMessageDesc, &Decoded);
+   if(QCBORDecode_Finish(&DCtx)) {
+      return -4;
+   }
+   if(Decoded.uPresent != (1U << (sizeof(sMessageFields)/sizeof(sMessageFields[0]))) - 1 ||
+      Decoded.Origin.uPresent != 0x03 ||
+      Decoded.nAlg != Message.nAlg ||
+      UsefulBuf_Compare(Decoded.Kid, Message.Kid) ||
+      Decoded.uCount != Message.uCount ||
+      Decoded.bFlag != Message.bFlag ||
+      UsefulBuf_Compare(Decoded.Name, Message.Name) ||
+      Decoded.Origin.nX != Message.Origin.nX ||
+      Decoded.Origin.nY != Message.Origin.nY) {
+      return -5;
+   }
+#ifndef USEFULBUF_DISABLE_ALL_FLOAT
+   if(Decoded.dScale != Message.dScale) {
+      return -6;
+   }
+#endif /* USEFULBUF_DISABLE_ALL_FLOAT */
+
+   /* Only required members and the flag */
+   Message.uPresent = 1U << 3;
+   QCBOREncode_Init(&ECtx, StructBuf);
+   QCBOREncode_AddStruct(&ECtx, &sMessageDesc, &Message);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return -7;
+   }
+   QCBOREncode_Init(&ECtx, HandBuf);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMapN(&ECtx, 1, Message.nAlg);
+   QCBOREncode_AddBoolToMap(&ECtx, "flag", Message.bFlag);
+   QCBOREncode_AddTextToMap(&ECtx, "name", Message.Name);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Expected) || UsefulBuf_Compare(Encoded, Expected)) {
+      return -8;
+   }
+
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetStruct(&DCtx, &sMessageDesc, &Decoded);
+   if(QCBORDecode_Finish(&DCtx) || Decoded.uPresent != (1U << 0 | 1U << 3 | 1U << 4)) {
+      return -9;
+   }
+
+   /* More members than there are present bits. The members aren't
+    * looked at. */
+   QCBOREncode_Init(&ECtx, StructBuf);
+   QCBOREncode_AddStruct(&ECtx, &sTooManyDesc, &Message);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_ERR_UNSUPPORTED) {
+      return -10;
+   }
+   QCBORDecode_Init(&DCtx, Expected, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetStruct(&DCtx, &sTooManyDesc, &Decoded);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_UNSUPPORTED) {
+      return -11;
+   }
+
+   return 0;
+}
+
+
+struct StructDecodeTestCase {
+   UsefulBufC Encoded;
+   QCBORError uExpectedErr;
+};
+
+/* The encoded CBOR is given as a string literal of hex escapes */
+#define STRUCT_TEST_CASE(szEncoded, uExpectedErr) \
+   {{szEncoded, sizeof(szEncoded) - 1}, uExpectedErr}
+
+static const struct StructDecodeTestCase sStructDecodeTestCases[] = {
+   /* {"name": "x", 1: 5}, out of order */
+   STRUCT_TEST_CASE("\xa2\x64name\x61x\x01\x05", QCBOR_SUCCESS),
+   /* Extra members including nested containers */
+   STRUCT_TEST_CASE("\xa4\x01\x05\x02\x82\xa1\x01\x02\x80\x64name\x61x\x61z\xa0", QCBOR_SUCCESS),
+#ifndef QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS
+   /* Indefinite lengths */
+   STRUCT_TEST_CASE("\xbf\x01\x05\x64name\x61x\x66origin\xbf\x01\x00\x02\x00\xff\xff", QCBOR_SUCCESS),
+#endif /* QCBOR_DISABLE_INDEFINITE_LENGTH_ARRAYS */
+   /* Missing "name" */
+   STRUCT_TEST_CASE("\xa1\x01\x05", QCBOR_ERR_LABEL_NOT_FOUND),
+   /* Missing 2 in origin */
+   STRUCT_TEST_CASE("\xa3\x01\x05\x64name\x61x\x66origin\xa1\x01\x00", QCBOR_ERR_LABEL_NOT_FOUND),
+   /* 1 twice */
+   STRUCT_TEST_CASE("\xa3\x01\x05\x64name\x61x\x01\x06", QCBOR_ERR_DUPLICATE_LABEL),
+   /* Text for 1 */
+   STRUCT_TEST_CASE("\xa2\x01\x61x\x64name\x61x", QCBOR_ERR_UNEXPECTED_TYPE),
+   /* Too large for int64_t */
+   STRUCT_TEST_CASE("\xa2\x01\x1b\xff\xff\xff\xff\xff\xff\xff\xff\x64name\x61x", QCBOR_ERR_INT_OVERFLOW),
+   /* Negative for uint64_t */
+   STRUCT_TEST_CASE("\xa3\x01\x05\x64name\x61x\x3a\x00\x01\x11\x6f\x20", QCBOR_ERR_NUMBER_SIGN_CONVERSION),
+   /* Array for origin */
+   STRUCT_TEST_CASE("\xa3\x01\x05\x64name\x61x\x66origin\x80", QCBOR_ERR_UNEXPECTED_TYPE),
+   /* Not a map */
+   STRUCT_TEST_CASE("\x82\x01\x05", QCBOR_ERR_UNEXPECTED_TYPE),
+   /* Not well formed */
+   STRUCT_TEST_CASE("\xa2\x01\x05\x64name", QCBOR_ERR_HIT_END),
+};
+
+
+static const uint8_t spInArray[] = {
+   0x82, 0xa2, 0x01, 0x05, 0x64, 'n', 'a', 'm', 'e', 0x61, 'x', 0x07
+};
+
+
+int32_t StructDecodeTest(void)
+{
+   QCBORDecodeContext DCtx;
+   TestMessage        Decoded;
+   QCBORItem          Item;
+   QCBORError         uErr;
+   size_t             uIndex;
+
+   for(uIndex = 0; uIndex < sizeof(sStructDecodeTestCases)/sizeof(sStructDecodeTestCases[0]); uIndex++) {
+      QCBORDecode_Init(&DCtx, sStructDecodeTestCases[uIndex].Encoded, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_GetStruct(&DCtx, &sMessageDesc, &Decoded);
+      uErr = QCBORDecode_GetError(&DCtx);
+      if(uErr != sStructDecodeTestCases[uIndex].uExpectedErr) {
+         return (int32_t)(uIndex * 100 + uErr);
+      }
+      if(uErr == QCBOR_SUCCESS) {
+         if(Decoded.nAlg != 5 || Decoded.Name.len != 1 || QCBORDecode_Finish(&DCtx)) {
+            return (int32_t)(uIndex * 100 + 99);
+         }
+      }
+   }
+
+   /* Nested in an array and followed by another item */
+   QCBORDecode_Init(&DCtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spInArray), QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_EnterArray(&DCtx, NULL);
+   QCBORDecode_GetStruct(&DCtx, &sMessageDesc, &Decoded);
+   QCBORDecode_VGetNext(&DCtx, &Item);
+   QCBORDecode_ExitArray(&DCtx);
+   if(QCBORDecode_Finish(&DCtx) || Item.val.int64 != 7 || Decoded.uPresent != 0x11) {
+      return -1;
+   }
+
+   return 0;
+}
+
+
+/*
+ [{1: 10, "name": "a", "n": 100, "extra": [1, 2], "ok": true},
+  {1: 11, "name": "b", "n": 101, "extra": [], "ok": false},
+  {"ok": true, "name": "c", 1: 12},
+  {1: 13, "name": "d", "n": null, "ok": null}]
+ */
+static UsefulBufC
+ColumnTest_MakeRecords(UsefulBuf Buffer)
+{
+   QCBOREncodeContext ECtx;
+   UsefulBufC         Encoded;
+
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenArray(&ECtx);
+
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMapN(&ECtx, 1, 10);
+   QCBOREncode_AddSZStringToMap(&ECtx, "name", "a");
+   QCBOREncode_AddUInt64ToMap(&ECtx, "n", 100);
+   QCBOREncode_OpenArrayInMap(&ECtx, "extra");
+   QCBOREncode_AddInt64(&ECtx, 1);
+   QCBOREncode_AddInt64(&ECtx, 2);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddBoolToMap(&ECtx, "ok", true);
+   QCBOREncode_CloseMap(&ECtx);
+
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMapN(&ECtx, 1, 11);
+   QCBOREncode_AddSZStringToMap(&ECtx, "name", "b");
+   QCBOREncode_AddUInt64ToMap(&ECtx, "n", 101);
+   QCBOREncode_OpenArrayInMap(&ECtx, "extra");
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddBoolToMap(&ECtx, "ok", false);
+   QCBOREncode_CloseMap(&ECtx);
+
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddBoolToMap(&ECtx, "ok", true);
+   QCBOREncode_AddSZStringToMap(&ECtx, "name", "c");
+   QCBOREncode_AddInt64ToMapN(&ECtx, 1, 12);
+   QCBOREncode_CloseMap(&ECtx);
+
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMapN(&ECtx, 1, 13);
+   QCBOREncode_AddSZStringToMap(&ECtx, "name", "d");
+   QCBOREncode_AddNULLToMap(&ECtx, "n");
+   QCBOREncode_AddNULLToMap(&ECtx, "ok");
+   QCBOREncode_CloseMap(&ECtx);
+
+   QCBOREncode_CloseArray(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_SUCCESS) {
+      return NULLUsefulBufC;
+   }
+   return Encoded;
+}
+
+
+struct ColumnTestCase {
+   UsefulBufC Encoded;
+   QCBORError uExpectedErr;
+   size_t     uExpectedRows;
+};
+
+#define COLUMN_TEST_CASE(sz, err, rows) {{(sz), sizeof(sz) - 1}, (err), (rows)}
+
+static const struct ColumnTestCase sColumnDecodeTestCases[] = {
+   /* Empty */
+   COLUMN_TEST_CASE("\x80", QCBOR_SUCCESS, 0),
+   /* Not an array */
+   COLUMN_TEST_CASE("\xa0", QCBOR_ERR_UNEXPECTED_TYPE, 0),
+   /* Not a map in the array */
+   COLUMN_TEST_CASE("\x82\xa2\x01\x01\x64name\x60\x01", QCBOR_ERR_UNEXPECTED_TYPE, 1),
+   /* Missing required 1 */
+   COLUMN_TEST_CASE("\x81\xa1\x64name\x60", QCBOR_ERR_LABEL_NOT_FOUND, 0),
+   /* Required 1 is null */
+   COLUMN_TEST_CASE("\x81\xa2\x01\xf6\x64name\x60", QCBOR_ERR_LABEL_NOT_FOUND, 0),
+   /* 1 twice, the first null */
+   COLUMN_TEST_CASE("\x81\xa3\x01\xf6\x64name\x60\x01\x01", QCBOR_ERR_DUPLICATE_LABEL, 0),
+   /* Text for n */
+   COLUMN_TEST_CASE("\x81\xa3\x01\x01\x64name\x60\x61n\x60", QCBOR_ERR_UNEXPECTED_TYPE, 0),
+   /* More rows than room */
+   COLUMN_TEST_CASE("\x85\xa2\x01\x01\x64name\x60\xa2\x01\x01\x64name\x60"
+                    "\xa2\x01\x01\x64name\x60\xa2\x01\x01\x64name\x60"
+                    "\xa2\x01\x01\x64name\x60", QCBOR_ERR_ARRAY_TOO_LONG, 4),
+   /* Not well formed */
+   COLUMN_TEST_CASE("\x81\xa2\x01\x01\x64name", QCBOR_ERR_HIT_END, 0),
+};
+
+
+int32_t ColumnDecodeTest(void)
+{
+   QCBORDecodeContext DCtx;
+   UsefulBufC         Encoded;
+   size_t             uNumRows;
+   size_t             uIndex;
+   QCBORError         uErr;
+   int64_t            anIds[4];
+   UsefulBufC         aNames[4];
+   uint64_t           auNs[4];
+   bool               abOks[4];
+   uint8_t            uNNulls;
+   uint8_t            uOkNulls;
+   UsefulBuf_MAKE_STACK_UB(Buffer, 120);
+
+   const QCBORColumn Columns[] = {
+      QCBOR_COLUMN_N(1, QCBOR_STRUCT_INT64, QCBOR_STRUCT_REQUIRED, anIds, NULL),
+      QCBOR_COLUMN_SZ("name", QCBOR_STRUCT_TEXT, QCBOR_STRUCT_REQUIRED, aNames, NULL),
+      QCBOR_COLUMN_SZ("n", QCBOR_STRUCT_UINT64, 0, auNs, &uNNulls),
+      QCBOR_COLUMN_SZ("ok", QCBOR_STRUCT_BOOL, 0, abOks, &uOkNulls),
+   };
+   const QCBORColumn MapColumn[] = {
+      QCBOR_COLUMN_N(1, QCBOR_STRUCT_MAP, 0, anIds, NULL),
+   };
+
+   Encoded = ColumnTest_MakeRecords(Buffer);
+   if(UsefulBuf_IsNULLC(Encoded)) {
+      return 1;
+   }
+
+   uNNulls  = 0xff;
+   uOkNulls = 0xff;
+   memset(auNs, 0xff, sizeof(auNs));
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetColumns(&DCtx, Columns, 4, 4, &uNumRows);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS || uNumRows != 4) {
+      return 2;
+   }
+   for(uIndex = 0; uIndex < 4; uIndex++) {
+      if(anIds[uIndex] != 10 + (int64_t)uIndex ||
+         aNames[uIndex].len != 1 ||
+         ((const char *)aNames[uIndex].ptr)[0] != (char)('a' + uIndex)) {
+         return (int32_t)(10 + uIndex);
+      }
+   }
+   /* Rows 2 and 3 have no n, row 3 has no ok. Bits past the rows are
+    * not changed. */
+   if(auNs[0] != 100 || auNs[1] != 101 || auNs[2] != 0 || auNs[3] != 0 ||
+      uNNulls != 0xfc) {
+      return 20;
+   }
+   if(!abOks[0] || abOks[1] || !abOks[2] || abOks[3] || uOkNulls != 0xf8) {
+      return 21;
+   }
+
+   for(uIndex = 0; uIndex < sizeof(sColumnDecodeTestCases)/sizeof(sColumnDecodeTestCases[0]); uIndex++) {
+      QCBORDecode_Init(&DCtx, sColumnDecodeTestCases[uIndex].Encoded, QCBOR_DECODE_MODE_NORMAL);
+      QCBORDecode_GetColumns(&DCtx, Columns, 4, 4, &uNumRows);
+      uErr = QCBORDecode_GetError(&DCtx);
+      if(uErr != sColumnDecodeTestCases[uIndex].uExpectedErr ||
+         uNumRows != sColumnDecodeTestCases[uIndex].uExpectedRows) {
+         return (int32_t)(1000 + uIndex * 100 + uErr);
+      }
+   }
+
+   /* A map column can't be decoded this way */
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetColumns(&DCtx, MapColumn, 1, 4, &uNumRows);
+   if(QCBORDecode_GetError(&DCtx) != QCBOR_ERR_UNSUPPORTED) {
+      return 30;
+   }
+
+   return 0;
+}
+
+
+int32_t ColumnEncodeTest(void)
+{
+   QCBOREncodeContext ECtx;
+   QCBORDecodeContext DCtx;
+   UsefulBufC         Encoded;
+   UsefulBufC         Expected;
+   size_t             uNumRows;
+   size_t             uSize;
+   int64_t            anIds[3]   = {1, -2, 300};
+   UsefulBufC         aNames[3]  = {{"a", 1}, {"bb", 2}, {"", 0}};
+   bool               abOks[3]   = {true, false, true};
+   uint8_t            uOkNulls   = 0x02;
+   int64_t            anIds2[3];
+   UsefulBufC         aNames2[3];
+   bool               abOks2[3];
+   uint8_t            uOkNulls2;
+   char               szLongLabel[300];
+   UsefulBuf_MAKE_STACK_UB(Buffer,         800);
+   UsefulBuf_MAKE_STACK_UB(ExpectedBuffer, 800);
+
+   static const uint8_t spIdsTyped[] = {
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x2c
+   };
+
+   const QCBORColumn Columns[] = {
+      QCBOR_COLUMN_N(-1, QCBOR_STRUCT_INT64, QCBOR_STRUCT_REQUIRED, anIds, NULL),
+      QCBOR_COLUMN_SZ("name", QCBOR_STRUCT_TEXT, 0, aNames, NULL),
+      QCBOR_COLUMN_SZ("ok", QCBOR_STRUCT_BOOL, 0, abOks, &uOkNulls),
+   };
+   const QCBORColumn Columns2[] = {
+      QCBOR_COLUMN_N(-1, QCBOR_STRUCT_INT64, QCBOR_STRUCT_REQUIRED, anIds2, NULL),
+      QCBOR_COLUMN_SZ("name", QCBOR_STRUCT_TEXT, 0, aNames2, NULL),
+      QCBOR_COLUMN_SZ("ok", QCBOR_STRUCT_BOOL, 0, abOks2, &uOkNulls2),
+   };
+   const QCBORColumn LongColumn[] = {
+      QCBOR_COLUMN_SZ(szLongLabel, QCBOR_STRUCT_INT64, 0, anIds, NULL),
+   };
+   const QCBORColumn MapColumn[] = {
+      QCBOR_COLUMN_N(1, QCBOR_STRUCT_MAP, 0, anIds, NULL),
+   };
+
+   /* Same as adding the maps one at a time */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddColumns(&ECtx, Columns, 3, 3, 0);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_SUCCESS) {
+      return 1;
+   }
+   QCBOREncode_Init(&ECtx, ExpectedBuffer);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMapN(&ECtx, -1, 1);
+   QCBOREncode_AddSZStringToMap(&ECtx, "name", "a");
+   QCBOREncode_AddBoolToMap(&ECtx, "ok", true);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMapN(&ECtx, -1, -2);
+   QCBOREncode_AddSZStringToMap(&ECtx, "name", "bb");
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMapN(&ECtx, -1, 300);
+   QCBOREncode_AddSZStringToMap(&ECtx, "name", "");
+   QCBOREncode_AddBoolToMap(&ECtx, "ok", true);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_CloseArray(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Expected) != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Encoded, Expected) != 0) {
+      return 2;
+   }
+
+   /* And decodes back to the same */
+   QCBORDecode_Init(&DCtx, Encoded, QCBOR_DECODE_MODE_NORMAL);
+   QCBORDecode_GetColumns(&DCtx, Columns2, 3, 3, &uNumRows);
+   if(QCBORDecode_Finish(&DCtx) != QCBOR_SUCCESS || uNumRows != 3 ||
+      memcmp(anIds, anIds2, sizeof(anIds)) ||
+      UsefulBuf_Compare(aNames[1], aNames2[1]) ||
+      abOks2[0] != true || abOks2[2] != true || (uOkNulls2 & 0x07) != 0x02) {
+      return 3;
+   }
+
+   /* Computing only the size */
+   QCBOREncode_Init(&ECtx, SizeCalculateUsefulBuf);
+   QCBOREncode_AddColumns(&ECtx, Columns, 3, 3, 0);
+   if(QCBOREncode_FinishGetSize(&ECtx, &uSize) != QCBOR_SUCCESS || uSize != Encoded.len) {
+      return 4;
+   }
+
+   /* As typed arrays. The column with a null is an ordinary array. */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddColumns(&ECtx, Columns, 3, 3, QCBOR_COLUMNS_TYPED_ARRAYS);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_SUCCESS) {
+      return 10;
+   }
+   QCBOREncode_Init(&ECtx, ExpectedBuffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64(&ECtx, -1);
+   QCBOREncode_AddTag(&ECtx, 75);
+   QCBOREncode_AddBytes(&ECtx, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIdsTyped));
+   QCBOREncode_OpenArrayInMap(&ECtx, "name");
+   QCBOREncode_AddSZString(&ECtx, "a");
+   QCBOREncode_AddSZString(&ECtx, "bb");
+   QCBOREncode_AddSZString(&ECtx, "");
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_OpenArrayInMap(&ECtx, "ok");
+   QCBOREncode_AddBool(&ECtx, true);
+   QCBOREncode_AddNULL(&ECtx);
+   QCBOREncode_AddBool(&ECtx, true);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Expected) != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Encoded, Expected) != 0) {
+      return 11;
+   }
+
+   /* Without nulls the bools are a uint8 typed array */
+   uOkNulls = 0;
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddColumns(&ECtx, &Columns[2], 1, 3, QCBOR_COLUMNS_TYPED_ARRAYS);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Encoded, UsefulBuf_FROM_SZ_LITERAL("\xa1\x62ok\xd8\x40\x43\x01\x00\x01"))) {
+      return 12;
+   }
+
+   /* A label too long to encode once is encoded for each row */
+   memset(szLongLabel, 'x', sizeof(szLongLabel) - 1);
+   szLongLabel[sizeof(szLongLabel) - 1] = '\0';
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddColumns(&ECtx, LongColumn, 1, 2, 0);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_SUCCESS ||
+      Encoded.len != 1 + 2 * (1 + 3 + 299 + 1)) {
+      return 13;
+   }
+
+   /* Errors */
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddColumns(&ECtx, Columns, 3, QCBOR_MAX_ITEMS_IN_ARRAY + 1, 0);
+   if(QCBOREncode_GetErrorState(&ECtx) != QCBOR_ERR_ARRAY_TOO_LONG) {
+      return 20;
+   }
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddColumns(&ECtx, MapColumn, 1, 1, 0);
+   if(QCBOREncode_GetErrorState(&ECtx) != QCBOR_ERR_UNSUPPORTED) {
+      return 21;
+   }
+   QCBOREncode_Init(&ECtx, (UsefulBuf){Buffer.ptr, 20});
+   QCBOREncode_AddColumns(&ECtx, Columns, 3, 3, 0);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 22;
+   }
+
+   return 0;
+}
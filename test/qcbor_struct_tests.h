@@ -0,0 +1,48 @@
+/*==============================================================================
+ qcbor_struct_tests.h -- tests for table-driven encoding and decoding of
+ C structures
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_struct_tests_h
+#define qcbor_struct_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Encodes a structure with nested structures and checks the output is
+ the same as from the equivalent QCBOREncode_AddXxxToMapN() calls,
+ then decodes it back and compares.
+ */
+int32_t StructRoundTripTest(void);
+
+
+/*
+ Decodes maps in a different order, with extra members, with missing
+ members, with duplicates and with members of the wrong type.
+ */
+int32_t StructDecodeTest(void);
+
+
+/*
+ Decodes an array of maps into columns, with maps in different orders,
+ missing and null members and members not in the columns, and checks
+ the errors.
+ */
+int32_t ColumnDecodeTest(void);
+
+
+/*
+ Encodes columns as an array of maps and as typed arrays and compares
+ to the same made with the regular encoding functions.
+ */
+int32_t ColumnEncodeTest(void);
+
+
+#endif /* qcbor_struct_tests_h */
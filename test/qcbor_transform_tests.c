@@ -0,0 +1,344 @@
+/*==============================================================================
+ qcbor_transform_tests.c -- tests for streaming transformation of CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_transform_tests.h"
+#include "qcbor/qcbor_transform.h"
+
+
+/*
+ One stage that does what its rules say. Labels are matched as text.
+ */
+typedef struct {
+   const char *szDrop;
+   const char *szRename;
+   int64_t     nRenameTo;
+   const char *szReplace;
+   UsefulBufC  Replacement;
+   const char *szSort;
+   bool        bSkipNested;
+   bool        bDropTop;
+   int         nCalls;
+   int         nFailOnCall; /* 0 for never */
+} TransformRules;
+
+
+static bool
+TransformTest_LabelIs(const QCBORTransformItem *pItem, const char *szLabel)
+{
+   return szLabel != NULL &&
+          pItem->uLabelType == QCBOR_TYPE_TEXT_STRING &&
+          UsefulBuf_Compare(pItem->label.string, UsefulBuf_FromSZ(szLabel)) == 0;
+}
+
+
+static QCBORError
+TransformTest_Stage(void *pStageCtx, const QCBORTransformItem *pItem, QCBORTransformEdit *pEdit)
+{
+   TransformRules *pRules = (TransformRules *)pStageCtx;
+
+   pRules->nCalls++;
+   if(pRules->nCalls == pRules->nFailOnCall) {
+      return QCBOR_ERR_CALLBACK_FAIL;
+   }
+
+   if(TransformTest_LabelIs(pItem, pRules->szDrop) ||
+      (pRules->bDropTop && pItem->uNestLevel == 0)) {
+      pEdit->bDrop = true;
+   }
+   if(TransformTest_LabelIs(pItem, pRules->szRename)) {
+      pEdit->uNewLabelType = QCBOR_TYPE_INT64;
+      pEdit->nNewLabel     = pRules->nRenameTo;
+   }
+   if(TransformTest_LabelIs(pItem, pRules->szReplace)) {
+      pEdit->NewValue = pRules->Replacement;
+   }
+   if(TransformTest_LabelIs(pItem, pRules->szSort)) {
+      pEdit->bSortMap = true;
+   }
+   pEdit->bSkipMembers = pRules->bSkipNested && pItem->uNestLevel > 0;
+
+   return QCBOR_SUCCESS;
+}
+
+
+/*
+ {"a": 1, "password": "x", "n": [1, 2, 3],
+  "inner": 55799({"password": "y", "z": 2, "b": 1}), "c": h'01'}
+ */
+static UsefulBufC
+TransformTest_MakeInput(UsefulBuf Buffer)
+{
+   QCBOREncodeContext ECtx;
+   UsefulBufC         Encoded;
+   static const uint8_t aByte[] = {0x01};
+
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMap(&ECtx, "a", 1);
+   QCBOREncode_AddSZStringToMap(&ECtx, "password", "x");
+   QCBOREncode_OpenArrayInMap(&ECtx, "n");
+   QCBOREncode_AddInt64(&ECtx, 1);
+   QCBOREncode_AddInt64(&ECtx, 2);
+   QCBOREncode_AddInt64(&ECtx, 3);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddSZString(&ECtx, "inner");
+   QCBOREncode_AddTag(&ECtx, CBOR_TAG_CBOR_MAGIC);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddSZStringToMap(&ECtx, "password", "y");
+   QCBOREncode_AddInt64ToMap(&ECtx, "z", 2);
+   QCBOREncode_AddInt64ToMap(&ECtx, "b", 1);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddBytesToMap(&ECtx, "c", UsefulBuf_FROM_BYTE_ARRAY_LITERAL(aByte));
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) != QCBOR_SUCCESS) {
+      return NULLUsefulBufC;
+   }
+   return Encoded;
+}
+
+
+static QCBORError
+TransformTest_Run(UsefulBufC                 Input,
+                  const QCBORTransformStage *pStages,
+                  size_t                     uNumStages,
+                  UsefulBuf                  Buffer,
+                  UsefulBufC                *pOutput)
+{
+   QCBOREncodeContext ECtx;
+
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_AddTransformed(&ECtx, Input, pStages, uNumStages);
+   return QCBOREncode_Finish(&ECtx, pOutput);
+}
+
+
+int32_t
+TransformTest(void)
+{
+   QCBOREncodeContext  ECtx;
+   UsefulBufC          Input;
+   UsefulBufC          Output;
+   UsefulBufC          Expected;
+   TransformRules      Rules;
+   TransformRules      Rules2;
+   QCBORTransformStage Stages[2];
+   size_t              uSize;
+   UsefulBuf_MAKE_STACK_UB(InBuffer,       100);
+   UsefulBuf_MAKE_STACK_UB(OutBuffer,      100);
+   UsefulBuf_MAKE_STACK_UB(ExpectedBuffer, 100);
+   static const uint8_t aByte[] = {0x01};
+   static const uint8_t aNull[] = {0xf6};
+
+   Input = TransformTest_MakeInput(InBuffer);
+   if(UsefulBuf_IsNULLC(Input)) {
+      return 1;
+   }
+
+   /* Without any stages the output is the input */
+   if(TransformTest_Run(Input, NULL, 0, OutBuffer, &Output) != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Input, Output) != 0) {
+      return 2;
+   }
+
+   /* Nothing changed and everything visited still copies as is */
+   memset(&Rules, 0, sizeof(Rules));
+   Stages[0].pfStage   = TransformTest_Stage;
+   Stages[0].pStageCtx = &Rules;
+   if(TransformTest_Run(Input, Stages, 1, OutBuffer, &Output) != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Input, Output) != 0) {
+      return 3;
+   }
+   /* The map, its five values and the three array and three map members */
+   if(Rules.nCalls != 12) {
+      return 4;
+   }
+
+   /* Skipping inside the members of the top map visits only it and them */
+   memset(&Rules, 0, sizeof(Rules));
+   Rules.bSkipNested = true;
+   if(TransformTest_Run(Input, Stages, 1, OutBuffer, &Output) != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Input, Output) != 0 ||
+      Rules.nCalls != 6) {
+      return 5;
+   }
+
+   /* Drop, rename, replace and sort in one stage. The nested map is
+    * gone into so the drop applies there too. */
+   memset(&Rules, 0, sizeof(Rules));
+   Rules.szDrop      = "password";
+   Rules.szRename    = "a";
+   Rules.nRenameTo   = -7;
+   Rules.szReplace   = "n";
+   Rules.Replacement = UsefulBuf_FROM_BYTE_ARRAY_LITERAL(aNull);
+   Rules.szSort      = "inner";
+   if(TransformTest_Run(Input, Stages, 1, OutBuffer, &Output) != QCBOR_SUCCESS) {
+      return 10;
+   }
+
+   QCBOREncode_Init(&ECtx, ExpectedBuffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMapN(&ECtx, -7, 1);
+   QCBOREncode_AddNULLToMap(&ECtx, "n");
+   QCBOREncode_AddSZString(&ECtx, "inner");
+   QCBOREncode_AddTag(&ECtx, CBOR_TAG_CBOR_MAGIC);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMap(&ECtx, "b", 1);
+   QCBOREncode_AddInt64ToMap(&ECtx, "z", 2);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddBytesToMap(&ECtx, "c", UsefulBuf_FROM_BYTE_ARRAY_LITERAL(aByte));
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Expected) != QCBOR_SUCCESS) {
+      return 11;
+   }
+   if(UsefulBuf_Compare(Expected, Output) != 0) {
+      return 12;
+   }
+
+   /* The same computing only the size */
+   memset(&Rules, 0, sizeof(Rules));
+   Rules.szDrop = "password";
+   QCBOREncode_Init(&ECtx, SizeCalculateUsefulBuf);
+   QCBOREncode_AddTransformed(&ECtx, Input, Stages, 1);
+   if(QCBOREncode_FinishGetSize(&ECtx, &uSize) != QCBOR_SUCCESS ||
+      uSize != Input.len - 2 * (1 + 8 + 2)) {
+      return 13;
+   }
+
+   /* A second stage sees the rename done by the first */
+   memset(&Rules, 0, sizeof(Rules));
+   Rules.szRename  = "c";
+   Rules.nRenameTo = 3;
+   memset(&Rules2, 0, sizeof(Rules2));
+   Stages[1].pfStage   = TransformTest_Stage;
+   Stages[1].pStageCtx = &Rules2;
+   if(TransformTest_Run(Input, Stages, 2, OutBuffer, &Output) != QCBOR_SUCCESS ||
+      Output.len != Input.len - 1 ||
+      ((const uint8_t *)Output.ptr)[Output.len - 3] != 0x03) {
+      return 20;
+   }
+   Rules.bSkipNested = true;
+   Rules.nCalls      = 0;
+   Rules2.szRename   = NULL;
+   Rules2.szDrop     = "c";
+   Rules2.nCalls     = 0;
+   if(TransformTest_Run(Input, Stages, 2, OutBuffer, &Output) != QCBOR_SUCCESS ||
+      UsefulBuf_Compare(Output, Input) == 0) {
+      return 21;
+   }
+   /* Only when all stages skip is a nested array or map not gone into */
+   if(Rules.nCalls != 12 || Rules2.nCalls != 12) {
+      return 22;
+   }
+   /* Stages after the one that drops aren't called */
+   Rules.nCalls       = 0;
+   Rules.szDrop       = "a";
+   Rules2.nCalls      = 0;
+   Rules2.szDrop      = NULL;
+   Rules2.bSkipNested = true;
+   if(TransformTest_Run(Input, Stages, 2, OutBuffer, &Output) != QCBOR_SUCCESS ||
+      Rules.nCalls != 6 || Rules2.nCalls != 5) {
+      return 23;
+   }
+
+   /* The top item dropped adds nothing to the open array */
+   memset(&Rules, 0, sizeof(Rules));
+   Rules.bDropTop = true;
+   QCBOREncode_Init(&ECtx, OutBuffer);
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_AddSZString(&ECtx, "inner");
+   QCBOREncode_AddTransformed(&ECtx, Input, Stages, 1);
+   QCBOREncode_AddTransformed(&ECtx, Input, NULL, 0);
+   QCBOREncode_CloseArray(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Output) != QCBOR_SUCCESS ||
+      Rules.nCalls != 1 ||
+      ((const uint8_t *)Output.ptr)[0] != 0x82) {
+      return 30;
+   }
+
+   return 0;
+}
+
+
+int32_t
+TransformErrorsTest(void)
+{
+   UsefulBufC          Output;
+   TransformRules      Rules;
+   QCBORTransformStage Stage;
+   UsefulBuf_MAKE_STACK_UB(InBuffer,  100);
+   UsefulBuf_MAKE_STACK_UB(OutBuffer, 100);
+
+   static const uint8_t aIndefinite[] = {0x9f, 0x01, 0xff};
+   static const uint8_t aTruncated[]  = {0x82, 0x01};
+   static const uint8_t aTwoItems[]   = {0x01, 0x02};
+   static const uint8_t aBadType7[]   = {0x81, 0xf8, 0x10};
+   static const uint8_t aReserved[]   = {0x81, 0x1c};
+   static uint8_t       aTooLong[3 + QCBOR_MAX_ITEMS_IN_ARRAY + 1];
+
+   if(TransformTest_Run(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(aIndefinite),
+                        NULL, 0, OutBuffer, &Output) != QCBOR_ERR_ENCODE_UNSUPPORTED) {
+      return 1;
+   }
+   if(TransformTest_Run(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(aTruncated),
+                        NULL, 0, OutBuffer, &Output) != QCBOR_ERR_HIT_END) {
+      return 2;
+   }
+   if(TransformTest_Run(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(aTwoItems),
+                        NULL, 0, OutBuffer, &Output) != QCBOR_ERR_EXTRA_BYTES) {
+      return 3;
+   }
+   if(TransformTest_Run(NULLUsefulBufC,
+                        NULL, 0, OutBuffer, &Output) != QCBOR_ERR_HIT_END) {
+      return 4;
+   }
+
+   /* An error from a stage stops it */
+   memset(&Rules, 0, sizeof(Rules));
+   Rules.nFailOnCall = 4;
+   Stage.pfStage     = TransformTest_Stage;
+   Stage.pStageCtx   = &Rules;
+   if(TransformTest_Run(TransformTest_MakeInput(InBuffer),
+                        &Stage, 1, OutBuffer, &Output) != QCBOR_ERR_CALLBACK_FAIL ||
+      Rules.nCalls != 4) {
+      return 5;
+   }
+
+   /* Output that doesn't fit */
+   if(TransformTest_Run(TransformTest_MakeInput(InBuffer),
+                        NULL, 0, (UsefulBuf){OutBuffer.ptr, 10}, &Output) != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return 6;
+   }
+
+   /* An array with one more item than can be output. Only the size
+    * is computed. */
+   memset(aTooLong, 0, sizeof(aTooLong));
+   aTooLong[0] = 0x99;
+   aTooLong[1] = (uint8_t)((QCBOR_MAX_ITEMS_IN_ARRAY + 1) >> 8);
+   aTooLong[2] = (uint8_t)(QCBOR_MAX_ITEMS_IN_ARRAY + 1);
+   memset(&Rules, 0, sizeof(Rules));
+   if(TransformTest_Run(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(aTooLong),
+                        &Stage, 1, SizeCalculateUsefulBuf, &Output) != QCBOR_ERR_ARRAY_TOO_LONG ||
+      Rules.nCalls != 1) {
+      return 7;
+   }
+
+   /* Not well-formed, errors as when decoding */
+   if(TransformTest_Run(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(aBadType7),
+                        NULL, 0, OutBuffer, &Output) != QCBOR_ERR_BAD_TYPE_7) {
+      return 8;
+   }
+   if(TransformTest_Run(UsefulBuf_FROM_BYTE_ARRAY_LITERAL(aReserved),
+                        NULL, 0, OutBuffer, &Output) != QCBOR_ERR_UNSUPPORTED) {
+      return 9;
+   }
+
+   return 0;
+}
@@ -0,0 +1,34 @@
+/*==============================================================================
+ qcbor_transform_tests.h -- tests for streaming transformation of CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_transform_tests_h
+#define qcbor_transform_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Drops, renames, replaces and sorts through one and several stages
+ and compares the output to the same thing made with the encoder.
+ Also checks that what isn't changed is copied as it is and that
+ stages don't see inside what they skip.
+ */
+int32_t TransformTest(void);
+
+
+/*
+ Checks the errors for input that is indefinite-length, not
+ well-formed or more than one item and that an error from a stage
+ stops the transformation.
+ */
+int32_t TransformErrorsTest(void);
+
+
+#endif /* qcbor_transform_tests_h */
@@ -0,0 +1,451 @@
+/*==============================================================================
+ qcbor_view_tests.c -- tests for lazy random-access view of encoded CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+
+#include "qcbor_view_tests.h"
+#include "qcbor/qcbor_view.h"
+#include "qcbor/qcbor_encode.h"
+
+
+/*
+ {
+   "hdr": {1: -7, 4: h'0102'},
+   "big": h'00...00' (300 bytes),
+   "route": ["a", [1, 2, 3], {"x": 1}, 5],
+   10: 1(100),
+   -20: "neg",
+   "last": true
+ }
+ */
+static UsefulBufC
+EncodeViewTestDocument(UsefulBuf Buffer)
+{
+   QCBOREncodeContext ECtx;
+   UsefulBufC         Encoded;
+   static const uint8_t spKid[] = {0x01, 0x02};
+   static const uint8_t spBig[300] = {0};
+
+   QCBOREncode_Init(&ECtx, Buffer);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_OpenMapInMap(&ECtx, "hdr");
+   QCBOREncode_AddInt64ToMapN(&ECtx, 1, -7);
+   QCBOREncode_AddBytesToMapN(&ECtx, 4, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spKid));
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddBytesToMap(&ECtx, "big", UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spBig));
+   QCBOREncode_OpenArrayInMap(&ECtx, "route");
+   QCBOREncode_AddSZString(&ECtx, "a");
+   QCBOREncode_OpenArray(&ECtx);
+   QCBOREncode_AddInt64(&ECtx, 1);
+   QCBOREncode_AddInt64(&ECtx, 2);
+   QCBOREncode_AddInt64(&ECtx, 3);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMap(&ECtx, "x", 1);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddInt64(&ECtx, 5);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddDateEpochToMapN(&ECtx, 10, 100);
+   QCBOREncode_AddSZStringToMapN(&ECtx, -20, "neg");
+   QCBOREncode_AddBoolToMap(&ECtx, "last", true);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded)) {
+      return NULLUsefulBufC;
+   }
+   return Encoded;
+}
+
+
+/* Gets the int at a path of "route", index, and optionally an index
+ * in that */
+static int32_t
+CheckRouteInt(const QCBORView *pRoot, uint32_t uIndex, uint32_t uIndex2, int64_t nExpected, QCBORViewCache *pCache)
+{
+   QCBORView Route;
+   QCBORView Element;
+   QCBORItem Item;
+
+   if(QCBORView_GetInMapSZ(pRoot, "route", pCache, &Route) ||
+      QCBORView_GetIndex(&Route, uIndex, pCache, &Element)) {
+      return 1;
+   }
+   if(uIndex2 != UINT32_MAX && QCBORView_GetIndex(&Element, uIndex2, pCache, &Element)) {
+      return 2;
+   }
+   if(QCBORView_GetItem(&Element, &Item) ||
+      Item.uDataType != QCBOR_TYPE_INT64 ||
+      Item.val.int64 != nExpected) {
+      return 3;
+   }
+   return 0;
+}
+
+
+/* The same as the test document above, but with indefinite lengths
+ * and a tagged array */
+static const uint8_t spIndefinite[] = {
+   0xbf,
+      0x63, 'h', 'd', 'r', 0xbf, 0x01, 0x26, 0xff,
+      0x63, 'b', 'i', 'g', 0x5f, 0x41, 0x00, 0x42, 0x00, 0x00, 0xff,
+      0x65, 'r', 'o', 'u', 't', 'e', 0xd9, 0x04, 0xd2, 0x9f,
+         0x7f, 0x61, 'a', 0xff,
+         0x9f, 0x01, 0x02, 0x03, 0xff,
+         0xa1, 0x61, 'x', 0x01,
+         0x05,
+      0xff,
+      0x0a, 0xc1, 0x18, 0x64,
+      0x33, 0x63, 'n', 'e', 'g',
+      0x64, 'l', 'a', 's', 't', 0xf5,
+   0xff
+};
+
+
+int32_t ViewTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(Buffer, 400);
+   QCBORView           Root;
+   QCBORView           Child;
+   QCBORView           Hdr;
+   QCBORItem           Item;
+   QCBORViewCache      Cache;
+   QCBORViewCacheEntry aEntries[4];
+   QCBORViewCache     *pCache;
+   UsefulBufC          Encoded;
+   int                 nPass;
+   int32_t             nResult;
+
+   Encoded = EncodeViewTestDocument(Buffer);
+   if(UsefulBuf_IsNULLC(Encoded)) {
+      return -1;
+   }
+
+   QCBORView_InitCache(&Cache, aEntries, 4);
+
+   /* Pass 0 without a cache, 1 with an empty cache, 2 with the cache
+    * from pass 1 and 3 with the indefinite-length document which
+    * empties the cache because it is another buffer */
+   for(nPass = 0; nPass < 4; nPass++) {
+      pCache = nPass == 0 ? NULL : &Cache;
+      if(nPass == 3) {
+         QCBORView_Init(&Root, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spIndefinite));
+      } else {
+         QCBORView_Init(&Root, Encoded);
+      }
+
+      /* Last member first */
+      if(QCBORView_GetInMapSZ(&Root, "last", pCache, &Child) ||
+         QCBORView_GetItem(&Child, &Item) ||
+         Item.uDataType != QCBOR_TYPE_TRUE) {
+         return nPass * 100 + 1;
+      }
+
+      nResult = CheckRouteInt(&Root, 3, UINT32_MAX, 5, pCache);
+      if(nResult) {
+         return nPass * 100 + 10 + nResult;
+      }
+      nResult = CheckRouteInt(&Root, 1, 2, 3, pCache);
+      if(nResult) {
+         return nPass * 100 + 20 + nResult;
+      }
+      nResult = CheckRouteInt(&Root, 1, 0, 1, pCache);
+      if(nResult) {
+         return nPass * 100 + 30 + nResult;
+      }
+
+      if(QCBORView_GetInMapSZ(&Root, "hdr", pCache, &Hdr) ||
+         QCBORView_GetInMapN(&Hdr, 1, pCache, &Child) ||
+         QCBORView_GetItem(&Child, &Item) ||
+         Item.uDataType != QCBOR_TYPE_INT64 ||
+         Item.val.int64 != -7) {
+         return nPass * 100 + 40;
+      }
+
+      if(QCBORView_GetInMapN(&Root, -20, pCache, &Child) ||
+         QCBORView_GetItem(&Child, &Item) ||
+         Item.uDataType != QCBOR_TYPE_TEXT_STRING ||
+         UsefulBuf_Compare(Item.val.string, UsefulBuf_FROM_SZ_LITERAL("neg"))) {
+         return nPass * 100 + 50;
+      }
+
+      if(QCBORView_GetInMapN(&Root, 10, pCache, &Child) ||
+         QCBORView_GetItem(&Child, &Item) ||
+         Item.uDataType != QCBOR_TYPE_DATE_EPOCH ||
+         Item.val.epochDate.nSeconds != 100) {
+         return nPass * 100 + 60;
+      }
+
+      /* The route array in the route map by index */
+      if(QCBORView_GetInMapSZ(&Root, "route", pCache, &Child) ||
+         QCBORView_GetIndex(&Child, 2, pCache, &Child) ||
+         QCBORView_GetInMapSZ(&Child, "x", pCache, &Child) ||
+         QCBORView_GetItem(&Child, &Item) ||
+         Item.val.int64 != 1) {
+         return nPass * 100 + 70;
+      }
+
+      if(pCache != NULL && pCache->uUsed != 4) {
+         return nPass * 100 + 80;
+      }
+   }
+
+   /* A cache with no entries is OK */
+   QCBORView_InitCache(&Cache, NULL, 0);
+   QCBORView_Init(&Root, Encoded);
+   if(CheckRouteInt(&Root, 1, 1, 2, &Cache)) {
+      return -2;
+   }
+
+   /* A view into the middle of a buffer */
+   Root.uOffset = Hdr.uOffset;
+   Root.Encoded = Encoded;
+   if(QCBORView_GetInMapN(&Root, 4, NULL, &Child) ||
+      QCBORView_GetItem(&Child, &Item) ||
+      Item.uDataType != QCBOR_TYPE_BYTE_STRING ||
+      Item.val.string.len != 2) {
+      return -3;
+   }
+
+   return 0;
+}
+
+
+struct ViewErrorTestCase {
+   UsefulBufC Encoded;
+   bool       bMap;
+   uint32_t   uIndex; /* Used as the label for maps */
+   QCBORError uExpectedErr;
+};
+
+/* The encoded CBOR is given as a string literal of hex escapes */
+#define VIEW_ERROR_TEST_CASE(szEncoded, bMap, uIndex, uExpectedErr) \
+   {{szEncoded, sizeof(szEncoded) - 1}, bMap, uIndex, uExpectedErr}
+
+static const struct ViewErrorTestCase sViewErrorTestCases[] = {
+   VIEW_ERROR_TEST_CASE("\x82\x01\x02", false, 1, QCBOR_SUCCESS),
+   VIEW_ERROR_TEST_CASE("\x82\x01\x02", false, 2, QCBOR_ERR_NO_MORE_ITEMS),
+   VIEW_ERROR_TEST_CASE("\x9f\x01\x02\xff", false, 2, QCBOR_ERR_NO_MORE_ITEMS),
+   VIEW_ERROR_TEST_CASE("\x80", false, 0, QCBOR_ERR_NO_MORE_ITEMS),
+   VIEW_ERROR_TEST_CASE("\xa1\x01\x02", false, 0, QCBOR_ERR_UNEXPECTED_TYPE),
+   VIEW_ERROR_TEST_CASE("\x82\x01\x02", true, 1, QCBOR_ERR_UNEXPECTED_TYPE),
+   VIEW_ERROR_TEST_CASE("\xa1\x01\x02", true, 2, QCBOR_ERR_LABEL_NOT_FOUND),
+   VIEW_ERROR_TEST_CASE("\xbf\x01\x02\xff", true, 2, QCBOR_ERR_LABEL_NOT_FOUND),
+   VIEW_ERROR_TEST_CASE("\xa2\x01\x02\x02", true, 2, QCBOR_ERR_HIT_END),
+   VIEW_ERROR_TEST_CASE("\x82\x42\x01", false, 1, QCBOR_ERR_HIT_END),
+   VIEW_ERROR_TEST_CASE("\x83\x01\xff\x02", false, 2, QCBOR_ERR_BAD_BREAK),
+   VIEW_ERROR_TEST_CASE("\x82\x1c\x01", false, 1, QCBOR_ERR_UNSUPPORTED),
+   VIEW_ERROR_TEST_CASE("\x82\x9b\xff\xff\xff\xff\xff\xff\xff\xff\x01", false, 1, QCBOR_ERR_HIT_END),
+   VIEW_ERROR_TEST_CASE("\xa2\xbb\xff\xff\xff\xff\xff\xff\xff\xff\x01\x02\x03", true, 2, QCBOR_ERR_HIT_END),
+   VIEW_ERROR_TEST_CASE("\x82\x81\x81\x81\x81\x81\x81\x81\x81\x81\x81\x81\x81\x81\x81\x81\x81\x81\x00\x01",
+                        false, 1, QCBOR_ERR_ARRAY_DECODE_NESTING_TOO_DEEP),
+   VIEW_ERROR_TEST_CASE("", false, 0, QCBOR_ERR_HIT_END),
+};
+
+
+int32_t ViewErrorTest(void)
+{
+   QCBORView  Root;
+   QCBORView  Child;
+   QCBORError uErr;
+   size_t     uIndex;
+
+   for(uIndex = 0; uIndex < sizeof(sViewErrorTestCases)/sizeof(sViewErrorTestCases[0]); uIndex++) {
+      const struct ViewErrorTestCase *pTest = &sViewErrorTestCases[uIndex];
+
+      QCBORView_Init(&Root, pTest->Encoded);
+      if(pTest->bMap) {
+         uErr = QCBORView_GetInMapN(&Root, pTest->uIndex, NULL, &Child);
+      } else {
+         uErr = QCBORView_GetIndex(&Root, pTest->uIndex, NULL, &Child);
+      }
+      if(uErr != pTest->uExpectedErr) {
+         return (int32_t)(uIndex * 100 + uErr);
+      }
+   }
+
+   return 0;
+}
+
+
+/* Gets element 2 of the array in Buffer and checks it is nExpected
+ * or, if nExpected is -1, that there is no element 2 */
+static int32_t
+CheckIndex2(UsefulBufC Buffer, QCBORViewCache *pCache, int64_t nExpected)
+{
+   QCBORView  Root;
+   QCBORView  Child;
+   QCBORItem  Item;
+   QCBORError uErr;
+
+   QCBORView_Init(&Root, Buffer);
+   uErr = QCBORView_GetIndex(&Root, 2, pCache, &Child);
+   if(nExpected == -1) {
+      return uErr == QCBOR_ERR_NO_MORE_ITEMS ? 0 : 1;
+   }
+   if(uErr != QCBOR_SUCCESS ||
+      QCBORView_GetItem(&Child, &Item) ||
+      Item.uDataType != QCBOR_TYPE_INT64 ||
+      Item.val.int64 != nExpected) {
+      return 2;
+   }
+   return 0;
+}
+
+
+int32_t ViewCacheReuseTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(Buffer, 10);
+   QCBORViewCache      Cache;
+   QCBORViewCacheEntry aEntries[2];
+   UsefulBufC          Doc;
+
+   /* [1, 2, 3] */
+   static const uint8_t spFirst[]  = {0x83, 0x01, 0x02, 0x03};
+   /* [[1, 2], 3, 4] puts element 2 somewhere else */
+   static const uint8_t spLonger[] = {0x83, 0x82, 0x01, 0x02, 0x03, 0x04};
+   /* [[1], 2] is the same length as the first, but has no element 2 */
+   static const uint8_t spSame[]   = {0x82, 0x81, 0x01, 0x02};
+
+   QCBORView_InitCache(&Cache, aEntries, 2);
+
+   Doc = UsefulBuf_Copy(Buffer, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spFirst));
+   if(CheckIndex2(Doc, &Cache, 3) || Cache.uUsed != 1) {
+      return 1;
+   }
+
+   /* A new document of another length in the same buffer empties the
+    * cache */
+   Doc = UsefulBuf_Copy(Buffer, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spLonger));
+   if(CheckIndex2(Doc, &Cache, 4)) {
+      return 2;
+   }
+
+   Doc = UsefulBuf_Copy(Buffer, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spFirst));
+   if(CheckIndex2(Doc, &Cache, 3)) {
+      return 3;
+   }
+
+   /* One of the same length needs the cache emptied by the caller */
+   Doc = UsefulBuf_Copy(Buffer, UsefulBuf_FROM_BYTE_ARRAY_LITERAL(spSame));
+   QCBORView_InitCache(&Cache, aEntries, 2);
+   if(CheckIndex2(Doc, &Cache, -1)) {
+      return 4;
+   }
+
+   return 0;
+}
+
+
+int32_t ViewReplaceTest(void)
+{
+   UsefulBuf_MAKE_STACK_UB(Buffer, 400);
+   UsefulBuf_MAKE_STACK_UB(Expected, 400);
+   QCBOREncodeContext ECtx;
+   QCBORView          Root;
+   QCBORView          Child;
+   QCBORView          Hdr;
+   QCBORItem          Item;
+   UsefulBufC         Encoded;
+   size_t             uLen;
+   size_t             uOriginalLen;
+
+   Encoded = EncodeViewTestDocument(Buffer);
+   if(UsefulBuf_IsNULLC(Encoded)) {
+      return -1;
+   }
+   uOriginalLen = Encoded.len;
+   QCBORView_Init(&Root, Encoded);
+
+   /* The same size: -7 to -8 in hdr */
+   if(QCBORView_GetInMapSZ(&Root, "hdr", NULL, &Hdr) ||
+      QCBORView_GetInMapN(&Hdr, 1, NULL, &Child) ||
+      QCBORView_Replace(&Child, Buffer, UsefulBuf_FROM_SZ_LITERAL("\x27"), &uLen) ||
+      uLen != uOriginalLen) {
+      return -2;
+   }
+   if(QCBORView_GetInMapN(&Hdr, 1, NULL, &Child) ||
+      QCBORView_GetItem(&Child, &Item) ||
+      Item.val.int64 != -8) {
+      return -3;
+   }
+
+   /* Larger: [1, 2, 3] in route to "abcdefghij" */
+   if(QCBORView_GetInMapSZ(&Root, "route", NULL, &Child) ||
+      QCBORView_GetIndex(&Child, 1, NULL, &Child) ||
+      QCBORView_Replace(&Child, Buffer, UsefulBuf_FROM_SZ_LITERAL("\x6a" "abcdefghij"), &uLen) ||
+      uLen != uOriginalLen + 7) {
+      return -4;
+   }
+   Root.Encoded.len = uLen;
+
+   /* Smaller: the 300-byte string to 1(5) */
+   if(QCBORView_GetInMapSZ(&Root, "big", NULL, &Child) ||
+      QCBORView_Replace(&Child, Buffer, UsefulBuf_FROM_SZ_LITERAL("\xc1\x05"), &uLen)) {
+      return -5;
+   }
+   Root.Encoded.len = uLen;
+
+   /* Compare to the same encoded directly */
+   QCBOREncode_Init(&ECtx, Expected);
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_OpenMapInMap(&ECtx, "hdr");
+   QCBOREncode_AddInt64ToMapN(&ECtx, 1, -8);
+   QCBOREncode_AddBytesToMapN(&ECtx, 4, UsefulBuf_FROM_SZ_LITERAL("\x01\x02"));
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddDateEpochToMap(&ECtx, "big", 5);
+   QCBOREncode_OpenArrayInMap(&ECtx, "route");
+   QCBOREncode_AddSZString(&ECtx, "a");
+   QCBOREncode_AddSZString(&ECtx, "abcdefghij");
+   QCBOREncode_OpenMap(&ECtx);
+   QCBOREncode_AddInt64ToMap(&ECtx, "x", 1);
+   QCBOREncode_CloseMap(&ECtx);
+   QCBOREncode_AddInt64(&ECtx, 5);
+   QCBOREncode_CloseArray(&ECtx);
+   QCBOREncode_AddDateEpochToMapN(&ECtx, 10, 100);
+   QCBOREncode_AddSZStringToMapN(&ECtx, -20, "neg");
+   QCBOREncode_AddBoolToMap(&ECtx, "last", true);
+   QCBOREncode_CloseMap(&ECtx);
+   if(QCBOREncode_Finish(&ECtx, &Encoded) ||
+      UsefulBuf_Compare(Encoded, Root.Encoded)) {
+      return -6;
+   }
+
+   /* Not enough space */
+   QCBORView_Init(&Root, Encoded);
+   if(QCBORView_GetInMapSZ(&Root, "last", NULL, &Child) ||
+      QCBORView_Replace(&Child, UsefulBuf_Unconst(Encoded), UsefulBuf_FROM_SZ_LITERAL("\x18\x64"), &uLen) != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return -7;
+   }
+
+   /* Not one item */
+   if(QCBORView_Replace(&Child, Expected, UsefulBuf_FROM_SZ_LITERAL("\x01\x02"), &uLen) != QCBOR_ERR_EXTRA_BYTES ||
+      QCBORView_Replace(&Child, Expected, UsefulBuf_FROM_SZ_LITERAL("\x82\x01"), &uLen) != QCBOR_ERR_HIT_END) {
+      return -8;
+   }
+
+   /* Buffer isn't the view's */
+   if(QCBORView_Replace(&Child, Buffer, UsefulBuf_FROM_SZ_LITERAL("\x01"), &uLen) != QCBOR_ERR_UNSUPPORTED) {
+      return -9;
+   }
+
+   /* Buffer shorter than the view's encoded CBOR */
+   if(QCBORView_Replace(&Child,
+                        (UsefulBuf){Expected.ptr, Child.Encoded.len - 1},
+                        UsefulBuf_FROM_SZ_LITERAL("\x01"),
+                        &uLen) != QCBOR_ERR_BUFFER_TOO_SMALL) {
+      return -11;
+   }
+
+   /* The whole thing */
+   if(QCBORView_Replace(&Root, Expected, UsefulBuf_FROM_SZ_LITERAL("\x01"), &uLen) ||
+      uLen != 1 || ((uint8_t *)Expected.ptr)[0] != 0x01) {
+      return -10;
+   }
+
+   return 0;
+}
@@ -0,0 +1,45 @@
+/*==============================================================================
+ qcbor_view_tests.h -- tests for lazy random-access view of encoded CBOR
+
+ Copyright (c) 2026, Laurence Lundblade. All rights reserved.
+
+ SPDX-License-Identifier: BSD-3-Clause
+
+ See BSD-3-Clause license in README.md
+ =============================================================================*/
+
+#ifndef qcbor_view_tests_h
+#define qcbor_view_tests_h
+
+#include <stdint.h>
+
+
+/*
+ Gets members and elements of a nested document out of order, with
+ and without a cache, including indefinite lengths and tags.
+ */
+int32_t ViewTest(void);
+
+
+/*
+ Checks not found, wrong type, past the end and not-well-formed
+ input.
+ */
+int32_t ViewErrorTest(void);
+
+
+/*
+ Reuses a buffer for new documents with a cache and checks stale
+ positions are not used.
+ */
+int32_t ViewCacheReuseTest(void);
+
+
+/*
+ Replaces items in place with ones of the same size, larger and
+ smaller, and checks the result decodes as expected.
+ */
+int32_t ViewReplaceTest(void);
+
+
+#endif /* qcbor_view_tests_h */
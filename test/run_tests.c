@@ -18,6 +18,17 @@
 #include "float_tests.h"
 #include "qcbor_decode_tests.h"
 #include "qcbor_encode_tests.h"
+#include "qcbor_json_tests.h"
+#include "qcbor_diag_tests.h"
+#include "qcbor_schema_tests.h"
+#include "qcbor_struct_tests.h"
+#include "qcbor_view_tests.h"
+#include "qcbor_seq_index_tests.h"
+#include "qcbor_packed_tests.h"
+#include "qcbor_path_tests.h"
+#include "qcbor_sax_tests.h"
+#include "qcbor_transform_tests.h"
+#include "qcbor_dom_tests.h"
 #include "UsefulBuf_Tests.h"
 
 
@@ -61,12 +72,41 @@ static test_entry2 s_tests2[] = {
     TEST_ENTRY(UBMacroConversionsTest),
     TEST_ENTRY(UBUtilTests),
     TEST_ENTRY(UIBTest_IntegerFormat),
-    TEST_ENTRY(UBAdvanceTest)
+    TEST_ENTRY(UBAdvanceTest),
+    TEST_ENTRY(UOBTest_Swap)
 };
 
 
 static test_entry s_tests[] = {
     TEST_ENTRY(OpenCloseBytesTest),
+    TEST_ENTRY(SortMapTest),
+    TEST_ENTRY(MergeMapsTest),
+    TEST_ENTRY(JSONToCBORTest),
+    TEST_ENTRY(JSONToCBORErrorTest),
+    TEST_ENTRY(DiagTest),
+    TEST_ENTRY(DiagErrorTest),
+    TEST_ENTRY(SchemaCompileTest),
+    TEST_ENTRY(SchemaValidateTest),
+    TEST_ENTRY(StructRoundTripTest),
+    TEST_ENTRY(StructDecodeTest),
+    TEST_ENTRY(ColumnDecodeTest),
+    TEST_ENTRY(ColumnEncodeTest),
+    TEST_ENTRY(ViewTest),
+    TEST_ENTRY(ViewErrorTest),
+    TEST_ENTRY(ViewCacheReuseTest),
+    TEST_ENTRY(ViewReplaceTest),
+    TEST_ENTRY(SeqIndexTest),
+    TEST_ENTRY(SeqIndexErrorTest),
+    TEST_ENTRY(PackedRoundTripTest),
+    TEST_ENTRY(PackedUnpackTest),
+    TEST_ENTRY(PathCompileTest),
+    TEST_ENTRY(PathGetTest),
+    TEST_ENTRY(SaxEventsTest),
+    TEST_ENTRY(SaxErrorsTest),
+    TEST_ENTRY(DomBuildTest),
+    TEST_ENTRY(DomErrorsTest),
+    TEST_ENTRY(TransformTest),
+    TEST_ENTRY(TransformErrorsTest),
     TEST_ENTRY(EnterBstrTest),
     TEST_ENTRY(IntegerConvertTest),
     TEST_ENTRY(EnterMapTest),
@@ -138,6 +178,16 @@ static test_entry s_tests[] = {
     TEST_ENTRY(IntToTests),
     TEST_ENTRY(DecodeTaggedTypeTests),
     TEST_ENTRY(PeekAndRewindTest),
+    TEST_ENTRY(PreparedDecodeTest),
+    TEST_ENTRY(PeekCacheTest),
+    TEST_ENTRY(ExitWithoutRescanTest),
+    TEST_ENTRY(DateStringEpochTest),
+    TEST_ENTRY(Base64Test),
+    TEST_ENTRY(UTF8ValidationTest),
+    TEST_ENTRY(InternTableTest),
+    TEST_ENTRY(BstrWrappedPosTest),
+    TEST_ENTRY(StreamByteStringTest),
+    TEST_ENTRY(DuplicateDetectionTest),
 #ifndef     QCBOR_DISABLE_EXP_AND_MANTISSA
     TEST_ENTRY(EncodeLengthThirtyoneTest),
     TEST_ENTRY(ExponentAndMantissaDecodeTests),